@@ -0,0 +1,62 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __acdriver_Compile_AtlasPacker_h
+#define __acdriver_Compile_AtlasPacker_h
+
+#include <vector>
+#include <ext/optional>
+
+namespace acdriver {
+namespace Compile {
+
+/*
+ * Packs rectangles into as few pages as possible, for sprite atlases.
+ * Uses maximal rectangles with the best short side fit.
+ */
+class AtlasPacker {
+public:
+    struct Size {
+        size_t width;
+        size_t height;
+    };
+
+    struct Placement {
+        size_t page;
+        size_t x;
+        size_t y;
+    };
+
+    struct Page {
+        size_t width;
+        size_t height;
+    };
+
+private:
+    AtlasPacker();
+    ~AtlasPacker();
+
+public:
+    /*
+     * Pack rectangles into pages no larger than the maximum size, with
+     * padding between them. Each rectangle's placement is in the order
+     * given; rectangles too large for a page are not placed. The pages
+     * are only as large as their contents.
+     */
+    static std::vector<ext::optional<Placement>> Pack(
+        std::vector<Size> const &sizes,
+        Size const &maximum,
+        size_t padding,
+        std::vector<Page> *pages);
+};
+
+}
+}
+
+#endif // !__acdriver_Compile_AtlasPacker_h
@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __acdriver_Compile_Benchmark_h
+#define __acdriver_Compile_Benchmark_h
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace plist { class Dictionary; }
+
+namespace acdriver {
+namespace Compile {
+
+/*
+ * Time spent in each stage of compilation, in total and for each asset.
+ */
+class Benchmark {
+public:
+    enum class Stage {
+        /*
+         * Loading asset catalogs, including parsing their contents.
+         */
+        Load,
+        /*
+         * Decoding images, including converting their pixels.
+         */
+        Decode,
+        /*
+         * Compressing and encoding renditions.
+         */
+        Compress,
+        /*
+         * Writing the compiled archive.
+         */
+        Write,
+    };
+
+    /*
+     * Records the time from creation to destruction. Does nothing without
+     * a benchmark, so stages can always be timed.
+     */
+    class Timer {
+    private:
+        Benchmark                             *_benchmark;
+        Stage                                  _stage;
+        std::string                            _asset;
+        std::chrono::steady_clock::time_point _start;
+
+    public:
+        Timer(Benchmark *benchmark, Stage stage, std::string const &asset = std::string());
+        ~Timer();
+    };
+
+private:
+    struct Times {
+        double seconds[4];
+        size_t count[4];
+    };
+
+private:
+    Times                         _totals;
+    std::map<std::string, Times>  _assets;
+    mutable std::mutex            _mutex;
+
+public:
+    Benchmark();
+
+public:
+    /*
+     * Record time spent in a stage, for an asset if not empty. Thread safe.
+     */
+    void record(Stage stage, std::string const &asset, double seconds);
+
+public:
+    /*
+     * The times as structured output: totals, and each asset's times.
+     */
+    std::unique_ptr<plist::Dictionary> dictionary() const;
+
+    /*
+     * The times as text.
+     */
+    std::string text() const;
+
+public:
+    /*
+     * The name of a stage, for output.
+     */
+    static std::string StageName(Stage stage);
+};
+
+}
+}
+
+#endif // !__acdriver_Compile_Benchmark_h
@@ -0,0 +1,85 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __acdriver_Compile_ImageCache_h
+#define __acdriver_Compile_ImageCache_h
+
+#include <car/Rendition.h>
+#include <ext/optional>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace acdriver {
+namespace Compile {
+
+/*
+ * Images decoded during one compile, keyed by path and the format they were
+ * decoded into. Images used by several assets are decoded once, and kept
+ * only until their last use.
+ */
+class ImageCache {
+public:
+    struct Image {
+        std::vector<uint8_t>            pixels;
+        size_t                          width;
+        size_t                          height;
+        car::Rendition::Data::Format    format;
+        ext::optional<std::string>      error;
+    };
+
+private:
+    struct Entry {
+        std::mutex mutex;
+        size_t     uses;
+        bool       decoded;
+        Image      image;
+    };
+
+private:
+    std::unordered_map<std::string, std::shared_ptr<Entry>> _entries;
+    std::mutex                                              _entriesMutex;
+
+public:
+    ImageCache();
+
+public:
+    /*
+     * Note an upcoming use of an image. Each retain must be matched by one
+     * call to `use` or `release`.
+     */
+    void retain(std::string const &key);
+
+    /*
+     * Get an image, decoding it on first use. If other threads use the same
+     * image at the same time, they wait for the one decoding it. The last
+     * use takes the image rather than copying it. Thread safe.
+     */
+    Image use(std::string const &key, std::function<Image()> const &decode);
+
+    /*
+     * Give up a use of an image without using it. Thread safe.
+     */
+    void release(std::string const &key);
+
+public:
+    /*
+     * The key for an image file decoded into a format.
+     */
+    static std::string Key(std::string const &path, std::string const &format);
+};
+
+}
+}
+
+#endif // !__acdriver_Compile_ImageCache_h
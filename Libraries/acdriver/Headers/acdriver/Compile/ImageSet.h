@@ -10,10 +10,13 @@
 #ifndef __acdriver_Compile_ImageSet_h
 #define __acdriver_Compile_ImageSet_h
 
+#include <acdriver/Compile/ImageCache.h>
 #include <xcassets/Asset/Asset.h>
 #include <xcassets/Asset/ImageSet.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace libutil { class Filesystem; }
 
@@ -43,6 +46,23 @@ public:
         libutil::Filesystem *filesystem,
         Output *compileOutput,
         Result *result);
+
+public:
+    /*
+     * The image cache key for an image file, as decoded for the archive.
+     */
+    static std::string DecodedImageKey(std::string const &filename);
+
+    /*
+     * Decode an image file into the archive's pixel format. JPEG files
+     * are kept as they are.
+     */
+    static ImageCache::Image DecodeImage(std::string const &filename, std::vector<uint8_t> const &contents);
+
+    /*
+     * The identifier for a named facet, adding the facet the first time.
+     */
+    static uint16_t FacetIdentifier(std::string const &name, Output *compileOutput);
 };
 
 }
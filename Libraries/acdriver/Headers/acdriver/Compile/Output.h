@@ -10,9 +10,13 @@
 #ifndef __acdriver_Compile_Output_h
 #define __acdriver_Compile_Output_h
 
+#include <acdriver/Compile/Benchmark.h>
+#include <acdriver/Compile/ImageCache.h>
+#include <acdriver/Compile/RenditionCache.h>
 #include <plist/Dictionary.h>
 #include <car/Writer.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -23,6 +27,9 @@ namespace libutil { class Filesystem; }
 namespace xcassets { namespace Asset { class Asset; } }
 
 namespace acdriver {
+
+class Result;
+
 namespace Compile {
 
 /*
@@ -45,14 +52,39 @@ private:
     std::string                        _root;
     Format                             _format;
 
+public:
+    /*
+     * Buffers reused by one worker for each asset it prepares, so large
+     * images don't each need new allocations.
+     */
+    struct Scratch {
+        std::vector<uint8_t> contents;
+    };
+
+    /*
+     * Work for an asset that can run in parallel with other assets, like
+     * decoding and converting images, and the step adding its result to
+     * the output. Results are added in the order the work was deferred,
+     * so the output is the same however the work was scheduled.
+     */
+    struct Deferred {
+        std::function<void(Scratch *)> prepare;
+        std::function<void(Result *)>  commit;
+    };
+
 private:
     ext::optional<std::string>         _appIcon;
     ext::optional<std::string>         _launchImage;
 
 private:
     ext::optional<car::Writer>         _car;
+    car::Rendition::Compression        _compression;
     std::vector<std::pair<std::string, std::string>> _copies;
     std::unique_ptr<plist::Dictionary> _additionalInfo;
+    std::vector<Deferred>              _deferred;
+    RenditionCache                     _renditionCache;
+    std::unique_ptr<ImageCache>        _imageCache;
+    std::unique_ptr<Benchmark>         _benchmark;
 
 private:
     std::vector<std::string>           _inputs;
@@ -100,6 +132,14 @@ public:
     ext::optional<car::Writer> &car()
     { return _car; }
 
+    /*
+     * How much to compress renditions in the compiled catalog.
+     */
+    car::Rendition::Compression compression() const
+    { return _compression; }
+    car::Rendition::Compression &compression()
+    { return _compression; }
+
     /*
      * Files to copy into the output.
      */
@@ -116,6 +156,39 @@ public:
     plist::Dictionary *additionalInfo()
     { return _additionalInfo.get(); }
 
+    /*
+     * Work deferred until all assets are compiled.
+     */
+    std::vector<Deferred> &deferred()
+    { return _deferred; }
+
+    /*
+     * Renditions encoded by the previous compile, and used by this one.
+     */
+    RenditionCache const &renditionCache() const
+    { return _renditionCache; }
+    RenditionCache &renditionCache()
+    { return _renditionCache; }
+
+    /*
+     * Images decoded while running the deferred work.
+     */
+    ImageCache &imageCache()
+    { return *_imageCache; }
+
+    /*
+     * If timing compilation, where the time is recorded.
+     */
+    std::unique_ptr<Benchmark> const &benchmark() const
+    { return _benchmark; }
+    std::unique_ptr<Benchmark> &benchmark()
+    { return _benchmark; }
+
+    /*
+     * Run the deferred work on all processors, then add the results.
+     */
+    void finishDeferred(Result *result);
+
 public:
     /*
      * Files that were read in as input.
@@ -0,0 +1,71 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __acdriver_Compile_RenditionCache_h
+#define __acdriver_Compile_RenditionCache_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+
+namespace acdriver {
+namespace Compile {
+
+/*
+ * Renditions encoded by a previous compile, keyed by a hash of the image
+ * contents and the properties of the rendition. Unchanged images can use
+ * the encoded rendition without decoding or compressing the image again.
+ */
+class RenditionCache {
+private:
+    std::unordered_map<std::string, std::vector<uint8_t>> _loaded;
+    std::unordered_map<std::string, std::vector<uint8_t>> _used;
+
+public:
+    RenditionCache();
+
+public:
+    /*
+     * Find a rendition encoded by the previous compile. Safe to call from
+     * multiple threads, as long as nothing is inserted at the same time.
+     */
+    std::vector<uint8_t> const *find(std::string const &key) const;
+
+    /*
+     * Note a rendition used by this compile, to save for the next one.
+     */
+    void insert(std::string const &key, std::vector<uint8_t> const &value);
+
+public:
+    /*
+     * Load renditions saved by a previous compile. A missing or invalid
+     * cache is treated as empty.
+     */
+    bool load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Save the renditions used by this compile. Renditions that were not
+     * used are dropped.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * The key for an image's contents and a description of everything
+     * else that affects its encoded rendition.
+     */
+    static std::string Key(std::vector<uint8_t> const &contents, std::string const &description);
+};
+
+}
+}
+
+#endif // !__acdriver_Compile_RenditionCache_h
@@ -47,6 +47,7 @@ private:
 private:
     ext::optional<std::string> _optimization;
     ext::optional<bool>        _compressPNGs;
+    ext::optional<bool>        _benchmark;
 
 private:
     ext::optional<std::string> _platform;
@@ -109,6 +110,8 @@ public:
     { return _optimization; }
     bool compressPNGs() const
     { return _compressPNGs.value_or(false); }
+    bool benchmark() const
+    { return _benchmark.value_or(false); }
 
 public:
     ext::optional<std::string> const &platform() const
@@ -0,0 +1,197 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <acdriver/Compile/AtlasPacker.h>
+
+#include <algorithm>
+#include <limits>
+
+using acdriver::Compile::AtlasPacker;
+
+struct Rect {
+    size_t x;
+    size_t y;
+    size_t width;
+    size_t height;
+};
+
+static bool
+Contains(Rect const &outer, Rect const &inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y &&
+        inner.x + inner.width <= outer.x + outer.width &&
+        inner.y + inner.height <= outer.y + outer.height;
+}
+
+static bool
+Intersects(Rect const &a, Rect const &b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+        a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+/*
+ * The free space left on a page, as maximal rectangles that can overlap.
+ */
+struct FreePage {
+    std::vector<Rect> free;
+};
+
+/*
+ * Find the free rectangle that leaves the least space on its shorter side.
+ */
+static bool
+FindPosition(FreePage const &page, size_t width, size_t height, Rect *position, size_t *score)
+{
+    bool found = false;
+    size_t bestShort = std::numeric_limits<size_t>::max();
+    size_t bestLong = std::numeric_limits<size_t>::max();
+
+    for (Rect const &free : page.free) {
+        if (free.width < width || free.height < height) {
+            continue;
+        }
+
+        size_t leftoverWidth = free.width - width;
+        size_t leftoverHeight = free.height - height;
+        size_t shortSide = std::min(leftoverWidth, leftoverHeight);
+        size_t longSide = std::max(leftoverWidth, leftoverHeight);
+        if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+            *position = { free.x, free.y, width, height };
+            bestShort = shortSide;
+            bestLong = longSide;
+            found = true;
+        }
+    }
+
+    *score = bestShort;
+    return found;
+}
+
+/*
+ * Remove the used rectangle from the free space: split every free rectangle
+ * it overlaps into the parts around it, then drop those inside others.
+ */
+static void
+Place(FreePage *page, Rect const &used)
+{
+    std::vector<Rect> free;
+    free.reserve(page->free.size() + 4);
+
+    for (Rect const &rect : page->free) {
+        if (!Intersects(rect, used)) {
+            free.push_back(rect);
+            continue;
+        }
+
+        if (used.x > rect.x) {
+            free.push_back({ rect.x, rect.y, used.x - rect.x, rect.height });
+        }
+        if (used.x + used.width < rect.x + rect.width) {
+            size_t x = used.x + used.width;
+            free.push_back({ x, rect.y, rect.x + rect.width - x, rect.height });
+        }
+        if (used.y > rect.y) {
+            free.push_back({ rect.x, rect.y, rect.width, used.y - rect.y });
+        }
+        if (used.y + used.height < rect.y + rect.height) {
+            size_t y = used.y + used.height;
+            free.push_back({ rect.x, y, rect.width, rect.y + rect.height - y });
+        }
+    }
+
+    page->free.clear();
+    for (size_t i = 0; i < free.size(); ++i) {
+        bool contained = false;
+        for (size_t j = 0; j < free.size() && !contained; ++j) {
+            /* Of identical rectangles, keep the first. */
+            if (i != j && Contains(free[j], free[i]) && (!Contains(free[i], free[j]) || j < i)) {
+                contained = true;
+            }
+        }
+
+        if (!contained) {
+            page->free.push_back(free[i]);
+        }
+    }
+}
+
+std::vector<ext::optional<AtlasPacker::Placement>> AtlasPacker::
+Pack(
+    std::vector<Size> const &sizes,
+    Size const &maximum,
+    size_t padding,
+    std::vector<Page> *pages)
+{
+    std::vector<ext::optional<Placement>> placements = std::vector<ext::optional<Placement>>(sizes.size());
+
+    /*
+     * Place the largest rectangles first; small ones fill in around them.
+     * Padding is added to the right and bottom of each rectangle, and the
+     * page is as large as the maximum plus padding so the last rectangles
+     * on each edge can still reach it.
+     */
+    std::vector<size_t> order;
+    order.reserve(sizes.size());
+    for (size_t n = 0; n < sizes.size(); ++n) {
+        order.push_back(n);
+    }
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+        size_t sideA = std::max(sizes[a].width, sizes[a].height);
+        size_t sideB = std::max(sizes[b].width, sizes[b].height);
+        if (sideA != sideB) {
+            return sideA > sideB;
+        }
+        return sizes[a].width * sizes[a].height > sizes[b].width * sizes[b].height;
+    });
+
+    std::vector<FreePage> freePages;
+    pages->clear();
+
+    for (size_t n : order) {
+        Size const &size = sizes[n];
+        if (size.width == 0 || size.height == 0 || size.width > maximum.width || size.height > maximum.height) {
+            continue;
+        }
+
+        size_t width = size.width + padding;
+        size_t height = size.height + padding;
+
+        size_t bestPage = freePages.size();
+        size_t bestScore = std::numeric_limits<size_t>::max();
+        Rect bestPosition = { 0, 0, width, height };
+        for (size_t p = 0; p < freePages.size(); ++p) {
+            Rect position;
+            size_t score;
+            if (FindPosition(freePages[p], width, height, &position, &score) && score < bestScore) {
+                bestPage = p;
+                bestScore = score;
+                bestPosition = position;
+            }
+        }
+
+        if (bestPage == freePages.size()) {
+            FreePage page;
+            page.free.push_back({ 0, 0, maximum.width + padding, maximum.height + padding });
+            freePages.push_back(std::move(page));
+            pages->push_back({ 0, 0 });
+        }
+
+        FreePage *page = &freePages[bestPage];
+        Place(page, bestPosition);
+
+        Page *result = &(*pages)[bestPage];
+        result->width = std::max(result->width, bestPosition.x + size.width);
+        result->height = std::max(result->height, bestPosition.y + size.height);
+
+        placements[n] = Placement({ bestPage, bestPosition.x, bestPosition.y });
+    }
+
+    return placements;
+}
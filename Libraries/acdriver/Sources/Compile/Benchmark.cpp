@@ -0,0 +1,152 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <acdriver/Compile/Benchmark.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/Real.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+using acdriver::Compile::Benchmark;
+
+static size_t const StageCount = 4;
+
+static Benchmark::Stage const Stages[StageCount] = {
+    Benchmark::Stage::Load,
+    Benchmark::Stage::Decode,
+    Benchmark::Stage::Compress,
+    Benchmark::Stage::Write,
+};
+
+Benchmark::Timer::
+Timer(Benchmark *benchmark, Stage stage, std::string const &asset) :
+    _benchmark(benchmark),
+    _stage    (stage)
+{
+    if (_benchmark != nullptr) {
+        _asset = asset;
+        _start = std::chrono::steady_clock::now();
+    }
+}
+
+Benchmark::Timer::
+~Timer()
+{
+    if (_benchmark != nullptr) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _start;
+        _benchmark->record(_stage, _asset, elapsed.count());
+    }
+}
+
+Benchmark::
+Benchmark() :
+    _totals({ })
+{
+}
+
+void Benchmark::
+record(Stage stage, std::string const &asset, double seconds)
+{
+    size_t index = static_cast<size_t>(stage);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _totals.seconds[index] += seconds;
+    _totals.count[index]++;
+
+    if (!asset.empty()) {
+        auto it = _assets.find(asset);
+        if (it == _assets.end()) {
+            it = _assets.insert({ asset, Times({ }) }).first;
+        }
+
+        it->second.seconds[index] += seconds;
+        it->second.count[index]++;
+    }
+}
+
+static std::unique_ptr<plist::Dictionary>
+TimesDictionary(double const *seconds, size_t const *count)
+{
+    auto dict = plist::Dictionary::New();
+    for (size_t n = 0; n < StageCount; ++n) {
+        if (count[n] == 0) {
+            continue;
+        }
+
+        auto stage = plist::Dictionary::New();
+        stage->set("seconds", plist::Real::New(seconds[n]));
+        stage->set("count", plist::Integer::New(count[n]));
+        dict->set(Benchmark::StageName(Stages[n]), std::move(stage));
+    }
+    return dict;
+}
+
+static std::string
+TimesText(double const *seconds, size_t const *count)
+{
+    std::string text;
+    for (size_t n = 0; n < StageCount; ++n) {
+        if (count[n] == 0) {
+            continue;
+        }
+
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), " %s %.3fs", Benchmark::StageName(Stages[n]).c_str(), seconds[n]);
+        text += buffer;
+    }
+    return text;
+}
+
+std::unique_ptr<plist::Dictionary> Benchmark::
+dictionary() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto assets = plist::Dictionary::New();
+    for (auto const &entry : _assets) {
+        assets->set(entry.first, TimesDictionary(entry.second.seconds, entry.second.count));
+    }
+
+    auto dict = plist::Dictionary::New();
+    dict->set("totals", TimesDictionary(_totals.seconds, _totals.count));
+    dict->set("assets", std::move(assets));
+    return dict;
+}
+
+std::string Benchmark::
+text() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::string text = "total:" + TimesText(_totals.seconds, _totals.count) + "\n";
+    for (auto const &entry : _assets) {
+        text += entry.first + ":" + TimesText(entry.second.seconds, entry.second.count) + "\n";
+    }
+    return text;
+}
+
+std::string Benchmark::
+StageName(Stage stage)
+{
+    switch (stage) {
+        case Stage::Load:
+            return "load";
+        case Stage::Decode:
+            return "decode";
+        case Stage::Compress:
+            return "compress";
+        case Stage::Write:
+            return "write";
+    }
+
+    abort();
+}
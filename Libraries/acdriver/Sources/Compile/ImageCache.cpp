@@ -0,0 +1,93 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <acdriver/Compile/ImageCache.h>
+
+#include <cassert>
+
+using acdriver::Compile::ImageCache;
+
+ImageCache::
+ImageCache()
+{
+}
+
+void ImageCache::
+retain(std::string const &key)
+{
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+
+    std::shared_ptr<Entry> &entry = _entries[key];
+    if (entry == nullptr) {
+        entry = std::make_shared<Entry>();
+        entry->uses = 0;
+        entry->decoded = false;
+    }
+    entry->uses++;
+}
+
+ImageCache::Image ImageCache::
+use(std::string const &key, std::function<Image()> const &decode)
+{
+    std::shared_ptr<Entry> entry;
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(_entriesMutex);
+
+        auto it = _entries.find(key);
+        if (it == _entries.end()) {
+            /* Not retained: nothing to share it with. */
+            return decode();
+        }
+
+        entry = it->second;
+        assert(entry->uses > 0);
+        last = (--entry->uses == 0);
+        if (last) {
+            _entries.erase(it);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (!entry->decoded) {
+        if (last) {
+            /* Only use: no need to keep it. */
+            return decode();
+        }
+
+        entry->image = decode();
+        entry->decoded = true;
+    }
+
+    if (last) {
+        return std::move(entry->image);
+    } else {
+        return entry->image;
+    }
+}
+
+void ImageCache::
+release(std::string const &key)
+{
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+
+    auto it = _entries.find(key);
+    if (it != _entries.end()) {
+        assert(it->second->uses > 0);
+        if (--it->second->uses == 0) {
+            _entries.erase(it);
+        }
+    }
+}
+
+std::string ImageCache::
+Key(std::string const &path, std::string const &format)
+{
+    return path + '\0' + format;
+}
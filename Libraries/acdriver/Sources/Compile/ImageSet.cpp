@@ -9,7 +9,9 @@
 
 #include <acdriver/Compile/ImageSet.h>
 #include <acdriver/Compile/Convert.h>
+#include <acdriver/Compile/ImageCache.h>
 #include <acdriver/Compile/Output.h>
+#include <acdriver/Compile/RenditionCache.h>
 #include <acdriver/Result.h>
 #include <graphics/PixelFormat.h>
 #include <graphics/Format/PNG.h>
@@ -23,11 +25,17 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 
 using acdriver::Compile::ImageSet;
+using acdriver::Compile::Benchmark;
 using acdriver::Compile::Convert;
+using acdriver::Compile::ImageCache;
 using acdriver::Compile::Output;
+using acdriver::Compile::RenditionCache;
 using acdriver::Result;
 using libutil::Filesystem;
 using libutil::FSUtil;
@@ -59,140 +67,202 @@ GenerateIdentifier(void) {
     return last;
 }
 
-bool ImageSet::
-CompileAsset(
-    xcassets::Asset::ImageSet const *imageSet,
-    xcassets::Asset::ImageSet::Image const &image,
-    Filesystem *filesystem,
-    Output *compileOutput,
-    Result *result)
+uint16_t ImageSet::
+FacetIdentifier(std::string const &name, Output *compileOutput)
 {
     static std::map<std::string, uint16_t> idMap = {};
 
-    /* Skip any entry that is not attached to a file, or is explicitly unassigned. */
-    if (!image.fileName() || image.unassigned()) {
-        return true;
+    auto it = idMap.find(name);
+    if (it != idMap.end()) {
+        return it->second;
     }
 
-    /* An image without an idiom is considered unassigned. */
-    if (!image.idiom()) {
-        return false;
-    }
+    uint16_t facetIdentifier = GenerateIdentifier();
+    idMap[name] = facetIdentifier;
 
-    std::string filename = FSUtil::ResolveRelativePath(*image.fileName(), imageSet->path());
+    car::AttributeList attributes = car::AttributeList({
+        { car_attribute_identifier_identifier, facetIdentifier },
+    });
 
-    std::string name = imageSet->name().string();
+    car::Facet facet = car::Facet::Create(name, attributes);
+    compileOutput->car()->addFacet(facet);
+
+    return facetIdentifier;
+}
+
+/*
+ * An image's rendition, encoded for the archive.
+ */
+struct EncodedImage {
+    std::string                key;
+    std::vector<uint8_t>       rendition;
+    ext::optional<std::string> error;
+};
+
+/*
+ * Describes everything besides the image contents that changes the
+ * encoded rendition, for the rendition cache.
+ */
+static std::string
+ImageDescription(xcassets::Asset::ImageSet::Image const &image, car::Rendition::Compression compression)
+{
+    std::ostringstream ss;
+    ss << "ImageSet 1" << '\0' << *image.fileName() << '\0';
+    ss << static_cast<int>(compression) << '\0';
 
-    /* The default (0) is any scale. */
-    double scale = 0;
     if (image.scale()) {
-        scale = image.scale()->value();
+        ss << image.scale()->value();
     }
+    ss << '\0';
 
-    // TODO: filter by target-device / device-model / os-version
-    uint16_t idiom = Convert::IdiomAttribute(*image.idiom());
+    if (image.resizing()) {
+        xcassets::Resizing const &resizing = *image.resizing();
+        if (resizing.mode()) {
+            ss << static_cast<int>(*resizing.mode());
+        }
+        ss << '\0';
 
-    std::vector<uint8_t> pixels;
-    size_t width = 0;
-    size_t height = 0;
-    car::Rendition::Data::Format format = car::Rendition::Data::Format::Data;
+        if (resizing.center() && resizing.center()->mode()) {
+            ss << static_cast<int>(*resizing.center()->mode());
+        }
+        ss << '\0';
 
-    if (FSUtil::IsFileExtension(filename, "png", true)) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, filename)) {
-            result->normal(
-                Result::Severity::Error,
-                "unable to read PNG file",
-                filename);
-            return false;
+        if (resizing.capInsets()) {
+            xcassets::Insets const &insets = *resizing.capInsets();
+            for (ext::optional<double> const &inset : { insets.top(), insets.left(), insets.bottom(), insets.right() }) {
+                if (inset) {
+                    ss << *inset;
+                }
+                ss << '\0';
+            }
         }
+    }
+
+    return ss.str();
+}
 
-        auto png = graphics::Format::PNG::Read(contents);
+ImageCache::Image ImageSet::
+DecodeImage(std::string const &filename, std::vector<uint8_t> const &contents)
+{
+    ImageCache::Image decoded;
+
+    if (FSUtil::IsFileExtension(filename, "png", true)) {
+        /* Decode straight into the archive format. */
+        auto png = graphics::Format::PNG::Read(
+            contents,
+            graphics::PixelFormat::Order::Reversed,
+            graphics::PixelFormat::Alpha::PremultipliedFirst);
         if (!png.first) {
-            result->normal(Result::Severity::Error, png.second, filename);
-            return false;
+            decoded.error = png.second;
+            return decoded;
         }
 
-        graphics::Image const &image = *png.first;
-        width = image.width();
-        height = image.height();
-
-        /* Convert the image to the archive format. */
+        graphics::Image &image = *png.first;
+        decoded.width = image.width();
+        decoded.height = image.height();
+        decoded.pixels = std::move(image.data());
         switch (image.format().color()) {
             case graphics::PixelFormat::Color::RGB:
-                format = car::Rendition::Data::Format::PremultipliedBGRA8;
-                pixels = graphics::PixelFormat::Convert(
-                    image.data(),
-                    image.format(),
-                    graphics::PixelFormat(
-                        graphics::PixelFormat::Color::RGB,
-                        graphics::PixelFormat::Order::Reversed,
-                        graphics::PixelFormat::Alpha::PremultipliedFirst));
+                decoded.format = car::Rendition::Data::Format::PremultipliedBGRA8;
                 break;
             case graphics::PixelFormat::Color::Grayscale:
-                format = car::Rendition::Data::Format::PremultipliedGA8;
-                pixels = graphics::PixelFormat::Convert(
-                    image.data(),
-                    image.format(),
-                    graphics::PixelFormat(
-                        graphics::PixelFormat::Color::Grayscale,
-                        graphics::PixelFormat::Order::Reversed,
-                        graphics::PixelFormat::Alpha::PremultipliedFirst));
+                decoded.format = car::Rendition::Data::Format::PremultipliedGA8;
                 break;
         }
-    } else if (FSUtil::IsFileExtension(filename, "jpg", true) || FSUtil::IsFileExtension(filename, "jpeg", true)) {
-        if (!filesystem->read(&pixels, filename)) {
-            result->normal(
-                Result::Severity::Error,
-                "unable to read JPEG file",
-                filename);
-            return false;
-        }
-
-        format = car::Rendition::Data::Format::JPEG;
     } else {
-        result->normal(
-            Result::Severity::Error,
-            "unknown file type",
-            filename);
-        return false;
+        decoded.width = 0;
+        decoded.height = 0;
+        decoded.format = car::Rendition::Data::Format::JPEG;
+        decoded.pixels = contents;
     }
 
-    bool createFacet = false;
-    uint16_t facetIdentifier = 0;
-    auto it = idMap.find(name);
-    if (it == idMap.end()) {
-        facetIdentifier = GenerateIdentifier();
-        idMap[name] = facetIdentifier;
-        createFacet = true;
-    } else {
-        facetIdentifier = it->second;
+    return decoded;
+}
+
+/*
+ * Images are always decoded into the archive's pixel format, so the key
+ * only needs to include it to stay distinct if that ever changes.
+ */
+std::string ImageSet::
+DecodedImageKey(std::string const &filename)
+{
+    return ImageCache::Key(filename, "PremultipliedFirst Reversed");
+}
+
+static EncodedImage
+EncodeImage(
+    Filesystem const *filesystem,
+    RenditionCache const *renditionCache,
+    ImageCache *imageCache,
+    Benchmark *benchmark,
+    std::string const &reference,
+    std::string const &filename,
+    xcassets::Asset::ImageSet::Image const &image,
+    car::Rendition::Compression compression,
+    Output::Scratch *scratch)
+{
+    EncodedImage encoded;
+
+    bool png = FSUtil::IsFileExtension(filename, "png", true);
+    bool jpeg = FSUtil::IsFileExtension(filename, "jpg", true) || FSUtil::IsFileExtension(filename, "jpeg", true);
+    if (!png && !jpeg) {
+        imageCache->release(ImageSet::DecodedImageKey(filename));
+        encoded.error = std::string("unknown file type");
+        return encoded;
     }
-    if (createFacet) {
-        car::AttributeList attributes = car::AttributeList({
-            { car_attribute_identifier_identifier, facetIdentifier },
-        });
 
-        car::Facet facet = car::Facet::Create(name, attributes);
-        compileOutput->car()->addFacet(facet);
+    std::vector<uint8_t> &contents = scratch->contents;
+    if (!filesystem->read(&contents, filename)) {
+        imageCache->release(ImageSet::DecodedImageKey(filename));
+        encoded.error = std::string(png ? "unable to read PNG file" : "unable to read JPEG file");
+        return encoded;
     }
 
     /*
-     * Create rendition for the image.
+     * Use the rendition from the previous compile if nothing changed.
      */
-    car::AttributeList attributes = car::AttributeList({
-        { car_attribute_identifier_idiom, idiom },
-        { car_attribute_identifier_scale, static_cast<int>(scale) },
-        { car_attribute_identifier_identifier, facetIdentifier },
+    encoded.key = RenditionCache::Key(contents, ImageDescription(image, compression));
+    if (std::vector<uint8_t> const *rendition = renditionCache->find(encoded.key)) {
+        imageCache->release(ImageSet::DecodedImageKey(filename));
+        encoded.rendition = *rendition;
+        return encoded;
+    }
+
+    /*
+     * The same file can be used by more than one image; decode it once.
+     */
+    ImageCache::Image decoded = imageCache->use(ImageSet::DecodedImageKey(filename), [&]() {
+        Benchmark::Timer timer(benchmark, Benchmark::Stage::Decode, reference);
+        return ImageSet::DecodeImage(filename, contents);
     });
+    if (decoded.error) {
+        encoded.error = decoded.error;
+        return encoded;
+    }
+
+    std::vector<uint8_t> pixels = std::move(decoded.pixels);
+    size_t width = decoded.width;
+    size_t height = decoded.height;
+    car::Rendition::Data::Format format = decoded.format;
+
+    /* The default (0) is any scale. */
+    double scale = 0;
+    if (image.scale()) {
+        scale = image.scale()->value();
+    }
 
+    /*
+     * Create rendition for the image. The attributes are not part of the
+     * encoded rendition, so they are added when the rendition is.
+     */
     auto data = ext::optional<car::Rendition::Data>(car::Rendition::Data(std::move(pixels), format));
 
-    car::Rendition rendition = car::Rendition::Create(attributes, std::move(data));
+    car::Rendition rendition = car::Rendition::Create(car::AttributeList({ }), std::move(data));
     rendition.width() = width;
     rendition.height() = height;
     rendition.scale() = scale;
     rendition.fileName() = *image.fileName();
+    rendition.compression() = compression;
 
     if (image.resizing()) {
         xcassets::Resizing const &resizing = *image.resizing();
@@ -214,6 +284,101 @@ CompileAsset(
         }
     }
 
-    compileOutput->car()->addRendition(std::move(rendition));
+    Benchmark::Timer timer(benchmark, Benchmark::Stage::Compress, reference);
+    encoded.rendition = rendition.write();
+    return encoded;
+}
+
+/*
+ * Lossless images are compressed as small as possible, unless the catalog
+ * is compiled for speed. Lossy and GPU compression aren't supported, so
+ * those use the compression for the whole catalog.
+ */
+static car::Rendition::Compression
+ImageCompression(xcassets::Asset::ImageSet::Image const &image, car::Rendition::Compression compression)
+{
+    if (compression == car::Rendition::Compression::Default && image.compression() && *image.compression() == xcassets::Compression::Lossless) {
+        return car::Rendition::Compression::Best;
+    }
+
+    return compression;
+}
+
+static void
+AddImage(
+    std::string const &name,
+    xcassets::Asset::ImageSet::Image const &image,
+    EncodedImage const &encoded,
+    Output *compileOutput)
+{
+    /* The default (0) is any scale. */
+    double scale = 0;
+    if (image.scale()) {
+        scale = image.scale()->value();
+    }
+
+    // TODO: filter by target-device / device-model / os-version
+    uint16_t idiom = Convert::IdiomAttribute(*image.idiom());
+
+    uint16_t facetIdentifier = ImageSet::FacetIdentifier(name, compileOutput);
+
+    car::AttributeList attributes = car::AttributeList({
+        { car_attribute_identifier_idiom, idiom },
+        { car_attribute_identifier_scale, static_cast<int>(scale) },
+        { car_attribute_identifier_identifier, facetIdentifier },
+    });
+
+    compileOutput->car()->addRendition(attributes, encoded.rendition);
+    compileOutput->renditionCache().insert(encoded.key, encoded.rendition);
+}
+
+bool ImageSet::
+CompileAsset(
+    xcassets::Asset::ImageSet const *imageSet,
+    xcassets::Asset::ImageSet::Image const &image,
+    Filesystem *filesystem,
+    Output *compileOutput,
+    Result *result)
+{
+    /* Skip any entry that is not attached to a file, or is explicitly unassigned. */
+    if (!image.fileName() || image.unassigned()) {
+        return true;
+    }
+
+    /* An image without an idiom is considered unassigned. */
+    if (!image.idiom()) {
+        return false;
+    }
+
+    std::string filename = FSUtil::ResolveRelativePath(*image.fileName(), imageSet->path());
+    std::string name = imageSet->name().string();
+
+    /*
+     * Reading, decoding and encoding the image is most of the work, so it
+     * happens in parallel with other images. The image is added in order.
+     */
+    std::shared_ptr<EncodedImage> encoded = std::make_shared<EncodedImage>();
+    RenditionCache const *renditionCache = &compileOutput->renditionCache();
+    ImageCache *imageCache = &compileOutput->imageCache();
+    Benchmark *benchmark = compileOutput->benchmark().get();
+    std::string reference = Output::AssetReference(imageSet);
+    imageCache->retain(ImageSet::DecodedImageKey(filename));
+    car::Rendition::Compression compression = ImageCompression(image, compileOutput->compression());
+    compileOutput->deferred().push_back({
+        [filesystem, renditionCache, imageCache, benchmark, reference, filename, image, compression, encoded](Output::Scratch *scratch) {
+            *encoded = EncodeImage(filesystem, renditionCache, imageCache, benchmark, reference, filename, image, compression, scratch);
+        },
+        [name, image, filename, encoded, compileOutput](Result *result) {
+            if (encoded->error) {
+                result->normal(Result::Severity::Error, *encoded->error, filename);
+            } else {
+                AddImage(name, image, *encoded, compileOutput);
+            }
+
+            /* Release the rendition once added. */
+            *encoded = EncodedImage();
+        },
+    });
+
     return true;
 }
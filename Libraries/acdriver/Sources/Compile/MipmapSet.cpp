@@ -8,14 +8,126 @@
  */
 
 #include <acdriver/Compile/MipmapSet.h>
+#include <acdriver/Compile/ImageCache.h>
+#include <acdriver/Compile/ImageSet.h>
 #include <acdriver/Compile/Output.h>
 #include <acdriver/Result.h>
+#include <graphics/Image.h>
+#include <graphics/Mipmap.h>
+#include <graphics/PixelFormat.h>
+#include <car/Rendition.h>
+#include <car/Writer.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 using acdriver::Compile::MipmapSet;
+using acdriver::Compile::ImageCache;
+using acdriver::Compile::ImageSet;
 using acdriver::Compile::Output;
 using acdriver::Result;
 using libutil::Filesystem;
+using libutil::FSUtil;
+
+/*
+ * A mipmap set's levels, encoded for the archive.
+ */
+struct EncodedLevels {
+    std::vector<std::pair<size_t, std::vector<uint8_t>>> renditions;
+    ext::optional<std::string>                           error;
+};
+
+static graphics::PixelFormat
+ImageFormat(car::Rendition::Data::Format format)
+{
+    /* As the decoded images are laid out. */
+    if (format == car::Rendition::Data::Format::PremultipliedGA8) {
+        return graphics::PixelFormat(graphics::PixelFormat::Color::Grayscale, graphics::PixelFormat::Order::Reversed, graphics::PixelFormat::Alpha::PremultipliedFirst);
+    } else {
+        return graphics::PixelFormat(graphics::PixelFormat::Color::RGB, graphics::PixelFormat::Order::Reversed, graphics::PixelFormat::Alpha::PremultipliedFirst);
+    }
+}
+
+static std::vector<uint8_t>
+EncodeLevel(std::string const &name, size_t level, graphics::Image image, car::Rendition::Data::Format format, car::Rendition::Compression compression)
+{
+    size_t width = image.width();
+    size_t height = image.height();
+    auto data = ext::optional<car::Rendition::Data>(car::Rendition::Data(std::move(image.data()), format));
+
+    car::Rendition rendition = car::Rendition::Create(car::AttributeList({ }), std::move(data));
+    rendition.width() = width;
+    rendition.height() = height;
+    rendition.fileName() = name + "-" + std::to_string(level) + ".png";
+    rendition.compression() = compression;
+    return rendition.write();
+}
+
+/*
+ * Decode the supplied levels, generate any others the level mode wants,
+ * and encode each one.
+ */
+static EncodedLevels
+EncodeLevels(
+    Filesystem const *filesystem,
+    std::string const &name,
+    std::vector<ext::optional<std::string>> const &files,
+    bool generate,
+    car::Rendition::Compression compression)
+{
+    EncodedLevels encoded;
+
+    ext::optional<graphics::Image> previous;
+    car::Rendition::Data::Format format = car::Rendition::Data::Format::PremultipliedBGRA8;
+    size_t count = files.size();
+
+    for (size_t level = 0; level < count; ++level) {
+        ext::optional<graphics::Image> image;
+
+        if (level < files.size() && files[level]) {
+            std::string const &filename = *files[level];
+
+            std::vector<uint8_t> contents;
+            if (!filesystem->read(&contents, filename)) {
+                encoded.error = std::string("unable to read PNG file");
+                return encoded;
+            }
+
+            ImageCache::Image decoded = ImageSet::DecodeImage(filename, contents);
+            if (decoded.error) {
+                encoded.error = decoded.error;
+                return encoded;
+            }
+
+            /* Generated levels use the format of the level above them. */
+            format = decoded.format;
+            image = graphics::Image(decoded.width, decoded.height, ImageFormat(decoded.format), std::move(decoded.pixels));
+
+            if (level == 0 && generate) {
+                count = graphics::Mipmap::LevelCount(image->width(), image->height());
+            }
+        } else if (generate && previous) {
+            image = graphics::Mipmap::Downsample(*previous);
+        } else {
+            continue;
+        }
+
+        /* Keep the level to generate the next from, if it's needed. */
+        if (generate && level + 1 < count && (level + 1 >= files.size() || !files[level + 1])) {
+            previous = *image;
+        } else {
+            previous = ext::nullopt;
+        }
+
+        encoded.renditions.push_back({ level, EncodeLevel(name, level, std::move(*image), format, compression) });
+    }
+
+    return encoded;
+}
 
 bool MipmapSet::
 Compile(
@@ -24,12 +136,87 @@ Compile(
     Output *compileOutput,
     Result *result)
 {
-    result->document(
-        Result::Severity::Warning,
-        mipmapSet->path(),
-        { Output::AssetReference(mipmapSet) },
-        "Not Implemented",
-        "mipmap set not yet supported");
-
-    return false;
+    /* Only compiled catalogs store levels. */
+    if (!compileOutput->car()) {
+        return true;
+    }
+
+    xcassets::MipmapLevelMode levelMode = mipmapSet->levelMode().value_or(xcassets::MipmapLevelMode::None);
+
+    /*
+     * The supplied files, by level. None is just the base level, fixed is
+     * the supplied levels, and all fills in the rest of the chain.
+     */
+    std::vector<ext::optional<std::string>> files;
+    if (mipmapSet->levels()) {
+        for (xcassets::Asset::MipmapSet::Level const &level : *mipmapSet->levels()) {
+            if (!level.fileName() || !level.mipmapLevel()) {
+                continue;
+            }
+
+            size_t index = static_cast<size_t>(*level.mipmapLevel());
+            if (index > 0 && levelMode == xcassets::MipmapLevelMode::None) {
+                continue;
+            }
+
+            std::string filename = FSUtil::ResolveRelativePath(*level.fileName(), mipmapSet->path());
+            if (!FSUtil::IsFileExtension(filename, "png", true)) {
+                result->normal(Result::Severity::Error, "mipmap levels must be PNG files", filename);
+                return false;
+            }
+
+            if (files.size() <= index) {
+                files.resize(index + 1);
+            }
+            files[index] = filename;
+        }
+    }
+
+    if (files.empty() || !files[0]) {
+        result->document(
+            Result::Severity::Warning,
+            mipmapSet->path(),
+            { Output::AssetReference(mipmapSet) },
+            "Missing Base Level",
+            "mipmap set has no base level");
+        return false;
+    }
+
+    /*
+     * Decoding and generating levels happens in parallel with other assets;
+     * the levels are added in order.
+     */
+    std::string name = mipmapSet->name().string();
+    std::string path = mipmapSet->path();
+    bool generate = (levelMode == xcassets::MipmapLevelMode::All);
+    car::Rendition::Compression compression = compileOutput->compression();
+    std::shared_ptr<EncodedLevels> encoded = std::make_shared<EncodedLevels>();
+
+    compileOutput->deferred().push_back({
+        [filesystem, name, files, generate, compression, encoded](Output::Scratch *scratch) {
+            *encoded = EncodeLevels(filesystem, name, files, generate, compression);
+        },
+        [name, path, encoded, compileOutput](Result *result) {
+            if (encoded->error) {
+                result->normal(Result::Severity::Error, *encoded->error, path);
+            } else {
+                uint16_t facetIdentifier = ImageSet::FacetIdentifier(name, compileOutput);
+
+                /* Levels are told apart by the first dimension. */
+                for (auto const &entry : encoded->renditions) {
+                    car::AttributeList attributes = car::AttributeList({
+                        { car_attribute_identifier_dimension1, static_cast<uint16_t>(entry.first) },
+                        { car_attribute_identifier_identifier, facetIdentifier },
+                    });
+
+                    compileOutput->car()->addRendition(attributes, entry.second);
+                }
+            }
+
+            /* Release the renditions once added. */
+            *encoded = EncodedLevels();
+        },
+    });
+
+    return true;
 }
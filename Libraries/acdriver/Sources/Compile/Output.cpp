@@ -17,12 +17,17 @@
 #include <plist/Format/Format.h>
 #include <plist/Format/XML.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <atomic>
 
 using acdriver::Compile::Output;
 using acdriver::Version;
 using acdriver::Options;
 using acdriver::Result;
 using libutil::Filesystem;
+using libutil::Parallel;
 
 Output::
 Output(
@@ -34,8 +39,30 @@ Output(
     _format        (format),
     _appIcon       (appIcon),
     _launchImage   (launchImage),
-    _additionalInfo(plist::Dictionary::New())
+    _compression   (car::Rendition::Compression::Default),
+    _additionalInfo(plist::Dictionary::New()),
+    _imageCache    (new ImageCache())
+{
+}
+
+void Output::
+finishDeferred(Result *result)
 {
+    std::atomic<size_t> next = { 0 };
+
+    /* Each job reuses its buffers for all of the work it does. */
+    size_t jobs = std::min(Parallel::DefaultJobs(), _deferred.size());
+    Parallel::For(jobs, jobs, [&](size_t) {
+        Scratch scratch;
+        for (size_t n = next++; n < _deferred.size(); n = next++) {
+            _deferred[n].prepare(&scratch);
+        }
+    });
+
+    for (Deferred const &deferred : _deferred) {
+        deferred.commit(result);
+    }
+    _deferred.clear();
 }
 
 std::string Output::
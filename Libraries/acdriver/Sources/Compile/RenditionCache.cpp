@@ -0,0 +1,126 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <acdriver/Compile/RenditionCache.h>
+#include <plist/Data.h>
+#include <plist/Dictionary.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
+
+#include <iomanip>
+#include <sstream>
+
+using acdriver::Compile::RenditionCache;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+RenditionCache::
+RenditionCache()
+{
+}
+
+std::vector<uint8_t> const *RenditionCache::
+find(std::string const &key) const
+{
+    auto it = _loaded.find(key);
+    if (it != _loaded.end()) {
+        return &it->second;
+    }
+
+    return nullptr;
+}
+
+void RenditionCache::
+insert(std::string const &key, std::vector<uint8_t> const &value)
+{
+    _used[key] = value;
+}
+
+bool RenditionCache::
+load(Filesystem const *filesystem, std::string const &path)
+{
+    _loaded.clear();
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return false;
+    }
+
+    auto deserialize = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create());
+    plist::Dictionary const *dict = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    if (dict == nullptr) {
+        fprintf(stderr, "warning: ignoring invalid rendition cache %s\n", path.c_str());
+        return false;
+    }
+
+    for (size_t n = 0; n < dict->count(); n++) {
+        if (plist::Data const *data = dict->value<plist::Data>(n)) {
+            _loaded.insert({ dict->key(n), data->value() });
+        }
+    }
+
+    return true;
+}
+
+bool RenditionCache::
+save(Filesystem *filesystem, std::string const &path) const
+{
+    /* Nothing to save if the same renditions were used as last time. */
+    if (_used.size() == _loaded.size()) {
+        bool same = true;
+        for (auto const &entry : _used) {
+            if (_loaded.find(entry.first) == _loaded.end()) {
+                same = false;
+                break;
+            }
+        }
+
+        if (same && filesystem->isReadable(path)) {
+            return true;
+        }
+    }
+
+    std::unique_ptr<plist::Dictionary> dict = plist::Dictionary::New();
+    for (auto const &entry : _used) {
+        dict->set(entry.first, plist::Data::New(entry.second));
+    }
+
+    auto serialize = plist::Format::Binary::Serialize(dict.get(), plist::Format::Binary::Create());
+    if (serialize.first == nullptr) {
+        fprintf(stderr, "warning: unable to serialize rendition cache: %s\n", serialize.second.c_str());
+        return false;
+    }
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true) || !filesystem->write(*serialize.first, path)) {
+        return false;
+    }
+
+    return true;
+}
+
+std::string RenditionCache::
+Key(std::vector<uint8_t> const &contents, std::string const &description)
+{
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(contents.data()), contents.size());
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(description.data()), description.size());
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+
+    return ss.str();
+}
@@ -8,14 +8,155 @@
  */
 
 #include <acdriver/Compile/SpriteAtlas.h>
+#include <acdriver/Compile/AtlasPacker.h>
+#include <acdriver/Compile/Convert.h>
+#include <acdriver/Compile/ImageCache.h>
+#include <acdriver/Compile/ImageSet.h>
 #include <acdriver/Compile/Output.h>
 #include <acdriver/Result.h>
+#include <xcassets/Asset/ImageSet.h>
+#include <car/Rendition.h>
+#include <car/Writer.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 using acdriver::Compile::SpriteAtlas;
+using acdriver::Compile::AtlasPacker;
+using acdriver::Compile::Convert;
+using acdriver::Compile::ImageCache;
+using acdriver::Compile::ImageSet;
 using acdriver::Compile::Output;
 using acdriver::Result;
 using libutil::Filesystem;
+using libutil::FSUtil;
+
+/*
+ * The largest page, in pixels, and the space left between sprites so
+ * filtering doesn't bleed across them.
+ */
+static AtlasPacker::Size const PageMaximum = { 2048, 2048 };
+static size_t const PagePadding = 2;
+
+/*
+ * An image in an atlas, read but not yet decoded.
+ */
+struct Sprite {
+    std::string          filename;
+    std::vector<uint8_t> contents;
+    size_t               width;
+    size_t               height;
+};
+
+/*
+ * A page of sprites with the same idiom and scale.
+ */
+struct Page {
+    std::string                        name;
+    uint16_t                           idiom;
+    double                             scale;
+    size_t                             width;
+    size_t                             height;
+    std::vector<std::pair<std::shared_ptr<Sprite>, AtlasPacker::Placement>> sprites;
+
+    std::vector<uint8_t>               rendition;
+};
+
+/*
+ * The size of a PNG image, from its header.
+ */
+static bool
+PNGSize(std::vector<uint8_t> const &contents, size_t *width, size_t *height)
+{
+    static uint8_t const signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    /* Signature, then the IHDR chunk's length and type, then its size. */
+    if (contents.size() < 24 || memcmp(contents.data(), signature, sizeof(signature)) != 0 || memcmp(&contents[12], "IHDR", 4) != 0) {
+        return false;
+    }
+
+    *width = (contents[16] << 24) | (contents[17] << 16) | (contents[18] << 8) | contents[19];
+    *height = (contents[20] << 24) | (contents[21] << 16) | (contents[22] << 8) | contents[23];
+    return true;
+}
+
+static void
+CollectImages(
+    std::vector<std::unique_ptr<xcassets::Asset::Asset>> const &children,
+    std::vector<std::pair<xcassets::Asset::ImageSet const *, xcassets::Asset::ImageSet::Image const *>> *images)
+{
+    for (std::unique_ptr<xcassets::Asset::Asset> const &child : children) {
+        if (child->type() == xcassets::Asset::AssetType::ImageSet) {
+            auto imageSet = static_cast<xcassets::Asset::ImageSet const *>(child.get());
+            if (imageSet->images()) {
+                for (xcassets::Asset::ImageSet::Image const &image : *imageSet->images()) {
+                    images->push_back({ imageSet, &image });
+                }
+            }
+        } else if (child->type() == xcassets::Asset::AssetType::Group) {
+            CollectImages(child->children(), images);
+        }
+    }
+}
+
+/*
+ * Draw the sprites into the page, and encode it.
+ */
+static void
+RenderPage(Page *page, ImageCache *imageCache, car::Rendition::Compression compression)
+{
+    size_t const bytesPerPixel = car::Rendition::Data::FormatSize(car::Rendition::Data::Format::PremultipliedBGRA8);
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(page->width * page->height * bytesPerPixel, 0);
+
+    for (auto const &entry : page->sprites) {
+        Sprite const *sprite = entry.first.get();
+        AtlasPacker::Placement const &placement = entry.second;
+
+        ImageCache::Image image = imageCache->use(ImageSet::DecodedImageKey(sprite->filename), [sprite]() {
+            return ImageSet::DecodeImage(sprite->filename, sprite->contents);
+        });
+
+        /* Images that fail to decode are reported by their image set. */
+        if (image.error || image.width != sprite->width || image.height != sprite->height) {
+            continue;
+        }
+
+        for (size_t y = 0; y < image.height; ++y) {
+            uint8_t *row = &pixels[((placement.y + y) * page->width + placement.x) * bytesPerPixel];
+
+            if (image.format == car::Rendition::Data::Format::PremultipliedBGRA8) {
+                memcpy(row, &image.pixels[y * image.width * bytesPerPixel], image.width * bytesPerPixel);
+            } else if (image.format == car::Rendition::Data::Format::PremultipliedGA8) {
+                uint8_t const *source = &image.pixels[y * image.width * 2];
+                for (size_t x = 0; x < image.width; ++x) {
+                    row[x * 4 + 0] = source[x * 2 + 0];
+                    row[x * 4 + 1] = source[x * 2 + 0];
+                    row[x * 4 + 2] = source[x * 2 + 0];
+                    row[x * 4 + 3] = source[x * 2 + 1];
+                }
+            }
+        }
+    }
+
+    /* The file contents are no longer needed. */
+    page->sprites.clear();
+
+    auto data = ext::optional<car::Rendition::Data>(car::Rendition::Data(std::move(pixels), car::Rendition::Data::Format::PremultipliedBGRA8));
+
+    car::Rendition rendition = car::Rendition::Create(car::AttributeList({ }), std::move(data));
+    rendition.width() = page->width;
+    rendition.height() = page->height;
+    rendition.scale() = page->scale;
+    rendition.fileName() = page->name + ".png";
+    rendition.compression() = compression;
+    page->rendition = rendition.write();
+}
 
 bool SpriteAtlas::
 Compile(
@@ -24,12 +165,109 @@ Compile(
     Output *compileOutput,
     Result *result)
 {
-    result->document(
-        Result::Severity::Warning,
-        spriteAtlas->path(),
-        { Output::AssetReference(spriteAtlas) },
-        "Not Implemented",
-        "sprite atlas not yet supported");
-
-    return false;
+    /* Only compiled catalogs have pages. */
+    if (!compileOutput->car()) {
+        return true;
+    }
+
+    std::vector<std::pair<xcassets::Asset::ImageSet const *, xcassets::Asset::ImageSet::Image const *>> images;
+    CollectImages(spriteAtlas->children(), &images);
+
+    /*
+     * Sprites are packed with others of the same idiom and scale. The image
+     * sets still compile each sprite on its own, so the sprites that can't
+     * be packed are only skipped here.
+     */
+    std::map<std::pair<uint16_t, double>, std::vector<std::shared_ptr<Sprite>>> groups;
+    for (auto const &entry : images) {
+        xcassets::Asset::ImageSet::Image const &image = *entry.second;
+        if (!image.fileName() || image.unassigned() || !image.idiom()) {
+            continue;
+        }
+
+        std::string filename = FSUtil::ResolveRelativePath(*image.fileName(), entry.first->path());
+        if (!FSUtil::IsFileExtension(filename, "png", true)) {
+            continue;
+        }
+
+        auto sprite = std::make_shared<Sprite>();
+        sprite->filename = filename;
+        if (!filesystem->read(&sprite->contents, filename) || !PNGSize(sprite->contents, &sprite->width, &sprite->height)) {
+            continue;
+        }
+
+        /* The default (0) is any scale. */
+        double scale = 0;
+        if (image.scale()) {
+            scale = image.scale()->value();
+        }
+
+        uint16_t idiom = Convert::IdiomAttribute(*image.idiom());
+        groups[{ idiom, scale }].push_back(std::move(sprite));
+    }
+
+    ImageCache *imageCache = &compileOutput->imageCache();
+    car::Rendition::Compression compression = compileOutput->compression();
+
+    for (auto &group : groups) {
+        std::vector<std::shared_ptr<Sprite>> &sprites = group.second;
+
+        std::vector<AtlasPacker::Size> sizes;
+        sizes.reserve(sprites.size());
+        for (std::shared_ptr<Sprite> const &sprite : sprites) {
+            sizes.push_back({ sprite->width, sprite->height });
+        }
+
+        std::vector<AtlasPacker::Page> packed;
+        std::vector<ext::optional<AtlasPacker::Placement>> placements = AtlasPacker::Pack(sizes, PageMaximum, PagePadding, &packed);
+
+        std::vector<std::shared_ptr<Page>> pages;
+        for (size_t n = 0; n < packed.size(); ++n) {
+            auto page = std::make_shared<Page>();
+            page->name = "ZZZZPackedAsset-" + spriteAtlas->name().string() + "-" + std::to_string(group.first.first) + "-" + std::to_string(static_cast<int>(group.first.second)) + "-" + std::to_string(n);
+            page->idiom = group.first.first;
+            page->scale = group.first.second;
+            page->width = packed[n].width;
+            page->height = packed[n].height;
+            pages.push_back(std::move(page));
+        }
+
+        for (size_t n = 0; n < sprites.size(); ++n) {
+            if (!placements[n]) {
+                result->normal(Result::Severity::Warning, "image too large for a sprite atlas page", sprites[n]->filename);
+                continue;
+            }
+
+            /* Decoded once for both the page and the image set. */
+            imageCache->retain(ImageSet::DecodedImageKey(sprites[n]->filename));
+            pages[placements[n]->page]->sprites.push_back({ sprites[n], *placements[n] });
+        }
+
+        /*
+         * Pages are drawn in parallel with each other and other assets.
+         */
+        for (std::shared_ptr<Page> const &page : pages) {
+            compileOutput->deferred().push_back({
+                [page, imageCache, compression](Output::Scratch *scratch) {
+                    RenderPage(page.get(), imageCache, compression);
+                },
+                [page, compileOutput](Result *result) {
+                    uint16_t facetIdentifier = ImageSet::FacetIdentifier(page->name, compileOutput);
+
+                    car::AttributeList attributes = car::AttributeList({
+                        { car_attribute_identifier_idiom, page->idiom },
+                        { car_attribute_identifier_scale, static_cast<int>(page->scale) },
+                        { car_attribute_identifier_identifier, facetIdentifier },
+                    });
+
+                    compileOutput->car()->addRendition(attributes, page->rendition);
+
+                    /* Release the rendition once added. */
+                    page->rendition = std::vector<uint8_t>();
+                },
+            });
+        }
+    }
+
+    return true;
 }
@@ -62,6 +62,8 @@ WriteOutput(Filesystem *filesystem, Options const &options, Compile::Output cons
      * Write out compiled archive.
      */
     if (compileOutput.car()) {
+        Compile::Benchmark::Timer timer(compileOutput.benchmark().get(), Compile::Benchmark::Stage::Write);
+
         // TODO: only write if non-empty. but did mmap already create the file?
         compileOutput.car()->write();
     }
@@ -166,6 +168,25 @@ DetermineOutputFormat(ext::optional<std::string> const &minimumDeploymentTarget)
     }
 }
 
+static ext::optional<car::Rendition::Compression>
+DetermineCompression(ext::optional<std::string> const &optimization)
+{
+    if (!optimization || optimization->empty()) {
+        return car::Rendition::Compression::Default;
+    } else if (*optimization == "time") {
+        /* Compress quickly for faster builds. */
+        return car::Rendition::Compression::Fast;
+    } else if (*optimization == "space") {
+        /* Compress as small as possible. */
+        return car::Rendition::Compression::Best;
+    } else if (*optimization == "none") {
+        /* Store without compression, fastest for iterating. */
+        return car::Rendition::Compression::None;
+    } else {
+        return ext::nullopt;
+    }
+}
+
 static ext::optional<car::Writer>
 CreateWriter(std::string const &path)
 {
@@ -189,10 +210,6 @@ WarnUnsupportedOptions(Options const &options, Result *result)
         result->normal(Result::Severity::Warning, "product type not supported");
     }
 
-    if (options.optimization()) {
-        result->normal(Result::Severity::Warning, "optimization not supported");
-    }
-
     if (options.compressPNGs()) {
         result->normal(Result::Severity::Warning, "compress PNGs not supported");
     }
@@ -254,6 +271,15 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
         return;
     }
 
+    /*
+     * Determine how much to compress compiled assets.
+     */
+    ext::optional<car::Rendition::Compression> compression = DetermineCompression(options.optimization());
+    if (!compression) {
+        result->normal(Result::Severity::Warning, "unknown optimization " + *options.optimization());
+        compression = car::Rendition::Compression::Default;
+    }
+
     /*
      * Create compilation output.
      */
@@ -262,10 +288,15 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
         *outputFormat,
         options.appIcon(),
         options.launchImage());
+    compileOutput.compression() = *compression;
+    if (options.benchmark()) {
+        compileOutput.benchmark().reset(new Compile::Benchmark());
+    }
 
     /*
      * If necessary, create output archive to write into.
      */
+    ext::optional<std::string> renditionCachePath;
     if (compileOutput.format() == Compile::Output::Format::Compiled) {
         std::string outputFilename = options.compileOutputFilename().value_or("Assets.car");
         std::string path = compileOutput.root() + "/" + outputFilename;
@@ -279,6 +310,15 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
         compileOutput.car() = std::move(writer);
         // TODO: should only be an output if ultimately non-empty
         compileOutput.outputs().push_back(path);
+
+        /*
+         * Keep encoded renditions alongside the partial info plist, which
+         * is in the intermediates directory, to reuse when recompiling.
+         */
+        if (options.outputPartialInfoPlist()) {
+            renditionCachePath = FSUtil::GetDirectoryName(*options.outputPartialInfoPlist()) + "/" + outputFilename + ".renditions";
+            compileOutput.renditionCache().load(filesystem, *renditionCachePath);
+        }
     }
 
     /*
@@ -288,7 +328,11 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
         /*
          * Load the input asset catalog.
          */
-        auto catalog = xcassets::Asset::Catalog::Load(filesystem, input);
+        std::unique_ptr<xcassets::Asset::Catalog> catalog;
+        {
+            Compile::Benchmark::Timer timer(compileOutput.benchmark().get(), Compile::Benchmark::Stage::Load, input);
+            catalog = xcassets::Asset::Catalog::Load(filesystem, input);
+        }
         if (catalog == nullptr) {
             result->normal(
                 Result::Severity::Error,
@@ -309,6 +353,11 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
         compileOutput.inputs().push_back(input);
     }
 
+    /*
+     * Finish compiling the images from every catalog.
+     */
+    compileOutput.finishDeferred(result);
+
     /*
      * Write out the output.
      */
@@ -316,5 +365,19 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
         /* Error already reported. */
         return;
     }
+
+    /*
+     * Report where the time went, if requested.
+     */
+    if (compileOutput.benchmark()) {
+        output->add("com.apple.actool.benchmark", compileOutput.benchmark()->dictionary(), compileOutput.benchmark()->text());
+    }
+
+    /*
+     * Save the encoded renditions for the next compile.
+     */
+    if (renditionCachePath) {
+        compileOutput.renditionCache().save(filesystem, *renditionCachePath);
+    }
 }
 
@@ -50,6 +50,8 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_optimization, args, it);
     } else if (arg == "--compress-pngs") {
         return libutil::Options::Current<bool>(&_compressPNGs, arg);
+    } else if (arg == "--benchmark") {
+        return libutil::Options::Current<bool>(&_benchmark, arg);
     } else if (arg == "--platform") {
         return libutil::Options::Next<std::string>(&_platform, args, it);
     } else if (arg == "--minimum-deployment-target") {
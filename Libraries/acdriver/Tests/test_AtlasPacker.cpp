@@ -0,0 +1,122 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <acdriver/Compile/AtlasPacker.h>
+
+using acdriver::Compile::AtlasPacker;
+
+/*
+ * Check every placed rectangle is inside its page and overlaps no other.
+ */
+static void
+ExpectPacked(
+    std::vector<AtlasPacker::Size> const &sizes,
+    std::vector<ext::optional<AtlasPacker::Placement>> const &placements,
+    std::vector<AtlasPacker::Page> const &pages,
+    size_t padding)
+{
+    ASSERT_EQ(sizes.size(), placements.size());
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        if (!placements[i]) {
+            continue;
+        }
+
+        AtlasPacker::Placement const &a = *placements[i];
+        ASSERT_LT(a.page, pages.size());
+        EXPECT_LE(a.x + sizes[i].width, pages[a.page].width);
+        EXPECT_LE(a.y + sizes[i].height, pages[a.page].height);
+
+        for (size_t j = i + 1; j < sizes.size(); ++j) {
+            if (!placements[j] || placements[j]->page != a.page) {
+                continue;
+            }
+
+            AtlasPacker::Placement const &b = *placements[j];
+            bool separate =
+                a.x + sizes[i].width + padding <= b.x || b.x + sizes[j].width + padding <= a.x ||
+                a.y + sizes[i].height + padding <= b.y || b.y + sizes[j].height + padding <= a.y;
+            EXPECT_TRUE(separate) << i << " overlaps " << j;
+        }
+    }
+}
+
+TEST(AtlasPacker, Empty)
+{
+    std::vector<AtlasPacker::Page> pages;
+    auto placements = AtlasPacker::Pack({ }, { 64, 64 }, 0, &pages);
+    EXPECT_TRUE(placements.empty());
+    EXPECT_TRUE(pages.empty());
+}
+
+TEST(AtlasPacker, Exact)
+{
+    /* Four quarters fill the page exactly. */
+    std::vector<AtlasPacker::Size> sizes = { { 32, 32 }, { 32, 32 }, { 32, 32 }, { 32, 32 } };
+
+    std::vector<AtlasPacker::Page> pages;
+    auto placements = AtlasPacker::Pack(sizes, { 64, 64 }, 0, &pages);
+    ASSERT_EQ(1, pages.size());
+    EXPECT_EQ(64, pages[0].width);
+    EXPECT_EQ(64, pages[0].height);
+    ExpectPacked(sizes, placements, pages, 0);
+    for (auto const &placement : placements) {
+        EXPECT_TRUE(placement);
+    }
+}
+
+TEST(AtlasPacker, Padding)
+{
+    /* With padding, only three fit side by side. */
+    std::vector<AtlasPacker::Size> sizes = { { 20, 64 }, { 20, 64 }, { 20, 64 }, { 20, 64 } };
+
+    std::vector<AtlasPacker::Page> pages;
+    auto placements = AtlasPacker::Pack(sizes, { 64, 64 }, 2, &pages);
+    ASSERT_EQ(2, pages.size());
+    ExpectPacked(sizes, placements, pages, 2);
+    EXPECT_EQ(64, pages[0].width);
+    EXPECT_EQ(20, pages[1].width);
+}
+
+TEST(AtlasPacker, TooLarge)
+{
+    std::vector<AtlasPacker::Size> sizes = { { 16, 16 }, { 65, 8 }, { 0, 8 } };
+
+    std::vector<AtlasPacker::Page> pages;
+    auto placements = AtlasPacker::Pack(sizes, { 64, 64 }, 1, &pages);
+    ASSERT_EQ(1, pages.size());
+    EXPECT_TRUE(placements[0]);
+    EXPECT_FALSE(placements[1]);
+    EXPECT_FALSE(placements[2]);
+    EXPECT_EQ(16, pages[0].width);
+    EXPECT_EQ(16, pages[0].height);
+}
+
+TEST(AtlasPacker, Mixed)
+{
+    std::vector<AtlasPacker::Size> sizes;
+    for (size_t n = 0; n < 200; ++n) {
+        sizes.push_back({ 4 + (n * 37) % 61, 4 + (n * 53) % 47 });
+    }
+
+    std::vector<AtlasPacker::Page> pages;
+    auto placements = AtlasPacker::Pack(sizes, { 256, 256 }, 1, &pages);
+    ExpectPacked(sizes, placements, pages, 1);
+
+    size_t area = 0;
+    for (size_t n = 0; n < sizes.size(); ++n) {
+        ASSERT_TRUE(placements[n]);
+        area += (sizes[n].width + 1) * (sizes[n].height + 1);
+    }
+
+    /* Most of each page is used. */
+    size_t pageArea = pages.size() * 257 * 257;
+    EXPECT_GT(area * 10, pageArea * 7);
+}
@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <acdriver/Compile/Benchmark.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/Real.h>
+
+using acdriver::Compile::Benchmark;
+
+TEST(Benchmark, Record)
+{
+    Benchmark benchmark;
+    benchmark.record(Benchmark::Stage::Decode, "a.imageset", 1.0);
+    benchmark.record(Benchmark::Stage::Decode, "b.imageset", 0.5);
+    benchmark.record(Benchmark::Stage::Compress, "a.imageset", 0.25);
+    benchmark.record(Benchmark::Stage::Write, "", 2.0);
+
+    auto dict = benchmark.dictionary();
+    auto totals = dict->value<plist::Dictionary>("totals");
+    ASSERT_NE(nullptr, totals);
+    EXPECT_EQ(nullptr, totals->value<plist::Dictionary>("load"));
+
+    auto decode = totals->value<plist::Dictionary>("decode");
+    ASSERT_NE(nullptr, decode);
+    EXPECT_EQ(1.5, decode->value<plist::Real>("seconds")->value());
+    EXPECT_EQ(2, decode->value<plist::Integer>("count")->value());
+    EXPECT_EQ(2.0, totals->value<plist::Dictionary>("write")->value<plist::Real>("seconds")->value());
+
+    /* Times without an asset are only in the totals. */
+    auto assets = dict->value<plist::Dictionary>("assets");
+    ASSERT_NE(nullptr, assets);
+    EXPECT_EQ(2, assets->count());
+
+    auto a = assets->value<plist::Dictionary>("a.imageset");
+    ASSERT_NE(nullptr, a);
+    EXPECT_EQ(1.0, a->value<plist::Dictionary>("decode")->value<plist::Real>("seconds")->value());
+    EXPECT_EQ(0.25, a->value<plist::Dictionary>("compress")->value<plist::Real>("seconds")->value());
+    EXPECT_EQ(nullptr, a->value<plist::Dictionary>("write"));
+
+    EXPECT_EQ(
+        "total: decode 1.500s compress 0.250s write 2.000s\n"
+        "a.imageset: decode 1.000s compress 0.250s\n"
+        "b.imageset: decode 0.500s\n",
+        benchmark.text());
+}
+
+TEST(Benchmark, Timer)
+{
+    Benchmark benchmark;
+    {
+        Benchmark::Timer timer(&benchmark, Benchmark::Stage::Load, "Assets.xcassets");
+    }
+
+    auto dict = benchmark.dictionary();
+    auto load = dict->value<plist::Dictionary>("totals")->value<plist::Dictionary>("load");
+    ASSERT_NE(nullptr, load);
+    EXPECT_EQ(1, load->value<plist::Integer>("count")->value());
+    EXPECT_GE(load->value<plist::Real>("seconds")->value(), 0.0);
+
+    /* Without a benchmark, nothing happens. */
+    Benchmark::Timer timer(nullptr, Benchmark::Stage::Load);
+}
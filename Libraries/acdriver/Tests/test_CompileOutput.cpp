@@ -0,0 +1,45 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <acdriver/Compile/Output.h>
+#include <acdriver/Result.h>
+
+#include <memory>
+#include <vector>
+
+using acdriver::Compile::Output;
+using acdriver::Result;
+
+TEST(CompileOutput, Deferred)
+{
+    Output output = Output("/output", Output::Format::Compiled, ext::nullopt, ext::nullopt);
+
+    std::vector<int> committed;
+    for (int i = 0; i < 64; i++) {
+        std::shared_ptr<int> prepared = std::make_shared<int>(-1);
+        output.deferred().push_back({
+            [prepared, i](Output::Scratch *scratch) {
+                *prepared = i;
+            },
+            [prepared, &committed](Result *result) {
+                committed.push_back(*prepared);
+            },
+        });
+    }
+
+    /* Everything is prepared before being committed in order. */
+    Result result;
+    output.finishDeferred(&result);
+    ASSERT_EQ(committed.size(), 64);
+    for (int i = 0; i < 64; i++) {
+        EXPECT_EQ(committed[i], i);
+    }
+    EXPECT_TRUE(output.deferred().empty());
+}
@@ -0,0 +1,137 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <acdriver/Compile/ImageCache.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using acdriver::Compile::ImageCache;
+
+static ImageCache::Image
+TestImage(uint8_t value)
+{
+    ImageCache::Image image;
+    image.pixels = std::vector<uint8_t>(16, value);
+    image.width = 2;
+    image.height = 2;
+    image.format = car::Rendition::Data::Format::PremultipliedBGRA8;
+    return image;
+}
+
+TEST(ImageCache, Key)
+{
+    EXPECT_EQ(ImageCache::Key("a.png", "BGRA"), ImageCache::Key("a.png", "BGRA"));
+    EXPECT_NE(ImageCache::Key("a.png", "BGRA"), ImageCache::Key("b.png", "BGRA"));
+    EXPECT_NE(ImageCache::Key("a.png", "BGRA"), ImageCache::Key("a.png", "RGBA"));
+}
+
+TEST(ImageCache, DecodeOnce)
+{
+    ImageCache cache;
+    cache.retain("a");
+    cache.retain("a");
+    cache.retain("a");
+
+    size_t decodes = 0;
+    auto decode = [&decodes]() {
+        decodes++;
+        return TestImage(7);
+    };
+
+    for (size_t n = 0; n < 3; ++n) {
+        ImageCache::Image image = cache.use("a", decode);
+        EXPECT_EQ(std::vector<uint8_t>(16, 7), image.pixels);
+        EXPECT_EQ(2, image.width);
+        EXPECT_FALSE(image.error);
+    }
+    EXPECT_EQ(1, decodes);
+
+    /* Released after the last use. */
+    cache.use("a", decode);
+    EXPECT_EQ(2, decodes);
+}
+
+TEST(ImageCache, Release)
+{
+    ImageCache cache;
+    cache.retain("a");
+    cache.retain("a");
+
+    size_t decodes = 0;
+    auto decode = [&decodes]() {
+        decodes++;
+        return TestImage(1);
+    };
+
+    /* A released use does not decode; the only remaining use keeps nothing. */
+    cache.release("a");
+    cache.use("a", decode);
+    EXPECT_EQ(1, decodes);
+
+    cache.retain("b");
+    cache.release("b");
+    cache.use("b", decode);
+    EXPECT_EQ(2, decodes);
+}
+
+TEST(ImageCache, Error)
+{
+    ImageCache cache;
+    cache.retain("a");
+    cache.retain("a");
+
+    size_t decodes = 0;
+    auto decode = [&decodes]() {
+        decodes++;
+        ImageCache::Image image;
+        image.error = std::string("invalid");
+        return image;
+    };
+
+    EXPECT_EQ(std::string("invalid"), *cache.use("a", decode).error);
+    EXPECT_EQ(std::string("invalid"), *cache.use("a", decode).error);
+    EXPECT_EQ(1, decodes);
+}
+
+TEST(ImageCache, Concurrent)
+{
+    size_t const uses = 64;
+
+    ImageCache cache;
+    for (size_t n = 0; n < uses; ++n) {
+        cache.retain("a");
+    }
+
+    std::atomic<size_t> decodes(0);
+    std::atomic<size_t> matches(0);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (size_t n = 0; n < uses / 8; ++n) {
+                ImageCache::Image image = cache.use("a", [&decodes]() {
+                    decodes++;
+                    return TestImage(3);
+                });
+                if (image.pixels == std::vector<uint8_t>(16, 3)) {
+                    matches++;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(1, decodes.load());
+    EXPECT_EQ(uses, matches.load());
+}
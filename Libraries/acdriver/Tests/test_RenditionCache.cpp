@@ -0,0 +1,56 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <acdriver/Compile/RenditionCache.h>
+#include <libutil/MemoryFilesystem.h>
+
+using acdriver::Compile::RenditionCache;
+using libutil::MemoryFilesystem;
+
+TEST(RenditionCache, Key)
+{
+    std::vector<uint8_t> contents = { 1, 2, 3 };
+    std::vector<uint8_t> changed = { 1, 2, 4 };
+
+    EXPECT_EQ(RenditionCache::Key(contents, "a.png"), RenditionCache::Key(contents, "a.png"));
+    EXPECT_NE(RenditionCache::Key(contents, "a.png"), RenditionCache::Key(changed, "a.png"));
+    EXPECT_NE(RenditionCache::Key(contents, "a.png"), RenditionCache::Key(contents, "b.png"));
+}
+
+TEST(RenditionCache, SaveLoad)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("intermediates", { }),
+    });
+
+    std::string used = RenditionCache::Key({ 1 }, "used");
+    std::string unused = RenditionCache::Key({ 2 }, "unused");
+
+    /* Nothing to load the first time. */
+    RenditionCache first;
+    EXPECT_FALSE(first.load(&filesystem, "/intermediates/Assets.car.renditions"));
+    EXPECT_EQ(first.find(used), nullptr);
+    first.insert(used, { 10, 11 });
+    first.insert(unused, { 12 });
+    EXPECT_TRUE(first.save(&filesystem, "/intermediates/Assets.car.renditions"));
+
+    RenditionCache second;
+    EXPECT_TRUE(second.load(&filesystem, "/intermediates/Assets.car.renditions"));
+    ASSERT_NE(second.find(used), nullptr);
+    EXPECT_EQ(*second.find(used), std::vector<uint8_t>({ 10, 11 }));
+    second.insert(used, *second.find(used));
+    EXPECT_TRUE(second.save(&filesystem, "/intermediates/Assets.car.renditions"));
+
+    /* Renditions not used by the last compile are dropped. */
+    RenditionCache third;
+    EXPECT_TRUE(third.load(&filesystem, "/intermediates/Assets.car.renditions"));
+    EXPECT_NE(third.find(used), nullptr);
+    EXPECT_EQ(third.find(unused), nullptr);
+}
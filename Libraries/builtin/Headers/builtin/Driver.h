@@ -28,7 +28,22 @@ public:
     virtual std::string name() = 0;
 
 public:
-    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem) = 0;
+    /*
+     * Run the builtin. Everything a run uses is passed in: the process
+     * context for its arguments, environment and working directory, and
+     * the filesystem. Running does not change the driver.
+     */
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem) const = 0;
+
+public:
+    /*
+     * If the driver can run more than once at the same time, on different
+     * threads. Reentrant drivers must not use any shared mutable state,
+     * including process state such as the working directory; they must
+     * only change files through the filesystem they are given, which must
+     * itself be safe to use from multiple threads.
+     */
+    virtual bool reentrant() const;
 };
 
 }
@@ -28,8 +28,13 @@ public:
     ~Registry();
 
 public:
+    /*
+     * Find a driver by name. Safe to call from multiple threads; drivers are
+     * shared between all callers, so only reentrant drivers can be run by
+     * more than one caller at once.
+     */
     std::shared_ptr<Driver>
-    driver(std::string const &name);
+    driver(std::string const &name) const;
 
 public:
     static Registry
@@ -0,0 +1,82 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __builtin_Server_h
+#define __builtin_Server_h
+
+#include <builtin/Registry.h>
+
+#include <string>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+
+namespace builtin {
+
+/*
+ * Runs builtin tools for clients connecting over a local socket. Avoids
+ * launching a new process for each builtin tool invocation. The client
+ * passes its output streams to the server, so tool output goes to the
+ * client's output as if the tool was run by the client. Requests are run
+ * one at a time, since tools run in the server's process.
+ *
+ * The socket must be in a directory only its user can access, and both
+ * ends check that the other is running as the same user.
+ */
+class Server {
+private:
+    Registry _registry;
+
+public:
+    Server(Registry const &registry);
+    ~Server();
+
+public:
+    /*
+     * Listens on a socket at the path and runs requests until asked to
+     * stop, or until no requests arrive for the idle timeout in seconds.
+     * Fails if the socket can't be created, or if its directory is not
+     * private to the user.
+     */
+    bool serve(
+        process::Context const *processContext,
+        libutil::Filesystem *filesystem,
+        std::string const &socketPath,
+        int idleTimeout);
+
+public:
+    /*
+     * Runs a builtin tool in the server listening at the path. The
+     * tool's arguments, environment, and working directory come from
+     * the process context. Returns the tool's exit code, or nothing if
+     * no server could run the tool; the caller should then run it.
+     */
+    static ext::optional<int>
+    Run(process::Context const *processContext, std::string const &socketPath, std::string const &name);
+
+    /*
+     * Asks the server listening at the path to stop.
+     */
+    static bool
+    Stop(std::string const &socketPath);
+
+public:
+    /*
+     * A directory for server sockets only the user can access, in the
+     * user's temporary directory. Created if it doesn't exist. Returns
+     * nothing if it can't be created, or if someone else owns it.
+     */
+    static ext::optional<std::string>
+    SocketDirectory(process::Context const *processContext);
+};
+
+}
+
+#endif // !__builtin_Server_h
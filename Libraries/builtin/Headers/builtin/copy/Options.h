@@ -33,11 +33,16 @@ private:
 
 private:
     std::vector<std::string>        _inputs;
+    std::vector<std::string>        _fileLists;
     ext::optional<bool>             _ignoreMissingInputs;
     ext::optional<bool>             _resolveSrcSymlinks;
     ext::optional<std::string>      _output;
     std::vector<std::string>        _excludes;
 
+private:
+    ext::optional<bool>             _skipUnchanged;
+    ext::optional<bool>             _skipUnchangedContents;
+
 private:
     ext::optional<bool>             _stripDebugSymbols;
     ext::optional<std::string>      _stripTool;
@@ -57,6 +62,8 @@ public:
 public:
     std::vector<std::string> const &inputs() const
     { return _inputs; }
+    std::vector<std::string> const &fileLists() const
+    { return _fileLists; }
     bool ignoreMissingInputs() const
     { return _ignoreMissingInputs.value_or(false); }
     bool resolveSrcSymlinks() const
@@ -66,6 +73,20 @@ public:
     std::vector<std::string> const &excludes() const
     { return _excludes; }
 
+public:
+    /*
+     * Leave outputs that already match their inputs untouched. Files
+     * match when their size and modification time are the same.
+     */
+    bool skipUnchanged() const
+    { return _skipUnchanged.value_or(false) || skipUnchangedContents(); }
+    /*
+     * Also compare contents of files that don't match by modification
+     * time, for filesystems that don't keep modification times.
+     */
+    bool skipUnchangedContents() const
+    { return _skipUnchangedContents.value_or(false); }
+
 public:
     bool stripDebugSymbols() const
     { return _stripDebugSymbols.value_or(false); }
@@ -23,6 +23,8 @@ class Options {
 private:
     std::vector<std::string>   _inputs;
     ext::optional<std::string> _outputDirectory;
+    std::vector<std::string>   _pairInputs;
+    std::vector<std::string>   _pairOutputs;
 
 public:
     ext::optional<bool>        _validate;
@@ -44,6 +46,16 @@ public:
     ext::optional<std::string> const &outputDirectory() const
     { return _outputDirectory; }
 
+public:
+    /*
+     * Inputs with an explicit output path each, rather than a name in the
+     * output directory. Many pairs can be converted in one invocation.
+     */
+    std::vector<std::string> const &pairInputs() const
+    { return _pairInputs; }
+    std::vector<std::string> const &pairOutputs() const
+    { return _pairOutputs; }
+
 public:
     bool validate() const
     { return _validate.value_or(false); }
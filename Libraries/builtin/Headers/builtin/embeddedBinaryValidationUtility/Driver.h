@@ -11,6 +11,10 @@
 #define __builtin_embeddedBinaryValidationUtility_Driver_h
 
 #include <builtin/Driver.h>
+#include <ext/optional>
+
+#include <string>
+#include <vector>
 
 namespace builtin {
 namespace embeddedBinaryValidationUtility {
@@ -24,7 +28,18 @@ public:
     virtual std::string name();
 
 public:
-    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem);
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem) const;
+    virtual bool reentrant() const;
+
+public:
+    /*
+     * Check a bundle's Info.plist and the header of its executable. Only
+     * the first bytes of the executable are read. With a parent identifier,
+     * also check the bundle identifier is prefixed by it, as required for
+     * embedded bundles. Returns the problems found.
+     */
+    static std::vector<std::string>
+    Validate(libutil::Filesystem const *filesystem, std::string const &bundle, ext::optional<std::string> const &parentIdentifier);
 };
 
 }
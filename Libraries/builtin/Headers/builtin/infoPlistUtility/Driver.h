@@ -12,10 +12,33 @@
 
 #include <builtin/Driver.h>
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace builtin {
 namespace infoPlistUtility {
 
 class Driver : public builtin::Driver {
+public:
+    /*
+     * The files generated from one set of inputs.
+     */
+    struct Generated {
+        std::vector<uint8_t> output;
+        std::vector<uint8_t> pkgInfo;
+    };
+
+private:
+    /*
+     * Generated files, keyed by a digest of everything they are generated
+     * from: the arguments, the input and additional content files, and the
+     * build settings. Unchanged inputs are not processed again.
+     */
+    mutable std::unordered_map<std::string, Generated> _generated;
+    mutable std::mutex                                 _generatedMutex;
+
 public:
     Driver();
     ~Driver();
@@ -24,7 +47,8 @@ public:
     virtual std::string name();
 
 public:
-    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem);
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem) const;
+    virtual bool reentrant() const;
 };
 
 }
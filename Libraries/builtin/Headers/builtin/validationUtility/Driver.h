@@ -24,7 +24,8 @@ public:
     virtual std::string name();
 
 public:
-    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem);
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem) const;
+    virtual bool reentrant() const;
 };
 
 }
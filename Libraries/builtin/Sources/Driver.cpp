@@ -21,3 +21,9 @@ Driver::
 {
 }
 
+bool Driver::
+reentrant() const
+{
+    return false;
+}
+
@@ -33,7 +33,7 @@ Registry::
 }
 
 std::shared_ptr<Driver> Registry::
-driver(std::string const &name)
+driver(std::string const &name) const
 {
     auto const &it = _drivers.find(name);
     if (it != _drivers.end()) {
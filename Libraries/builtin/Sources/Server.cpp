@@ -0,0 +1,530 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/Server.h>
+#include <builtin/Driver.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Ownership.h>
+#include <process/Context.h>
+#include <process/MemoryContext.h>
+
+#include <vector>
+#include <unordered_map>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using builtin::Server;
+using builtin::Registry;
+using builtin::Driver;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Ownership;
+
+/*
+ * Identifies the protocol, so mismatched clients and servers fail cleanly.
+ */
+static uint32_t const ServerProtocolVersion = 1;
+
+enum ServerRequestType : uint32_t {
+    kServerRequestRun  = 0,
+    kServerRequestStop = 1,
+};
+
+Server::
+Server(Registry const &registry) :
+    _registry(registry)
+{
+}
+
+Server::
+~Server()
+{
+}
+
+static bool
+SocketAddress(std::string const &socketPath, struct sockaddr_un *address)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address->sun_path)) {
+        return false;
+    }
+
+    strncpy(address->sun_path, socketPath.c_str(), sizeof(address->sun_path) - 1);
+    return true;
+}
+
+static int
+SocketCreate()
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* Don't leak the socket into processes the tools launch. */
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+#if defined(SO_NOSIGPIPE)
+    /* Report closed connections as errors rather than signals. */
+    int value = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#endif
+
+    return fd;
+}
+
+static bool
+WriteBytes(int fd, void const *data, size_t size)
+{
+#if defined(MSG_NOSIGNAL)
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+
+    uint8_t const *bytes = static_cast<uint8_t const *>(data);
+    while (size > 0) {
+        ssize_t written = ::send(fd, bytes, size, flags);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        bytes += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static bool
+ReadBytes(int fd, void *data, size_t size)
+{
+    uint8_t *bytes = static_cast<uint8_t *>(data);
+    while (size > 0) {
+        ssize_t count = ::recv(fd, bytes, size, 0);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        } else if (count == 0) {
+            /* Connection closed early. */
+            return false;
+        }
+
+        bytes += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+static bool
+WriteInteger(int fd, uint32_t value)
+{
+    return WriteBytes(fd, &value, sizeof(value));
+}
+
+static bool
+ReadInteger(int fd, uint32_t *value)
+{
+    return ReadBytes(fd, value, sizeof(*value));
+}
+
+static bool
+WriteString(int fd, std::string const &value)
+{
+    return WriteInteger(fd, static_cast<uint32_t>(value.size())) && WriteBytes(fd, value.data(), value.size());
+}
+
+static bool
+ReadString(int fd, std::string *value)
+{
+    uint32_t size;
+    if (!ReadInteger(fd, &size)) {
+        return false;
+    }
+
+    value->resize(size);
+    return size == 0 || ReadBytes(fd, &(*value)[0], size);
+}
+
+static bool
+WriteDescriptors(int fd, uint32_t type, std::vector<int> const &descriptors)
+{
+    /*
+     * Send the request type along with the descriptors in the control data.
+     */
+    struct iovec vector;
+    vector.iov_base = &type;
+    vector.iov_len = sizeof(type);
+
+    std::vector<uint8_t> control = std::vector<uint8_t>(CMSG_SPACE(sizeof(int) * descriptors.size()));
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+
+    if (!descriptors.empty()) {
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+
+        struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * descriptors.size());
+        memcpy(CMSG_DATA(header), descriptors.data(), sizeof(int) * descriptors.size());
+    }
+
+#if defined(MSG_NOSIGNAL)
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+
+    ssize_t written;
+    do {
+        written = ::sendmsg(fd, &message, flags);
+    } while (written < 0 && errno == EINTR);
+
+    return written == sizeof(type);
+}
+
+static bool
+ReadDescriptors(int fd, uint32_t *type, std::vector<int> *descriptors, size_t count)
+{
+    struct iovec vector;
+    vector.iov_base = type;
+    vector.iov_len = sizeof(*type);
+
+    std::vector<uint8_t> control = std::vector<uint8_t>(CMSG_SPACE(sizeof(int) * count));
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    ssize_t length;
+    do {
+        length = ::recvmsg(fd, &message, 0);
+    } while (length < 0 && errno == EINTR);
+
+    if (length != sizeof(*type)) {
+        return false;
+    }
+
+    for (struct cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            size_t received = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            std::vector<int> values = std::vector<int>(received);
+            memcpy(values.data(), CMSG_DATA(header), sizeof(int) * received);
+            descriptors->insert(descriptors->end(), values.begin(), values.end());
+        }
+    }
+
+    return true;
+}
+
+struct ServerRequest {
+    std::string                                  name;
+    std::string                                  currentDirectory;
+    std::vector<std::string>                     arguments;
+    std::unordered_map<std::string, std::string> environment;
+};
+
+static bool
+ReadRequest(int fd, ServerRequest *request)
+{
+    if (!ReadString(fd, &request->name) || !ReadString(fd, &request->currentDirectory)) {
+        return false;
+    }
+
+    uint32_t arguments;
+    if (!ReadInteger(fd, &arguments)) {
+        return false;
+    }
+    for (uint32_t n = 0; n < arguments; ++n) {
+        std::string argument;
+        if (!ReadString(fd, &argument)) {
+            return false;
+        }
+        request->arguments.push_back(argument);
+    }
+
+    uint32_t variables;
+    if (!ReadInteger(fd, &variables)) {
+        return false;
+    }
+    for (uint32_t n = 0; n < variables; ++n) {
+        std::string variable;
+        std::string value;
+        if (!ReadString(fd, &variable) || !ReadString(fd, &value)) {
+            return false;
+        }
+        request->environment.insert({ variable, value });
+    }
+
+    return true;
+}
+
+static int
+RunRequest(
+    Registry *registry,
+    process::Context const *processContext,
+    Filesystem *filesystem,
+    ServerRequest const &request,
+    int output,
+    int error)
+{
+    std::shared_ptr<Driver> driver = registry->driver(request.name);
+    if (driver == nullptr) {
+        dprintf(error, "error: unknown builtin tool %s\n", request.name.c_str());
+        return 1;
+    }
+
+    /*
+     * Tools write directly to the standard streams and may use relative
+     * paths, so point both at the client's for the duration of the tool.
+     */
+    fflush(stdout);
+    fflush(stderr);
+    int savedOutput = ::dup(STDOUT_FILENO);
+    int savedError = ::dup(STDERR_FILENO);
+    ::dup2(output, STDOUT_FILENO);
+    ::dup2(error, STDERR_FILENO);
+
+    int savedDirectory = ::open(".", O_RDONLY);
+    if (::chdir(request.currentDirectory.c_str()) != 0) {
+        fprintf(stderr, "warning: unable to change to directory %s\n", request.currentDirectory.c_str());
+    }
+
+    process::MemoryContext context = process::MemoryContext(
+        FSUtil::GetDirectoryName(processContext->executablePath()) + "/" + request.name,
+        request.currentDirectory,
+        request.arguments,
+        request.environment,
+        processContext->userID(),
+        processContext->groupID(),
+        processContext->userName(),
+        processContext->groupName());
+    int exitCode = driver->run(&context, filesystem);
+
+    fflush(stdout);
+    fflush(stderr);
+    ::dup2(savedOutput, STDOUT_FILENO);
+    ::dup2(savedError, STDERR_FILENO);
+    ::close(savedOutput);
+    ::close(savedError);
+
+    if (savedDirectory >= 0) {
+        if (::fchdir(savedDirectory) != 0) {
+            fprintf(stderr, "warning: unable to restore working directory\n");
+        }
+        ::close(savedDirectory);
+    }
+
+    return exitCode;
+}
+
+bool Server::
+serve(
+    process::Context const *processContext,
+    Filesystem *filesystem,
+    std::string const &socketPath,
+    int idleTimeout)
+{
+    struct sockaddr_un address;
+    if (!SocketAddress(socketPath, &address)) {
+        fprintf(stderr, "error: socket path too long: %s\n", socketPath.c_str());
+        return false;
+    }
+
+    /* Others could replace the socket in a shared directory. */
+    if (!Ownership::IsPrivateDirectory(FSUtil::GetDirectoryName(socketPath))) {
+        fprintf(stderr, "error: socket directory is not private: %s\n", FSUtil::GetDirectoryName(socketPath).c_str());
+        return false;
+    }
+
+    int listener = SocketCreate();
+    if (listener < 0) {
+        fprintf(stderr, "error: unable to create socket: %s\n", strerror(errno));
+        return false;
+    }
+
+    /* Replace any socket left behind by an earlier server. */
+    ::unlink(socketPath.c_str());
+
+    if (::bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "error: unable to listen on %s: %s\n", socketPath.c_str(), strerror(errno));
+        ::close(listener);
+        return false;
+    }
+
+    bool stop = false;
+    while (!stop) {
+        struct pollfd descriptor = { .fd = listener, .events = POLLIN, .revents = 0 };
+        int ready = ::poll(&descriptor, 1, idleTimeout * 1000);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        } else if (ready <= 0) {
+            /* Idle for too long, or an error. */
+            break;
+        }
+
+        int connection = ::accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            continue;
+        }
+        ::fcntl(connection, F_SETFD, FD_CLOEXEC);
+
+        /* Anyone connecting could run tools as this user, so only serve the same user. */
+        if (!Ownership::SocketPeerIsUser(connection)) {
+            ::close(connection);
+            continue;
+        }
+
+        uint32_t version = 0;
+        uint32_t type = 0;
+        std::vector<int> descriptors;
+        if (ReadInteger(connection, &version) && version == ServerProtocolVersion && ReadDescriptors(connection, &type, &descriptors, 2)) {
+            if (type == kServerRequestStop) {
+                stop = true;
+                WriteInteger(connection, 0);
+            } else if (type == kServerRequestRun && descriptors.size() == 2) {
+                ServerRequest request;
+                if (ReadRequest(connection, &request)) {
+                    int exitCode = RunRequest(&_registry, processContext, filesystem, request, descriptors[0], descriptors[1]);
+                    WriteInteger(connection, static_cast<uint32_t>(exitCode));
+                }
+            }
+        }
+
+        for (int received : descriptors) {
+            ::close(received);
+        }
+        ::close(connection);
+    }
+
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    return true;
+}
+
+static int
+Connect(std::string const &socketPath)
+{
+    struct sockaddr_un address;
+    if (!SocketAddress(socketPath, &address)) {
+        return -1;
+    }
+
+    int fd = SocketCreate();
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || !Ownership::SocketPeerIsUser(fd)) {
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+ext::optional<int> Server::
+Run(process::Context const *processContext, std::string const &socketPath, std::string const &name)
+{
+    int fd = Connect(socketPath);
+    if (fd < 0) {
+        return ext::nullopt;
+    }
+
+    bool sent = WriteInteger(fd, ServerProtocolVersion);
+    sent = sent && WriteDescriptors(fd, kServerRequestRun, { STDOUT_FILENO, STDERR_FILENO });
+    sent = sent && WriteString(fd, name);
+    sent = sent && WriteString(fd, processContext->currentDirectory());
+
+    std::vector<std::string> const &arguments = processContext->commandLineArguments();
+    sent = sent && WriteInteger(fd, static_cast<uint32_t>(arguments.size()));
+    for (std::string const &argument : arguments) {
+        sent = sent && WriteString(fd, argument);
+    }
+
+    std::unordered_map<std::string, std::string> const &environment = processContext->environmentVariables();
+    sent = sent && WriteInteger(fd, static_cast<uint32_t>(environment.size()));
+    for (auto const &variable : environment) {
+        sent = sent && WriteString(fd, variable.first) && WriteString(fd, variable.second);
+    }
+
+    if (!sent) {
+        /* The server didn't take the request, so it didn't run. */
+        ::close(fd);
+        return ext::nullopt;
+    }
+
+    uint32_t exitCode;
+    if (!ReadInteger(fd, &exitCode)) {
+        /* The tool may have partly run, so running it again is unsafe. */
+        fprintf(stderr, "error: lost connection to builtin server running %s\n", name.c_str());
+        ::close(fd);
+        return 1;
+    }
+
+    ::close(fd);
+    return static_cast<int>(exitCode);
+}
+
+bool Server::
+Stop(std::string const &socketPath)
+{
+    int fd = Connect(socketPath);
+    if (fd < 0) {
+        return false;
+    }
+
+    uint32_t result;
+    bool stopped = WriteInteger(fd, ServerProtocolVersion) && WriteDescriptors(fd, kServerRequestStop, { }) && ReadInteger(fd, &result);
+
+    ::close(fd);
+    return stopped;
+}
+
+ext::optional<std::string> Server::
+SocketDirectory(process::Context const *processContext)
+{
+    /*
+     * Socket addresses are short, so use the temporary directory rather
+     * than somewhere under the build's intermediates.
+     */
+    std::string temporaryDirectory = processContext->environmentVariable("TMPDIR").value_or("/tmp");
+    std::string path = FSUtil::NormalizePath(temporaryDirectory + "/xcbuild-" + std::to_string(::geteuid()));
+
+    /* Someone else may have made it first; it's only used if private. */
+    if (!Ownership::CreatePrivateDirectory(path)) {
+        return ext::nullopt;
+    }
+
+    return path;
+}
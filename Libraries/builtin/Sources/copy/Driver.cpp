@@ -15,6 +15,7 @@
 #include <process/MemoryContext.h>
 #include <process/Launcher.h>
 
+#include <cstring>
 #include <unordered_set>
 
 using builtin::copy::Driver;
@@ -39,8 +40,157 @@ name()
     return "builtin-copy";
 }
 
+bool Driver::
+reentrant() const
+{
+    return true;
+}
+
+static bool
+FileUnchanged(Filesystem const *filesystem, Options const &options, std::string const &inputPath, std::string const &outputPath)
+{
+    if (filesystem->type(outputPath) != Filesystem::Type::File) {
+        return false;
+    }
+
+    ext::optional<Filesystem::Stamp> inputStamp = filesystem->readFileStamp(inputPath);
+    ext::optional<Filesystem::Stamp> outputStamp = filesystem->readFileStamp(outputPath);
+    if (inputStamp && outputStamp) {
+        if (*inputStamp == *outputStamp) {
+            return true;
+        } else if (inputStamp->size != outputStamp->size) {
+            return false;
+        }
+    }
+
+    if (!options.skipUnchangedContents()) {
+        return false;
+    }
+
+    std::unique_ptr<Filesystem::Mapping const> input = filesystem->map(inputPath);
+    std::unique_ptr<Filesystem::Mapping const> output = filesystem->map(outputPath);
+    if (input == nullptr || output == nullptr || input->size() != output->size()) {
+        return false;
+    }
+
+    return input->size() == 0 || ::memcmp(input->data(), output->data(), input->size()) == 0;
+}
+
+static bool
+SymbolicLinkUnchanged(Filesystem const *filesystem, std::string const &inputPath, std::string const &outputPath)
+{
+    if (filesystem->type(outputPath) != Filesystem::Type::SymbolicLink) {
+        return false;
+    }
+
+    return filesystem->readSymbolicLink(inputPath) == filesystem->readSymbolicLink(outputPath);
+}
+
+static bool
+RemovePath(Filesystem *filesystem, std::string const &path, Filesystem::Type type)
+{
+    switch (type) {
+        case Filesystem::Type::File:
+            return filesystem->removeFile(path);
+        case Filesystem::Type::SymbolicLink:
+            return filesystem->removeSymbolicLink(path);
+        case Filesystem::Type::Directory:
+            return filesystem->removeDirectory(path, true);
+    }
+
+    abort();
+}
+
+/*
+ * Bring a directory copy up to date: only entries that differ from the input
+ * are copied, and entries no longer in the input are removed. Unchanged files
+ * keep their modification times, so later build steps see them as unchanged.
+ */
+static bool
+UpdateDirectory(Filesystem *filesystem, Options const &options, std::string const &inputPath, std::string const &outputPath, Permissions::Operation operation, Permissions permissions)
+{
+    ext::optional<Filesystem::Type> outputType = filesystem->type(outputPath);
+    if (outputType && *outputType != Filesystem::Type::Directory) {
+        if (!RemovePath(filesystem, outputPath, *outputType)) {
+            return false;
+        }
+    }
+
+    if (!filesystem->createDirectory(outputPath, false) || !filesystem->writeDirectoryPermissions(outputPath, operation, permissions, false)) {
+        return false;
+    }
+
+    /*
+     * Remove outputs that aren't inputs, or are a different type. Contents
+     * are listed after their directories, so go in reverse to remove the
+     * contents first.
+     */
+    std::vector<std::pair<std::string, Filesystem::Type>> stale;
+    bool success = filesystem->readDirectory(outputPath, true, [&](std::string const &path, ext::optional<Filesystem::Type> type) {
+        if (type && filesystem->type(inputPath + "/" + path) != type) {
+            stale.push_back({ path, *type });
+        }
+    });
+    if (!success) {
+        return false;
+    }
+
+    for (auto it = stale.rbegin(); it != stale.rend(); ++it) {
+        /* Already removed with a directory that was removed. */
+        if (!filesystem->type(outputPath + "/" + it->first)) {
+            continue;
+        }
+
+        if (!RemovePath(filesystem, outputPath + "/" + it->first, it->second)) {
+            return false;
+        }
+    }
+
+    success &= filesystem->readDirectory(inputPath, true, [&](std::string const &path, ext::optional<Filesystem::Type> type) {
+        std::string input = inputPath + "/" + path;
+        std::string output = outputPath + "/" + path;
+
+        if (!type) {
+            success = false;
+            return;
+        }
+
+        switch (*type) {
+            case Filesystem::Type::File:
+                if (!FileUnchanged(filesystem, options, input, output)) {
+                    if (!filesystem->copyFile(input, output)) {
+                        success = false;
+                        return;
+                    }
+                }
+                if (!filesystem->writeFilePermissions(output, operation, permissions)) {
+                    success = false;
+                }
+                break;
+            case Filesystem::Type::SymbolicLink:
+                if (!SymbolicLinkUnchanged(filesystem, input, output)) {
+                    if (!filesystem->copySymbolicLink(input, output)) {
+                        success = false;
+                        return;
+                    }
+                }
+                if (!filesystem->writeSymbolicLinkPermissions(output, operation, permissions)) {
+                    success = false;
+                }
+                break;
+            case Filesystem::Type::Directory:
+                if (!filesystem->createDirectory(output, false) || !filesystem->writeDirectoryPermissions(output, operation, permissions, false)) {
+                    success = false;
+                }
+                break;
+        }
+    });
+
+    return success;
+}
+
 static bool
-CopyPath(Filesystem *filesystem, std::string const &inputPath, std::string const &outputPath)
+CopyPath(Filesystem *filesystem, Options const &options, std::string const &inputPath, std::string const &outputPath)
 {
     /* Must be writable once copied to allow subsequent builds to overwrite. */
     Permissions permissions;
@@ -55,7 +205,9 @@ CopyPath(Filesystem *filesystem, std::string const &inputPath, std::string const
 
     switch (*type) {
         case Filesystem::Type::File: {
-            if (!filesystem->copyFile(inputPath, outputPath)) {
+            if (options.skipUnchanged() && FileUnchanged(filesystem, options, inputPath, outputPath)) {
+                /* Already up to date. */
+            } else if (!filesystem->copyFile(inputPath, outputPath)) {
                 return false;
             }
 
@@ -66,7 +218,9 @@ CopyPath(Filesystem *filesystem, std::string const &inputPath, std::string const
             return true;
         }
         case Filesystem::Type::SymbolicLink: {
-            if (!filesystem->copySymbolicLink(inputPath, outputPath)) {
+            if (options.skipUnchanged() && SymbolicLinkUnchanged(filesystem, inputPath, outputPath)) {
+                /* Already up to date. */
+            } else if (!filesystem->copySymbolicLink(inputPath, outputPath)) {
                 return false;
             }
 
@@ -77,11 +231,11 @@ CopyPath(Filesystem *filesystem, std::string const &inputPath, std::string const
             return true;
         }
         case Filesystem::Type::Directory: {
-            if (!filesystem->copyDirectory(inputPath, outputPath, true)) {
-                return false;
+            if (options.skipUnchanged()) {
+                return UpdateDirectory(filesystem, options, inputPath, outputPath, operation, permissions);
             }
 
-            if (!filesystem->writeDirectoryPermissions(outputPath, operation, permissions, true)) {
+            if (!filesystem->copyDirectoryWithPermissions(inputPath, outputPath, operation, permissions)) {
                 return false;
             }
 
@@ -121,7 +275,32 @@ Run(Filesystem *filesystem, Options const &options, std::string const &workingDi
     auto excludes = std::unordered_set<std::string>(options.excludes().begin(), options.excludes().end());
 #endif
 
-    for (std::string input : options.inputs()) {
+    /*
+     * Inputs can also be listed in files, one per line.
+     */
+    std::vector<std::string> inputs = options.inputs();
+    for (std::string const &fileList : options.fileLists()) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, FSUtil::ResolveRelativePath(fileList, workingDirectory))) {
+            fprintf(stderr, "error: unable to read file list '%s'\n", fileList.c_str());
+            return 1;
+        }
+
+        std::string::size_type start = 0;
+        std::string list = std::string(contents.begin(), contents.end());
+        while (start < list.size()) {
+            std::string::size_type end = list.find('\n', start);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            if (end > start) {
+                inputs.push_back(list.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+    }
+
+    for (std::string input : inputs) {
         input = FSUtil::ResolveRelativePath(input, workingDirectory);
 
         if (options.resolveSrcSymlinks()) {
@@ -142,7 +321,7 @@ Run(Filesystem *filesystem, Options const &options, std::string const &workingDi
         }
 
         std::string outputPath = output + "/" + FSUtil::GetBaseName(input);
-        if (!CopyPath(filesystem, input, outputPath)) {
+        if (!CopyPath(filesystem, options, input, outputPath)) {
             return 1;
         }
     }
@@ -151,7 +330,7 @@ Run(Filesystem *filesystem, Options const &options, std::string const &workingDi
 }
 
 int Driver::
-run(process::Context const *processContext, libutil::Filesystem *filesystem)
+run(process::Context const *processContext, libutil::Filesystem *filesystem) const
 {
     Options options;
     std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
@@ -34,8 +34,14 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Current<bool>(&_ignoreMissingInputs, arg, it);
     } else if (arg == "-resolve-src-symlinks") {
         return libutil::Options::Current<bool>(&_resolveSrcSymlinks, arg, it);
+    } else if (arg == "-file-list") {
+        return libutil::Options::AppendNext<std::string>(&_fileLists, args, it);
     } else if (arg == "-exclude") {
         return libutil::Options::AppendNext<std::string>(&_excludes, args, it);
+    } else if (arg == "-skip-unchanged") {
+        return libutil::Options::Current<bool>(&_skipUnchanged, arg, it);
+    } else if (arg == "-skip-unchanged-contents") {
+        return libutil::Options::Current<bool>(&_skipUnchangedContents, arg, it);
     } else if (arg == "-strip-debug-symbols") {
         return libutil::Options::Current<bool>(&_stripDebugSymbols, arg, it);
     } else if (arg == "-strip-tool") {
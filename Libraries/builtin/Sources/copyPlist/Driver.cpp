@@ -14,11 +14,15 @@
 #include <libutil/Filesystem.h>
 #include <process/Context.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
 
 using builtin::copyPlist::Driver;
 using builtin::copyPlist::Options;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 Driver::
 Driver()
@@ -36,8 +40,94 @@ name()
     return "builtin-copyPlist";
 }
 
+bool Driver::
+reentrant() const
+{
+    return true;
+}
+
+/*
+ * One input to convert into one output.
+ */
+struct Conversion {
+    std::string          input;
+    std::string          outputPath;
+    std::vector<uint8_t> contents;
+    std::string          error;
+};
+
+/*
+ * If an input in one format can be copied as is when converting to another.
+ * ASCII is usually written by hand, so it is always rewritten in the usual
+ * layout, even when it stays ASCII.
+ */
+static bool
+SameFormat(plist::Format::Any const &input, plist::Format::Any const &output)
+{
+    if (input.type() != output.type()) {
+        return false;
+    }
+
+    switch (input.type()) {
+        case plist::Format::Type::Binary:
+            return true;
+        case plist::Format::Type::XML:
+            return input.format<plist::Format::XML>()->encoding() == output.format<plist::Format::XML>()->encoding();
+        case plist::Format::Type::ASCII:
+            return false;
+    }
+
+    abort();
+}
+
+static bool
+Convert(Conversion *conversion, plist::Format::Any const *convertFormat, bool validate)
+{
+    /*
+     * If we aren't converting or validating, don't even bother parsing as a plist.
+     */
+    if (convertFormat == nullptr && !validate) {
+        return true;
+    }
+
+    /* Determine the input format. */
+    std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(conversion->contents);
+    if (inputFormat == nullptr) {
+        conversion->error = "input " + conversion->input + " is not a plist";
+        return false;
+    }
+
+    /*
+     * Already in the requested format, so copy it as is. Identifying the
+     * format only looks at the start of the input, unlike parsing it.
+     */
+    if (!validate && SameFormat(*inputFormat, *convertFormat)) {
+        return true;
+    }
+
+    /* Deserialize the input. */
+    auto deserialize = plist::Format::Any::Deserialize(conversion->contents, *inputFormat);
+    if (!deserialize.first) {
+        conversion->error = conversion->input + ": " + deserialize.second;
+        return false;
+    }
+
+    /* Use the conversion format if specified, otherwise use the same as the input. */
+    plist::Format::Any outputFormat = (convertFormat != nullptr ? *convertFormat : *inputFormat);
+
+    /* Serialize the output. */
+    auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
+    if (serialize.first == nullptr) {
+        conversion->error = conversion->input + ": " + serialize.second;
+        return false;
+    }
+
+    conversion->contents = std::move(*serialize.first);
+    return true;
+}
+
 int Driver::
-run(process::Context const *processContext, libutil::Filesystem *filesystem)
+run(process::Context const *processContext, libutil::Filesystem *filesystem) const
 {
     Options options;
     std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
@@ -50,7 +140,7 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
      * It's unclear if an output directory should be required, but require it for
      * now since the behavior without one is also unclear.
      */
-    if (!options.outputDirectory()) {
+    if (!options.outputDirectory() && !options.inputs().empty()) {
         fprintf(stderr, "error: output directory not provided\n");
         return 1;
     }
@@ -58,7 +148,7 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     /*
      * Require at least one input.
      */
-    if (options.inputs().empty()) {
+    if (options.inputs().empty() && options.pairInputs().empty()) {
         fprintf(stderr, "error: no input files provided\n");
         return 1;
     }
@@ -87,57 +177,47 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     }
 
     /*
-     * Process each input.
+     * Inputs are written to the same name in the output directory.
      */
+    std::vector<Conversion> conversions;
     for (std::string const &inputPath : options.inputs()) {
-        /* Read in the input. */
-        std::vector<uint8_t> inputContents;
-        if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory()))) {
-            fprintf(stderr, "error: unable to read input %s\n", inputPath.c_str());
+        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
+        conversions.push_back({ inputPath, outputPath, { }, { } });
+    }
+    for (size_t n = 0; n < options.pairInputs().size(); n++) {
+        std::string outputPath = FSUtil::ResolveRelativePath(options.pairOutputs()[n], processContext->currentDirectory());
+        conversions.push_back({ options.pairInputs()[n], outputPath, { }, { } });
+    }
+
+    /*
+     * Read in each input.
+     */
+    for (Conversion &conversion : conversions) {
+        if (!filesystem->read(&conversion.contents, FSUtil::ResolveRelativePath(conversion.input, processContext->currentDirectory()))) {
+            fprintf(stderr, "error: unable to read input %s\n", conversion.input.c_str());
             return 1;
         }
+    }
 
-        std::vector<uint8_t> outputContents;
+    /*
+     * Convert inputs in parallel. Conversions are independent, and the
+     * filesystem is only used outside of them.
+     */
+    Parallel::For(Parallel::DefaultJobs(), conversions.size(), [&](size_t index) {
+        Convert(&conversions[index], convertFormat.get(), options.validate());
+    });
 
-        if (convertFormat == nullptr && !options.validate()) {
-            /*
-             * If we aren't converting or validating, don't even bother parsing as a plist.
-             */
-            outputContents = inputContents;
-        } else {
-            /* Determine the input format. */
-            std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
-            if (inputFormat == nullptr) {
-                fprintf(stderr, "error: input %s is not a plist\n", inputPath.c_str());
-                return 1;
-            }
-
-            /* Deserialize the input. */
-            auto deserialize = plist::Format::Any::Deserialize(inputContents, *inputFormat);
-            if (!deserialize.first) {
-                fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), deserialize.second.c_str());
-                return 1;
-            }
-
-            /* Use the conversion format if specified, otherwise use the same as the input. */
-            plist::Format::Any outputFormat = (convertFormat != nullptr ? *convertFormat : *inputFormat);
-
-            /* Serialize the output. */
-            auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
-            if (serialize.first == nullptr) {
-                fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), serialize.second.c_str());
-                return 1;
-            }
-
-            outputContents = *serialize.first;
+    /*
+     * Write out each output, stopping at the first input that failed.
+     */
+    for (Conversion const &conversion : conversions) {
+        if (!conversion.error.empty()) {
+            fprintf(stderr, "error: %s\n", conversion.error.c_str());
+            return 1;
         }
 
-        /* Output to the same name as the input, but in the output directory. */
-        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
-
-        /* Write out the output. */
-        if (!filesystem->write(outputContents, outputPath)) {
-            fprintf(stderr, "error: could not open output path %s to write\n", outputPath.c_str());
+        if (!filesystem->write(conversion.contents, conversion.outputPath)) {
+            fprintf(stderr, "error: could not open output path %s to write\n", conversion.outputPath.c_str());
             return 1;
         }
     }
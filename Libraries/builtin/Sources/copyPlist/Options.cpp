@@ -34,6 +34,12 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
             return libutil::Options::Next<std::string>(&_convertFormat, args, it);
         } else if (arg == "--outdir") {
             return libutil::Options::Next<std::string>(&_outputDirectory, args, it);
+        } else if (arg == "--pair") {
+            std::pair<bool, std::string> result = libutil::Options::AppendNext<std::string>(&_pairInputs, args, it);
+            if (!result.first) {
+                return result;
+            }
+            return libutil::Options::AppendNext<std::string>(&_pairOutputs, args, it);
         } else if (arg == "--") {
             _separator = true;
             return std::make_pair(true, std::string());
@@ -18,14 +18,18 @@
 #include <plist/Format/Encoding.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/Context.h>
 
+#include <algorithm>
+
 #include <strings.h>
 
 using builtin::copyStrings::Driver;
 using builtin::copyStrings::Options;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 Driver::
 Driver()
@@ -43,6 +47,12 @@ name()
     return "builtin-copyStrings";
 }
 
+bool Driver::
+reentrant() const
+{
+    return true;
+}
+
 static bool
 ParseStringsEncoding(std::string const &string, plist::Format::Any *format)
 {
@@ -87,6 +97,56 @@ ValidateStrings(plist::Object const *root)
     }
 }
 
+/*
+ * One input to convert into one output.
+ */
+struct Conversion {
+    std::string          input;
+    std::string          outputPath;
+    std::vector<uint8_t> contents;
+    std::string          error;
+};
+
+static bool
+Convert(Conversion *conversion, ext::optional<plist::Format::Any> const &inputFormatOverride, plist::Format::Any const &outputFormat, bool validate)
+{
+    /* Determine the input format. */
+    std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(conversion->contents);
+    if (inputFormat == nullptr) {
+        conversion->error = "input " + conversion->input + " is not a plist";
+        return false;
+    }
+
+    /* If no input format was specified, use the detected strings encoding. */
+    plist::Format::Any resolvedInputFormat = (inputFormatOverride ? *inputFormatOverride : *inputFormat);
+
+    /* Deserialize the input. */
+    auto deserialize = plist::Format::Any::Deserialize(conversion->contents, resolvedInputFormat);
+    if (!deserialize.first) {
+        conversion->error = conversion->input + ": " + deserialize.second;
+        return false;
+    }
+
+    /* If requested, validate the strings file is valid. */
+    if (validate) {
+        auto validation = ValidateStrings(deserialize.first.get());
+        if (!validation.first) {
+            conversion->error = conversion->input + ": " + validation.second;
+            return false;
+        }
+    }
+
+    /* Write out the output. */
+    auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
+    if (serialize.first == nullptr) {
+        conversion->error = conversion->input + ": " + serialize.second;
+        return false;
+    }
+
+    conversion->contents = std::move(*serialize.first);
+    return true;
+}
+
 static bool
 ValidateOptions(Options const &options)
 {
@@ -95,7 +155,7 @@ ValidateOptions(Options const &options)
      * It's unclear if an output directory should be required, but require it for
      * now since the behavior without one is also unclear.
      */
-    if (!options.outputDirectory()) {
+    if (!options.outputDirectory() && !options.inputs().empty()) {
         fprintf(stderr, "error: output directory not provided\n");
         return false;
     }
@@ -103,7 +163,7 @@ ValidateOptions(Options const &options)
     /*
      * Require at least one input.
      */
-    if (options.inputs().empty()) {
+    if (options.inputs().empty() && options.pairInputs().empty()) {
         fprintf(stderr, "error: no input files provided\n");
         return false;
     }
@@ -112,7 +172,7 @@ ValidateOptions(Options const &options)
 }
 
 int Driver::
-run(process::Context const *processContext, libutil::Filesystem *filesystem)
+run(process::Context const *processContext, libutil::Filesystem *filesystem) const
 {
     Options options;
     std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
@@ -138,59 +198,60 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     }
 
     /*
-     * Process each input.
+     * If no input format was specified, the detected strings encoding is used.
      */
-    for (std::string const &inputPath : options.inputs()) {
-        /* Read in the input. */
-        std::string resolvedInputPath = FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory());
-        std::vector<uint8_t> inputContents;
-        if (!filesystem->read(&inputContents, resolvedInputPath)) {
-            fprintf(stderr, "error: unable to read input %s\n", inputPath.c_str());
-            return 1;
-        }
-
-        /* Determine the input format. */
-        std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
-        if (inputFormat == nullptr) {
-            fprintf(stderr, "error: input %s is not a plist\n", inputPath.c_str());
-            return 1;
-        }
-
-        /* If no input format was specified, use the detected strings encoding. */
-        plist::Format::Any resolvedInputFormat = *inputFormat;
-        if (options.inputEncoding() && !ParseStringsEncoding(*options.inputEncoding(), &resolvedInputFormat)) {
+    ext::optional<plist::Format::Any> inputFormat;
+    if (options.inputEncoding()) {
+        plist::Format::Any format = plist::Format::Any::Create(plist::Format::Binary::Create());
+        if (!ParseStringsEncoding(*options.inputEncoding(), &format)) {
             fprintf(stderr, "error: invalid input encoding '%s'\n", options.inputEncoding()->c_str());
             return -1;
         }
+        inputFormat = format;
+    }
 
-        /* Deserialize the input. */
-        auto deserialize = plist::Format::Any::Deserialize(inputContents, resolvedInputFormat);
-        if (!deserialize.first) {
-            fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), deserialize.second.c_str());
-            return 1;
-        }
+    /*
+     * Inputs are written to the same name in the output directory.
+     */
+    std::vector<Conversion> conversions;
+    for (std::string const &inputPath : options.inputs()) {
+        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
+        conversions.push_back({ inputPath, outputPath, { }, { } });
+    }
+    for (size_t n = 0; n < options.pairInputs().size(); n++) {
+        std::string outputPath = FSUtil::ResolveRelativePath(options.pairOutputs()[n], processContext->currentDirectory());
+        conversions.push_back({ options.pairInputs()[n], outputPath, { }, { } });
+    }
 
-        /* If requested, validate the strings file is valid. */
-        if (options.validate()) {
-            auto validation = ValidateStrings(deserialize.first.get());
-            if (!validation.first) {
-                fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), validation.second.c_str());
-                return 1;
-            }
+    /*
+     * Read in each input.
+     */
+    for (Conversion &conversion : conversions) {
+        if (!filesystem->read(&conversion.contents, FSUtil::ResolveRelativePath(conversion.input, processContext->currentDirectory()))) {
+            fprintf(stderr, "error: unable to read input %s\n", conversion.input.c_str());
+            return 1;
         }
+    }
 
-        /* Output to the same name as the input, but in the output directory. */
-        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
+    /*
+     * Convert inputs in parallel. Conversions are independent, and the
+     * filesystem is only used outside of them.
+     */
+    Parallel::For(Parallel::DefaultJobs(), conversions.size(), [&](size_t index) {
+        Convert(&conversions[index], inputFormat, outputFormat, options.validate());
+    });
 
-        /* Write out the output. */
-        auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
-        if (serialize.first == nullptr) {
-            fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), serialize.second.c_str());
+    /*
+     * Write out each output, stopping at the first input that failed.
+     */
+    for (Conversion const &conversion : conversions) {
+        if (!conversion.error.empty()) {
+            fprintf(stderr, "error: %s\n", conversion.error.c_str());
             return 1;
         }
 
-        if (!filesystem->write(*serialize.first, outputPath)) {
-            fprintf(stderr, "error: %s: could not write output\n", inputPath.c_str());
+        if (!filesystem->write(conversion.contents, conversion.outputPath)) {
+            fprintf(stderr, "error: %s: could not write output\n", conversion.input.c_str());
             return 1;
         }
     }
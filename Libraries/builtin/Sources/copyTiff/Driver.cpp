@@ -10,11 +10,15 @@
 #include <builtin/copyTiff/Driver.h>
 #include <builtin/copyTiff/Options.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
 #include <process/Context.h>
 
+#include <unordered_set>
+
 using builtin::copyTiff::Driver;
 using builtin::copyTiff::Options;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 Driver::
 Driver()
@@ -32,8 +36,149 @@ name()
     return "builtin-copyTiff";
 }
 
+bool Driver::
+reentrant() const
+{
+    return true;
+}
+
+/*
+ * Reads parts of a TIFF file on demand, so large images are never loaded
+ * into memory all at once.
+ */
+class TIFFReader {
+private:
+    Filesystem const *_filesystem;
+    std::string       _path;
+    bool              _bigEndian;
+    bool              _bigTIFF;
+
+public:
+    TIFFReader(Filesystem const *filesystem, std::string const &path) :
+        _filesystem(filesystem),
+        _path      (path),
+        _bigEndian (false),
+        _bigTIFF   (false)
+    {
+    }
+
+private:
+    uint64_t value(std::vector<uint8_t> const &bytes, size_t offset, size_t size) const
+    {
+        uint64_t value = 0;
+        for (size_t n = 0; n < size; n++) {
+            size_t index = (_bigEndian ? n : size - n - 1);
+            value = (value << 8) | bytes[offset + index];
+        }
+        return value;
+    }
+
+    bool read(std::vector<uint8_t> *bytes, uint64_t offset, size_t size) const
+    {
+        return _filesystem->read(bytes, _path, static_cast<size_t>(offset), size) && bytes->size() == size;
+    }
+
+public:
+    /*
+     * Check the header and every image directory, returning the compression
+     * of each image. Strip data is not read.
+     */
+    std::pair<bool, std::string> validate(std::vector<uint64_t> *compressions)
+    {
+        std::vector<uint8_t> header;
+        if (!read(&header, 0, 8)) {
+            return std::make_pair(false, "not a TIFF file");
+        }
+
+        if (header[0] == 'I' && header[1] == 'I') {
+            _bigEndian = false;
+        } else if (header[0] == 'M' && header[1] == 'M') {
+            _bigEndian = true;
+        } else {
+            return std::make_pair(false, "not a TIFF file");
+        }
+
+        uint64_t version = value(header, 2, 2);
+        uint64_t offset;
+        if (version == 42) {
+            _bigTIFF = false;
+            offset = value(header, 4, 4);
+        } else if (version == 43) {
+            std::vector<uint8_t> bigHeader;
+            if (!read(&bigHeader, 0, 16) || value(bigHeader, 4, 2) != 8) {
+                return std::make_pair(false, "invalid BigTIFF header");
+            }
+            _bigTIFF = true;
+            offset = value(bigHeader, 8, 8);
+        } else {
+            return std::make_pair(false, "unknown TIFF version");
+        }
+
+        size_t countSize = (_bigTIFF ? 8 : 2);
+        size_t entrySize = (_bigTIFF ? 20 : 12);
+        size_t offsetSize = (_bigTIFF ? 8 : 4);
+
+        std::unordered_set<uint64_t> visited;
+        while (offset != 0) {
+            if (!visited.insert(offset).second) {
+                return std::make_pair(false, "image directories form a loop");
+            }
+
+            std::vector<uint8_t> count;
+            if (!read(&count, offset, countSize)) {
+                return std::make_pair(false, "image directory outside of file");
+            }
+
+            /* Read the whole directory, including the offset to the next one. */
+            uint64_t entries = value(count, 0, countSize);
+            if (entries > 0xFFFF) {
+                return std::make_pair(false, "too many image directory entries");
+            }
+
+            std::vector<uint8_t> directory;
+            if (!read(&directory, offset + countSize, entries * entrySize + offsetSize)) {
+                return std::make_pair(false, "truncated image directory");
+            }
+
+            /* Compression is a short; absent means uncompressed. */
+            uint64_t compression = 1;
+            for (uint64_t n = 0; n < entries; n++) {
+                size_t entry = n * entrySize;
+                if (value(directory, entry, 2) == 259) {
+                    compression = value(directory, entry + (_bigTIFF ? 12 : 8), 2);
+                }
+            }
+            compressions->push_back(compression);
+
+            offset = value(directory, entries * entrySize, offsetSize);
+        }
+
+        if (compressions->empty()) {
+            return std::make_pair(false, "no images");
+        }
+
+        return std::make_pair(true, std::string());
+    }
+};
+
+static ext::optional<uint64_t>
+CompressionValue(std::string const &format)
+{
+    if (format == "none") {
+        return 1;
+    } else if (format == "lzw") {
+        return 5;
+    } else if (format == "jpeg") {
+        return 7;
+    } else if (format == "packbits") {
+        return 32773;
+    } else {
+        return ext::nullopt;
+    }
+}
+
 int Driver::
-run(process::Context const *processContext, libutil::Filesystem *filesystem)
+run(process::Context const *processContext, libutil::Filesystem *filesystem) const
 {
     Options options;
     std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
@@ -42,7 +187,64 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
         return 1;
     }
 
-    // TODO(grp): Implement copy tiff builtin.
-    fprintf(stderr, "error: copy tiff not supported\n");
-    return 1;
+    if (!options.outputDirectory()) {
+        fprintf(stderr, "error: output directory not provided\n");
+        return 1;
+    }
+
+    if (options.inputs().empty()) {
+        fprintf(stderr, "error: no input files\n");
+        return 1;
+    }
+
+    ext::optional<uint64_t> compression;
+    if (options.compressionFormat()) {
+        compression = CompressionValue(*options.compressionFormat());
+        if (!compression) {
+            fprintf(stderr, "error: unknown compression format %s\n", options.compressionFormat()->c_str());
+            return 1;
+        }
+    }
+
+    std::string outputDirectory = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory());
+    if (!filesystem->createDirectory(outputDirectory, true)) {
+        fprintf(stderr, "error: unable to create output directory %s\n", outputDirectory.c_str());
+        return 1;
+    }
+
+    for (std::string const &input : options.inputs()) {
+        std::string inputPath = FSUtil::ResolveRelativePath(input, processContext->currentDirectory());
+        std::string outputPath = outputDirectory + "/" + FSUtil::GetBaseName(inputPath);
+
+        /*
+         * Only the header and image directories are needed to decide whether
+         * the file can be copied as-is, so read just those.
+         */
+        if (options.validate().value_or(false) || compression) {
+            std::vector<uint64_t> compressions;
+            auto validate = TIFFReader(filesystem, inputPath).validate(&compressions);
+            if (!validate.first) {
+                fprintf(stderr, "error: %s: %s\n", input.c_str(), validate.second.c_str());
+                return 1;
+            }
+
+            if (compression) {
+                for (uint64_t imageCompression : compressions) {
+                    if (imageCompression != *compression) {
+                        // TODO: Re-encode strips in the requested compression.
+                        fprintf(stderr, "warning: %s: recompressing as %s is not supported, copying unchanged\n", input.c_str(), options.compressionFormat()->c_str());
+                        break;
+                    }
+                }
+            }
+        }
+
+        /* Copy the image unchanged through the filesystem, without buffering it. */
+        if (!filesystem->copyFile(inputPath, outputPath)) {
+            fprintf(stderr, "error: unable to copy %s to %s\n", input.c_str(), outputPath.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
 }
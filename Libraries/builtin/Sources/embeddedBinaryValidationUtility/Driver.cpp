@@ -10,11 +10,16 @@
 #include <builtin/embeddedBinaryValidationUtility/Driver.h>
 #include <builtin/embeddedBinaryValidationUtility/Options.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
 #include <process/Context.h>
 
 using builtin::embeddedBinaryValidationUtility::Driver;
 using builtin::embeddedBinaryValidationUtility::Options;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 Driver::
 Driver()
@@ -32,8 +37,93 @@ name()
     return "builtin-embeddedBinaryValidationUtility";
 }
 
+bool Driver::
+reentrant() const
+{
+    return true;
+}
+
+static bool
+IsMachO(std::vector<uint8_t> const &header)
+{
+    uint32_t magic = (static_cast<uint32_t>(header[0]) << 24) |
+        (static_cast<uint32_t>(header[1]) << 16) |
+        (static_cast<uint32_t>(header[2]) << 8) |
+        static_cast<uint32_t>(header[3]);
+
+    switch (magic) {
+        case 0xfeedface: case 0xcefaedfe: /* 32-bit */
+        case 0xfeedfacf: case 0xcffaedfe: /* 64-bit */
+        case 0xcafebabe: case 0xbebafeca: /* universal */
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::vector<std::string> Driver::
+Validate(Filesystem const *filesystem, std::string const &bundle, ext::optional<std::string> const &parentIdentifier)
+{
+    std::vector<std::string> errors;
+
+    /*
+     * Bundles for macOS keep their contents in a subdirectory; other
+     * platforms use a flat bundle. Frameworks keep the Info.plist in
+     * their resources.
+     */
+    std::string infoPlistPath;
+    std::string executableDirectory;
+    if (filesystem->isReadable(bundle + "/Contents/Info.plist")) {
+        infoPlistPath = bundle + "/Contents/Info.plist";
+        executableDirectory = bundle + "/Contents/MacOS";
+    } else if (filesystem->isReadable(bundle + "/Resources/Info.plist")) {
+        infoPlistPath = bundle + "/Resources/Info.plist";
+        executableDirectory = bundle;
+    } else if (filesystem->isReadable(bundle + "/Info.plist")) {
+        infoPlistPath = bundle + "/Info.plist";
+        executableDirectory = bundle;
+    } else {
+        errors.push_back(bundle + ": missing Info.plist");
+        return errors;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, infoPlistPath)) {
+        errors.push_back(infoPlistPath + ": unable to read");
+        return errors;
+    }
+
+    auto deserialize = plist::Format::Any::Deserialize(contents);
+    plist::Dictionary const *info = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    if (info == nullptr) {
+        errors.push_back(infoPlistPath + ": not a dictionary plist");
+        return errors;
+    }
+
+    plist::String const *identifier = info->value<plist::String>("CFBundleIdentifier");
+    if (identifier == nullptr || identifier->value().empty()) {
+        errors.push_back(infoPlistPath + ": missing CFBundleIdentifier");
+    } else if (parentIdentifier && identifier->value().compare(0, parentIdentifier->size() + 1, *parentIdentifier + ".") != 0) {
+        errors.push_back(bundle + ": bundle identifier " + identifier->value() + " is not prefixed by the containing bundle identifier " + *parentIdentifier);
+    }
+
+    /* Only the magic number is needed to check the executable. */
+    if (plist::String const *executable = info->value<plist::String>("CFBundleExecutable")) {
+        std::string executablePath = executableDirectory + "/" + executable->value();
+
+        std::vector<uint8_t> header;
+        if (!filesystem->read(&header, executablePath, 0, 4)) {
+            errors.push_back(executablePath + ": missing or unreadable executable");
+        } else if (!IsMachO(header)) {
+            errors.push_back(executablePath + ": executable is not a Mach-O binary");
+        }
+    }
+
+    return errors;
+}
+
 int Driver::
-run(process::Context const *processContext, libutil::Filesystem *filesystem)
+run(process::Context const *processContext, libutil::Filesystem *filesystem) const
 {
     Options options;
     std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
@@ -42,7 +132,41 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
         return 1;
     }
 
-    // TODO(grp): Implement embedded binary validation builtin.
-    fprintf(stderr, "error: embedded binary validation not supported\n");
-    return 1;
+    if (!options.input()) {
+        fprintf(stderr, "error: no input specified\n");
+        return 1;
+    }
+
+    /*
+     * The containing product's Info.plist provides the identifier the
+     * embedded bundle's identifier must start with.
+     */
+    ext::optional<std::string> parentIdentifier;
+    if (options.inputPlistPath()) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, FSUtil::ResolveRelativePath(*options.inputPlistPath(), processContext->currentDirectory()))) {
+            fprintf(stderr, "error: unable to read %s\n", options.inputPlistPath()->c_str());
+            return 1;
+        }
+
+        auto deserialize = plist::Format::Any::Deserialize(contents);
+        plist::Dictionary const *info = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+        if (info == nullptr) {
+            fprintf(stderr, "error: %s is not a dictionary plist\n", options.inputPlistPath()->c_str());
+            return 1;
+        }
+
+        if (plist::String const *identifier = info->value<plist::String>("CFBundleIdentifier")) {
+            parentIdentifier = identifier->value();
+        }
+    }
+
+    // TODO: Check the embedded binary is signed with the signing certificate.
+
+    std::vector<std::string> errors = Validate(filesystem, FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory()), parentIdentifier);
+    for (std::string const &error : errors) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+    }
+
+    return (errors.empty() ? 0 : 1);
 }
@@ -25,6 +25,9 @@
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 #include <process/Context.h>
+#include <libutil/md5.h>
+
+#include <algorithm>
 
 using builtin::infoPlistUtility::Driver;
 using builtin::infoPlistUtility::Options;
@@ -47,8 +50,14 @@ name()
     return "builtin-infoPlistUtility";
 }
 
-static std::pair<bool, std::string>
-WritePkgInfo(Filesystem *filesystem, plist::Dictionary const *root, std::string const &path)
+bool Driver::
+reentrant() const
+{
+    return true;
+}
+
+static std::vector<uint8_t>
+PkgInfoContents(plist::Dictionary const *root)
 {
     std::string pkgInfo;
 
@@ -66,12 +75,71 @@ WritePkgInfo(Filesystem *filesystem, plist::Dictionary const *root, std::string
         pkgInfo += "????";
     }
 
-    auto pkgInfoContents = std::vector<uint8_t>(pkgInfo.begin(), pkgInfo.end());
-    if (!filesystem->write(pkgInfoContents, path)) {
-        return std::make_pair(false, "could write to " + path);
+    return std::vector<uint8_t>(pkgInfo.begin(), pkgInfo.end());
+}
+
+static bool
+WriteIfChanged(Filesystem *filesystem, std::vector<uint8_t> const &contents, std::string const &path)
+{
+    /*
+     * Leave outputs that would not change alone: a newer modification time
+     * would make code signing and packaging run again.
+     */
+    if (filesystem->isReadable(path)) {
+        std::vector<uint8_t> existing;
+        if (filesystem->read(&existing, path) && existing == contents) {
+            return true;
+        }
     }
 
-    return std::make_pair(true, std::string());
+    return filesystem->write(contents, path);
+}
+
+static void
+DigestAppend(md5_state_t *state, uint8_t const *data, size_t size)
+{
+    /* Prefix with the size so adjacent parts can't run together. */
+    uint64_t length = size;
+    md5_append(state, reinterpret_cast<md5_byte_t const *>(&length), sizeof(length));
+    md5_append(state, reinterpret_cast<md5_byte_t const *>(data), size);
+}
+
+static void
+DigestAppend(md5_state_t *state, std::string const &string)
+{
+    DigestAppend(state, reinterpret_cast<uint8_t const *>(string.data()), string.size());
+}
+
+static std::string
+InputsDigest(
+    process::Context const *processContext,
+    std::vector<uint8_t> const &inputContents,
+    std::vector<std::vector<uint8_t>> const &additionalContents)
+{
+    md5_state_t state;
+    md5_init(&state);
+
+    for (std::string const &argument : processContext->commandLineArguments()) {
+        DigestAppend(&state, argument);
+    }
+
+    DigestAppend(&state, inputContents.data(), inputContents.size());
+    for (std::vector<uint8_t> const &contents : additionalContents) {
+        DigestAppend(&state, contents.data(), contents.size());
+    }
+
+    /* Any build setting can be expanded, so include them all, in a stable order. */
+    std::unordered_map<std::string, std::string> const &environmentVariables = processContext->environmentVariables();
+    std::vector<std::pair<std::string, std::string>> environment = std::vector<std::pair<std::string, std::string>>(environmentVariables.begin(), environmentVariables.end());
+    std::sort(environment.begin(), environment.end());
+    for (std::pair<std::string, std::string> const &pair : environment) {
+        DigestAppend(&state, pair.first);
+        DigestAppend(&state, pair.second);
+    }
+
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+    return std::string(reinterpret_cast<char const *>(digest), sizeof(digest));
 }
 
 static void
@@ -154,54 +222,32 @@ CreateBuildEnvironment(std::unordered_map<std::string, std::string> const &envir
     return settingsEnvironment;
 }
 
-int Driver::
-run(process::Context const *processContext, libutil::Filesystem *filesystem)
+static bool
+Generate(
+    Options const &options,
+    pbxsetting::Environment const &settingsEnvironment,
+    std::vector<uint8_t> const &inputContents,
+    std::vector<std::vector<uint8_t>> const &additionalContents,
+    Driver::Generated *generated)
 {
-    Options options;
-    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
-    if (!result.first) {
-        fprintf(stderr, "error: %s\n", result.second.c_str());
-        return 1;
-    }
-
-    /* Validate options. */
-    if (!options.input()) {
-        fprintf(stderr, "error: no input file specified\n");
-        return 1;
-    }
-
-    if (!options.output()) {
-        fprintf(stderr, "error: no output file specified\n");
-        return 1;
-    }
-
-    pbxsetting::Environment settingsEnvironment = CreateBuildEnvironment(processContext->environmentVariables());
-
-    /* Read in the input. */
-    std::vector<uint8_t> inputContents;
-    if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory()))) {
-        fprintf(stderr, "error: unable to read input %s\n", options.input()->c_str());
-        return 1;
-    }
-
     /* Determine the input format. */
     std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
     if (inputFormat == nullptr) {
         fprintf(stderr, "error: input %s is not a plist\n", options.input()->c_str());
-        return 1;
+        return false;
     }
 
     /* Deserialize the input. */
     auto deserialize = plist::Format::Any::Deserialize(inputContents, *inputFormat);
     if (!deserialize.first) {
         fprintf(stderr, "error: %s: %s\n", options.input()->c_str(), deserialize.second.c_str());
-        return 1;
+        return false;
     }
 
     plist::Dictionary *root = plist::CastTo<plist::Dictionary>(deserialize.first.get());
     if (root == nullptr) {
         fprintf(stderr, "error: info plist root is not a dictionary\n");
-        return 1;
+        return false;
     }
 
     /*
@@ -216,20 +262,16 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
      * Process additional content files. These are plists that get merged with the
      * main Info.plist at the top level.
      */
-    for (std::string const &additionalContentFile : options.additionalContentFiles()) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, FSUtil::ResolveRelativePath(additionalContentFile, processContext->currentDirectory()))) {
-            fprintf(stderr, "error: unable to read additional content file: %s\n", additionalContentFile.c_str());
-            return 1;
-        }
+    for (size_t n = 0; n < additionalContents.size(); n++) {
+        std::string const &additionalContentFile = options.additionalContentFiles()[n];
 
-        auto additionalContent = plist::Format::Any::Deserialize(contents);
-        if (additionalContent.first == nullptr) {
-            fprintf(stderr, "error: unable to parse additional content file %s: %s\n", additionalContentFile.c_str(), additionalContent.second.c_str());
-            return 1;
+        auto deserialize = plist::Format::Any::Deserialize(additionalContents[n]);
+        if (deserialize.first == nullptr) {
+            fprintf(stderr, "error: unable to parse additional content file %s: %s\n", additionalContentFile.c_str(), deserialize.second.c_str());
+            return false;
         }
 
-        if (plist::Dictionary *dictionary = plist::CastTo<plist::Dictionary>(additionalContent.first.get())) {
+        if (plist::Dictionary const *dictionary = plist::CastTo<plist::Dictionary>(deserialize.first.get())) {
             /* Pass true to replace existing entries. */
             root->merge(dictionary, true);
         }
@@ -259,34 +301,9 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     AddBuildEnvironment(root, settingsEnvironment);
 
     /*
-     * Write the PkgInfo file. This is just the package type and signature.
+     * The PkgInfo file is just the package type and signature.
      */
-    if (options.genPkgInfo()) {
-        auto result = WritePkgInfo(filesystem, root, FSUtil::ResolveRelativePath(*options.genPkgInfo(), processContext->currentDirectory()));
-        if (!result.first) {
-            fprintf(stderr, "error: %s\n", result.second.c_str());
-            return 1;
-        }
-    }
-
-    /*
-     * Copy the resource rules file. This is used by code signing.
-     */
-    if (options.resourceRulesFile()) {
-        std::string resourceRulesInputPath = settingsEnvironment.resolve("CODE_SIGN_RESOURCE_RULES_PATH");
-        if (!resourceRulesInputPath.empty()) {
-            std::vector<uint8_t> contents;
-            if (!filesystem->read(&contents, FSUtil::ResolveRelativePath(resourceRulesInputPath, processContext->currentDirectory()))) {
-                fprintf(stderr, "error: unable to read input %s\n", resourceRulesInputPath.c_str());
-                return 1;
-            }
-
-            if (!filesystem->write(contents, FSUtil::ResolveRelativePath(*options.resourceRulesFile(), processContext->currentDirectory()))) {
-                fprintf(stderr, "error: could not open output path %s to write\n", options.resourceRulesFile()->c_str());
-                return 1;
-            }
-        }
-    }
+    generated->pkgInfo = PkgInfoContents(root);
 
     /*
      * Determine the output format. By default, use the same as the input format.
@@ -301,7 +318,7 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
             outputFormat = plist::Format::Any::Create(plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8));
         } else {
             fprintf(stderr, "error: unknown output format %s\n", options.format()->c_str());
-            return 1;
+            return false;
         }
     }
 
@@ -309,11 +326,110 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     auto serialize = plist::Format::Any::Serialize(root, outputFormat);
     if (serialize.first == nullptr) {
         fprintf(stderr, "error: %s\n", serialize.second.c_str());
+        return false;
+    }
+
+    generated->output = std::move(*serialize.first);
+    return true;
+}
+
+int Driver::
+run(process::Context const *processContext, libutil::Filesystem *filesystem) const
+{
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
+    if (!result.first) {
+        fprintf(stderr, "error: %s\n", result.second.c_str());
         return 1;
     }
 
+    /* Validate options. */
+    if (!options.input()) {
+        fprintf(stderr, "error: no input file specified\n");
+        return 1;
+    }
+
+    if (!options.output()) {
+        fprintf(stderr, "error: no output file specified\n");
+        return 1;
+    }
+
+    pbxsetting::Environment settingsEnvironment = CreateBuildEnvironment(processContext->environmentVariables());
+
+    /* Read in the input. */
+    std::vector<uint8_t> inputContents;
+    if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory()))) {
+        fprintf(stderr, "error: unable to read input %s\n", options.input()->c_str());
+        return 1;
+    }
+
+    /* Read in the additional content files. */
+    std::vector<std::vector<uint8_t>> additionalContents;
+    for (std::string const &additionalContentFile : options.additionalContentFiles()) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, FSUtil::ResolveRelativePath(additionalContentFile, processContext->currentDirectory()))) {
+            fprintf(stderr, "error: unable to read additional content file: %s\n", additionalContentFile.c_str());
+            return 1;
+        }
+
+        additionalContents.push_back(std::move(contents));
+    }
+
+    /*
+     * Generate the output, unless the same inputs were already processed.
+     */
+    std::string digest = InputsDigest(processContext, inputContents, additionalContents);
+
+    Generated generated;
+    bool cached;
+    {
+        std::lock_guard<std::mutex> lock(_generatedMutex);
+        auto it = _generated.find(digest);
+        if ((cached = (it != _generated.end()))) {
+            generated = it->second;
+        }
+    }
+
+    if (!cached) {
+        if (!Generate(options, settingsEnvironment, inputContents, additionalContents, &generated)) {
+            return 1;
+        }
+
+        std::lock_guard<std::mutex> lock(_generatedMutex);
+        _generated.insert({ digest, generated });
+    }
+
+    /*
+     * Write the PkgInfo file.
+     */
+    if (options.genPkgInfo()) {
+        if (!WriteIfChanged(filesystem, generated.pkgInfo, FSUtil::ResolveRelativePath(*options.genPkgInfo(), processContext->currentDirectory()))) {
+            fprintf(stderr, "error: could write to %s\n", options.genPkgInfo()->c_str());
+            return 1;
+        }
+    }
+
+    /*
+     * Copy the resource rules file. This is used by code signing.
+     */
+    if (options.resourceRulesFile()) {
+        std::string resourceRulesInputPath = settingsEnvironment.resolve("CODE_SIGN_RESOURCE_RULES_PATH");
+        if (!resourceRulesInputPath.empty()) {
+            std::vector<uint8_t> contents;
+            if (!filesystem->read(&contents, FSUtil::ResolveRelativePath(resourceRulesInputPath, processContext->currentDirectory()))) {
+                fprintf(stderr, "error: unable to read input %s\n", resourceRulesInputPath.c_str());
+                return 1;
+            }
+
+            if (!WriteIfChanged(filesystem, contents, FSUtil::ResolveRelativePath(*options.resourceRulesFile(), processContext->currentDirectory()))) {
+                fprintf(stderr, "error: could not open output path %s to write\n", options.resourceRulesFile()->c_str());
+                return 1;
+            }
+        }
+    }
+
     /* Write out the output. */
-    if (!filesystem->write(*serialize.first, FSUtil::ResolveRelativePath(*options.output(), processContext->currentDirectory()))) {
+    if (!WriteIfChanged(filesystem, generated.output, FSUtil::ResolveRelativePath(*options.output(), processContext->currentDirectory()))) {
         fprintf(stderr, "error: could not open output path %s to write\n", options.output()->c_str());
         return 1;
     }
@@ -9,12 +9,22 @@
 
 #include <builtin/validationUtility/Driver.h>
 #include <builtin/validationUtility/Options.h>
+#include <builtin/embeddedBinaryValidationUtility/Driver.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
 #include <process/Context.h>
 
+#include <algorithm>
+
 using builtin::validationUtility::Driver;
 using builtin::validationUtility::Options;
 using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Parallel;
 
 Driver::
 Driver()
@@ -32,8 +42,48 @@ name()
     return "builtin-validationUtility";
 }
 
+bool Driver::
+reentrant() const
+{
+    return true;
+}
+
+static void
+FindEmbeddedBundles(Filesystem const *filesystem, std::string const &product, std::vector<std::string> *bundles)
+{
+    /*
+     * Embedded bundles live in a few known directories, both in flat bundles
+     * and in the contents directory of macOS bundles.
+     */
+    static std::vector<std::pair<std::string, std::string>> const locations = {
+        { "PlugIns", "appex" },
+        { "Frameworks", "framework" },
+        { "Watch", "app" },
+        { "Contents/PlugIns", "appex" },
+        { "Contents/Frameworks", "framework" },
+    };
+
+    for (std::pair<std::string, std::string> const &location : locations) {
+        std::string directory = product + "/" + location.first;
+        if (filesystem->type(directory) != Filesystem::Type::Directory) {
+            continue;
+        }
+
+        std::vector<std::string> found;
+        filesystem->readDirectory(directory, false, [&](std::string const &name) {
+            if (FSUtil::GetFileExtension(name) == location.second) {
+                found.push_back(directory + "/" + name);
+            }
+        });
+
+        /* Directory order is not stable; keep errors in a stable order. */
+        std::sort(found.begin(), found.end());
+        bundles->insert(bundles->end(), found.begin(), found.end());
+    }
+}
+
 int Driver::
-run(process::Context const *processContext, libutil::Filesystem *filesystem)
+run(process::Context const *processContext, libutil::Filesystem *filesystem) const
 {
     Options options;
     std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
@@ -42,7 +92,58 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
         return 1;
     }
 
-    // TODO(grp): Implement validation builtin.
-    fprintf(stderr, "error: validation not supported\n");
-    return 1;
+    if (!options.input()) {
+        fprintf(stderr, "error: no input specified\n");
+        return 1;
+    }
+
+    std::string product = FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory());
+
+    /* Validate the product itself. */
+    std::vector<std::string> errors = builtin::embeddedBinaryValidationUtility::Driver::Validate(filesystem, product, ext::nullopt);
+    if (!errors.empty()) {
+        for (std::string const &error : errors) {
+            fprintf(stderr, "error: %s\n", error.c_str());
+        }
+        return 1;
+    }
+
+    /* Find the identifier embedded bundles must be prefixed with. */
+    ext::optional<std::string> identifier;
+    for (std::string const &path : { product + "/Contents/Info.plist", product + "/Info.plist" }) {
+        std::vector<uint8_t> contents;
+        if (filesystem->read(&contents, path)) {
+            auto deserialize = plist::Format::Any::Deserialize(contents);
+            if (plist::Dictionary const *info = plist::CastTo<plist::Dictionary>(deserialize.first.get())) {
+                if (plist::String const *value = info->value<plist::String>("CFBundleIdentifier")) {
+                    identifier = value->value();
+                }
+            }
+            break;
+        }
+    }
+
+    /*
+     * Each embedded bundle is checked independently, and only reads its
+     * Info.plist and the start of its executable, so check them at once.
+     */
+    std::vector<std::string> bundles;
+    FindEmbeddedBundles(filesystem, product, &bundles);
+
+    std::vector<std::vector<std::string>> bundleErrors = std::vector<std::vector<std::string>>(bundles.size());
+    Parallel::For(Parallel::DefaultJobs(), bundles.size(), [&](size_t n) {
+        bundleErrors[n] = builtin::embeddedBinaryValidationUtility::Driver::Validate(filesystem, bundles[n], identifier);
+    });
+
+    // TODO: Check additional requirements with -validate-for-store.
+
+    bool valid = true;
+    for (std::vector<std::string> const &errors : bundleErrors) {
+        for (std::string const &error : errors) {
+            fprintf(stderr, "error: %s\n", error.c_str());
+            valid = false;
+        }
+    }
+
+    return (valid ? 0 : 1);
 }
@@ -0,0 +1,185 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/Driver.h>
+#include <builtin/Registry.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+
+#include <thread>
+
+using builtin::Driver;
+using builtin::Registry;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static size_t const Runs = 16;
+
+/*
+ * Run a driver many times at once on one filesystem, each with the
+ * arguments for its index. Returns the exit code of each run.
+ */
+static std::vector<int>
+RunConcurrently(std::shared_ptr<Driver> const &driver, Filesystem *filesystem, std::function<std::vector<std::string>(size_t)> const &arguments)
+{
+    std::vector<int> results = std::vector<int>(Runs, -1);
+
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < Runs; n++) {
+        threads.emplace_back([&driver, filesystem, &arguments, &results, n] {
+            process::MemoryContext context = process::MemoryContext(
+                driver->name(),
+                "/",
+                arguments(n),
+                std::unordered_map<std::string, std::string>(),
+                0,
+                0,
+                "root",
+                "wheel");
+            results[n] = driver->run(&context, filesystem);
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return results;
+}
+
+static std::string
+PlistValue(Filesystem const *filesystem, std::string const &path, std::string const &key)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return std::string();
+    }
+
+    auto deserialize = plist::Format::Any::Deserialize(contents);
+    plist::Dictionary const *dictionary = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    if (dictionary == nullptr) {
+        return std::string();
+    }
+
+    plist::String const *value = dictionary->value<plist::String>(key);
+    return (value != nullptr ? value->value() : std::string());
+}
+
+TEST(Registry, ReentrantDrivers)
+{
+    Registry registry = Registry::Default();
+    for (std::string const &name : { "builtin-copy", "builtin-copyPlist", "builtin-copyStrings", "builtin-infoPlistUtility" }) {
+        std::shared_ptr<Driver> driver = registry.driver(name);
+        ASSERT_NE(driver, nullptr);
+        EXPECT_TRUE(driver->reentrant()) << name;
+    }
+}
+
+TEST(Registry, ConcurrentCopy)
+{
+    std::vector<MemoryFilesystem::Entry> inputs;
+    for (size_t n = 0; n < Runs; n++) {
+        inputs.push_back(MemoryFilesystem::Entry::Directory("input" + std::to_string(n), {
+            MemoryFilesystem::Entry::File("file", Contents(std::to_string(n))),
+            MemoryFilesystem::Entry::Directory("directory", {
+                MemoryFilesystem::Entry::File("nested", Contents("nested" + std::to_string(n))),
+            }),
+        }));
+    }
+    MemoryFilesystem filesystem = MemoryFilesystem(inputs);
+
+    std::vector<int> results = RunConcurrently(Registry::Default().driver("builtin-copy"), &filesystem, [](size_t n) {
+        return std::vector<std::string>({ "input" + std::to_string(n), "output" });
+    });
+
+    for (size_t n = 0; n < Runs; n++) {
+        EXPECT_EQ(0, results[n]);
+
+        std::vector<uint8_t> contents;
+        EXPECT_TRUE(filesystem.read(&contents, "/output/input" + std::to_string(n) + "/file"));
+        EXPECT_EQ(contents, Contents(std::to_string(n)));
+        EXPECT_TRUE(filesystem.read(&contents, "/output/input" + std::to_string(n) + "/directory/nested"));
+        EXPECT_EQ(contents, Contents("nested" + std::to_string(n)));
+    }
+}
+
+TEST(Registry, ConcurrentCopyPlist)
+{
+    std::vector<MemoryFilesystem::Entry> inputs = { MemoryFilesystem::Entry::Directory("output", { }) };
+    for (size_t n = 0; n < Runs; n++) {
+        inputs.push_back(MemoryFilesystem::Entry::File("in" + std::to_string(n) + ".plist", Contents("{ key = \"" + std::to_string(n) + "\"; }")));
+    }
+    MemoryFilesystem filesystem = MemoryFilesystem(inputs);
+
+    std::vector<int> results = RunConcurrently(Registry::Default().driver("builtin-copyPlist"), &filesystem, [](size_t n) {
+        return std::vector<std::string>({ "--convert", "xml1", "--outdir", "output", "in" + std::to_string(n) + ".plist" });
+    });
+
+    for (size_t n = 0; n < Runs; n++) {
+        EXPECT_EQ(0, results[n]);
+        EXPECT_EQ(PlistValue(&filesystem, "/output/in" + std::to_string(n) + ".plist", "key"), std::to_string(n));
+    }
+}
+
+TEST(Registry, ConcurrentCopyStrings)
+{
+    std::vector<MemoryFilesystem::Entry> inputs = { MemoryFilesystem::Entry::Directory("output", { }) };
+    for (size_t n = 0; n < Runs; n++) {
+        inputs.push_back(MemoryFilesystem::Entry::File("in" + std::to_string(n) + ".strings", Contents("key = \"" + std::to_string(n) + "\";")));
+    }
+    MemoryFilesystem filesystem = MemoryFilesystem(inputs);
+
+    std::vector<int> results = RunConcurrently(Registry::Default().driver("builtin-copyStrings"), &filesystem, [](size_t n) {
+        return std::vector<std::string>({ "--validate", "--outputencoding", "utf-8", "--outdir", "output", "in" + std::to_string(n) + ".strings" });
+    });
+
+    for (size_t n = 0; n < Runs; n++) {
+        EXPECT_EQ(0, results[n]);
+
+        std::vector<uint8_t> contents;
+        EXPECT_TRUE(filesystem.read(&contents, "/output/in" + std::to_string(n) + ".strings"));
+        EXPECT_EQ(contents, Contents("key = " + std::to_string(n) + ";\n"));
+    }
+}
+
+TEST(Registry, ConcurrentInfoPlistUtility)
+{
+    std::vector<MemoryFilesystem::Entry> inputs = {
+        MemoryFilesystem::Entry::File("additional.plist", Contents("{ shared = \"shared\"; }")),
+        MemoryFilesystem::Entry::Directory("output", { }),
+    };
+    for (size_t n = 0; n < Runs; n++) {
+        inputs.push_back(MemoryFilesystem::Entry::File("Info" + std::to_string(n) + ".plist", Contents("{ key = \"" + std::to_string(n) + "\"; }")));
+    }
+    MemoryFilesystem filesystem = MemoryFilesystem(inputs);
+
+    std::vector<int> results = RunConcurrently(Registry::Default().driver("builtin-infoPlistUtility"), &filesystem, [](size_t n) {
+        return std::vector<std::string>({
+            "Info" + std::to_string(n) + ".plist",
+            "-additionalcontentfile", "additional.plist",
+            "-format", "xml",
+            "-o", "output/Info" + std::to_string(n) + ".plist",
+        });
+    });
+
+    for (size_t n = 0; n < Runs; n++) {
+        EXPECT_EQ(0, results[n]);
+        EXPECT_EQ(PlistValue(&filesystem, "/output/Info" + std::to_string(n) + ".plist", "key"), std::to_string(n));
+        EXPECT_EQ(PlistValue(&filesystem, "/output/Info" + std::to_string(n) + ".plist", "shared"), "shared");
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/Server.h>
+#include <builtin/Driver.h>
+#include <builtin/Registry.h>
+#include <libutil/Filesystem.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/Context.h>
+#include <process/MemoryContext.h>
+
+#include <cstdlib>
+#include <thread>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using builtin::Driver;
+using builtin::Registry;
+using builtin::Server;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+class WriteDriver : public Driver {
+public:
+    virtual std::string name()
+    { return "builtin-write"; }
+
+public:
+    virtual int run(process::Context const *processContext, Filesystem *filesystem) const
+    {
+        std::vector<std::string> const &arguments = processContext->commandLineArguments();
+        if (arguments.size() != 2) {
+            return 2;
+        }
+
+        std::vector<uint8_t> contents = std::vector<uint8_t>(arguments[1].begin(), arguments[1].end());
+        return filesystem->write(contents, arguments[0]) ? 0 : 1;
+    }
+};
+
+static process::MemoryContext
+Process(std::vector<std::string> const &arguments)
+{
+    return process::MemoryContext(
+        "/usr/bin/builtin-client",
+        "/",
+        arguments,
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+}
+
+TEST(Server, Run)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    char directoryTemplate[] = "/tmp/xcbuild-test-server-XXXXXX";
+    ASSERT_NE(nullptr, ::mkdtemp(directoryTemplate));
+    std::string socketPath = std::string(directoryTemplate) + "/server.sock";
+
+    /* Nothing listening yet. */
+    auto unavailable = Process({ "/written", "contents" });
+    EXPECT_FALSE(Server::Run(&unavailable, socketPath, "builtin-write"));
+
+    Server server = Server(Registry::Create({ std::make_shared<WriteDriver>() }));
+    auto serverProcess = Process({ });
+    std::thread thread = std::thread([&] {
+        EXPECT_TRUE(server.serve(&serverProcess, &filesystem, socketPath, 60));
+    });
+
+    /* Wait for the server to start listening. */
+    auto process = Process({ "/written", "contents" });
+    ext::optional<int> exitCode;
+    for (int n = 0; n < 1000 && !exitCode; ++n) {
+        exitCode = Server::Run(&process, socketPath, "builtin-write");
+        if (!exitCode) {
+            ::usleep(1000);
+        }
+    }
+    ASSERT_TRUE(exitCode);
+    EXPECT_EQ(0, *exitCode);
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/written"));
+    EXPECT_EQ(std::string("contents"), std::string(contents.begin(), contents.end()));
+
+    /* Exit codes from the tool are returned. */
+    auto invalid = Process({ "/written" });
+    EXPECT_EQ(ext::optional<int>(2), Server::Run(&invalid, socketPath, "builtin-write"));
+
+    /* Unknown tools fail. */
+    EXPECT_EQ(ext::optional<int>(1), Server::Run(&process, socketPath, "builtin-unknown"));
+
+    EXPECT_TRUE(Server::Stop(socketPath));
+    thread.join();
+
+    EXPECT_FALSE(Server::Run(&process, socketPath, "builtin-write"));
+    ::rmdir(directoryTemplate);
+}
+
+TEST(Server, SharedDirectory)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    char directoryTemplate[] = "/tmp/xcbuild-test-server-XXXXXX";
+    ASSERT_NE(nullptr, ::mkdtemp(directoryTemplate));
+    ASSERT_EQ(0, ::chmod(directoryTemplate, 0777));
+
+    /* Others could replace the socket, so don't listen there. */
+    Server server = Server(Registry::Create({ std::make_shared<WriteDriver>() }));
+    auto serverProcess = Process({ });
+    EXPECT_FALSE(server.serve(&serverProcess, &filesystem, std::string(directoryTemplate) + "/server.sock", 60));
+
+    ::rmdir(directoryTemplate);
+}
+
+TEST(Server, SocketDirectory)
+{
+    char directoryTemplate[] = "/tmp/xcbuild-test-server-XXXXXX";
+    ASSERT_NE(nullptr, ::mkdtemp(directoryTemplate));
+
+    process::MemoryContext process = process::MemoryContext(
+        "/usr/bin/builtin-client",
+        "/",
+        { },
+        { { "TMPDIR", directoryTemplate } },
+        0,
+        0,
+        "root",
+        "wheel");
+
+    ext::optional<std::string> socketDirectory = Server::SocketDirectory(&process);
+    ASSERT_TRUE(socketDirectory);
+    EXPECT_EQ(0u, socketDirectory->find(directoryTemplate));
+
+    struct stat status;
+    ASSERT_EQ(0, ::lstat(socketDirectory->c_str(), &status));
+    EXPECT_EQ(static_cast<mode_t>(0700), status.st_mode & 0777);
+
+    /* Not used once others can get in. */
+    ASSERT_EQ(0, ::chmod(socketDirectory->c_str(), 0755));
+    EXPECT_FALSE(Server::SocketDirectory(&process));
+
+    ::rmdir(socketDirectory->c_str());
+    ::rmdir(directoryTemplate);
+}
@@ -113,3 +113,91 @@ TEST(copy, IgnoreMissingOutput)
     EXPECT_EQ(0, driver.run(&succeed, &filesystem));
 }
 
+
+TEST(copy, FileList)
+{
+    std::vector<uint8_t> contents;
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("in1", Contents("one")),
+        MemoryFilesystem::Entry::File("in2", Contents("two")),
+        MemoryFilesystem::Entry::File("in3", Contents("three")),
+        MemoryFilesystem::Entry::File("list", Contents("in2\nin3\n")),
+        MemoryFilesystem::Entry::Directory("output", { }),
+    });
+
+    Driver driver;
+    auto process = Process(driver.name(), { "in1", "-file-list", "list", "output", });
+    EXPECT_EQ(0, driver.run(&process, &filesystem));
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/in1"));
+    EXPECT_EQ(contents, Contents("one"));
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/in2"));
+    EXPECT_EQ(contents, Contents("two"));
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/in3"));
+    EXPECT_EQ(contents, Contents("three"));
+
+    /* Missing file lists should fail. */
+    auto missing = Process(driver.name(), { "-file-list", "missing", "output", });
+    EXPECT_NE(0, driver.run(&missing, &filesystem));
+}
+
+TEST(copy, SkipUnchanged)
+{
+    std::vector<uint8_t> contents;
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file", Contents("file")),
+        MemoryFilesystem::Entry::Directory("input", {
+            MemoryFilesystem::Entry::File("same", Contents("same")),
+            MemoryFilesystem::Entry::File("changed", Contents("new")),
+            MemoryFilesystem::Entry::Directory("sub", {
+                MemoryFilesystem::Entry::File("added", Contents("added")),
+            }),
+        }),
+        MemoryFilesystem::Entry::Directory("output", {
+            MemoryFilesystem::Entry::File("file", Contents("file")),
+            MemoryFilesystem::Entry::Directory("input", {
+                MemoryFilesystem::Entry::File("same", Contents("same")),
+                MemoryFilesystem::Entry::File("changed", Contents("old")),
+                MemoryFilesystem::Entry::File("sub", Contents("not a directory")),
+                MemoryFilesystem::Entry::Directory("removed", {
+                    MemoryFilesystem::Entry::File("stale", Contents("stale")),
+                }),
+            }),
+        }),
+    });
+
+    /* The inputs are newer than the outputs, so only contents can match. */
+    Filesystem::Stamp older = Filesystem::Stamp({ 0, 1 });
+    filesystem.setStamp(older);
+    for (std::string const &input : { "/file", "/input/same", "/input/changed", "/input/sub/added" }) {
+        EXPECT_TRUE(filesystem.setStamp(input, Filesystem::Stamp({ 0, 2 })));
+    }
+
+    /* Copied files have new stamps. */
+    Driver driver;
+    auto process = Process(driver.name(), { "-skip-unchanged-contents", "file", "input", "output", });
+    EXPECT_EQ(0, driver.run(&process, &filesystem));
+    EXPECT_EQ(filesystem.readFileStamp("/output/file"), older);
+    EXPECT_EQ(filesystem.readFileStamp("/output/input/same"), older);
+    EXPECT_NE(filesystem.readFileStamp("/output/input/changed"), older);
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/input/changed"));
+    EXPECT_EQ(contents, Contents("new"));
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/input/sub/added"));
+    EXPECT_EQ(contents, Contents("added"));
+
+    EXPECT_FALSE(filesystem.exists("/output/input/removed"));
+
+    /* Without comparing contents, nothing is known to match. */
+    auto stamps = Process(driver.name(), { "-skip-unchanged", "file", "output", });
+    EXPECT_EQ(0, driver.run(&stamps, &filesystem));
+    EXPECT_NE(filesystem.readFileStamp("/output/file"), older);
+}
@@ -85,3 +85,79 @@ TEST(copyPlist, CopyMultiple)
     EXPECT_EQ(contents, Contents("{\n\tin3 = three;\n}\n"));
 }
 
+
+TEST(copyPlist, Pairs)
+{
+    std::vector<uint8_t> contents;
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("in1.plist", Contents("{ in1 = \"one\"; }")),
+        MemoryFilesystem::Entry::File("in2.plist", Contents("{ in2 = \"two\"; }")),
+        MemoryFilesystem::Entry::Directory("output", { }),
+        MemoryFilesystem::Entry::Directory("other", { }),
+    });
+
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        {
+            "--convert", "ascii1",
+            "--outdir", "output",
+            "in1.plist",
+            "--pair", "in2.plist", "other/renamed.plist",
+        },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    EXPECT_EQ(0, driver.run(&processContext, &filesystem));
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/in1.plist"));
+    EXPECT_EQ(contents, Contents("{\n\tin1 = one;\n}\n"));
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/other/renamed.plist"));
+    EXPECT_EQ(contents, Contents("{\n\tin2 = two;\n}\n"));
+}
+
+TEST(copyPlist, SameFormat)
+{
+    /* Not how the XML format would write it, so copying keeps it as is. */
+    std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<plist version=\"1.0\"><dict><key>in</key><string>one</string></dict></plist>\n";
+
+    std::vector<uint8_t> contents;
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("in1.plist", Contents(xml)),
+        MemoryFilesystem::Entry::File("in2.plist", Contents("{ in2 = \"two\"; }")),
+        MemoryFilesystem::Entry::Directory("output", { }),
+    });
+
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        {
+            "in1.plist",
+            "in2.plist",
+            "--outdir", "output",
+            "--convert", "xml1",
+        },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    EXPECT_EQ(0, driver.run(&processContext, &filesystem));
+
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/in1.plist"));
+    EXPECT_EQ(contents, Contents(xml));
+
+    /* Other formats are still converted. */
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/output/in2.plist"));
+    EXPECT_NE(contents, Contents("{ in2 = \"two\"; }"));
+    EXPECT_EQ(contents.front(), '<');
+}
@@ -113,3 +113,73 @@ TEST(copyStrings, InputOutputEncoding)
     }
 }
 
+
+TEST(copyStrings, Pairs)
+{
+    std::vector<MemoryFilesystem::Entry> languages;
+    std::vector<std::string> arguments = { "--outputencoding", "utf-8" };
+    for (size_t n = 0; n < 40; n++) {
+        std::string language = "language" + std::to_string(n);
+        languages.push_back(MemoryFilesystem::Entry::Directory(language + ".lproj", {
+            MemoryFilesystem::Entry::File("Localizable.strings", Contents("string = \"" + language + "\";")),
+        }));
+        arguments.push_back("--pair");
+        arguments.push_back(language + ".lproj/Localizable.strings");
+        arguments.push_back("output/" + language + ".lproj/Localizable.strings");
+    }
+
+    std::vector<MemoryFilesystem::Entry> outputs;
+    for (size_t n = 0; n < 40; n++) {
+        outputs.push_back(MemoryFilesystem::Entry::Directory("language" + std::to_string(n) + ".lproj", { }));
+    }
+    languages.push_back(MemoryFilesystem::Entry::Directory("output", outputs));
+    MemoryFilesystem filesystem = MemoryFilesystem(languages);
+
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        arguments,
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    EXPECT_EQ(0, driver.run(&processContext, &filesystem));
+
+    for (size_t n = 0; n < 40; n++) {
+        std::string language = "language" + std::to_string(n);
+
+        std::vector<uint8_t> contents;
+        EXPECT_TRUE(filesystem.read(&contents, "/output/" + language + ".lproj/Localizable.strings"));
+        EXPECT_EQ(contents, Contents("string = " + language + ";\n"));
+    }
+}
+
+TEST(copyStrings, PairsInvalid)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("valid.strings", Contents("string = value;")),
+        MemoryFilesystem::Entry::File("invalid.strings", Contents("string = (value);")),
+        MemoryFilesystem::Entry::Directory("output", { }),
+    });
+
+    /* Outputs before the first invalid input are still written. */
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        {
+            "--validate",
+            "--pair", "valid.strings", "output/valid.strings",
+            "--pair", "invalid.strings", "output/invalid.strings",
+        },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    EXPECT_NE(0, driver.run(&processContext, &filesystem));
+    EXPECT_TRUE(filesystem.exists("/output/valid.strings"));
+    EXPECT_FALSE(filesystem.exists("/output/invalid.strings"));
+}
@@ -0,0 +1,110 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/copyTiff/Driver.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+
+using builtin::copyTiff::Driver;
+using libutil::MemoryFilesystem;
+
+static process::MemoryContext
+Process(std::vector<std::string> const &arguments)
+{
+    return process::MemoryContext(
+        "builtin-copyTiff",
+        "/",
+        arguments,
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+}
+
+/*
+ * A little-endian TIFF with one 1x1 image in one strip, with the
+ * given compression.
+ */
+static std::vector<uint8_t>
+TIFF(uint16_t compression)
+{
+    uint8_t c0 = static_cast<uint8_t>(compression & 0xFF);
+    uint8_t c1 = static_cast<uint8_t>(compression >> 8);
+
+    return std::vector<uint8_t>({
+        'I', 'I', 42, 0, 8, 0, 0, 0,
+        /* Directory: 5 entries. */
+        5, 0,
+        0x00, 0x01, 3, 0, 1, 0, 0, 0, 1, 0, 0, 0,  /* ImageWidth */
+        0x01, 0x01, 3, 0, 1, 0, 0, 0, 1, 0, 0, 0,  /* ImageLength */
+        0x03, 0x01, 3, 0, 1, 0, 0, 0, c0, c1, 0, 0, /* Compression */
+        0x11, 0x01, 4, 0, 1, 0, 0, 0, 74, 0, 0, 0, /* StripOffsets */
+        0x17, 0x01, 4, 0, 1, 0, 0, 0, 1, 0, 0, 0,  /* StripByteCounts */
+        0, 0, 0, 0,
+        /* Strip data. */
+        0xFF,
+    });
+}
+
+TEST(copyTiff, Copy)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("image.tiff", TIFF(1)),
+    });
+
+    Driver driver;
+    process::MemoryContext context = Process({ "--validate", "--outdir", "output", "image.tiff" });
+    EXPECT_EQ(0, driver.run(&context, &filesystem));
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/output/image.tiff"));
+    EXPECT_EQ(contents, TIFF(1));
+}
+
+TEST(copyTiff, Compression)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("image.tiff", TIFF(5)),
+    });
+
+    Driver driver;
+    process::MemoryContext lzw = Process({ "--compression", "lzw", "--outdir", "output", "image.tiff" });
+    EXPECT_EQ(0, driver.run(&lzw, &filesystem));
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/output/image.tiff"));
+    EXPECT_EQ(contents, TIFF(5));
+
+    process::MemoryContext unknown = Process({ "--compression", "unknown", "--outdir", "output", "image.tiff" });
+    EXPECT_NE(0, driver.run(&unknown, &filesystem));
+}
+
+TEST(copyTiff, Invalid)
+{
+    std::vector<uint8_t> truncated = TIFF(1);
+    truncated.resize(20);
+
+    std::vector<uint8_t> loop = TIFF(1);
+    loop[70] = 8;
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("text.tiff", std::vector<uint8_t>({ 'n', 'o', 't', ' ', 't', 'i', 'f', 'f' })),
+        MemoryFilesystem::Entry::File("truncated.tiff", truncated),
+        MemoryFilesystem::Entry::File("loop.tiff", loop),
+    });
+
+    Driver driver;
+    for (std::string const &input : { "text.tiff", "truncated.tiff", "loop.tiff" }) {
+        process::MemoryContext context = Process({ "--validate", "--outdir", "output", input });
+        EXPECT_NE(0, driver.run(&context, &filesystem)) << input;
+        EXPECT_FALSE(filesystem.exists("/output/" + input)) << input;
+    }
+}
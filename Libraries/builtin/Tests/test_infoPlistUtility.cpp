@@ -0,0 +1,119 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/infoPlistUtility/Driver.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+
+using builtin::infoPlistUtility::Driver;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static process::MemoryContext
+Process(std::vector<std::string> const &arguments, std::unordered_map<std::string, std::string> const &environment)
+{
+    return process::MemoryContext(
+        "builtin-infoPlistUtility",
+        "/",
+        arguments,
+        environment,
+        0,
+        0,
+        "root",
+        "wheel");
+}
+
+static std::string
+OutputValue(MemoryFilesystem const *filesystem, std::string const &key)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, "/Info.out.plist")) {
+        return std::string();
+    }
+
+    auto deserialize = plist::Format::Any::Deserialize(contents);
+    plist::Dictionary const *dictionary = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    plist::String const *value = (dictionary != nullptr ? dictionary->value<plist::String>(key) : nullptr);
+    return (value != nullptr ? value->value() : std::string());
+}
+
+TEST(infoPlistUtility, SkipUnchanged)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("Info.plist", Contents("{ CFBundleIdentifier = \"$(IDENTIFIER)\"; CFBundlePackageType = APPL; }")),
+        MemoryFilesystem::Entry::File("additional.plist", Contents("{ Additional = first; }")),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+    std::vector<std::string> arguments = {
+        "Info.plist",
+        "-expandbuildsettings",
+        "-additionalcontentfile", "additional.plist",
+        "-genpkginfo", "PkgInfo",
+        "-format", "xml",
+        "-o", "Info.out.plist",
+    };
+    std::unordered_map<std::string, std::string> environment = { { "IDENTIFIER", "com.example.first" } };
+
+    Driver driver;
+
+    /* The first run writes both outputs. Written files get new stamps. */
+    process::MemoryContext first = Process(arguments, environment);
+    EXPECT_EQ(0, driver.run(&first, &filesystem));
+    ext::optional<Filesystem::Stamp> pkgInfoStamp = filesystem.readFileStamp("/PkgInfo");
+    ext::optional<Filesystem::Stamp> infoStamp = filesystem.readFileStamp("/Info.out.plist");
+    ASSERT_TRUE(pkgInfoStamp);
+    ASSERT_TRUE(infoStamp);
+    EXPECT_EQ(OutputValue(&filesystem, "CFBundleIdentifier"), "com.example.first");
+    EXPECT_EQ(OutputValue(&filesystem, "Additional"), "first");
+
+    std::vector<uint8_t> pkgInfo;
+    EXPECT_TRUE(filesystem.read(&pkgInfo, "/PkgInfo"));
+    EXPECT_EQ(pkgInfo, Contents("APPL????"));
+
+    /* Running again with the same inputs writes nothing. */
+    process::MemoryContext second = Process(arguments, environment);
+    EXPECT_EQ(0, driver.run(&second, &filesystem));
+    EXPECT_EQ(filesystem.readFileStamp("/PkgInfo"), pkgInfoStamp);
+    EXPECT_EQ(filesystem.readFileStamp("/Info.out.plist"), infoStamp);
+
+    /* A changed build setting changes only the Info.plist. */
+    environment["IDENTIFIER"] = "com.example.second";
+    process::MemoryContext third = Process(arguments, environment);
+    EXPECT_EQ(0, driver.run(&third, &filesystem));
+    EXPECT_EQ(filesystem.readFileStamp("/PkgInfo"), pkgInfoStamp);
+    EXPECT_NE(filesystem.readFileStamp("/Info.out.plist"), infoStamp);
+    infoStamp = filesystem.readFileStamp("/Info.out.plist");
+    EXPECT_EQ(OutputValue(&filesystem, "CFBundleIdentifier"), "com.example.second");
+
+    /* A changed additional content file is merged again. */
+    EXPECT_TRUE(filesystem.write(Contents("{ Additional = second; }"), "/additional.plist"));
+    process::MemoryContext fourth = Process(arguments, environment);
+    EXPECT_EQ(0, driver.run(&fourth, &filesystem));
+    EXPECT_EQ(filesystem.readFileStamp("/PkgInfo"), pkgInfoStamp);
+    EXPECT_NE(filesystem.readFileStamp("/Info.out.plist"), infoStamp);
+    EXPECT_EQ(OutputValue(&filesystem, "Additional"), "second");
+
+    /* A removed output is written again, even for cached inputs. */
+    EXPECT_TRUE(filesystem.removeFile("/Info.out.plist"));
+    process::MemoryContext fifth = Process(arguments, environment);
+    EXPECT_EQ(0, driver.run(&fifth, &filesystem));
+    EXPECT_EQ(filesystem.readFileStamp("/PkgInfo"), pkgInfoStamp);
+    EXPECT_TRUE(filesystem.readFileStamp("/Info.out.plist"));
+    EXPECT_EQ(OutputValue(&filesystem, "Additional"), "second");
+}
@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/validationUtility/Driver.h>
+#include <builtin/embeddedBinaryValidationUtility/Driver.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static process::MemoryContext
+Process(std::string const &executable, std::vector<std::string> const &arguments)
+{
+    return process::MemoryContext(
+        executable,
+        "/",
+        arguments,
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+}
+
+static MemoryFilesystem::Entry
+Bundle(std::string const &name, std::string const &identifier, std::vector<uint8_t> const &executable)
+{
+    return MemoryFilesystem::Entry::Directory(name, {
+        MemoryFilesystem::Entry::File("Info.plist", Contents("{ CFBundleIdentifier = \"" + identifier + "\"; CFBundleExecutable = Executable; }")),
+        MemoryFilesystem::Entry::File("Executable", executable),
+    });
+}
+
+static std::vector<uint8_t> const MachO = { 0xcf, 0xfa, 0xed, 0xfe, 0x07, 0x00, 0x00, 0x01 };
+
+TEST(validationUtility, EmbeddedBundles)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("App.app", {
+            MemoryFilesystem::Entry::File("Info.plist", Contents("{ CFBundleIdentifier = com.example.app; CFBundleExecutable = App; }")),
+            MemoryFilesystem::Entry::File("App", MachO),
+            MemoryFilesystem::Entry::Directory("PlugIns", {
+                Bundle("First.appex", "com.example.app.first", MachO),
+                Bundle("Second.appex", "com.example.app.second", MachO),
+            }),
+            MemoryFilesystem::Entry::Directory("Frameworks", {
+                Bundle("Framework.framework", "com.example.app.framework", MachO),
+            }),
+        }),
+    });
+
+    builtin::validationUtility::Driver driver;
+    process::MemoryContext context = Process(driver.name(), { "App.app" });
+    EXPECT_EQ(0, driver.run(&context, &filesystem));
+
+    /* Identifiers must be prefixed by the app, and executables must be Mach-O. */
+    EXPECT_TRUE(filesystem.write(Contents("{ CFBundleIdentifier = com.other; CFBundleExecutable = Executable; }"), "/App.app/PlugIns/First.appex/Info.plist"));
+    EXPECT_NE(0, driver.run(&context, &filesystem));
+    EXPECT_EQ(1, builtin::embeddedBinaryValidationUtility::Driver::Validate(&filesystem, "/App.app/PlugIns/First.appex", std::string("com.example.app")).size());
+
+    EXPECT_TRUE(filesystem.write(Contents("{ CFBundleIdentifier = com.example.app.first; CFBundleExecutable = Executable; }"), "/App.app/PlugIns/First.appex/Info.plist"));
+    EXPECT_TRUE(filesystem.write(Contents("text"), "/App.app/Frameworks/Framework.framework/Executable"));
+    EXPECT_NE(0, driver.run(&context, &filesystem));
+
+    EXPECT_TRUE(filesystem.write(MachO, "/App.app/Frameworks/Framework.framework/Executable"));
+    EXPECT_EQ(0, driver.run(&context, &filesystem));
+}
+
+TEST(embeddedBinaryValidationUtility, Validate)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("App.app", {
+            MemoryFilesystem::Entry::File("Info.plist", Contents("{ CFBundleIdentifier = com.example.app; }")),
+            MemoryFilesystem::Entry::Directory("PlugIns", {
+                Bundle("Valid.appex", "com.example.app.valid", MachO),
+                Bundle("Prefix.appex", "com.example.application", MachO),
+                MemoryFilesystem::Entry::Directory("Missing.appex", { }),
+            }),
+        }),
+    });
+
+    builtin::embeddedBinaryValidationUtility::Driver driver;
+
+    process::MemoryContext valid = Process(driver.name(), { "-info-plist-path", "App.app/Info.plist", "App.app/PlugIns/Valid.appex" });
+    EXPECT_EQ(0, driver.run(&valid, &filesystem));
+
+    process::MemoryContext prefix = Process(driver.name(), { "-info-plist-path", "App.app/Info.plist", "App.app/PlugIns/Prefix.appex" });
+    EXPECT_NE(0, driver.run(&prefix, &filesystem));
+
+    process::MemoryContext missing = Process(driver.name(), { "-info-plist-path", "App.app/Info.plist", "App.app/PlugIns/Missing.appex" });
+    EXPECT_NE(0, driver.run(&missing, &filesystem));
+}
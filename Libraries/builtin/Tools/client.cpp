@@ -0,0 +1,60 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/Server.h>
+#include <libutil/FSUtil.h>
+#include <process/DefaultContext.h>
+#include <process/MemoryContext.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+
+using libutil::FSUtil;
+
+int
+main(int argc, char **argv, char **envp)
+{
+    process::DefaultContext defaultContext = process::DefaultContext();
+
+    std::vector<std::string> const &arguments = defaultContext.commandLineArguments();
+    if (arguments.size() < 2) {
+        fprintf(stderr, "usage: builtin-client socket builtin [arguments...]\n");
+        return 1;
+    }
+
+    std::string const &socketPath = arguments[0];
+    std::string const &name = arguments[1];
+
+    /*
+     * Run the builtin as if it was launched directly with the remaining arguments.
+     */
+    process::MemoryContext processContext = process::MemoryContext(&defaultContext);
+    processContext.commandLineArguments() = std::vector<std::string>(arguments.begin() + 2, arguments.end());
+
+    if (ext::optional<int> exitCode = builtin::Server::Run(&processContext, socketPath, name)) {
+        return *exitCode;
+    }
+
+    /*
+     * No server is available. Run the builtin tool, installed alongside this one.
+     */
+    std::string path = FSUtil::GetDirectoryName(defaultContext.executablePath()) + "/" + name;
+    std::vector<char *> toolArguments = { const_cast<char *>(path.c_str()) };
+    for (std::string const &argument : processContext.commandLineArguments()) {
+        toolArguments.push_back(const_cast<char *>(argument.c_str()));
+    }
+    toolArguments.push_back(nullptr);
+
+    ::execve(path.c_str(), toolArguments.data(), envp);
+    fprintf(stderr, "error: unable to run %s: %s\n", path.c_str(), strerror(errno));
+    return 1;
+}
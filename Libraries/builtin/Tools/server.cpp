@@ -0,0 +1,38 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/Server.h>
+#include <builtin/Registry.h>
+#include <libutil/DefaultFilesystem.h>
+#include <process/DefaultContext.h>
+
+#include <csignal>
+#include <cstdio>
+
+using libutil::DefaultFilesystem;
+
+int
+main(int argc, char **argv, char **envp)
+{
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    process::DefaultContext processContext = process::DefaultContext();
+
+    std::vector<std::string> const &arguments = processContext.commandLineArguments();
+    if (arguments.size() != 1) {
+        fprintf(stderr, "usage: builtin-server socket\n");
+        return 1;
+    }
+
+    /* Clients going away shouldn't stop the server. */
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Stop if not used for a while. Clients run tools themselves without a server. */
+    builtin::Server server = builtin::Server(builtin::Registry::Default());
+    return server.serve(&processContext, &filesystem, arguments.front(), 10 * 60) ? 0 : 1;
+}
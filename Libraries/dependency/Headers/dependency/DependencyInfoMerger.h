@@ -0,0 +1,71 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __dependency_DependencyInfoMerger_h
+#define __dependency_DependencyInfoMerger_h
+
+#include <dependency/DependencyInfo.h>
+#include <dependency/DependencyInfoFormat.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+
+namespace dependency {
+
+/*
+ * Merges the inputs from several dependency info into one list for an
+ * output. Inputs are made absolute, and each input is only kept once, in
+ * the order it was first added.
+ */
+class DependencyInfoMerger {
+private:
+    std::string                      _currentDirectory;
+    std::unordered_set<std::string>  _seen;
+    std::vector<std::string const *> _inputs;
+
+public:
+    explicit DependencyInfoMerger(std::string const &currentDirectory);
+
+public:
+    /*
+     * The merged inputs. Owned by the merger.
+     */
+    std::vector<std::string const *> const &inputs() const
+    { return _inputs; }
+
+public:
+    /*
+     * Add an input, if not already added.
+     */
+    void add(std::string const &input);
+
+    /*
+     * Add the inputs from dependency info.
+     */
+    void add(DependencyInfo const &dependencyInfo);
+
+    /*
+     * Add the inputs from a dependency info file or directory. Fails if
+     * it can't be read or is invalid.
+     */
+    bool add(libutil::Filesystem const *filesystem, DependencyInfoFormat format, std::string const &path);
+
+public:
+    /*
+     * Serialize the merged inputs as Makefile dependency info for an output.
+     */
+    std::string serializeMakefile(std::string const &output) const;
+};
+
+}
+
+#endif /* __dependency_DependencyInfoMerger_h */
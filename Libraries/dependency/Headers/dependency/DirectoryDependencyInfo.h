@@ -21,6 +21,8 @@ namespace libutil { class Filesystem; }
 
 namespace dependency {
 
+class DirectoryManifest;
+
 /*
  * Dependency info created from the contents of a directory.
  */
@@ -57,6 +59,13 @@ public:
     static ext::optional<DirectoryDependencyInfo>
     Deserialize(libutil::Filesystem const *filesystem, std::string const &directory);
 
+    /*
+     * Create dependency info for a directory, only reading directories
+     * that changed since they were recorded in the manifest.
+     */
+    static ext::optional<DirectoryDependencyInfo>
+    Deserialize(libutil::Filesystem const *filesystem, std::string const &directory, DirectoryManifest *manifest);
+
 public:
     /*
      * The dependency info format.
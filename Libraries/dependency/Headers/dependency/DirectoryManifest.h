@@ -0,0 +1,68 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __dependency_DirectoryManifest_h
+#define __dependency_DirectoryManifest_h
+
+#include <libutil/Filesystem.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dependency {
+
+/*
+ * Remembers the entries of directories along with the directory stamps,
+ * so a directory is only read again once entries are added or removed.
+ * Can be saved between builds.
+ */
+class DirectoryManifest {
+public:
+    /*
+     * An entry in a directory: its name, and if it is a directory.
+     */
+    typedef std::pair<std::string, bool> Entry;
+
+private:
+    struct Directory {
+        libutil::Filesystem::Stamp stamp;
+        std::vector<Entry>         entries;
+    };
+
+private:
+    std::unordered_map<std::string, Directory> _directories;
+    bool                                       _modified;
+
+public:
+    DirectoryManifest();
+
+public:
+    /*
+     * The entries of a directory, read only if it changed since last read.
+     * Fails if the directory can't be read.
+     */
+    bool entries(libutil::Filesystem const *filesystem, std::string const &directory, std::vector<Entry> *entries);
+
+public:
+    /*
+     * Load a manifest saved to a file. Fails if the file is missing or invalid.
+     */
+    bool load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Save the manifest to a file, if it changed since it was loaded.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path);
+};
+
+}
+
+#endif /* __dependency_DirectoryManifest_h */
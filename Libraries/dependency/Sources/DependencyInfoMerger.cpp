@@ -0,0 +1,123 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <dependency/DependencyInfoMerger.h>
+#include <dependency/BinaryDependencyInfo.h>
+#include <dependency/DirectoryDependencyInfo.h>
+#include <dependency/MakefileDependencyInfo.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <cctype>
+
+using dependency::DependencyInfoMerger;
+using dependency::DependencyInfo;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+DependencyInfoMerger::
+DependencyInfoMerger(std::string const &currentDirectory) :
+    _currentDirectory(currentDirectory)
+{
+}
+
+void DependencyInfoMerger::
+add(std::string const &input)
+{
+    /* Normalize path as Ninja requires matching paths. */
+    auto result = _seen.insert(FSUtil::ResolveRelativePath(input, _currentDirectory));
+    if (result.second) {
+        /* Set elements don't move, so the inputs can point to them. */
+        _inputs.push_back(&*result.first);
+    }
+}
+
+void DependencyInfoMerger::
+add(DependencyInfo const &dependencyInfo)
+{
+    for (std::string const &input : dependencyInfo.inputs()) {
+        add(input);
+    }
+}
+
+bool DependencyInfoMerger::
+add(Filesystem const *filesystem, DependencyInfoFormat format, std::string const &path)
+{
+    if (format == DependencyInfoFormat::Directory) {
+        auto directoryInfo = DirectoryDependencyInfo::Deserialize(filesystem, path);
+        if (!directoryInfo) {
+            return false;
+        }
+
+        add(directoryInfo->dependencyInfo());
+        return true;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return false;
+    }
+
+    if (format == DependencyInfoFormat::Binary) {
+        auto binaryInfo = BinaryDependencyInfo::Deserialize(contents);
+        if (!binaryInfo) {
+            return false;
+        }
+
+        add(binaryInfo->dependencyInfo());
+        return true;
+    } else if (format == DependencyInfoFormat::Makefile) {
+        auto makefileInfo = MakefileDependencyInfo::Deserialize(std::string(contents.begin(), contents.end()));
+        if (!makefileInfo) {
+            return false;
+        }
+
+        for (DependencyInfo const &dependencyInfo : makefileInfo->dependencyInfo()) {
+            add(dependencyInfo);
+        }
+        return true;
+    } else {
+        return false;
+    }
+}
+
+static void
+AppendMakefile(std::string *result, std::string const &value)
+{
+    /* Same escaping as libutil::Escape::Makefile, without a copy per path. */
+    for (char c : value) {
+        if (isspace(c) || c == '#' || c == '$' || c == '%' || c == ':') {
+            *result += '\\';
+        }
+
+        *result += c;
+    }
+}
+
+std::string DependencyInfoMerger::
+serializeMakefile(std::string const &output) const
+{
+    size_t size = output.size() + 1;
+    for (std::string const *input : _inputs) {
+        size += input->size() + 4;
+    }
+
+    std::string result;
+    result.reserve(size + size / 16);
+
+    AppendMakefile(&result, output);
+    result += ":";
+
+    for (std::string const *input : _inputs) {
+        result += " \\\n  ";
+        AppendMakefile(&result, *input);
+    }
+
+    return result;
+}
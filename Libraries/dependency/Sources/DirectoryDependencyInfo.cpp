@@ -9,10 +9,12 @@
 
 #include <dependency/DirectoryDependencyInfo.h>
 #include <dependency/DependencyInfo.h>
+#include <dependency/DirectoryManifest.h>
 #include <libutil/Filesystem.h>
 
 using dependency::DirectoryDependencyInfo;
 using dependency::DependencyInfo;
+using dependency::DirectoryManifest;
 using libutil::Filesystem;
 
 DirectoryDependencyInfo::
@@ -44,3 +46,41 @@ Deserialize(Filesystem const *filesystem, std::string const &directory)
 
     return DirectoryDependencyInfo(directoryInfo);
 }
+
+static bool
+AddDirectory(Filesystem const *filesystem, DirectoryManifest *manifest, std::string const &directory, std::vector<std::string> *inputs)
+{
+    std::vector<DirectoryManifest::Entry> entries;
+    if (!manifest->entries(filesystem, directory, &entries)) {
+        return false;
+    }
+
+    for (DirectoryManifest::Entry const &entry : entries) {
+        std::string path = directory + "/" + entry.first;
+        inputs->push_back(path);
+
+        /* Unchanged subdirectories are not read again. */
+        if (entry.second && !AddDirectory(filesystem, manifest, path, inputs)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ext::optional<DirectoryDependencyInfo> DirectoryDependencyInfo::
+Deserialize(Filesystem const *filesystem, std::string const &directory, DirectoryManifest *manifest)
+{
+    std::vector<std::string> inputs;
+
+    /* Verify is directory. */
+    if (filesystem->type(directory) != Filesystem::Type::Directory) {
+        return ext::nullopt;
+    }
+
+    if (!AddDirectory(filesystem, manifest, directory, &inputs)) {
+        return ext::nullopt;
+    }
+
+    return DirectoryDependencyInfo(directory, DependencyInfo(inputs, std::vector<std::string>()));
+}
@@ -0,0 +1,145 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <dependency/DirectoryManifest.h>
+#include <libutil/FSUtil.h>
+
+#include <sstream>
+
+using dependency::DirectoryManifest;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/*
+ * The first line of a saved manifest. Changed when the format changes.
+ */
+static std::string const ManifestHeader = "directory-manifest 1";
+
+DirectoryManifest::
+DirectoryManifest() :
+    _modified(false)
+{
+}
+
+bool DirectoryManifest::
+entries(Filesystem const *filesystem, std::string const &directory, std::vector<Entry> *entries)
+{
+    ext::optional<Filesystem::Stamp> stamp = filesystem->readDirectoryStamp(directory);
+
+    if (stamp) {
+        auto it = _directories.find(directory);
+        if (it != _directories.end() && it->second.stamp == *stamp) {
+            *entries = it->second.entries;
+            return true;
+        }
+    }
+
+    std::vector<Entry> read;
+    bool valid = (directory.find('\n') == std::string::npos);
+    if (!filesystem->readDirectory(directory, false, [&](std::string const &name, ext::optional<Filesystem::Type> type) {
+        if (!type) {
+            type = filesystem->type(directory + "/" + name);
+        }
+
+        /* Names are saved one per line. */
+        valid = valid && (name.find('\n') == std::string::npos);
+        read.push_back({ name, type == Filesystem::Type::Directory });
+    })) {
+        return false;
+    }
+
+    /* Keep the entries only if changes to them can be seen. */
+    if (stamp && valid) {
+        _directories[directory] = Directory { *stamp, read };
+        _modified = true;
+    } else if (_directories.erase(directory) != 0) {
+        _modified = true;
+    }
+
+    *entries = std::move(read);
+    return true;
+}
+
+bool DirectoryManifest::
+load(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return false;
+    }
+
+    /*
+     * Each directory is its path, then its stamp, then the number of
+     * entries, followed by a line for each entry: 'd' or 'f' and a name.
+     */
+    std::istringstream stream(std::string(contents.begin(), contents.end()));
+
+    std::string line;
+    if (!std::getline(stream, line) || line != ManifestHeader) {
+        return false;
+    }
+
+    std::unordered_map<std::string, Directory> directories;
+    std::string directory;
+    while (std::getline(stream, directory)) {
+        Directory loaded;
+        size_t count;
+
+        if (!std::getline(stream, line)) {
+            return false;
+        }
+        std::istringstream values(line);
+        if (!(values >> loaded.stamp.size >> loaded.stamp.modificationTime >> count)) {
+            return false;
+        }
+
+        for (size_t n = 0; n < count; ++n) {
+            if (!std::getline(stream, line) || line.size() < 2 || (line[0] != 'd' && line[0] != 'f')) {
+                return false;
+            }
+
+            loaded.entries.push_back({ line.substr(1), line[0] == 'd' });
+        }
+
+        directories[directory] = std::move(loaded);
+    }
+
+    _directories = std::move(directories);
+    _modified = false;
+    return true;
+}
+
+bool DirectoryManifest::
+save(Filesystem *filesystem, std::string const &path)
+{
+    if (!_modified) {
+        return true;
+    }
+
+    std::string result = ManifestHeader + "\n";
+    for (auto const &directory : _directories) {
+        result += directory.first + "\n";
+        result += std::to_string(directory.second.stamp.size) + " ";
+        result += std::to_string(directory.second.stamp.modificationTime) + " ";
+        result += std::to_string(directory.second.entries.size()) + "\n";
+
+        for (Entry const &entry : directory.second.entries) {
+            result += (entry.second ? 'd' : 'f');
+            result += entry.first + "\n";
+        }
+    }
+
+    std::vector<uint8_t> contents = std::vector<uint8_t>(result.begin(), result.end());
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true) || !filesystem->write(contents, path)) {
+        return false;
+    }
+
+    _modified = false;
+    return true;
+}
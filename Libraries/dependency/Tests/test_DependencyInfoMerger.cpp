@@ -0,0 +1,45 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <dependency/DependencyInfoMerger.h>
+#include <dependency/MakefileDependencyInfo.h>
+
+using dependency::DependencyInfoMerger;
+using dependency::DependencyInfo;
+using dependency::MakefileDependencyInfo;
+
+TEST(DependencyInfoMerger, Deduplicate)
+{
+    DependencyInfoMerger merger = DependencyInfoMerger("/root");
+    merger.add(DependencyInfo({ "one", "/root/two" }, { "output" }));
+    merger.add(DependencyInfo({ "/root/one", "two", "three" }, { }));
+    merger.add("one");
+
+    ASSERT_EQ(merger.inputs().size(), 3);
+    EXPECT_EQ(*merger.inputs()[0], "/root/one");
+    EXPECT_EQ(*merger.inputs()[1], "/root/two");
+    EXPECT_EQ(*merger.inputs()[2], "/root/three");
+}
+
+TEST(DependencyInfoMerger, SerializeMakefile)
+{
+    DependencyInfoMerger merger = DependencyInfoMerger("/");
+    merger.add("/with space");
+    merger.add("/colon:");
+
+    EXPECT_EQ("out\\$put: \\\n  /with\\ space \\\n  /colon\\:", merger.serializeMakefile("out$put"));
+
+    /* Matches the general serializer. */
+    MakefileDependencyInfo makefileInfo;
+    makefileInfo.dependencyInfo() = { DependencyInfo({ "/with space", "/colon:" }, { "out$put" }) };
+    EXPECT_EQ(makefileInfo.serialize(), merger.serializeMakefile("out$put"));
+
+    EXPECT_EQ("output:", DependencyInfoMerger("/").serializeMakefile("output"));
+}
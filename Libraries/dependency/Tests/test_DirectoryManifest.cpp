@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <dependency/DirectoryManifest.h>
+#include <dependency/DirectoryDependencyInfo.h>
+#include <libutil/MemoryFilesystem.h>
+
+using dependency::DirectoryManifest;
+using dependency::DirectoryDependencyInfo;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+/*
+ * A memory filesystem that records the directories read.
+ */
+class RecordingFilesystem : public MemoryFilesystem {
+public:
+    mutable std::vector<std::string> reads;
+
+public:
+    explicit RecordingFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
+        MemoryFilesystem(entries)
+    {
+    }
+
+public:
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const
+    {
+        reads.push_back(path);
+        return MemoryFilesystem::readDirectory(path, recursive, cb);
+    }
+};
+
+TEST(DirectoryManifest, ReadOnlyChanged)
+{
+    RecordingFilesystem filesystem = RecordingFilesystem({
+        MemoryFilesystem::Entry::Directory("root", {
+            MemoryFilesystem::Entry::File("file1", { }),
+            MemoryFilesystem::Entry::Directory("dir1", {
+                MemoryFilesystem::Entry::File("file2", { }),
+            }),
+            MemoryFilesystem::Entry::Directory("dir2", {
+                MemoryFilesystem::Entry::File("file3", { }),
+            }),
+        }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 0 }));
+
+    DirectoryManifest manifest;
+    auto info1 = DirectoryDependencyInfo::Deserialize(&filesystem, "/root", &manifest);
+    ASSERT_TRUE(info1);
+    EXPECT_EQ(info1->dependencyInfo().inputs().size(), 5);
+    EXPECT_EQ(filesystem.reads.size(), 3);
+
+    /* Nothing changed, so nothing is read. */
+    filesystem.reads.clear();
+    auto info2 = DirectoryDependencyInfo::Deserialize(&filesystem, "/root", &manifest);
+    ASSERT_TRUE(info2);
+    EXPECT_EQ(info2->dependencyInfo().inputs(), info1->dependencyInfo().inputs());
+    EXPECT_TRUE(filesystem.reads.empty());
+
+    /* Only the changed directory is read. */
+    ASSERT_TRUE(filesystem.write({ }, "/root/dir2/file4"));
+    ASSERT_TRUE(filesystem.setStamp("/root/dir2", Filesystem::Stamp({ 0, 1 })));
+    auto info3 = DirectoryDependencyInfo::Deserialize(&filesystem, "/root", &manifest);
+    ASSERT_TRUE(info3);
+    EXPECT_EQ(info3->dependencyInfo().inputs().size(), 6);
+    EXPECT_EQ(filesystem.reads, std::vector<std::string>({ "/root/dir2" }));
+}
+
+TEST(DirectoryManifest, SaveLoad)
+{
+    RecordingFilesystem filesystem = RecordingFilesystem({
+        MemoryFilesystem::Entry::Directory("root", {
+            MemoryFilesystem::Entry::File("file 1", { }),
+            MemoryFilesystem::Entry::Directory("dir", {
+                MemoryFilesystem::Entry::File("file2", { }),
+            }),
+        }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 0 }));
+
+    {
+        DirectoryManifest manifest;
+        ASSERT_TRUE(DirectoryDependencyInfo::Deserialize(&filesystem, "/root", &manifest));
+        ASSERT_TRUE(manifest.save(&filesystem, "/manifest"));
+    }
+
+    filesystem.reads.clear();
+    DirectoryManifest manifest;
+    ASSERT_TRUE(manifest.load(&filesystem, "/manifest"));
+    auto info = DirectoryDependencyInfo::Deserialize(&filesystem, "/root", &manifest);
+    ASSERT_TRUE(info);
+    EXPECT_TRUE(filesystem.reads.empty());
+    EXPECT_EQ(info->dependencyInfo().inputs(), DirectoryDependencyInfo::Deserialize(&filesystem, "/root")->dependencyInfo().inputs());
+
+    EXPECT_FALSE(manifest.load(&filesystem, "/missing"));
+}
@@ -8,7 +8,6 @@
  */
 
 #include <libutil/Options.h>
-#include <libutil/Escape.h>
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
@@ -16,13 +15,14 @@
 #include <process/Context.h>
 
 #include <dependency/DependencyInfo.h>
+#include <dependency/DependencyInfoMerger.h>
 #include <dependency/BinaryDependencyInfo.h>
 #include <dependency/DirectoryDependencyInfo.h>
+#include <dependency/DirectoryManifest.h>
 #include <dependency/MakefileDependencyInfo.h>
 
 #include <cassert>
 
-using libutil::Escape;
 using libutil::DefaultFilesystem;
 using libutil::Filesystem;
 using libutil::FSUtil;
@@ -36,6 +36,7 @@ private:
     std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> _inputs;
     ext::optional<std::string> _output;
     ext::optional<std::string> _name;
+    ext::optional<std::string> _manifest;
 
 public:
     Options();
@@ -54,6 +55,8 @@ public:
     { return _output; }
     ext::optional<std::string> const &name() const
     { return _name; }
+    ext::optional<std::string> const &manifest() const
+    { return _manifest; }
 
 private:
     friend class libutil::Options;
@@ -84,6 +87,8 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_output, args, it);
     } else if (arg == "-n" || arg == "--name") {
         return libutil::Options::Next<std::string>(&_name, args, it);
+    } else if (arg == "-m" || arg == "--manifest") {
+        return libutil::Options::Next<std::string>(&_manifest, args, it);
     } else if (!arg.empty() && arg[0] != '-') {
         std::string::size_type offset = arg.find(':');
         if (offset != std::string::npos && offset != 0 && offset != arg.size() - 1) {
@@ -125,6 +130,7 @@ Help(std::string const &error = std::string())
     fprintf(stderr, "Conversion Options:\n");
     fprintf(stderr, INDENT "-o, --output\n");
     fprintf(stderr, INDENT "-n, --name\n");
+    fprintf(stderr, INDENT "-m, --manifest (for directory inputs)\n");
     fprintf(stderr, "\n");
 
     fprintf(stderr, "Inputs:\n");
@@ -144,7 +150,7 @@ Version()
 }
 
 static bool
-LoadDependencyInfo(Filesystem const *filesystem, std::string const &path, dependency::DependencyInfoFormat format, std::vector<dependency::DependencyInfo> *dependencyInfo)
+LoadDependencyInfo(Filesystem const *filesystem, std::string const &path, dependency::DependencyInfoFormat format, dependency::DirectoryManifest *manifest, dependency::DependencyInfoMerger *merger)
 {
     if (format == dependency::DependencyInfoFormat::Binary) {
         std::vector<uint8_t> contents;
@@ -159,16 +165,18 @@ LoadDependencyInfo(Filesystem const *filesystem, std::string const &path, depend
             return false;
         }
 
-        dependencyInfo->push_back(binaryInfo->dependencyInfo());
+        merger->add(binaryInfo->dependencyInfo());
         return true;
     } else if (format == dependency::DependencyInfoFormat::Directory) {
-        auto directoryInfo = dependency::DirectoryDependencyInfo::Deserialize(filesystem, path);
+        auto directoryInfo = (manifest != nullptr ?
+            dependency::DirectoryDependencyInfo::Deserialize(filesystem, path, manifest) :
+            dependency::DirectoryDependencyInfo::Deserialize(filesystem, path));
         if (!directoryInfo) {
             fprintf(stderr, "error: invalid directory\n");
             return false;
         }
 
-        dependencyInfo->push_back(directoryInfo->dependencyInfo());
+        merger->add(directoryInfo->dependencyInfo());
         return true;
     } else if (format == dependency::DependencyInfoFormat::Makefile) {
         std::vector<uint8_t> contents;
@@ -184,7 +192,9 @@ LoadDependencyInfo(Filesystem const *filesystem, std::string const &path, depend
             return false;
         }
 
-        dependencyInfo->insert(dependencyInfo->end(), makefileInfo->dependencyInfo().begin(), makefileInfo->dependencyInfo().end());
+        for (dependency::DependencyInfo const &dependencyInfo : makefileInfo->dependencyInfo()) {
+            merger->add(dependencyInfo);
+        }
         return true;
     } else {
         assert(false);
@@ -192,24 +202,6 @@ LoadDependencyInfo(Filesystem const *filesystem, std::string const &path, depend
     }
 }
 
-static std::string
-SerializeMakefileDependencyInfo(std::string const &currentDirectory, std::string const &output, std::vector<std::string> const &inputs)
-{
-    dependency::DependencyInfo dependencyInfo;
-    dependencyInfo.outputs() = { output };
-
-    /* Normalize path as Ninja requires matching paths. */
-    for (std::string const &input : inputs) {
-        std::string path = FSUtil::ResolveRelativePath(input, currentDirectory);
-        dependencyInfo.inputs().push_back(path);
-    }
-
-    /* Serialize dependency info. */
-    dependency::MakefileDependencyInfo makefileInfo;
-    makefileInfo.dependencyInfo() = { dependencyInfo };
-    return makefileInfo.serialize();
-}
-
 int
 main(int argc, char **argv)
 {
@@ -241,25 +233,36 @@ main(int argc, char **argv)
         return Help("missing option(s)");
     }
 
-    std::vector<std::string> inputs;
+    /*
+     * Merge the inputs from all of the dependency info. Large dependency
+     * info often lists the same inputs many times.
+     */
+    dependency::DependencyInfoMerger merger = dependency::DependencyInfoMerger(processContext.currentDirectory());
+
+    /*
+     * With a manifest, only directories changed since the last run are read.
+     */
+    dependency::DirectoryManifest manifest;
+    ext::optional<std::string> manifestPath;
+    if (options.manifest()) {
+        manifestPath = FSUtil::ResolveRelativePath(*options.manifest(), processContext.currentDirectory());
+        manifest.load(&filesystem, *manifestPath);
+    }
+
     for (std::pair<dependency::DependencyInfoFormat, std::string> const &input : options.inputs()) {
-        /*
-         * Load the dependency info.
-         */
-        std::vector<dependency::DependencyInfo> info;
-        if (!LoadDependencyInfo(&filesystem, input.second, input.first, &info)) {
+        if (!LoadDependencyInfo(&filesystem, input.second, input.first, (manifestPath ? &manifest : nullptr), &merger)) {
             return -1;
         }
+    }
 
-        for (dependency::DependencyInfo const &dependencyInfo : info) {
-            inputs.insert(inputs.end(), dependencyInfo.inputs().begin(), dependencyInfo.inputs().end());
-        }
+    if (manifestPath && !manifest.save(&filesystem, *manifestPath)) {
+        fprintf(stderr, "warning: unable to write manifest %s\n", manifestPath->c_str());
     }
 
     /*
      * Serialize the output.
      */
-    std::string contents = SerializeMakefileDependencyInfo(processContext.currentDirectory(), *options.name(), inputs);
+    std::string contents = merger.serializeMakefile(*options.name());
 
     /*
      * Write out the output.
@@ -0,0 +1,72 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __graphics_Format_ASTC_h
+#define __graphics_Format_ASTC_h
+
+#include <graphics/Image.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace graphics {
+namespace Format {
+
+/*
+ * Utilities for ASTC compressed textures.
+ */
+class ASTC {
+public:
+    /*
+     * The size of a block, in pixels. Each block is 16 bytes.
+     */
+    enum class BlockSize {
+        /*
+         * Eight bits per pixel.
+         */
+        Block4x4,
+        /*
+         * Two bits per pixel.
+         */
+        Block8x8,
+    };
+
+private:
+    ASTC();
+    ~ASTC();
+
+public:
+    /*
+     * The width and height of a block size.
+     */
+    static size_t BlockDimension(BlockSize blockSize);
+
+public:
+    /*
+     * Encode an image into LDR blocks, in rows from the top left. Edge
+     * blocks repeat the last row and column. Each block has one partition
+     * with RGBA endpoints, so the result is valid for both linear and sRGB
+     * textures. Rows of blocks are encoded on all processors.
+     */
+    static std::vector<uint8_t>
+    Encode(Image const &image, BlockSize blockSize);
+
+    /*
+     * Write an image as an ASTC file: a header and the encoded blocks.
+     */
+    static std::pair<ext::optional<std::vector<uint8_t>>, std::string>
+    Write(Image const &image, BlockSize blockSize);
+};
+
+}
+}
+
+#endif // !__graphics_Format_ASTC_h
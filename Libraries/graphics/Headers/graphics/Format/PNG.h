@@ -25,6 +25,52 @@ namespace Format {
  * Utilities for PNG images.
  */
 class PNG {
+public:
+    /*
+     * How rows are filtered before compression.
+     */
+    enum class Filter {
+        /*
+         * Store rows as-is. Fastest, but compresses the least.
+         */
+        None,
+        /*
+         * Difference from the pixel to the left.
+         */
+        Sub,
+        /*
+         * Difference from the pixel above.
+         */
+        Up,
+        /*
+         * Difference from a prediction from the left, above and upper left
+         * pixels. Slowest, but usually compresses the most.
+         */
+        Paeth,
+    };
+
+    /*
+     * How much to compress the filtered rows.
+     */
+    enum class Compression {
+        /*
+         * Store without compression.
+         */
+        None,
+        /*
+         * Compress quickly, at the cost of size.
+         */
+        Fast,
+        /*
+         * Balance speed and size.
+         */
+        Default,
+        /*
+         * Compress as small as possible, at the cost of speed.
+         */
+        Best,
+    };
+
 private:
     PNG();
     ~PNG();
@@ -36,12 +82,28 @@ public:
     static std::pair<ext::optional<Image>, std::string>
     Read(std::vector<uint8_t> const &contents);
 
+    /*
+     * Read a PNG image, keeping its color but converting it to the given
+     * order and alpha. Rows are converted as they are decoded, without an
+     * intermediate copy of the image where possible.
+     */
+    static std::pair<ext::optional<Image>, std::string>
+    Read(std::vector<uint8_t> const &contents, PixelFormat::Order order, PixelFormat::Alpha alpha);
+
 public:
     /*
      * Write a PNG image.
      */
     static std::pair<ext::optional<std::vector<uint8_t>>, std::string>
     Write(Image const &image);
+
+    /*
+     * Write a PNG image with the given filter and compression. For speed
+     * over size, such as for development builds, use `Filter::Sub` with
+     * `Compression::Fast`.
+     */
+    static std::pair<ext::optional<std::vector<uint8_t>>, std::string>
+    Write(Image const &image, Filter filter, Compression compression);
 };
 
 }
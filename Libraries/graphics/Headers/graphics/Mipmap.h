@@ -0,0 +1,52 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __graphics_Mipmap_h
+#define __graphics_Mipmap_h
+
+#include <graphics/Image.h>
+
+#include <vector>
+
+namespace graphics {
+
+/*
+ * Generates mipmap levels by downsampling.
+ */
+class Mipmap {
+private:
+    Mipmap();
+    ~Mipmap();
+
+public:
+    /*
+     * The number of levels in a full chain for an image size, including
+     * the base level: each level is half the size of the previous one,
+     * down to one pixel.
+     */
+    static size_t LevelCount(size_t width, size_t height);
+
+    /*
+     * Create the next level of an image, half its size, by averaging each
+     * two by two block of pixels. Sizes round down, as for GPU textures,
+     * and a side that is one pixel stays one pixel. Channels are averaged
+     * independently, so images with alpha should be premultiplied. Large
+     * images are downsampled on all processors.
+     */
+    static Image Downsample(Image const &image);
+
+    /*
+     * Create the levels after the base image, down to one pixel.
+     */
+    static std::vector<Image> Generate(Image const &base);
+};
+
+}
+
+#endif // !__graphics_Mipmap_h
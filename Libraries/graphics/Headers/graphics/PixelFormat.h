@@ -142,6 +142,36 @@ public:
         std::vector<uint8_t> const &pixels,
         PixelFormat const &from,
         PixelFormat const &to);
+
+    /*
+     * Convert from one color format to another, into an existing buffer.
+     * The buffer's storage is reused if it is large enough.
+     */
+    static void Convert(
+        std::vector<uint8_t> const &pixels,
+        PixelFormat const &from,
+        PixelFormat const &to,
+        std::vector<uint8_t> *result);
+
+    /*
+     * Convert a run of pixels between buffers, such as a single row. Bytes
+     * for ignored alpha in the result are not written.
+     */
+    static void Convert(
+        uint8_t const *pixels,
+        size_t pixelCount,
+        PixelFormat const &from,
+        PixelFormat const &to,
+        uint8_t *result);
+
+    /*
+     * Convert from one color format to another in place. Only allocates
+     * if the formats have different sizes.
+     */
+    static void ConvertInPlace(
+        std::vector<uint8_t> *pixels,
+        PixelFormat const &from,
+        PixelFormat const &to);
 };
 
 }
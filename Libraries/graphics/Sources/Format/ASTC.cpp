@@ -0,0 +1,317 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <graphics/Format/ASTC.h>
+#include <graphics/PixelFormat.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using graphics::Format::ASTC;
+using graphics::Image;
+using graphics::PixelFormat;
+using libutil::Parallel;
+
+/*
+ * Every block uses a 4x4 grid of two bit weights with one partition and
+ * direct RGBA endpoints (color endpoint mode 12). That leaves room for
+ * eight bit endpoints, which need no integer sequence encoding.
+ */
+static size_t const GridDimension = 4;
+
+/*
+ * Block mode for a 4x4 weight grid with weights quantized to four levels:
+ * A = 2, B = 0, layout 0 (width B + 4, height A + 2), range bits 100.
+ */
+static uint32_t const BlockMode = 0x042;
+static uint32_t const EndpointMode = 12;
+
+/*
+ * The four weight levels, out of 64.
+ */
+static int const WeightValues[4] = { 0, 21, 43, 64 };
+
+size_t ASTC::
+BlockDimension(BlockSize blockSize)
+{
+    switch (blockSize) {
+        case BlockSize::Block4x4:
+            return 4;
+        case BlockSize::Block8x8:
+            return 8;
+    }
+
+    abort();
+}
+
+static void
+WriteBits(uint8_t *block, size_t offset, size_t count, uint32_t value)
+{
+    for (size_t n = 0; n < count; ++n) {
+        if (value & (1u << n)) {
+            block[(offset + n) / 8] |= static_cast<uint8_t>(1u << ((offset + n) % 8));
+        }
+    }
+}
+
+/*
+ * How much each texel takes from each grid weight, from the bilinear
+ * infill when the grid is smaller than the block. In sixteenths.
+ */
+struct Infill {
+    size_t index[4];
+    int    factor[4];
+};
+
+static std::vector<Infill>
+BlockInfill(size_t dimension)
+{
+    std::vector<Infill> infill;
+    infill.reserve(dimension * dimension);
+
+    int scale = (1024 + static_cast<int>(dimension) / 2) / (static_cast<int>(dimension) - 1);
+    for (size_t t = 0; t < dimension; ++t) {
+        for (size_t s = 0; s < dimension; ++s) {
+            int gs = (scale * static_cast<int>(s) * (GridDimension - 1) + 32) >> 6;
+            int gt = (scale * static_cast<int>(t) * (GridDimension - 1) + 32) >> 6;
+            size_t js = gs >> 4;
+            size_t jt = gt >> 4;
+            int fs = gs & 0xF;
+            int ft = gt & 0xF;
+
+            Infill entry;
+            entry.factor[3] = (fs * ft + 8) >> 4;
+            entry.factor[2] = ft - entry.factor[3];
+            entry.factor[1] = fs - entry.factor[3];
+            entry.factor[0] = 16 - fs - ft + entry.factor[3];
+
+            size_t js1 = std::min(js + 1, GridDimension - 1);
+            size_t jt1 = std::min(jt + 1, GridDimension - 1);
+            entry.index[0] = jt * GridDimension + js;
+            entry.index[1] = jt * GridDimension + js1;
+            entry.index[2] = jt1 * GridDimension + js;
+            entry.index[3] = jt1 * GridDimension + js1;
+            infill.push_back(entry);
+        }
+    }
+
+    return infill;
+}
+
+static void
+EncodeBlock(uint8_t const *texels, size_t dimension, std::vector<Infill> const *infill, uint8_t *block)
+{
+    size_t count = dimension * dimension;
+
+    /* Endpoints along the principal axis of the texels. */
+    float mean[4] = { 0, 0, 0, 0 };
+    for (size_t n = 0; n < count; ++n) {
+        for (size_t c = 0; c < 4; ++c) {
+            mean[c] += texels[n * 4 + c];
+        }
+    }
+    for (size_t c = 0; c < 4; ++c) {
+        mean[c] /= count;
+    }
+
+    float covariance[4][4] = { };
+    for (size_t n = 0; n < count; ++n) {
+        float d[4];
+        for (size_t c = 0; c < 4; ++c) {
+            d[c] = texels[n * 4 + c] - mean[c];
+        }
+        for (size_t i = 0; i < 4; ++i) {
+            for (size_t j = 0; j < 4; ++j) {
+                covariance[i][j] += d[i] * d[j];
+            }
+        }
+    }
+
+    float axis[4] = { 1, 1, 1, 1 };
+    for (size_t iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = { 0, 0, 0, 0 };
+        for (size_t i = 0; i < 4; ++i) {
+            for (size_t j = 0; j < 4; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+        }
+
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+        if (length < 1e-6f) {
+            break;
+        }
+        for (size_t c = 0; c < 4; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float low = 0, high = 0;
+    for (size_t n = 0; n < count; ++n) {
+        float t = 0;
+        for (size_t c = 0; c < 4; ++c) {
+            t += (texels[n * 4 + c] - mean[c]) * axis[c];
+        }
+        low = std::min(low, t);
+        high = std::max(high, t);
+    }
+
+    int endpoints[2][4];
+    for (size_t c = 0; c < 4; ++c) {
+        endpoints[0][c] = std::max(0, std::min(255, static_cast<int>(std::lround(mean[c] + low * axis[c]))));
+        endpoints[1][c] = std::max(0, std::min(255, static_cast<int>(std::lround(mean[c] + high * axis[c]))));
+    }
+
+    /*
+     * The decoder swaps endpoints (and contracts blue) if the second is
+     * darker, so keep the brighter one second.
+     */
+    if (endpoints[1][0] + endpoints[1][1] + endpoints[1][2] < endpoints[0][0] + endpoints[0][1] + endpoints[0][2]) {
+        std::swap(endpoints[0], endpoints[1]);
+    }
+
+    /* Each texel's ideal weight, out of 64. */
+    float range[4];
+    float lengthSquared = 0;
+    for (size_t c = 0; c < 4; ++c) {
+        range[c] = static_cast<float>(endpoints[1][c] - endpoints[0][c]);
+        lengthSquared += range[c] * range[c];
+    }
+
+    std::vector<float> ideal = std::vector<float>(count, 0);
+    if (lengthSquared > 0) {
+        for (size_t n = 0; n < count; ++n) {
+            float t = 0;
+            for (size_t c = 0; c < 4; ++c) {
+                t += (texels[n * 4 + c] - endpoints[0][c]) * range[c];
+            }
+            ideal[n] = std::max(0.0f, std::min(64.0f, 64.0f * t / lengthSquared));
+        }
+    }
+
+    /* Grid weights are the texels they contribute to, averaged. */
+    float grid[GridDimension * GridDimension];
+    if (infill == nullptr) {
+        std::copy(ideal.begin(), ideal.end(), grid);
+    } else {
+        float totals[GridDimension * GridDimension] = { };
+        float factors[GridDimension * GridDimension] = { };
+        for (size_t n = 0; n < count; ++n) {
+            Infill const &entry = (*infill)[n];
+            for (size_t k = 0; k < 4; ++k) {
+                totals[entry.index[k]] += ideal[n] * entry.factor[k];
+                factors[entry.index[k]] += entry.factor[k];
+            }
+        }
+        for (size_t n = 0; n < GridDimension * GridDimension; ++n) {
+            grid[n] = (factors[n] > 0 ? totals[n] / factors[n] : 0);
+        }
+    }
+
+    memset(block, 0, 16);
+    WriteBits(block, 0, 11, BlockMode);
+    WriteBits(block, 11, 2, 0);
+    WriteBits(block, 13, 4, EndpointMode);
+
+    /* Endpoints are interleaved by channel: r0 r1 g0 g1 b0 b1 a0 a1. */
+    for (size_t c = 0; c < 4; ++c) {
+        WriteBits(block, 17 + (c * 2 + 0) * 8, 8, endpoints[0][c]);
+        WriteBits(block, 17 + (c * 2 + 1) * 8, 8, endpoints[1][c]);
+    }
+
+    /* Weights are stored from the end of the block, bit reversed. */
+    for (size_t n = 0; n < GridDimension * GridDimension; ++n) {
+        int best = 0;
+        for (int q = 1; q < 4; ++q) {
+            if (std::fabs(grid[n] - WeightValues[q]) < std::fabs(grid[n] - WeightValues[best])) {
+                best = q;
+            }
+        }
+
+        for (size_t b = 0; b < 2; ++b) {
+            if (best & (1 << b)) {
+                size_t bit = 127 - (n * 2 + b);
+                block[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> ASTC::
+Encode(Image const &image, BlockSize blockSize)
+{
+    size_t dimension = BlockDimension(blockSize);
+    size_t blocksWide = (image.width() + dimension - 1) / dimension;
+    size_t blocksHigh = (image.height() + dimension - 1) / dimension;
+    std::vector<uint8_t> result = std::vector<uint8_t>(blocksWide * blocksHigh * 16);
+    if (blocksWide == 0 || blocksHigh == 0) {
+        return result;
+    }
+
+    PixelFormat rgba = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    std::vector<uint8_t> converted;
+    std::vector<uint8_t> const *pixels = &image.data();
+    if (image.format().color() != rgba.color() || image.format().order() != rgba.order() || image.format().alpha() != rgba.alpha()) {
+        converted = PixelFormat::Convert(image.data(), image.format(), rgba);
+        pixels = &converted;
+    }
+
+    std::vector<Infill> infill;
+    if (dimension != GridDimension) {
+        infill = BlockInfill(dimension);
+    }
+
+    auto encodeRow = [&](size_t by) {
+        std::vector<uint8_t> texels = std::vector<uint8_t>(dimension * dimension * 4);
+        for (size_t bx = 0; bx < blocksWide; ++bx) {
+            for (size_t y = 0; y < dimension; ++y) {
+                size_t py = std::min(by * dimension + y, image.height() - 1);
+                for (size_t x = 0; x < dimension; ++x) {
+                    size_t px = std::min(bx * dimension + x, image.width() - 1);
+                    memcpy(&texels[(y * dimension + x) * 4], &(*pixels)[(py * image.width() + px) * 4], 4);
+                }
+            }
+
+            EncodeBlock(texels.data(), dimension, infill.empty() ? nullptr : &infill, &result[(by * blocksWide + bx) * 16]);
+        }
+    };
+
+    Parallel::For(Parallel::DefaultJobs(), blocksHigh, encodeRow);
+
+    return result;
+}
+
+std::pair<ext::optional<std::vector<uint8_t>>, std::string> ASTC::
+Write(Image const &image, BlockSize blockSize)
+{
+    if (image.width() >= (1 << 24) || image.height() >= (1 << 24)) {
+        return std::make_pair(ext::nullopt, "image too large");
+    }
+
+    size_t dimension = BlockDimension(blockSize);
+    std::vector<uint8_t> blocks = Encode(image, blockSize);
+
+    std::vector<uint8_t> contents;
+    contents.reserve(16 + blocks.size());
+
+    uint8_t const magic[4] = { 0x13, 0xAB, 0xA1, 0x5C };
+    contents.insert(contents.end(), magic, magic + sizeof(magic));
+    contents.push_back(static_cast<uint8_t>(dimension));
+    contents.push_back(static_cast<uint8_t>(dimension));
+    contents.push_back(1);
+    for (size_t size : { image.width(), image.height(), static_cast<size_t>(1) }) {
+        contents.push_back(static_cast<uint8_t>(size));
+        contents.push_back(static_cast<uint8_t>(size >> 8));
+        contents.push_back(static_cast<uint8_t>(size >> 16));
+    }
+    contents.insert(contents.end(), blocks.begin(), blocks.end());
+
+    return std::make_pair(contents, std::string());
+}
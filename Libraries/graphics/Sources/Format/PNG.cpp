@@ -9,7 +9,9 @@
 
 #include <graphics/Format/PNG.h>
 
+#include <functional>
 #include <iterator>
+#include <utility>
 #include <ext/optional>
 
 using graphics::Format::PNG;
@@ -108,8 +110,8 @@ PixelFormatFromCGColorSpaceAndCGBitmapInfo(CGColorSpaceRef colorSpace, CGBitmapI
     return PixelFormat(color, order, alpha);
 }
 
-std::pair<ext::optional<Image>, std::string> PNG::
-Read(std::vector<uint8_t> const &contents)
+static std::pair<ext::optional<Image>, std::string>
+ReadImage(std::vector<uint8_t> const &contents)
 {
     /*
      * Load the image.
@@ -167,8 +169,8 @@ Read(std::vector<uint8_t> const &contents)
         CFRange range = CFRangeMake(0, CFDataGetLength(data.get()));
         CFDataGetBytes(data.get(), range, pixels.data());
 
-        Image image = Image(width, height, *format, pixels);
-        return std::make_pair(image, std::string());
+        Image image = Image(width, height, *format, std::move(pixels));
+        return std::make_pair(std::move(image), std::string());
     } else {
         /*
          * Convert to a supported image format. Note that CoreGraphics does not support
@@ -201,18 +203,33 @@ Read(std::vector<uint8_t> const &contents)
             /* Convert to grayscale. */
             auto intermediateFormat = *PixelFormatFromCGColorSpaceAndCGBitmapInfo(colorSpace.get(), bitmapInfo);
             auto format = PixelFormat(PixelFormat::Color::Grayscale, intermediateFormat.order(), intermediateFormat.alpha());
-            std::vector<uint8_t> pixels = PixelFormat::Convert(backing, intermediateFormat, format);
-            Image image = Image(width, height, format, pixels);
-            return std::make_pair(image, std::string());
+            PixelFormat::ConvertInPlace(&backing, intermediateFormat, format);
+            Image image = Image(width, height, format, std::move(backing));
+            return std::make_pair(std::move(image), std::string());
         } else {
             /* Not grayscale, return it as-is. */
             PixelFormat format = *PixelFormatFromCGColorSpaceAndCGBitmapInfo(colorSpace.get(), bitmapInfo);
-            Image image = Image(width, height, format, backing);
-            return std::make_pair(image, std::string());
+            Image image = Image(width, height, format, std::move(backing));
+            return std::make_pair(std::move(image), std::string());
         }
     }
 }
 
+static std::pair<ext::optional<Image>, std::string>
+ReadImage(std::vector<uint8_t> const &contents, std::function<PixelFormat(PixelFormat const &)> const &target)
+{
+    auto result = ReadImage(contents);
+    if (result.first) {
+        /* CoreGraphics decodes the whole image, so convert it afterwards. */
+        Image &image = *result.first;
+        PixelFormat format = target(image.format());
+        PixelFormat::ConvertInPlace(&image.data(), image.format(), format);
+        result.first = Image(image.width(), image.height(), format, std::move(image.data()));
+    }
+
+    return result;
+}
+
 #else
 
 #include <png.h>
@@ -230,8 +247,8 @@ png_user_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
     *contents_ptr += length;
 }
 
-std::pair<ext::optional<Image>, std::string> PNG::
-Read(std::vector<uint8_t> const &contents)
+static std::pair<ext::optional<Image>, std::string>
+ReadImage(std::vector<uint8_t> const &contents, std::function<PixelFormat(PixelFormat const &)> const &target)
 {
     if (contents.size() < 8 || png_sig_cmp(const_cast<png_bytep>(static_cast<png_byte const *>(contents.data())), 0, 8)) {
         return std::make_pair(ext::nullopt, "contents is not a PNG");
@@ -336,35 +353,169 @@ Read(std::vector<uint8_t> const &contents)
         return std::make_pair(ext::nullopt, "unable to transform PNG pixel data");
     }
 
-    png_byte **row_pointers = (png_byte **)malloc(height * sizeof(png_bytep));
-    if (row_pointers == NULL) {
-        png_destroy_read_struct(&png_struct_ptr, &info_struct_ptr, NULL);
-        return std::make_pair(ext::nullopt, "could not allocate memory");
+    PixelFormat targetFormat = target(format);
+    if (interlace_method != PNG_INTERLACE_NONE || (targetFormat.color() == format.color() && targetFormat.order() == format.order() && targetFormat.alpha() == format.alpha())) {
+        /*
+         * Interlaced images need the whole image to decode, so read it all,
+         * then convert it if needed.
+         */
+        png_byte **row_pointers = (png_byte **)malloc(height * sizeof(png_bytep));
+        if (row_pointers == NULL) {
+            png_destroy_read_struct(&png_struct_ptr, &info_struct_ptr, NULL);
+            return std::make_pair(ext::nullopt, "could not allocate memory");
+        }
+
+        auto pixels = std::vector<uint8_t>(width * height * format.bytesPerPixel());
+        unsigned char *bytes = static_cast<unsigned char *>(pixels.data());
+        for (int row = 0; row < height; row++) {
+            row_pointers[row] = bytes + (row * row_bytes);
+        }
+        png_read_image(png_struct_ptr, row_pointers);
+
+        /* Clean up. */
+        png_read_end(png_struct_ptr, info_struct_ptr);
+        png_destroy_read_struct(&png_struct_ptr, &info_struct_ptr, (png_infopp)NULL);
+        free(row_pointers);
+
+        PixelFormat::ConvertInPlace(&pixels, format, targetFormat);
+        Image image = Image(width, height, targetFormat, std::move(pixels));
+        return std::make_pair(std::move(image), std::string());
     }
 
-    auto pixels = std::vector<uint8_t>(width * height * format.bytesPerPixel());
-    unsigned char *bytes = static_cast<unsigned char *>(pixels.data());
-    for (int row = 0; row < height; row++) {
-        row_pointers[row] = bytes + (row * row_bytes);
+    /*
+     * Decode one row at a time, converting each straight into the result.
+     */
+    size_t target_row_bytes = width * targetFormat.bytesPerPixel();
+    auto pixels = std::vector<uint8_t>(height * target_row_bytes);
+    auto row = std::vector<uint8_t>(row_bytes);
+    for (png_uint_32 y = 0; y < height; y++) {
+        png_read_row(png_struct_ptr, row.data(), NULL);
+        PixelFormat::Convert(row.data(), width, format, targetFormat, pixels.data() + y * target_row_bytes);
     }
-    png_read_image(png_struct_ptr, row_pointers);
 
     /* Clean up. */
     png_read_end(png_struct_ptr, info_struct_ptr);
     png_destroy_read_struct(&png_struct_ptr, &info_struct_ptr, (png_infopp)NULL);
-    free(row_pointers);
 
-    Image image = Image(width, height, format, pixels);
-    return std::make_pair(image, std::string());
+    Image image = Image(width, height, targetFormat, std::move(pixels));
+    return std::make_pair(std::move(image), std::string());
 }
 
 #endif
 
+std::pair<ext::optional<Image>, std::string> PNG::
+Read(std::vector<uint8_t> const &contents)
+{
+    return ReadImage(contents, [](PixelFormat const &format) {
+        return format;
+    });
+}
+
+std::pair<ext::optional<Image>, std::string> PNG::
+Read(std::vector<uint8_t> const &contents, PixelFormat::Order order, PixelFormat::Alpha alpha)
+{
+    return ReadImage(contents, [order, alpha](PixelFormat const &format) {
+        return PixelFormat(format.color(), order, alpha);
+    });
+}
+
 #include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
 #include <zlib.h>
 
+static int
+CompressionLevel(PNG::Compression compression)
+{
+    switch (compression) {
+        case PNG::Compression::None:
+            return Z_NO_COMPRESSION;
+        case PNG::Compression::Fast:
+            return Z_BEST_SPEED;
+        case PNG::Compression::Default:
+            return Z_DEFAULT_COMPRESSION;
+        case PNG::Compression::Best:
+            return Z_BEST_COMPRESSION;
+    }
+
+    abort();
+}
+
+static uint8_t
+FilterType(PNG::Filter filter)
+{
+    switch (filter) {
+        case PNG::Filter::None:
+            return 0;
+        case PNG::Filter::Sub:
+            return 1;
+        case PNG::Filter::Up:
+            return 2;
+        case PNG::Filter::Paeth:
+            return 4;
+    }
+
+    abort();
+}
+
+static uint8_t
+PaethPredictor(uint8_t a, uint8_t b, uint8_t c)
+{
+    int p = (int)a + (int)b - (int)c;
+    int pa = abs(p - (int)a);
+    int pb = abs(p - (int)b);
+    int pc = abs(p - (int)c);
+
+    if (pa <= pb && pa <= pc) {
+        return a;
+    } else if (pb <= pc) {
+        return b;
+    } else {
+        return c;
+    }
+}
+
+/*
+ * Filter one row. The previous row is null for the first row.
+ */
+static void
+FilterRow(PNG::Filter filter, uint8_t const *row, uint8_t const *previous, size_t length, size_t bytesPerPixel, uint8_t *result)
+{
+    switch (filter) {
+        case PNG::Filter::None:
+            memcpy(result, row, length);
+            break;
+        case PNG::Filter::Sub:
+            for (size_t i = 0; i < length; i++) {
+                uint8_t left = (i >= bytesPerPixel ? row[i - bytesPerPixel] : 0);
+                result[i] = row[i] - left;
+            }
+            break;
+        case PNG::Filter::Up:
+            for (size_t i = 0; i < length; i++) {
+                uint8_t up = (previous != nullptr ? previous[i] : 0);
+                result[i] = row[i] - up;
+            }
+            break;
+        case PNG::Filter::Paeth:
+            for (size_t i = 0; i < length; i++) {
+                uint8_t left = (i >= bytesPerPixel ? row[i - bytesPerPixel] : 0);
+                uint8_t up = (previous != nullptr ? previous[i] : 0);
+                uint8_t upLeft = (previous != nullptr && i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0);
+                result[i] = row[i] - PaethPredictor(left, up, upLeft);
+            }
+            break;
+    }
+}
+
 std::pair<ext::optional<std::vector<uint8_t>>, std::string> PNG::
 Write(Image const &image)
+{
+    return Write(image, Filter::None, Compression::Default);
+}
+
+std::pair<ext::optional<std::vector<uint8_t>>, std::string> PNG::
+Write(Image const &image, Filter filter, Compression compression)
 {
     std::vector<uint8_t> png;
 
@@ -459,21 +610,29 @@ Write(Image const &image)
     strm.zfree = Z_NULL;
     strm.opaque = Z_NULL;
 
-    int ret = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, 8, 15, 8, Z_DEFAULT_STRATEGY);
+    /* Filtered rows are mostly small values, which zlib has a strategy for. */
+    int strategy = (filter == Filter::None ? Z_DEFAULT_STRATEGY : Z_FILTERED);
+    int ret = deflateInit2(&strm, CompressionLevel(compression), 8, 15, 8, strategy);
     if (ret != Z_OK) {
         return std::make_pair(ext::nullopt, "deflate init failed");
     }
 
-    /* Add filter bytes between rows in the image. */
+    /* Filter each row, adding the filter type before it. */
     uint32_t filter_stride = image.width() * format.bytesPerPixel();
-    size_t filter_size = (data.size() / filter_stride);
+    size_t filter_size = image.height();
     std::vector<uint8_t> buffer = std::vector<uint8_t>(data.size() + filter_size);
     for (size_t i = 0; i < image.height(); i++) {
         size_t offset = (i * filter_stride);
         size_t filter_offset = i;
 
-        *(buffer.data() + offset + filter_offset) = 0; // filter format
-        memcpy(buffer.data() + offset + filter_offset + 1, data.data() + offset, filter_stride);
+        *(buffer.data() + offset + filter_offset) = FilterType(filter); // filter format
+        FilterRow(
+            filter,
+            data.data() + offset,
+            (i > 0 ? data.data() + offset - filter_stride : nullptr),
+            filter_stride,
+            format.bytesPerPixel(),
+            buffer.data() + offset + filter_offset + 1);
     }
 
     strm.avail_in = buffer.size();
@@ -9,6 +9,7 @@
 
 #include <graphics/Image.h>
 #include <cassert>
+#include <utility>
 
 using graphics::Image;
 
@@ -22,3 +23,13 @@ Image(size_t width, size_t height, PixelFormat format, std::vector<uint8_t> cons
     assert(data.size() == _width * _height * _format.bytesPerPixel());
 }
 
+Image::
+Image(size_t width, size_t height, PixelFormat format, std::vector<uint8_t> &&data) :
+    _width (width),
+    _height(height),
+    _format(format),
+    _data  (std::move(data))
+{
+    assert(_data.size() == _width * _height * _format.bytesPerPixel());
+}
+
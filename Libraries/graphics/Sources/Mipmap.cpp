@@ -0,0 +1,129 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <graphics/Mipmap.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+
+using graphics::Mipmap;
+using graphics::Image;
+using libutil::Parallel;
+
+size_t Mipmap::
+LevelCount(size_t width, size_t height)
+{
+    size_t levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+        levels++;
+    }
+    return levels;
+}
+
+/*
+ * Average the rows of source into one row of result. The loops are simple
+ * so the compiler can vectorize them.
+ */
+static void
+DownsampleRow(uint8_t const *row0, uint8_t const *row1, size_t sourceWidth, size_t width, size_t bytesPerPixel, uint8_t *result)
+{
+    /* Pixels with a full block; a one pixel wide row has none. */
+    size_t pairs = sourceWidth / 2;
+    if (bytesPerPixel == 4) {
+        for (size_t x = 0; x < pairs; ++x) {
+            for (size_t c = 0; c < 4; ++c) {
+                unsigned int sum =
+                    row0[x * 8 + c] + row0[x * 8 + 4 + c] +
+                    row1[x * 8 + c] + row1[x * 8 + 4 + c];
+                result[x * 4 + c] = static_cast<uint8_t>((sum + 2) >> 2);
+            }
+        }
+    } else {
+        for (size_t x = 0; x < pairs; ++x) {
+            for (size_t c = 0; c < bytesPerPixel; ++c) {
+                unsigned int sum =
+                    row0[(x * 2) * bytesPerPixel + c] + row0[(x * 2 + 1) * bytesPerPixel + c] +
+                    row1[(x * 2) * bytesPerPixel + c] + row1[(x * 2 + 1) * bytesPerPixel + c];
+                result[x * bytesPerPixel + c] = static_cast<uint8_t>((sum + 2) >> 2);
+            }
+        }
+    }
+
+    if (pairs < width) {
+        for (size_t c = 0; c < bytesPerPixel; ++c) {
+            unsigned int sum = row0[c] + row1[c];
+            result[c] = static_cast<uint8_t>((sum + 1) >> 1);
+        }
+    }
+}
+
+/*
+ * Only split images this large across threads; smaller ones finish
+ * before threads could start.
+ */
+static size_t const ParallelPixels = 512 * 512;
+static size_t const RowsPerTask = 16;
+
+Image Mipmap::
+Downsample(Image const &image)
+{
+    size_t bytesPerPixel = image.format().bytesPerPixel();
+    size_t sourceWidth = image.width();
+    size_t sourceHeight = image.height();
+    if (sourceWidth == 0 || sourceHeight == 0) {
+        return Image(0, 0, image.format(), std::vector<uint8_t>());
+    }
+
+    size_t width = std::max<size_t>(sourceWidth / 2, 1);
+    size_t height = std::max<size_t>(sourceHeight / 2, 1);
+    std::vector<uint8_t> data = std::vector<uint8_t>(width * height * bytesPerPixel);
+
+    uint8_t const *source = image.data().data();
+    size_t sourceStride = sourceWidth * bytesPerPixel;
+    size_t stride = width * bytesPerPixel;
+
+    auto rows = [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            /* A one pixel tall image averages its row with itself. */
+            size_t y0 = std::min(y * 2, sourceHeight - 1);
+            size_t y1 = std::min(y * 2 + 1, sourceHeight - 1);
+            DownsampleRow(source + y0 * sourceStride, source + y1 * sourceStride, sourceWidth, width, bytesPerPixel, data.data() + y * stride);
+        }
+    };
+
+    if (sourceWidth * sourceHeight < ParallelPixels) {
+        rows(0, height);
+    } else {
+        size_t tasks = (height + RowsPerTask - 1) / RowsPerTask;
+        Parallel::For(Parallel::DefaultJobs(), tasks, [&](size_t n) {
+            rows(n * RowsPerTask, std::min((n + 1) * RowsPerTask, height));
+        });
+    }
+
+    return Image(width, height, image.format(), std::move(data));
+}
+
+std::vector<Image> Mipmap::
+Generate(Image const &base)
+{
+    std::vector<Image> levels;
+
+    size_t count = LevelCount(base.width(), base.height());
+    if (count > 1) {
+        levels.reserve(count - 1);
+        levels.push_back(Downsample(base));
+        while (levels.size() < count - 1) {
+            levels.push_back(Downsample(levels.back()));
+        }
+    }
+
+    return levels;
+}
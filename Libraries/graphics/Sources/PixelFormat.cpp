@@ -10,6 +10,7 @@
 #include <graphics/PixelFormat.h>
 
 #include <cmath>
+#include <utility>
 #include <ext/optional>
 
 using graphics::PixelFormat;
@@ -172,16 +173,129 @@ ColorChannels(size_t *red, size_t *green, size_t *blue, PixelFormat::Color color
     }
 }
 
-std::vector<uint8_t> PixelFormat::
-Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat const &to)
+/*
+ * Where each channel is in a pixel, and what to do to the color channels.
+ */
+struct ChannelMapping {
+    size_t fromRed, fromGreen, fromBlue;
+    size_t toRed, toGreen, toBlue;
+    bool   fromAlpha;
+    size_t fromAlphaChannel;
+    bool   toAlpha;
+    size_t toAlphaChannel;
+};
+
+/*
+ * Converts pixels with the sizes and conversion known when compiled, so
+ * the compiler can unroll and vectorize the loop. Premultiplying and
+ * averaging use integer math: `(v * a + 127) / 255` and `(r + g + b + 1) / 3`
+ * round the same as the floating point math in the generic conversion,
+ * since neither can land exactly halfway between two values.
+ */
+template<size_t FromBytes, size_t ToBytes, bool Premultiply, bool Average>
+static void
+ConvertPixels(uint8_t const *from, uint8_t *to, size_t pixelCount, ChannelMapping const &mapping)
 {
-    /* Determine number of pixels. */
-    size_t fromBytesPerPixel = from.bytesPerPixel();
-    size_t pixelCount = pixels.size() / fromBytesPerPixel;
+    size_t const fromRed = mapping.fromRed, fromGreen = mapping.fromGreen, fromBlue = mapping.fromBlue;
+    size_t const toRed = mapping.toRed, toGreen = mapping.toGreen, toBlue = mapping.toBlue;
+    bool const fromAlpha = mapping.fromAlpha, toAlpha = mapping.toAlpha;
+    size_t const fromAlphaChannel = mapping.fromAlphaChannel, toAlphaChannel = mapping.toAlphaChannel;
+
+    for (size_t i = 0; i < pixelCount; ++i) {
+        uint8_t const *fromPixel = &from[i * FromBytes];
+        uint8_t *toPixel = &to[i * ToBytes];
+
+        uint32_t alpha = (fromAlpha ? fromPixel[fromAlphaChannel] : 0xFF);
+        uint32_t red = fromPixel[fromRed];
+        uint32_t green = fromPixel[fromGreen];
+        uint32_t blue = fromPixel[fromBlue];
+
+        if (Average) {
+            red = green = blue = (red + green + blue + 1) / 3;
+        }
+
+        if (Premultiply) {
+            red = (red * alpha + 127) / 255;
+            green = (green * alpha + 127) / 255;
+            blue = (blue * alpha + 127) / 255;
+        }
+
+        /* Write alpha first; grayscale writes one channel three times. */
+        if (toAlpha) {
+            toPixel[toAlphaChannel] = static_cast<uint8_t>(alpha);
+        }
+        toPixel[toRed] = static_cast<uint8_t>(red);
+        toPixel[toGreen] = static_cast<uint8_t>(green);
+        toPixel[toBlue] = static_cast<uint8_t>(blue);
+    }
+}
 
-    /* Allocate output. */
+template<size_t FromBytes, size_t ToBytes>
+static void
+ConvertPixels(uint8_t const *from, uint8_t *to, size_t pixelCount, ChannelMapping const &mapping, bool premultiply, bool average)
+{
+    if (premultiply) {
+        if (average) {
+            ConvertPixels<FromBytes, ToBytes, true, true>(from, to, pixelCount, mapping);
+        } else {
+            ConvertPixels<FromBytes, ToBytes, true, false>(from, to, pixelCount, mapping);
+        }
+    } else {
+        if (average) {
+            ConvertPixels<FromBytes, ToBytes, false, true>(from, to, pixelCount, mapping);
+        } else {
+            ConvertPixels<FromBytes, ToBytes, false, false>(from, to, pixelCount, mapping);
+        }
+    }
+}
+
+/*
+ * Converts between the common pixel sizes: RGBA to RGBA (reordering and
+ * premultiplying), RGB to RGBA, RGBA to gray and alpha, and gray to gray
+ * and alpha. Returns false for other sizes, to use the generic conversion.
+ */
+static bool
+ConvertCommonPixels(
+    uint8_t const *from,
+    size_t fromBytesPerPixel,
+    uint8_t *to,
+    size_t toBytesPerPixel,
+    size_t pixelCount,
+    ChannelMapping const &mapping,
+    bool premultiply,
+    bool average)
+{
+    switch ((fromBytesPerPixel << 4) | toBytesPerPixel) {
+        case 0x44:
+            ConvertPixels<4, 4>(from, to, pixelCount, mapping, premultiply, average);
+            return true;
+        case 0x34:
+            ConvertPixels<3, 4>(from, to, pixelCount, mapping, premultiply, average);
+            return true;
+        case 0x42:
+            ConvertPixels<4, 2>(from, to, pixelCount, mapping, premultiply, average);
+            return true;
+        case 0x22:
+            ConvertPixels<2, 2>(from, to, pixelCount, mapping, premultiply, average);
+            return true;
+        case 0x12:
+            ConvertPixels<1, 2>(from, to, pixelCount, mapping, premultiply, average);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * Converts pixels into a buffer. Each pixel is read before it is written,
+ * so the buffers can be the same if the pixel sizes are. Bytes for ignored
+ * alpha in the output are not written.
+ */
+static void
+ConvertPixels(uint8_t const *pixels, size_t pixelCount, PixelFormat const &from, PixelFormat const &to, uint8_t *result)
+{
+    size_t fromBytesPerPixel = from.bytesPerPixel();
     size_t toBytesPerPixel = to.bytesPerPixel();
-    std::vector<uint8_t> result = std::vector<uint8_t>(pixelCount * toBytesPerPixel);
 
     /* Find alpha channels. */
     ext::optional<size_t> fromAlphaChannel = AlphaChannel(from.alpha(), from.order(), from.channels());
@@ -201,6 +315,24 @@ Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat
      */
     bool toPremultiplied = (toAlphaPremultiplied || !toAlphaChannel);
 
+    /*
+     * Common conversions that don't unpremultiply have specialized loops.
+     */
+    if (!fromAlphaPremultiplied || toPremultiplied) {
+        ChannelMapping mapping = {
+            fromRed, fromGreen, fromBlue,
+            toRed, toGreen, toBlue,
+            (bool)fromAlphaChannel, fromAlphaChannel.value_or(0),
+            (bool)toAlphaChannel, toAlphaChannel.value_or(0),
+        };
+
+        bool premultiply = (!fromAlphaPremultiplied && toPremultiplied && fromAlphaChannel);
+        bool average = (from.color() == PixelFormat::Color::RGB && to.color() == PixelFormat::Color::Grayscale);
+        if (ConvertCommonPixels(pixels, fromBytesPerPixel, result, toBytesPerPixel, pixelCount, mapping, premultiply, average)) {
+            return;
+        }
+    }
+
     if (from.color() == to.color() && (bool)fromAlphaChannel == (bool)toAlphaChannel && fromAlphaPremultiplied == toPremultiplied) {
         /*
          * Fast path: not converting color formats or changing alpha.
@@ -209,39 +341,43 @@ Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat
             uint8_t const *fromPixel = &pixels[i * fromBytesPerPixel];
             uint8_t *toPixel = &result[i * toBytesPerPixel];
 
+            uint8_t red = fromPixel[fromRed];
+            uint8_t green = fromPixel[fromGreen];
+            uint8_t blue = fromPixel[fromBlue];
+
             /* Copy alpha channel. */
             if (fromAlphaChannel && toAlphaChannel) {
                 toPixel[*toAlphaChannel] = fromPixel[*fromAlphaChannel];
             }
 
             /* Copy data channels. */
-            toPixel[toRed] = fromPixel[fromRed];
-            toPixel[toGreen] = fromPixel[fromGreen];
-            toPixel[toBlue] = fromPixel[fromBlue];
+            toPixel[toRed] = red;
+            toPixel[toGreen] = green;
+            toPixel[toBlue] = blue;
         }
     } else {
         /*
          * Slow path: have to modify pixel data, either to convert color formats or adjust alpha.
          */
-        bool convertingToGrayscale = (from.color() == Color::RGB && to.color() == Color::Grayscale);
+        bool convertingToGrayscale = (from.color() == PixelFormat::Color::RGB && to.color() == PixelFormat::Color::Grayscale);
         for (size_t i = 0; i < pixelCount; ++i) {
             uint8_t const *fromPixel = &pixels[i * fromBytesPerPixel];
             uint8_t *toPixel = &result[i * toBytesPerPixel];
 
-            /* Copy alpha channel. */
+            /* Read the pixel. */
             uint8_t alpha = 0xFF;
             if (fromAlphaChannel) {
                 alpha = fromPixel[*fromAlphaChannel];
             }
-            if (toAlphaChannel) {
-                toPixel[*toAlphaChannel] = alpha;
-            }
-
-            /* Copy data channels. */
             uint8_t red = fromPixel[fromRed];
             uint8_t green = fromPixel[fromGreen];
             uint8_t blue = fromPixel[fromBlue];
 
+            /* Copy alpha channel. */
+            if (toAlphaChannel) {
+                toPixel[*toAlphaChannel] = alpha;
+            }
+
             /* If converting to grayscale, average the channels. */
             if (convertingToGrayscale) {
                 float value = ((red / 255.0) + (green / 255.0) + (blue / 255.0)) / 3.0;
@@ -253,7 +389,45 @@ Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat
             toPixel[toBlue] = Premultiply(blue, fromAlphaPremultiplied, toPremultiplied, alpha);
         }
     }
+}
+
+void PixelFormat::
+Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat const &to, std::vector<uint8_t> *result)
+{
+    size_t pixelCount = pixels.size() / from.bytesPerPixel();
+
+    /* Reuses the result's storage if it's large enough. */
+    result->assign(pixelCount * to.bytesPerPixel(), 0);
+    ConvertPixels(pixels.data(), pixelCount, from, to, result->data());
+}
 
+void PixelFormat::
+Convert(uint8_t const *pixels, size_t pixelCount, PixelFormat const &from, PixelFormat const &to, uint8_t *result)
+{
+    ConvertPixels(pixels, pixelCount, from, to, result);
+}
+
+std::vector<uint8_t> PixelFormat::
+Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat const &to)
+{
+    std::vector<uint8_t> result;
+    Convert(pixels, from, to, &result);
     return result;
 }
 
+void PixelFormat::
+ConvertInPlace(std::vector<uint8_t> *pixels, PixelFormat const &from, PixelFormat const &to)
+{
+    /*
+     * Pixels can be converted in place if they stay the same size, and any
+     * ignored alpha bytes would be zero.
+     */
+    if (from.bytesPerPixel() == to.bytesPerPixel() && to.bytesPerPixel() == to.channels()) {
+        ConvertPixels(pixels->data(), pixels->size() / from.bytesPerPixel(), from, to, pixels->data());
+    } else {
+        std::vector<uint8_t> result;
+        Convert(*pixels, from, to, &result);
+        *pixels = std::move(result);
+    }
+}
+
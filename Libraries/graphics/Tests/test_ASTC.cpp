@@ -0,0 +1,213 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <graphics/Format/ASTC.h>
+#include <graphics/Image.h>
+#include <graphics/PixelFormat.h>
+
+#include <cstdlib>
+
+using graphics::Format::ASTC;
+using graphics::Image;
+using graphics::PixelFormat;
+
+static PixelFormat const RGBA = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+
+static uint32_t
+ReadBits(uint8_t const *block, size_t offset, size_t count)
+{
+    uint32_t value = 0;
+    for (size_t n = 0; n < count; ++n) {
+        if (block[(offset + n) / 8] & (1u << ((offset + n) % 8))) {
+            value |= (1u << n);
+        }
+    }
+    return value;
+}
+
+/*
+ * Decode a block, supporting only what the encoder writes: one partition,
+ * direct RGBA endpoints, and a single plane of weights in four levels.
+ */
+static void
+DecodeBlock(uint8_t const *block, size_t dimension, uint8_t *texels)
+{
+    /* Block mode, as laid out for a 2D block with low bits set. */
+    uint32_t mode = ReadBits(block, 0, 11);
+    ASSERT_NE(0, mode & 3);
+    uint32_t A = (mode >> 5) & 3;
+    uint32_t B = (mode >> 7) & 3;
+    ASSERT_EQ(0, (mode >> 2) & 3);
+    size_t gridWidth = B + 4;
+    size_t gridHeight = A + 2;
+    uint32_t range = ((mode & 3) << 1) | ((mode >> 4) & 1);
+    ASSERT_EQ(4, range);        /* Four levels. */
+    ASSERT_EQ(0, (mode >> 9) & 3); /* Low precision, one plane. */
+
+    ASSERT_EQ(0, ReadBits(block, 11, 2));
+    ASSERT_EQ(12, ReadBits(block, 13, 4));
+
+    int v[8];
+    for (size_t n = 0; n < 8; ++n) {
+        v[n] = ReadBits(block, 17 + n * 8, 8);
+    }
+    ASSERT_GE(v[1] + v[3] + v[5], v[0] + v[2] + v[4]);
+    int e0[4] = { v[0], v[2], v[4], v[6] };
+    int e1[4] = { v[1], v[3], v[5], v[7] };
+
+    static int const unquantize[4] = { 0, 21, 43, 64 };
+    std::vector<int> grid;
+    for (size_t n = 0; n < gridWidth * gridHeight; ++n) {
+        int q = 0;
+        for (size_t b = 0; b < 2; ++b) {
+            size_t bit = 127 - (n * 2 + b);
+            if (block[bit / 8] & (1u << (bit % 8))) {
+                q |= (1 << b);
+            }
+        }
+        grid.push_back(unquantize[q]);
+    }
+
+    int ds = (1024 + static_cast<int>(dimension) / 2) / (static_cast<int>(dimension) - 1);
+    for (size_t t = 0; t < dimension; ++t) {
+        for (size_t s = 0; s < dimension; ++s) {
+            int gs = (ds * static_cast<int>(s) * static_cast<int>(gridWidth - 1) + 32) >> 6;
+            int gt = (ds * static_cast<int>(t) * static_cast<int>(gridHeight - 1) + 32) >> 6;
+            int js = gs >> 4, fs = gs & 0xF;
+            int jt = gt >> 4, ft = gt & 0xF;
+            int w11 = (fs * ft + 8) >> 4;
+            int w10 = ft - w11;
+            int w01 = fs - w11;
+            int w00 = 16 - fs - ft + w11;
+
+            auto at = [&](int x, int y) {
+                x = std::min<int>(x, gridWidth - 1);
+                y = std::min<int>(y, gridHeight - 1);
+                return grid[y * gridWidth + x];
+            };
+            int w = (at(js, jt) * w00 + at(js + 1, jt) * w01 + at(js, jt + 1) * w10 + at(js + 1, jt + 1) * w11 + 8) >> 4;
+
+            for (size_t c = 0; c < 4; ++c) {
+                int c0 = (e0[c] << 8) | e0[c];
+                int c1 = (e1[c] << 8) | e1[c];
+                int value = (c0 * (64 - w) + c1 * w + 32) >> 6;
+                texels[(t * dimension + s) * 4 + c] = static_cast<uint8_t>(value >> 8);
+            }
+        }
+    }
+}
+
+static std::vector<uint8_t>
+Decode(std::vector<uint8_t> const &blocks, size_t width, size_t height, size_t dimension)
+{
+    size_t blocksWide = (width + dimension - 1) / dimension;
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(width * height * 4);
+    std::vector<uint8_t> texels = std::vector<uint8_t>(dimension * dimension * 4);
+
+    for (size_t by = 0; by * dimension < height; ++by) {
+        for (size_t bx = 0; bx < blocksWide; ++bx) {
+            DecodeBlock(&blocks[(by * blocksWide + bx) * 16], dimension, texels.data());
+            for (size_t y = 0; y < dimension && by * dimension + y < height; ++y) {
+                for (size_t x = 0; x < dimension && bx * dimension + x < width; ++x) {
+                    memcpy(&pixels[((by * dimension + y) * width + bx * dimension + x) * 4], &texels[(y * dimension + x) * 4], 4);
+                }
+            }
+        }
+    }
+
+    return pixels;
+}
+
+static Image
+Gradient(size_t width, size_t height)
+{
+    std::vector<uint8_t> data;
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            data.push_back(static_cast<uint8_t>(x * 255 / (width - 1)));
+            data.push_back(static_cast<uint8_t>(x * 255 / (width - 1)));
+            data.push_back(200);
+            data.push_back(255);
+        }
+    }
+    return Image(width, height, RGBA, std::move(data));
+}
+
+static int
+MaximumError(std::vector<uint8_t> const &a, std::vector<uint8_t> const &b)
+{
+    int error = 0;
+    for (size_t n = 0; n < a.size(); ++n) {
+        error = std::max(error, std::abs(static_cast<int>(a[n]) - static_cast<int>(b[n])));
+    }
+    return error;
+}
+
+TEST(ASTC, Solid)
+{
+    Image image = Image(4, 4, RGBA, std::vector<uint8_t>(64, 0));
+    for (size_t n = 0; n < 16; ++n) {
+        image.data()[n * 4 + 0] = 10;
+        image.data()[n * 4 + 1] = 120;
+        image.data()[n * 4 + 2] = 250;
+        image.data()[n * 4 + 3] = 128;
+    }
+
+    std::vector<uint8_t> blocks = ASTC::Encode(image, ASTC::BlockSize::Block4x4);
+    ASSERT_EQ(16, blocks.size());
+    EXPECT_EQ(image.data(), Decode(blocks, 4, 4, 4));
+}
+
+TEST(ASTC, Gradient4x4)
+{
+    /* Not a multiple of the block size. */
+    Image image = Gradient(37, 9);
+    std::vector<uint8_t> blocks = ASTC::Encode(image, ASTC::BlockSize::Block4x4);
+    ASSERT_EQ(10 * 3 * 16, blocks.size());
+    EXPECT_LE(MaximumError(image.data(), Decode(blocks, 37, 9, 4)), 12);
+}
+
+TEST(ASTC, Gradient8x8)
+{
+    Image image = Gradient(64, 16);
+    std::vector<uint8_t> blocks = ASTC::Encode(image, ASTC::BlockSize::Block8x8);
+    ASSERT_EQ(8 * 2 * 16, blocks.size());
+    EXPECT_LE(MaximumError(image.data(), Decode(blocks, 64, 16, 8)), 12);
+}
+
+TEST(ASTC, ConvertsFormat)
+{
+    /* Reversed premultiplied input is converted first. */
+    PixelFormat bgra = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::First);
+    Image image = Image(4, 4, bgra, std::vector<uint8_t>(64, 0));
+    for (size_t n = 0; n < 16; ++n) {
+        image.data()[n * 4 + 0] = 30;
+        image.data()[n * 4 + 1] = 20;
+        image.data()[n * 4 + 2] = 10;
+        image.data()[n * 4 + 3] = 255;
+    }
+
+    std::vector<uint8_t> pixels = Decode(ASTC::Encode(image, ASTC::BlockSize::Block4x4), 4, 4, 4);
+    EXPECT_EQ(10, pixels[0]);
+    EXPECT_EQ(20, pixels[1]);
+    EXPECT_EQ(30, pixels[2]);
+    EXPECT_EQ(255, pixels[3]);
+}
+
+TEST(ASTC, Write)
+{
+    Image image = Gradient(300, 5);
+    auto result = ASTC::Write(image, ASTC::BlockSize::Block8x8);
+    ASSERT_TRUE(result.first);
+
+    std::vector<uint8_t> const &contents = *result.first;
+    ASSERT_EQ(16 + 38 * 1 * 16, contents.size());
+    EXPECT_EQ(std::vector<uint8_t>({ 0x13, 0xAB, 0xA1, 0x5C, 8, 8, 1, 44, 1, 0, 5, 0, 0, 1, 0, 0 }), std::vector<uint8_t>(contents.begin(), contents.begin() + 16));
+}
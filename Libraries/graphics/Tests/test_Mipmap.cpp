@@ -0,0 +1,99 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <graphics/Mipmap.h>
+
+using graphics::Image;
+using graphics::Mipmap;
+using graphics::PixelFormat;
+
+static PixelFormat const RGBA = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+static PixelFormat const Gray = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+
+TEST(Mipmap, LevelCount)
+{
+    EXPECT_EQ(1, Mipmap::LevelCount(1, 1));
+    EXPECT_EQ(2, Mipmap::LevelCount(2, 2));
+    EXPECT_EQ(9, Mipmap::LevelCount(256, 256));
+    EXPECT_EQ(9, Mipmap::LevelCount(256, 1));
+    EXPECT_EQ(3, Mipmap::LevelCount(5, 7));
+}
+
+TEST(Mipmap, Downsample)
+{
+    /* Each block of four averages, with rounding. */
+    Image image = Image(2, 2, RGBA, {
+        0, 10, 255, 255,   4, 10, 255, 255,
+        0, 20, 255, 0,     4, 21, 0,   0,
+    });
+
+    Image level = Mipmap::Downsample(image);
+    EXPECT_EQ(1, level.width());
+    EXPECT_EQ(1, level.height());
+    EXPECT_EQ(std::vector<uint8_t>({ 2, 15, 191, 128 }), level.data());
+}
+
+TEST(Mipmap, OddSizes)
+{
+    /* The odd last column is not included. */
+    Image wide = Image(3, 2, Gray, { 10, 20, 99, 30, 40, 99 });
+    Image level = Mipmap::Downsample(wide);
+    EXPECT_EQ(1, level.width());
+    EXPECT_EQ(1, level.height());
+    EXPECT_EQ(std::vector<uint8_t>({ 25 }), level.data());
+
+    /* A single row stays a single row. */
+    Image row = Image(4, 1, Gray, { 10, 20, 30, 41 });
+    level = Mipmap::Downsample(row);
+    EXPECT_EQ(2, level.width());
+    EXPECT_EQ(1, level.height());
+    EXPECT_EQ(std::vector<uint8_t>({ 15, 36 }), level.data());
+
+    /* And a single column. */
+    Image column = Image(1, 4, Gray, { 10, 20, 30, 41 });
+    level = Mipmap::Downsample(column);
+    EXPECT_EQ(1, level.width());
+    EXPECT_EQ(2, level.height());
+    EXPECT_EQ(std::vector<uint8_t>({ 15, 36 }), level.data());
+}
+
+TEST(Mipmap, Generate)
+{
+    /* Large enough to downsample in parallel. */
+    size_t size = 1024;
+    std::vector<uint8_t> data;
+    data.reserve(size * size * 4);
+    for (size_t y = 0; y < size; ++y) {
+        for (size_t x = 0; x < size; ++x) {
+            data.push_back(static_cast<uint8_t>(x));
+            data.push_back(static_cast<uint8_t>(y));
+            data.push_back(100);
+            data.push_back(255);
+        }
+    }
+
+    Image base = Image(size, size, RGBA, std::move(data));
+    std::vector<Image> levels = Mipmap::Generate(base);
+    ASSERT_EQ(10, levels.size());
+
+    for (size_t n = 0; n < levels.size(); ++n) {
+        EXPECT_EQ(size >> (n + 1), levels[n].width());
+        EXPECT_EQ(size >> (n + 1), levels[n].height());
+    }
+
+    /* Matches downsampling one level at a time. */
+    Image second = Mipmap::Downsample(Mipmap::Downsample(base));
+    EXPECT_EQ(second.data(), levels[1].data());
+
+    /* Constant channels stay constant. */
+    Image const &last = levels.back();
+    EXPECT_EQ(100, last.data()[2]);
+    EXPECT_EQ(255, last.data()[3]);
+}
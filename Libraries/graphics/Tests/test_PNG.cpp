@@ -137,6 +137,51 @@ TEST(PNG, Read)
     }
 }
 
+TEST(PNG, ReadConverted)
+{
+    PixelFormat::Order order = PixelFormat::Order::Reversed;
+    PixelFormat::Alpha alpha = PixelFormat::Alpha::PremultipliedFirst;
+
+    for (size_t i = 0; i < sizeof(PNGTests) / sizeof(*PNGTests); i++) {
+        auto const &test = PNGTests[i];
+        std::vector<uint8_t> png;
+        std::vector<uint8_t> pixels;
+        PixelFormat format = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+        test(&png, &pixels, &format);
+
+        /* Should read directly into the requested format. */
+        auto result = PNG::Read(png, order, alpha);
+        ASSERT_NE(result.first, ext::nullopt);
+        Image const &image = *result.first;
+        EXPECT_EQ(image.format().color(), format.color());
+        EXPECT_EQ(image.format().order(), order);
+        EXPECT_EQ(image.format().alpha(), alpha);
+
+        /* Should match converting after reading. */
+        auto native = PNG::Read(png);
+        ASSERT_NE(native.first, ext::nullopt);
+        EXPECT_EQ(image.data(), PixelFormat::Convert(native.first->data(), native.first->format(), image.format()));
+    }
+
+    /* Rows are converted separately; check a larger image. */
+    size_t width = 37;
+    size_t height = 23;
+    PixelFormat format = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(width * height * format.bytesPerPixel());
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = (i * 31 + i / 7) & 0xFF;
+    }
+
+    auto png = PNG::Write(Image(width, height, format, pixels));
+    ASSERT_NE(png.first, ext::nullopt);
+
+    auto result = PNG::Read(*png.first, order, alpha);
+    ASSERT_NE(result.first, ext::nullopt);
+    EXPECT_EQ(result.first->width(), width);
+    EXPECT_EQ(result.first->height(), height);
+    EXPECT_EQ(result.first->data(), PixelFormat::Convert(pixels, format, result.first->format()));
+}
+
 TEST(PNG, Write)
 {
     for (size_t i = 0; i < sizeof(PNGTests) / sizeof(*PNGTests); i++) {
@@ -156,3 +201,27 @@ TEST(PNG, Write)
         EXPECT_EQ(*result.first, png);
     }
 }
+
+TEST(PNG, WriteFilters)
+{
+    size_t width = 29;
+    size_t height = 17;
+    PixelFormat format = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(width * height * format.bytesPerPixel());
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = (i * 13 + i / 11) & 0xFF;
+    }
+    Image image = Image(width, height, format, pixels);
+
+    /* Every filter and compression should read back the same. */
+    for (PNG::Filter filter : { PNG::Filter::None, PNG::Filter::Sub, PNG::Filter::Up, PNG::Filter::Paeth }) {
+        for (PNG::Compression compression : { PNG::Compression::None, PNG::Compression::Fast, PNG::Compression::Default, PNG::Compression::Best }) {
+            auto result = PNG::Write(image, filter, compression);
+            ASSERT_NE(result.first, ext::nullopt);
+
+            auto read = PNG::Read(*result.first);
+            ASSERT_NE(read.first, ext::nullopt);
+            EXPECT_EQ(PixelFormat::Convert(read.first->data(), read.first->format(), format), pixels);
+        }
+    }
+}
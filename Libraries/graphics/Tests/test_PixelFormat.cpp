@@ -10,6 +10,9 @@
 #include <gtest/gtest.h>
 #include <graphics/PixelFormat.h>
 
+#include <algorithm>
+#include <cmath>
+
 using graphics::PixelFormat;
 
 TEST(PixelFormat, Properties)
@@ -98,3 +101,96 @@ TEST(PixelFormat, ConvertRearrange)
     EXPECT_EQ(PixelFormat::Convert({ 0x6A, 0x6C, 0x6E }, forward, reversed), Expected({ 0x6E, 0x6C, 0x6A }));
     EXPECT_EQ(PixelFormat::Convert({ 0x6E, 0x6C, 0x6A }, reversed, forward), Expected({ 0x6A, 0x6C, 0x6E }));
 }
+
+TEST(PixelFormat, ConvertPremultiplyAll)
+{
+    PixelFormat rgba = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    PixelFormat bgra = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+
+    /* Every value with every alpha. */
+    std::vector<uint8_t> pixels;
+    for (int alpha = 0; alpha < 256; alpha++) {
+        for (int value = 0; value < 256; value++) {
+            pixels.insert(pixels.end(), { static_cast<uint8_t>(value), static_cast<uint8_t>(255 - value), 0x00, static_cast<uint8_t>(alpha) });
+        }
+    }
+
+    /* Should round the same as premultiplying in floating point. */
+    std::vector<uint8_t> result = PixelFormat::Convert(pixels, rgba, bgra);
+    ASSERT_EQ(result.size(), pixels.size());
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        float a = (pixels[i + 3] / 255.0);
+        EXPECT_EQ(result[i + 0], 0x00);
+        EXPECT_EQ(result[i + 1], static_cast<uint8_t>(std::round(((pixels[i + 1] / 255.0) * a) * 255.0)));
+        EXPECT_EQ(result[i + 2], static_cast<uint8_t>(std::round(((pixels[i + 0] / 255.0) * a) * 255.0)));
+        EXPECT_EQ(result[i + 3], pixels[i + 3]);
+    }
+}
+
+TEST(PixelFormat, ConvertGrayscaleAll)
+{
+    PixelFormat rgba = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    PixelFormat ga = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+
+    /* Every sum of channels, with a few alphas. */
+    std::vector<uint8_t> pixels;
+    for (int alpha : { 0x00, 0x40, 0x7F, 0xFF }) {
+        for (int sum = 0; sum <= 3 * 255; sum++) {
+            int red = std::min(sum, 255);
+            int green = std::min(sum - red, 255);
+            int blue = sum - red - green;
+            pixels.insert(pixels.end(), { static_cast<uint8_t>(red), static_cast<uint8_t>(green), static_cast<uint8_t>(blue), static_cast<uint8_t>(alpha) });
+        }
+    }
+
+    /* Should round the same as averaging and premultiplying in floating point. */
+    std::vector<uint8_t> result = PixelFormat::Convert(pixels, rgba, ga);
+    ASSERT_EQ(result.size(), pixels.size() / 2);
+    for (size_t i = 0; i < pixels.size() / 4; i++) {
+        uint8_t const *pixel = &pixels[i * 4];
+        float value = ((pixel[0] / 255.0) + (pixel[1] / 255.0) + (pixel[2] / 255.0)) / 3.0;
+        uint8_t gray = std::round(value * 255.0);
+        float a = (pixel[3] / 255.0);
+        uint8_t expected = (pixel[3] == 0xFF ? gray : static_cast<uint8_t>(std::round(((gray / 255.0) * a) * 255.0)));
+        EXPECT_EQ(result[i * 2 + 0], expected);
+        EXPECT_EQ(result[i * 2 + 1], pixel[3]);
+    }
+}
+
+TEST(PixelFormat, ConvertIgnoredAlpha)
+{
+    PixelFormat ignored = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::IgnoredLast);
+    PixelFormat bgra = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+    PixelFormat rgb = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+
+    /* Ignored alpha should be treated as solid, and written as zero. */
+    EXPECT_EQ(PixelFormat::Convert({ 0x10, 0x20, 0x30, 0x40 }, ignored, bgra), Expected({ 0x30, 0x20, 0x10, 0xFF }));
+    EXPECT_EQ(PixelFormat::Convert({ 0x10, 0x20, 0x30 }, rgb, ignored), Expected({ 0x10, 0x20, 0x30, 0x00 }));
+}
+
+TEST(PixelFormat, ConvertBuffer)
+{
+    PixelFormat rgba = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    PixelFormat bgra = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+    PixelFormat rgb = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+    PixelFormat ignored = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::IgnoredLast);
+
+    /* Should reuse the result's storage, and clear ignored bytes. */
+    std::vector<uint8_t> result = { 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA };
+    uint8_t const *storage = result.data();
+    PixelFormat::Convert({ 0x10, 0x20, 0x30 }, rgb, ignored, &result);
+    EXPECT_EQ(result, Expected({ 0x10, 0x20, 0x30, 0x00 }));
+    EXPECT_EQ(result.data(), storage);
+
+    /* Should convert in place when the size doesn't change. */
+    std::vector<uint8_t> pixels = { 0x10, 0x20, 0x30, 0xFF, 0x80, 0x40, 0x00, 0x80 };
+    storage = pixels.data();
+    PixelFormat::ConvertInPlace(&pixels, rgba, bgra);
+    EXPECT_EQ(pixels, PixelFormat::Convert({ 0x10, 0x20, 0x30, 0xFF, 0x80, 0x40, 0x00, 0x80 }, rgba, bgra));
+    EXPECT_EQ(pixels.data(), storage);
+
+    /* Should still convert when the size changes. */
+    pixels = { 0x10, 0x20, 0x30 };
+    PixelFormat::ConvertInPlace(&pixels, rgb, bgra);
+    EXPECT_EQ(pixels, Expected({ 0x30, 0x20, 0x10, 0xFF }));
+}
@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <graphics/PixelFormat.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+#include <cstdlib>
+
+using graphics::PixelFormat;
+
+/*
+ * Measures the throughput of converting between pixel formats.
+ */
+static void
+Benchmark(std::string const &name, PixelFormat const &from, PixelFormat const &to, size_t pixelCount, size_t iterations)
+{
+    std::mt19937 random;
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(pixelCount * from.bytesPerPixel());
+    for (uint8_t &byte : pixels) {
+        byte = static_cast<uint8_t>(random());
+    }
+
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        std::vector<uint8_t> result = PixelFormat::Convert(pixels, from, to);
+        checksum += result[i % result.size()];
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megapixels = static_cast<double>(pixelCount * iterations) / 1e6;
+    printf("%-32s %10.1f Mpixel/s (%zu)\n", name.c_str(), megapixels / seconds, checksum);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t iterations = (argc > 1 ? std::strtoul(argv[1], NULL, 10) : 20);
+    size_t pixelCount = 1024 * 1024;
+
+    PixelFormat rgba = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    PixelFormat rgb = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+    PixelFormat bgraPremultiplied = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+    PixelFormat rgbaPremultiplied = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::PremultipliedLast);
+    PixelFormat gaPremultiplied = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+    PixelFormat ga = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+
+    Benchmark("RGBA -> premultiplied BGRA", rgba, bgraPremultiplied, pixelCount, iterations);
+    Benchmark("premultiplied RGBA -> BGRA", rgbaPremultiplied, bgraPremultiplied, pixelCount, iterations);
+    Benchmark("RGB -> premultiplied BGRA", rgb, bgraPremultiplied, pixelCount, iterations);
+    Benchmark("RGBA -> premultiplied GA", rgba, gaPremultiplied, pixelCount, iterations);
+    Benchmark("GA -> premultiplied GA", ga, gaPremultiplied, pixelCount, iterations);
+
+    /* Unpremultiplying uses the generic conversion. */
+    Benchmark("premultiplied BGRA -> RGBA", bgraPremultiplied, rgba, pixelCount, iterations);
+
+    return 0;
+}
@@ -115,6 +115,18 @@ bom_tree_reserve(struct bom_tree_context *tree, size_t count);
 void
 bom_tree_add(struct bom_tree_context *tree, const void *key, size_t key_len, const void *value, size_t value_len);
 
+struct bom_tree_bulk_entry {
+    uint32_t key_index;
+    uint32_t value_index;
+};
+
+/*
+ * Build an empty tree from keys and values already added as indexes. Entries
+ * are sorted by key, and written bottom-up into full leaves.
+ */
+void
+bom_tree_bulk_load(struct bom_tree_context *tree, struct bom_tree_bulk_entry const *entries, size_t count);
+
 
 #ifdef __cplusplus
 }
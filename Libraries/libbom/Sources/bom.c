@@ -85,11 +85,14 @@ bom_alloc_load(struct bom_context_memory memory)
 {
     struct bom_context *context = _bom_alloc(memory);
     if (context == NULL) {
-        memory.free(&memory);
+        if (memory.free != NULL) {
+            memory.free(&memory);
+        }
         return NULL;
     }
 
-    if (context->memory.size < sizeof(struct bom_header)) {
+    /* Also the case if the file couldn't be mapped. */
+    if (context->memory.data == NULL || context->memory.size < sizeof(struct bom_header)) {
         bom_free(context);
         return NULL;
     }
@@ -141,7 +144,9 @@ bom_free(struct bom_context *context)
         return;
     }
 
-    context->memory.free(&context->memory);
+    if (context->memory.free != NULL) {
+        context->memory.free(&context->memory);
+    }
     free(context);
 }
 
@@ -175,6 +180,12 @@ _bom_address_update_all(struct bom_context *context, uint32_t point, ptrdiff_t d
 static void
 _bom_address_resize(struct bom_context *context, uint32_t point, ptrdiff_t delta)
 {
+    /* Appending at the end moves nothing, so no addresses need updating. */
+    if (point == context->memory.size) {
+        context->memory.resize(&context->memory, context->memory.size + delta);
+        return;
+    }
+
     _bom_address_update_all(context, point, delta);
 
     context->memory.resize(&context->memory, context->memory.size + delta);
@@ -267,13 +278,18 @@ bom_index_add(struct bom_context *context, const void *data, size_t data_len)
     uint32_t index_point = ntohl(header->index_offset) + sizeof(struct bom_index_header) + sizeof(struct bom_index) * ntohl(index_header->count);
     size_t new_index_length = sizeof(struct bom_index_header) + sizeof(struct bom_index) * (ntohl(index_header->count) + 1);
     if (new_index_length > ntohl(header->index_length) - (sizeof(struct bom_index) * 2) ) {
-        ptrdiff_t index_delta = sizeof(struct bom_index);
+        /*
+         * Growing the index moves all the data after it, so reserve room for
+         * as many indexes again as there are, rather than just for this one.
+         */
+        size_t index_grow = ntohl(index_header->count) > 0 ? ntohl(index_header->count) : 1;
+        ptrdiff_t index_delta = sizeof(struct bom_index) * index_grow;
         _bom_address_resize(context, index_point, index_delta);
 
         /* Re-fetch, invalidated by resize. */
         header = (struct bom_header *)context->memory.data;
 
-        header->index_length = htonl(ntohl(header->index_length) + sizeof(struct bom_index));        
+        header->index_length = htonl(ntohl(header->index_length) + index_delta);
     }
 
     /* Insert data at the very end. */
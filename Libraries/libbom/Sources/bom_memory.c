@@ -20,17 +20,44 @@
 #include <unistd.h>
 #include <assert.h>
 
+/*
+ * BOMs are written by many small insertions, each resizing the memory. Grow
+ * the underlying allocation geometrically, so most resizes don't need it to
+ * move, and only the logical size changes.
+ */
+static size_t
+_bom_context_memory_capacity(size_t capacity, size_t size)
+{
+    if (size <= capacity) {
+        return capacity;
+    }
+
+    size_t grown = capacity + capacity / 2;
+    return (grown > size ? grown : size);
+}
+
+struct _bom_context_memory_malloc_context {
+    size_t capacity;
+};
+
 static void
 _bom_context_memory_realloc(struct bom_context_memory *memory, size_t size)
 {
+    struct _bom_context_memory_malloc_context *context = memory->ctx;
+
+    if (size > context->capacity) {
+        context->capacity = _bom_context_memory_capacity(context->capacity, size);
+        memory->data = realloc(memory->data, context->capacity);
+    }
+
     memory->size = size;
-    memory->data = realloc(memory->data, memory->size);
 }
 
 static void
 _bom_context_memory_free(struct bom_context_memory *memory)
 {
     free(memory->data);
+    free(memory->ctx);
 }
 
 struct bom_context_memory
@@ -44,18 +71,22 @@ bom_context_memory(void const *data, size_t size)
         memset(new, 0, size);
     }
 
+    struct _bom_context_memory_malloc_context *context = malloc(sizeof(*context));
+    context->capacity = size;
+
     return (struct bom_context_memory){
         .data = new,
         .size = size,
         .resize = _bom_context_memory_realloc,
         .free = _bom_context_memory_free,
-        .ctx = NULL,
+        .ctx = context,
     };
 }
 
 struct _bom_context_memory_mmap_context {
     int fd;
     bool writeable;
+    size_t capacity;
 };
 
 static void
@@ -63,18 +94,22 @@ _bom_context_memory_mremap(struct bom_context_memory *memory, size_t size)
 {
     struct _bom_context_memory_mmap_context *context = memory->ctx;
 
-    munmap(memory->data, memory->size);
-    if (size > memory->size) {
-        int ret = ftruncate(context->fd, size);
+    /* The file is extended to the capacity, and truncated to size when freed. */
+    if (size > context->capacity) {
+        size_t capacity = _bom_context_memory_capacity(context->capacity, size);
+
+        munmap(memory->data, context->capacity);
+        int ret = ftruncate(context->fd, capacity);
         assert(ret == 0);
         (void)ret;
+
+        int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
+        memory->data = mmap(NULL, capacity, prot, MAP_SHARED, context->fd, 0);
+        assert((intptr_t)memory->data != -1);
+        context->capacity = capacity;
     }
 
     memory->size = size;
-
-    int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
-    memory->data = mmap(NULL, size, prot, MAP_SHARED, context->fd, 0);
-    assert((intptr_t)memory->data != -1);
 }
 
 static void
@@ -82,7 +117,12 @@ _bom_context_memory_munmap(struct bom_context_memory *memory)
 {
     struct _bom_context_memory_mmap_context *context = memory->ctx;
 
-    munmap(memory->data, memory->size);
+    munmap(memory->data, context->capacity);
+    if (context->writeable && context->capacity != memory->size) {
+        int ret = ftruncate(context->fd, memory->size);
+        assert(ret == 0);
+        (void)ret;
+    }
     close(context->fd);
     free(context);
 }
@@ -120,13 +160,41 @@ bom_context_memory_file(const char *fn, bool writeable, size_t minimum_size)
         }
     }
 
+    /*
+     * Read-only files are mapped privately, so they are paged in from the
+     * file as used rather than read into memory up front.
+     */
+    int prot = writeable ? PROT_READ | PROT_WRITE : PROT_READ;
+    size_t size = st.st_size < (off_t)minimum_size ? minimum_size : st.st_size;
+
+    /*
+     * Empty files can't be mapped. New files to write into are extended to
+     * a page to map them, and truncated back to their size when freed.
+     */
+    size_t capacity = size;
+    if (writeable && capacity == 0) {
+        capacity = (size_t)sysconf(_SC_PAGESIZE);
+        if (ftruncate(fd, capacity) != 0) {
+            capacity = 0;
+        }
+    }
+
+    void *data = (capacity > 0 ? mmap(NULL, capacity, prot, (writeable ? MAP_SHARED : MAP_PRIVATE), fd, 0) : MAP_FAILED);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return (struct bom_context_memory) {
+            .data = NULL,
+            .size = 0,
+            .resize = NULL,
+            .free = NULL,
+            .ctx = NULL,
+        };
+    }
+
     struct _bom_context_memory_mmap_context *context = malloc(sizeof(*context));
     context->fd = fd;
     context->writeable = writeable;
-
-    int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
-    size_t size = st.st_size < (off_t)minimum_size ? minimum_size : st.st_size;
-    void *data = mmap(NULL, size, prot, (writeable ? MAP_SHARED : MAP_PRIVATE), context->fd, 0);
+    context->capacity = capacity;
 
     return (struct bom_context_memory) {
         .data = data,
@@ -215,9 +215,10 @@ bom_tree_add(struct bom_tree_context *tree_context, const void *key, size_t key_
     size_t paths_length;
     struct bom_tree_entry *paths = (struct bom_tree_entry *)bom_index_get(tree_context->context, paths_index, &paths_length);
 
-    if ((ntohs(paths->count) + 1) * sizeof(struct bom_tree_entry_indexes) > paths_length) {
-        /* Make room for the new index, extending the size as necessary. */
-        bom_index_append(tree_context->context, paths_index, sizeof(struct bom_tree_entry_indexes));
+    if (sizeof(struct bom_tree_entry) + (ntohs(paths->count) + 1) * sizeof(struct bom_tree_entry_indexes) > paths_length) {
+        /* Make room for the new index, doubling the size to grow less often. */
+        size_t paths_grow = ntohs(paths->count) > 0 ? ntohs(paths->count) : 1;
+        bom_index_append(tree_context->context, paths_index, sizeof(struct bom_tree_entry_indexes) * paths_grow);
 
         /* Re-fetch after append invalidation. */
         tree = (struct bom_tree *)bom_index_get(tree_context->context, tree_index, NULL);
@@ -236,3 +237,136 @@ bom_tree_add(struct bom_tree_context *tree_context, const void *key, size_t key_
     paths->count = htons(ntohs(paths->count) + 1);
 }
 
+
+struct _bom_tree_bulk_sort_entry {
+    void const *key;
+    size_t key_len;
+    struct bom_tree_bulk_entry entry;
+};
+
+static int
+_bom_tree_bulk_compare(void const *a, void const *b)
+{
+    struct _bom_tree_bulk_sort_entry const *ea = a;
+    struct _bom_tree_bulk_sort_entry const *eb = b;
+
+    size_t len = ea->key_len < eb->key_len ? ea->key_len : eb->key_len;
+    int result = memcmp(ea->key, eb->key, len);
+    if (result != 0) {
+        return result;
+    }
+
+    return (ea->key_len > eb->key_len) - (ea->key_len < eb->key_len);
+}
+
+void
+bom_tree_bulk_load(struct bom_tree_context *tree_context, struct bom_tree_bulk_entry const *entries, size_t count)
+{
+    assert(tree_context != NULL);
+    assert(entries != NULL || count == 0);
+    assert(tree_context->tree_iterating == 0);
+
+    struct bom_context *context = tree_context->context;
+    uint32_t tree_index = bom_variable_get(context, tree_context->variable_name);
+    struct bom_tree *tree = (struct bom_tree *)bom_index_get(context, tree_index, NULL);
+    uint32_t paths_index = ntohl(tree->child);
+
+    size_t paths_length;
+    struct bom_tree_entry *paths = (struct bom_tree_entry *)bom_index_get(context, paths_index, &paths_length);
+    assert(ntohs(paths->count) == 0 && "bulk load requires an empty tree");
+
+    /* Sort by key. Nothing is added while sorting, so the key pointers stay valid. */
+    struct _bom_tree_bulk_sort_entry *sorted = malloc(sizeof(*sorted) * (count > 0 ? count : 1));
+    if (sorted == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        sorted[i].key = bom_index_get(context, entries[i].key_index, &sorted[i].key_len);
+        sorted[i].entry = entries[i];
+    }
+    qsort(sorted, count, sizeof(*sorted), _bom_tree_bulk_compare);
+
+    size_t leaf_capacity = (ntohl(tree->node_size) - sizeof(struct bom_tree_entry)) / sizeof(struct bom_tree_entry_indexes);
+    size_t leaf_count = (count + leaf_capacity - 1) / leaf_capacity;
+
+    /* The root holds either every entry, or one entry per leaf; use any space already reserved. */
+    size_t root_length = sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * (leaf_count <= 1 ? count : leaf_count);
+    size_t root_append = (root_length > paths_length ? root_length - paths_length : 0);
+
+    if (leaf_count <= 1) {
+        /* Everything fits in the root leaf. */
+        if (root_append > 0) {
+            bom_index_append(context, paths_index, root_append);
+        }
+        paths = (struct bom_tree_entry *)bom_index_get(context, paths_index, NULL);
+
+        for (size_t i = 0; i < count; i++) {
+            paths->indexes[i].key_index = htonl(sorted[i].entry.key_index);
+            paths->indexes[i].value_index = htonl(sorted[i].entry.value_index);
+        }
+        paths->count = htons(count);
+    } else {
+        uint32_t *leaf_indexes = malloc(sizeof(*leaf_indexes) * leaf_count);
+        if (leaf_indexes == NULL) {
+            free(sorted);
+            return;
+        }
+
+        size_t leaf_size = sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * leaf_capacity;
+        struct bom_tree_entry *leaf = malloc(leaf_size);
+        if (leaf == NULL) {
+            free(leaf_indexes);
+            free(sorted);
+            return;
+        }
+
+        bom_index_reserve(context, leaf_count);
+
+        /* Fill each leaf completely, except perhaps the last. */
+        for (size_t l = 0; l < leaf_count; l++) {
+            size_t start = l * leaf_capacity;
+            size_t leaf_entries = (count - start < leaf_capacity ? count - start : leaf_capacity);
+
+            leaf->is_leaf = htons(1);
+            leaf->count = htons(leaf_entries);
+            leaf->forward = htonl(0);
+            leaf->backward = htonl(0);
+            for (size_t i = 0; i < leaf_entries; i++) {
+                leaf->indexes[i].key_index = htonl(sorted[start + i].entry.key_index);
+                leaf->indexes[i].value_index = htonl(sorted[start + i].entry.value_index);
+            }
+
+            leaf_indexes[l] = bom_index_add(context, leaf, sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * leaf_entries);
+        }
+        free(leaf);
+
+        /* Link the leaves in order. */
+        for (size_t l = 0; l < leaf_count; l++) {
+            leaf = (struct bom_tree_entry *)bom_index_get(context, leaf_indexes[l], NULL);
+            leaf->backward = htonl(l > 0 ? leaf_indexes[l - 1] : 0);
+            leaf->forward = htonl(l + 1 < leaf_count ? leaf_indexes[l + 1] : 0);
+        }
+
+        /* The root refers to each leaf, keyed by the leaf's last key. */
+        if (root_append > 0) {
+            bom_index_append(context, paths_index, root_append);
+        }
+        paths = (struct bom_tree_entry *)bom_index_get(context, paths_index, NULL);
+        paths->is_leaf = htons(0);
+        paths->count = htons(leaf_count - 1);
+        for (size_t l = 0; l < leaf_count; l++) {
+            size_t last = (l + 1) * leaf_capacity < count ? (l + 1) * leaf_capacity - 1 : count - 1;
+            paths->indexes[l].key_index = htonl(sorted[last].entry.key_index);
+            paths->indexes[l].value_index = htonl(leaf_indexes[l]);
+        }
+
+        free(leaf_indexes);
+    }
+
+    /* Re-fetch, invalidated by adding leaves. */
+    tree = (struct bom_tree *)bom_index_get(context, tree_index, NULL);
+    tree->path_count = htonl(count);
+
+    free(sorted);
+}
@@ -10,11 +10,12 @@
 #include <bom/bom.h>
 #include <libutil/Options.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <sstream>
-#include <iomanip>
+
+#include <cstdio>
 
 #include <arpa/inet.h>
 
@@ -356,10 +357,22 @@ main(int argc, char **argv)
      * Iterate contents of the tree and print it out.
      */
 
-    /* Store file pointers to their parent information. */
+    /* Buffer output in large blocks; listings can have millions of lines. */
+    static char buffer[1 << 20];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+    /*
+     * Store each entry's name and parent. Directories also keep their path,
+     * so their children are found without walking up to the root. Paths are
+     * relative to the first ancestor not yet seen, in case a child comes
+     * before its parent; they are extended if that ancestor appears later.
+     */
     struct file_info {
         uint32_t parent;
         std::string name;
+        bool resolved;
+        std::string path;
+        uint32_t unresolved;
     };
     std::unordered_map<uint32_t, struct file_info> files;
 
@@ -369,16 +382,19 @@ main(int argc, char **argv)
         bool includeAll;
         struct bom_context *bom;
         std::unordered_map<uint32_t, struct file_info> *files;
+        std::string line;
     } context = {
         &options,
         includeAll,
         bom.get(),
         &files,
+        std::string(),
     };
 
     bom_tree_iterate(tree.get(), [](struct bom_tree_context *tree, void *key, size_t key_len, void *value, size_t value_len, void *ctx) {
         struct iteration_context *context = reinterpret_cast<struct iteration_context *>(ctx);
         Options const *options = context->options;
+        std::unordered_map<uint32_t, struct file_info> *files = context->files;
 
         /*
          * Collect information about this entry.
@@ -389,9 +405,9 @@ main(int argc, char **argv)
         /*
          * Store file information for computing full path.
          */
-        struct file_info info = { file_key->parent, std::string(file_key->name) };
+        struct file_info info = { file_key->parent, std::string(file_key->name), false, std::string(), 0 };
         uint32_t path_info_1_value_id = path_info_1_value->id;
-        context->files->insert({ path_info_1_value_id, info });
+        struct file_info *entry = &files->insert({ path_info_1_value_id, info }).first->second;
 
         /*
          * Extract the secondary information for the file. This information is structured differently
@@ -404,6 +420,33 @@ main(int argc, char **argv)
             return;
         }
 
+        /*
+         * Resolve the path of an entry from its parent's, extending any path
+         * stored before an ancestor was seen.
+         */
+        std::function<struct file_info *(struct file_info *)> resolve = [files, &resolve](struct file_info *info) -> struct file_info * {
+            if (!info->resolved) {
+                info->resolved = true;
+                info->path = info->name;
+                info->unresolved = info->parent;
+            }
+
+            for (auto it = files->find(info->unresolved); it != files->end(); it = files->find(info->unresolved)) {
+                struct file_info *parent = resolve(&it->second);
+                info->path = parent->path + "/" + info->path;
+                info->unresolved = parent->unresolved;
+            }
+
+            return info;
+        };
+
+        /*
+         * Only directories keep their path, as only they have children.
+         */
+        if (path_info_2_value->type == bom_path_type_directory) {
+            resolve(entry);
+        }
+
         /*
          * Filter by included file type.
          */
@@ -439,35 +482,37 @@ main(int argc, char **argv)
         /*
          * Load full file path.
          */
-        std::string path = std::string(file_key->name);
-        uint32_t next_index = file_key->parent;
-        for (auto it = context->files->find(next_index); it != context->files->end(); it = context->files->find(next_index)) {
-            path = it->second.name + "/" + path;
-            next_index = it->second.parent;
+        std::string &line = context->line;
+        if (entry->resolved) {
+            line = entry->path;
+        } else {
+            auto it = files->find(entry->parent);
+            if (it != files->end()) {
+                line = resolve(&it->second)->path;
+                line += '/';
+                line += entry->name;
+            } else {
+                line = entry->name;
+            }
         }
 
         /*
          * Print out requested details.
          */
-        if (options->onlyPath()) {
-            printf("%s\n", path.c_str());
-        } else {
+        if (!options->onlyPath()) {
             // TODO: Respect options about what to print.
-            std::stringstream stream;
-            stream << std::oct << ntohs(path_info_2_value->mode);
-            std::string mode = stream.str();
-            std::string UID = std::to_string(ntohl(path_info_2_value->user));
-            std::string GID = std::to_string(ntohl(path_info_2_value->group));
-            printf("%s\t%s\t%s/%s", path.c_str(), mode.c_str(), UID.c_str(), GID.c_str());
-            
+            char details[64];
+            snprintf(details, sizeof(details), "\t%o\t%u/%u", ntohs(path_info_2_value->mode), ntohl(path_info_2_value->user), ntohl(path_info_2_value->group));
+            line += details;
+
             if (path_info_2_value->type == bom_path_type_file) {
-                std::string size = std::to_string(ntohl(path_info_2_value->size));
-                std::string checksum = std::to_string(ntohl(path_info_2_value->checksum));
-                printf("\t%s\t%s", size.c_str(), checksum.c_str());
+                snprintf(details, sizeof(details), "\t%u\t%u", ntohl(path_info_2_value->size), ntohl(path_info_2_value->checksum));
+                line += details;
             }
-            
-            printf("\n");
         }
+
+        line += '\n';
+        fwrite(line.data(), 1, line.size(), stdout);
     }, reinterpret_cast<void *>(&context));
 
     return 0;
@@ -14,6 +14,9 @@
 #include <car/car_format.h>
 #include <ext/optional>
 
+#include <array>
+#include <bitset>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -34,7 +37,14 @@ namespace car {
  */
 class AttributeList {
 private:
-    std::unordered_map<enum car_attribute_identifier, uint16_t> _values;
+    /*
+     * The known identifiers are few and numbered densely, so their values
+     * are indexed directly by identifier, with a bit for each one present.
+     * Any other identifiers are kept in order after them.
+     */
+    std::bitset<_car_attribute_identifier_count>                    _present;
+    std::array<uint16_t, _car_attribute_identifier_count>           _values;
+    std::vector<std::pair<enum car_attribute_identifier, uint16_t>> _other;
 
 public:
     AttributeList(std::unordered_map<enum car_attribute_identifier, uint16_t> const &values);
@@ -51,12 +61,17 @@ public:
     void set(enum car_attribute_identifier identifier, uint16_t value);
 
     /*
-     * Iterate over the contents of the attribute list. Unordered.
+     * Iterate over the contents of the attribute list, in identifier order.
      */
     template<typename T>
     void iterate(T iterator) const
     {
-        for (auto const &entry : _values) {
+        for (size_t identifier = 0; identifier < _present.size(); ++identifier) {
+            if (_present.test(identifier)) {
+                iterator((enum car_attribute_identifier)identifier, _values[identifier]);
+            }
+        }
+        for (auto const &entry : _other) {
             iterator(entry.first, entry.second);
         }
     }
@@ -27,6 +27,11 @@ class Rendition;
 
 /*
  * An archive within a BOM file holding facets and their renditions.
+ *
+ * Facets and renditions are indexed when the archive is loaded, and are
+ * not modified after. Iterating them, looking them up, and reading the
+ * data of the renditions found can happen on several threads at once. The
+ * fast iteration functions walk the BOM itself and are not thread-safe.
  */
 class Reader {
 public:
@@ -34,18 +39,21 @@ public:
     typedef std::unique_ptr<struct bom_tree_context, decltype(&bom_tree_free)> unique_ptr_bom_tree;
 
 private:
-    typedef struct {
-        void *key;
-        size_t key_len;
-        void *value;
-        size_t value_len;
-    } KeyValuePair;
+    /*
+     * A rendition's attributes, decoded from its key once when the archive
+     * is loaded, and its value in the BOM.
+     */
+    struct RenditionEntry {
+        AttributeList                attributes;
+        struct car_rendition_value *value;
+    };
 
 private:
-    unique_ptr_bom                                  _bom;
-    ext::optional<struct car_key_format *>          _keyfmt;
-    std::unordered_map<std::string, void *>         _facetValues;
-    std::unordered_multimap<uint16_t, KeyValuePair> _renditionValues;
+    unique_ptr_bom                                            _bom;
+    ext::optional<struct car_key_format *>                    _keyfmt;
+    std::unordered_map<std::string, void *>                   _facetValues;
+    std::unordered_map<uint16_t, std::vector<RenditionEntry>> _renditionValues;
+    size_t                                                    _renditionCount;
 
 private:
     Reader(unique_ptr_bom bom);
@@ -77,7 +85,7 @@ public:
      * The number of Renditions read
      */
      int renditionCount() const
-     { return _renditionValues.size(); }
+     { return _renditionCount; }
 
 public:
     /*
@@ -101,6 +109,14 @@ public:
      */
     std::vector<car::Rendition> lookupRenditions(Facet const &) const;
 
+    /*
+     * Lookup the Rendition for a Facet best matching a set of attributes,
+     * such as scale, idiom, or size class. Each attribute must either match
+     * or have the universal value (zero) in the rendition; renditions with
+     * more exact matches are preferred.
+     */
+    ext::optional<car::Rendition> lookupRendition(Facet const &, AttributeList const &attributes) const;
+
 public:
     /*
      * Print debug information about the archive.
@@ -15,6 +15,7 @@
 
 #include <string>
 #include <functional>
+#include <utility>
 
 namespace car {
 
@@ -56,7 +57,7 @@ public:
         Format               _format;
 
     public:
-        Data(std::vector<uint8_t> const &data, Format format);
+        Data(std::vector<uint8_t> data, Format format);
 
     public:
         /*
@@ -86,6 +87,29 @@ public:
         HorizontalScaleVerticalUniform,
     };
 
+public:
+    /*
+     * How much to compress pixel data when written.
+     */
+    enum class Compression {
+        /*
+         * Store the pixel data without compressing it.
+         */
+        None,
+        /*
+         * Compress quickly, at the cost of size.
+         */
+        Fast,
+        /*
+         * Balance speed and size.
+         */
+        Default,
+        /*
+         * Compress as small as possible, at the cost of speed.
+         */
+        Best,
+    };
+
 public:
     struct Slice {
         uint32_t x;
@@ -100,6 +124,7 @@ private:
 private:
     std::function<ext::optional<Data>(Rendition const *)> _deferredData;
     ext::optional<Data> _data;
+    struct car_rendition_value const *_value;
 
 private:
     std::string                     _fileName;
@@ -113,10 +138,11 @@ private:
     std::vector<Slice>              _slices;
     enum car_rendition_value_layout _layout;
     ext::optional<std::string>      _UTI;
+    Compression                     _compression;
 
 private:
     Rendition(AttributeList const &attributes, std::function<ext::optional<Data>(Rendition const *)> const &data);
-    Rendition(AttributeList const &attributes, ext::optional<Data> const &data);
+    Rendition(AttributeList const &attributes, ext::optional<Data> data);
 
 public:
     /*
@@ -217,12 +243,34 @@ public:
     std::vector<Slice> &slices()
     { return _slices; }
 
+public:
+    /*
+     * How much to compress the pixel data when written.
+     */
+    Compression compression() const
+    { return _compression; }
+    Compression &compression()
+    { return _compression; }
+
 public:
     /*
      * The rendition pixel data. May incur expensive decoding.
      */
     ext::optional<Data> data() const;
 
+    /*
+     * The format of the rendition pixel data, without decoding it.
+     */
+    ext::optional<Data::Format> dataFormat() const;
+
+    /*
+     * The rendition data as stored in the archive, without decoding or
+     * copying it: the compressed pixels, or the contents of JPEG and raw
+     * data. Only available for loaded renditions, and only valid while
+     * the archive they were loaded from is.
+     */
+    ext::optional<std::pair<uint8_t const *, size_t>> encodedData() const;
+
 public:
     /*
      * Serialize the rendition for writing to a file.
@@ -253,7 +301,7 @@ public:
 
     static Rendition Create(
         AttributeList const &attributes,
-        ext::optional<Data> const &data);
+        ext::optional<Data> data);
 };
 
 }
@@ -45,6 +45,7 @@ private:
     std::unordered_map<std::string, Facet> _facets;
     std::unordered_multimap<uint16_t, Rendition> _renditions;
     std::vector<KeyValuePair> _rawRenditions;
+    std::vector<std::pair<AttributeList, std::vector<uint8_t>>> _encodedRenditions;
 
 private:
     Writer(unique_ptr_bom bom);
@@ -72,6 +73,11 @@ public:
      */
     void addRendition(void *key, size_t keyLength, void *value, size_t valueLength);
 
+    /*
+     * Add a rendition for a facet, already serialized by `Rendition::write()`.
+     */
+    void addRendition(AttributeList const &attributes, std::vector<uint8_t> const &value);
+
     /*
      * The key format, optional and determined automatically if omitted.
      */
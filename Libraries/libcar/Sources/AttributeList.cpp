@@ -9,20 +9,34 @@
 
 #include <car/AttributeList.h>
 
+#include <algorithm>
+
 using car::AttributeList;
 
 AttributeList::
 AttributeList(std::unordered_map<enum car_attribute_identifier, uint16_t> const &values) :
-    _values(values)
+    _values()
 {
+    for (auto const &entry : values) {
+        set(entry.first, entry.second);
+    }
 }
 
 ext::optional<uint16_t> AttributeList::
 get(enum car_attribute_identifier identifier) const
 {
-    auto it = _values.find(identifier);
-    if (it != _values.end()) {
-        return it->second;
+    if ((size_t)identifier < _present.size()) {
+        if (_present.test(identifier)) {
+            return _values[identifier];
+        }
+
+        return ext::nullopt;
+    }
+
+    for (auto const &entry : _other) {
+        if (entry.first == identifier) {
+            return entry.second;
+        }
     }
 
     return ext::nullopt;
@@ -31,49 +45,64 @@ get(enum car_attribute_identifier identifier) const
 void AttributeList::
 set(enum car_attribute_identifier identifier, uint16_t value)
 {
-    _values[identifier] = value;
+    if ((size_t)identifier < _present.size()) {
+        _present.set(identifier);
+        _values[identifier] = value;
+        return;
+    }
+
+    auto it = std::lower_bound(_other.begin(), _other.end(), identifier, [](std::pair<enum car_attribute_identifier, uint16_t> const &entry, enum car_attribute_identifier identifier) {
+        return entry.first < identifier;
+    });
+    if (it != _other.end() && it->first == identifier) {
+        it->second = value;
+    } else {
+        _other.insert(it, { identifier, value });
+    }
 }
 
 size_t AttributeList::
 count() const
 {
-    return _values.size();
+    return _present.count() + _other.size();
 }
 
 void AttributeList::
 dump() const
 {
-    for (auto const &entry : _values) {
-        enum car_attribute_identifier identifier = entry.first;
-        uint16_t value = entry.second;
-
+    iterate([](enum car_attribute_identifier identifier, uint16_t value) {
         if (identifier < sizeof(car_attribute_identifier_names) / sizeof(*car_attribute_identifier_names)) {
             printf("[%02d] %-24s = %-6d | %-4x\n", identifier, car_attribute_identifier_names[identifier] ?: "(unknown)", value, value);
         } else {
             printf("[%02d] %-24s = %-6d | %-4x\n", identifier, "(unknown)", value, value);
         }
-    }
+    });
 }
 
 AttributeList AttributeList::
 Load(size_t count, uint32_t const *identifiers, uint16_t const *values)
 {
-    std::unordered_map<enum car_attribute_identifier, uint16_t> attributes;
+    AttributeList attributes = AttributeList({ });
     for (size_t i = 0; i < count; ++i) {
-        attributes.insert({ (enum car_attribute_identifier)identifiers[i], values[i] });
+        /* The first value for an identifier is kept. */
+        if (!attributes.get((enum car_attribute_identifier)identifiers[i])) {
+            attributes.set((enum car_attribute_identifier)identifiers[i], values[i]);
+        }
     }
-    return AttributeList(attributes);
+    return attributes;
 }
 
 AttributeList AttributeList::
 Load(size_t count, struct car_attribute_pair const *pairs)
 {
-    std::unordered_map<enum car_attribute_identifier, uint16_t> attributes;
+    AttributeList attributes = AttributeList({ });
     for (size_t i = 0; i < count; ++i) {
         uint16_t value = pairs[i].value;
-        attributes.insert({ (enum car_attribute_identifier)pairs[i].identifier, value });
+        if (!attributes.get((enum car_attribute_identifier)pairs[i].identifier)) {
+            attributes.set((enum car_attribute_identifier)pairs[i].identifier, value);
+        }
     }
-    return AttributeList(attributes);
+    return attributes;
 }
 
 std::vector<uint8_t> AttributeList::
@@ -81,16 +110,9 @@ write(size_t count, uint32_t const *identifiers) const
 {
     std::vector<uint8_t> output = std::vector<uint8_t>(sizeof(uint16_t) * count);
     uint16_t *values = reinterpret_cast<uint16_t *>(output.data());
-    std::unordered_map<enum car_attribute_identifier, uint16_t> attributes;
     for (size_t i = 0; i < count; ++i) {
         enum car_attribute_identifier identifier = (enum car_attribute_identifier) identifiers[i];
-        auto result = _values.find(identifier);
-        if (result != _values.end()) {
-            values[i] = result->second;
-        } else {
-            values[i] = 0;
-        }
+        values[i] = get(identifier).value_or(0);
     }
     return output;
 }
-
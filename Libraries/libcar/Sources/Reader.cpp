@@ -28,7 +28,8 @@ Reader(unique_ptr_bom bom) :
     _bom(std::move(bom)),
     _keyfmt(ext::nullopt),
     _facetValues({ }),
-    _renditionValues({ })
+    _renditionValues({ }),
+    _renditionCount(0)
 {
 }
 
@@ -81,14 +82,11 @@ facetFastIterate(std::function<void(void *key, size_t key_len, void *value, size
 void Reader::
 renditionIterate(std::function<void(Rendition const &)> const &iterator) const
 {
-    auto keyfmt = *_keyfmt;
     for (const auto &it : _renditionValues) {
-        KeyValuePair kv = (KeyValuePair)it.second;
-        car_rendition_key *rendition_key = (car_rendition_key *)kv.key;
-        struct car_rendition_value *rendition_value = (struct car_rendition_value *)kv.value;
-        AttributeList attributes = AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
-        Rendition rendition = Rendition::Load(attributes, rendition_value);
-        iterator(rendition);
+        for (RenditionEntry const &entry : it.second) {
+            Rendition rendition = Rendition::Load(entry.attributes, entry.value);
+            iterator(rendition);
+        }
     }
 }
 
@@ -215,15 +213,15 @@ Load(unique_ptr_bom bom)
         }
     }
 
-    /* Iterate through the renditions as fast as possible. Save the key and value pointers, indexed by the Facet identifier. */
-    reader.renditionFastIterate([identifier_index,&reader](void *key, size_t key_len, void *value, size_t value_len) {
-        KeyValuePair kv;
-        kv.key = key;
-        kv.key_len = key_len;
-        kv.value = value;
-        kv.value_len = value_len;
+    /*
+     * Iterate through the renditions, indexed by the Facet identifier. Decode
+     * each key here, so lookups can compare attributes without decoding.
+     */
+    reader.renditionFastIterate([identifier_index, keyfmt, &reader](void *key, size_t key_len, void *value, size_t value_len) {
         car_rendition_key *rendition_key = (car_rendition_key *)key;
-        reader._renditionValues.insert({ rendition_key[identifier_index], kv });
+        AttributeList attributes = AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
+        reader._renditionValues[rendition_key[identifier_index]].push_back({ attributes, (struct car_rendition_value *)value });
+        reader._renditionCount++;
     });
 
     return std::move(reader);
@@ -262,16 +260,55 @@ lookupRenditions(Facet const &facet) const
         return result;
     }
 
-    auto keyfmt = *_keyfmt;
-    auto lookupRendition = _renditionValues.equal_range(*facet_identifier);
-    for (auto it = lookupRendition.first; it != lookupRendition.second; ++it) {
-        KeyValuePair value = (KeyValuePair)it->second;
-        car_rendition_key *rendition_key = (car_rendition_key *)value.key;
-        struct car_rendition_value *rendition_value = (struct car_rendition_value *)value.value;
-        AttributeList attributes = AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
-        Rendition rendition = Rendition::Load(attributes, rendition_value);
-        result.push_back(rendition);
+    auto lookup = _renditionValues.find(*facet_identifier);
+    if (lookup == _renditionValues.end()) {
+        return result;
+    }
+
+    for (RenditionEntry const &entry : lookup->second) {
+        result.push_back(Rendition::Load(entry.attributes, entry.value));
     }
     return result;
 }
 
+ext::optional<Rendition> Reader::
+lookupRendition(Facet const &facet, AttributeList const &attributes) const
+{
+    ext::optional<uint16_t> facet_identifier = facet.attributes().get(car_attribute_identifier_identifier);
+    if (!facet_identifier) {
+        return ext::nullopt;
+    }
+
+    auto lookup = _renditionValues.find(*facet_identifier);
+    if (lookup == _renditionValues.end()) {
+        return ext::nullopt;
+    }
+
+    RenditionEntry const *best = nullptr;
+    size_t best_matches = 0;
+    for (RenditionEntry const &entry : lookup->second) {
+        bool compatible = true;
+        size_t matches = 0;
+
+        attributes.iterate([&](enum car_attribute_identifier identifier, uint16_t value) {
+            uint16_t rendition_value = entry.attributes.get(identifier).value_or(0);
+            if (rendition_value == value) {
+                matches++;
+            } else if (rendition_value != 0) {
+                compatible = false;
+            }
+        });
+
+        if (compatible && (best == nullptr || matches > best_matches)) {
+            best = &entry;
+            best_matches = matches;
+        }
+    }
+
+    if (best == nullptr) {
+        return ext::nullopt;
+    }
+
+    return Rendition::Load(best->attributes, best->value);
+}
+
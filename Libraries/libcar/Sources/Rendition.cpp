@@ -10,10 +10,13 @@
 #include <car/Rendition.h>
 #include <car/Reader.h>
 #include <car/car_format.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cstdio>
+#include <utility>
 
 #include <zlib.h>
 
@@ -31,10 +34,11 @@
 #endif
 
 using car::Rendition;
+using libutil::Parallel;
 
 Rendition::Data::
-Data(std::vector<uint8_t> const &data, Format format) :
-    _data  (data),
+Data(std::vector<uint8_t> data, Format format) :
+    _data  (std::move(data)),
     _format(format)
 {
 }
@@ -59,25 +63,33 @@ Rendition::
 Rendition(AttributeList const &attributes, std::function<ext::optional<Data>(Rendition const *)> const &data) :
     _attributes  (attributes),
     _deferredData(data),
+    _value       (nullptr),
     _width       (0),
     _height      (0),
     _scale       (1.0),
     _isVector    (false),
     _isOpaque    (false),
-    _isResizable (false)
+    _isResizable (false),
+    _resizeMode  (ResizeMode::FixedSize),
+    _layout      (car_rendition_value_layout_one_part_fixed_size),
+    _compression (Compression::Default)
 {
 }
 
 Rendition::
-Rendition(AttributeList const &attributes, ext::optional<Data> const &data) :
+Rendition(AttributeList const &attributes, ext::optional<Data> data) :
     _attributes (attributes),
-    _data       (data),
+    _data       (std::move(data)),
+    _value      (nullptr),
     _width      (0),
     _height     (0),
     _scale      (1.0),
     _isVector   (false),
     _isOpaque   (false),
-    _isResizable(false)
+    _isResizable(false),
+    _resizeMode (ResizeMode::FixedSize),
+    _layout     (car_rendition_value_layout_one_part_fixed_size),
+    _compression(Compression::Default)
 {
 }
 
@@ -123,8 +135,10 @@ dump() const
     _attributes.dump();
 }
 
+static ext::optional<Rendition::Data::Format> DecodeFormat(struct car_rendition_value const *value);
+static ext::optional<std::pair<uint8_t const *, size_t>> DecodePayload(struct car_rendition_value const *value);
 static ext::optional<Rendition::Data> Decode(struct car_rendition_value *value);
-static ext::optional<std::vector<uint8_t>> Encode(Rendition const *rendition, ext::optional<Rendition::Data> data);
+static ext::optional<std::vector<uint8_t>> Encode(Rendition const *rendition, ext::optional<Rendition::Data> const &data);
 
 
 static Rendition::ResizeMode
@@ -172,6 +186,7 @@ Load(
     Rendition rendition = Rendition(attributes, [value](Rendition const *rendition) -> ext::optional<Data> {
         return Decode(value);
     });
+    rendition._value = value;
 
     for (struct car_rendition_info_header *info_header = (struct car_rendition_info_header *)value->info;
         ((uintptr_t)info_header - (uintptr_t)value->info) < value->info_len;
@@ -275,38 +290,108 @@ data() const
     return ext::nullopt;
 }
 
-static ext::optional<Rendition::Data>
-Decode(struct car_rendition_value *value)
+ext::optional<Rendition::Data::Format> Rendition::
+dataFormat() const
+{
+    if (_data) {
+        return _data->format();
+    }
+
+    if (_value != nullptr) {
+        return DecodeFormat(_value);
+    }
+
+    /* Created with deferred data: the only way to know is to create it. */
+    ext::optional<Data> data = this->data();
+    if (data) {
+        return data->format();
+    }
+
+    return ext::nullopt;
+}
+
+ext::optional<std::pair<uint8_t const *, size_t>> Rendition::
+encodedData() const
+{
+    if (_data || _value == nullptr) {
+        return ext::nullopt;
+    }
+
+    return DecodePayload(_value);
+}
+
+static ext::optional<Rendition::Data::Format>
+DecodeFormat(struct car_rendition_value const *value)
 {
     if (strncmp(value->magic, "ISTC", 4) != 0) {
         return ext::nullopt;
     }
 
-    Rendition::Data::Format format;
     if (value->pixel_format == car_rendition_value_pixel_format_argb) {
-        format = Rendition::Data::Format::PremultipliedBGRA8;
+        return Rendition::Data::Format::PremultipliedBGRA8;
     } else if (value->pixel_format == car_rendition_value_pixel_format_ga8) {
-        format = Rendition::Data::Format::PremultipliedGA8;
+        return Rendition::Data::Format::PremultipliedGA8;
     } else if (value->pixel_format == car_rendition_value_pixel_format_raw_data) {
-        format = Rendition::Data::Format::Data;
+        return Rendition::Data::Format::Data;
     } else if (value->pixel_format == car_rendition_value_pixel_format_jpeg) {
-        format = Rendition::Data::Format::JPEG;
+        return Rendition::Data::Format::JPEG;
     } else {
         fprintf(stderr, "error: unsupported pixel format %.4s\n", (char const *)&value->pixel_format);
         return ext::nullopt;
     }
+}
+
+/*
+ * The data following the info section, in place: the contents of JPEG and raw
+ * data, or the compressed pixels including their header.
+ */
+static ext::optional<std::pair<uint8_t const *, size_t>>
+DecodePayload(struct car_rendition_value const *value)
+{
+    ext::optional<Rendition::Data::Format> format = DecodeFormat(value);
+    if (!format) {
+        return ext::nullopt;
+    }
+
+    uintptr_t payload = (uintptr_t)value + sizeof(struct car_rendition_value) + value->info_len;
 
     /* JPEG format embeds the file within another header. */
-    if (format == Rendition::Data::Format::JPEG || format == Rendition::Data::Format::Data) {
-        struct car_rendition_data_header_raw *header_raw = (struct car_rendition_data_header_raw *)((uintptr_t)value + sizeof(struct car_rendition_value) + value->info_len);
+    if (*format == Rendition::Data::Format::JPEG || *format == Rendition::Data::Format::Data) {
+        struct car_rendition_data_header_raw const *header_raw = (struct car_rendition_data_header_raw const *)payload;
         if (strncmp(header_raw->magic, "DWAR", sizeof(header_raw->magic)) != 0) {
             fprintf(stderr, "error: raw data header magic is wrong, can't possibly decode\n");
             return ext::nullopt;
         }
 
-        std::vector<uint8_t> contents = std::vector<uint8_t>(header_raw->data, header_raw->data + header_raw->length);
-        Rendition::Data data = Rendition::Data(contents, format);
-        return data;
+        return std::make_pair(static_cast<uint8_t const *>(header_raw->data), static_cast<size_t>(header_raw->length));
+    }
+
+    struct car_rendition_data_header1 const *header1 = (struct car_rendition_data_header1 const *)payload;
+    if (strncmp(header1->magic, "MLEC", sizeof(header1->magic)) != 0) {
+        fprintf(stderr, "error: header1 magic is wrong (%.4s), can't possibly decode\n", header1->magic);
+        return ext::nullopt;
+    }
+
+    return std::make_pair(reinterpret_cast<uint8_t const *>(header1), sizeof(struct car_rendition_data_header1) + header1->length);
+}
+
+static ext::optional<Rendition::Data>
+Decode(struct car_rendition_value *value)
+{
+    ext::optional<Rendition::Data::Format> decodedFormat = DecodeFormat(value);
+    if (!decodedFormat) {
+        return ext::nullopt;
+    }
+    Rendition::Data::Format format = *decodedFormat;
+
+    if (format == Rendition::Data::Format::JPEG || format == Rendition::Data::Format::Data) {
+        ext::optional<std::pair<uint8_t const *, size_t>> payload = DecodePayload(value);
+        if (!payload) {
+            return ext::nullopt;
+        }
+
+        std::vector<uint8_t> contents = std::vector<uint8_t>(payload->first, payload->first + payload->second);
+        return Rendition::Data(std::move(contents), format);
     }
 
     size_t bytes_per_pixel = Rendition::Data::FormatSize(format);
@@ -355,8 +440,8 @@ Decode(struct car_rendition_value *value)
                return ext::nullopt;
             }
 
-            strm.avail_out = uncompressed_length;
-            strm.next_out = (Bytef *)uncompressed_data;
+            strm.avail_out = uncompressed_length - offset;
+            strm.next_out = (Bytef *)uncompressed_data + offset;
 
             ret = inflate(&strm, Z_NO_FLUSH);
             if (ret != Z_OK && ret != Z_STREAM_END) {
@@ -369,7 +454,14 @@ Decode(struct car_rendition_value *value)
                 return ext::nullopt;
             }
 
-            offset += (uncompressed_length - strm.avail_out);
+            size_t decompressed_length = (uncompressed_length - offset - strm.avail_out);
+            if (decompressed_length == 0) {
+                fprintf(stderr, "error: decompression made no progress\n");
+                return ext::nullopt;
+            }
+
+            offset += decompressed_length;
+            compressed_data = (void *)((uintptr_t)compressed_data + compressed_length);
         } else if (header1->compression == car_rendition_data_compression_magic_rle) {
             fprintf(stderr, "error: unable to handle RLE\n");
             return ext::nullopt;
@@ -413,8 +505,67 @@ Decode(struct car_rendition_value *value)
     return data;
 }
 
+static int
+CompressionLevel(Rendition::Compression compression)
+{
+    switch (compression) {
+        case Rendition::Compression::None:
+            return Z_NO_COMPRESSION;
+        case Rendition::Compression::Fast:
+            return Z_BEST_SPEED;
+        case Rendition::Compression::Default:
+            return Z_DEFAULT_COMPRESSION;
+        case Rendition::Compression::Best:
+            return Z_BEST_COMPRESSION;
+    }
+
+    abort();
+}
+
 static ext::optional<std::vector<uint8_t>>
-Encode(Rendition const *rendition, ext::optional<Rendition::Data> data)
+Compress(uint8_t const *uncompressed_data, size_t uncompressed_length, int deflateLevel)
+{
+    int windowSize = 16+MAX_WBITS;
+    z_stream zlibStream;
+    memset(&zlibStream, 0, sizeof(zlibStream));
+    zlibStream.next_in = (Bytef*)uncompressed_data;
+    zlibStream.avail_in = (uInt)uncompressed_length;
+    int err = deflateInit2(&zlibStream, deflateLevel, Z_DEFLATED, windowSize, 8, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) {
+        return ext::nullopt;
+    }
+
+    std::vector<uint8_t> compressed_vector;
+    while (true) {
+        uint8_t tmp[4096];
+        zlibStream.next_out = (Bytef*)&tmp;
+        zlibStream.avail_out = (uInt)sizeof(tmp);
+        err = deflate(&zlibStream, Z_FINISH);
+        size_t block_size = sizeof(tmp) - zlibStream.avail_out;
+        compressed_vector.resize(compressed_vector.size() + block_size);
+        memcpy(&compressed_vector[compressed_vector.size() - block_size], &tmp[0], block_size);
+        if (err == Z_STREAM_END) {  /* Done */
+            break;
+        }
+        if (err != Z_OK) {  /* Z_OK -> Made progress, else err */
+            deflateEnd(&zlibStream);
+            fprintf(stderr, "Zlib error %d", err);
+            return ext::nullopt;
+        }
+    }
+    deflateEnd(&zlibStream);
+
+    return compressed_vector;
+}
+
+/*
+ * Renditions larger than this are split into blocks, each compressed on
+ * its own, so they can be compressed at the same time.
+ */
+static size_t const EncodeBlockSize = 1024 * 1024;
+
+static ext::optional<std::vector<uint8_t>>
+Encode(Rendition const *rendition, ext::optional<Rendition::Data> const &data)
 {
     if (!data || data->data().size() == 0) {
         return ext::nullopt;
@@ -429,50 +580,51 @@ Encode(Rendition const *rendition, ext::optional<Rendition::Data> data)
 
     // The selected algorithm, only zlib for now
     enum car_rendition_data_compression_magic compression_magic = car_rendition_data_compression_magic_zlib;
+    int deflateLevel = CompressionLevel(rendition->compression());
     size_t bytes_per_pixel = Rendition::Data::FormatSize(data->format());
 
     size_t uncompressed_length = rendition->width() * rendition->height() * bytes_per_pixel;
-    void *uncompressed_data = static_cast<void *>(data->data().data());
+    uint8_t const *uncompressed_data = data->data().data();
 
-    std::vector<uint8_t> compressed_vector;
-    if (compression_magic == car_rendition_data_compression_magic_zlib) {
-        int deflateLevel = Z_DEFAULT_COMPRESSION;
-        int windowSize = 16+MAX_WBITS;
-        z_stream zlibStream;
-        memset(&zlibStream, 0, sizeof(zlibStream));
-        zlibStream.next_in = (Bytef*)uncompressed_data;
-        zlibStream.avail_in = (uInt)uncompressed_length;
-        int err = deflateInit2(&zlibStream, deflateLevel, Z_DEFLATED, windowSize, 8, Z_DEFAULT_STRATEGY);
-        if (err != Z_OK) {
+    /*
+     * Split into blocks of whole rows. A single block is written without
+     * block headers.
+     */
+    size_t bytes_per_row = std::max<size_t>(rendition->width() * bytes_per_pixel, 1);
+    size_t block_length = std::max<size_t>(EncodeBlockSize / bytes_per_row, 1) * bytes_per_row;
+    size_t block_count = std::max<size_t>((uncompressed_length + block_length - 1) / block_length, 1);
+
+    std::vector<ext::optional<std::vector<uint8_t>>> blocks = std::vector<ext::optional<std::vector<uint8_t>>>(block_count);
+    Parallel::For(Parallel::DefaultJobs(), block_count, [&](size_t n) {
+        size_t offset = n * block_length;
+        size_t length = std::min(block_length, uncompressed_length - std::min(offset, uncompressed_length));
+        blocks[n] = Compress(uncompressed_data + offset, length, deflateLevel);
+    });
+
+    std::vector<uint8_t> output = std::vector<uint8_t>(sizeof(struct car_rendition_data_header1));
+
+    for (ext::optional<std::vector<uint8_t>> const &block : blocks) {
+        if (!block) {
             return ext::nullopt;
         }
-        while (true) {
-            uint8_t tmp[4096];
-            zlibStream.next_out = (Bytef*)&tmp;
-            zlibStream.avail_out = (uInt)sizeof(tmp);
-            err = deflate(&zlibStream, Z_FINISH);
-            size_t block_size = sizeof(tmp) - zlibStream.avail_out;
-            compressed_vector.resize(compressed_vector.size() + block_size);
-            memcpy(&compressed_vector[compressed_vector.size() - block_size], &tmp[0], block_size);
-            if (err == Z_STREAM_END) {  /* Done */
-                break;
-            }
-            if (err != Z_OK) {  /* Z_OK -> Made progress, else err */
-                deflateEnd(&zlibStream);
-                fprintf(stderr, "Zlib error %d", err);
-                return ext::nullopt;
-            }
+
+        if (block_count > 1) {
+            struct car_rendition_data_header2 header2;
+            memset(&header2, 0, sizeof(header2));
+            memcpy(header2.magic, "KCBC", sizeof(header2.magic));
+            header2.length = block->size();
+
+            uint8_t const *header2_bytes = reinterpret_cast<uint8_t const *>(&header2);
+            output.insert(output.end(), header2_bytes, header2_bytes + sizeof(header2));
         }
-        deflateEnd(&zlibStream);
-    }
 
-    std::vector<uint8_t> output = std::vector<uint8_t>(sizeof(struct car_rendition_data_header1));
+        output.insert(output.end(), block->begin(), block->end());
+    }
 
     struct car_rendition_data_header1 *header1 = reinterpret_cast<struct car_rendition_data_header1 *>(output.data());
     memcpy(header1->magic, "MLEC", sizeof(header1->magic));
-    header1->length = compressed_vector.size();
+    header1->length = output.size() - sizeof(struct car_rendition_data_header1);
     header1->compression = compression_magic;
-    output.insert(output.end(), compressed_vector.begin(), compressed_vector.end());
 
     return output;
 }
@@ -488,9 +640,9 @@ Create(
 Rendition Rendition::
 Create(
     AttributeList const &attributes,
-    ext::optional<Data> const &data)
+    ext::optional<Data> data)
 {
-    return Rendition(attributes, data);
+    return Rendition(attributes, std::move(data));
 }
 
 std::vector<uint8_t> Rendition::
@@ -568,23 +720,55 @@ write() const
     info_bitmap_info.header.length = sizeof(struct car_rendition_info_bitmap_info) - sizeof(struct car_rendition_info_header);
     info_bitmap_info.exif_orientation = 1; // XXX FIXME
 
+    /*
+     * Loaded renditions keep their stored payload, rather than decoding and
+     * encoding it again. Otherwise, use the rendition's own data, if it has
+     * it, rather than a copy.
+     */
+    ext::optional<Rendition::Data::Format> format;
+    ext::optional<std::pair<uint8_t const *, size_t>> payload;
+    ext::optional<std::vector<uint8_t>> data;
+    if (!_data && _value != nullptr) {
+        format = DecodeFormat(_value);
+        payload = DecodePayload(_value);
+    } else {
+        ext::optional<Rendition::Data> deferredData;
+        if (!_data) {
+            deferredData = this->data();
+        }
+        ext::optional<Rendition::Data> const &renditionData = (_data ? _data : deferredData);
+        if (renditionData) {
+            format = renditionData->format();
+        }
+
+        data = Encode(this, renditionData);
+        if (data) {
+            payload = std::make_pair(static_cast<uint8_t const *>(data->data()), data->size());
+        }
+    }
+    if (!payload) {
+        printf("Error: no bitmap data for %s\n", this->fileName().c_str());
+        payload = std::make_pair(static_cast<uint8_t const *>(nullptr), static_cast<size_t>(0));
+    }
+
     size_t bytes_per_pixel = 0;
-    auto renditionData = this->data();
-    switch (renditionData->format()) {
-        case Rendition::Data::Format::PremultipliedBGRA8:
-            bytes_per_pixel = 4;
-            header.pixel_format = car_rendition_value_pixel_format_argb;
-            break;
-        case Rendition::Data::Format::PremultipliedGA8:
-            bytes_per_pixel = 2;
-            header.pixel_format = car_rendition_value_pixel_format_ga8;
-            break;
-        case Rendition::Data::Format::JPEG:
-            header.pixel_format = car_rendition_value_pixel_format_jpeg;
-            break;
-        case Rendition::Data::Format::Data:
-            header.pixel_format = car_rendition_value_pixel_format_raw_data;
-            break;
+    if (format) {
+        switch (*format) {
+            case Rendition::Data::Format::PremultipliedBGRA8:
+                bytes_per_pixel = 4;
+                header.pixel_format = car_rendition_value_pixel_format_argb;
+                break;
+            case Rendition::Data::Format::PremultipliedGA8:
+                bytes_per_pixel = 2;
+                header.pixel_format = car_rendition_value_pixel_format_ga8;
+                break;
+            case Rendition::Data::Format::JPEG:
+                header.pixel_format = car_rendition_value_pixel_format_jpeg;
+                break;
+            case Rendition::Data::Format::Data:
+                header.pixel_format = car_rendition_value_pixel_format_raw_data;
+                break;
+        }
     }
 
     struct car_rendition_info_bytes_per_row info_bytes_per_row;
@@ -592,15 +776,8 @@ write() const
     info_bytes_per_row.header.length = sizeof(struct car_rendition_info_bytes_per_row) - sizeof(struct car_rendition_info_header);
     info_bytes_per_row.bytes_per_row = _width * bytes_per_pixel;
 
-    // Write bitmap data
-    ext::optional<std::vector<uint8_t>> data = Encode(this, renditionData);
-    if (!data) {
-        printf("Error: no bitmap data for %s\n", this->fileName().c_str());
-        data = ext::optional<std::vector<uint8_t>>(std::vector<uint8_t>());
-    }
-
-    size_t compressed_data_length = data->size();
-    uint8_t *compressed_data = reinterpret_cast<uint8_t *>(data->data());
+    size_t compressed_data_length = payload->second;
+    uint8_t const *compressed_data = payload->first;
 
     // Assemble Header and info segments
     size_t rendition_header_size = sizeof(struct car_rendition_value) + info_slices_size + \
@@ -651,7 +828,9 @@ write() const
         output_bytes += sizeof(struct car_rendition_data_header_raw);
     }
 
-    memcpy(output_bytes, compressed_data, compressed_data_length);
+    if (compressed_data_length > 0) {
+        memcpy(output_bytes, compressed_data, compressed_data_length);
+    }
 
     return output;
 }
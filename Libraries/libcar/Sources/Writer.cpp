@@ -12,6 +12,7 @@
 
 #include <random>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -55,10 +56,19 @@ addRendition(void *key, size_t key_len, void *value, size_t value_len)
     _rawRenditions.emplace_back(kv);
 }
 
+void Writer::
+addRendition(AttributeList const &attributes, std::vector<uint8_t> const &value)
+{
+    if (attributes.get(car_attribute_identifier_identifier) != ext::nullopt) {
+        _encodedRenditions.push_back({ attributes, value });
+    }
+}
+
 static std::vector<enum car_attribute_identifier>
 DetermineKeyFormat(
     std::unordered_map<std::string, Facet> const &facets,
-    std::unordered_multimap<uint16_t, Rendition> const &renditions)
+    std::unordered_multimap<uint16_t, Rendition> const &renditions,
+    std::vector<std::pair<car::AttributeList, std::vector<uint8_t>>> const &encodedRenditions)
 {
     std::unordered_set<enum car_attribute_identifier> format;
     auto insert = [&format](enum car_attribute_identifier identifier, uint16_t value) {
@@ -73,11 +83,62 @@ DetermineKeyFormat(
         item.second.attributes().iterate(insert);
     }
 
+    for (auto const &item : encodedRenditions) {
+        item.first.iterate(insert);
+    }
+
     /* Sort attributes to preserve ordering. */
     auto ordered = std::set<enum car_attribute_identifier>(format.begin(), format.end());
     return std::vector<enum car_attribute_identifier>(ordered.begin(), ordered.end());
 }
 
+static struct bom_tree_bulk_entry
+AddEntry(struct bom_context *bom, void const *key, size_t key_len, void const *value, size_t value_len)
+{
+    struct bom_tree_bulk_entry entry;
+    entry.key_index = bom_index_add(bom, key, key_len);
+    entry.value_index = bom_index_add(bom, value, value_len);
+    return entry;
+}
+
+static uint64_t
+HashValue(void const *value, size_t value_len)
+{
+    /* FNV-1a. */
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t n = 0; n < value_len; ++n) {
+        hash ^= static_cast<uint8_t const *>(value)[n];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+ * Add a tree entry whose value may already be stored. Identical values
+ * share one index, so repeated images are only stored once.
+ */
+static struct bom_tree_bulk_entry
+AddSharedEntry(struct bom_context *bom, std::unordered_multimap<uint64_t, uint32_t> *values, void const *key, size_t key_len, void const *value, size_t value_len)
+{
+    struct bom_tree_bulk_entry entry;
+    entry.key_index = bom_index_add(bom, key, key_len);
+
+    uint64_t hash = HashValue(value, value_len);
+    auto range = values->equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        size_t stored_len;
+        void const *stored = bom_index_get(bom, it->second, &stored_len);
+        if (stored_len == value_len && memcmp(stored, value, value_len) == 0) {
+            entry.value_index = it->second;
+            return entry;
+        }
+    }
+
+    entry.value_index = bom_index_add(bom, value, value_len);
+    values->insert({ hash, entry.value_index });
+    return entry;
+}
+
 void Writer::
 write() const
 {
@@ -87,7 +148,7 @@ write() const
      * Each tree entry (facet or rendition) requires 2: one key index, one value index.
      */
     uint32_t facet_count = _facets.size();
-    uint32_t rendition_count = _renditions.size() + _rawRenditions.size();
+    uint32_t rendition_count = _renditions.size() + _rawRenditions.size() + _encodedRenditions.size();
     uint32_t bom_index_count = 6 + facet_count * 2 + rendition_count * 2;
     bom_index_reserve(_bom.get(), bom_index_count);
 
@@ -124,7 +185,7 @@ write() const
     struct car_key_format *keyfmt;
     size_t keyfmt_size;
     if (_keyfmt == ext::nullopt) {
-      std::vector<enum car_attribute_identifier> format = DetermineKeyFormat(_facets, _renditions);
+      std::vector<enum car_attribute_identifier> format = DetermineKeyFormat(_facets, _renditions, _encodedRenditions);
       keyfmt_size = sizeof(struct car_key_format) + (format.size() * sizeof(uint32_t));
       keyfmt = (struct car_key_format *)malloc(keyfmt_size);
       strncpy(keyfmt->magic, "tmfk", 4);
@@ -141,44 +202,44 @@ write() const
     int key_format_index = bom_index_add(_bom.get(), keyfmt, keyfmt_size);
     bom_variable_add(_bom.get(), car_key_format_variable, key_format_index);
 
-    /* Write facets. */
+    /*
+     * Write facets. Keys and values are added first, then the tree is built
+     * from them at once, sorted and in full leaves.
+     */
     struct bom_tree_context *facets_tree_context = bom_tree_alloc_empty(_bom.get(), car_facet_keys_variable);
-    bom_tree_reserve(facets_tree_context, facet_count);
     if (facets_tree_context != NULL) {
+        std::vector<struct bom_tree_bulk_entry> entries;
+        entries.reserve(facet_count);
         for (auto const &item : _facets) {
             auto facet_value = item.second.write();
-            bom_tree_add(
-                facets_tree_context,
-                reinterpret_cast<void const *>(item.first.c_str()),
-                item.first.size(),
-                reinterpret_cast<void const *>(facet_value.data()),
-                facet_value.size());
+            entries.push_back(AddEntry(_bom.get(), item.first.c_str(), item.first.size(), facet_value.data(), facet_value.size()));
         }
+        bom_tree_bulk_load(facets_tree_context, entries.data(), entries.size());
         bom_tree_free(facets_tree_context);
     }
 
-    /* Write renditions. */
+    /*
+     * Write renditions. Renditions with identical contents, such as the same
+     * image used for several slots, share their stored value.
+     */
     struct bom_tree_context *renditions_tree_context = bom_tree_alloc_empty(_bom.get(), car_renditions_variable);
-    bom_tree_reserve(renditions_tree_context, rendition_count);
     if (renditions_tree_context != NULL) {
+        std::unordered_multimap<uint64_t, uint32_t> values;
+        std::vector<struct bom_tree_bulk_entry> entries;
+        entries.reserve(rendition_count);
         for (auto const &item : _renditions) {
             auto attributes_value = item.second.attributes().write(keyfmt->num_identifiers, keyfmt->identifier_list);
             auto rendition_value = item.second.write();
-            bom_tree_add(
-                renditions_tree_context,
-                reinterpret_cast<void const *>(attributes_value.data()),
-                attributes_value.size(),
-                reinterpret_cast<void const *>(rendition_value.data()),
-                rendition_value.size());
+            entries.push_back(AddSharedEntry(_bom.get(), &values, attributes_value.data(), attributes_value.size(), rendition_value.data(), rendition_value.size()));
+        }
+        for (auto const &item : _encodedRenditions) {
+            auto attributes_value = item.first.write(keyfmt->num_identifiers, keyfmt->identifier_list);
+            entries.push_back(AddSharedEntry(_bom.get(), &values, attributes_value.data(), attributes_value.size(), item.second.data(), item.second.size()));
         }
         for (auto const &item : _rawRenditions) {
-            bom_tree_add(
-                renditions_tree_context,
-                item.key,
-                item.keyLength,
-                item.value,
-                item.valueLength);
+            entries.push_back(AddSharedEntry(_bom.get(), &values, item.key, item.keyLength, item.value, item.valueLength));
         }
+        bom_tree_bulk_load(renditions_tree_context, entries.data(), entries.size());
         bom_tree_free(renditions_tree_context);
     }
 
@@ -75,3 +75,32 @@ TEST(AttributeList, DeserializeAndSerialize)
     EXPECT_TRUE(0 == memcmp(rendition_key, attributes_out, sizeof(uint16_t) * KeyFormatCount));
 }
 
+
+TEST(AttributeList, SetAndIterate)
+{
+    car::AttributeList attributes = car::AttributeList({
+        { car_attribute_identifier_identifier, 8 },
+        { car_attribute_identifier_scale, 2 },
+    });
+    attributes.set((enum car_attribute_identifier)40, 4);
+    attributes.set(car_attribute_identifier_element, 1);
+    attributes.set(car_attribute_identifier_scale, 3);
+
+    EXPECT_EQ(4, attributes.count());
+    EXPECT_EQ(3, *attributes.get(car_attribute_identifier_scale));
+    EXPECT_EQ(4, *attributes.get((enum car_attribute_identifier)40));
+    EXPECT_FALSE(attributes.get(car_attribute_identifier_idiom));
+    EXPECT_FALSE(attributes.get((enum car_attribute_identifier)41));
+
+    /* Iterated in identifier order. */
+    std::vector<std::pair<int, uint16_t>> values;
+    attributes.iterate([&values](enum car_attribute_identifier identifier, uint16_t value) {
+        values.push_back({ identifier, value });
+    });
+    EXPECT_EQ((std::vector<std::pair<int, uint16_t>>({
+        { car_attribute_identifier_element, 1 },
+        { car_attribute_identifier_scale, 3 },
+        { car_attribute_identifier_identifier, 8 },
+        { 40, 4 },
+    })), values);
+}
@@ -246,3 +246,114 @@ TEST(Rendition, SerializeSlices)
     }
 }
 
+
+TEST(Rendition, SerializeBlocks)
+{
+    /* Large enough to be compressed as several blocks. */
+    size_t width = 1000;
+    size_t height = 700;
+
+    auto format = car::Rendition::Data::Format::PremultipliedBGRA8;
+    auto bitmap = std::vector<uint8_t>(width * height * 4);
+    for (size_t i = 0; i < bitmap.size(); i++) {
+        bitmap[i] = (i * 7 + i / 4093) & 0xFF;
+    }
+
+    auto data = car::Rendition::Data(bitmap, format);
+    car::Rendition rendition = car::Rendition::Create(EmptyAttributeList(), data);
+    rendition.width() = width;
+    rendition.height() = height;
+    rendition.scale() = 1.0;
+    rendition.fileName() = "test.png";
+    rendition.layout() = car_rendition_value_layout_one_part_scale;
+
+    /* Serialize and deserialize rendition. */
+    std::vector<uint8_t> rendition_value = rendition.write();
+    struct car_rendition_value *value = reinterpret_cast<struct car_rendition_value *>(rendition_value.data());
+    car::Rendition deserialized_rendition = car::Rendition::Load(EmptyAttributeList(), value);
+
+    /* Verify data is written in blocks. */
+    struct car_rendition_data_header1 *header1 = (struct car_rendition_data_header1 *)((uintptr_t)value + sizeof(struct car_rendition_value) + value->info_len);
+    EXPECT_EQ(strncmp((char const *)header1->data, "KCBC", 4), 0);
+
+    /* Verify data is identical. */
+    auto deserialized_data = deserialized_rendition.data();
+    ASSERT_NE(deserialized_data, ext::nullopt);
+    EXPECT_EQ(deserialized_data->format(), format);
+    EXPECT_EQ(deserialized_data->data(), bitmap);
+
+    /* Verify a loaded rendition is written with its blocks intact. */
+    std::vector<uint8_t> rewritten_value = deserialized_rendition.write();
+    car::Rendition rewritten_rendition = car::Rendition::Load(EmptyAttributeList(), reinterpret_cast<struct car_rendition_value *>(rewritten_value.data()));
+    auto rewritten_data = rewritten_rendition.data();
+    ASSERT_NE(rewritten_data, ext::nullopt);
+    EXPECT_EQ(rewritten_data->data(), bitmap);
+}
+
+TEST(Rendition, SerializeCompression)
+{
+    size_t width = 64;
+    size_t height = 64;
+
+    auto format = car::Rendition::Data::Format::PremultipliedBGRA8;
+    auto bitmap = std::vector<uint8_t>(width * height * 4);
+    for (size_t i = 0; i < bitmap.size(); i++) {
+        bitmap[i] = (i / 64) & 0xFF;
+    }
+
+    std::vector<size_t> sizes;
+    for (car::Rendition::Compression compression : { car::Rendition::Compression::None, car::Rendition::Compression::Fast, car::Rendition::Compression::Best }) {
+        car::Rendition rendition = car::Rendition::Create(EmptyAttributeList(), car::Rendition::Data(bitmap, format));
+        rendition.width() = width;
+        rendition.height() = height;
+        rendition.fileName() = "test.png";
+        rendition.layout() = car_rendition_value_layout_one_part_scale;
+        rendition.compression() = compression;
+
+        /* Every compression should read back the same. */
+        std::vector<uint8_t> rendition_value = rendition.write();
+        car::Rendition deserialized_rendition = car::Rendition::Load(EmptyAttributeList(), reinterpret_cast<struct car_rendition_value *>(rendition_value.data()));
+        EXPECT_EQ(deserialized_rendition.data()->data(), bitmap);
+        sizes.push_back(rendition_value.size());
+    }
+
+    /* Storing without compression is larger than compressing. */
+    EXPECT_GT(sizes[0], bitmap.size());
+    EXPECT_LT(sizes[1], sizes[0]);
+    EXPECT_LE(sizes[2], sizes[1]);
+}
+
+TEST(Rendition, EncodedData)
+{
+    auto format = car::Rendition::Data::Format::JPEG;
+    auto jpeg = std::vector<uint8_t>(1000);
+    for (size_t i = 0; i < jpeg.size(); i++) {
+        jpeg[i] = i & 0xFF;
+    }
+
+    /* Created renditions have no stored data. */
+    car::Rendition rendition = car::Rendition::Create(EmptyAttributeList(), car::Rendition::Data(jpeg, format));
+    rendition.width() = 10;
+    rendition.height() = 10;
+    rendition.fileName() = "test.jpg";
+    rendition.layout() = car_rendition_value_layout_one_part_scale;
+    EXPECT_EQ(rendition.encodedData(), ext::nullopt);
+    EXPECT_EQ(rendition.dataFormat(), format);
+
+    /* Loaded renditions point into the value they were loaded from. */
+    std::vector<uint8_t> rendition_value = rendition.write();
+    car::Rendition deserialized_rendition = car::Rendition::Load(EmptyAttributeList(), reinterpret_cast<struct car_rendition_value *>(rendition_value.data()));
+    EXPECT_EQ(deserialized_rendition.dataFormat(), format);
+    auto encoded = deserialized_rendition.encodedData();
+    ASSERT_NE(encoded, ext::nullopt);
+    EXPECT_GE(encoded->first, rendition_value.data());
+    EXPECT_LE(encoded->first + encoded->second, rendition_value.data() + rendition_value.size());
+    EXPECT_EQ(std::vector<uint8_t>(encoded->first, encoded->first + encoded->second), jpeg);
+
+    /* Writing a loaded rendition keeps its stored data. */
+    std::vector<uint8_t> rewritten_value = deserialized_rendition.write();
+    car::Rendition rewritten_rendition = car::Rendition::Load(EmptyAttributeList(), reinterpret_cast<struct car_rendition_value *>(rewritten_value.data()));
+    auto rewritten = rewritten_rendition.encodedData();
+    ASSERT_NE(rewritten, ext::nullopt);
+    EXPECT_EQ(std::vector<uint8_t>(rewritten->first, rewritten->first + rewritten->second), jpeg);
+}
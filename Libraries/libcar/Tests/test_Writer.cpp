@@ -18,8 +18,11 @@
 #include <car/Writer.h>
 #include <car/Reader.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <string>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <vector>
 
@@ -254,3 +257,251 @@ TEST(Writer, TestWriter100Optimal)
     EXPECT_EQ(rendition_count, create_rendition_count);
 }
 
+
+TEST(Writer, EncodedRendition)
+{
+    auto writer_bom = car::Writer::unique_ptr_bom(bom_alloc_empty(bom_context_memory(NULL, 0)), bom_free);
+    EXPECT_NE(writer_bom, nullptr);
+
+    auto writer = car::Writer::Create(std::move(writer_bom));
+    EXPECT_NE(writer, ext::nullopt);
+
+    car::AttributeList attributes = car::AttributeList({
+        { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+        { car_attribute_identifier_scale, 2 },
+        { car_attribute_identifier_identifier, 1 },
+    });
+
+    car::Facet facet = car::Facet::Create("testpattern", attributes);
+    writer->addFacet(facet);
+
+    /* Add a rendition serialized ahead of time. */
+    auto data = car::Rendition::Data(test_pixels, car::Rendition::Data::Format::PremultipliedBGRA8);
+    car::Rendition rendition = car::Rendition::Create(attributes, data);
+    rendition.width() = 8;
+    rendition.height() = 8;
+    rendition.scale() = 2;
+    rendition.fileName() = "testpattern.png";
+    rendition.layout() = car_rendition_value_layout_one_part_scale;
+    writer->addRendition(attributes, rendition.write());
+
+    writer->write();
+
+    /* Read back. */
+    struct bom_context_memory const *writer_memory = bom_memory(writer->bom());
+    struct bom_context_memory reader_memory = bom_context_memory(writer_memory->data, writer_memory->size);
+    auto reader_bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(reader_memory), bom_free);
+    EXPECT_NE(reader_bom, nullptr);
+
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    EXPECT_NE(reader, ext::nullopt);
+
+    int rendition_count = 0;
+    reader->facetIterate([&reader, &rendition_count](car::Facet const &facet) {
+        EXPECT_EQ(facet.name(), "testpattern");
+
+        for (auto const &rendition : reader->lookupRenditions(facet)) {
+            rendition_count++;
+            EXPECT_TRUE(strcmp(rendition.fileName().c_str(), "testpattern.png") == 0);
+            EXPECT_EQ(rendition.data()->data(), test_pixels);
+        }
+    });
+
+    EXPECT_EQ(rendition_count, 1);
+}
+
+TEST(Writer, SharedRenditions)
+{
+    /* Noisy pixels, so the stored renditions are large. */
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(128 * 128 * 4);
+    uint32_t state = 1;
+    for (uint8_t &pixel : pixels) {
+        state = state * 1103515245 + 12345;
+        pixel = static_cast<uint8_t>(state >> 16);
+    }
+
+    auto data = car::Rendition::Data(pixels, car::Rendition::Data::Format::PremultipliedBGRA8);
+    car::Rendition rendition = car::Rendition::Create(car::AttributeList({ }), data);
+    rendition.width() = 128;
+    rendition.height() = 128;
+    rendition.fileName() = "placeholder.png";
+    std::vector<uint8_t> encoded = rendition.write();
+
+    auto writer_bom = car::Writer::unique_ptr_bom(bom_alloc_empty(bom_context_memory(NULL, 0)), bom_free);
+    auto writer = car::Writer::Create(std::move(writer_bom));
+    ASSERT_NE(writer, ext::nullopt);
+
+    /* The same image, for several facets. */
+    for (int identifier = 1; identifier <= 4; identifier++) {
+        car::AttributeList attributes = car::AttributeList({
+            { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+            { car_attribute_identifier_identifier, identifier },
+        });
+        writer->addFacet(car::Facet::Create("placeholder_" + std::to_string(identifier), attributes));
+        writer->addRendition(attributes, encoded);
+    }
+
+    writer->write();
+
+    /* Stored once. */
+    struct bom_context_memory const *writer_memory = bom_memory(writer->bom());
+    EXPECT_LT(writer_memory->size, encoded.size() * 2);
+
+    struct bom_context_memory reader_memory = bom_context_memory(writer_memory->data, writer_memory->size);
+    auto reader_bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(reader_memory), bom_free);
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    ASSERT_NE(reader, ext::nullopt);
+
+    int rendition_count = 0;
+    reader->facetIterate([&reader, &rendition_count, &pixels](car::Facet const &facet) {
+        for (auto const &rendition : reader->lookupRenditions(facet)) {
+            rendition_count++;
+            EXPECT_EQ(rendition.data()->data(), pixels);
+        }
+    });
+    EXPECT_EQ(rendition_count, 4);
+}
+
+TEST(Writer, LookupRendition)
+{
+    auto writer_bom = car::Writer::unique_ptr_bom(bom_alloc_empty(bom_context_memory(NULL, 0)), bom_free);
+    auto writer = car::Writer::Create(std::move(writer_bom));
+    ASSERT_NE(writer, ext::nullopt);
+
+    car::AttributeList facet_attributes = car::AttributeList({
+        { car_attribute_identifier_identifier, 1 },
+    });
+    writer->addFacet(car::Facet::Create("testpattern", facet_attributes));
+
+    for (uint16_t scale : { 1, 2 }) {
+        car::AttributeList attributes = car::AttributeList({
+            { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+            { car_attribute_identifier_scale, scale },
+            { car_attribute_identifier_identifier, 1 },
+        });
+
+        car::Rendition rendition = car::Rendition::Create(attributes, car::Rendition::Data(test_pixels, car::Rendition::Data::Format::PremultipliedBGRA8));
+        rendition.width() = 8;
+        rendition.height() = 8;
+        rendition.scale() = scale;
+        rendition.fileName() = "testpattern.png";
+        rendition.layout() = car_rendition_value_layout_one_part_scale;
+        writer->addRendition(rendition);
+    }
+
+    writer->write();
+
+    struct bom_context_memory const *writer_memory = bom_memory(writer->bom());
+    struct bom_context_memory reader_memory = bom_context_memory(writer_memory->data, writer_memory->size);
+    auto reader_bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(reader_memory), bom_free);
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    ASSERT_NE(reader, ext::nullopt);
+    EXPECT_EQ(reader->renditionCount(), 2);
+
+    ext::optional<car::Facet> facet = reader->lookupFacet("testpattern");
+    ASSERT_NE(facet, ext::nullopt);
+
+    /* Exact match. */
+    ext::optional<car::Rendition> scale2 = reader->lookupRendition(*facet, car::AttributeList({
+        { car_attribute_identifier_scale, 2 },
+    }));
+    ASSERT_NE(scale2, ext::nullopt);
+    EXPECT_EQ(*scale2->attributes().get(car_attribute_identifier_scale), 2);
+
+    /* Universal idiom matches a specific idiom. */
+    ext::optional<car::Rendition> phone = reader->lookupRendition(*facet, car::AttributeList({
+        { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_phone },
+        { car_attribute_identifier_scale, 1 },
+    }));
+    ASSERT_NE(phone, ext::nullopt);
+    EXPECT_EQ(*phone->attributes().get(car_attribute_identifier_scale), 1);
+
+    /* No rendition for the scale. */
+    EXPECT_EQ(reader->lookupRendition(*facet, car::AttributeList({
+        { car_attribute_identifier_scale, 3 },
+    })), ext::nullopt);
+}
+
+TEST(Writer, ManyFacets)
+{
+    /* More facets than fit in one tree leaf. */
+    int create_facet_count = 2000;
+
+    auto writer_bom = car::Writer::unique_ptr_bom(bom_alloc_empty(bom_context_memory(NULL, 0)), bom_free);
+    auto writer = car::Writer::Create(std::move(writer_bom));
+    ASSERT_NE(writer, ext::nullopt);
+
+    for (int i = 0; i < create_facet_count; i++) {
+        car::AttributeList attributes = car::AttributeList({
+            { car_attribute_identifier_identifier, static_cast<uint16_t>(i + 1) },
+        });
+        writer->addFacet(car::Facet::Create("facet" + std::to_string(i), attributes));
+    }
+
+    writer->write();
+
+    struct bom_context_memory const *writer_memory = bom_memory(writer->bom());
+    struct bom_context_memory reader_memory = bom_context_memory(writer_memory->data, writer_memory->size);
+    auto reader_bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(reader_memory), bom_free);
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    ASSERT_NE(reader, ext::nullopt);
+    EXPECT_EQ(reader->facetCount(), create_facet_count);
+
+    /* Facets are iterated in key order. */
+    std::vector<std::string> names;
+    reader->facetFastIterate([&names](void *key, size_t key_len, void *value, size_t value_len) {
+        names.push_back(std::string(static_cast<char *>(key), key_len));
+    });
+    EXPECT_EQ(names.size(), create_facet_count);
+    EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+
+    for (int i = 0; i < create_facet_count; i++) {
+        EXPECT_NE(reader->lookupFacet("facet" + std::to_string(i)), ext::nullopt);
+    }
+}
+
+TEST(Writer, NewFile)
+{
+    char directoryTemplate[] = "/tmp/xcbuild-test-car-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string path = std::string(directoryTemplate) + "/Assets.car";
+
+    /* A new, empty file to write into, as actool creates. */
+    int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    ASSERT_GE(fd, 0);
+    ::close(fd);
+
+    /* Empty files can't be read. */
+    struct bom_context_memory empty = bom_context_memory_file(path.c_str(), false, 0);
+    EXPECT_EQ(nullptr, empty.data);
+
+    {
+        struct bom_context_memory memory = bom_context_memory_file(path.c_str(), true, 0);
+        ASSERT_NE(nullptr, memory.data);
+
+        auto writer_bom = car::Writer::unique_ptr_bom(bom_alloc_empty(memory), bom_free);
+        ASSERT_NE(writer_bom, nullptr);
+        auto writer = car::Writer::Create(std::move(writer_bom));
+        ASSERT_NE(writer, ext::nullopt);
+
+        car::AttributeList attributes = car::AttributeList({
+            { car_attribute_identifier_identifier, 1 },
+        });
+        writer->addFacet(car::Facet::Create("facet", attributes));
+        writer->write();
+    }
+
+    /* Written out to the file when the archive is freed. */
+    struct bom_context_memory memory = bom_context_memory_file(path.c_str(), false, 0);
+    ASSERT_NE(nullptr, memory.data);
+    auto reader_bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(memory), bom_free);
+    ASSERT_NE(reader_bom, nullptr);
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    ASSERT_NE(reader, ext::nullopt);
+    EXPECT_EQ(1, reader->facetCount());
+    EXPECT_NE(reader->lookupFacet("facet"), ext::nullopt);
+    reader = ext::nullopt;
+
+    ::unlink(path.c_str());
+    ::rmdir(directoryTemplate);
+}
@@ -13,16 +13,36 @@
 #include <car/Rendition.h>
 #include <graphics/Image.h>
 #include <graphics/Format/PNG.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
 #include <iterator>
 #include <string>
 #include <fstream>
+#include <unordered_map>
+#include <vector>
 
 #include <cassert>
+#include <cstdlib>
 
 static void
 rendition_dump(car::Rendition const &rendition, std::string const &path)
 {
+    /* JPEG and raw data are written as stored, without decoding a copy. */
+    ext::optional<car::Rendition::Data::Format> format = rendition.dataFormat();
+    ext::optional<std::pair<uint8_t const *, size_t>> encoded = rendition.encodedData();
+    if (format && encoded && (*format == car::Rendition::Data::Format::JPEG || *format == car::Rendition::Data::Format::Data)) {
+        std::ofstream file;
+        file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (file.fail()) {
+            fprintf(stderr, "error: failed to open file\n");
+            return;
+        }
+        file.write(reinterpret_cast<char const *>(encoded->first), encoded->second);
+        file.close();
+        return;
+    }
+
     ext::optional<car::Rendition::Data> data = rendition.data();
     if (!data) {
         fprintf(stderr, "warning: failed to get image data for rendition\n");
@@ -54,7 +74,8 @@ rendition_dump(car::Rendition const &rendition, std::string const &path)
                 graphics::PixelFormat::Alpha::PremultipliedFirst);
 
             auto image = graphics::Image(rendition.width(), rendition.height(), format, data->data());
-            auto png = graphics::Format::PNG::Write(image);
+            /* Dumped images are for inspection, so favor speed over size. */
+            auto png = graphics::Format::PNG::Write(image, graphics::Format::PNG::Filter::Sub, graphics::Format::PNG::Compression::Fast);
             if (!png.first) {
                 fprintf(stderr, "failed to encode png: %s\n", png.second.c_str());
                 return;
@@ -80,6 +101,19 @@ rendition_dump(car::Rendition const &rendition, std::string const &path)
 int
 main(int argc, char **argv)
 {
+    /*
+     * With `-j`, renditions are decoded and written on that many threads
+     * once the archive has been printed. Otherwise, each is written as it
+     * is printed.
+     */
+    size_t jobs = 1;
+    if (argc > 2 && std::string(argv[1]) == "-j") {
+        jobs = std::max<size_t>(strtoul(argv[2], NULL, 10), 1);
+        libutil::Parallel::SetDefaultJobs(jobs);
+        argc -= 2;
+        argv += 2;
+    }
+
     if (argc != 2 && argc != 3) {
         fprintf(stderr, "error: missing input\n");
         return 1;
@@ -118,20 +152,38 @@ main(int argc, char **argv)
 
     int facet_count = 0;
     int rendition_count = 0;
+    std::vector<std::pair<car::Rendition, std::string>> pending;
+    std::unordered_map<std::string, size_t> pendingPaths;
 
-    car->facetIterate([&car, &facet_count, &rendition_count, output](car::Facet const &facet) {
+    car->facetIterate([&car, &facet_count, &rendition_count, &pending, &pendingPaths, jobs, output](car::Facet const &facet) {
         facet_count++;
         facet.dump();
 
         auto renditions = car->lookupRenditions(facet);
         for (auto const &rendition : renditions) {
             rendition.dump();
-            rendition_dump(rendition, output + "/" + rendition.fileName());
+            if (jobs > 1) {
+                /* Renditions can share a file name; as when writing in order, the last one is kept. */
+                std::string path = output + "/" + rendition.fileName();
+                auto it = pendingPaths.find(path);
+                if (it != pendingPaths.end()) {
+                    pending[it->second] = { rendition, path };
+                } else {
+                    pendingPaths.insert({ path, pending.size() });
+                    pending.push_back({ rendition, path });
+                }
+            } else {
+                rendition_dump(rendition, output + "/" + rendition.fileName());
+            }
             rendition_count++;
         }
     });
 
+    /* Renditions only read the archive, so they decode independently. */
+    libutil::Parallel::For(jobs, pending.size(), [&](size_t n) {
+        rendition_dump(pending[n].first, pending[n].second);
+    });
+
     printf("Found %d facets and %d renditions\n", facet_count, rendition_count);
     return 0;
 }
-
@@ -0,0 +1,116 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_CachingFilesystem_h
+#define __libutil_CachingFilesystem_h
+
+#include <libutil/Filesystem.h>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace libutil {
+
+/*
+ * Wraps another filesystem, remembering whether paths exist, their types,
+ * their access permissions, and where executables are found. Any change
+ * made through this filesystem forgets everything remembered, but changes
+ * made by other processes or filesystems are not noticed. Use only while
+ * the files involved are not expected to change. Safe to use from multiple
+ * threads.
+ */
+class CachingFilesystem : public Filesystem {
+private:
+    struct Entry {
+        ext::optional<bool>                exists;
+        ext::optional<ext::optional<Type>> type;
+        ext::optional<bool>                readable;
+        ext::optional<bool>                writable;
+        ext::optional<bool>                executable;
+    };
+
+private:
+    Filesystem                                     *_filesystem;
+    mutable std::unordered_map<std::string, Entry>  _entries;
+    mutable std::mutex                              _entriesMutex;
+    uint64_t                                        _generation;
+
+private:
+    mutable std::unordered_map<std::string, ext::optional<std::string>> _executables;
+
+public:
+    CachingFilesystem(Filesystem *filesystem);
+
+public:
+    /*
+     * The wrapped filesystem.
+     */
+    Filesystem *filesystem() const
+    { return _filesystem; }
+
+public:
+    /*
+     * Forget everything remembered about the filesystem.
+     */
+    void invalidate();
+
+private:
+    template<typename T>
+    T cached(std::string const &path, ext::optional<T> Entry::*field, std::function<T()> const &compute) const;
+
+public:
+    virtual bool exists(std::string const &path) const;
+    virtual ext::optional<Type> type(std::string const &path) const;
+
+public:
+    virtual bool isReadable(std::string const &path) const;
+    virtual bool isWritable(std::string const &path) const;
+    virtual bool isExecutable(std::string const &path) const;
+
+public:
+    virtual ext::optional<Permissions> readFilePermissions(std::string const &path) const;
+    virtual bool writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions);
+    virtual ext::optional<Stamp> readFileStamp(std::string const &path) const;
+    virtual bool createFile(std::string const &path);
+    virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
+    virtual std::unique_ptr<Mapping const> map(std::string const &path) const;
+    virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool copyFile(std::string const &from, std::string const &to);
+    virtual bool moveFile(std::string const &from, std::string const &to);
+    virtual bool removeFile(std::string const &path);
+
+public:
+    virtual ext::optional<Permissions> readSymbolicLinkPermissions(std::string const &path) const;
+    virtual bool writeSymbolicLinkPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions);
+    virtual ext::optional<std::string> readSymbolicLink(std::string const &path) const;
+    virtual bool writeSymbolicLink(std::string const &target, std::string const &path);
+    virtual bool copySymbolicLink(std::string const &from, std::string const &to);
+    virtual bool removeSymbolicLink(std::string const &path);
+
+public:
+    virtual ext::optional<Permissions> readDirectoryPermissions(std::string const &path) const;
+    virtual bool writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive);
+    virtual ext::optional<Stamp> readDirectoryStamp(std::string const &path) const;
+    virtual bool createDirectory(std::string const &path, bool recursive);
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const;
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const;
+    virtual bool copyDirectory(std::string const &from, std::string const &to, bool recursive);
+    virtual bool copyDirectoryWithPermissions(std::string const &from, std::string const &to, Permissions::Operation operation, Permissions permissions);
+    virtual bool removeDirectory(std::string const &path, bool recursive);
+
+public:
+    virtual std::string resolvePath(std::string const &path) const;
+
+public:
+    virtual ext::optional<std::string> findExecutable(std::string const &name, std::vector<std::string> const &paths) const;
+};
+
+}
+
+#endif  // !__libutil_CachingFilesystem_h
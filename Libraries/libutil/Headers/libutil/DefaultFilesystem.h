@@ -27,10 +27,13 @@ public:
 public:
     virtual ext::optional<Permissions> readFilePermissions(std::string const &path) const;
     virtual bool writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions);
+    virtual ext::optional<Stamp> readFileStamp(std::string const &path) const;
     virtual bool createFile(std::string const &path);
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
+    virtual std::unique_ptr<Mapping const> map(std::string const &path) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
     virtual bool copyFile(std::string const &from, std::string const &to);
+    virtual bool moveFile(std::string const &from, std::string const &to);
     virtual bool removeFile(std::string const &path);
 
 public:
@@ -44,9 +47,12 @@ public:
 public:
     virtual ext::optional<Permissions> readDirectoryPermissions(std::string const &path) const;
     virtual bool writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive);
+    virtual ext::optional<Stamp> readDirectoryStamp(std::string const &path) const;
     virtual bool createDirectory(std::string const &path, bool recursive);
     virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const;
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const;
     virtual bool copyDirectory(std::string const &from, std::string const &to, bool recursive);
+    virtual bool copyDirectoryWithPermissions(std::string const &from, std::string const &to, Permissions::Operation operation, Permissions permissions);
     virtual bool removeDirectory(std::string const &path, bool recursive);
 
 public:
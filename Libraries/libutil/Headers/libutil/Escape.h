@@ -26,11 +26,23 @@ public:
     static std::string
     Shell(std::string const &value);
 
+    /*
+     * Shell-escapes a string, appending it to a result.
+     */
+    static void
+    Shell(std::string const &value, std::string *result);
+
     /*
      * Escape a file path for a Makefile.
      */
     static std::string
     Makefile(std::string const &value);
+
+    /*
+     * Quote and escape a string for JSON.
+     */
+    static std::string
+    JSON(std::string const &value);
 };
 
 }
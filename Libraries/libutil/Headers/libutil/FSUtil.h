@@ -38,6 +38,14 @@ public:
     static std::string ResolveRelativePath(std::string const &path, std::string const &workingDirectory);
     static std::string NormalizePath(std::string const &path);
 
+public:
+    /*
+     * A path next to a file to write it to before moving it into place.
+     * Unique per process and call, as other processes and threads may be
+     * writing the same file.
+     */
+    static std::string GetTemporaryPath(std::string const &path);
+
 public:
     static std::string FindFile(std::string const &name, std::vector<std::string> const &paths);
     static std::string FindExecutable(std::string const &name, std::vector<std::string> const &paths);
@@ -0,0 +1,65 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_FileWatcher_h
+#define __libutil_FileWatcher_h
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace libutil {
+
+/*
+ * Notices changes to files on disk as the operating system reports them,
+ * so a long-running process can tell which files changed without reading
+ * the stamp of every file. The directory containing each file is watched,
+ * so files replaced by a rename, as editors and source control often do,
+ * are noticed too. Not supported on every platform.
+ */
+class FileWatcher {
+private:
+    int                                          _descriptor;
+    std::unordered_map<int, std::string>         _directories;
+    std::unordered_map<std::string, int>         _watches;
+    std::unordered_map<std::string, std::string> _paths;
+
+private:
+    explicit FileWatcher(int descriptor);
+
+public:
+    ~FileWatcher();
+
+public:
+    /*
+     * Start watching a file for changes. The file doesn't have to exist,
+     * but the directory containing it does.
+     */
+    bool watch(std::string const &path);
+
+    /*
+     * Add the watched files changed since the last call. Does not wait for
+     * changes. If changes could have been missed, returns false; then any
+     * watched file must be assumed changed.
+     */
+    bool changes(std::unordered_set<std::string> *changed);
+
+public:
+    /*
+     * Create a file watcher. Returns null if the platform doesn't support
+     * watching files.
+     */
+    static std::unique_ptr<FileWatcher>
+    Create();
+};
+
+}
+
+#endif // !__libutil_FileWatcher_h
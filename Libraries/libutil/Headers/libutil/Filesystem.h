@@ -12,7 +12,9 @@
 
 #include <libutil/Permissions.h>
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <ext/optional>
@@ -39,6 +41,40 @@ public:
         Directory,
     };
 
+    /*
+     * Identifies a version of a file without reading its contents. If a
+     * file's stamp is unchanged, its contents are assumed unchanged too.
+     */
+    struct Stamp {
+        uint64_t size;
+        int64_t  modificationTime;
+
+        bool operator==(Stamp const &rhs) const
+        { return size == rhs.size && modificationTime == rhs.modificationTime; }
+        bool operator!=(Stamp const &rhs) const
+        { return !(*this == rhs); }
+    };
+
+    /*
+     * A read-only view of a file's contents. The contents stay valid
+     * until the mapping is destroyed.
+     */
+    class Mapping {
+    private:
+        uint8_t const *_data;
+        size_t         _size;
+
+    public:
+        Mapping(uint8_t const *data, size_t size);
+        virtual ~Mapping();
+
+    public:
+        uint8_t const *data() const
+        { return _data; }
+        size_t size() const
+        { return _size; }
+    };
+
 public:
     /*
      * Test if a filesystem entry exists.
@@ -77,6 +113,12 @@ public:
      */
     virtual bool writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions) = 0;
 
+    /*
+     * Retrieve the stamp for a file. Nothing if the file doesn't exist, or
+     * if the filesystem can't tell when files change.
+     */
+    virtual ext::optional<Stamp> readFileStamp(std::string const &path) const;
+
 public:
     /*
      * Create a file. Succeeds if created or already exists.
@@ -88,16 +130,36 @@ public:
      */
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const = 0;
 
+    /*
+     * Map a file's contents into memory without copying them, where the
+     * filesystem allows. Nothing if the file can't be read. Changes to the
+     * file while it is mapped may or may not be visible in the mapping.
+     */
+    virtual std::unique_ptr<Mapping const> map(std::string const &path) const;
+
     /*
      * Write to a file.
      */
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path) = 0;
 
+    /*
+     * Write to a uniquely named temporary file, then move it to the path.
+     * Readers of the path see either the old or new contents, and writers
+     * at the same time don't interfere; the last to move wins.
+     */
+    bool writeAtomically(std::vector<uint8_t> const &contents, std::string const &path);
+
     /*
      * Copy a file to a new path.
      */
     virtual bool copyFile(std::string const &from, std::string const &to);
 
+    /*
+     * Move a file to a new path, replacing any file already there. Where
+     * possible, readers of the new path see either the old or new file.
+     */
+    virtual bool moveFile(std::string const &from, std::string const &to);
+
     /*
      * Delete a file.
      */
@@ -145,6 +207,14 @@ public:
      */
     virtual bool writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive) = 0;
 
+    /*
+     * Retrieve the stamp for a directory. It changes when entries are added
+     * to or removed from the directory, but not when their contents change.
+     * Nothing if the directory doesn't exist, or if the filesystem can't
+     * tell when directories change.
+     */
+    virtual ext::optional<Stamp> readDirectoryStamp(std::string const &path) const;
+
     /*
      * Create a directory. Succeeds if created or already exists.
      */
@@ -155,11 +225,23 @@ public:
      */
     virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const = 0;
 
+    /*
+     * Enumerate contents of a directory, with the type of each entry. Where
+     * possible, types come from the directory itself, without a stat per entry.
+     */
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const = 0;
+
     /*
      * Copy a directory to a new path, optionally recursively.
      */
     virtual bool copyDirectory(std::string const &from, std::string const &to, bool recursive);
 
+    /*
+     * Copy a directory to a new path recursively, updating the permissions
+     * of each copied entry as it is copied rather than in a second pass.
+     */
+    virtual bool copyDirectoryWithPermissions(std::string const &from, std::string const &to, Permissions::Operation operation, Permissions permissions);
+
     /*
      * Remove a directory, optionally recursively..
      */
@@ -180,7 +262,7 @@ public:
     /*
      * Finds an executable in the given directories.
      */
-    ext::optional<std::string> findExecutable(std::string const &name, std::vector<std::string> const &paths) const;
+    virtual ext::optional<std::string> findExecutable(std::string const &name, std::vector<std::string> const &paths) const;
 
 public:
     /*
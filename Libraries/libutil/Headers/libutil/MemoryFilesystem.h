@@ -12,25 +12,30 @@
 
 #include <libutil/Filesystem.h>
 
+#include <mutex>
+#include <unordered_map>
+
 namespace libutil {
 
+/*
+ * A filesystem held in memory, for tests. Safe to use from multiple
+ * threads, but entries returned from root() are not protected.
+ */
 class MemoryFilesystem : public Filesystem {
 public:
     class Entry {
-    public:
-        std::string          _name;
-
-    public:
-        Type                 _type;
-        std::vector<uint8_t> _contents;
-        std::vector<Entry>   _children;
+    private:
+        std::string                             _name;
+        Type                                    _type;
+        std::vector<uint8_t>                    _contents;
+        std::vector<Entry>                      _children;
+        std::unordered_map<std::string, size_t> _childIndexes;
+        ext::optional<Stamp>                    _stamp;
 
     private:
         Entry(std::string const &name, Type type);
 
     public:
-        std::string &name()
-        { return _name; }
         std::string const &name() const
         { return _name; }
 
@@ -41,25 +46,51 @@ public:
         { return _contents; }
         std::vector<uint8_t> const &contents() const
         { return _contents; }
-        std::vector<Entry> &children()
-        { return _children; }
         std::vector<Entry> const &children() const
         { return _children; }
 
     public:
+        /*
+         * The stamp for this entry, if it has its own.
+         */
+        ext::optional<Stamp> const &stamp() const
+        { return _stamp; }
+        void setStamp(ext::optional<Stamp> const &stamp)
+        { _stamp = stamp; }
+
+    public:
+        /*
+         * Find a child by name. Children are indexed by name, so this
+         * doesn't depend on the number of children.
+         */
         MemoryFilesystem::Entry *child(std::string const &name);
         MemoryFilesystem::Entry const *child(std::string const &name) const;
 
+        /*
+         * Add a child, replacing any child with the same name. Returns the
+         * added child, valid until the children next change.
+         */
+        MemoryFilesystem::Entry *insert(Entry entry);
+
+        /*
+         * Remove a child by name. Fails if there is no such child.
+         */
+        bool remove(std::string const &name);
+
     public:
         static Entry File(std::string const &name, std::vector<uint8_t> const &contents);
         static Entry Directory(std::string const &name, std::vector<Entry> const &children);
     };
 
 private:
-    Entry _root;
+    Entry                        _root;
+    ext::optional<Stamp>         _stamp;
+    int64_t                      _modificationTime;
+    mutable std::recursive_mutex _mutex;
 
 public:
     MemoryFilesystem(std::vector<Entry> const &entries);
+    MemoryFilesystem(MemoryFilesystem const &other);
 
 public:
     Entry &root()
@@ -67,6 +98,26 @@ public:
     Entry const &root() const
     { return _root; }
 
+public:
+    /*
+     * Give every file and directory a stamp, or just the entry at a path.
+     * Without one, no stamps can be read, as on a filesystem without them.
+     * Once stamps are used, writing a file gives it its own stamp, later
+     * than any before. Directory stamps only change when set.
+     */
+    void setStamp(Stamp const &stamp);
+    bool setStamp(std::string const &path, Stamp const &stamp);
+
+public:
+    /*
+     * Copy a directory tree from another filesystem, such as a real one, to
+     * a directory here, creating it if needed. Files are read once each and
+     * added directly, without resolving each path. Symbolic links to files
+     * are copied as files; links to directories are skipped, since they can
+     * form cycles.
+     */
+    bool import(Filesystem const *filesystem, std::string const &from, std::string const &to);
+
 public:
     virtual bool exists(std::string const &path) const;
     virtual ext::optional<Type> type(std::string const &path) const;
@@ -79,6 +130,7 @@ public:
 public:
     virtual ext::optional<Permissions> readFilePermissions(std::string const &path) const;
     virtual bool writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions);
+    virtual ext::optional<Stamp> readFileStamp(std::string const &path) const;
     virtual bool createFile(std::string const &path);
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
@@ -96,8 +148,10 @@ public:
 public:
     virtual ext::optional<Permissions> readDirectoryPermissions(std::string const &path) const;
     virtual bool writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive);
+    virtual ext::optional<Stamp> readDirectoryStamp(std::string const &path) const;
     virtual bool createDirectory(std::string const &path, bool recursive);
     virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const;
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const;
     virtual bool copyDirectory(std::string const &from, std::string const &to, bool recursive);
     virtual bool removeDirectory(std::string const &path, bool recursive);
 
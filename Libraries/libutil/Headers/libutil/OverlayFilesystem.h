@@ -0,0 +1,111 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_OverlayFilesystem_h
+#define __libutil_OverlayFilesystem_h
+
+#include <libutil/Filesystem.h>
+
+#include <mutex>
+#include <unordered_set>
+
+namespace libutil {
+
+/*
+ * Layers a writable filesystem over a read-only one. Reads see the upper
+ * filesystem where it has an entry, and the lower filesystem otherwise.
+ * All changes are made in the upper filesystem: files are copied up when
+ * their permissions change, and the directories containing new entries
+ * are created in it as needed. Removing an entry that is in the lower
+ * filesystem hides it, and everything below it, until it is created again.
+ *
+ * The lower filesystem is never changed, so it can be shared, for example
+ * by several invocations each writing to their own upper filesystem. Safe
+ * to use from multiple threads if both filesystems are.
+ */
+class OverlayFilesystem : public Filesystem {
+private:
+    Filesystem const                *_lower;
+    Filesystem                      *_upper;
+
+private:
+    std::unordered_set<std::string>  _removed;
+    mutable std::mutex               _removedMutex;
+
+public:
+    OverlayFilesystem(Filesystem const *lower, Filesystem *upper);
+
+public:
+    /*
+     * The read-only filesystem underneath.
+     */
+    Filesystem const *lower() const
+    { return _lower; }
+
+    /*
+     * The filesystem changes are made in.
+     */
+    Filesystem *upper() const
+    { return _upper; }
+
+private:
+    enum class Layer {
+        None,
+        Upper,
+        Lower,
+    };
+
+    bool hidden(std::string const &path) const;
+    void hide(std::string const &path);
+    Layer layer(std::string const &path) const;
+    bool createParent(std::string const &path);
+    bool readMergedDirectory(std::string const &path, ext::optional<std::string> const &subpath, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const;
+
+public:
+    virtual bool exists(std::string const &path) const;
+    virtual ext::optional<Type> type(std::string const &path) const;
+
+public:
+    virtual bool isReadable(std::string const &path) const;
+    virtual bool isWritable(std::string const &path) const;
+    virtual bool isExecutable(std::string const &path) const;
+
+public:
+    virtual ext::optional<Permissions> readFilePermissions(std::string const &path) const;
+    virtual bool writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions);
+    virtual ext::optional<Stamp> readFileStamp(std::string const &path) const;
+    virtual bool createFile(std::string const &path);
+    virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
+    virtual std::unique_ptr<Mapping const> map(std::string const &path) const;
+    virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool removeFile(std::string const &path);
+
+public:
+    virtual ext::optional<Permissions> readSymbolicLinkPermissions(std::string const &path) const;
+    virtual bool writeSymbolicLinkPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions);
+    virtual ext::optional<std::string> readSymbolicLink(std::string const &path) const;
+    virtual bool writeSymbolicLink(std::string const &target, std::string const &path);
+    virtual bool removeSymbolicLink(std::string const &path);
+
+public:
+    virtual ext::optional<Permissions> readDirectoryPermissions(std::string const &path) const;
+    virtual bool writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive);
+    virtual ext::optional<Stamp> readDirectoryStamp(std::string const &path) const;
+    virtual bool createDirectory(std::string const &path, bool recursive);
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const;
+    virtual bool readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const;
+    virtual bool removeDirectory(std::string const &path, bool recursive);
+
+public:
+    virtual std::string resolvePath(std::string const &path) const;
+};
+
+}
+
+#endif  // !__libutil_OverlayFilesystem_h
@@ -0,0 +1,46 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_Ownership_h
+#define __libutil_Ownership_h
+
+#include <string>
+
+namespace libutil {
+
+/*
+ * Checks that files and connections belong to the current user. Files
+ * other users can replace in shared directories, such as the temporary
+ * directory, can't be trusted; keep them in a private directory instead.
+ */
+class Ownership {
+public:
+    /*
+     * Test if a path is a directory, not a symbolic link, owned by the
+     * current user and not accessible to anyone else.
+     */
+    static bool IsPrivateDirectory(std::string const &path);
+
+    /*
+     * Create a private directory, if it doesn't exist. Fails if it can't
+     * be created, or if it exists but is not private, such as when another
+     * user created it first.
+     */
+    static bool CreatePrivateDirectory(std::string const &path);
+
+public:
+    /*
+     * Test if the other end of a local socket is the current user.
+     */
+    static bool SocketPeerIsUser(int fd);
+};
+
+}
+
+#endif  // !__libutil_Ownership_h
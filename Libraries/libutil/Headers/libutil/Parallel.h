@@ -0,0 +1,50 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_Parallel_h
+#define __libutil_Parallel_h
+
+#include <functional>
+
+#include <cstddef>
+
+namespace libutil {
+
+/*
+ * Runs independent pieces of work at the same time. Threads beyond the
+ * calling one come from a budget shared by the whole process, so work
+ * started from inside other parallel work doesn't multiply the threads.
+ */
+class Parallel {
+public:
+    /*
+     * The number of jobs the process runs at once: the number set with
+     * SetDefaultJobs(), or otherwise the number of processors.
+     */
+    static size_t DefaultJobs();
+
+    /*
+     * Set the number of jobs the process runs at once, such as from a
+     * jobs option. Zero uses the number of processors again.
+     */
+    static void SetDefaultJobs(size_t jobs);
+
+public:
+    /*
+     * Call a function for each index up to a count, on up to a number of
+     * jobs at once, one of them the calling thread. Fewer threads are used
+     * when the process is already running its default number of jobs.
+     * Indexes are taken in order, but finish in any order.
+     */
+    static void For(size_t jobs, size_t count, std::function<void(size_t)> const &function);
+};
+
+}
+
+#endif  // !__libutil_Parallel_h
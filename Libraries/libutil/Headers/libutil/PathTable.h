@@ -0,0 +1,84 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_PathTable_h
+#define __libutil_PathTable_h
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil {
+
+/*
+ * Interns paths as small integer identifiers. Each path is stored as its
+ * last component and the identifier of its parent, so a prefix shared by
+ * many paths, such as a build directory, is stored only once. Identifiers
+ * are equal exactly when the paths are equal as strings, so hashing and
+ * comparing interned paths are integer operations.
+ *
+ * Not thread safe; use a table from one thread at a time.
+ */
+class PathTable {
+public:
+    typedef uint32_t Id;
+
+private:
+    struct Entry {
+        Id       parent;
+        uint32_t component;
+    };
+
+private:
+    std::vector<std::string>                  _components;
+    std::unordered_map<std::string, uint32_t> _componentIds;
+
+private:
+    std::vector<Entry>                        _entries;
+    std::unordered_map<uint64_t, Id>          _children;
+
+public:
+    PathTable();
+
+public:
+    /*
+     * The identifier for a path, adding it if it is new.
+     */
+    Id intern(std::string const &path);
+
+    /*
+     * The identifier for a path, if it has been added.
+     */
+    ext::optional<Id> find(std::string const &path) const;
+
+public:
+    /*
+     * The path an identifier was interned from.
+     */
+    std::string path(Id id) const;
+
+    /*
+     * The identifier of the directory containing a path, if it has been
+     * interned as part of the path.
+     */
+    ext::optional<Id> parent(Id id) const;
+
+public:
+    /*
+     * The number of interned paths, including the directories above them.
+     */
+    size_t size() const
+    { return _entries.size() - 1; }
+};
+
+}
+
+#endif // !__libutil_PathTable_h
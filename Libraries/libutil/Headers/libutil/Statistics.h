@@ -0,0 +1,108 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_Statistics_h
+#define __libutil_Statistics_h
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace libutil {
+
+/*
+ * Counts how often hot paths run, to find what makes a build slow without
+ * the cost of tracing each call. Counting is process-wide and off until
+ * started; counters cost only a check while it is off.
+ */
+class Statistics {
+public:
+    /*
+     * A named count. Counters are static objects next to the code they
+     * count, and are included in reports once constructed. Thread safe.
+     */
+    class Counter {
+    private:
+        char const           *_name;
+        bool                  _maximum;
+        std::atomic<int64_t>  _value;
+        Counter              *_next;
+
+    public:
+        /*
+         * Maximum counters report the largest value seen rather than a total.
+         */
+        explicit Counter(char const *name, bool maximum = false);
+
+    public:
+        /*
+         * Add to the total.
+         */
+        void add(int64_t value = 1)
+        {
+            if (_enabled.load(std::memory_order_relaxed)) {
+                _value.fetch_add(value, std::memory_order_relaxed);
+            }
+        }
+
+        /*
+         * Raise the maximum to a value, if it's larger.
+         */
+        void maximum(int64_t value)
+        {
+            if (_enabled.load(std::memory_order_relaxed)) {
+                int64_t current = _value.load(std::memory_order_relaxed);
+                while (value > current && !_value.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+                }
+            }
+        }
+
+    public:
+        /*
+         * The count so far.
+         */
+        int64_t value() const
+        { return _value.load(std::memory_order_relaxed); }
+
+    public:
+        Counter(Counter const &) = delete;
+        Counter &operator=(Counter const &) = delete;
+
+    private:
+        friend class Statistics;
+    };
+
+private:
+    static std::atomic<bool> _enabled;
+
+private:
+    Statistics();
+    ~Statistics();
+
+public:
+    /*
+     * Start counting, from zero.
+     */
+    static void Start();
+
+    /*
+     * If counters are counting.
+     */
+    static bool Enabled();
+
+public:
+    /*
+     * Each counter and its value, one per line, sorted by name.
+     */
+    static std::string Report();
+};
+
+}
+
+#endif // !__libutil_Statistics_h
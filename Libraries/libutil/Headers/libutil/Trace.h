@@ -0,0 +1,112 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_Trace_h
+#define __libutil_Trace_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libutil {
+
+class Filesystem;
+
+/*
+ * Records how long parts of the process take, as nested spans on each
+ * thread, for viewing in chrome://tracing. Recording is process-wide and
+ * off until started; spans created while it is off cost only a check.
+ *
+ * Spans can also record the memory allocated while they ran: the most
+ * allocated at once, and how much was still allocated when they ended.
+ * Allocations are counted on each thread, so memory a span allocates is
+ * attributed to it even if another thread frees it later.
+ */
+class Trace {
+public:
+    /*
+     * Records a span from its creation until it is destroyed. Thread safe.
+     */
+    class Span {
+    private:
+        char const  *_name;
+        std::string  _detail;
+        int64_t      _start;
+        std::vector<std::pair<char const *, int64_t>> _values;
+
+    private:
+        Span        *_parent;
+        int64_t      _allocatedStart;
+        int64_t      _allocatedPeak;
+
+    public:
+        explicit Span(char const *name, std::string const &detail = std::string());
+        ~Span();
+
+    public:
+        /*
+         * Record a measurement along with the span, such as the resources
+         * used by the work it covers. Ignored when not recording.
+         */
+        void value(char const *name, int64_t value);
+
+    public:
+        Span(Span const &) = delete;
+        Span &operator=(Span const &) = delete;
+
+    private:
+        friend class Trace;
+    };
+
+private:
+    Trace();
+    ~Trace();
+
+public:
+    /*
+     * Start recording spans.
+     */
+    static void Start();
+
+    /*
+     * If spans are being recorded.
+     */
+    static bool Enabled();
+
+public:
+    /*
+     * Also record the memory allocated during spans started from now on.
+     * Allocations are only seen if the executable reports them below, from
+     * its replacement `operator new` and `operator delete`.
+     */
+    static void StartMemory();
+
+    /*
+     * Report memory allocated or freed on the current thread. Cheap when
+     * memory isn't being recorded; must not allocate.
+     */
+    static void Allocated(size_t bytes);
+    static void Freed(size_t bytes);
+
+    /*
+     * Write the spans recorded so far in the trace event format.
+     */
+    static bool Write(Filesystem *filesystem, std::string const &path);
+
+    /*
+     * The spans recorded so far in the trace event format.
+     */
+    static std::string Serialize();
+};
+
+}
+
+#endif // !__libutil_Trace_h
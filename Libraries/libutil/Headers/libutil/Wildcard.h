@@ -10,12 +10,56 @@
 #ifndef __libutil_Wildcard_h
 #define __libutil_Wildcard_h
 
+#include <bitset>
 #include <string>
+#include <vector>
 
 namespace libutil {
 
+/*
+ * Matches strings against patterns where `*` matches any run of characters
+ * and `[abc]` matches any one of the characters listed. Matching takes at
+ * most time proportional to the pattern length times the string length.
+ */
 struct Wildcard {
+    /*
+     * A pattern parsed once, for matching against many strings.
+     */
+    class Pattern {
+    public:
+        /*
+         * A star, or the characters allowed in one position.
+         */
+        struct Token {
+            bool             star;
+            std::bitset<256> characters;
+        };
+
+    private:
+        std::vector<Token> _tokens;
+        bool               _literal;
+        std::string        _pattern;
+
+    public:
+        Pattern(std::vector<Token> const &tokens, bool literal, std::string const &pattern);
+
+    public:
+        /*
+         * The pattern as written.
+         */
+        std::string const &pattern() const
+        { return _pattern; }
+
+    public:
+        /*
+         * If the whole string matches the pattern.
+         */
+        bool match(std::string const &string) const;
+    };
+
     static bool Match(std::string const &pattern, std::string const &string);
+
+    static Pattern Compile(std::string const &pattern);
 };
 
 }
@@ -0,0 +1,304 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/CachingFilesystem.h>
+
+using libutil::CachingFilesystem;
+using libutil::Filesystem;
+using libutil::Permissions;
+
+CachingFilesystem::
+CachingFilesystem(Filesystem *filesystem) :
+    _filesystem(filesystem),
+    _generation(0)
+{
+}
+
+void CachingFilesystem::
+invalidate()
+{
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+    _entries.clear();
+    _executables.clear();
+    _generation++;
+}
+
+template<typename T>
+T CachingFilesystem::
+cached(std::string const &path, ext::optional<T> Entry::*field, std::function<T()> const &compute) const
+{
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(_entriesMutex);
+
+        auto it = _entries.find(path);
+        if (it != _entries.end() && it->second.*field) {
+            return *(it->second.*field);
+        }
+
+        generation = _generation;
+    }
+
+    /* Check outside the lock; checking twice gives the same result. */
+    T value = compute();
+
+    /* A change made while checking may have come too late for the result. */
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+    if (_generation == generation) {
+        _entries[path].*field = value;
+    }
+    return value;
+}
+
+bool CachingFilesystem::
+exists(std::string const &path) const
+{
+    return cached<bool>(path, &Entry::exists, [&] { return _filesystem->exists(path); });
+}
+
+ext::optional<Filesystem::Type> CachingFilesystem::
+type(std::string const &path) const
+{
+    return cached<ext::optional<Type>>(path, &Entry::type, [&] { return _filesystem->type(path); });
+}
+
+bool CachingFilesystem::
+isReadable(std::string const &path) const
+{
+    return cached<bool>(path, &Entry::readable, [&] { return _filesystem->isReadable(path); });
+}
+
+bool CachingFilesystem::
+isWritable(std::string const &path) const
+{
+    return cached<bool>(path, &Entry::writable, [&] { return _filesystem->isWritable(path); });
+}
+
+bool CachingFilesystem::
+isExecutable(std::string const &path) const
+{
+    return cached<bool>(path, &Entry::executable, [&] { return _filesystem->isExecutable(path); });
+}
+
+ext::optional<Permissions> CachingFilesystem::
+readFilePermissions(std::string const &path) const
+{
+    return _filesystem->readFilePermissions(path);
+}
+
+bool CachingFilesystem::
+writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions)
+{
+    bool result = _filesystem->writeFilePermissions(path, operation, permissions);
+    invalidate();
+    return result;
+}
+
+ext::optional<Filesystem::Stamp> CachingFilesystem::
+readFileStamp(std::string const &path) const
+{
+    return _filesystem->readFileStamp(path);
+}
+
+ext::optional<Filesystem::Stamp> CachingFilesystem::
+readDirectoryStamp(std::string const &path) const
+{
+    return _filesystem->readDirectoryStamp(path);
+}
+
+bool CachingFilesystem::
+createFile(std::string const &path)
+{
+    bool result = _filesystem->createFile(path);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext::optional<size_t> length) const
+{
+    return _filesystem->read(contents, path, offset, length);
+}
+
+std::unique_ptr<Filesystem::Mapping const> CachingFilesystem::
+map(std::string const &path) const
+{
+    return _filesystem->map(path);
+}
+
+bool CachingFilesystem::
+write(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    bool result = _filesystem->write(contents, path);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+copyFile(std::string const &from, std::string const &to)
+{
+    bool result = _filesystem->copyFile(from, to);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+moveFile(std::string const &from, std::string const &to)
+{
+    bool result = _filesystem->moveFile(from, to);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+removeFile(std::string const &path)
+{
+    bool result = _filesystem->removeFile(path);
+    invalidate();
+    return result;
+}
+
+ext::optional<Permissions> CachingFilesystem::
+readSymbolicLinkPermissions(std::string const &path) const
+{
+    return _filesystem->readSymbolicLinkPermissions(path);
+}
+
+bool CachingFilesystem::
+writeSymbolicLinkPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions)
+{
+    bool result = _filesystem->writeSymbolicLinkPermissions(path, operation, permissions);
+    invalidate();
+    return result;
+}
+
+ext::optional<std::string> CachingFilesystem::
+readSymbolicLink(std::string const &path) const
+{
+    return _filesystem->readSymbolicLink(path);
+}
+
+bool CachingFilesystem::
+writeSymbolicLink(std::string const &target, std::string const &path)
+{
+    bool result = _filesystem->writeSymbolicLink(target, path);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+copySymbolicLink(std::string const &from, std::string const &to)
+{
+    bool result = _filesystem->copySymbolicLink(from, to);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+removeSymbolicLink(std::string const &path)
+{
+    bool result = _filesystem->removeSymbolicLink(path);
+    invalidate();
+    return result;
+}
+
+ext::optional<Permissions> CachingFilesystem::
+readDirectoryPermissions(std::string const &path) const
+{
+    return _filesystem->readDirectoryPermissions(path);
+}
+
+bool CachingFilesystem::
+writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive)
+{
+    bool result = _filesystem->writeDirectoryPermissions(path, operation, permissions, recursive);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+createDirectory(std::string const &path, bool recursive)
+{
+    bool result = _filesystem->createDirectory(path, recursive);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const
+{
+    return _filesystem->readDirectory(path, recursive, cb);
+}
+
+bool CachingFilesystem::
+readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const
+{
+    return _filesystem->readDirectory(path, recursive, cb);
+}
+
+bool CachingFilesystem::
+copyDirectory(std::string const &from, std::string const &to, bool recursive)
+{
+    bool result = _filesystem->copyDirectory(from, to, recursive);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+copyDirectoryWithPermissions(std::string const &from, std::string const &to, Permissions::Operation operation, Permissions permissions)
+{
+    bool result = _filesystem->copyDirectoryWithPermissions(from, to, operation, permissions);
+    invalidate();
+    return result;
+}
+
+bool CachingFilesystem::
+removeDirectory(std::string const &path, bool recursive)
+{
+    bool result = _filesystem->removeDirectory(path, recursive);
+    invalidate();
+    return result;
+}
+
+std::string CachingFilesystem::
+resolvePath(std::string const &path) const
+{
+    return _filesystem->resolvePath(path);
+}
+
+ext::optional<std::string> CachingFilesystem::
+findExecutable(std::string const &name, std::vector<std::string> const &paths) const
+{
+    /* The same tools are found in the same directories for each invocation. */
+    std::string key = name;
+    for (std::string const &path : paths) {
+        key += '\0';
+        key += path;
+    }
+
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(_entriesMutex);
+
+        auto it = _executables.find(key);
+        if (it != _executables.end()) {
+            return it->second;
+        }
+
+        generation = _generation;
+    }
+
+    ext::optional<std::string> executable = Filesystem::findExecutable(name, paths);
+
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+    if (_generation == generation) {
+        _executables.insert({ key, executable });
+    }
+    return executable;
+}
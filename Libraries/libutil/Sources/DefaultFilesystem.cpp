@@ -9,7 +9,13 @@
 
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+#include <libutil/Statistics.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <stack>
 #include <climits>
 #include <cstdlib>
@@ -21,23 +27,38 @@
 #include <libgen.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #if defined(__APPLE__) || defined(__FreeBSD__)
 #include <copyfile.h>
+#elif defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
 #endif
 
 using libutil::DefaultFilesystem;
 using libutil::Filesystem;
+using libutil::Parallel;
 using libutil::Permissions;
+using libutil::Statistics;
+
+static Statistics::Counter Stats("Filesystem stats");
+static Statistics::Counter Reads("Filesystem reads");
+static Statistics::Counter BytesRead("Filesystem bytes read");
 
 bool DefaultFilesystem::
 exists(std::string const &path) const
 {
+    Stats.add();
     return ::access(path.c_str(), F_OK) == 0;
 }
 
 ext::optional<Filesystem::Type> DefaultFilesystem::
 type(std::string const &path) const
 {
+    Stats.add();
     struct stat st;
     if (::lstat(path.c_str(), &st) < 0) {
         return ext::nullopt;
@@ -58,18 +79,21 @@ type(std::string const &path) const
 bool DefaultFilesystem::
 isReadable(std::string const &path) const
 {
+    Stats.add();
     return ::access(path.c_str(), R_OK) == 0;
 }
 
 bool DefaultFilesystem::
 isWritable(std::string const &path) const
 {
+    Stats.add();
     return ::access(path.c_str(), W_OK) == 0;
 }
 
 bool DefaultFilesystem::
 isExecutable(std::string const &path) const
 {
+    Stats.add();
     return ::access(path.c_str(), X_OK) == 0;
 }
 
@@ -95,6 +119,7 @@ ModePermissions(mode_t mode)
 ext::optional<Permissions> DefaultFilesystem::
 readFilePermissions(std::string const &path) const
 {
+    Stats.add();
     struct stat st;
     if (::stat(path.c_str(), &st) < 0) {
         return ext::nullopt;
@@ -103,9 +128,35 @@ readFilePermissions(std::string const &path) const
     return ModePermissions(st.st_mode);
 }
 
+static Filesystem::Stamp
+StatStamp(struct stat const &st)
+{
+    Filesystem::Stamp stamp;
+    stamp.size = static_cast<uint64_t>(st.st_size);
+#if defined(__APPLE__)
+    stamp.modificationTime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp.modificationTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return stamp;
+}
+
+ext::optional<Filesystem::Stamp> DefaultFilesystem::
+readFileStamp(std::string const &path) const
+{
+    Stats.add();
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0 || !S_ISREG(st.st_mode)) {
+        return ext::nullopt;
+    }
+
+    return StatStamp(st);
+}
+
 ext::optional<Permissions> DefaultFilesystem::
 readSymbolicLinkPermissions(std::string const &path) const
 {
+    Stats.add();
     struct stat st;
     if (::lstat(path.c_str(), &st) < 0) {
         return ext::nullopt;
@@ -117,6 +168,7 @@ readSymbolicLinkPermissions(std::string const &path) const
 ext::optional<Permissions> DefaultFilesystem::
 readDirectoryPermissions(std::string const &path) const
 {
+    Stats.add();
     struct stat st;
     if (::stat(path.c_str(), &st) < 0) {
         return ext::nullopt;
@@ -125,6 +177,18 @@ readDirectoryPermissions(std::string const &path) const
     return ModePermissions(st.st_mode);
 }
 
+ext::optional<Filesystem::Stamp> DefaultFilesystem::
+readDirectoryStamp(std::string const &path) const
+{
+    Stats.add();
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0 || !S_ISDIR(st.st_mode)) {
+        return ext::nullopt;
+    }
+
+    return StatStamp(st);
+}
+
 static mode_t
 PermissionsMode(Permissions permissions)
 {
@@ -263,6 +327,8 @@ createFile(std::string const &path)
 bool DefaultFilesystem::
 read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext::optional<size_t> length) const
 {
+    Reads.add();
+
     FILE *fp = std::fopen(path.c_str(), "rb");
     if (fp == nullptr) {
         return false;
@@ -279,21 +345,20 @@ read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext
         return false;
     }
 
-    if (length) {
-        if (offset + *length > size) {
-            std::fclose(fp);
-            return false;
-        }
-
-        size = *length;
+    if (offset > static_cast<size_t>(size) || (length && *length > size - offset)) {
+        std::fclose(fp);
+        return false;
     }
 
+    size = (length ? *length : size - offset);
+
     if (std::fseek(fp, offset, SEEK_SET) != 0) {
         std::fclose(fp);
         return false;
     }
 
-    *contents = std::vector<uint8_t>(size);
+    /* Reuse the buffer's storage if it's large enough. */
+    contents->resize(size);
 
     if (size > 0) {
         if (std::fread(contents->data(), size, 1, fp) != 1) {
@@ -303,9 +368,61 @@ read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext
     }
 
     std::fclose(fp);
+    BytesRead.add(size);
     return true;
 }
 
+/*
+ * A mapping of a file's pages, unmapped when destroyed.
+ */
+class FileMapping : public Filesystem::Mapping {
+public:
+    FileMapping(void *data, size_t size) :
+        Filesystem::Mapping(static_cast<uint8_t const *>(data), size)
+    {
+    }
+
+    virtual ~FileMapping()
+    {
+        ::munmap(const_cast<uint8_t *>(this->data()), this->size());
+    }
+};
+
+std::unique_ptr<Filesystem::Mapping const> DefaultFilesystem::
+map(std::string const &path) const
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    /* Empty files can't be mapped, but have no contents to copy. */
+    if (st.st_size == 0) {
+        ::close(fd);
+        Reads.add();
+        return std::unique_ptr<Mapping const>(new Mapping(nullptr, 0));
+    }
+
+    void *data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        /* Some files, such as on some network filesystems, can't be mapped. */
+        return Filesystem::map(path);
+    }
+
+    /* Counted once mapped, as falling back reads the file instead. */
+    Reads.add();
+    BytesRead.add(st.st_size);
+    return std::unique_ptr<Mapping const>(new FileMapping(data, st.st_size));
+}
+
 bool DefaultFilesystem::
 write(std::vector<uint8_t> const &contents, std::string const &path)
 {
@@ -327,6 +444,74 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
     return true;
 }
 
+#if defined(__linux__)
+static bool
+CopyFileDescriptor(int in, int out, size_t size)
+{
+    size_t copied = 0;
+
+#if defined(FICLONE)
+    /* A reflink shares the source's extents; nothing is copied at all. */
+    if (::ioctl(out, FICLONE, in) == 0) {
+        return true;
+    }
+#endif
+
+#if defined(SYS_copy_file_range)
+    /* Copy within the kernel; this can also reflink or offload the copy. */
+    while (copied < size) {
+        long result = ::syscall(SYS_copy_file_range, in, nullptr, out, nullptr, size - copied, 0);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result <= 0) {
+            break;
+        }
+        copied += static_cast<size_t>(result);
+    }
+#endif
+
+    /* Older kernels can't copy between filesystems; sendfile still copies in the kernel. */
+    while (copied < size) {
+        ssize_t result = ::sendfile(out, in, nullptr, size - copied);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result <= 0) {
+            break;
+        }
+        copied += static_cast<size_t>(result);
+    }
+
+    /*
+     * Stream whatever is left in chunks. This also picks up anything
+     * appended to the source after it was measured.
+     */
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(1024 * 1024);
+    while (true) {
+        ssize_t length = ::read(in, buffer.data(), buffer.size());
+        if (length < 0 && errno == EINTR) {
+            continue;
+        } else if (length < 0) {
+            return false;
+        } else if (length == 0) {
+            break;
+        }
+
+        ssize_t written = 0;
+        while (written < length) {
+            ssize_t result = ::write(out, buffer.data() + written, length - written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            } else if (result < 0) {
+                return false;
+            }
+            written += result;
+        }
+    }
+
+    return true;
+}
+#endif
+
 bool DefaultFilesystem::
 copyFile(std::string const &from, std::string const &to)
 {
@@ -362,11 +547,58 @@ copyFile(std::string const &from, std::string const &to)
     ::copyfile_state_free(state);
 
     return true;
+#elif defined(__linux__)
+    int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(in, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(in);
+        return false;
+    }
+
+    int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    bool success = CopyFileDescriptor(in, out, static_cast<size_t>(st.st_size));
+
+    /* Keep the modification time, as copyfile() does, so the copy's stamp matches. */
+    struct timespec times[2] = { st.st_atim, st.st_mtim };
+    if (success && ::futimens(out, times) != 0) {
+        success = false;
+    }
+
+    ::close(in);
+    if (::close(out) != 0) {
+        success = false;
+    }
+
+    return success;
 #else
     return Filesystem::copyFile(from, to);
 #endif
 }
 
+bool DefaultFilesystem::
+moveFile(std::string const &from, std::string const &to)
+{
+    if (this->type(from) != Type::File) {
+        return false;
+    }
+
+    /* Renaming replaces the destination atomically. */
+    if (::rename(from.c_str(), to.c_str()) != 0) {
+        return false;
+    }
+
+    return true;
+}
+
 bool DefaultFilesystem::
 removeFile(std::string const &path)
 {
@@ -469,7 +701,7 @@ createDirectory(std::string const &path, bool recursive)
             create.pop();
         }
     } else {
-        if (::mkdir(path.c_str(), mode) != 0) {
+        if (::mkdir(path.c_str(), mode) != 0 && (errno != EEXIST || this->type(path) != Type::Directory)) {
             return false;
         }
     }
@@ -477,8 +709,39 @@ createDirectory(std::string const &path, bool recursive)
     return true;
 }
 
+static ext::optional<Filesystem::Type>
+DirectoryEntryType(DefaultFilesystem const *filesystem, struct dirent const *entry, std::string const &full)
+{
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(__APPLE__) || defined(__FreeBSD__)
+    switch (entry->d_type) {
+        case DT_REG:
+            return Filesystem::Type::File;
+        case DT_LNK:
+            return Filesystem::Type::SymbolicLink;
+        case DT_DIR:
+            return Filesystem::Type::Directory;
+        case DT_UNKNOWN:
+            /* Not all filesystems provide the type; check directly. */
+            break;
+        default:
+            /* Unsupported file type, e.g. character or block device. */
+            return ext::nullopt;
+    }
+#endif
+
+    return filesystem->type(full);
+}
+
 bool DefaultFilesystem::
 readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const
+{
+    return this->readDirectory(path, recursive, [&cb](std::string const &name, ext::optional<Type> type) {
+        cb(name);
+    });
+}
+
+bool DefaultFilesystem::
+readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const
 {
     std::function<bool(std::string const &, ext::optional<std::string> const &)> process =
         [this, &recursive, &cb, &process](std::string const &absolute, ext::optional<std::string> const &relative) -> bool {
@@ -488,37 +751,31 @@ readDirectory(std::string const &path, bool recursive, std::function<void(std::s
         }
 
         /* Report children. */
+        std::vector<std::string> subdirectories;
         while (struct dirent *entry = ::readdir(dp)) {
             if (::strcmp(entry->d_name, ".") == 0 || ::strcmp(entry->d_name, "..") == 0) {
                 continue;
             }
 
             std::string path = (relative ? *relative + "/" + entry->d_name : entry->d_name);
-            cb(path);
-        }
+            ext::optional<Type> type = DirectoryEntryType(this, entry, absolute + "/" + entry->d_name);
+            cb(path, type);
 
-        /* Process subdirectories. */
-        if (recursive) {
-            ::rewinddir(dp);
-
-            while (struct dirent *entry = ::readdir(dp)) {
-                if (::strcmp(entry->d_name, ".") == 0 || ::strcmp(entry->d_name, "..") == 0) {
-                    continue;
-                }
+            if (recursive && type == Type::Directory) {
+                subdirectories.push_back(entry->d_name);
+            }
+        }
 
-                std::string full = absolute + "/" + entry->d_name;
+        ::closedir(dp);
 
-                if (this->type(full) == Type::Directory) {
-                    std::string path = (relative ? *relative + "/" + entry->d_name : entry->d_name);
-                    if (!process(full, path)) {
-                        ::closedir(dp);
-                        return false;
-                    }
-                }
+        /* Process subdirectories. */
+        for (std::string const &subdirectory : subdirectories) {
+            std::string path = (relative ? *relative + "/" + subdirectory : subdirectory);
+            if (!process(absolute + "/" + subdirectory, path)) {
+                return false;
             }
         }
 
-        ::closedir(dp);
         return true;
     };
 
@@ -553,46 +810,204 @@ copyDirectory(std::string const &from, std::string const &to, bool recursive)
 }
 
 bool DefaultFilesystem::
-removeDirectory(std::string const &path, bool recursive)
+copyDirectoryWithPermissions(std::string const &from, std::string const &to, Permissions::Operation operation, Permissions permissions)
 {
-    if (recursive) {
-        bool success = true;
+    if (this->type(from) != Type::Directory) {
+        return false;
+    }
 
-        success &= this->readDirectory(path, recursive, [this, &path, &success](std::string const &name) {
-            std::string full = path + "/" + name;
+    if (this->type(to) == Type::Directory) {
+        if (!this->removeDirectory(to, true)) {
+            return false;
+        }
+    }
 
-            ext::optional<Type> type = this->type(full);
-            if (!type) {
+    if (!this->createDirectory(to, false) || !this->writeDirectoryPermissions(to, operation, permissions, false)) {
+        return false;
+    }
+
+    /*
+     * Create the directory structure and symbolic links while walking, since
+     * that is cheap. File contents are collected and copied afterwards.
+     */
+    bool success = true;
+    std::vector<std::string> files;
+
+    success &= this->readDirectory(from, true, [this, &from, &to, &operation, &permissions, &success, &files](std::string const &path, ext::optional<Type> type) {
+        std::string fromPath = from + "/" + path;
+        std::string toPath = to + "/" + path;
+
+        if (!type) {
+            success = false;
+            return;
+        }
+
+        switch (*type) {
+            case Type::File:
+                files.push_back(path);
+                break;
+            case Type::SymbolicLink:
+                if (!this->copySymbolicLink(fromPath, toPath) || !this->writeSymbolicLinkPermissions(toPath, operation, permissions)) {
+                    success = false;
+                }
+                break;
+            case Type::Directory:
+                if (!this->createDirectory(toPath, false) || !this->writeDirectoryPermissions(toPath, operation, permissions, false)) {
+                    success = false;
+                }
+                break;
+        }
+    });
+
+    if (!success) {
+        return false;
+    }
+
+    /*
+     * Copy files in parallel. Each copy is independent, and most of the
+     * time in copying a bundle is spent waiting on the files themselves.
+     */
+    std::atomic<bool> failed(false);
+    Parallel::For(Parallel::DefaultJobs(), files.size(), [&](size_t index) {
+        if (failed) {
+            return;
+        }
+
+        std::string toPath = to + "/" + files[index];
+        if (!this->copyFile(from + "/" + files[index], toPath) || !this->writeFilePermissions(toPath, operation, permissions)) {
+            failed = true;
+        }
+    });
+
+    return !failed;
+}
+
+/*
+ * Remove everything in a directory except its subdirectories, which are
+ * added to the list to empty next. Entries are removed relative to the
+ * open directory, so their full paths aren't looked up again.
+ */
+static bool
+RemoveDirectoryFiles(std::string const &path, std::vector<std::string> *directories)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    DIR *dir = ::fdopendir(fd);
+    if (dir == nullptr) {
+        ::close(fd);
+        return false;
+    }
+
+    /* Read every entry before removing any, as removing can skip entries. */
+    std::vector<std::pair<std::string, bool>> entries;
+    bool success = true;
+    while (struct dirent *entry = ::readdir(dir)) {
+        if (::strcmp(entry->d_name, ".") == 0 || ::strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        bool directory;
+        if (entry->d_type != DT_UNKNOWN) {
+            directory = (entry->d_type == DT_DIR);
+        } else {
+            struct stat st;
+            if (::fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                success = false;
+                break;
+            }
+            directory = S_ISDIR(st.st_mode);
+        }
+
+        entries.push_back({ entry->d_name, directory });
+    }
+
+    for (auto const &entry : entries) {
+        if (!success) {
+            break;
+        }
+
+        if (entry.second) {
+            directories->push_back(path + "/" + entry.first);
+        } else if (::unlinkat(fd, entry.first.c_str(), 0) != 0) {
+            success = false;
+        }
+    }
+
+    ::closedir(dir);
+    return success;
+}
+
+bool DefaultFilesystem::
+removeDirectory(std::string const &path, bool recursive)
+{
+    if (recursive) {
+        /*
+         * Empty directories in the order they are found, so each directory
+         * comes after its parent. Small trees are emptied on this thread;
+         * once there are enough directories waiting, the rest are emptied
+         * on up to the default number of jobs.
+         */
+        std::vector<std::string> directories = { path };
+        size_t next = 0;
+        bool failed = false;
+
+        size_t count = Parallel::DefaultJobs();
+        while (next < directories.size() && (count <= 1 || directories.size() - next < count)) {
+            std::vector<std::string> found;
+            if (!RemoveDirectoryFiles(directories[next++], &found)) {
                 return false;
             }
+            directories.insert(directories.end(), found.begin(), found.end());
+        }
 
-            switch (*type) {
-                case Type::File:
-                    if (!this->removeFile(full)) {
-                        success = false;
-                        return false;
-                    }
-                    break;
-                case Type::SymbolicLink:
-                    if (!this->removeSymbolicLink(full)) {
-                        success = false;
-                        return false;
+        if (next < directories.size()) {
+            std::mutex mutex;
+            std::condition_variable condition;
+            size_t active = 0;
+
+            auto work = [&directories, &next, &failed, &mutex, &condition, &active] {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    /* Finished once nothing is waiting and nothing could find more. */
+                    condition.wait(lock, [&] { return failed || next < directories.size() || active == 0; });
+                    if (failed || next >= directories.size()) {
+                        break;
                     }
-                    break;
-                case Type::Directory:
-                    if (!this->removeDirectory(full, false)) {
-                        success = false;
-                        return false;
-                    }
-                    break;
-            }
 
-            return true;
-        });
+                    std::string directory = directories[next++];
+                    active++;
+                    lock.unlock();
 
-        if (!success) {
+                    std::vector<std::string> found;
+                    bool success = RemoveDirectoryFiles(directory, &found);
+
+                    lock.lock();
+                    active--;
+                    directories.insert(directories.end(), found.begin(), found.end());
+                    failed |= !success;
+                    condition.notify_all();
+                }
+            };
+
+            /* Each job takes directories until there are none left. */
+            Parallel::For(count, count, [&](size_t) {
+                work();
+            });
+        }
+
+        if (failed) {
             return false;
         }
+
+        /* Now only directories are left; remove each after its subdirectories. */
+        for (size_t index = directories.size() - 1; index > 0; --index) {
+            if (::rmdir(directories[index].c_str()) != 0) {
+                return false;
+            }
+        }
     }
 
     if (::rmdir(path.c_str()) != 0) {
@@ -9,39 +9,57 @@
 
 #include <libutil/Escape.h>
 
+#include <cstdio>
+#include <cstring>
+
 using libutil::Escape;
 
-std::string Escape::
-Shell(std::string const &value)
+static bool
+ShellSafe(char c)
 {
-    static std::string const *escaped = nullptr;
-    if (escaped == nullptr) {
-        std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-        std::string digits = "0123456789";
-        escaped = new std::string(alphabet + digits + "@%_-+=:,./");
-    }
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+        (c != '\0' && ::strchr("@%_-+=:,./", c) != nullptr);
+}
 
-    if (value.find_first_not_of(*escaped) == std::string::npos) {
-        return value;
-    } else {
-        std::string result;
-        result.reserve(value.size() + 4);
-        result += "'";
-
-        std::string::size_type offset = 0;
-        std::string::size_type previous = 0;
-        while ((offset = value.find("'", offset)) != std::string::npos) {
-            result.append(value.data() + previous, offset - previous);
-            result += "'\\''";
-
-            offset += 1;
-            previous = offset;
+void Escape::
+Shell(std::string const &value, std::string *result)
+{
+    /* Most arguments need no quoting; append them as is. */
+    bool quote = false;
+    for (char c : value) {
+        if (!ShellSafe(c)) {
+            quote = true;
+            break;
         }
-        result.append(value.data() + previous, value.size() - previous);
+    }
 
-        result += "'";
-        return result;
+    if (!quote) {
+        result->append(value);
+        return;
     }
+
+    result->push_back('\'');
+
+    std::string::size_type offset = 0;
+    std::string::size_type previous = 0;
+    while ((offset = value.find('\'', offset)) != std::string::npos) {
+        result->append(value.data() + previous, offset - previous);
+        result->append("'\\''");
+
+        offset += 1;
+        previous = offset;
+    }
+    result->append(value.data() + previous, value.size() - previous);
+
+    result->push_back('\'');
+}
+
+std::string Escape::
+Shell(std::string const &value)
+{
+    std::string result;
+    Shell(value, &result);
+    return result;
 }
 
 std::string Escape::
@@ -60,3 +78,33 @@ Makefile(std::string const &value)
 
     return result;
 }
+
+std::string Escape::
+JSON(std::string const &value)
+{
+    std::string result;
+    result.reserve(value.size() + 2);
+    result += '"';
+
+    for (char c : value) {
+        switch (c) {
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n";  break;
+            case '\r': result += "\\r";  break;
+            case '\t': result += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[7];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                    result += escaped;
+                } else {
+                    result += c;
+                }
+                break;
+        }
+    }
+
+    result += '"';
+    return result;
+}
@@ -9,6 +9,7 @@
 
 #include <libutil/FSUtil.h>
 
+#include <atomic>
 #include <cstring>
 
 #include <strings.h>
@@ -17,16 +18,63 @@
 
 using libutil::FSUtil;
 
+/*
+ * The directory and base name follow dirname() and basename(), including
+ * for trailing and repeated slashes, but find the parts in place rather
+ * than copying the path to let those modify it.
+ */
 std::string FSUtil::
 GetDirectoryName(std::string const &path)
 {
-    if (path.find('/') == std::string::npos) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
         // dirname() returns '.' for empty
         return std::string();
     }
 
-    std::string copy(path);
-    return ::dirname(&copy[0]);
+    /* Ignore trailing slashes, unless the path is only slashes. */
+    if (slash != 0 && slash == path.size() - 1) {
+        size_t end = path.find_last_not_of('/', slash);
+        if (end != std::string::npos) {
+            slash = path.rfind('/', end);
+            if (slash == std::string::npos) {
+                return ".";
+            }
+        }
+    }
+
+    /* Remove the slashes before the base name. */
+    size_t end = path.find_last_not_of('/', slash);
+    if (end == std::string::npos) {
+        /* Two leading slashes are kept. */
+        return (slash == 1 ? "//" : "/");
+    }
+
+    return path.substr(0, end + 1);
+}
+
+/*
+ * The start and length of a path's base name.
+ */
+static std::pair<size_t, size_t>
+BaseNameRange(std::string const &path)
+{
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return { 0, path.size() };
+    } else if (slash != path.size() - 1) {
+        return { slash + 1, path.size() - slash - 1 };
+    }
+
+    /* Ignore trailing slashes, unless the path is only slashes. */
+    size_t end = path.find_last_not_of('/');
+    if (end == std::string::npos) {
+        return { path.size() - 1, 1 };
+    }
+
+    size_t start = path.rfind('/', end);
+    start = (start == std::string::npos ? 0 : start + 1);
+    return { start, end + 1 - start };
 }
 
 std::string FSUtil::
@@ -37,21 +85,21 @@ GetBaseName(std::string const &path)
         return std::string();
     }
 
-    std::string copy(path);
-    return ::basename(&copy[0]);
+    std::pair<size_t, size_t> base = BaseNameRange(path);
+    return path.substr(base.first, base.second);
 }
 
 std::string FSUtil::
 GetBaseNameWithoutExtension(std::string const &path)
 {
-    std::string base = GetBaseName(path);
+    std::pair<size_t, size_t> base = BaseNameRange(path);
 
-    size_t pos = base.rfind('.');
-    if (pos == std::string::npos) {
-        return base;
+    size_t pos = path.rfind('.', base.first + base.second - 1);
+    if (base.second == 0 || pos == std::string::npos || pos < base.first) {
+        return path.substr(base.first, base.second);
     }
 
-    return base.substr(0, pos);
+    return path.substr(base.first, pos - base.first);
 }
 
 std::string FSUtil::
@@ -94,51 +142,72 @@ GetRelativePath(std::string const &path, std::string const &to)
     return result;
 }
 
+/*
+ * The start and length of a path's extension, without the dot.
+ */
+static std::pair<size_t, size_t>
+FileExtensionRange(std::string const &path)
+{
+    std::pair<size_t, size_t> base = BaseNameRange(path);
+    if (base.second == 0) {
+        return { 0, 0 };
+    }
+
+    size_t pos = path.rfind('.', base.first + base.second - 1);
+    if (pos == std::string::npos || pos < base.first) {
+        return { 0, 0 };
+    }
+
+    return { pos + 1, base.first + base.second - pos - 1 };
+}
+
 std::string FSUtil::
 GetFileExtension(std::string const &path)
 {
-    std::string base = GetBaseName(path);
+    std::pair<size_t, size_t> extension = FileExtensionRange(path);
+    return path.substr(extension.first, extension.second);
+}
 
-    size_t pos = base.rfind('.');
-    if (pos == std::string::npos) {
-        return std::string();
+/*
+ * Compares a path's extension in place, without copying it out.
+ */
+static bool
+MatchFileExtension(std::string const &path, std::pair<size_t, size_t> const &range, std::string const &extension, bool insensitive)
+{
+    if (range.second != extension.size()) {
+        return false;
     }
 
-    return base.substr(pos + 1);
+    if (insensitive) {
+        return ::strncasecmp(path.data() + range.first, extension.data(), range.second) == 0;
+    } else {
+        return path.compare(range.first, range.second, extension) == 0;
+    }
 }
 
 bool FSUtil::
 IsFileExtension(std::string const &path, std::string const &extension, bool insensitive)
 {
-    std::string pathExtension = GetFileExtension(path);
-    if (pathExtension.empty()) {
+    std::pair<size_t, size_t> range = FileExtensionRange(path);
+    if (range.second == 0) {
         return extension.empty();
     }
 
-    if (insensitive) {
-        return ::strcasecmp(pathExtension.c_str(), extension.c_str()) == 0;
-    } else {
-        return pathExtension == extension;
-    }
+    return MatchFileExtension(path, range, extension, insensitive);
 }
 
 bool FSUtil::
 IsFileExtension(std::string const &path, std::initializer_list<std::string> const &extensions, bool insensitive)
 {
-    std::string pathExtension = GetFileExtension(path);
-    if (pathExtension.empty()) {
+    std::pair<size_t, size_t> range = FileExtensionRange(path);
+    if (range.second == 0) {
         return false;
     }
 
     for (auto const &extension : extensions) {
-        bool match = false;
-        if (insensitive) {
-            match = ::strcasecmp(pathExtension.c_str(), extension.c_str()) == 0;
-        } else {
-            match = pathExtension == extension;
-        }
-        if (match)
+        if (MatchFileExtension(path, range, extension, insensitive)) {
             return true;
+        }
     }
 
     return false;
@@ -150,6 +219,37 @@ IsAbsolutePath(std::string const &path)
     return !path.empty() && path[0] == '/';
 }
 
+/*
+ * Whether normalizing a path would leave it unchanged: it has no repeated
+ * slashes and, if absolute, no '.' or '..' components. Most paths already
+ * are, so checking first avoids writing out a copy.
+ */
+static bool
+IsNormalPath(std::string const &path)
+{
+    bool absolute = FSUtil::IsAbsolutePath(path);
+
+    size_t start = 0;
+    for (size_t i = 0; i <= path.size(); ++i) {
+        if (i != path.size() && path[i] != '/') {
+            continue;
+        }
+
+        size_t length = i - start;
+        if (i != path.size() && i != 0 && length == 0) {
+            /* Repeated slash. */
+            return false;
+        }
+        if (absolute && path[start] == '.' && (length == 1 || (length == 2 && path[start + 1] == '.'))) {
+            return false;
+        }
+
+        start = i + 1;
+    }
+
+    return true;
+}
+
 std::string FSUtil::
 ResolveRelativePath(std::string const &path, std::string const &workingDirectory)
 {
@@ -160,7 +260,16 @@ ResolveRelativePath(std::string const &path, std::string const &workingDirectory
     } else if (workingDirectory.empty()) {
         return path;
     } else {
-        return NormalizePath(workingDirectory + "/" + path);
+        std::string joined;
+        joined.reserve(workingDirectory.size() + 1 + path.size());
+        joined += workingDirectory;
+        joined += '/';
+        joined += path;
+
+        if (IsNormalPath(joined)) {
+            return joined;
+        }
+        return NormalizePath(joined);
     }
 }
 
@@ -241,6 +350,8 @@ NormalizePath(std::string const &path)
 
     if (path.empty()) {
         return std::string();
+    } else if (IsNormalPath(path)) {
+        return path;
     }
 
     outputPath.resize(path.size() * 2);
@@ -249,3 +360,10 @@ NormalizePath(std::string const &path)
 
     return outputPath;
 }
+
+std::string FSUtil::
+GetTemporaryPath(std::string const &path)
+{
+    static std::atomic<uint64_t> Writes(0);
+    return path + ".tmp-" + std::to_string(::getpid()) + "-" + std::to_string(Writes++);
+}
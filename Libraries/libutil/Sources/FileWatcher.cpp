@@ -0,0 +1,147 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/FileWatcher.h>
+#include <libutil/FSUtil.h>
+
+#include <cerrno>
+
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+using libutil::FileWatcher;
+using libutil::FSUtil;
+
+FileWatcher::
+FileWatcher(int descriptor) :
+    _descriptor(descriptor)
+{
+}
+
+FileWatcher::
+~FileWatcher()
+{
+    ::close(_descriptor);
+}
+
+bool FileWatcher::
+watch(std::string const &path)
+{
+#if defined(__linux__)
+    std::string directory = FSUtil::GetDirectoryName(path);
+
+    if (_watches.find(directory) == _watches.end()) {
+        uint32_t mask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+        int watch = ::inotify_add_watch(_descriptor, directory.c_str(), mask);
+        if (watch < 0) {
+            return false;
+        }
+
+        _directories[watch] = directory;
+        _watches[directory] = watch;
+    }
+
+    /* Keyed by how events name the file. */
+    _paths[directory + "/" + FSUtil::GetBaseName(path)] = path;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+bool FileWatcher::
+changes(std::unordered_set<std::string> *changed)
+{
+#if defined(__linux__)
+    bool complete = true;
+
+    /* Events are aligned for the event structure. */
+    alignas(struct inotify_event) char buffer[16 * 1024];
+
+    while (true) {
+        ssize_t size = ::read(_descriptor, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR) {
+            continue;
+        } else if (size < 0 && errno == EAGAIN) {
+            /* No more events waiting. */
+            break;
+        } else if (size <= 0) {
+            return false;
+        }
+
+        for (ssize_t offset = 0; offset < size;) {
+            struct inotify_event const *event = reinterpret_cast<struct inotify_event const *>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                /* Events were dropped; anything could have changed. */
+                complete = false;
+                continue;
+            }
+
+            auto it = _directories.find(event->wd);
+            if (it == _directories.end()) {
+                continue;
+            }
+            std::string directory = it->second;
+
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                /*
+                 * The directory itself went away, so every file in it changed.
+                 * Watching a file in it again watches the new directory.
+                 */
+                for (auto const &entry : _paths) {
+                    if (FSUtil::GetDirectoryName(entry.first) == directory) {
+                        changed->insert(entry.second);
+                    }
+                }
+
+                if (event->mask & IN_IGNORED) {
+                    _watches.erase(directory);
+                    _directories.erase(event->wd);
+                } else {
+                    ::inotify_rm_watch(_descriptor, event->wd);
+                }
+                continue;
+            }
+
+            if (event->len > 0) {
+                auto PI = _paths.find(directory + "/" + event->name);
+                if (PI != _paths.end()) {
+                    changed->insert(PI->second);
+                }
+            }
+        }
+    }
+
+    return complete;
+#else
+    (void)changed;
+    return false;
+#endif
+}
+
+std::unique_ptr<FileWatcher> FileWatcher::
+Create()
+{
+#if defined(__linux__)
+    int descriptor = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (descriptor < 0) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<FileWatcher>(new FileWatcher(descriptor));
+#else
+    return nullptr;
+#endif
+}
@@ -32,6 +32,84 @@ copyFile(std::string const &from, std::string const &to)
     return true;
 }
 
+Filesystem::Mapping::
+Mapping(uint8_t const *data, size_t size) :
+    _data(data),
+    _size(size)
+{
+}
+
+Filesystem::Mapping::
+~Mapping()
+{
+}
+
+/*
+ * A mapping holding a copy of the file's contents.
+ */
+class ContentsMapping : public Filesystem::Mapping {
+private:
+    std::vector<uint8_t> _contents;
+
+public:
+    ContentsMapping(std::vector<uint8_t> &&contents) :
+        Filesystem::Mapping(contents.data(), contents.size()),
+        _contents          (std::move(contents))
+    {
+    }
+};
+
+std::unique_ptr<Filesystem::Mapping const> Filesystem::
+map(std::string const &path) const
+{
+    /* Without a way to map files, fall back to reading a copy. */
+    std::vector<uint8_t> contents;
+    if (!this->read(&contents, path)) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<Mapping const>(new ContentsMapping(std::move(contents)));
+}
+
+ext::optional<Filesystem::Stamp> Filesystem::
+readFileStamp(std::string const &path) const
+{
+    /* Without modification times, a stamp can't show a file is unchanged. */
+    return ext::nullopt;
+}
+
+ext::optional<Filesystem::Stamp> Filesystem::
+readDirectoryStamp(std::string const &path) const
+{
+    return ext::nullopt;
+}
+
+bool Filesystem::
+moveFile(std::string const &from, std::string const &to)
+{
+    if (!this->copyFile(from, to)) {
+        return false;
+    }
+
+    if (!this->removeFile(from)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool Filesystem::
+writeAtomically(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    std::string temporaryPath = FSUtil::GetTemporaryPath(path);
+    if (!this->write(contents, temporaryPath) || !this->moveFile(temporaryPath, path)) {
+        this->removeFile(temporaryPath);
+        return false;
+    }
+
+    return true;
+}
+
 bool Filesystem::
 copySymbolicLink(std::string const &from, std::string const &to)
 {
@@ -50,7 +128,7 @@ copySymbolicLink(std::string const &from, std::string const &to)
         }
     }
 
-    if (!this->writeSymbolicLink(to, *target)) {
+    if (!this->writeSymbolicLink(*target, to)) {
         return false;
     }
 
@@ -81,11 +159,10 @@ copyDirectory(std::string const &from, std::string const &to, bool recursive)
     if (recursive) {
         bool success = true;
 
-        success &= this->readDirectory(from, recursive, [this, &from, &to, &success](std::string const &path) {
+        success &= this->readDirectory(from, recursive, [this, &from, &to, &success](std::string const &path, ext::optional<Type> type) {
             std::string fromPath = from + "/" + path;
             std::string toPath = to + "/" + path;
 
-            ext::optional<Type> type = this->type(fromPath);
             if (!type) {
                 return false;
             }
@@ -122,6 +199,56 @@ copyDirectory(std::string const &from, std::string const &to, bool recursive)
     return true;
 }
 
+bool Filesystem::
+copyDirectoryWithPermissions(std::string const &from, std::string const &to, Permissions::Operation operation, Permissions permissions)
+{
+    if (this->type(from) != Type::Directory) {
+        return false;
+    }
+
+    if (this->type(to) == Type::Directory) {
+        if (!this->removeDirectory(to, true)) {
+            return false;
+        }
+    }
+
+    if (!this->createDirectory(to, false) || !this->writeDirectoryPermissions(to, operation, permissions, false)) {
+        return false;
+    }
+
+    bool success = true;
+
+    success &= this->readDirectory(from, true, [this, &from, &to, &operation, &permissions, &success](std::string const &path, ext::optional<Type> type) {
+        std::string fromPath = from + "/" + path;
+        std::string toPath = to + "/" + path;
+
+        if (!type) {
+            success = false;
+            return;
+        }
+
+        switch (*type) {
+            case Type::File:
+                if (!this->copyFile(fromPath, toPath) || !this->writeFilePermissions(toPath, operation, permissions)) {
+                    success = false;
+                }
+                break;
+            case Type::SymbolicLink:
+                if (!this->copySymbolicLink(fromPath, toPath) || !this->writeSymbolicLinkPermissions(toPath, operation, permissions)) {
+                    success = false;
+                }
+                break;
+            case Type::Directory:
+                if (!this->copyDirectory(fromPath, toPath, false) || !this->writeDirectoryPermissions(toPath, operation, permissions, false)) {
+                    success = false;
+                }
+                break;
+        }
+    });
+
+    return success;
+}
+
 ext::optional<std::string> Filesystem::
 findFile(std::string const &name, std::vector<std::string> const &paths) const
 {
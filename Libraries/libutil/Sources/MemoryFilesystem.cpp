@@ -11,7 +11,6 @@
 #include <libutil/FSUtil.h>
 
 #include <algorithm>
-
 #include <cassert>
 
 using libutil::MemoryFilesystem;
@@ -31,13 +30,12 @@ child(std::string const &name)
 {
     assert(_type == Type::Directory);
 
-    for (MemoryFilesystem::Entry &entry : _children) {
-        if (entry.name() == name) {
-            return &entry;
-        }
+    auto it = _childIndexes.find(name);
+    if (it == _childIndexes.end()) {
+        return nullptr;
     }
 
-    return nullptr;
+    return &_children[it->second];
 }
 
 MemoryFilesystem::Entry const *MemoryFilesystem::Entry::
@@ -45,13 +43,49 @@ child(std::string const &name) const
 {
     assert(_type == Type::Directory);
 
-    for (MemoryFilesystem::Entry const &entry : _children) {
-        if (entry.name() == name) {
-            return &entry;
-        }
+    auto it = _childIndexes.find(name);
+    if (it == _childIndexes.end()) {
+        return nullptr;
+    }
+
+    return &_children[it->second];
+}
+
+MemoryFilesystem::Entry *MemoryFilesystem::Entry::
+insert(Entry entry)
+{
+    assert(_type == Type::Directory);
+
+    auto it = _childIndexes.find(entry.name());
+    if (it != _childIndexes.end()) {
+        _children[it->second] = std::move(entry);
+        return &_children[it->second];
     }
 
-    return nullptr;
+    _childIndexes.insert({ entry.name(), _children.size() });
+    _children.push_back(std::move(entry));
+    return &_children.back();
+}
+
+bool MemoryFilesystem::Entry::
+remove(std::string const &name)
+{
+    assert(_type == Type::Directory);
+
+    auto it = _childIndexes.find(name);
+    if (it == _childIndexes.end()) {
+        return false;
+    }
+
+    /* Keep the order of the remaining children; re-index those after it. */
+    size_t index = it->second;
+    _childIndexes.erase(it);
+    _children.erase(_children.begin() + index);
+    for (size_t i = index; i < _children.size(); ++i) {
+        _childIndexes[_children[i].name()] = i;
+    }
+
+    return true;
 }
 
 MemoryFilesystem::Entry MemoryFilesystem::Entry::
@@ -66,13 +100,24 @@ MemoryFilesystem::Entry MemoryFilesystem::Entry::
 Directory(std::string const &name, std::vector<Entry> const &children)
 {
     MemoryFilesystem::Entry entry = MemoryFilesystem::Entry(name, Type::Directory);
-    entry.children() = children;
+    for (MemoryFilesystem::Entry const &child : children) {
+        entry.insert(child);
+    }
     return entry;
 }
 
 MemoryFilesystem::
 MemoryFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
-    _root(MemoryFilesystem::Entry::Directory("/", entries))
+    _root            (MemoryFilesystem::Entry::Directory("/", entries)),
+    _modificationTime(0)
+{
+}
+
+MemoryFilesystem::
+MemoryFilesystem(MemoryFilesystem const &other) :
+    _root            (other.root()),
+    _stamp           (other._stamp),
+    _modificationTime(other._modificationTime)
 {
 }
 
@@ -133,9 +178,99 @@ WalkPath(
     } while (true);
 }
 
+/*
+ * Add the contents of a directory on another filesystem to an entry.
+ */
+static bool
+ImportDirectory(Filesystem const *filesystem, std::string const &path, MemoryFilesystem::Entry *directory)
+{
+    std::vector<std::pair<std::string, ext::optional<Filesystem::Type>>> entries;
+    if (!filesystem->readDirectory(path, false, [&entries](std::string const &name, ext::optional<Filesystem::Type> type) {
+        entries.push_back({ name, type });
+    })) {
+        return false;
+    }
+
+    for (auto const &entry : entries) {
+        std::string entryPath = (path == "/" ? path : path + "/") + entry.first;
+
+        ext::optional<Filesystem::Type> type = entry.second;
+        if (!type) {
+            type = filesystem->type(entryPath);
+        }
+        if (type == Filesystem::Type::SymbolicLink) {
+            std::string resolved = filesystem->resolvePath(entryPath);
+            if (resolved.empty() || filesystem->type(resolved) != Filesystem::Type::File) {
+                continue;
+            }
+            type = Filesystem::Type::File;
+        }
+
+        if (type == Filesystem::Type::File) {
+            MemoryFilesystem::Entry *file = directory->insert(MemoryFilesystem::Entry::File(entry.first, { }));
+            if (!filesystem->read(&file->contents(), entryPath)) {
+                return false;
+            }
+        } else if (type == Filesystem::Type::Directory) {
+            /* Merge into existing directories. */
+            MemoryFilesystem::Entry *child = directory->child(entry.first);
+            if (child == nullptr || child->type() != Filesystem::Type::Directory) {
+                child = directory->insert(MemoryFilesystem::Entry::Directory(entry.first, { }));
+            }
+            if (!ImportDirectory(filesystem, entryPath, child)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void MemoryFilesystem::
+setStamp(Stamp const &stamp)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _stamp = stamp;
+    _modificationTime = std::max(_modificationTime, stamp.modificationTime);
+}
+
+bool MemoryFilesystem::
+setStamp(std::string const &path, Stamp const &stamp)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _modificationTime = std::max(_modificationTime, stamp.modificationTime);
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [&stamp](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) {
+        if (entry != nullptr) {
+            entry->setStamp(stamp);
+        }
+
+        return entry;
+    });
+}
+
+bool MemoryFilesystem::
+import(Filesystem const *filesystem, std::string const &from, std::string const &to)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (filesystem->type(from) != Type::Directory || !this->createDirectory(to, true)) {
+        return false;
+    }
+
+    MemoryFilesystem::Entry *directory = nullptr;
+    if (!WalkPath<MemoryFilesystem::Entry>(this, to, false, [&directory](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) {
+        directory = entry;
+        return entry;
+    })) {
+        return false;
+    }
+
+    return ImportDirectory(filesystem, FSUtil::NormalizePath(from), directory);
+}
+
 bool MemoryFilesystem::
 exists(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return WalkPath<MemoryFilesystem::Entry const>(this, path, false, [](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) {
         /* Nothing to do. */
         return entry;
@@ -145,6 +280,7 @@ exists(std::string const &path) const
 ext::optional<Filesystem::Type> MemoryFilesystem::
 type(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     ext::optional<Type> type;
 
     if (!WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&type](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) -> MemoryFilesystem::Entry const * {
@@ -163,18 +299,21 @@ type(std::string const &path) const
 bool MemoryFilesystem::
 isReadable(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return this->exists(path);
 }
 
 bool MemoryFilesystem::
 isWritable(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return this->exists(path);
 }
 
 bool MemoryFilesystem::
 isExecutable(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return this->exists(path);
 }
 
@@ -190,6 +329,7 @@ AllPermissions()
 ext::optional<Permissions> MemoryFilesystem::
 readFilePermissions(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     if (this->type(path) != Type::File) {
         return ext::nullopt;
     }
@@ -200,12 +340,14 @@ readFilePermissions(std::string const &path) const
 ext::optional<Permissions> MemoryFilesystem::
 readSymbolicLinkPermissions(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return ext::nullopt;
 }
 
 ext::optional<Permissions> MemoryFilesystem::
 readDirectoryPermissions(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     if (this->type(path) != Type::Directory) {
         return ext::nullopt;
     }
@@ -213,27 +355,65 @@ readDirectoryPermissions(std::string const &path) const
     return AllPermissions();
 }
 
+ext::optional<Filesystem::Stamp> MemoryFilesystem::
+readFileStamp(std::string const &path) const
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    ext::optional<Stamp> stamp;
+
+    WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) {
+        if (entry != nullptr && entry->type() == Type::File) {
+            stamp = (entry->stamp() ? entry->stamp() : _stamp);
+        }
+
+        return entry;
+    });
+
+    return stamp;
+}
+
 bool MemoryFilesystem::
 writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return this->type(path) == Type::File;
 }
 
 bool MemoryFilesystem::
 writeSymbolicLinkPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return this->type(path) == Type::SymbolicLink;
 }
 
+ext::optional<Filesystem::Stamp> MemoryFilesystem::
+readDirectoryStamp(std::string const &path) const
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    ext::optional<Stamp> stamp;
+
+    WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) {
+        if (entry != nullptr && entry->type() == Type::Directory) {
+            stamp = (entry->stamp() ? entry->stamp() : _stamp);
+        }
+
+        return entry;
+    });
+
+    return stamp;
+}
+
 bool MemoryFilesystem::
 writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return this->type(path) == Type::Directory;
 }
 
 bool MemoryFilesystem::
 createFile(std::string const &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return WalkPath<MemoryFilesystem::Entry>(this, path, false, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == Type::File) {
@@ -246,9 +426,7 @@ createFile(std::string const &path)
         } else {
             /* Add empty file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, std::vector<uint8_t>());
-            std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-            children->emplace_back(std::move(file));
-            return &children->back();
+            return parent->insert(std::move(file));
         }
     });
 }
@@ -256,6 +434,7 @@ createFile(std::string const &path)
 bool MemoryFilesystem::
 read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext::optional<size_t> length) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) -> MemoryFilesystem::Entry const * {
         if (entry == nullptr || entry->type() != Type::File) {
             return nullptr;
@@ -265,7 +444,11 @@ read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext
             *contents = entry->contents();
         } else {
             std::vector<uint8_t> const &from = entry->contents();
-            size_t end = (length ? offset + *length : from.size() - offset);
+            if (offset > from.size() || (length && *length > from.size() - offset)) {
+                return nullptr;
+            }
+
+            size_t end = (length ? offset + *length : from.size());
             *contents = std::vector<uint8_t>(from.begin() + offset, from.begin() + end);
         }
 
@@ -276,43 +459,47 @@ read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext
 bool MemoryFilesystem::
 write(std::vector<uint8_t> const &contents, std::string const &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return WalkPath<MemoryFilesystem::Entry>(this, path, false, [&](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
-            if (entry->type() == Type::File) {
-                /* Exists as a file, replace contents. */
-                entry->contents() = contents;
-                return entry;
-            } else {
+            if (entry->type() != Type::File) {
                 /* Exists already, but not as a file. */
                 return nullptr;
             }
+
+            /* Exists as a file, replace contents. */
+            entry->contents() = contents;
         } else {
             /* Add file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, contents);
-            std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-            children->emplace_back(std::move(file));
-            return &children->back();
+            entry = parent->insert(std::move(file));
         }
+
+        /* Written files are newer than anything before them. */
+        if (_stamp || entry->stamp()) {
+            entry->setStamp(Stamp({ contents.size(), ++_modificationTime }));
+        }
+
+        return entry;
     });
 }
 
 bool MemoryFilesystem::
 copyFile(std::string const &from, std::string const &to)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return Filesystem::copyFile(from, to);
 }
 
 bool MemoryFilesystem::
 removeFile(std::string const &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return WalkPath<MemoryFilesystem::Entry>(this, path, false, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == Type::File) {
                 /* Found, remove it. */
-                std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-                children->erase(std::remove_if(children->begin(), children->end(), [&](MemoryFilesystem::Entry const &entry) {
-                    return (entry.name() == name);
-                }), children->end());
+                parent->remove(name);
                 return parent;
             } else {
                 /* Can't remove directories. */
@@ -328,30 +515,35 @@ removeFile(std::string const &path)
 ext::optional<std::string> MemoryFilesystem::
 readSymbolicLink(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return ext::nullopt;
 }
 
 bool MemoryFilesystem::
 writeSymbolicLink(std::string const &target, std::string const &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return false;
 }
 
 bool MemoryFilesystem::
 copySymbolicLink(std::string const &from, std::string const &to)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return false;
 }
 
 bool MemoryFilesystem::
 removeSymbolicLink(std::string const &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return false;
 }
 
 bool MemoryFilesystem::
 createDirectory(std::string const &path, bool recursive)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return WalkPath<MemoryFilesystem::Entry>(this, path, recursive, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == Type::Directory) {
@@ -364,9 +556,7 @@ createDirectory(std::string const &path, bool recursive)
         } else {
             /* Add intermediate directory. */
             MemoryFilesystem::Entry directory = MemoryFilesystem::Entry::Directory(name, { });
-            std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-            children->emplace_back(std::move(directory));
-            return &children->back();
+            return parent->insert(std::move(directory));
         }
     });
 }
@@ -374,18 +564,29 @@ createDirectory(std::string const &path, bool recursive)
 bool MemoryFilesystem::
 copyDirectory(std::string const &from, std::string const &to, bool recursive)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return Filesystem::copyDirectory(from, to, recursive);
 }
 
 bool MemoryFilesystem::
 readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return this->readDirectory(path, recursive, [&cb](std::string const &name, ext::optional<Type> type) {
+        cb(name);
+    });
+}
+
+bool MemoryFilesystem::
+readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     std::function<void(ext::optional<std::string> const &, MemoryFilesystem::Entry const *)> process =
         [&path, &recursive, &cb, &process](ext::optional<std::string> const &subpath, MemoryFilesystem::Entry const *entry) {
         /* Report children. */
         for (MemoryFilesystem::Entry const &child : entry->children()) {
             std::string path = (subpath ? *subpath + "/" + child.name() : child.name());
-            cb(path);
+            cb(path, child.type());
         }
 
         /* Process subdirectories. */
@@ -414,6 +615,7 @@ readDirectory(std::string const &path, bool recursive, std::function<void(std::s
 bool MemoryFilesystem::
 removeDirectory(std::string const &path, bool recursive)
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     return WalkPath<MemoryFilesystem::Entry>(this, path, false, [&recursive](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr && entry->type() == Type::Directory) {
             /* Only remove empty directories unless recursive. */
@@ -422,10 +624,7 @@ removeDirectory(std::string const &path, bool recursive)
             }
 
             /* Remove directory. */
-            std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-            children->erase(std::remove_if(children->begin(), children->end(), [&](MemoryFilesystem::Entry const &entry) {
-                return (entry.name() == name);
-            }), children->end());
+            parent->remove(name);
             return parent;
         } else {
             /* Did not exist or not a directory. */
@@ -437,6 +636,7 @@ removeDirectory(std::string const &path, bool recursive)
 std::string MemoryFilesystem::
 resolvePath(std::string const &path) const
 {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     if (this->exists(path)) {
         return FSUtil::NormalizePath(path);
     } else {
@@ -0,0 +1,506 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/OverlayFilesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <cstdlib>
+
+using libutil::OverlayFilesystem;
+using libutil::Filesystem;
+using libutil::Permissions;
+using libutil::FSUtil;
+
+OverlayFilesystem::
+OverlayFilesystem(Filesystem const *lower, Filesystem *upper) :
+    _lower(lower),
+    _upper(upper)
+{
+}
+
+/*
+ * The normalized path without a trailing slash, to identify removed entries.
+ */
+static std::string
+RemovedKey(std::string const &path)
+{
+    std::string key = FSUtil::NormalizePath(path);
+    while (key.size() > 1 && key.back() == '/') {
+        key.pop_back();
+    }
+    return key;
+}
+
+static std::string
+ChildPath(std::string const &path, std::string const &name)
+{
+    return (!path.empty() && path.back() == '/' ? path : path + "/") + name;
+}
+
+bool OverlayFilesystem::
+hidden(std::string const &path) const
+{
+    std::lock_guard<std::mutex> lock(_removedMutex);
+    if (_removed.empty()) {
+        return false;
+    }
+
+    /* Removing a directory hides everything below it, too. */
+    std::string current = RemovedKey(path);
+    while (true) {
+        if (_removed.find(current) != _removed.end()) {
+            return true;
+        }
+
+        std::string::size_type slash = current.rfind('/');
+        if (slash == std::string::npos || current == "/") {
+            return false;
+        }
+        current = (slash == 0 ? "/" : current.substr(0, slash));
+    }
+}
+
+void OverlayFilesystem::
+hide(std::string const &path)
+{
+    std::lock_guard<std::mutex> lock(_removedMutex);
+    _removed.insert(RemovedKey(path));
+}
+
+OverlayFilesystem::Layer OverlayFilesystem::
+layer(std::string const &path) const
+{
+    if (_upper->type(path)) {
+        return Layer::Upper;
+    } else if (!hidden(path) && _lower->type(path)) {
+        return Layer::Lower;
+    } else {
+        return Layer::None;
+    }
+}
+
+bool OverlayFilesystem::
+createParent(std::string const &path)
+{
+    std::string parent = FSUtil::GetDirectoryName(RemovedKey(path));
+    if (parent.empty() || _upper->type(parent) == Type::Directory) {
+        return true;
+    }
+
+    /* Directories only in the lower filesystem are created above it. */
+    if (this->type(parent) != Type::Directory) {
+        return false;
+    }
+    return _upper->createDirectory(parent, true);
+}
+
+bool OverlayFilesystem::
+exists(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->exists(path);
+        case Layer::Lower: return _lower->exists(path);
+        case Layer::None: return false;
+    }
+    abort();
+}
+
+ext::optional<Filesystem::Type> OverlayFilesystem::
+type(std::string const &path) const
+{
+    if (ext::optional<Type> type = _upper->type(path)) {
+        return type;
+    } else if (hidden(path)) {
+        return ext::nullopt;
+    } else {
+        return _lower->type(path);
+    }
+}
+
+bool OverlayFilesystem::
+isReadable(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->isReadable(path);
+        case Layer::Lower: return _lower->isReadable(path);
+        case Layer::None: return false;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+isWritable(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->isWritable(path);
+        /* Writes go to the upper filesystem instead. */
+        case Layer::Lower: return true;
+        case Layer::None: return false;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+isExecutable(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->isExecutable(path);
+        case Layer::Lower: return _lower->isExecutable(path);
+        case Layer::None: return false;
+    }
+    abort();
+}
+
+ext::optional<Permissions> OverlayFilesystem::
+readFilePermissions(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->readFilePermissions(path);
+        case Layer::Lower: return _lower->readFilePermissions(path);
+        case Layer::None: return ext::nullopt;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions)
+{
+    switch (layer(path)) {
+        case Layer::Upper:
+            return _upper->writeFilePermissions(path, operation, permissions);
+        case Layer::Lower: {
+            /* Copy the file up, with its permissions, then change those. */
+            std::vector<uint8_t> contents;
+            if (_lower->type(path) != Type::File || !_lower->read(&contents, path)) {
+                return false;
+            }
+            if (!createParent(path) || !_upper->write(contents, path)) {
+                return false;
+            }
+            if (ext::optional<Permissions> existing = _lower->readFilePermissions(path)) {
+                _upper->writeFilePermissions(path, Permissions::Operation::Set, *existing);
+            }
+            return _upper->writeFilePermissions(path, operation, permissions);
+        }
+        case Layer::None:
+            return false;
+    }
+    abort();
+}
+
+ext::optional<Filesystem::Stamp> OverlayFilesystem::
+readFileStamp(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->readFileStamp(path);
+        case Layer::Lower: return _lower->readFileStamp(path);
+        case Layer::None: return ext::nullopt;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+createFile(std::string const &path)
+{
+    if (ext::optional<Type> type = this->type(path)) {
+        return (*type == Type::File);
+    }
+
+    return createParent(path) && _upper->createFile(path);
+}
+
+bool OverlayFilesystem::
+read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext::optional<size_t> length) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->read(contents, path, offset, length);
+        case Layer::Lower: return _lower->read(contents, path, offset, length);
+        case Layer::None: return false;
+    }
+    abort();
+}
+
+std::unique_ptr<Filesystem::Mapping const> OverlayFilesystem::
+map(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->map(path);
+        case Layer::Lower: return _lower->map(path);
+        case Layer::None: return nullptr;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+write(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    if (this->type(path) == Type::Directory) {
+        return false;
+    }
+
+    return createParent(path) && _upper->write(contents, path);
+}
+
+bool OverlayFilesystem::
+removeFile(std::string const &path)
+{
+    if (this->type(path) != Type::File) {
+        return false;
+    }
+
+    if (_upper->type(path) == Type::File && !_upper->removeFile(path)) {
+        return false;
+    }
+
+    /* A file below would otherwise show through. */
+    if (!hidden(path) && _lower->type(path)) {
+        hide(path);
+    }
+
+    return true;
+}
+
+ext::optional<Permissions> OverlayFilesystem::
+readSymbolicLinkPermissions(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->readSymbolicLinkPermissions(path);
+        case Layer::Lower: return _lower->readSymbolicLinkPermissions(path);
+        case Layer::None: return ext::nullopt;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+writeSymbolicLinkPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions)
+{
+    switch (layer(path)) {
+        case Layer::Upper:
+            return _upper->writeSymbolicLinkPermissions(path, operation, permissions);
+        case Layer::Lower: {
+            /* Copy the link up, then change its permissions. */
+            ext::optional<std::string> target = _lower->readSymbolicLink(path);
+            if (!target || !createParent(path) || !_upper->writeSymbolicLink(*target, path)) {
+                return false;
+            }
+            return _upper->writeSymbolicLinkPermissions(path, operation, permissions);
+        }
+        case Layer::None:
+            return false;
+    }
+    abort();
+}
+
+ext::optional<std::string> OverlayFilesystem::
+readSymbolicLink(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->readSymbolicLink(path);
+        case Layer::Lower: return _lower->readSymbolicLink(path);
+        case Layer::None: return ext::nullopt;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+writeSymbolicLink(std::string const &target, std::string const &path)
+{
+    if (layer(path) == Layer::Lower) {
+        return false;
+    }
+
+    return createParent(path) && _upper->writeSymbolicLink(target, path);
+}
+
+bool OverlayFilesystem::
+removeSymbolicLink(std::string const &path)
+{
+    if (this->type(path) != Type::SymbolicLink) {
+        return false;
+    }
+
+    if (_upper->type(path) == Type::SymbolicLink && !_upper->removeSymbolicLink(path)) {
+        return false;
+    }
+
+    if (!hidden(path) && _lower->type(path)) {
+        hide(path);
+    }
+
+    return true;
+}
+
+ext::optional<Permissions> OverlayFilesystem::
+readDirectoryPermissions(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->readDirectoryPermissions(path);
+        case Layer::Lower: return _lower->readDirectoryPermissions(path);
+        case Layer::None: return ext::nullopt;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+writeDirectoryPermissions(std::string const &path, Permissions::Operation operation, Permissions permissions, bool recursive)
+{
+    if (this->type(path) != Type::Directory) {
+        return false;
+    }
+
+    /* Entries only in the lower filesystem keep their permissions. */
+    if (_upper->type(path) != Type::Directory && !_upper->createDirectory(path, true)) {
+        return false;
+    }
+    return _upper->writeDirectoryPermissions(path, operation, permissions, recursive);
+}
+
+ext::optional<Filesystem::Stamp> OverlayFilesystem::
+readDirectoryStamp(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper:
+            /* Entries can change in either filesystem when both have it. */
+            if (!hidden(path) && _lower->type(path)) {
+                return ext::nullopt;
+            }
+            return _upper->readDirectoryStamp(path);
+        case Layer::Lower:
+            return _lower->readDirectoryStamp(path);
+        case Layer::None:
+            return ext::nullopt;
+    }
+    abort();
+}
+
+bool OverlayFilesystem::
+createDirectory(std::string const &path, bool recursive)
+{
+    if (ext::optional<Type> type = this->type(path)) {
+        return (*type == Type::Directory);
+    }
+
+    std::string parent = FSUtil::GetDirectoryName(RemovedKey(path));
+    if (!parent.empty() && parent != RemovedKey(path)) {
+        if (recursive) {
+            if (!this->createDirectory(parent, true)) {
+                return false;
+            }
+        } else if (this->type(parent) != Type::Directory) {
+            return false;
+        }
+    }
+
+    return createParent(path) && _upper->createDirectory(path, false);
+}
+
+bool OverlayFilesystem::
+readMergedDirectory(std::string const &path, ext::optional<std::string> const &subpath, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const
+{
+    std::vector<std::pair<std::string, ext::optional<Type>>> entries;
+    std::unordered_set<std::string> names;
+
+    /* Entries in the upper filesystem replace those below. */
+    bool upper = _upper->readDirectory(path, false, [&](std::string const &name, ext::optional<Type> type) {
+        names.insert(name);
+        entries.push_back({ name, type });
+    });
+
+    bool lower = false;
+    if (!hidden(path)) {
+        lower = _lower->readDirectory(path, false, [&](std::string const &name, ext::optional<Type> type) {
+            if (names.find(name) == names.end() && !hidden(ChildPath(path, name))) {
+                entries.push_back({ name, type });
+            }
+        });
+    }
+
+    if (!upper && !lower) {
+        return false;
+    }
+
+    for (auto const &entry : entries) {
+        cb(subpath ? *subpath + "/" + entry.first : entry.first, entry.second);
+    }
+
+    if (recursive) {
+        for (auto const &entry : entries) {
+            std::string childPath = ChildPath(path, entry.first);
+
+            ext::optional<Type> type = entry.second;
+            if (!type) {
+                type = this->type(childPath);
+            }
+
+            if (type == Type::Directory) {
+                readMergedDirectory(childPath, subpath ? *subpath + "/" + entry.first : entry.first, true, cb);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool OverlayFilesystem::
+readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &)> const &cb) const
+{
+    return this->readDirectory(path, recursive, [&cb](std::string const &name, ext::optional<Type> type) {
+        cb(name);
+    });
+}
+
+bool OverlayFilesystem::
+readDirectory(std::string const &path, bool recursive, std::function<void(std::string const &, ext::optional<Type>)> const &cb) const
+{
+    if (layer(path) == Layer::None) {
+        return false;
+    }
+
+    return readMergedDirectory(path, ext::nullopt, recursive, cb);
+}
+
+bool OverlayFilesystem::
+removeDirectory(std::string const &path, bool recursive)
+{
+    if (this->type(path) != Type::Directory) {
+        return false;
+    }
+
+    if (!recursive) {
+        bool empty = true;
+        this->readDirectory(path, false, [&empty](std::string const &name) {
+            empty = false;
+        });
+        if (!empty) {
+            return false;
+        }
+    }
+
+    if (_upper->type(path) == Type::Directory && !_upper->removeDirectory(path, true)) {
+        return false;
+    }
+
+    /* Hides the directory and everything in it below. */
+    if (!hidden(path) && _lower->type(path)) {
+        hide(path);
+    }
+
+    return true;
+}
+
+std::string OverlayFilesystem::
+resolvePath(std::string const &path) const
+{
+    switch (layer(path)) {
+        case Layer::Upper: return _upper->resolvePath(path);
+        case Layer::Lower: return _lower->resolvePath(path);
+        case Layer::None: return std::string();
+    }
+    abort();
+}
@@ -0,0 +1,61 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Ownership.h>
+
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using libutil::Ownership;
+
+bool Ownership::
+IsPrivateDirectory(std::string const &path)
+{
+    struct stat status;
+    if (::lstat(path.c_str(), &status) != 0) {
+        return false;
+    }
+
+    return S_ISDIR(status.st_mode) && status.st_uid == ::geteuid() && (status.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+}
+
+bool Ownership::
+CreatePrivateDirectory(std::string const &path)
+{
+    if (::mkdir(path.c_str(), S_IRWXU) != 0 && errno != EEXIST) {
+        return false;
+    }
+
+    return IsPrivateDirectory(path);
+}
+
+bool Ownership::
+SocketPeerIsUser(int fd)
+{
+#if defined(SO_PEERCRED)
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) {
+        return false;
+    }
+
+    return credentials.uid == ::geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (::getpeereid(fd, &uid, &gid) != 0) {
+        return false;
+    }
+
+    return uid == ::geteuid();
+#endif
+}
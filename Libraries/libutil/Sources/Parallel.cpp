@@ -0,0 +1,82 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using libutil::Parallel;
+
+/*
+ * The default number of jobs, or zero for the number of processors.
+ */
+static std::atomic<size_t> DefaultJobCount = ATOMIC_VAR_INIT(0);
+
+/*
+ * Threads started by all calls in the process, not counting the threads
+ * that made the calls.
+ */
+static std::atomic<size_t> ActiveThreads = ATOMIC_VAR_INIT(0);
+
+size_t Parallel::
+DefaultJobs()
+{
+    size_t jobs = DefaultJobCount.load();
+    if (jobs != 0) {
+        return jobs;
+    }
+
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void Parallel::
+SetDefaultJobs(size_t jobs)
+{
+    DefaultJobCount = jobs;
+}
+
+void Parallel::
+For(size_t jobs, size_t count, std::function<void(size_t)> const &function)
+{
+    std::atomic<size_t> next = ATOMIC_VAR_INIT(0);
+    auto work = [&]() {
+        for (size_t n = next++; n < count; n = next++) {
+            function(n);
+        }
+    };
+
+    /*
+     * The calling thread is one of the jobs. Take the others from what is
+     * left of the process's budget; nested calls find it already spent.
+     */
+    size_t wanted = std::min(jobs, count);
+    size_t limit = DefaultJobs() - 1;
+
+    std::vector<std::thread> threads;
+    while (threads.size() + 1 < wanted) {
+        size_t active = ActiveThreads.load();
+        if (active >= limit) {
+            break;
+        }
+
+        if (ActiveThreads.compare_exchange_weak(active, active + 1)) {
+            threads.emplace_back(work);
+        }
+    }
+
+    work();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    ActiveThreads -= threads.size();
+}
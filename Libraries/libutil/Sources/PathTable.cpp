@@ -0,0 +1,118 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/PathTable.h>
+
+using libutil::PathTable;
+
+/*
+ * Paths are split at every separator, keeping empty components, so that
+ * joining the components gives back exactly the original string. The root
+ * entry is above every path and is never a path itself.
+ */
+static PathTable::Id const Root = 0;
+
+static uint64_t
+ChildKey(PathTable::Id parent, uint32_t component)
+{
+    return (static_cast<uint64_t>(parent) << 32) | component;
+}
+
+PathTable::
+PathTable()
+{
+    _entries.push_back({ Root, 0 });
+}
+
+PathTable::Id PathTable::
+intern(std::string const &path)
+{
+    Id id = Root;
+
+    std::string::size_type start = 0;
+    while (true) {
+        std::string::size_type end = path.find('/', start);
+        std::string component = path.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+        auto cit = _componentIds.find(component);
+        if (cit == _componentIds.end()) {
+            cit = _componentIds.insert({ component, static_cast<uint32_t>(_components.size()) }).first;
+            _components.push_back(component);
+        }
+
+        uint64_t key = ChildKey(id, cit->second);
+        auto it = _children.find(key);
+        if (it == _children.end()) {
+            it = _children.insert({ key, static_cast<Id>(_entries.size()) }).first;
+            _entries.push_back({ id, cit->second });
+        }
+        id = it->second;
+
+        if (end == std::string::npos) {
+            return id;
+        }
+        start = end + 1;
+    }
+}
+
+ext::optional<PathTable::Id> PathTable::
+find(std::string const &path) const
+{
+    Id id = Root;
+
+    std::string::size_type start = 0;
+    while (true) {
+        std::string::size_type end = path.find('/', start);
+        std::string component = path.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+        auto cit = _componentIds.find(component);
+        if (cit == _componentIds.end()) {
+            return ext::nullopt;
+        }
+
+        auto it = _children.find(ChildKey(id, cit->second));
+        if (it == _children.end()) {
+            return ext::nullopt;
+        }
+        id = it->second;
+
+        if (end == std::string::npos) {
+            return id;
+        }
+        start = end + 1;
+    }
+}
+
+std::string PathTable::
+path(Id id) const
+{
+    std::vector<std::string const *> components;
+    for (; id != Root; id = _entries[id].parent) {
+        components.push_back(&_components[_entries[id].component]);
+    }
+
+    std::string result;
+    for (auto it = components.rbegin(); it != components.rend(); ++it) {
+        if (it != components.rbegin()) {
+            result += '/';
+        }
+        result += **it;
+    }
+    return result;
+}
+
+ext::optional<PathTable::Id> PathTable::
+parent(Id id) const
+{
+    Id parent = _entries[id].parent;
+    if (parent == Root) {
+        return ext::nullopt;
+    }
+    return parent;
+}
@@ -0,0 +1,71 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Statistics.h>
+
+#include <algorithm>
+#include <vector>
+
+using libutil::Statistics;
+
+std::atomic<bool> Statistics::_enabled(false);
+
+/*
+ * Counters are pushed here as they are constructed, which can be during
+ * static initialization in any library; constant initialized to allow that.
+ */
+static std::atomic<Statistics::Counter *> Counters(nullptr);
+
+Statistics::Counter::
+Counter(char const *name, bool maximum) :
+    _name    (name),
+    _maximum (maximum),
+    _value   (0),
+    _next    (Counters.load())
+{
+    while (!Counters.compare_exchange_weak(_next, this)) {
+    }
+}
+
+void Statistics::
+Start()
+{
+    for (Counter *counter = Counters.load(); counter != nullptr; counter = counter->_next) {
+        counter->_value = 0;
+    }
+    _enabled = true;
+}
+
+bool Statistics::
+Enabled()
+{
+    return _enabled;
+}
+
+std::string Statistics::
+Report()
+{
+    std::vector<Counter const *> counters;
+    for (Counter const *counter = Counters.load(); counter != nullptr; counter = counter->_next) {
+        counters.push_back(counter);
+    }
+
+    std::sort(counters.begin(), counters.end(), [](Counter const *a, Counter const *b) {
+        return std::string(a->_name) < std::string(b->_name);
+    });
+
+    std::string result;
+    for (Counter const *counter : counters) {
+        result += counter->_name;
+        result += (counter->_maximum ? " (maximum): " : ": ");
+        result += std::to_string(counter->value());
+        result += "\n";
+    }
+    return result;
+}
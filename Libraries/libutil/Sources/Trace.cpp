@@ -0,0 +1,238 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Trace.h>
+#include <libutil/Escape.h>
+#include <libutil/Filesystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+using libutil::Trace;
+using libutil::Escape;
+using libutil::Filesystem;
+
+namespace {
+
+struct Event {
+    char const  *name;
+    std::string  detail;
+    size_t       thread;
+    int64_t      start;
+    int64_t      duration;
+    std::vector<std::pair<char const *, int64_t>> values;
+    bool         memory;
+    int64_t      allocatedPeak;
+    int64_t      allocatedRetained;
+    int64_t      allocated;
+};
+
+/*
+ * Shared by all threads. Spans are only recorded while enabled.
+ */
+struct Recorder {
+    std::atomic<bool>                           enabled;
+    std::chrono::steady_clock::time_point       start;
+    std::mutex                                  mutex;
+    std::vector<Event>                          events;
+    std::unordered_map<std::thread::id, size_t> threads;
+};
+
+}
+
+/*
+ * Memory allocated by the process, and by the current thread. Plain values,
+ * as they are updated from inside the allocator.
+ */
+static std::atomic<bool>    MemoryEnabled(false);
+static std::atomic<int64_t> ProcessAllocated(0);
+static thread_local int64_t ThreadAllocated = 0;
+static thread_local Trace::Span *ThreadSpan = nullptr;
+
+static Recorder *
+SharedRecorder()
+{
+    /* Never destroyed, as spans could end during exit. */
+    static Recorder *recorder = new Recorder();
+    return recorder;
+}
+
+static int64_t
+Now(Recorder const *recorder)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - recorder->start).count();
+}
+
+Trace::Span::
+Span(char const *name, std::string const &detail) :
+    _name           (name),
+    _start          (-1),
+    _parent         (nullptr),
+    _allocatedStart (0),
+    _allocatedPeak  (-1)
+{
+    Recorder *recorder = SharedRecorder();
+    if (recorder->enabled) {
+        _detail = detail;
+        _start = Now(recorder);
+
+        if (MemoryEnabled) {
+            _parent = ThreadSpan;
+            _allocatedStart = ThreadAllocated;
+            _allocatedPeak = 0;
+            ThreadSpan = this;
+        }
+    }
+}
+
+Trace::Span::
+~Span()
+{
+    if (_start < 0) {
+        return;
+    }
+
+    Recorder *recorder = SharedRecorder();
+    int64_t end = Now(recorder);
+
+    /* The parent's peak includes what it had allocated before this span. */
+    bool memory = (_allocatedPeak >= 0);
+    int64_t allocatedRetained = 0;
+    if (memory) {
+        allocatedRetained = ThreadAllocated - _allocatedStart;
+        if (_parent != nullptr) {
+            _parent->_allocatedPeak = std::max(_parent->_allocatedPeak, _allocatedStart - _parent->_allocatedStart + _allocatedPeak);
+        }
+        ThreadSpan = _parent;
+    }
+
+    std::lock_guard<std::mutex> lock(recorder->mutex);
+    size_t thread = recorder->threads.insert({ std::this_thread::get_id(), recorder->threads.size() }).first->second;
+    recorder->events.push_back({ _name, std::move(_detail), thread, _start, end - _start, std::move(_values), memory, _allocatedPeak, allocatedRetained, ProcessAllocated });
+}
+
+void Trace::Span::
+value(char const *name, int64_t value)
+{
+    if (_start >= 0) {
+        _values.push_back({ name, value });
+    }
+}
+
+void Trace::
+Start()
+{
+    Recorder *recorder = SharedRecorder();
+    if (!recorder->enabled) {
+        recorder->start = std::chrono::steady_clock::now();
+        recorder->enabled = true;
+    }
+}
+
+bool Trace::
+Enabled()
+{
+    return SharedRecorder()->enabled;
+}
+
+void Trace::
+StartMemory()
+{
+    MemoryEnabled = true;
+}
+
+void Trace::
+Allocated(size_t bytes)
+{
+    if (!MemoryEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    ProcessAllocated.fetch_add(bytes, std::memory_order_relaxed);
+    ThreadAllocated += bytes;
+
+    if (Span *span = ThreadSpan) {
+        span->_allocatedPeak = std::max(span->_allocatedPeak, ThreadAllocated - span->_allocatedStart);
+    }
+}
+
+void Trace::
+Freed(size_t bytes)
+{
+    if (!MemoryEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    ProcessAllocated.fetch_sub(bytes, std::memory_order_relaxed);
+    ThreadAllocated -= bytes;
+}
+
+std::string Trace::
+Serialize()
+{
+    Recorder *recorder = SharedRecorder();
+    std::string pid = std::to_string(::getpid());
+
+    std::lock_guard<std::mutex> lock(recorder->mutex);
+
+    std::string result = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (size_t n = 0; n < recorder->events.size(); ++n) {
+        Event const &event = recorder->events[n];
+
+        /* Complete events, with both start and duration. */
+        result += "{\"name\":" + Escape::JSON(event.name);
+        result += ",\"cat\":\"xcbuild\",\"ph\":\"X\"";
+        result += ",\"ts\":" + std::to_string(event.start);
+        result += ",\"dur\":" + std::to_string(event.duration);
+        result += ",\"pid\":" + pid;
+        result += ",\"tid\":" + std::to_string(event.thread);
+
+        std::string args;
+        if (!event.detail.empty()) {
+            args += ",\"detail\":" + Escape::JSON(event.detail);
+        }
+        for (auto const &value : event.values) {
+            args += "," + Escape::JSON(value.first) + ":" + std::to_string(value.second);
+        }
+        if (event.memory) {
+            args += ",\"peak_bytes\":" + std::to_string(event.allocatedPeak);
+            args += ",\"retained_bytes\":" + std::to_string(event.allocatedRetained);
+        }
+        if (!args.empty()) {
+            result += ",\"args\":{" + args.substr(1) + "}";
+        }
+
+        /* Counter events graph what the process had allocated over time. */
+        if (event.memory) {
+            result += "},\n{\"name\":\"Allocated\",\"cat\":\"xcbuild\",\"ph\":\"C\"";
+            result += ",\"ts\":" + std::to_string(event.start + event.duration);
+            result += ",\"pid\":" + pid;
+            result += ",\"args\":{\"bytes\":" + std::to_string(event.allocated) + "}";
+        }
+
+        result += (n + 1 < recorder->events.size() ? "},\n" : "}\n");
+    }
+    result += "]}\n";
+
+    return result;
+}
+
+bool Trace::
+Write(Filesystem *filesystem, std::string const &path)
+{
+    std::string contents = Serialize();
+    return filesystem->write(std::vector<uint8_t>(contents.begin(), contents.end()), path);
+}
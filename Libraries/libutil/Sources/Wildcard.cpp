@@ -13,33 +13,178 @@
 
 using libutil::Wildcard;
 
+namespace {
+
+/*
+ * Tokens read directly from the pattern string, so one-off matches don't
+ * need to allocate. Positions are offsets into the pattern.
+ */
+class StringTokens {
+private:
+    std::string const &_pattern;
+
+public:
+    explicit StringTokens(std::string const &pattern) :
+        _pattern(pattern)
+    {
+    }
+
+public:
+    bool end(size_t position) const
+    { return position >= _pattern.size(); }
+
+    bool star(size_t position) const
+    { return _pattern[position] == '*'; }
+
+    size_t next(size_t position) const
+    {
+        size_t close = ClassEnd(position);
+        return (close != std::string::npos ? close + 1 : position + 1);
+    }
+
+    bool matches(size_t position, char c) const
+    {
+        size_t close = ClassEnd(position);
+        if (close != std::string::npos) {
+            return std::find(_pattern.begin() + position + 1, _pattern.begin() + close, c) != _pattern.begin() + close;
+        } else {
+            return _pattern[position] == c;
+        }
+    }
+
+private:
+    /*
+     * The closing bracket of a character class, if the position starts one.
+     * An unclosed bracket matches itself.
+     */
+    size_t ClassEnd(size_t position) const
+    { return (_pattern[position] == '[' ? _pattern.find(']', position) : std::string::npos); }
+};
+
+/*
+ * Tokens from a compiled pattern. Positions are indexes of tokens.
+ */
+class CompiledTokens {
+private:
+    std::vector<Wildcard::Pattern::Token> const &_tokens;
+
+public:
+    explicit CompiledTokens(std::vector<Wildcard::Pattern::Token> const &tokens) :
+        _tokens(tokens)
+    {
+    }
+
+public:
+    bool end(size_t position) const
+    { return position >= _tokens.size(); }
+
+    bool star(size_t position) const
+    { return _tokens[position].star; }
+
+    size_t next(size_t position) const
+    { return position + 1; }
+
+    bool matches(size_t position, char c) const
+    { return _tokens[position].characters.test(static_cast<unsigned char>(c)); }
+};
+
+}
+
+/*
+ * Match by advancing through the pattern and string together. On a
+ * mismatch, retry from the most recent star with it covering one more
+ * character; earlier stars never need to be revisited, so this can't take
+ * exponential time.
+ */
+template<typename T>
+static bool
+MatchTokens(T const &tokens, std::string const &string)
+{
+    size_t position = 0;
+    size_t index = 0;
+
+    size_t starPosition = std::string::npos;
+    size_t starIndex = 0;
+
+    while (index < string.size()) {
+        if (!tokens.end(position) && tokens.star(position)) {
+            starPosition = position;
+            starIndex = index;
+            position = tokens.next(position);
+        } else if (!tokens.end(position) && tokens.matches(position, string[index])) {
+            position = tokens.next(position);
+            index++;
+        } else if (starPosition != std::string::npos) {
+            position = tokens.next(starPosition);
+            index = ++starIndex;
+        } else {
+            return false;
+        }
+    }
+
+    while (!tokens.end(position) && tokens.star(position)) {
+        position = tokens.next(position);
+    }
+
+    return tokens.end(position);
+}
+
+Wildcard::Pattern::
+Pattern(std::vector<Token> const &tokens, bool literal, std::string const &pattern) :
+    _tokens (tokens),
+    _literal(literal),
+    _pattern(pattern)
+{
+}
+
+bool Wildcard::Pattern::
+match(std::string const &string) const
+{
+    if (_literal) {
+        return string == _pattern;
+    }
+
+    return MatchTokens(CompiledTokens(_tokens), string);
+}
+
 bool Wildcard::
 Match(std::string const &pattern, std::string const &string)
 {
-    std::string::const_iterator sit = string.begin();
-    for (std::string::const_iterator fit = pattern.begin(); fit != pattern.end(); ++fit) {
-        std::string::const_iterator fend;
-        if (*fit == '*') {
-            if (++fit == pattern.end() || sit == string.end()) {
-                return true;
-            }
+    return MatchTokens(StringTokens(pattern), string);
+}
 
-            while (*sit++ != *fit) {
-                if (sit == string.end()) {
-                    return false;
-                }
+Wildcard::Pattern Wildcard::
+Compile(std::string const &pattern)
+{
+    /* Most patterns are plain strings. */
+    if (pattern.find_first_of("*[") == std::string::npos) {
+        return Pattern(std::vector<Pattern::Token>(), true, pattern);
+    }
+
+    StringTokens tokens = StringTokens(pattern);
+
+    std::vector<Pattern::Token> compiled;
+    bool literal = true;
+
+    for (size_t position = 0; !tokens.end(position); position = tokens.next(position)) {
+        Pattern::Token token = { tokens.star(position), std::bitset<256>() };
+
+        if (token.star) {
+            /* Adjacent stars match the same as one. */
+            if (!compiled.empty() && compiled.back().star) {
+                continue;
             }
-        } else if (*fit == '[' && (fend = std::find(fit, pattern.end(), ']')) != pattern.end()) {
-            std::string allowed = std::string(std::next(fit), fend);
-            if (allowed.find(*sit++) == std::string::npos) {
-                return false;
+        } else {
+            for (size_t c = 0; c < 256; ++c) {
+                if (tokens.matches(position, static_cast<char>(c))) {
+                    token.characters.set(c);
+                }
             }
-            fit = fend;
-        } else if (*fit != *sit++) {
-            return false;
         }
+
+        literal = literal && !token.star && token.characters.count() == 1 && tokens.next(position) == position + 1;
+        compiled.push_back(token);
     }
 
-    return (sit == string.end());
+    return Pattern(compiled, literal, pattern);
 }
-
@@ -0,0 +1,141 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/CachingFilesystem.h>
+#include <libutil/MemoryFilesystem.h>
+
+using libutil::CachingFilesystem;
+using libutil::MemoryFilesystem;
+using libutil::Filesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(CachingFilesystem, Cached)
+{
+    MemoryFilesystem base = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file1", Contents("one")),
+        MemoryFilesystem::Entry::Directory("dir1", { }),
+    });
+    CachingFilesystem filesystem(&base);
+
+    EXPECT_TRUE(filesystem.exists("/file1"));
+    EXPECT_EQ(filesystem.type("/dir1"), Filesystem::Type::Directory);
+    EXPECT_FALSE(filesystem.exists("/file2"));
+    EXPECT_EQ(filesystem.type("/file2"), ext::nullopt);
+
+    /* Changes behind the cache's back are not seen. */
+    EXPECT_TRUE(base.write(Contents("two"), "/file2"));
+    EXPECT_TRUE(base.removeFile("/file1"));
+    EXPECT_TRUE(filesystem.exists("/file1"));
+    EXPECT_FALSE(filesystem.exists("/file2"));
+    EXPECT_EQ(filesystem.type("/file2"), ext::nullopt);
+
+    /* Until the cache is invalidated. */
+    filesystem.invalidate();
+    EXPECT_FALSE(filesystem.exists("/file1"));
+    EXPECT_TRUE(filesystem.exists("/file2"));
+    EXPECT_EQ(filesystem.type("/file2"), Filesystem::Type::File);
+}
+
+TEST(CachingFilesystem, Invalidated)
+{
+    MemoryFilesystem base = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file1", Contents("one")),
+    });
+    CachingFilesystem filesystem(&base);
+
+    EXPECT_FALSE(filesystem.exists("/file2"));
+    EXPECT_FALSE(filesystem.exists("/dir1"));
+
+    /* Changes through the cache are seen. */
+    EXPECT_TRUE(filesystem.write(Contents("two"), "/file2"));
+    EXPECT_TRUE(filesystem.exists("/file2"));
+
+    EXPECT_TRUE(filesystem.createDirectory("/dir1", false));
+    EXPECT_EQ(filesystem.type("/dir1"), Filesystem::Type::Directory);
+
+    EXPECT_TRUE(filesystem.removeFile("/file1"));
+    EXPECT_FALSE(filesystem.exists("/file1"));
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/file2"));
+    EXPECT_EQ(contents, Contents("two"));
+}
+
+/*
+ * Changes the wrapped filesystem while the cache is checking it.
+ */
+class ChangingFilesystem : public MemoryFilesystem {
+public:
+    CachingFilesystem *cache;
+
+public:
+    ChangingFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
+        MemoryFilesystem(entries),
+        cache           (nullptr)
+    {
+    }
+
+public:
+    virtual bool exists(std::string const &path) const
+    {
+        bool exists = MemoryFilesystem::exists(path);
+        if (cache != nullptr) {
+            const_cast<ChangingFilesystem *>(this)->write(Contents(""), path);
+            cache->invalidate();
+        }
+        return exists;
+    }
+};
+
+TEST(CachingFilesystem, InvalidatedWhileChecking)
+{
+    ChangingFilesystem base = ChangingFilesystem({
+        MemoryFilesystem::Entry::Directory("bin", { }),
+    });
+    CachingFilesystem filesystem(&base);
+    base.cache = &filesystem;
+
+    /* The answer from before the change is not remembered. */
+    EXPECT_FALSE(filesystem.exists("/file1"));
+    base.cache = nullptr;
+    EXPECT_TRUE(filesystem.exists("/file1"));
+
+    base.cache = &filesystem;
+    EXPECT_EQ(filesystem.findExecutable("tool", { "/bin" }), ext::nullopt);
+    base.cache = nullptr;
+    EXPECT_EQ(filesystem.findExecutable("tool", { "/bin" }), std::string("/bin/tool"));
+}
+
+TEST(CachingFilesystem, FindExecutable)
+{
+    MemoryFilesystem base = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("bin1", { }),
+        MemoryFilesystem::Entry::Directory("bin2", {
+            MemoryFilesystem::Entry::File("tool", Contents("")),
+        }),
+    });
+    CachingFilesystem filesystem(&base);
+
+    EXPECT_EQ(filesystem.findExecutable("tool", { "/bin1", "/bin2" }), std::string("/bin2/tool"));
+    EXPECT_EQ(filesystem.findExecutable("tool", { "/bin1" }), ext::nullopt);
+
+    /* Found executables are remembered for the same directories. */
+    EXPECT_TRUE(base.write(Contents(""), "/bin1/tool"));
+    EXPECT_EQ(filesystem.findExecutable("tool", { "/bin1", "/bin2" }), std::string("/bin2/tool"));
+    EXPECT_EQ(filesystem.findExecutable("tool", { "/bin1" }), ext::nullopt);
+
+    filesystem.invalidate();
+    EXPECT_EQ(filesystem.findExecutable("tool", { "/bin1", "/bin2" }), std::string("/bin1/tool"));
+}
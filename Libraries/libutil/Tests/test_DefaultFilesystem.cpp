@@ -0,0 +1,143 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <cstdlib>
+
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::Permissions;
+
+TEST(DefaultFilesystem, CopyFile)
+{
+    char directoryTemplate[] = "/tmp/xcbuild-test-filesystem-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string directory = directoryTemplate;
+
+    DefaultFilesystem filesystem;
+
+    /* Larger than one chunk of the streaming fallback. */
+    std::vector<uint8_t> large;
+    for (size_t i = 0; i < 3 * 1024 * 1024 + 17; i++) {
+        large.push_back(static_cast<uint8_t>(i * 31 + (i >> 12)));
+    }
+    ASSERT_TRUE(filesystem.write(large, directory + "/large"));
+    EXPECT_TRUE(filesystem.copyFile(directory + "/large", directory + "/large-copy"));
+
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, directory + "/large-copy"));
+    EXPECT_EQ(large, contents);
+    EXPECT_EQ(filesystem.readFileStamp(directory + "/large"), filesystem.readFileStamp(directory + "/large-copy"));
+
+    /* An existing, longer destination is replaced entirely. */
+    std::vector<uint8_t> small = { 'a', 'b', 'c' };
+    ASSERT_TRUE(filesystem.write(small, directory + "/small"));
+    EXPECT_TRUE(filesystem.copyFile(directory + "/small", directory + "/large-copy"));
+    ASSERT_TRUE(filesystem.read(&contents, directory + "/large-copy"));
+    EXPECT_EQ(small, contents);
+
+    /* Empty files copy to empty files. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>(), directory + "/empty"));
+    EXPECT_TRUE(filesystem.copyFile(directory + "/empty", directory + "/empty-copy"));
+    EXPECT_EQ(filesystem.type(directory + "/empty-copy"), Filesystem::Type::File);
+    ASSERT_TRUE(filesystem.read(&contents, directory + "/empty-copy"));
+    EXPECT_TRUE(contents.empty());
+
+    /* Missing sources and directories can't be copied. */
+    EXPECT_FALSE(filesystem.copyFile(directory + "/missing", directory + "/missing-copy"));
+    EXPECT_FALSE(filesystem.exists(directory + "/missing-copy"));
+    EXPECT_FALSE(filesystem.copyFile(directory, directory + "/directory-copy"));
+    EXPECT_FALSE(filesystem.copyFile(directory + "/small", directory));
+
+    EXPECT_TRUE(filesystem.removeDirectory(directory, true));
+}
+
+TEST(DefaultFilesystem, CopyDirectoryWithPermissions)
+{
+    char directoryTemplate[] = "/tmp/xcbuild-test-filesystem-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string directory = directoryTemplate;
+
+    DefaultFilesystem filesystem;
+    ASSERT_TRUE(filesystem.createDirectory(directory + "/in/sub/deeper", true));
+    for (size_t i = 0; i < 40; i++) {
+        std::string name = std::to_string(i);
+        std::string parent = (i % 3 == 0 ? "/in" : i % 3 == 1 ? "/in/sub" : "/in/sub/deeper");
+        ASSERT_TRUE(filesystem.write(std::vector<uint8_t>(name.begin(), name.end()), directory + parent + "/" + name));
+    }
+    ASSERT_TRUE(filesystem.writeSymbolicLink("sub/1", directory + "/in/link"));
+
+    /* Source files are read-only; the copies must become writable. */
+    Permissions readOnly;
+    readOnly.user(Permissions::Permission::Write, true);
+    ASSERT_TRUE(filesystem.writeFilePermissions(directory + "/in/sub/1", Permissions::Operation::Remove, readOnly));
+
+    /* Anything already at the destination is replaced. */
+    ASSERT_TRUE(filesystem.createDirectory(directory + "/out/stale", true));
+
+    Permissions writable;
+    writable.user(Permissions::Permission::Write, true);
+    EXPECT_TRUE(filesystem.copyDirectoryWithPermissions(directory + "/in", directory + "/out", Permissions::Operation::Add, writable));
+
+    EXPECT_FALSE(filesystem.exists(directory + "/out/stale"));
+    EXPECT_EQ(filesystem.type(directory + "/out/sub/deeper"), Filesystem::Type::Directory);
+    EXPECT_EQ(filesystem.readSymbolicLink(directory + "/out/link"), std::string("sub/1"));
+    for (size_t i = 0; i < 40; i++) {
+        std::string name = std::to_string(i);
+        std::string parent = (i % 3 == 0 ? "/out" : i % 3 == 1 ? "/out/sub" : "/out/sub/deeper");
+
+        std::vector<uint8_t> contents;
+        ASSERT_TRUE(filesystem.read(&contents, directory + parent + "/" + name));
+        EXPECT_EQ(std::string(contents.begin(), contents.end()), name);
+    }
+
+    ext::optional<Permissions> permissions = filesystem.readFilePermissions(directory + "/out/sub/1");
+    ASSERT_TRUE(permissions);
+    EXPECT_TRUE(permissions->user(Permissions::Permission::Write));
+
+    /* Copying something that isn't a directory fails. */
+    EXPECT_FALSE(filesystem.copyDirectoryWithPermissions(directory + "/in/0", directory + "/file", Permissions::Operation::Add, writable));
+
+    EXPECT_TRUE(filesystem.removeDirectory(directory, true));
+}
+
+TEST(DefaultFilesystem, RemoveDirectory)
+{
+    char directoryTemplate[] = "/tmp/xcbuild-test-filesystem-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string directory = directoryTemplate;
+
+    DefaultFilesystem filesystem;
+
+    /* Enough directories to be emptied on more than one thread. */
+    for (size_t i = 0; i < 24; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            std::string parent = directory + "/tree/" + std::to_string(i) + "/" + std::to_string(j);
+            ASSERT_TRUE(filesystem.createDirectory(parent + "/empty", true));
+            ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'o' }), parent + "/file.o"));
+        }
+    }
+
+    /* Links are removed, not followed. */
+    ASSERT_TRUE(filesystem.createDirectory(directory + "/kept", false));
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'k' }), directory + "/kept/file"));
+    ASSERT_TRUE(filesystem.writeSymbolicLink(directory + "/kept", directory + "/tree/3/link"));
+
+    EXPECT_TRUE(filesystem.removeDirectory(directory + "/tree", true));
+    EXPECT_FALSE(filesystem.exists(directory + "/tree"));
+    EXPECT_TRUE(filesystem.exists(directory + "/kept/file"));
+
+    /* Only directories that exist are removed. */
+    EXPECT_FALSE(filesystem.removeDirectory(directory + "/kept/file", true));
+    EXPECT_FALSE(filesystem.removeDirectory(directory + "/missing", true));
+
+    EXPECT_TRUE(filesystem.removeDirectory(directory, true));
+}
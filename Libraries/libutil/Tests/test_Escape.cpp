@@ -26,6 +26,18 @@ TEST(Escape, Shell)
     EXPECT_EQ(Escape::Shell("'"), "''\\'''");
 }
 
+TEST(Escape, ShellAppend)
+{
+    std::string command = "echo";
+    command += ' ';
+    Escape::Shell("plain", &command);
+    command += ' ';
+    Escape::Shell("two words", &command);
+    command += ' ';
+    Escape::Shell("sin'gle", &command);
+    EXPECT_EQ("echo plain 'two words' 'sin'\\''gle'", command);
+}
+
 TEST(Escape, Makefile)
 {
     EXPECT_EQ(Escape::Makefile(""), "");
@@ -37,3 +49,13 @@ TEST(Escape, Makefile)
     EXPECT_EQ(Escape::Makefile("per%cent"), "per\\%cent");
     EXPECT_EQ(Escape::Makefile("'\"\\"), "'\"\\");
 }
+
+TEST(Escape, JSON)
+{
+    EXPECT_EQ(Escape::JSON(""), "\"\"");
+    EXPECT_EQ(Escape::JSON("alpha"), "\"alpha\"");
+    EXPECT_EQ(Escape::JSON("quo\"te"), "\"quo\\\"te\"");
+    EXPECT_EQ(Escape::JSON("back\\slash"), "\"back\\\\slash\"");
+    EXPECT_EQ(Escape::JSON("new\nline\ttab"), "\"new\\nline\\ttab\"");
+    EXPECT_EQ(Escape::JSON(std::string("nul\0", 4)), "\"nul\\u0000\"");
+}
@@ -18,6 +18,11 @@ TEST(FSUtil, GetDirectoryName)
     EXPECT_EQ("", FSUtil::GetDirectoryName("a"));
     EXPECT_EQ("/a", FSUtil::GetDirectoryName("/a/b"));
     EXPECT_EQ("/a/b", FSUtil::GetDirectoryName("/a/b/c"));
+    EXPECT_EQ("/", FSUtil::GetDirectoryName("/"));
+    EXPECT_EQ("/", FSUtil::GetDirectoryName("/a"));
+    EXPECT_EQ(".", FSUtil::GetDirectoryName("a/"));
+    EXPECT_EQ("/a", FSUtil::GetDirectoryName("/a//b//"));
+    EXPECT_EQ("//", FSUtil::GetDirectoryName("//a"));
 }
 
 TEST(FSUtil, GetBaseName)
@@ -28,6 +33,9 @@ TEST(FSUtil, GetBaseName)
     EXPECT_EQ("b", FSUtil::GetBaseName("/a/b"));
     EXPECT_EQ("c", FSUtil::GetBaseName("/a/b/c"));
     EXPECT_EQ("c.ext", FSUtil::GetBaseName("/a/b/c.ext"));
+    EXPECT_EQ("/", FSUtil::GetBaseName("/"));
+    EXPECT_EQ("/", FSUtil::GetBaseName("///"));
+    EXPECT_EQ("b", FSUtil::GetBaseName("/a/b//"));
 }
 
 TEST(FSUtil, GetBaseNameWithoutExtension)
@@ -60,6 +68,8 @@ TEST(FSUtil, GetFileExtension)
     EXPECT_EQ("", FSUtil::GetFileExtension("/a/b"));
     EXPECT_EQ("ext", FSUtil::GetFileExtension("/a/b.ext"));
     EXPECT_EQ("ext", FSUtil::GetFileExtension("/a/b/c.sub.ext"));
+    EXPECT_EQ("", FSUtil::GetFileExtension("/a.dir/b"));
+    EXPECT_EQ("ext", FSUtil::GetFileExtension("/a/b.ext/"));
 }
 
 TEST(FSUtil, IsAbsolutePath)
@@ -84,6 +94,18 @@ TEST(FSUtil, ResolveRelativePath)
     EXPECT_EQ("/a/b", FSUtil::ResolveRelativePath("/a/b", "/c"));
 }
 
+TEST(FSUtil, NormalizePath)
+{
+    EXPECT_EQ("", FSUtil::NormalizePath(""));
+    EXPECT_EQ("/a/b", FSUtil::NormalizePath("/a/b"));
+    EXPECT_EQ("/a/.b/c..", FSUtil::NormalizePath("/a/.b/c.."));
+    EXPECT_EQ("/a/b", FSUtil::NormalizePath("/a//b"));
+    EXPECT_EQ("/a/b", FSUtil::NormalizePath("/a/./b"));
+    EXPECT_EQ("/b", FSUtil::NormalizePath("/a/../b"));
+    EXPECT_EQ("a/b/", FSUtil::NormalizePath("a//b/"));
+    EXPECT_EQ("a/../b", FSUtil::NormalizePath("a/../b"));
+}
+
 TEST(FSUtil, IsFileExtension)
 {
     EXPECT_TRUE(FSUtil::IsFileExtension("", ""));
@@ -0,0 +1,67 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/FileWatcher.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <cstdlib>
+
+using libutil::FileWatcher;
+using libutil::DefaultFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(FileWatcher, Changes)
+{
+    std::unique_ptr<FileWatcher> watcher = FileWatcher::Create();
+    if (watcher == nullptr) {
+        /* Not supported on this platform. */
+        return;
+    }
+
+    char directoryTemplate[] = "/tmp/xcbuild-test-watcher-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string directory = directoryTemplate;
+
+    DefaultFilesystem filesystem;
+    ASSERT_TRUE(filesystem.write(Contents("a"), directory + "/a"));
+    ASSERT_TRUE(filesystem.write(Contents("b"), directory + "/b"));
+
+    ASSERT_TRUE(watcher->watch(directory + "/a"));
+    ASSERT_TRUE(watcher->watch(directory + "/b"));
+    ASSERT_TRUE(watcher->watch(directory + "/c"));
+
+    std::unordered_set<std::string> changed;
+    EXPECT_TRUE(watcher->changes(&changed));
+    EXPECT_TRUE(changed.empty());
+
+    /* Changes to files that aren't watched aren't reported. */
+    ASSERT_TRUE(filesystem.write(Contents("x"), directory + "/x"));
+    ASSERT_TRUE(filesystem.write(Contents("a2"), directory + "/a"));
+    ASSERT_TRUE(filesystem.write(Contents("c"), directory + "/c"));
+    EXPECT_TRUE(watcher->changes(&changed));
+    EXPECT_EQ(changed, std::unordered_set<std::string>({ directory + "/a", directory + "/c" }));
+
+    /* Replacing a file by renaming over it is a change. */
+    changed.clear();
+    ASSERT_TRUE(filesystem.moveFile(directory + "/x", directory + "/b"));
+    EXPECT_TRUE(watcher->changes(&changed));
+    EXPECT_EQ(changed, std::unordered_set<std::string>({ directory + "/b" }));
+
+    /* Removing the directory changes every file in it. */
+    changed.clear();
+    ASSERT_TRUE(filesystem.removeDirectory(directory, true));
+    EXPECT_TRUE(watcher->changes(&changed));
+    EXPECT_EQ(changed, std::unordered_set<std::string>({ directory + "/a", directory + "/b", directory + "/c" }));
+}
@@ -164,6 +164,24 @@ TEST(MemoryFilesystem, Read)
     EXPECT_EQ(contents, Contents(""));
 }
 
+TEST(MemoryFilesystem, Map)
+{
+    auto filesystem = BasicFilesystem();
+
+    /* Map file. */
+    auto mapping = filesystem.map("/dir1/file2");
+    ASSERT_NE(mapping, nullptr);
+    EXPECT_EQ(std::vector<uint8_t>(mapping->data(), mapping->data() + mapping->size()), Contents("two1"));
+
+    /* Mapping stays valid after the file changes. */
+    EXPECT_TRUE(filesystem.write(Contents("changed"), "/dir1/file2"));
+    EXPECT_EQ(std::vector<uint8_t>(mapping->data(), mapping->data() + mapping->size()), Contents("two1"));
+
+    /* Can't map directory or nonexistent file. */
+    EXPECT_EQ(filesystem.map("/dir1"), nullptr);
+    EXPECT_EQ(filesystem.map("/invalid"), nullptr);
+}
+
 TEST(MemoryFilesystem, Write)
 {
     auto filesystem = BasicFilesystem();
@@ -196,6 +214,40 @@ TEST(MemoryFilesystem, Write)
     EXPECT_FALSE(filesystem.exists("/invalid/new"));
 }
 
+TEST(MemoryFilesystem, Stamp)
+{
+    auto filesystem = BasicFilesystem();
+
+    /* No stamps until they're used. */
+    EXPECT_EQ(filesystem.readFileStamp("/file1"), ext::nullopt);
+    EXPECT_EQ(filesystem.readDirectoryStamp("/dir1"), ext::nullopt);
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/file1"));
+    EXPECT_EQ(filesystem.readFileStamp("/file1"), ext::nullopt);
+
+    filesystem.setStamp(Filesystem::Stamp({ 1, 5 }));
+    EXPECT_EQ(filesystem.readFileStamp("/file1"), Filesystem::Stamp({ 1, 5 }));
+    EXPECT_EQ(filesystem.readDirectoryStamp("/dir1"), Filesystem::Stamp({ 1, 5 }));
+
+    /* Stamps are only read for their own type. */
+    EXPECT_EQ(filesystem.readFileStamp("/dir1"), ext::nullopt);
+    EXPECT_EQ(filesystem.readDirectoryStamp("/file1"), ext::nullopt);
+    EXPECT_EQ(filesystem.readFileStamp("/invalid"), ext::nullopt);
+
+    /* A stamp for a path replaces the one for everything. */
+    EXPECT_TRUE(filesystem.setStamp("/dir1", Filesystem::Stamp({ 1, 10 })));
+    EXPECT_EQ(filesystem.readDirectoryStamp("/dir1"), Filesystem::Stamp({ 1, 10 }));
+    EXPECT_EQ(filesystem.readDirectoryStamp("/dir2"), Filesystem::Stamp({ 1, 5 }));
+    EXPECT_FALSE(filesystem.setStamp("/invalid", Filesystem::Stamp({ 1, 10 })));
+
+    /* Writing and copying give files new stamps. */
+    EXPECT_TRUE(filesystem.write(Contents("newer"), "/file1"));
+    EXPECT_EQ(filesystem.readFileStamp("/file1"), Filesystem::Stamp({ 5, 11 }));
+    EXPECT_TRUE(filesystem.copyFile("/file1", "/copied"));
+    EXPECT_EQ(filesystem.readFileStamp("/copied"), Filesystem::Stamp({ 5, 12 }));
+    EXPECT_EQ(filesystem.readFileStamp("/dir1/file2"), Filesystem::Stamp({ 1, 5 }));
+    EXPECT_EQ(filesystem.readDirectoryStamp("/dir1"), Filesystem::Stamp({ 1, 10 }));
+}
+
 TEST(MemoryFilesystem, CopyFile)
 {
     std::vector<uint8_t> contents;
@@ -221,6 +273,23 @@ TEST(MemoryFilesystem, CopyFile)
     EXPECT_EQ(contents, Contents("one"));
 }
 
+TEST(MemoryFilesystem, MoveFile)
+{
+    std::vector<uint8_t> contents;
+    auto filesystem = BasicFilesystem();
+
+    /* Can't move over a directory. */
+    EXPECT_FALSE(filesystem.moveFile("/file1", "/dir1"));
+    EXPECT_TRUE(filesystem.exists("/file1"));
+
+    /* Can move over an existing file. */
+    contents.clear();
+    EXPECT_TRUE(filesystem.moveFile("/file1", "/dir1/file2"));
+    EXPECT_FALSE(filesystem.exists("/file1"));
+    EXPECT_TRUE(filesystem.read(&contents, "/dir1/file2"));
+    EXPECT_EQ(contents, Contents("one"));
+}
+
 TEST(MemoryFilesystem, RemoveFile)
 {
     auto filesystem = BasicFilesystem();
@@ -419,3 +488,85 @@ TEST(MemoryFilesystem, ResolvePath)
     EXPECT_EQ(filesystem.resolvePath("/dir2/.././dir1/file2"), "/dir1/file2");
 }
 
+
+TEST(MemoryFilesystem, ReadDirectoryTypes)
+{
+    auto filesystem = BasicFilesystem();
+
+    std::vector<std::pair<std::string, ext::optional<Filesystem::Type>>> entries;
+    auto accumulate = [&entries](std::string const &name, ext::optional<Filesystem::Type> type) {
+        entries.push_back({ name, type });
+    };
+
+    /* Types are reported with each entry. */
+    EXPECT_TRUE(filesystem.readDirectory("/dir2", true, accumulate));
+    EXPECT_EQ(entries, (std::vector<std::pair<std::string, ext::optional<Filesystem::Type>>>({
+        { "file2", Filesystem::Type::File },
+        { "dir3", Filesystem::Type::Directory },
+    })));
+
+    /* Can't list file. */
+    entries.clear();
+    EXPECT_FALSE(filesystem.readDirectory("/file1", false, accumulate));
+    EXPECT_TRUE(entries.empty());
+}
+
+TEST(MemoryFilesystem, ManyChildren)
+{
+    auto filesystem = MemoryFilesystem({ });
+    for (size_t i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(filesystem.write(Contents(std::to_string(i)), "/file" + std::to_string(i)));
+    }
+
+    /* Removing keeps the other children, in order, and findable. */
+    EXPECT_TRUE(filesystem.removeFile("/file10"));
+    EXPECT_FALSE(filesystem.exists("/file10"));
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/file999"));
+    EXPECT_EQ(Contents("999"), contents);
+
+    std::vector<std::string> names;
+    EXPECT_TRUE(filesystem.readDirectory("/", false, [&names](std::string const &name) {
+        names.push_back(name);
+    }));
+    ASSERT_EQ(999, names.size());
+    EXPECT_EQ("file9", names[9]);
+    EXPECT_EQ("file11", names[10]);
+
+    /* Writing an existing file replaces it. */
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/file11"));
+    EXPECT_TRUE(filesystem.read(&contents, "/file11"));
+    EXPECT_EQ(Contents("new"), contents);
+}
+
+TEST(MemoryFilesystem, Import)
+{
+    auto source = BasicFilesystem();
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file1", Contents("other")),
+    });
+
+    /* The tree is copied to the destination, which is created. */
+    EXPECT_TRUE(filesystem.import(&source, "/dir2", "/copy/dir2"));
+    EXPECT_EQ(filesystem.type("/copy/dir2/dir3"), Filesystem::Type::Directory);
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/copy/dir2/file2"));
+    EXPECT_EQ(Contents("two2"), contents);
+
+    /* Existing files are replaced, and existing directories merged. */
+    EXPECT_TRUE(filesystem.createDirectory("/dir1", false));
+    EXPECT_TRUE(filesystem.write(Contents("kept"), "/dir1/file3"));
+    EXPECT_TRUE(filesystem.import(&source, "/", "/"));
+    EXPECT_TRUE(filesystem.exists("/dir1/file3"));
+    EXPECT_TRUE(filesystem.read(&contents, "/file1"));
+    EXPECT_EQ(Contents("one"), contents);
+    EXPECT_TRUE(filesystem.read(&contents, "/dir1/file2"));
+    EXPECT_EQ(Contents("two1"), contents);
+    EXPECT_TRUE(filesystem.exists("/copy/dir2/file2"));
+
+    /* Only directories can be imported. */
+    EXPECT_FALSE(filesystem.import(&source, "/file1", "/file"));
+    EXPECT_FALSE(filesystem.import(&source, "/invalid", "/invalid"));
+}
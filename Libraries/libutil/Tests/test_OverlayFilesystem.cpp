@@ -0,0 +1,126 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/OverlayFilesystem.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <algorithm>
+
+using libutil::OverlayFilesystem;
+using libutil::MemoryFilesystem;
+using libutil::Filesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static MemoryFilesystem
+LowerFilesystem()
+{
+    return MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file1", Contents("one")),
+        MemoryFilesystem::Entry::Directory("dir1", {
+            MemoryFilesystem::Entry::File("file2", Contents("two")),
+            MemoryFilesystem::Entry::Directory("dir2", {
+                MemoryFilesystem::Entry::File("file3", Contents("three")),
+            }),
+        }),
+    });
+}
+
+static std::vector<std::string>
+List(Filesystem const *filesystem, std::string const &path, bool recursive)
+{
+    std::vector<std::string> names;
+    filesystem->readDirectory(path, recursive, [&names](std::string const &name) {
+        names.push_back(name);
+    });
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+TEST(OverlayFilesystem, ReadThrough)
+{
+    MemoryFilesystem lower = LowerFilesystem();
+    MemoryFilesystem upper = MemoryFilesystem({ });
+    OverlayFilesystem filesystem(&lower, &upper);
+
+    EXPECT_TRUE(filesystem.exists("/file1"));
+    EXPECT_EQ(filesystem.type("/dir1/dir2"), Filesystem::Type::Directory);
+    EXPECT_FALSE(filesystem.exists("/missing"));
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/dir1/dir2/file3"));
+    EXPECT_EQ(Contents("three"), contents);
+    EXPECT_EQ(List(&filesystem, "/", true), std::vector<std::string>({ "dir1", "dir1/dir2", "dir1/dir2/file3", "dir1/file2", "file1" }));
+}
+
+TEST(OverlayFilesystem, WriteAbove)
+{
+    MemoryFilesystem lower = LowerFilesystem();
+    MemoryFilesystem upper = MemoryFilesystem({ });
+    OverlayFilesystem filesystem(&lower, &upper);
+
+    /* Writes replace lower files without changing them. */
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/dir1/file2"));
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/dir1/file2"));
+    EXPECT_EQ(Contents("new"), contents);
+    EXPECT_TRUE(lower.read(&contents, "/dir1/file2"));
+    EXPECT_EQ(Contents("two"), contents);
+
+    /* Containing directories are created above as needed. */
+    EXPECT_TRUE(filesystem.write(Contents("four"), "/dir1/dir2/file4"));
+    EXPECT_EQ(upper.type("/dir1/dir2/file4"), Filesystem::Type::File);
+    EXPECT_FALSE(lower.exists("/dir1/dir2/file4"));
+    EXPECT_FALSE(filesystem.write(Contents("four"), "/missing/file4"));
+
+    /* Directories list entries from both, once each. */
+    EXPECT_EQ(List(&filesystem, "/dir1", true), std::vector<std::string>({ "dir2", "dir2/file3", "dir2/file4", "file2" }));
+
+    EXPECT_TRUE(filesystem.createDirectory("/dir3/dir4", true));
+    EXPECT_EQ(filesystem.type("/dir3/dir4"), Filesystem::Type::Directory);
+    EXPECT_FALSE(filesystem.createDirectory("/file1/dir5", true));
+    EXPECT_FALSE(lower.exists("/dir3"));
+}
+
+TEST(OverlayFilesystem, Remove)
+{
+    MemoryFilesystem lower = LowerFilesystem();
+    MemoryFilesystem upper = MemoryFilesystem({ });
+    OverlayFilesystem filesystem(&lower, &upper);
+
+    /* Removing lower files hides them. */
+    EXPECT_TRUE(filesystem.removeFile("/file1"));
+    EXPECT_FALSE(filesystem.exists("/file1"));
+    EXPECT_TRUE(lower.exists("/file1"));
+    EXPECT_FALSE(filesystem.removeFile("/file1"));
+
+    /* Until they are written again. */
+    EXPECT_TRUE(filesystem.write(Contents("again"), "/file1"));
+    EXPECT_TRUE(filesystem.exists("/file1"));
+    EXPECT_TRUE(filesystem.removeFile("/file1"));
+    EXPECT_FALSE(filesystem.exists("/file1"));
+
+    /* Removing a directory hides everything in it. */
+    EXPECT_FALSE(filesystem.removeDirectory("/dir1", false));
+    EXPECT_TRUE(filesystem.removeDirectory("/dir1", true));
+    EXPECT_FALSE(filesystem.exists("/dir1/dir2/file3"));
+    EXPECT_TRUE(List(&filesystem, "/", true).empty());
+
+    /* Created again, it starts empty. */
+    EXPECT_TRUE(filesystem.createDirectory("/dir1", false));
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/dir1/file4"));
+    EXPECT_EQ(List(&filesystem, "/dir1", true), std::vector<std::string>({ "file4" }));
+    EXPECT_FALSE(filesystem.exists("/dir1/file2"));
+    EXPECT_TRUE(lower.exists("/dir1/file2"));
+}
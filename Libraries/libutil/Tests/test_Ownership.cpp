@@ -0,0 +1,68 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Ownership.h>
+
+#include <cstdlib>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using libutil::Ownership;
+
+TEST(Ownership, PrivateDirectory)
+{
+    char directoryTemplate[] = "/tmp/xcbuild-test-ownership-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string directory = directoryTemplate;
+
+    /* Created only accessible to the user. */
+    std::string created = directory + "/private";
+    EXPECT_TRUE(Ownership::CreatePrivateDirectory(created));
+    EXPECT_TRUE(Ownership::IsPrivateDirectory(created));
+    EXPECT_TRUE(Ownership::CreatePrivateDirectory(created));
+
+    struct stat status;
+    ASSERT_EQ(0, ::lstat(created.c_str(), &status));
+    EXPECT_EQ(static_cast<mode_t>(0700), status.st_mode & 0777);
+
+    /* Not private once others can get in. */
+    ASSERT_EQ(0, ::chmod(created.c_str(), 0755));
+    EXPECT_FALSE(Ownership::IsPrivateDirectory(created));
+    EXPECT_FALSE(Ownership::CreatePrivateDirectory(created));
+
+    /* Links and files aren't private directories, even to one. */
+    std::string link = directory + "/link";
+    ASSERT_EQ(0, ::chmod(created.c_str(), 0700));
+    ASSERT_EQ(0, ::symlink(created.c_str(), link.c_str()));
+    EXPECT_FALSE(Ownership::IsPrivateDirectory(link));
+    EXPECT_FALSE(Ownership::CreatePrivateDirectory(link));
+
+    std::string missing = directory + "/missing/private";
+    EXPECT_FALSE(Ownership::IsPrivateDirectory(missing));
+    EXPECT_FALSE(Ownership::CreatePrivateDirectory(missing));
+
+    ::unlink(link.c_str());
+    ::rmdir(created.c_str());
+    ::rmdir(directory.c_str());
+}
+
+TEST(Ownership, SocketPeer)
+{
+    int fds[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    EXPECT_TRUE(Ownership::SocketPeerIsUser(fds[0]));
+    EXPECT_TRUE(Ownership::SocketPeerIsUser(fds[1]));
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
@@ -0,0 +1,87 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using libutil::Parallel;
+
+TEST(Parallel, EachIndexOnce)
+{
+    std::vector<std::atomic<size_t>> calls = std::vector<std::atomic<size_t>>(100);
+    Parallel::For(4, calls.size(), [&](size_t n) {
+        calls[n]++;
+    });
+
+    for (std::atomic<size_t> const &count : calls) {
+        EXPECT_EQ(1, count.load());
+    }
+
+    /* Nothing to do is fine. */
+    Parallel::For(4, 0, [&](size_t n) {
+        ADD_FAILURE();
+    });
+}
+
+TEST(Parallel, SingleJob)
+{
+    std::thread::id caller = std::this_thread::get_id();
+    std::vector<size_t> order;
+    Parallel::For(1, 10, [&](size_t n) {
+        EXPECT_EQ(caller, std::this_thread::get_id());
+        order.push_back(n);
+    });
+
+    EXPECT_EQ(std::vector<size_t>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }), order);
+}
+
+TEST(Parallel, DefaultJobs)
+{
+    EXPECT_LE(1, Parallel::DefaultJobs());
+
+    Parallel::SetDefaultJobs(3);
+    EXPECT_EQ(3, Parallel::DefaultJobs());
+
+    Parallel::SetDefaultJobs(0);
+    EXPECT_EQ(std::max<size_t>(std::thread::hardware_concurrency(), 1), Parallel::DefaultJobs());
+}
+
+TEST(Parallel, NestedWithinDefaultJobs)
+{
+    Parallel::SetDefaultJobs(3);
+
+    std::atomic<size_t> running = ATOMIC_VAR_INIT(0);
+    std::atomic<size_t> most = ATOMIC_VAR_INIT(0);
+    std::atomic<size_t> calls = ATOMIC_VAR_INIT(0);
+
+    /* Nested calls share the process's jobs rather than adding their own. */
+    Parallel::For(8, 8, [&](size_t) {
+        Parallel::For(8, 8, [&](size_t) {
+            size_t current = ++running;
+            size_t previous = most.load();
+            while (current > previous && !most.compare_exchange_weak(previous, current)) {
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            calls++;
+            running--;
+        });
+    });
+
+    EXPECT_EQ(64, calls.load());
+    EXPECT_LE(most.load(), 3);
+
+    Parallel::SetDefaultJobs(0);
+}
@@ -0,0 +1,62 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/PathTable.h>
+
+using libutil::PathTable;
+
+TEST(PathTable, Intern)
+{
+    PathTable table;
+
+    PathTable::Id file = table.intern("/build/obj/a.o");
+    EXPECT_EQ(file, table.intern("/build/obj/a.o"));
+    EXPECT_NE(file, table.intern("/build/obj/b.o"));
+    EXPECT_EQ("/build/obj/a.o", table.path(file));
+
+    /* The shared directories are only added once. */
+    EXPECT_EQ(5, table.size());
+    EXPECT_EQ(table.find("/build/obj"), table.parent(file));
+    EXPECT_EQ("/build/obj", table.path(*table.parent(file)));
+}
+
+TEST(PathTable, Find)
+{
+    PathTable table;
+    table.intern("/build/obj/a.o");
+
+    EXPECT_TRUE(table.find("/build/obj/a.o"));
+    EXPECT_TRUE(table.find("/build"));
+    EXPECT_FALSE(table.find("/build/obj/b.o"));
+    EXPECT_FALSE(table.find("/src"));
+    EXPECT_FALSE(table.find("build"));
+
+    /* Finding never adds paths. */
+    EXPECT_EQ(4, table.size());
+}
+
+TEST(PathTable, Exact)
+{
+    PathTable table;
+
+    /* Paths differing only in separators are still different. */
+    std::vector<std::string> paths = { "", "/", "a", "a/", "/a", "a//a", "a/a", "./a" };
+    std::vector<PathTable::Id> ids;
+    for (std::string const &path : paths) {
+        ids.push_back(table.intern(path));
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        EXPECT_EQ(paths[i], table.path(ids[i]));
+        for (size_t j = 0; j < i; ++j) {
+            EXPECT_NE(ids[i], ids[j]);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Statistics.h>
+
+using libutil::Statistics;
+
+static Statistics::Counter Calls("test calls");
+static Statistics::Counter Depth("test depth", true);
+
+TEST(Statistics, Counters)
+{
+    /* Not counted until started. */
+    Calls.add();
+    EXPECT_EQ(0, Calls.value());
+
+    Statistics::Start();
+    EXPECT_TRUE(Statistics::Enabled());
+
+    Calls.add();
+    Calls.add(2);
+    EXPECT_EQ(3, Calls.value());
+
+    Depth.maximum(4);
+    Depth.maximum(2);
+    EXPECT_EQ(4, Depth.value());
+
+    std::string report = Statistics::Report();
+    EXPECT_NE(std::string::npos, report.find("test calls: 3\n"));
+    EXPECT_NE(std::string::npos, report.find("test depth (maximum): 4\n"));
+    EXPECT_LT(report.find("test calls"), report.find("test depth"));
+
+    /* Starting again counts from zero. */
+    Statistics::Start();
+    EXPECT_EQ(0, Calls.value());
+}
@@ -0,0 +1,78 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Trace.h>
+
+using libutil::Trace;
+
+TEST(Trace, Spans)
+{
+    {
+        /* Not recorded until started. */
+        Trace::Span span("before");
+    }
+    EXPECT_EQ(std::string::npos, Trace::Serialize().find("before"));
+
+    Trace::Start();
+    EXPECT_TRUE(Trace::Enabled());
+    {
+        Trace::Span outer("outer", "a \"detail\"");
+        Trace::Span inner("inner");
+    }
+
+    std::string trace = Trace::Serialize();
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"outer\""));
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"detail\":\"a \\\"detail\\\"\"}"));
+
+    /* Inner spans finish first. */
+    EXPECT_LT(trace.find("\"name\":\"inner\""), trace.find("\"name\":\"outer\""));
+    EXPECT_EQ(0, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+}
+
+TEST(Trace, Values)
+{
+    Trace::Start();
+    {
+        Trace::Span span("values", "detail");
+        span.value("user_time_us", 42);
+    }
+
+    std::string trace = Trace::Serialize();
+    std::string values = trace.substr(trace.find("\"name\":\"values\""));
+    EXPECT_NE(std::string::npos, values.find("\"args\":{\"detail\":\"detail\",\"user_time_us\":42}"));
+}
+
+TEST(Trace, Memory)
+{
+    Trace::Start();
+    Trace::StartMemory();
+    {
+        Trace::Span outer("memory outer");
+        Trace::Allocated(100);
+        {
+            /* Freed before the inner span ends, but still the peak. */
+            Trace::Span inner("memory inner");
+            Trace::Allocated(1000);
+            Trace::Freed(1000);
+            Trace::Allocated(10);
+        }
+    }
+    Trace::Freed(110);
+
+    std::string trace = Trace::Serialize();
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"memory inner\""));
+
+    /* The outer span's peak includes what it allocated before the inner span. */
+    std::string inner = trace.substr(trace.find("\"name\":\"memory inner\""));
+    EXPECT_NE(std::string::npos, inner.find("\"args\":{\"peak_bytes\":1000,\"retained_bytes\":10}"));
+    std::string outer = trace.substr(trace.find("\"name\":\"memory outer\""));
+    EXPECT_NE(std::string::npos, outer.find("\"args\":{\"peak_bytes\":1100,\"retained_bytes\":110}"));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"Allocated\""));
+}
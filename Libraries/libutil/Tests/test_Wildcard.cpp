@@ -49,3 +49,33 @@ TEST(Wildcard, One)
     EXPECT_FALSE(Wildcard::Match("[aA]", "b"));
 }
 
+
+TEST(Wildcard, Backtrack)
+{
+    /* A star can cover an earlier occurrence of what follows it. */
+    EXPECT_TRUE(Wildcard::Match("*a", "aba"));
+    EXPECT_TRUE(Wildcard::Match("*.framework", "a.b.framework"));
+    EXPECT_TRUE(Wildcard::Match("a*b*c", "abbbcbc"));
+    EXPECT_FALSE(Wildcard::Match("a*b", "a"));
+    EXPECT_FALSE(Wildcard::Match("a*b*c", "abbbcb"));
+
+    /* Each star is only revisited while it is the most recent one. */
+    std::string string = std::string(2000, 'a');
+    EXPECT_FALSE(Wildcard::Match("*a*a*a*a*a*a*a*b", string));
+}
+
+TEST(Wildcard, Compile)
+{
+    std::vector<std::string> patterns = { "", "a", "abcd", "*", "a*", "*a", "*a*", "a*de", "a*d", "[", "[aA]", "b[aei][dn]", "**x", "a*b*c" };
+    std::vector<std::string> strings = { "", "a", "A", "aA", "abcd", "abcde", "bcd", "[", "bid", "ban", "x", "abbbcbc", "aba" };
+
+    /* Compiled patterns match the same as matching directly. */
+    for (std::string const &pattern : patterns) {
+        Wildcard::Pattern compiled = Wildcard::Compile(pattern);
+        EXPECT_EQ(pattern, compiled.pattern());
+
+        for (std::string const &string : strings) {
+            EXPECT_EQ(Wildcard::Match(pattern, string), compiled.match(string)) << pattern << " " << string;
+        }
+    }
+}
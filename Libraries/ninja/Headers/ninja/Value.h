@@ -10,6 +10,7 @@
 #ifndef __ninja_Value_h
 #define __ninja_Value_h
 
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -80,6 +81,15 @@ public:
      */
     std::string resolve(EscapeMode mode) const;
 
+    /*
+     * Append the value to put in the Ninja file to a buffer.
+     */
+    void resolve(EscapeMode mode, std::vector<uint8_t> *result) const;
+
+private:
+    template<typename T>
+    void append(EscapeMode mode, T *result) const;
+
 public:
     /*
      * Create an empty Ninja value.
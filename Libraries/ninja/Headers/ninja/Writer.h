@@ -12,8 +12,8 @@
 
 #include <ninja/Value.h>
 
+#include <cstdint>
 #include <string>
-#include <sstream>
 #include <vector>
 
 namespace ninja {
@@ -21,10 +21,11 @@ namespace ninja {
 /*
  * Writes a Ninja file. Attempts to be reasonably type-safe to avoid the
  * most common escaping and syntax errors, but remains quite low-level.
+ * Values are escaped directly into the output, which can be very large.
  */
 class Writer {
 private:
-    std::ostringstream _buffer;
+    std::vector<uint8_t> _buffer;
 
 public:
     Writer();
@@ -88,6 +89,17 @@ public:
      * Serialize what's been written so far.
      */
     std::string serialize() const;
+
+    /*
+     * What's been written so far, without copying it.
+     */
+    std::vector<uint8_t> const &contents() const
+    { return _buffer; }
+
+private:
+    void write(std::string const &text);
+    void write(Value const &value, Value::EscapeMode mode);
+    void writeBindings(std::vector<Binding> const &bindings);
 };
 
 }
@@ -9,7 +9,6 @@
 
 #include <ninja/Value.h>
 
-#include <sstream>
 
 using ninja::Value;
 
@@ -40,62 +39,68 @@ operator+(Value const &rhs) const
     return Value(chunks);
 }
 
-static std::string
-Replace(std::string string, std::string const &search, std::string const &replace)
+/*
+ * Escapes directly into the result, to avoid intermediate copies of
+ * large values. The result can be a string or a byte buffer. Runs of
+ * characters that need no escaping, usually the whole value, are
+ * appended at once.
+ */
+template<typename T>
+void Value::
+append(Value::EscapeMode mode, T *result) const
 {
-    size_t pos = 0;
+    bool escapeSpaces = (mode == Value::EscapeMode::PathList || mode == Value::EscapeMode::BuildPathList);
+    bool escapeColons = (mode == Value::EscapeMode::BuildPathList);
 
-    while ((pos = string.find(search, pos)) != std::string::npos) {
-         string.replace(pos, search.length(), replace);
-         pos += replace.length();
+    for (Value::Chunk const &chunk : _chunks) {
+        std::string const &value = chunk.value();
+        bool expression = (chunk.type() == Value::Chunk::Type::Expression);
+
+        std::string::size_type run = 0;
+        for (std::string::size_type i = 0; i < value.size(); ++i) {
+            char c = value[i];
+
+            /*
+             * Strings escape variables, and spaces and colons as needed.
+             * Expressions allow variables, but escape spaces and colons as
+             * needed; an escape right before a space or colon is itself escaped.
+             */
+            bool escape;
+            if (c == '$') {
+                if (!expression) {
+                    escape = true;
+                } else if (i + 1 < value.size()) {
+                    char next = value[i + 1];
+                    escape = (next == ' ' && escapeSpaces) || (next == ':' && escapeColons);
+                } else {
+                    escape = false;
+                }
+            } else {
+                escape = (c == ' ' && escapeSpaces) || (c == ':' && escapeColons);
+            }
+
+            if (escape) {
+                result->insert(result->end(), value.begin() + run, value.begin() + i);
+                result->push_back('$');
+                run = i;
+            }
+        }
+        result->insert(result->end(), value.begin() + run, value.end());
     }
-
-    return string;
 }
 
 std::string Value::
 resolve(Value::EscapeMode mode) const
 {
-    std::ostringstream result;
-
-    for (Value::Chunk const &chunk : _chunks) {
-        switch (chunk.type()) {
-            case Value::Chunk::Type::String:
-                switch (mode) {
-                    case Value::EscapeMode::Value:
-                        /* String, value: just escape variables. Spaces are allowed. */
-                        result << Replace(chunk.value(), "$", "$$");
-                        break;
-                    case Value::EscapeMode::PathList:
-                        /* String, path list: escape variables and spaces, not colons. */
-                        result << Replace(Replace(chunk.value(), "$", "$$"), " ", "$ ");
-                        break;
-                    case Value::EscapeMode::BuildPathList:
-                        /* String, build path list: escape variables, spaces, and, colons. */
-                        result << Replace(Replace(Replace(chunk.value(), "$", "$$"), " ", "$ "), ":", "$:");
-                        break;
-                }
-                break;
-            case Value::Chunk::Type::Expression:
-                switch (mode) {
-                    case Value::EscapeMode::Value:
-                        /* Expression, value: no need to escape. Allow variables. */
-                        result << chunk.value();
-                        break;
-                    case Value::EscapeMode::PathList:
-                        /* Expression, path list: just escape spaces. */
-                        result << Replace(Replace(chunk.value(), "$ ", "$$ "), " ", "$ ");
-                        break;
-                    case Value::EscapeMode::BuildPathList:
-                        /* Expression, path list: escape spaces and colons. */
-                        result << Replace(Replace(Replace(Replace(chunk.value(), "$ ", "$$ "), " ", "$ "), "$:", "$$:"), ":", "$:");
-                        break;
-                }
-                break;
-        }
-    }
+    std::string result;
+    append(mode, &result);
+    return result;
+}
 
-    return result.str();
+void Value::
+resolve(Value::EscapeMode mode, std::vector<uint8_t> *result) const
+{
+    append(mode, result);
 }
 
 Value Value::
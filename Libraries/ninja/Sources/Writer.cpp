@@ -15,6 +15,8 @@ using ninja::Writer;
 Writer::
 Writer()
 {
+    /* Start with enough room to avoid regrowing for small files. */
+    _buffer.reserve(64 * 1024);
 }
 
 Writer::
@@ -22,68 +24,99 @@ Writer::
 {
 }
 
+void Writer::
+write(std::string const &text)
+{
+    _buffer.insert(_buffer.end(), text.begin(), text.end());
+}
+
+void Writer::
+write(Value const &value, Value::EscapeMode mode)
+{
+    value.resolve(mode, &_buffer);
+}
+
+void Writer::
+writeBindings(std::vector<Binding> const &bindings)
+{
+    for (Binding const &binding : bindings) {
+        this->binding(binding, 1);
+    }
+
+    _buffer.push_back('\n');
+}
+
 void Writer::
 newline()
 {
-    _buffer << std::endl;
+    _buffer.push_back('\n');
 }
 
 void Writer::
 binding(Binding const &binding, int indent)
 {
     for (int i = 0; i < indent; i++) {
-        _buffer << "  ";
+        write("  ");
     }
 
-    _buffer << binding.first << " = " << binding.second.resolve(Value::EscapeMode::Value) << std::endl;
+    write(binding.first);
+    write(" = ");
+    write(binding.second, Value::EscapeMode::Value);
+    _buffer.push_back('\n');
 }
 
 void Writer::
 command(std::string const &command, std::string const &remaining, std::vector<Binding> const &bindings)
 {
-    _buffer << command;
+    write(command);
     if (!remaining.empty()) {
-        _buffer << " " << remaining;
-    }
-    _buffer << std::endl;
-
-    for (Binding const &binding : bindings) {
-        this->binding(binding, 1);
+        _buffer.push_back(' ');
+        write(remaining);
     }
+    _buffer.push_back('\n');
 
-    _buffer << std::endl;
+    writeBindings(bindings);
 }
 
 void Writer::
 comment(std::string const &text)
 {
-    _buffer << "#" << " " << text << std::endl;
+    write("# ");
+    write(text);
+    _buffer.push_back('\n');
 }
 
 void Writer::
 subninja(ninja::Value const &path)
 {
-    command("subninja", path.resolve(Value::EscapeMode::PathList));
+    write("subninja ");
+    write(path, Value::EscapeMode::PathList);
+    _buffer.push_back('\n');
+
+    writeBindings({ });
 }
 
 void Writer::
 include(ninja::Value const &path)
 {
-    command("include", path.resolve(Value::EscapeMode::PathList));
+    write("include ");
+    write(path, Value::EscapeMode::PathList);
+    _buffer.push_back('\n');
+
+    writeBindings({ });
 }
 
 void Writer::
 default_(std::vector<Value> const &paths)
 {
-    std::string remaining;
+    write("default");
     for (Value const &path : paths) {
-        if (&path != &paths[0]) {
-            remaining += " ";
-        }
-        remaining += path.resolve(Value::EscapeMode::PathList);
+        _buffer.push_back(' ');
+        write(path, Value::EscapeMode::PathList);
     }
+    _buffer.push_back('\n');
 
-    command("default", remaining);
+    writeBindings({ });
 }
 
 void Writer::
@@ -97,50 +130,55 @@ pool(std::string const &name, int depth)
 void Writer::
 rule(std::string const &name, Value const &command, std::vector<Binding> const &bindings)
 {
-    std::vector<Binding> bindingList = bindings;
-    bindingList.insert(bindingList.begin(), { "command", command });
+    write("rule ");
+    write(name);
+    _buffer.push_back('\n');
 
-    this->command("rule", name, bindingList);
+    this->binding({ "command", command }, 1);
+    writeBindings(bindings);
 }
 
 void Writer::
 build(std::vector<Value> const &outputs, std::string const &rule, std::vector<Value> const &inputs, std::vector<Binding> const &bindings, std::vector<Value> const &dependencies, std::vector<Value> const &orders)
 {
-    std::ostringstream remaining;
+    write("build");
 
     for (Value const &output : outputs) {
-        if (&output != &outputs[0]) {
-            remaining << " ";
-        }
-        remaining << output.resolve(Value::EscapeMode::BuildPathList);
+        _buffer.push_back(' ');
+        write(output, Value::EscapeMode::BuildPathList);
     }
 
-    remaining << ":" << " " << rule;
+    write(": ");
+    write(rule);
 
     for (Value const &input : inputs) {
-        remaining << " " << input.resolve(Value::EscapeMode::BuildPathList);
+        _buffer.push_back(' ');
+        write(input, Value::EscapeMode::BuildPathList);
     }
 
     if (!dependencies.empty()) {
-        remaining << " " << "|";
+        write(" |");
         for (Value const &dependency : dependencies) {
-            remaining << " " << dependency.resolve(Value::EscapeMode::BuildPathList);
+            _buffer.push_back(' ');
+            write(dependency, Value::EscapeMode::BuildPathList);
         }
     }
 
     if (!orders.empty()) {
-        remaining << " " << "||";
+        write(" ||");
         for (Value const &order : orders) {
-            remaining << " " << order.resolve(Value::EscapeMode::BuildPathList);
+            _buffer.push_back(' ');
+            write(order, Value::EscapeMode::BuildPathList);
         }
     }
 
-    command("build", remaining.str(), bindings);
+    _buffer.push_back('\n');
+
+    writeBindings(bindings);
 }
 
 std::string Writer::
 serialize() const
 {
-    return _buffer.str();
+    return std::string(_buffer.begin(), _buffer.end());
 }
-
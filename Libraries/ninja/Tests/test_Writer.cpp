@@ -160,3 +160,13 @@ TEST(Writer, Pool)
     EXPECT_EQ(writer.serialize(), "pool name\n  depth = 4\n\n");
 }
 
+
+TEST(Writer, Contents)
+{
+    Writer writer;
+    writer.build({ Value::String("out put") }, "rule", { Value::String("in:put") }, { { "var", Value::String("$value") } });
+
+    std::string serialized = writer.serialize();
+    EXPECT_EQ(serialized, "build out$ put: rule in$:put\n  var = $$value\n\n");
+    EXPECT_EQ(writer.contents(), std::vector<uint8_t>(serialized.begin(), serialized.end()));
+}
@@ -11,12 +11,20 @@
 #define __pbxbuild_Build_Context_h
 
 #include <pbxbuild/Base.h>
+#include <pbxbuild/DirectoryCache.h>
+#include <pbxbuild/FileTypeCache.h>
+#include <pbxbuild/HeadermapCache.h>
 #include <pbxbuild/WorkspaceContext.h>
 #include <pbxbuild/Build/Environment.h>
 #include <pbxbuild/Target/Environment.h>
+#include <libutil/CachingFilesystem.h>
 
 #include <ext/optional>
 
+#include <functional>
+#include <map>
+#include <mutex>
+
 namespace pbxbuild {
 namespace Build {
 
@@ -37,6 +45,13 @@ private:
 
 private:
     std::shared_ptr<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>> _targetEnvironments;
+    std::shared_ptr<std::mutex>                                                                _targetEnvironmentsMutex;
+    std::shared_ptr<DirectoryCache>                                                            _directoryCache;
+    std::shared_ptr<std::map<std::pair<pbxspec::PBX::BuildSystem::shared_ptr, xcsdk::SDK::Target::shared_ptr>, pbxsetting::Environment>> _sdkEnvironments;
+    std::shared_ptr<std::mutex>                                                                _sdkEnvironmentsMutex;
+    std::shared_ptr<HeadermapCache>                                                            _headermapCache;
+    std::shared_ptr<FileTypeCache>                                                             _fileTypeCache;
+    std::shared_ptr<libutil::CachingFilesystem>                                                _filesystem;
 
 public:
     Context(
@@ -112,6 +127,61 @@ public:
     ext::optional<Target::Environment>
     targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const;
 
+    /*
+     * Create the computed environments for many targets at once, in
+     * parallel. Later calls to targetEnvironment() fetch the results.
+     */
+    void
+    prepareTargetEnvironments(Build::Environment const &buildEnvironment, std::vector<pbxproj::PBX::Target::shared_ptr> const &targets) const;
+
+    /*
+     * The build settings shared by every target using a build system and
+     * SDK: the build system, base, platform and SDK levels. If not yet
+     * created, they are created with the function. Targets add their own
+     * levels in front of a copy, sharing these levels between them.
+     */
+    pbxsetting::Environment
+    sdkEnvironment(
+        pbxspec::PBX::BuildSystem::shared_ptr const &buildSystem,
+        xcsdk::SDK::Target::shared_ptr const &sdk,
+        std::function<pbxsetting::Environment()> const &create) const;
+
+    /*
+     * Use the same computed target environments as another context for the
+     * same workspace and options, such as one from an earlier build.
+     */
+    void
+    shareTargetEnvironments(Context const &context);
+
+public:
+    /*
+     * Directory listings shared by all targets in the build.
+     */
+    DirectoryCache *directoryCache() const
+    { return _directoryCache.get(); }
+
+    /*
+     * Project headers shared by all targets in the build.
+     */
+    HeadermapCache *headermapCache() const
+    { return _headermapCache.get(); }
+
+    /*
+     * File types detected for files in the build. Executors load it from
+     * and save it to the workspace's DerivedData, so later builds detect
+     * file types without reading unchanged files.
+     */
+    FileTypeCache *fileTypeCache() const
+    { return _fileTypeCache.get(); }
+
+    /*
+     * Filesystem checks made while resolving targets in the build. Running
+     * a target's invocations can create files resolving later targets
+     * checks for, so executors invalidate it after each target runs.
+     */
+    libutil::CachingFilesystem *filesystem() const
+    { return _filesystem.get(); }
+
 public:
     /*
      * Finds a target by identifier within a project.
@@ -11,6 +11,7 @@
 #define __pbxbuild_Build_Environment_h
 
 #include <pbxbuild/Base.h>
+#include <pbxbuild/FileTypeResolver.h>
 #include <pbxsetting/Environment.h>
 #include <xcsdk/SDK/Manager.h>
 
@@ -31,12 +32,14 @@ private:
     pbxspec::Manager::shared_ptr         _specManager;
     std::shared_ptr<xcsdk::SDK::Manager> _sdkManager;
     pbxsetting::Environment              _baseEnvironment;
+    std::shared_ptr<FileTypeResolver>    _fileTypeResolver;
 
 public:
     Environment(
         pbxspec::Manager::shared_ptr const &specManager,
         std::shared_ptr<xcsdk::SDK::Manager> const &sdkManager,
-        pbxsetting::Environment const &baseEnvironment);
+        pbxsetting::Environment const &baseEnvironment,
+        std::shared_ptr<FileTypeResolver> const &fileTypeResolver);
 
 public:
     /*
@@ -58,6 +61,13 @@ public:
     pbxsetting::Environment const &baseEnvironment() const
     { return _baseEnvironment; }
 
+public:
+    /*
+     * Resolves file types from the specifications in any domain.
+     */
+    std::shared_ptr<FileTypeResolver> const &fileTypeResolver() const
+    { return _fileTypeResolver; }
+
 public:
     /*
      * Creates a build environment from the default configuration
@@ -67,6 +77,16 @@ public:
     Default(
         process::Context const *processContext,
         libutil::Filesystem const *filesystem);
+
+public:
+    /*
+     * Where the property lists parsed to create the default build
+     * environment can be saved between builds, by loading and saving
+     * plist::FileCache::GetDefault() around `Default`. Later builds then
+     * only parse the files that have changed.
+     */
+    static ext::optional<std::string>
+    CachePath(process::Context const *processContext);
 };
 
 }
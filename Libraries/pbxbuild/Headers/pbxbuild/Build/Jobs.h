@@ -0,0 +1,53 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_Build_Jobs_h
+#define __pbxbuild_Build_Jobs_h
+
+#include <pbxsetting/Environment.h>
+
+#include <cstddef>
+
+namespace pbxbuild {
+namespace Build {
+
+/*
+ * How much work a build does at once. The build runs up to a number of
+ * jobs at a time, from `XCBUILD_JOBS` (set by -jobs) or one per processor.
+ * Tools that use several threads each share those jobs, rather than each
+ * assuming it has the whole machine.
+ */
+class Jobs {
+public:
+    /*
+     * The number of jobs to run at once.
+     */
+    static size_t
+    Count(pbxsetting::Environment const &environment);
+
+    /*
+     * The number of Swift compiles that run at once. By default, a few
+     * Swift compiles share the jobs; `NINJA_SWIFT_POOL_DEPTH` overrides
+     * it, with zero allowing one per job.
+     */
+    static size_t
+    SwiftCompiles(pbxsetting::Environment const &environment);
+
+    /*
+     * The number of threads each Swift compile uses, so the Swift compiles
+     * running at once use about as many threads as there are jobs.
+     */
+    static size_t
+    SwiftThreads(pbxsetting::Environment const &environment);
+};
+
+}
+}
+
+#endif // !__pbxbuild_Build_Jobs_h
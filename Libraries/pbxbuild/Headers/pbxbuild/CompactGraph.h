@@ -0,0 +1,92 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_CompactGraph_h
+#define __pbxbuild_CompactGraph_h
+
+#include <pbxbuild/Base.h>
+
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace pbxbuild {
+
+/*
+ * A directed graph of nodes numbered from zero, for graphs too large to
+ * keep in hash tables, such as the invocations of a build. The nodes each
+ * node is adjacent to are stored together in one array, in the order their
+ * edges were given, so visiting them needs no lookups or allocations.
+ */
+class CompactGraph {
+public:
+    /*
+     * The nodes adjacent to a node, as a range.
+     */
+    class Range {
+    private:
+        size_t const *_begin;
+        size_t const *_end;
+
+    public:
+        Range(size_t const *begin, size_t const *end) :
+            _begin(begin),
+            _end  (end)
+        {
+        }
+
+    public:
+        size_t const *begin() const
+        { return _begin; }
+        size_t const *end() const
+        { return _end; }
+
+    public:
+        size_t size() const
+        { return _end - _begin; }
+        bool empty() const
+        { return _begin == _end; }
+    };
+
+private:
+    std::vector<size_t> _offsets;
+    std::vector<size_t> _adjacent;
+
+public:
+    /*
+     * Create a graph of `size` nodes, with edges from the first node of
+     * each pair to the second. Repeated edges are only kept once.
+     */
+    CompactGraph(size_t size, std::vector<std::pair<size_t, size_t>> const &edges);
+
+public:
+    /*
+     * The number of nodes.
+     */
+    size_t size() const
+    { return _offsets.size() - 1; }
+
+    /*
+     * The nodes a node is adjacent to.
+     */
+    Range adjacent(size_t node) const
+    { return Range(_adjacent.data() + _offsets[node], _adjacent.data() + _offsets[node + 1]); }
+
+public:
+    /*
+     * Order the nodes so each comes after the nodes it is adjacent to. Of
+     * the nodes that could come next, the lowest numbered is taken, so the
+     * order otherwise stays as numbered. Fails if the graph has a cycle.
+     */
+    ext::optional<std::vector<size_t>> ordered() const;
+};
+
+}
+
+#endif // !__pbxbuild_CompactGraph_h
@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_DirectoryCache_h
+#define __pbxbuild_DirectoryCache_h
+
+#include <libutil/Filesystem.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pbxbuild {
+
+/*
+ * Caches directory listings for the length of a build. Many targets
+ * expand the same recursive search paths, so each directory is only
+ * read once. Safe to use from multiple threads.
+ */
+class DirectoryCache {
+public:
+    /*
+     * An entry in a directory.
+     */
+    class Entry {
+    private:
+        std::string                              _name;
+        ext::optional<libutil::Filesystem::Type> _type;
+
+    public:
+        Entry(std::string const &name, ext::optional<libutil::Filesystem::Type> const &type);
+
+    public:
+        /*
+         * The name of the entry, within its directory.
+         */
+        std::string const &name() const
+        { return _name; }
+
+        /*
+         * The type of the entry.
+         */
+        ext::optional<libutil::Filesystem::Type> const &type() const
+        { return _type; }
+    };
+
+private:
+    std::unordered_map<std::string, std::shared_ptr<std::vector<Entry> const>> _directories;
+    std::mutex                                                                  _mutex;
+
+public:
+    DirectoryCache();
+
+public:
+    /*
+     * The entries in a directory, sorted by name. Empty if the directory
+     * can't be read.
+     */
+    std::shared_ptr<std::vector<Entry> const>
+    read(libutil::Filesystem const *filesystem, std::string const &path);
+};
+
+}
+
+#endif // !__pbxbuild_DirectoryCache_h
@@ -0,0 +1,71 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_FileTypeCache_h
+#define __pbxbuild_FileTypeCache_h
+
+#include <libutil/Filesystem.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <ext/optional>
+
+namespace pbxbuild {
+
+/*
+ * Remembers the file types detected for files, so later builds can use
+ * them again without reading the files. A file type is used again until
+ * the file's size or modification time changes. Only files and directories
+ * with stamps are kept. Safe to use from multiple threads.
+ */
+class FileTypeCache {
+private:
+    struct Entry {
+        bool                       directory;
+        libutil::Filesystem::Stamp stamp;
+        std::string                identifier;
+    };
+
+private:
+    std::unordered_map<std::string, Entry> _entries;
+    bool                                   _modified;
+    std::mutex                             _mutex;
+
+public:
+    FileTypeCache();
+
+public:
+    /*
+     * Find the file type identifier detected for a path, if the file has
+     * not changed since.
+     */
+    ext::optional<std::string> find(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Keep the file type identifier detected for a path, along with the
+     * current stamp of the file.
+     */
+    void insert(libutil::Filesystem const *filesystem, std::string const &path, std::string const &identifier);
+
+public:
+    /*
+     * Load a cache saved to a file. Fails if the file is missing or invalid.
+     */
+    bool load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Save the cache to a file, if it changed since it was loaded.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path);
+};
+
+}
+
+#endif // !__pbxbuild_FileTypeCache_h
@@ -11,41 +11,97 @@
 #define __pbxbuild_FileTypeResolver_h
 
 #include <pbxbuild/Base.h>
-#include <pbxbuild/Build/Environment.h>
+#include <libutil/Wildcard.h>
+
+#include <map>
+#include <ext/optional>
 
 namespace libutil { class Filesystem; }
 
 namespace pbxbuild {
 
+class FileTypeCache;
+
 /*
- * Determines the file type of a file.
+ * Determines the file type of a file. The file types in the domains are
+ * sorted and indexed once, so resolving a file type only checks the file
+ * types that could match the file. File contents are only read to check
+ * the magic words of those file types.
  */
 class FileTypeResolver {
 private:
-    FileTypeResolver();
-    ~FileTypeResolver();
+    pbxspec::Manager::shared_ptr                       _specManager;
+    pbxspec::DomainSet::shared_ptr                     _domainSet;
+
+private:
+    /*
+     * File types, more specific file types first.
+     */
+    std::vector<pbxspec::PBX::FileType::shared_ptr>    _fileTypes;
+
+    /*
+     * The file name patterns of each file type above, compiled.
+     */
+    std::vector<std::vector<libutil::Wildcard::Pattern>> _filenamePatterns;
+
+    /*
+     * Indexes of file types by lowercase extension; without extensions, by
+     * file name prefix (grouped by prefix length) or by exact file name.
+     * Other file types could match any file.
+     */
+    std::unordered_map<std::string, std::vector<size_t>>                       _extensionFileTypes;
+    std::map<size_t, std::unordered_map<std::string, std::vector<size_t>>>     _prefixFileTypes;
+    std::unordered_map<std::string, std::vector<size_t>>                       _fileNameFileTypes;
+    std::vector<size_t>                                                        _otherFileTypes;
+
+public:
+    FileTypeResolver(
+        pbxspec::Manager::shared_ptr const &specManager,
+        pbxspec::DomainSet::shared_ptr const &domainSet,
+        std::vector<pbxspec::PBX::FileType::shared_ptr> const &fileTypes);
 
 public:
     /*
-     * Determine the file type of a file path.
+     * The specification manager and domains file types are from.
      */
-    static pbxspec::PBX::FileType::shared_ptr
-    Resolve(libutil::Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, std::string const &filePath);
+    pbxspec::Manager::shared_ptr const &specManager() const
+    { return _specManager; }
+    std::vector<std::string> const &domains() const
+    { return _domainSet->domains(); }
+    pbxspec::DomainSet::shared_ptr const &domainSet() const
+    { return _domainSet; }
+
+public:
+    /*
+     * Determine the file type of a file path. If a cache is given, a file
+     * type detected for the same unchanged file is used instead, and the
+     * file type detected is kept in the cache.
+     */
+    pbxspec::PBX::FileType::shared_ptr
+    resolve(libutil::Filesystem const *filesystem, std::string const &filePath, FileTypeCache *cache = nullptr) const;
 
     /*
      * Determine the file type of a file reference. If a file reference is available, use
      * this method instead of the one with just the file type, as the reference can override
      * the automatically determined file type from the file path.
      */
-    static pbxspec::PBX::FileType::shared_ptr
-    Resolve(libutil::Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxproj::PBX::FileReference::shared_ptr const &fileReference, std::string const &filePath);
+    pbxspec::PBX::FileType::shared_ptr
+    resolve(libutil::Filesystem const *filesystem, pbxproj::PBX::FileReference::shared_ptr const &fileReference, std::string const &filePath, FileTypeCache *cache = nullptr) const;
 
     /*
      * Determine the file type of a version group. Uses the explicit file type or falls back
      * to autodetecting the file type from the path provided.
      */
-    static pbxspec::PBX::FileType::shared_ptr
-    Resolve(libutil::Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxproj::XC::VersionGroup::shared_ptr const &versionGroup, std::string const &filePath);
+    pbxspec::PBX::FileType::shared_ptr
+    resolve(libutil::Filesystem const *filesystem, pbxproj::XC::VersionGroup::shared_ptr const &versionGroup, std::string const &filePath, FileTypeCache *cache = nullptr) const;
+
+public:
+    /*
+     * Create a resolver for the file types in the domains. Fails if the
+     * file types inherit from each other in a cycle.
+     */
+    static ext::optional<FileTypeResolver>
+    Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains);
 };
 
 }
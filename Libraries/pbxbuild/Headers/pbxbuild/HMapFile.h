@@ -11,6 +11,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#ifndef __pbxbuild_HMapFile_h
+#define __pbxbuild_HMapFile_h
+
 #include <string>
 #include <cstdint>
 
@@ -55,3 +58,5 @@ static inline unsigned HashHMapKey(std::string const &Str) {
     Result += tolower(*S) * 13;
   return Result;
 }
+
+#endif // !__pbxbuild_HMapFile_h
@@ -20,6 +20,16 @@
 namespace pbxbuild {
 
 class HeaderMap {
+public:
+    /*
+     * An entry to add to a header map.
+     */
+    struct Entry {
+        std::string key;
+        std::string prefix;
+        std::string suffix;
+    };
+
 private:
     HMapHeader              _header;
     std::vector<HMapBucket> _buckets;
@@ -41,6 +51,18 @@ public:
 public:
     bool add(std::string const &key, std::string const &prefix, std::string const &suffix);
 
+    /*
+     * Add many entries at once. The table is sized for all of the entries
+     * first, rather than growing as each is added. Entries with a key that
+     * is already present are skipped.
+     */
+    void add(std::vector<Entry> const &entries);
+
+    /*
+     * Size the table to hold a number of entries without growing.
+     */
+    void reserve(size_t count);
+
 public:
     void dump();
 
@@ -48,7 +70,7 @@ private:
     void grow();
     void rehash(uint32_t newNumBuckets);
     void set(unsigned hash, uint32_t koff, uint32_t poff, uint32_t soff, bool growing);
-    std::unordered_map<std::string, size_t>::iterator add(std::string const &string, bool key);
+    std::unordered_map<std::string, size_t>::iterator add(std::string const &string);
 };
 
 }
@@ -0,0 +1,76 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_HeaderMapView_h
+#define __pbxbuild_HeaderMapView_h
+
+#include <pbxbuild/HMapFile.h>
+#include <libutil/Filesystem.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <ext/optional>
+
+namespace pbxbuild {
+
+/*
+ * A read-only header map, looked up in place from a mapped file. Unlike
+ * `HeaderMap`, nothing is copied out of the file, so looking up a key
+ * in a large header map only touches the buckets it probes.
+ */
+class HeaderMapView {
+private:
+    std::unique_ptr<libutil::Filesystem::Mapping const> _mapping;
+    HMapHeader                                          _header;
+
+public:
+    HeaderMapView(std::unique_ptr<libutil::Filesystem::Mapping const> mapping, HMapHeader const &header);
+
+public:
+    /*
+     * The number of entries in the header map.
+     */
+    uint32_t size() const
+    { return _header.NumEntries; }
+
+public:
+    /*
+     * The path a key maps to, joining its prefix and suffix. Keys are
+     * matched without regard to case, as by the compiler.
+     */
+    ext::optional<std::string> lookup(std::string const &key) const;
+
+    /*
+     * Visit each entry, in bucket order. Broken entries are skipped.
+     */
+    void iterate(std::function<void(char const *key, char const *prefix, char const *suffix)> const &cb) const;
+
+private:
+    bool bucket(uint32_t index, char const **key, char const **prefix, char const **suffix) const;
+    char const *string(uint32_t offset) const;
+
+public:
+    /*
+     * View the header map in a mapping. Nothing if it is not a valid
+     * header map.
+     */
+    static std::unique_ptr<HeaderMapView>
+    Create(std::unique_ptr<libutil::Filesystem::Mapping const> mapping);
+
+    /*
+     * Map and view a header map file.
+     */
+    static std::unique_ptr<HeaderMapView>
+    Load(libutil::Filesystem const *filesystem, std::string const &path);
+};
+
+}
+
+#endif // !__pbxbuild_HeaderMapView_h
@@ -0,0 +1,77 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_HeadermapCache_h
+#define __pbxbuild_HeadermapCache_h
+
+#include <pbxbuild/HeaderMap.h>
+#include <pbxproj/PBX/Target.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pbxbuild {
+
+/*
+ * Caches the headers in each project for the length of a build. Every
+ * target's header maps include headers from every target in its project,
+ * so each project's headers are only found once. Safe to use from
+ * multiple threads.
+ */
+class HeadermapCache {
+public:
+    /*
+     * A header in a target's headers build phase.
+     */
+    struct TargetHeader {
+        pbxproj::PBX::Target::shared_ptr target;
+        std::string                      fileName;
+        std::string                      fileDirectory;
+        std::string                      frameworkName;
+        bool                             isPublic;
+        bool                             isPrivate;
+        bool                             isNonFramework;
+    };
+
+    /*
+     * The headers in a project, and the header maps that are the same for
+     * every target in the project.
+     */
+    struct ProjectHeaders {
+        std::vector<HeaderMap::Entry> projectHeaders;
+        std::vector<TargetHeader>     targetHeaders;
+
+        std::vector<uint8_t>          projectHeadersContents;
+        std::vector<uint8_t>          allTargetHeadersContents;
+        std::vector<uint8_t>          allNonFrameworkTargetHeadersContents;
+    };
+
+private:
+    std::unordered_map<std::string, std::shared_ptr<ProjectHeaders const>> _projects;
+    std::mutex                                                             _mutex;
+
+public:
+    HeadermapCache();
+
+public:
+    /*
+     * The headers for a project, identified by a key. If not yet cached,
+     * they are created with the function.
+     */
+    std::shared_ptr<ProjectHeaders const>
+    project(std::string const &key, std::function<std::shared_ptr<ProjectHeaders const>()> const &create);
+};
+
+}
+
+#endif // !__pbxbuild_HeadermapCache_h
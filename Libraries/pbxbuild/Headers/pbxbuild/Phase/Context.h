@@ -14,6 +14,7 @@
 
 #include <pbxbuild/Base.h>
 #include <pbxbuild/Phase/File.h>
+#include <pbxbuild/Tool/ClangResolver.h>
 #include <pbxbuild/Tool/Context.h>
 #include <pbxbuild/Tool/ToolResolver.h>
 
@@ -21,7 +22,6 @@ namespace pbxbuild {
 
 namespace Tool {
     class AssetCatalogResolver;
-    class ClangResolver;
     class CopyResolver;
     class DittoResolver;
     class InfoPlistResolver;
@@ -97,6 +97,33 @@ public:
         std::vector<std::vector<Tool::Input>> const &groups,
         std::string const &outputDirectory,
         std::string const &fallbackToolIdentifier = std::string());
+
+    /*
+     * Resolves the same files once for each environment and output
+     * directory, such as for each variant and architecture. Sources for all
+     * of them are prepared at once; they are then resolved in order.
+     */
+    bool resolveBuildFiles(
+        Phase::Environment const &phaseEnvironment,
+        std::vector<std::pair<pbxsetting::Environment, std::string>> const &passes,
+        pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase,
+        std::vector<std::vector<Tool::Input>> const &groups,
+        std::string const &fallbackToolIdentifier = std::string());
+
+private:
+    std::vector<std::vector<ext::optional<Tool::ClangResolver::PreparedSource>>> prepareSources(
+        Phase::Environment const &phaseEnvironment,
+        std::vector<std::pair<pbxsetting::Environment const *, std::string const *>> const &passes,
+        std::vector<std::vector<Tool::Input>> const &groups,
+        std::string const &fallbackToolIdentifier);
+    bool resolveBuildFiles(
+        Phase::Environment const &phaseEnvironment,
+        pbxsetting::Environment const &environment,
+        pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase,
+        std::vector<std::vector<Tool::Input>> const &groups,
+        std::string const &outputDirectory,
+        std::string const &fallbackToolIdentifier,
+        std::vector<ext::optional<Tool::ClangResolver::PreparedSource>> const &preparedSources);
 };
 
 }
@@ -32,6 +32,12 @@ public:
 public:
     bool resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext) const;
 
+    /*
+     * Build the target's module explicitly, if it has explicit modules
+     * enabled. Must come after the module's headers are copied.
+     */
+    bool resolveExplicitModule(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext) const;
+
 public:
     static ext::optional<Tool::AuxiliaryFile::Chunk>
     Contents(pbxsetting::Environment const &environment, pbxproj::PBX::Target::shared_ptr const &target, std::string const &workingDirectory);
@@ -26,8 +26,8 @@ private:
 
 public:
     PhaseInvocations(
-        std::vector<Tool::Invocation> const &invocations,
-        std::vector<Tool::AuxiliaryFile> const &auxiliaryFiles);
+        std::vector<Tool::Invocation> &&invocations,
+        std::vector<Tool::AuxiliaryFile> &&auxiliaryFiles);
     ~PhaseInvocations();
 
 public:
@@ -37,6 +37,14 @@ public:
     { return _auxiliaryFiles; }
 
 public:
+    std::vector<Tool::Invocation> &invocations()
+    { return _invocations; }
+
+public:
+    /*
+     * Resolve the invocations for a target. Invocations with the same
+     * environment share a single copy of it.
+     */
     static PhaseInvocations
     Create(Phase::Environment const &phaseEnvironment, pbxproj::PBX::Target::shared_ptr const &target);
 };
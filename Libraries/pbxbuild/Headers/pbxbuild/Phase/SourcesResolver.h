@@ -11,6 +11,8 @@
 #define __pbxbuild_Phase_SourcesResolver_h
 
 #include <pbxbuild/Base.h>
+#include <pbxbuild/Tool/Context.h>
+#include <pbxbuild/Tool/Input.h>
 
 namespace pbxbuild {
 namespace Phase {
@@ -32,6 +34,17 @@ public:
 
 public:
     bool resolve(Phase::Environment const &phaseEnvironment, Phase::Context *Context);
+
+public:
+    /*
+     * Combine C-family sources into unity sources of up to `size` files
+     * each, which include the sources they replace. Only sources of the same
+     * type and without their own compiler flags are combined, so each unity
+     * source compiles the same way its files would have. The unity sources
+     * are added to the tool context as auxiliary files.
+     */
+    static std::vector<Tool::Input>
+    UnitySources(Tool::Context *toolContext, pbxsetting::Environment const &environment, std::vector<Tool::Input> const &files, size_t size);
 };
 
 }
@@ -11,6 +11,7 @@
 #define __pbxbuild_Target_BuildRules_h
 
 #include <pbxbuild/Base.h>
+#include <libutil/Wildcard.h>
 
 namespace pbxbuild {
 namespace Target {
@@ -56,15 +57,29 @@ private:
     BuildRule::vector _buildRules;
 
 private:
+    /*
+     * The first rule for each file type, the first rule for each exact
+     * file name, and the rules with wildcard patterns, by index. Earlier
+     * rules take precedence, so only the first rule of each can match.
+     */
+    std::unordered_map<pbxspec::PBX::FileType const *, size_t> _fileTypeRules;
+    std::unordered_map<std::string, size_t>                    _fileNameRules;
+    std::vector<std::pair<size_t, libutil::Wildcard::Pattern>> _patternRules;
+
+public:
     BuildRules(BuildRule::vector const &buildRules);
 
 public:
+    /*
+     * The first rule matching a file, either by a file pattern or by the
+     * file's type or a type it's based on.
+     */
     BuildRule::shared_ptr
     resolve(pbxspec::PBX::FileType::shared_ptr const &fileType, std::string const &filePath) const;
 
 public:
     static BuildRules
-    Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxproj::PBX::Target::shared_ptr const &target);
+    Create(pbxspec::Manager::shared_ptr const &specManager, pbxspec::DomainSet::shared_ptr const &domainSet, pbxproj::PBX::Target::shared_ptr const &target);
 };
 
 }
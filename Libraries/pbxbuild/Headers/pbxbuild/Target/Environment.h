@@ -37,7 +37,7 @@ private:
 
 private:
     Target::BuildRules                             _buildRules;
-    std::vector<std::string>                       _specDomains;
+    pbxspec::DomainSet::shared_ptr                 _specDomainSet;
     pbxspec::PBX::BuildSystem::shared_ptr          _buildSystem;
 
 private:
@@ -59,7 +59,7 @@ public:
         std::vector<xcsdk::SDK::Toolchain::shared_ptr> const &toolchains,
         std::vector<std::string> const &executablePaths,
         Target::BuildRules const &buildRules,
-        std::vector<std::string> const &specDomains,
+        pbxspec::DomainSet::shared_ptr const &specDomainSet,
         pbxspec::PBX::BuildSystem::shared_ptr const &buildSystem,
         pbxspec::PBX::ProductType::shared_ptr const &productType,
         pbxspec::PBX::PackageType::shared_ptr const &packageType,
@@ -102,7 +102,14 @@ public:
      * The specification domains for this target.
      */
     std::vector<std::string> const &specDomains() const
-    { return _specDomains; }
+    { return _specDomainSet->domains(); }
+
+    /*
+     * The specifications in the specification domains, for finding them
+     * without searching each domain.
+     */
+    pbxspec::DomainSet::shared_ptr const &specDomainSet() const
+    { return _specDomainSet; }
 
     /*
      * The base build system used for this target.
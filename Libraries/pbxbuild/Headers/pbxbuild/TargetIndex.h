@@ -0,0 +1,74 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_TargetIndex_h
+#define __pbxbuild_TargetIndex_h
+
+#include <pbxproj/PBX/Project.h>
+#include <pbxproj/PBX/Target.h>
+#include <pbxproj/PBX/FileReference.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <ext/optional>
+
+namespace pbxbuild {
+
+/*
+ * Finds the targets in a set of projects by their identifiers and by their
+ * products. Created once for a workspace, then shared by everything that
+ * looks up targets: dependency resolution, and build files referring to
+ * other targets' products.
+ */
+class TargetIndex {
+private:
+    struct ProjectTargets {
+        std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> targets;
+        std::unordered_map<std::string, std::pair<pbxproj::PBX::Target::shared_ptr, pbxproj::PBX::FileReference::shared_ptr>> products;
+    };
+
+private:
+    std::unordered_map<pbxproj::PBX::Project::shared_ptr, ProjectTargets> _projects;
+    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr>     _productNames;
+
+public:
+    TargetIndex();
+
+public:
+    /*
+     * Find a target in a project by its identifier.
+     */
+    pbxproj::PBX::Target::shared_ptr
+    target(pbxproj::PBX::Project::shared_ptr const &project, std::string const &identifier) const;
+
+    /*
+     * Find a target in a project by the identifier of its product.
+     */
+    ext::optional<std::pair<pbxproj::PBX::Target::shared_ptr, pbxproj::PBX::FileReference::shared_ptr>>
+    product(pbxproj::PBX::Project::shared_ptr const &project, std::string const &identifier) const;
+
+    /*
+     * Find a target in any project by the name of its product.
+     */
+    pbxproj::PBX::Target::shared_ptr
+    productName(std::string const &name) const;
+
+public:
+    /*
+     * Index the targets in projects. Where projects have targets with the
+     * same product name, the first is found.
+     */
+    static TargetIndex
+    Create(std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> const &projects);
+};
+
+}
+
+#endif // !__pbxbuild_TargetIndex_h
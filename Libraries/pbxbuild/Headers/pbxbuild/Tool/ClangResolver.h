@@ -10,11 +10,14 @@
 #ifndef __pbxbuild_Tool_ClangResolver_h
 #define __pbxbuild_Tool_ClangResolver_h
 
+#include <pbxbuild/Tool/Invocation.h>
 #include <pbxspec/Manager.h>
 #include <pbxspec/PBX/Compiler.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace pbxsetting { class Environment; }
@@ -23,29 +26,112 @@ namespace pbxbuild {
 namespace Tool {
 
 class Context;
+class Environment;
 class Input;
 class PrecompiledHeaderInfo;
 class SearchPaths;
 
 class ClangResolver {
+public:
+    /*
+     * A source file's compilation, prepared without changing the tool
+     * context. Preparing is most of the work of resolving a source, so
+     * sources can be prepared at the same time, then added in order.
+     */
+    class PreparedSource {
+    private:
+        Tool::Invocation                       _invocation;
+        std::shared_ptr<PrecompiledHeaderInfo> _precompiledHeaderInfo;
+        ext::optional<std::string>             _dialect;
+        std::vector<std::string>               _linkerArgs;
+
+    public:
+        PreparedSource(
+            Tool::Invocation const &invocation,
+            std::shared_ptr<PrecompiledHeaderInfo> const &precompiledHeaderInfo,
+            ext::optional<std::string> const &dialect,
+            std::vector<std::string> const &linkerArgs);
+
+    public:
+        Tool::Invocation const &invocation() const
+        { return _invocation; }
+        std::shared_ptr<PrecompiledHeaderInfo> const &precompiledHeaderInfo() const
+        { return _precompiledHeaderInfo; }
+        ext::optional<std::string> const &dialect() const
+        { return _dialect; }
+        std::vector<std::string> const &linkerArgs() const
+        { return _linkerArgs; }
+    };
+
+private:
+    /*
+     * The parts of a source file's compilation that are the same for every
+     * source of one file type in a variant and architecture. Per-file values
+     * (input, output, compiler flags, dependency info) are added to it.
+     */
+    struct SourceTemplate {
+        std::string                                  executable;
+        std::vector<std::string>                     arguments;
+        std::string                                  prefixHeaderFile;
+        bool                                         precompilePrefixHeader;
+        std::shared_ptr<PrecompiledHeaderInfo>       precompiledHeaderInfo;
+        std::vector<std::string>                     notUsedInPrecompsArguments;
+        std::vector<std::string>                     moduleFiles;
+        std::unordered_map<std::string, std::string> environment;
+        std::vector<std::string>                     linkerArgs;
+    };
+
 private:
     pbxspec::PBX::Compiler::shared_ptr _compiler;
 
+private:
+    mutable std::unordered_map<std::string, std::shared_ptr<SourceTemplate const>> _sourceTemplates;
+    mutable std::mutex                                                             _sourceTemplatesMutex;
+
 public:
     ClangResolver(pbxspec::PBX::Compiler::shared_ptr const &compiler);
     ~ClangResolver();
 
+private:
+    std::shared_ptr<SourceTemplate const> sourceTemplate(
+        Tool::Context const *toolContext,
+        pbxsetting::Environment const &environment,
+        Tool::Environment const &toolEnvironment,
+        Tool::Input const &input,
+        ext::optional<std::string> const &dialect) const;
+
 public:
     void resolveSource(
         Tool::Context *toolContext,
         pbxsetting::Environment const &environment,
         Tool::Input const &input,
         std::string const &outputDirectory) const;
+    PreparedSource prepareSource(
+        Tool::Context const *toolContext,
+        pbxsetting::Environment const &environment,
+        Tool::Input const &input,
+        std::string const &outputDirectory) const;
+    void addSource(
+        Tool::Context *toolContext,
+        pbxsetting::Environment const &environment,
+        PreparedSource const &preparedSource) const;
     void resolvePrecompiledHeader(
         Tool::Context *toolContext,
         pbxsetting::Environment const &environment,
         PrecompiledHeaderInfo const &precompiledHeaderInfo) const;
 
+    /*
+     * Build the module defined by a module map, for other targets to load
+     * explicitly. The input dependencies are the headers in the module.
+     */
+    void resolveModule(
+        Tool::Context *toolContext,
+        pbxsetting::Environment const &environment,
+        std::string const &moduleName,
+        Tool::Input const &moduleMap,
+        std::string const &output,
+        std::vector<std::string> const &inputDependencies) const;
+
 public:
     pbxspec::PBX::Compiler::shared_ptr const &compiler() const
     { return _compiler; }
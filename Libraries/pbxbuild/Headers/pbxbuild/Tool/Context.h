@@ -15,10 +15,12 @@
 #include <pbxbuild/Tool/CompilationInfo.h>
 #include <pbxbuild/Tool/SwiftModuleInfo.h>
 #include <pbxbuild/Tool/ModuleMapInfo.h>
+#include <pbxbuild/Tool/ExplicitModuleInfo.h>
 #include <pbxbuild/Tool/PrecompiledHeaderInfo.h>
 #include <pbxbuild/Tool/SearchPaths.h>
 #include <xcsdk/SDK/Target.h>
 #include <xcsdk/SDK/Toolchain.h>
+#include <libutil/Filesystem.h>
 
 #include <map>
 #include <string>
@@ -29,6 +31,7 @@ namespace Tool {
 
 class Context {
 private:
+    libutil::Filesystem const       *_filesystem;
     xcsdk::SDK::Target::shared_ptr   _sdk;
     std::vector<xcsdk::SDK::Toolchain::shared_ptr> _toolchains;
     std::string                      _workingDirectory;
@@ -39,6 +42,7 @@ private:
 private:
     HeadermapInfo                    _headermapInfo;
     ModuleMapInfo                    _moduleMapInfo;
+    std::vector<ExplicitModuleInfo>  _explicitModuleInfo;
     CompilationInfo                  _compilationInfo;
     std::vector<SwiftModuleInfo>     _swiftModuleInfo;
     std::vector<std::string>         _additionalInfoPlistContents;
@@ -52,6 +56,7 @@ private:
 
 public:
     Context(
+        libutil::Filesystem const *filesystem,
         xcsdk::SDK::Target::shared_ptr const &sdk,
         std::vector<xcsdk::SDK::Toolchain::shared_ptr> const &toolchains,
         std::string const &workingDirectory,
@@ -59,6 +64,8 @@ public:
     ~Context();
 
 public:
+    libutil::Filesystem const *filesystem() const
+    { return _filesystem; }
     xcsdk::SDK::Target::shared_ptr const &sdk() const
     { return _sdk; }
     std::vector<xcsdk::SDK::Toolchain::shared_ptr> const &toolchains() const
@@ -75,6 +82,8 @@ public:
     { return _headermapInfo; }
     ModuleMapInfo const &moduleMapInfo() const
     { return _moduleMapInfo; }
+    std::vector<ExplicitModuleInfo> const &explicitModuleInfo() const
+    { return _explicitModuleInfo; }
     CompilationInfo const &compilationInfo() const
     { return _compilationInfo; }
     std::vector<SwiftModuleInfo> const &swiftModuleInfo() const
@@ -87,6 +96,8 @@ public:
     { return _headermapInfo; }
     ModuleMapInfo &moduleMapInfo()
     { return _moduleMapInfo; }
+    std::vector<ExplicitModuleInfo> &explicitModuleInfo()
+    { return _explicitModuleInfo; }
     CompilationInfo &compilationInfo()
     { return _compilationInfo; }
     std::vector<SwiftModuleInfo> &swiftModuleInfo()
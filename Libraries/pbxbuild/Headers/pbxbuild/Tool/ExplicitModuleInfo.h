@@ -0,0 +1,68 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_Tool_ExplicitModuleInfo_h
+#define __pbxbuild_Tool_ExplicitModuleInfo_h
+
+#include <map>
+#include <string>
+#include <utility>
+#include <ext/optional>
+
+namespace pbxsetting { class Environment; }
+
+namespace pbxbuild {
+namespace Tool {
+
+/*
+ * Represents a Clang module built explicitly by another target, rather than
+ * implicitly inside each compile that imports it. Compiles load the built
+ * module instead of building their own copy in the module cache.
+ */
+class ExplicitModuleInfo {
+private:
+    std::string                                                _moduleName;
+    std::map<std::pair<std::string, std::string>, std::string> _modulePaths;
+
+public:
+    ExplicitModuleInfo(
+        std::string const &moduleName,
+        std::map<std::pair<std::string, std::string>, std::string> const &modulePaths);
+
+public:
+    /*
+     * The name of the module.
+     */
+    std::string const &moduleName() const
+    { return _moduleName; }
+
+    /*
+     * The built module for each variant and architecture built.
+     */
+    std::map<std::pair<std::string, std::string>, std::string> const &modulePaths() const
+    { return _modulePaths; }
+
+    /*
+     * The built module for a variant and architecture, if it is built.
+     */
+    ext::optional<std::string> modulePath(std::string const &variant, std::string const &architecture) const;
+
+public:
+    /*
+     * The path a target builds its module to. The environment is for the
+     * target, in a specific variant and architecture.
+     */
+    static std::string
+    ModulePath(pbxsetting::Environment const &environment);
+};
+
+}
+}
+
+#endif // !__pbxbuild_Tool_ExplicitModuleInfo_h
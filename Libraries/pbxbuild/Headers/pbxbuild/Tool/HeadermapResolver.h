@@ -22,6 +22,10 @@
 namespace pbxsetting { class Environment; }
 
 namespace pbxbuild {
+
+class FileTypeResolver;
+class HeadermapCache;
+
 namespace Tool {
 
 class SearchPaths;
@@ -32,15 +36,17 @@ private:
     pbxspec::PBX::Tool::shared_ptr     _tool;
     pbxspec::PBX::Compiler::shared_ptr _compiler;
     pbxspec::Manager::shared_ptr       _specManager;
+    std::shared_ptr<FileTypeResolver>  _fileTypeResolver;
 
 public:
-    HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager);
+    HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<FileTypeResolver> const &fileTypeResolver);
 
 public:
     void resolve(
         Tool::Context *toolContext,
         pbxsetting::Environment const &environment,
-        pbxproj::PBX::Target::shared_ptr const &target) const;
+        pbxproj::PBX::Target::shared_ptr const &target,
+        HeadermapCache *headermapCache = nullptr) const;
 
 public:
     pbxspec::PBX::Tool::shared_ptr const &tool() const
@@ -52,7 +58,7 @@ public:
 
 public:
     static std::unique_ptr<HeadermapResolver>
-    Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains, pbxspec::PBX::Compiler::shared_ptr const &compiler);
+    Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains, pbxspec::PBX::Compiler::shared_ptr const &compiler, std::shared_ptr<FileTypeResolver> const &fileTypeResolver);
 };
 
 }
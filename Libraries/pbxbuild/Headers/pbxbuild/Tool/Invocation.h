@@ -12,6 +12,7 @@
 
 #include <dependency/DependencyInfoFormat.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -86,41 +87,61 @@ public:
     };
 
 private:
-    ext::optional<Executable>                    _executable;
-    std::vector<std::string>                     _arguments;
-    std::unordered_map<std::string, std::string> _environment;
-    std::string                                  _workingDirectory;
+    std::string                                                   _toolIdentifier;
 
 private:
-    std::vector<std::string>                     _inputs;
-    std::vector<std::string>                     _outputs;
-    std::vector<std::string>                     _phonyInputs;
+    ext::optional<Executable>                                     _executable;
+    std::vector<std::string>                                      _arguments;
+    std::shared_ptr<std::unordered_map<std::string, std::string>> _environment;
+    std::string                                                   _workingDirectory;
 
 private:
-    std::vector<std::string>                     _inputDependencies;
-    std::vector<std::string>                     _orderDependencies;
+    std::vector<std::string>                                      _inputs;
+    std::vector<std::string>                                      _outputs;
+    std::vector<std::string>                                      _phonyInputs;
 
 private:
-    std::vector<DependencyInfo>                  _dependencyInfo;
+    std::vector<std::string>                                      _inputDependencies;
+    std::vector<std::string>                                      _orderDependencies;
 
 private:
-    std::string                                  _logMessage;
-    bool                                         _showEnvironmentInLog;
+    std::vector<DependencyInfo>                                   _dependencyInfo;
 
 private:
-    bool                                         _createsProductStructure;
+    std::string                                                   _logMessage;
+    bool                                                          _showEnvironmentInLog;
+
+private:
+    bool                                                          _createsProductStructure;
 
 public:
     Invocation();
+    Invocation(Invocation const &) = default;
+    Invocation(Invocation &&) = default;
     ~Invocation();
 
+public:
+    Invocation &operator=(Invocation const &) = default;
+    Invocation &operator=(Invocation &&) = default;
+
+public:
+    /*
+     * The identifier of the tool specification the invocation is for.
+     */
+    std::string const &toolIdentifier() const
+    { return _toolIdentifier; }
+
+public:
+    std::string &toolIdentifier()
+    { return _toolIdentifier; }
+
 public:
     ext::optional<Executable> const &executable() const
     { return _executable; }
     std::vector<std::string> const &arguments() const
     { return _arguments; }
     std::unordered_map<std::string, std::string> const &environment() const
-    { return _environment; }
+    { return *_environment; }
     std::string const &workingDirectory() const
     { return _workingDirectory; }
 
@@ -129,11 +150,18 @@ public:
     { return _executable; }
     std::vector<std::string> &arguments()
     { return _arguments; }
-    std::unordered_map<std::string, std::string> &environment()
-    { return _environment; }
+    std::unordered_map<std::string, std::string> &environment();
     std::string &workingDirectory()
     { return _workingDirectory; }
 
+public:
+    /*
+     * Share the environment of another invocation. Invocations sharing an
+     * environment copy it before changing it.
+     */
+    void shareEnvironment(Invocation const &invocation)
+    { _environment = invocation._environment; }
+
 public:
     std::vector<std::string> const &inputs() const
     { return _inputs; }
@@ -12,6 +12,8 @@
 
 #include <pbxproj/PBX/Target.h>
 
+#include <string>
+
 namespace pbxsetting { class Environment; }
 
 namespace pbxbuild {
@@ -30,6 +32,17 @@ public:
         pbxsetting::Environment const &environment,
         pbxproj::PBX::Target::shared_ptr const &target) const;
 
+public:
+    /*
+     * Whether a target has a standard module map, either specified in
+     * its build settings or generated from its umbrella header.
+     */
+    static bool
+    HasModuleMap(
+        pbxsetting::Environment const &environment,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        std::string const &workingDirectory);
+
 public:
     static std::unique_ptr<ModuleMapResolver>
     Create();
@@ -13,9 +13,13 @@
 #include <string>
 #include <vector>
 
+namespace libutil { class Filesystem; }
 namespace pbxsetting { class Environment; }
 
 namespace pbxbuild {
+
+class DirectoryCache;
+
 namespace Tool {
 
 class SearchPaths {
@@ -43,12 +47,16 @@ public:
     { return _librarySearchPaths; }
 
 public:
+    /*
+     * Resolve the search paths for an environment. Recursive search paths are
+     * expanded using the directory cache, if provided.
+     */
     static Tool::SearchPaths
-    Create(pbxsetting::Environment const &environment, std::string const &workingDirectory);
+    Create(libutil::Filesystem const *filesystem, pbxsetting::Environment const &environment, std::string const &workingDirectory, DirectoryCache *directoryCache = nullptr);
 
 public:
     static std::vector<std::string>
-    ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory);
+    ExpandRecursive(libutil::Filesystem const *filesystem, std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory, DirectoryCache *directoryCache = nullptr);
 };
 
 }
@@ -12,6 +12,7 @@
 
 #include <pbxbuild/Base.h>
 #include <pbxbuild/DerivedDataHash.h>
+#include <pbxbuild/TargetIndex.h>
 #include <pbxsetting/XC/Config.h>
 
 namespace pbxsetting { class Environment; }
@@ -37,6 +38,7 @@ private:
     std::vector<xcscheme::SchemeGroup::shared_ptr> _schemeGroups;
     std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> _projects;
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> _configs;
+    std::shared_ptr<TargetIndex const>             _targetIndex;
 
 public:
     WorkspaceContext(
@@ -94,6 +96,12 @@ public:
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> const &configs() const
     { return _configs; }
 
+    /*
+     * The targets in all projects, by identifier and by product.
+     */
+    TargetIndex const &targetIndex() const
+    { return *_targetIndex; }
+
 public:
     /*
      * Find a project in the workspace. Could be the root project (for a legacy build), a project
@@ -117,6 +125,27 @@ public:
      */
     std::vector<std::string> loadedFilePaths() const;
 
+public:
+    /*
+     * Save snapshots of each project in the workspace that was not opened
+     * from a fresh snapshot, so later builds open them faster.
+     */
+    void saveProjectSnapshots(libutil::Filesystem *filesystem, pbxsetting::Environment const &baseEnvironment) const;
+
+    /*
+     * The path to save a project's snapshot, in the project's directory
+     * inside DerivedData. Empty if the project path cannot be resolved.
+     */
+    static std::string
+    ProjectSnapshotPath(libutil::Filesystem const *filesystem, pbxsetting::Environment const &baseEnvironment, std::string const &projectPath);
+
+    /*
+     * The path to save the file types detected while building this
+     * workspace, in its directory inside DerivedData. Empty if there is no
+     * DerivedData directory.
+     */
+    std::string fileTypeCachePath(pbxsetting::Environment const &baseEnvironment) const;
+
 public:
     /*
      * Creates a workspace context from a real workspace.
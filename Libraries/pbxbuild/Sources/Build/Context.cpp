@@ -8,9 +8,13 @@
  */
 
 #include <pbxbuild/Build/Context.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
 
 namespace Build = pbxbuild::Build;
 namespace Target = pbxbuild::Target;
+using libutil::Parallel;
 
 Build::Context::
 Context(
@@ -22,67 +26,107 @@ Context(
     bool defaultConfiguration,
     std::vector<pbxsetting::Level> const &overrideLevels
 ) :
-    _workspaceContext    (workspaceContext),
-    _scheme              (scheme),
-    _schemeGroup         (schemeGroup),
-    _action              (action),
-    _configuration       (configuration),
-    _defaultConfiguration(defaultConfiguration),
-    _overrideLevels      (overrideLevels),
-    _targetEnvironments  (std::make_shared<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>>())
+    _workspaceContext       (workspaceContext),
+    _scheme                 (scheme),
+    _schemeGroup            (schemeGroup),
+    _action                 (action),
+    _configuration          (configuration),
+    _defaultConfiguration   (defaultConfiguration),
+    _overrideLevels         (overrideLevels),
+    _targetEnvironments     (std::make_shared<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>>()),
+    _targetEnvironmentsMutex(std::make_shared<std::mutex>()),
+    _directoryCache         (std::make_shared<DirectoryCache>()),
+    _sdkEnvironments        (std::make_shared<std::map<std::pair<pbxspec::PBX::BuildSystem::shared_ptr, xcsdk::SDK::Target::shared_ptr>, pbxsetting::Environment>>()),
+    _sdkEnvironmentsMutex   (std::make_shared<std::mutex>()),
+    _headermapCache         (std::make_shared<HeadermapCache>()),
+    _fileTypeCache          (std::make_shared<FileTypeCache>()),
+    _filesystem             (std::make_shared<libutil::CachingFilesystem>(libutil::Filesystem::GetDefaultUNSAFE()))
 {
 }
 
 ext::optional<pbxbuild::Target::Environment> Build::Context::
 targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const
 {
-    auto TEI = _targetEnvironments->find(target);
-    if (TEI != _targetEnvironments->end()) {
-        return TEI->second;
-    } else {
-        ext::optional<Target::Environment> targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
-        if (targetEnvironment) {
-            _targetEnvironments->insert(std::make_pair(target, *targetEnvironment));
+    {
+        std::lock_guard<std::mutex> lock(*_targetEnvironmentsMutex);
+
+        auto TEI = _targetEnvironments->find(target);
+        if (TEI != _targetEnvironments->end()) {
+            return TEI->second;
         }
-        return targetEnvironment;
     }
+
+    /*
+     * Create the environment without holding the lock, so targets can be
+     * resolved in parallel. If another thread finished first, keep its copy.
+     */
+    ext::optional<Target::Environment> targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
+    if (targetEnvironment) {
+        std::lock_guard<std::mutex> lock(*_targetEnvironmentsMutex);
+
+        auto result = _targetEnvironments->insert(std::make_pair(target, *targetEnvironment));
+        return result.first->second;
+    }
+    return targetEnvironment;
 }
 
-pbxproj::PBX::Target::shared_ptr Build::Context::
-resolveTargetIdentifier(pbxproj::PBX::Project::shared_ptr const &project, std::string const &identifier) const
+void Build::Context::
+prepareTargetEnvironments(Build::Environment const &buildEnvironment, std::vector<pbxproj::PBX::Target::shared_ptr> const &targets) const
 {
-    if (project == nullptr) {
-        return nullptr;
-    }
+    /* Failures are left for targetEnvironment() to report when fetched. */
+    Parallel::For(Parallel::DefaultJobs(), targets.size(), [&](size_t n) {
+        this->targetEnvironment(buildEnvironment, targets[n]);
+    });
+}
 
-    pbxproj::PBX::Target::shared_ptr foundTarget = nullptr;
-    for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
-        if (target->blueprintIdentifier() == identifier) {
-            return target;
+void Build::Context::
+shareTargetEnvironments(Context const &context)
+{
+    _targetEnvironments = context._targetEnvironments;
+    _targetEnvironmentsMutex = context._targetEnvironmentsMutex;
+    _sdkEnvironments = context._sdkEnvironments;
+    _sdkEnvironmentsMutex = context._sdkEnvironmentsMutex;
+    _fileTypeCache = context._fileTypeCache;
+}
+
+pbxsetting::Environment Build::Context::
+sdkEnvironment(
+    pbxspec::PBX::BuildSystem::shared_ptr const &buildSystem,
+    xcsdk::SDK::Target::shared_ptr const &sdk,
+    std::function<pbxsetting::Environment()> const &create) const
+{
+    auto key = std::make_pair(buildSystem, sdk);
+
+    {
+        std::lock_guard<std::mutex> lock(*_sdkEnvironmentsMutex);
+
+        auto it = _sdkEnvironments->find(key);
+        if (it != _sdkEnvironments->end()) {
+            return pbxsetting::Environment(it->second);
         }
     }
 
-    return nullptr;
+    /*
+     * Create the levels outside the lock; if another thread creates the
+     * same levels at the same time, the first stored is used.
+     */
+    pbxsetting::Environment environment = create();
+
+    std::lock_guard<std::mutex> lock(*_sdkEnvironmentsMutex);
+    auto it = _sdkEnvironments->emplace(key, std::move(environment)).first;
+    return pbxsetting::Environment(it->second);
+}
+
+pbxproj::PBX::Target::shared_ptr Build::Context::
+resolveTargetIdentifier(pbxproj::PBX::Project::shared_ptr const &project, std::string const &identifier) const
+{
+    return _workspaceContext.targetIndex().target(project, identifier);
 }
 
 ext::optional<std::pair<pbxproj::PBX::Target::shared_ptr, pbxproj::PBX::FileReference::shared_ptr>> Build::Context::
 resolveProductIdentifier(pbxproj::PBX::Project::shared_ptr const &project, std::string const &identifier) const
 {
-    if (project == nullptr) {
-        return ext::nullopt;
-    }
-
-    pbxproj::PBX::Target::shared_ptr foundTarget = nullptr;
-    for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
-        if (target->type() == pbxproj::PBX::Target::Type::Native) {
-            pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
-            if (nativeTarget->productReference() != nullptr && nativeTarget->productReference()->blueprintIdentifier() == identifier) {
-                return std::make_pair(target, nativeTarget->productReference());
-            }
-        }
-    }
-
-    return ext::nullopt;
+    return _workspaceContext.targetIndex().product(project, identifier);
 }
 
 pbxsetting::Level Build::Context::
@@ -9,12 +9,14 @@
 
 #include <pbxbuild/Build/DependencyResolver.h>
 #include <pbxbuild/Target/Environment.h>
+#include <libutil/Trace.h>
 
 #define DEPENDENCY_RESOLVER_LOGGING 0
 
 namespace Build = pbxbuild::Build;
 namespace Target = pbxbuild::Target;
 using pbxbuild::WorkspaceContext;
+using pbxbuild::TargetIndex;
 using pbxbuild::DirectedGraph;
 using xcscheme::XC::Scheme;
 using xcscheme::XC::BuildAction;
@@ -62,15 +64,43 @@ ResolveContainerItemProxy(Build::Environment const &buildEnvironment, Build::Con
     }
 }
 
+/*
+ * Proxies resolved so far, for implicit (product reference) and explicit
+ * dependencies. A proxy's container is relative to the project containing
+ * it, so it resolves to the same target for each target that uses it.
+ */
+struct ResolvedProxies {
+    std::unordered_map<pbxproj::PBX::ContainerItemProxy::shared_ptr, pbxproj::PBX::Target::shared_ptr> products;
+    std::unordered_map<pbxproj::PBX::ContainerItemProxy::shared_ptr, pbxproj::PBX::Target::shared_ptr> targets;
+};
+
 struct DependenciesContext {
     Build::Environment const *buildEnvironment;
     Build::Context     const *buildContext;
     DirectedGraph<pbxproj::PBX::Target::shared_ptr> *graph;
     BuildAction::shared_ptr buildAction;
     std::unordered_set<pbxproj::PBX::Target::shared_ptr> *positional;
-    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> *productNameToTarget;
+    TargetIndex const *productNames;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> *visited;
+    ResolvedProxies *resolvedProxies;
 };
 
+static pbxproj::PBX::Target::shared_ptr
+ResolveContainerItemProxy(DependenciesContext const &context, pbxproj::PBX::Target::shared_ptr const &target, pbxproj::PBX::ContainerItemProxy::shared_ptr const &proxy, bool productReference)
+{
+    auto *resolved = (productReference ? &context.resolvedProxies->products : &context.resolvedProxies->targets);
+
+    auto it = resolved->find(proxy);
+    if (it != resolved->end()) {
+        return it->second;
+    }
+
+    /* Failures are remembered too, so they are not resolved again. */
+    pbxproj::PBX::Target::shared_ptr proxiedTarget = ResolveContainerItemProxy(*context.buildEnvironment, *context.buildContext, target, proxy, productReference);
+    resolved->insert({ proxy, proxiedTarget });
+    return proxiedTarget;
+}
+
 static void
 AddDependencies(DependenciesContext const &context, pbxproj::PBX::Target::shared_ptr const &target);
 
@@ -92,7 +122,7 @@ AddImplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
                     /* A implicit dependency referencing the product of another target through a direct reference to that target's product. */
                     pbxproj::PBX::ReferenceProxy::shared_ptr proxy = std::static_pointer_cast <pbxproj::PBX::ReferenceProxy> (file->fileRef());
 
-                    pbxproj::PBX::Target::shared_ptr proxiedTarget = ResolveContainerItemProxy(*context.buildEnvironment, *context.buildContext, target, proxy->remoteRef(), true);
+                    pbxproj::PBX::Target::shared_ptr proxiedTarget = ResolveContainerItemProxy(context, target, proxy->remoteRef(), true);
                     if (proxiedTarget != nullptr) {
                         dependencies.insert(proxiedTarget);
 
@@ -112,9 +142,9 @@ AddImplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
                     pbxproj::PBX::FileReference::shared_ptr fileReference = std::static_pointer_cast<pbxproj::PBX::FileReference>(file->fileRef());
                     std::string name = fileReference->name();
 
-                    auto it = context.productNameToTarget->find(name);
-                    if (it != context.productNameToTarget->end()) {
-                        pbxproj::PBX::Target::shared_ptr dependentTarget = it->second;
+                    /* Use the product name because the path can't be resolved yet. */
+                    pbxproj::PBX::Target::shared_ptr dependentTarget = (context.productNames != nullptr ? context.productNames->productName(name) : nullptr);
+                    if (dependentTarget != nullptr) {
                         dependencies.insert(dependentTarget);
 
 #if DEPENDENCY_RESOLVER_LOGGING
@@ -159,7 +189,7 @@ AddExplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
             AddDependencies(context, dependency->target());
         } else if (dependency->targetProxy() != nullptr) {
             /* A dependency referencing a target in another project. Get that target. */
-            pbxproj::PBX::Target::shared_ptr proxiedTarget = ResolveContainerItemProxy(*context.buildEnvironment, *context.buildContext, target, dependency->targetProxy(), false);
+            pbxproj::PBX::Target::shared_ptr proxiedTarget = ResolveContainerItemProxy(context, target, dependency->targetProxy(), false);
             if (proxiedTarget != nullptr) {
                 dependencies.insert(proxiedTarget);
 
@@ -185,6 +215,14 @@ AddExplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
 static void
 AddDependencies(DependenciesContext const &context, pbxproj::PBX::Target::shared_ptr const &target)
 {
+    /*
+     * Adding a target's dependencies again adds nothing new to the graph, so
+     * each target is only walked once. This also stops at dependency cycles.
+     */
+    if (!context.visited->insert(target).second) {
+        return;
+    }
+
     /* If there's no build action, this is a legacy context which always have implicit dependencies. */
     if (context.buildAction == nullptr || context.buildAction->buildImplicitDependencies()) {
         AddImplicitDependencies(context, target);
@@ -211,42 +249,11 @@ AddDependencies(DependenciesContext const &context, pbxproj::PBX::Target::shared
     }
 }
 
-static std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr>
-BuildProductPathsToTargets(WorkspaceContext const &workspaceContext)
-{
-    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> productNameToTarget;
-
-    /*
-     * Build a mapping of product path -> target, in order to look up implicit dependencies
-     * where the product paths match, but the dependency is not through a container portal.
-     */
-    for (auto const &pair : workspaceContext.projects()) {
-        for (pbxproj::PBX::Target::shared_ptr const &target : pair.second->targets()) {
-            if (target->type() != pbxproj::PBX::Target::Type::Native) {
-                /* Only native targets have products. */
-                continue;
-            }
-
-            pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
-            pbxproj::PBX::FileReference::shared_ptr const &productReference = nativeTarget->productReference();
-
-            if (productReference != nullptr) {
-                /* Use the product name because we can't resolve the path yet. */
-                std::string productName = productReference->name();
-#if DEPENDENCY_RESOLVER_LOGGING
-                fprintf(stderr, "debug: product output: %s %s => %s\n", target->blueprintIdentifier().c_str(), target->name().c_str(), productName.c_str());
-#endif
-                productNameToTarget.insert({ productName, nativeTarget });
-            }
-        }
-    }
-
-    return productNameToTarget;
-}
-
 DirectedGraph<pbxproj::PBX::Target::shared_ptr> Build::DependencyResolver::
 resolveSchemeDependencies(Build::Context const &context) const
 {
+    libutil::Trace::Span span("Resolve Dependencies");
+
     DirectedGraph<pbxproj::PBX::Target::shared_ptr> graph;
 
     xcscheme::XC::Scheme::shared_ptr const &scheme = context.scheme();
@@ -261,13 +268,12 @@ resolveSchemeDependencies(Build::Context const &context) const
         return graph;
     }
 
-    /* Only create the product path mapping if we have implicit dependencies on to use it. */
-    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> productNameToTarget;
-    if (buildAction->buildImplicitDependencies()) {
-        productNameToTarget = BuildProductPathsToTargets(context.workspaceContext());
-    }
+    /* Only find targets by product name if implicit dependencies are enabled. */
+    TargetIndex const *productNames = (buildAction->buildImplicitDependencies() ? &context.workspaceContext().targetIndex() : nullptr);
 
     std::unordered_set<pbxproj::PBX::Target::shared_ptr> positional;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> visited;
+    ResolvedProxies resolvedProxies;
     for (BuildActionEntry::shared_ptr const &entry : buildAction->buildActionEntries()) {
         // TODO(grp): Check the buildFor* flags against the Build::Context.
         if (!entry->buildForRunning()) {
@@ -312,7 +318,9 @@ resolveSchemeDependencies(Build::Context const &context) const
             .graph = &graph,
             .buildAction = buildAction,
             .positional = &positional,
-            .productNameToTarget = &productNameToTarget,
+            .productNames = productNames,
+            .visited = &visited,
+            .resolvedProxies = &resolvedProxies,
         };
         AddDependencies(dependenciesContext, target);
     }
@@ -333,6 +341,8 @@ resolveSchemeDependencies(Build::Context const &context) const
 DirectedGraph<pbxproj::PBX::Target::shared_ptr> Build::DependencyResolver::
 resolveLegacyDependencies(Build::Context const &context, bool allTargets, ext::optional<std::vector<std::string>> const &targetNames) const
 {
+    libutil::Trace::Span span("Resolve Dependencies");
+
     DirectedGraph<pbxproj::PBX::Target::shared_ptr> graph;
 
     pbxproj::PBX::Project::shared_ptr const &project = context.workspaceContext().project();
@@ -341,9 +351,9 @@ resolveLegacyDependencies(Build::Context const &context, bool allTargets, ext::o
         return graph;
     }
 
-    auto productNameToTarget = BuildProductPathsToTargets(context.workspaceContext());
-
     std::unordered_set<pbxproj::PBX::Target::shared_ptr> positional;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> visited;
+    ResolvedProxies resolvedProxies;
     for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
         if (!allTargets) {
             if (targetNames && std::find(targetNames->begin(), targetNames->end(), target->name()) == targetNames->end()) {
@@ -361,7 +371,9 @@ resolveLegacyDependencies(Build::Context const &context, bool allTargets, ext::o
             .graph = &graph,
             .buildAction = nullptr,
             .positional = &positional,
-            .productNameToTarget = &productNameToTarget,
+            .productNames = &context.workspaceContext().targetIndex(),
+            .visited = &visited,
+            .resolvedProxies = &resolvedProxies,
         };
         AddDependencies(dependenciesContext, target);
     }
@@ -12,16 +12,18 @@
 #include <xcsdk/Environment.h>
 #include <pbxsetting/DefaultSettings.h>
 #include <pbxsetting/Environment.h>
+#include <process/Context.h>
 #include <libutil/Filesystem.h>
 
 namespace Build = pbxbuild::Build;
 using libutil::Filesystem;
 
 Build::Environment::
-Environment(pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<xcsdk::SDK::Manager> const &sdkManager, pbxsetting::Environment const &baseEnvironment) :
+Environment(pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<xcsdk::SDK::Manager> const &sdkManager, pbxsetting::Environment const &baseEnvironment, std::shared_ptr<pbxbuild::FileTypeResolver> const &fileTypeResolver) :
     _specManager(specManager),
     _sdkManager(sdkManager),
-    _baseEnvironment(baseEnvironment)
+    _baseEnvironment(baseEnvironment),
+    _fileTypeResolver(fileTypeResolver)
 {
 }
 
@@ -64,7 +66,8 @@ Default(process::Context const *processContext, Filesystem const *filesystem)
     }
 
     /*
-     * Register platform-specific specifications.
+     * Register platform-specific specifications. This loads every platform,
+     * as do the computed settings below; only their SDKs load as needed.
      */
     std::unordered_map<std::string, std::string> platforms;
     for (xcsdk::SDK::Platform::shared_ptr const &platform : sdkManager->platforms()) {
@@ -91,5 +94,36 @@ Default(process::Context const *processContext, Filesystem const *filesystem)
         baseEnvironment.insertBack(level, false);
     }
 
-    return Build::Environment(specManager, sdkManager, baseEnvironment);
+    ext::optional<pbxbuild::FileTypeResolver> fileTypeResolver = pbxbuild::FileTypeResolver::Create(specManager, { pbxspec::Manager::AnyDomain() });
+    if (!fileTypeResolver) {
+        fprintf(stderr, "error: couldn't create file type resolver\n");
+        return ext::nullopt;
+    }
+
+    return Build::Environment(specManager, sdkManager, baseEnvironment, std::make_shared<pbxbuild::FileTypeResolver>(*fileTypeResolver));
+}
+
+ext::optional<std::string> Build::Environment::
+CachePath(process::Context const *processContext)
+{
+#if defined(__APPLE__)
+    ext::optional<std::string> home = processContext->userHomeDirectory();
+    if (!home) {
+        return ext::nullopt;
+    }
+
+    return *home + "/Library/Caches/xcbuild/PropertyLists.plist";
+#else
+    ext::optional<std::string> cache = processContext->environmentVariable("XDG_CACHE_HOME");
+    if (!cache) {
+        ext::optional<std::string> home = processContext->userHomeDirectory();
+        if (!home) {
+            return ext::nullopt;
+        }
+
+        cache = *home + "/.cache";
+    }
+
+    return *cache + "/xcbuild/PropertyLists.plist";
+#endif
 }
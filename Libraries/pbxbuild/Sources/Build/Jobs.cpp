@@ -0,0 +1,53 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/Build/Jobs.h>
+#include <pbxsetting/Type.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+
+namespace Build = pbxbuild::Build;
+
+/*
+ * Each Swift compile is expected to use this many threads on a machine
+ * with enough jobs for it, as it did before the jobs were shared.
+ */
+static size_t const SwiftDefaultThreads = 8;
+
+size_t Build::Jobs::
+Count(pbxsetting::Environment const &environment)
+{
+    int64_t jobs = pbxsetting::Type::ParseInteger(environment.resolve("XCBUILD_JOBS"));
+    if (jobs > 0) {
+        return static_cast<size_t>(jobs);
+    }
+
+    return libutil::Parallel::DefaultJobs();
+}
+
+size_t Build::Jobs::
+SwiftCompiles(pbxsetting::Environment const &environment)
+{
+    size_t jobs = Count(environment);
+
+    std::string depth = environment.resolve("NINJA_SWIFT_POOL_DEPTH");
+    if (!depth.empty()) {
+        int64_t value = pbxsetting::Type::ParseInteger(depth);
+        return (value > 0 ? std::min<size_t>(static_cast<size_t>(value), jobs) : jobs);
+    }
+
+    return std::max<size_t>(jobs / SwiftDefaultThreads, 1);
+}
+
+size_t Build::Jobs::
+SwiftThreads(pbxsetting::Environment const &environment)
+{
+    return std::max<size_t>(Count(environment) / SwiftCompiles(environment), 1);
+}
@@ -0,0 +1,98 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/CompactGraph.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+using pbxbuild::CompactGraph;
+
+CompactGraph::
+CompactGraph(size_t size, std::vector<std::pair<size_t, size_t>> const &edges) :
+    _offsets(size + 1, 0)
+{
+    /* Count each node's edges, then place them in order after the counts. */
+    for (std::pair<size_t, size_t> const &edge : edges) {
+        _offsets[edge.first + 1]++;
+    }
+    for (size_t node = 0; node < size; ++node) {
+        _offsets[node + 1] += _offsets[node];
+    }
+
+    _adjacent.resize(edges.size());
+    std::vector<size_t> next = std::vector<size_t>(_offsets.begin(), _offsets.end() - 1);
+    for (std::pair<size_t, size_t> const &edge : edges) {
+        _adjacent[next[edge.first]++] = edge.second;
+    }
+
+    /* Drop repeated edges, keeping the first of each. */
+    std::vector<size_t> seen = std::vector<size_t>(size, size);
+    size_t write = 0;
+    for (size_t node = 0; node < size; ++node) {
+        size_t begin = _offsets[node];
+        _offsets[node] = write;
+        for (size_t read = begin; read < _offsets[node + 1]; ++read) {
+            size_t adjacent = _adjacent[read];
+            if (seen[adjacent] != node) {
+                seen[adjacent] = node;
+                _adjacent[write++] = adjacent;
+            }
+        }
+    }
+    _offsets[size] = write;
+    _adjacent.resize(write);
+}
+
+ext::optional<std::vector<size_t>> CompactGraph::
+ordered() const
+{
+    size_t count = size();
+
+    /* Nodes waiting on each node, and how many nodes each is waiting on. */
+    std::vector<size_t> remaining = std::vector<size_t>(count, 0);
+    std::vector<std::pair<size_t, size_t>> reverse;
+    reverse.reserve(_adjacent.size());
+    for (size_t node = 0; node < count; ++node) {
+        remaining[node] = adjacent(node).size();
+        for (size_t adjacent : this->adjacent(node)) {
+            reverse.push_back({ adjacent, node });
+        }
+    }
+    CompactGraph waiting = CompactGraph(count, reverse);
+
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+    for (size_t node = 0; node < count; ++node) {
+        if (remaining[node] == 0) {
+            ready.push(node);
+        }
+    }
+
+    std::vector<size_t> result;
+    result.reserve(count);
+    while (!ready.empty()) {
+        size_t node = ready.top();
+        ready.pop();
+        result.push_back(node);
+
+        for (size_t dependent : waiting.adjacent(node)) {
+            if (--remaining[dependent] == 0) {
+                ready.push(dependent);
+            }
+        }
+    }
+
+    /* Nodes in a cycle are never ready. */
+    if (result.size() != count) {
+        return ext::nullopt;
+    }
+
+    return result;
+}
@@ -8,10 +8,10 @@
  */
 
 #include <pbxbuild/DirectedGraph.h>
+#include <pbxbuild/CompactGraph.h>
 #include <pbxbuild/Tool/Invocation.h>
 
-#include <algorithm>
-#include <cassert>
+#include <cstdint>
 
 using pbxbuild::DirectedGraph;
 
@@ -53,49 +53,86 @@ template<class T>
 ext::optional<std::vector<T>> DirectedGraph<T>::
 ordered(void) const
 {
-    std::vector<T> result;
+    /*
+     * Number the nodes, those with edges first, so the search below only
+     * looks nodes up by index. Edges keep the order they are stored in.
+     */
+    std::vector<T> nodes;
+    std::unordered_map<T, size_t> ids;
+    nodes.reserve(_nodes.size());
+    ids.reserve(_nodes.size());
+
+    auto id = [&](T const &node) -> size_t {
+        auto result = ids.insert({ node, nodes.size() });
+        if (result.second) {
+            nodes.push_back(node);
+        }
+        return result.first->second;
+    };
+
+    for (std::pair<T, std::unordered_set<T>> const &pair : _adjacency) {
+        id(pair.first);
+    }
+    size_t roots = nodes.size();
+
+    std::vector<std::pair<size_t, size_t>> edges;
+    for (std::pair<T, std::unordered_set<T>> const &pair : _adjacency) {
+        size_t node = ids.at(pair.first);
+        for (T const &child : pair.second) {
+            edges.push_back({ node, id(child) });
+        }
+    }
 
-    std::list<T> toExplore;
-    std::transform(_adjacency.begin(), _adjacency.end(), std::back_inserter(toExplore), [](std::pair<T, std::unordered_set<T>> const &pair) {
-        return pair.first;
-    });
+    CompactGraph graph = CompactGraph(nodes.size(), edges);
+
+    /*
+     * Depth first, so each node comes after the nodes it is adjacent to.
+     * The back of the stack is explored next.
+     */
+    enum class State : uint8_t {
+        Unexplored,
+        InProgress,
+        Explored,
+    };
+    std::vector<State> states = std::vector<State>(nodes.size(), State::Unexplored);
+
+    std::vector<size_t> toExplore;
+    toExplore.reserve(roots);
+    for (size_t root = roots; root > 0; --root) {
+        toExplore.push_back(root - 1);
+    }
 
-    std::unordered_set<T> inProgress;
-    std::unordered_set<T> explored;
+    std::vector<T> result;
+    result.reserve(nodes.size());
 
     while (!toExplore.empty()) {
-        T node = toExplore.front();
-        if (explored.find(node) != explored.end()) {
-            toExplore.pop_front();
+        size_t node = toExplore.back();
+        if (states[node] == State::Explored) {
+            toExplore.pop_back();
             continue;
         }
 
         size_t stack = toExplore.size();
-        inProgress.insert(node);
-
-        auto it = _adjacency.find(node);
-        if (it != _adjacency.end()) {
-            for (T const &child : it->second) {
-                if (inProgress.find(child) != inProgress.end()) {
-                    return ext::nullopt;
-                }
-
-                if (explored.find(child) == explored.end()) {
-                    toExplore.push_front(child);
-                    break;
-                }
+        states[node] = State::InProgress;
+
+        for (size_t child : graph.adjacent(node)) {
+            if (states[child] == State::InProgress) {
+                return ext::nullopt;
+            }
+
+            if (states[child] != State::Explored) {
+                toExplore.push_back(child);
+                break;
             }
         }
 
         if (stack == toExplore.size()) {
-            toExplore.pop_front();
-            inProgress.erase(node);
-            explored.insert(node);
-            result.push_back(node);
+            toExplore.pop_back();
+            states[node] = State::Explored;
+            result.push_back(nodes[node]);
         }
     }
 
-    assert(inProgress.empty());
     return result;
 }
 
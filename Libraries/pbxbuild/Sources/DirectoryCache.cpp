@@ -0,0 +1,56 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/DirectoryCache.h>
+
+#include <algorithm>
+
+using pbxbuild::DirectoryCache;
+using libutil::Filesystem;
+
+DirectoryCache::Entry::
+Entry(std::string const &name, ext::optional<Filesystem::Type> const &type) :
+    _name(name),
+    _type(type)
+{
+}
+
+DirectoryCache::
+DirectoryCache()
+{
+}
+
+std::shared_ptr<std::vector<DirectoryCache::Entry> const> DirectoryCache::
+read(Filesystem const *filesystem, std::string const &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _directories.find(path);
+        if (it != _directories.end()) {
+            return it->second;
+        }
+    }
+
+    /*
+     * Read the directory outside the lock; if another thread reads the same
+     * directory at the same time, the first result stored is used.
+     */
+    auto entries = std::make_shared<std::vector<Entry>>();
+    filesystem->readDirectory(path, false, [&](std::string const &name, ext::optional<Filesystem::Type> type) {
+        entries->push_back(Entry(name, type));
+    });
+
+    std::sort(entries->begin(), entries->end(), [](Entry const &a, Entry const &b) {
+        return a.name() < b.name();
+    });
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _directories.insert({ path, entries }).first->second;
+}
@@ -0,0 +1,147 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/FileTypeCache.h>
+#include <plist/Boolean.h>
+#include <plist/CacheFile.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+
+using pbxbuild::FileTypeCache;
+using libutil::Filesystem;
+
+static int64_t const CacheVersion = 1;
+
+FileTypeCache::
+FileTypeCache() :
+    _modified(false)
+{
+}
+
+ext::optional<std::string> FileTypeCache::
+find(Filesystem const *filesystem, std::string const &path)
+{
+    bool directory;
+    Filesystem::Stamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _entries.find(path);
+        if (it == _entries.end()) {
+            return ext::nullopt;
+        }
+
+        directory = it->second.directory;
+        stamp = it->second.stamp;
+    }
+
+    /* Only one stat, outside the lock; the entry knows what kind of file to expect. */
+    ext::optional<Filesystem::Stamp> current = (directory ? filesystem->readDirectoryStamp(path) : filesystem->readFileStamp(path));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _entries.find(path);
+    if (it == _entries.end()) {
+        return ext::nullopt;
+    }
+
+    if (current != it->second.stamp || it->second.directory != directory) {
+        /* Changed since detected; it will be detected again. */
+        _entries.erase(it);
+        _modified = true;
+        return ext::nullopt;
+    }
+
+    return it->second.identifier;
+}
+
+void FileTypeCache::
+insert(Filesystem const *filesystem, std::string const &path, std::string const &identifier)
+{
+    bool directory = false;
+    ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(path);
+    if (!stamp) {
+        directory = true;
+        stamp = filesystem->readDirectoryStamp(path);
+    }
+
+    if (!stamp) {
+        /* Missing, or changes to the file can't be seen. */
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries[path] = Entry { directory, *stamp, identifier };
+    _modified = true;
+}
+
+bool FileTypeCache::
+load(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<plist::Dictionary> root = plist::CacheFile::Load(filesystem, path, CacheVersion);
+    auto entries = (root != nullptr ? root->value<plist::Dictionary>("Entries") : nullptr);
+    if (entries == nullptr) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (size_t n = 0; n < entries->count(); ++n) {
+        auto dict = entries->value<plist::Dictionary>(n);
+        if (dict == nullptr) {
+            continue;
+        }
+
+        auto identifier = dict->value<plist::String>("Identifier");
+        auto size = dict->value<plist::Integer>("Size");
+        auto modificationTime = dict->value<plist::Integer>("ModificationTime");
+        auto directory = dict->value<plist::Boolean>("Directory");
+        if (identifier == nullptr || size == nullptr || modificationTime == nullptr) {
+            continue;
+        }
+
+        Filesystem::Stamp stamp = { static_cast<uint64_t>(size->value()), modificationTime->value() };
+        _entries[entries->key(n)] = Entry { directory != nullptr && directory->value(), stamp, identifier->value() };
+    }
+
+    _modified = false;
+    return true;
+}
+
+bool FileTypeCache::
+save(Filesystem *filesystem, std::string const &path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_modified) {
+        return true;
+    }
+
+    auto entries = plist::Dictionary::New();
+    for (auto const &it : _entries) {
+        auto dict = plist::Dictionary::New();
+        dict->set("Identifier", plist::String::New(it.second.identifier));
+        dict->set("Size", plist::Integer::New(static_cast<int64_t>(it.second.stamp.size)));
+        dict->set("ModificationTime", plist::Integer::New(it.second.stamp.modificationTime));
+        if (it.second.directory) {
+            dict->set("Directory", plist::Boolean::New(true));
+        }
+
+        entries->set(it.first, std::move(dict));
+    }
+
+    auto root = plist::Dictionary::New();
+    root->set("Entries", std::move(entries));
+    if (!plist::CacheFile::Save(filesystem, path, CacheVersion, std::move(root))) {
+        return false;
+    }
+
+    _modified = false;
+    return true;
+}
@@ -8,18 +8,30 @@
  */
 
 #include <pbxbuild/FileTypeResolver.h>
+#include <pbxbuild/FileTypeCache.h>
 #include <pbxbuild/DirectedGraph.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Statistics.h>
 #include <libutil/Wildcard.h>
 
-#include <cassert>
-#include <strings.h>
+#include <algorithm>
+#include <cctype>
+#include <iterator>
 
 using pbxbuild::FileTypeResolver;
+using pbxbuild::FileTypeCache;
 using pbxbuild::DirectedGraph;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Statistics;
+
+/*
+ * Resolutions from a reference, and those that had to look at the file.
+ */
+static Statistics::Counter ResolveCalls("FileTypeResolver::resolve calls");
+static Statistics::Counter ResolveDetections("FileTypeResolver::resolve detections");
+static Statistics::Counter ResolveCacheHits("FileTypeResolver::resolve cache hits");
 using libutil::Wildcard;
 
 static ext::optional<std::vector<pbxspec::PBX::FileType::shared_ptr>>
@@ -38,9 +50,92 @@ SortedFileTypes(std::vector<pbxspec::PBX::FileType::shared_ptr> const &fileTypes
     return graph.ordered();
 }
 
+static std::string
+Lowercase(std::string const &string)
+{
+    // TODO(grp): Is this correct? Needed for handling ".S" as ".s", but might be over-broad.
+    std::string result = string;
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+static bool
+IsWildcard(std::string const &pattern)
+{
+    /* Patterns without special characters only match exactly. */
+    return pattern.find_first_of("*[") != std::string::npos;
+}
+
+FileTypeResolver::
+FileTypeResolver(
+    pbxspec::Manager::shared_ptr const &specManager,
+    pbxspec::DomainSet::shared_ptr const &domainSet,
+    std::vector<pbxspec::PBX::FileType::shared_ptr> const &fileTypes) :
+    _specManager(specManager),
+    _domainSet  (domainSet),
+    _fileTypes  (fileTypes)
+{
+    for (size_t index = 0; index < _fileTypes.size(); ++index) {
+        pbxspec::PBX::FileType::shared_ptr const &fileType = _fileTypes[index];
+
+        std::vector<Wildcard::Pattern> filenamePatterns;
+        if (fileType->filenamePatterns()) {
+            for (std::string const &pattern : *fileType->filenamePatterns()) {
+                filenamePatterns.push_back(Wildcard::Compile(pattern));
+            }
+        }
+        _filenamePatterns.push_back(filenamePatterns);
+
+        /*
+         * Index by the most selective check a file type has; the rest of the
+         * checks for the file type are done when resolving.
+         */
+        if (fileType->extensions()) {
+            std::unordered_set<std::string> extensions;
+            for (std::string const &extension : *fileType->extensions()) {
+                extensions.insert(Lowercase(extension));
+            }
+
+            for (std::string const &extension : extensions) {
+                _extensionFileTypes[extension].push_back(index);
+            }
+        } else if (fileType->prefix()) {
+            for (std::string const &prefix : *fileType->prefix()) {
+                _prefixFileTypes[prefix.size()][prefix].push_back(index);
+            }
+        } else if (fileType->filenamePatterns() && std::none_of(fileType->filenamePatterns()->begin(), fileType->filenamePatterns()->end(), IsWildcard)) {
+            for (std::string const &pattern : *fileType->filenamePatterns()) {
+                _fileNameFileTypes[pattern].push_back(index);
+            }
+        } else {
+            _otherFileTypes.push_back(index);
+        }
+    }
+}
+
 pbxspec::PBX::FileType::shared_ptr FileTypeResolver::
-Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, std::string const &filePath)
+resolve(Filesystem const *filesystem, std::string const &filePath, FileTypeCache *cache) const
 {
+    if (cache != nullptr) {
+        if (ext::optional<std::string> identifier = cache->find(filesystem, filePath)) {
+            if (pbxspec::PBX::FileType::shared_ptr const &fileType = _domainSet->find<pbxspec::PBX::FileType>(*identifier)) {
+                ResolveCacheHits.add();
+                return fileType;
+            }
+        }
+
+        pbxspec::PBX::FileType::shared_ptr fileType = resolve(filesystem, filePath);
+
+        /* Only kept if the identifier finds the same file type again. */
+        if (fileType != nullptr && _domainSet->find<pbxspec::PBX::FileType>(fileType->identifier()) == fileType) {
+            cache->insert(filesystem, filePath, fileType->identifier());
+        }
+
+        return fileType;
+    }
+
+    ResolveDetections.add();
+
     bool isReadable = filesystem->isReadable(filePath);
     bool isFolder = isReadable && filesystem->type(filePath) == Filesystem::Type::Directory;
 
@@ -48,39 +143,48 @@ Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specMa
     std::string fileName = FSUtil::GetBaseName(filePath);
 
     std::vector<uint8_t> fileContents;
+    bool fileContentsEnded = false;
 
-    /* Reverse first so more specific file types are processed first. */
-    std::vector<pbxspec::PBX::FileType::shared_ptr> const &fileTypes = specManager->fileTypes(domains);
-    ext::optional<std::vector<pbxspec::PBX::FileType::shared_ptr>> result = SortedFileTypes(fileTypes);
-    if (!result) {
-        fprintf(stderr, "error: cycle creating file type graph\n");
-        return nullptr;
+    /*
+     * Only the indexed file types that could match are checked. Check those in
+     * order, so more specific file types are checked first.
+     */
+    std::vector<size_t> candidates = _otherFileTypes;
+
+    auto it = _extensionFileTypes.find(Lowercase(fileExtension));
+    if (it != _extensionFileTypes.end()) {
+        candidates.insert(candidates.end(), it->second.begin(), it->second.end());
     }
 
-    std::vector<pbxspec::PBX::FileType::shared_ptr> const &sortedFileTypes = *result;
-    for (pbxspec::PBX::FileType::shared_ptr const &fileType : sortedFileTypes) {
-        if (isReadable && fileType->isFolder() != isFolder) {
-            continue;
+    for (auto const &entry : _prefixFileTypes) {
+        /* Indexed by length, so no longer prefixes can match either. */
+        if (entry.first > fileName.size()) {
+            break;
         }
 
-        bool empty = true;
+        auto it = entry.second.find(fileName.substr(0, entry.first));
+        if (it != entry.second.end()) {
+            candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+        }
+    }
 
-        if (fileType->extensions()) {
-            empty = false;
-            bool matched = false;
+    auto nit = _fileNameFileTypes.find(fileName);
+    if (nit != _fileNameFileTypes.end()) {
+        candidates.insert(candidates.end(), nit->second.begin(), nit->second.end());
+    }
 
-            for (std::string const &extension : *fileType->extensions()) {
-                // TODO(grp): Is this correct? Needed for handling ".S" as ".s", but might be over-broad.
-                if (strcasecmp(extension.c_str(), fileExtension.c_str()) == 0) {
-                    matched = true;
-                }
-            }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
 
-            if (!matched) {
-                continue;
-            }
+    for (size_t index : candidates) {
+        pbxspec::PBX::FileType::shared_ptr const &fileType = _fileTypes[index];
+
+        if (isReadable && fileType->isFolder() != isFolder) {
+            continue;
         }
 
+        /* Extension was matched by the index. */
+        bool empty = !fileType->extensions();
 
         if (fileType->prefix()) {
             empty = false;
@@ -101,9 +205,10 @@ Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specMa
             empty = false;
             bool matched = false;
 
-            for (std::string const &pattern : *fileType->filenamePatterns()) {
-                if (Wildcard::Match(pattern, fileName)) {
+            for (Wildcard::Pattern const &pattern : _filenamePatterns[index]) {
+                if (pattern.match(fileName)) {
                     matched = true;
+                    break;
                 }
             }
 
@@ -138,19 +243,22 @@ Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specMa
             empty = false;
             bool matched = false;
 
+            /* Contents are only read as far as needed, and shared between file types. */
             for (std::vector<uint8_t> const &magicWord : *fileType->magicWords()) {
-                if (fileContents.size() < magicWord.size()) {
+                if (fileContents.size() < magicWord.size() && !fileContentsEnded) {
                     std::vector<uint8_t> next;
-                    if (!filesystem->read(&next, fileName, fileContents.size(), magicWord.size() - fileContents.size())) {
+                    if (!filesystem->read(&next, filePath, fileContents.size(), magicWord.size() - fileContents.size())) {
+                        /* Too short to contain the magic word. */
+                        fileContentsEnded = true;
                         continue;
                     }
 
                     fileContents.insert(fileContents.end(), next.begin(), next.end());
                 }
 
-                assert(fileContents.size() == magicWord.size());
-                if (std::equal(magicWord.begin(), magicWord.end(), fileContents.begin())) {
+                if (fileContents.size() >= magicWord.size() && std::equal(magicWord.begin(), magicWord.end(), fileContents.begin())) {
                     matched = true;
+                    break;
                 }
             }
 
@@ -172,36 +280,60 @@ Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specMa
         return fileType;
     }
 
-    pbxspec::PBX::FileType::shared_ptr fileType = (isFolder ? specManager->fileType("folder", domains) : specManager->fileType("file", domains));
+    pbxspec::PBX::FileType::shared_ptr fileType = (isFolder ? _domainSet->find<pbxspec::PBX::FileType>("folder") : _domainSet->find<pbxspec::PBX::FileType>("file"));
     return fileType;
 }
 
 pbxspec::PBX::FileType::shared_ptr FileTypeResolver::
-Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxproj::PBX::FileReference::shared_ptr const &fileReference, std::string const &filePath)
+resolve(Filesystem const *filesystem, pbxproj::PBX::FileReference::shared_ptr const &fileReference, std::string const &filePath, FileTypeCache *cache) const
 {
+    ResolveCalls.add();
+
     if (!fileReference->explicitFileType().empty()) {
-        if (pbxspec::PBX::FileType::shared_ptr const &fileType = specManager->fileType(fileReference->explicitFileType(), domains)) {
+        if (pbxspec::PBX::FileType::shared_ptr const &fileType = _domainSet->find<pbxspec::PBX::FileType>(fileReference->explicitFileType())) {
             return fileType;
         }
     }
 
     if (!fileReference->lastKnownFileType().empty()) {
-        if (pbxspec::PBX::FileType::shared_ptr const &fileType = specManager->fileType(fileReference->lastKnownFileType(), domains)) {
+        if (pbxspec::PBX::FileType::shared_ptr const &fileType = _domainSet->find<pbxspec::PBX::FileType>(fileReference->lastKnownFileType())) {
             return fileType;
         }
     }
 
-    return Resolve(filesystem, specManager, domains, filePath);
+    return resolve(filesystem, filePath, cache);
 }
 
 pbxspec::PBX::FileType::shared_ptr FileTypeResolver::
-Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxproj::XC::VersionGroup::shared_ptr const &versionGroup, std::string const &filePath)
+resolve(Filesystem const *filesystem, pbxproj::XC::VersionGroup::shared_ptr const &versionGroup, std::string const &filePath, FileTypeCache *cache) const
 {
+    ResolveCalls.add();
+
     if (!versionGroup->versionGroupType().empty()) {
-        if (pbxspec::PBX::FileType::shared_ptr const &fileType = specManager->fileType(versionGroup->versionGroupType(), domains)) {
+        if (pbxspec::PBX::FileType::shared_ptr const &fileType = _domainSet->find<pbxspec::PBX::FileType>(versionGroup->versionGroupType())) {
             return fileType;
         }
     }
 
-    return Resolve(filesystem, specManager, domains, filePath);
+    return resolve(filesystem, filePath, cache);
+}
+
+ext::optional<FileTypeResolver> FileTypeResolver::
+Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains)
+{
+    pbxspec::DomainSet::shared_ptr domainSet = pbxspec::DomainSet::Create(*specManager, domains);
+
+    std::vector<pbxspec::PBX::FileType::shared_ptr> fileTypes;
+    for (pbxspec::PBX::Specification::shared_ptr const &specification : domainSet->specifications(pbxspec::PBX::FileType::Type())) {
+        fileTypes.push_back(std::static_pointer_cast<pbxspec::PBX::FileType>(specification));
+    }
+
+    /* Sort so more specific file types are processed first. */
+    ext::optional<std::vector<pbxspec::PBX::FileType::shared_ptr>> sortedFileTypes = SortedFileTypes(fileTypes);
+    if (!sortedFileTypes) {
+        fprintf(stderr, "error: cycle creating file type graph\n");
+        return ext::nullopt;
+    }
+
+    return FileTypeResolver(specManager, domainSet, *sortedFileTypes);
 }
@@ -154,7 +154,7 @@ add(std::string const &key, std::string const &prefix, std::string const &suffix
         return false; // invalid argument
     }
 
-    if (_keys.find(CanonicalizeKey(key)) != _keys.end()) {
+    if (!_keys.insert(CanonicalizeKey(key)).second) {
         // already exists
         return false;
     }
@@ -162,17 +162,17 @@ add(std::string const &key, std::string const &prefix, std::string const &suffix
     //
     // Lookup key offset, if none, add one.
     //
-    auto KI = add(key, true);
+    auto KI = add(key);
 
     //
     // Lookup prefix offset, if none, add one.
     //
-    auto PI = add(prefix, false);
+    auto PI = add(prefix);
 
     //
     // Lookup suffix offset, if none, add one.
     //
-    auto SI = add(suffix, false);
+    auto SI = add(suffix);
 
     //
     // Now let the table grow by one item, if needed.
@@ -193,6 +193,32 @@ add(std::string const &key, std::string const &prefix, std::string const &suffix
     return true;
 }
 
+void HeaderMap::
+add(std::vector<Entry> const &entries)
+{
+    reserve(_header.NumEntries + entries.size());
+
+    for (Entry const &entry : entries) {
+        add(entry.key, entry.prefix, entry.suffix);
+    }
+}
+
+void HeaderMap::
+reserve(size_t count)
+{
+    //
+    // Find the size that won't grow, matching grow().
+    //
+    uint32_t numBuckets = std::max<uint32_t>(_header.NumBuckets, 8);
+    while (count + 1 >= (numBuckets * 3) / 4) {
+        numBuckets <<= 1;
+    }
+
+    if (numBuckets != _header.NumBuckets) {
+        rehash(numBuckets);
+    }
+}
+
 void HeaderMap::
 grow()
 {
@@ -235,7 +261,7 @@ rehash(uint32_t newNumBuckets)
 }
 
 std::unordered_map<std::string, size_t>::iterator HeaderMap::
-add(std::string const &string, bool key)
+add(std::string const &string)
 {
     auto I = _offsets.find(string);
     if (I == _offsets.end()) {
@@ -252,13 +278,6 @@ add(std::string const &string, bool key)
         ::memcpy(&_strings[offset], &string[0], string.length() + 1);
 
         I = _offsets.insert(std::make_pair(string, offset)).first;
-
-        if (key) {
-            //
-            // store key
-            //
-            _keys.insert(CanonicalizeKey(string));
-        }
     }
     return I;
 }
@@ -0,0 +1,122 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/HeaderMapView.h>
+
+#include <cstring>
+#include <strings.h>
+
+using pbxbuild::HeaderMapView;
+using libutil::Filesystem;
+
+HeaderMapView::
+HeaderMapView(std::unique_ptr<Filesystem::Mapping const> mapping, HMapHeader const &header) :
+    _mapping(std::move(mapping)),
+    _header (header)
+{
+}
+
+char const *HeaderMapView::
+string(uint32_t offset) const
+{
+    /* Strings must end before the end of the file. */
+    size_t start = static_cast<size_t>(_header.StringsOffset) + offset;
+    if (offset == HMAP_EmptyBucketKey || start >= _mapping->size()) {
+        return nullptr;
+    }
+
+    char const *string = reinterpret_cast<char const *>(_mapping->data() + start);
+    if (::memchr(string, '\0', _mapping->size() - start) == nullptr) {
+        return nullptr;
+    }
+
+    return string;
+}
+
+bool HeaderMapView::
+bucket(uint32_t index, char const **key, char const **prefix, char const **suffix) const
+{
+    /* Buckets may not be aligned in the file. */
+    HMapBucket bucket;
+    ::memcpy(&bucket, _mapping->data() + sizeof(HMapHeader) + index * sizeof(HMapBucket), sizeof(HMapBucket));
+
+    *key = string(bucket.Key);
+    *prefix = string(bucket.Prefix);
+    *suffix = string(bucket.Suffix);
+    return bucket.Key != HMAP_EmptyBucketKey;
+}
+
+ext::optional<std::string> HeaderMapView::
+lookup(std::string const &key) const
+{
+    /* Probe linearly from the key's hash until an empty bucket. */
+    uint32_t mask = _header.NumBuckets - 1;
+    uint32_t start = HashHMapKey(key) & mask;
+    for (uint32_t n = 0; n < _header.NumBuckets; n++) {
+        char const *bucketKey;
+        char const *prefix;
+        char const *suffix;
+        if (!bucket((start + n) & mask, &bucketKey, &prefix, &suffix)) {
+            break;
+        }
+
+        if (bucketKey != nullptr && ::strcasecmp(bucketKey, key.c_str()) == 0) {
+            if (prefix == nullptr || suffix == nullptr) {
+                return ext::nullopt;
+            }
+
+            return std::string(prefix) + suffix;
+        }
+    }
+
+    return ext::nullopt;
+}
+
+void HeaderMapView::
+iterate(std::function<void(char const *key, char const *prefix, char const *suffix)> const &cb) const
+{
+    for (uint32_t n = 0; n < _header.NumBuckets; n++) {
+        char const *key;
+        char const *prefix;
+        char const *suffix;
+        if (bucket(n, &key, &prefix, &suffix) && key != nullptr && prefix != nullptr && suffix != nullptr) {
+            cb(key, prefix, suffix);
+        }
+    }
+}
+
+std::unique_ptr<HeaderMapView> HeaderMapView::
+Create(std::unique_ptr<Filesystem::Mapping const> mapping)
+{
+    if (mapping == nullptr || mapping->size() < sizeof(HMapHeader)) {
+        return nullptr;
+    }
+
+    HMapHeader header;
+    ::memcpy(&header, mapping->data(), sizeof(HMapHeader));
+
+    /* Lookups need a power of two buckets, all within the file. */
+    if (header.Magic != HMAP_HeaderMagicNumber ||
+        header.Version != HMAP_HeaderVersion ||
+        header.Reserved != 0 ||
+        header.NumBuckets == 0 ||
+        (header.NumBuckets & (header.NumBuckets - 1)) != 0 ||
+        (mapping->size() - sizeof(HMapHeader)) / sizeof(HMapBucket) < header.NumBuckets ||
+        header.StringsOffset > mapping->size()) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<HeaderMapView>(new HeaderMapView(std::move(mapping), header));
+}
+
+std::unique_ptr<HeaderMapView> HeaderMapView::
+Load(Filesystem const *filesystem, std::string const &path)
+{
+    return Create(filesystem->map(path));
+}
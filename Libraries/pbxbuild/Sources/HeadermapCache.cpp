@@ -0,0 +1,39 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/HeadermapCache.h>
+
+using pbxbuild::HeadermapCache;
+
+HeadermapCache::
+HeadermapCache()
+{
+}
+
+std::shared_ptr<HeadermapCache::ProjectHeaders const> HeadermapCache::
+project(std::string const &key, std::function<std::shared_ptr<ProjectHeaders const>()> const &create)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _projects.find(key);
+        if (it != _projects.end()) {
+            return it->second;
+        }
+    }
+
+    /*
+     * Find the headers outside the lock; if another thread finds the same
+     * project's headers at the same time, the first result stored is used.
+     */
+    std::shared_ptr<ProjectHeaders const> headers = create();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _projects.insert({ key, headers }).first->second;
+}
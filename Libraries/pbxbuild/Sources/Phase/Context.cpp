@@ -25,13 +25,17 @@
 #include <pbxbuild/Target/Environment.h>
 #include <pbxbuild/Target/BuildRules.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
 namespace Target = pbxbuild::Target;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 Phase::Context::
 Context(Tool::Context const &toolContext) :
@@ -332,6 +336,97 @@ Group(std::vector<Tool::Input> const &files)
     return result;
 }
 
+static std::string
+BuildFileToolIdentifier(Tool::Input const &first, std::string const &fallbackToolIdentifier)
+{
+    std::string toolIdentifier = fallbackToolIdentifier;
+
+    if (Target::BuildRules::BuildRule::shared_ptr const &buildRule = first.buildRule()) {
+        if (pbxspec::PBX::Tool::shared_ptr const &tool = buildRule->tool()) {
+            /*
+             * Some tools additionally limit their file types beyond what their build rule allows.
+             * For example, the default compiler limits itself to just source files, despite its
+             * default build rule specifying that it accepts all C-family inputs, including headers.
+             */
+            // TODO(grp): Is this the right way to make .h files not get compiled as resources?
+            if (tool->fileTypes() || tool->inputFileTypes()) {
+                if (first.fileType() != nullptr) {
+                    std::vector<std::string> toolFileTypes;
+                    if (tool->fileTypes()) {
+                        toolFileTypes.insert(toolFileTypes.end(), tool->fileTypes()->begin(), tool->fileTypes()->end());
+                    }
+                    if (tool->inputFileTypes()) {
+                        toolFileTypes.insert(toolFileTypes.end(), tool->inputFileTypes()->begin(), tool->inputFileTypes()->end());
+                    }
+
+                    std::string inputFileType = first.fileType()->identifier();
+                    bool toolAcceptsInputFileType = (toolFileTypes.empty() || std::find(toolFileTypes.begin(), toolFileTypes.end(), inputFileType) != toolFileTypes.end());
+
+                    if (toolAcceptsInputFileType) {
+                        toolIdentifier = tool->identifier();
+                    }
+                }
+            } else {
+                toolIdentifier = tool->identifier();
+            }
+        }
+    }
+
+    return toolIdentifier;
+}
+
+static std::string
+BuildFileOutputDirectory(Tool::Input const &first, std::string const &outputDirectory)
+{
+    std::string fileOutputDirectory = outputDirectory;
+    if (first.localization()) {
+        fileOutputDirectory += "/" + *first.localization() + ".lproj";
+    }
+    return fileOutputDirectory;
+}
+
+std::vector<std::vector<ext::optional<Tool::ClangResolver::PreparedSource>>> Phase::Context::
+prepareSources(
+    Phase::Environment const &phaseEnvironment,
+    std::vector<std::pair<pbxsetting::Environment const *, std::string const *>> const &passes,
+    std::vector<std::vector<Tool::Input>> const &groups,
+    std::string const &fallbackToolIdentifier)
+{
+    std::vector<std::vector<ext::optional<Tool::ClangResolver::PreparedSource>>> preparedSources;
+    for (size_t n = 0; n < passes.size(); ++n) {
+        preparedSources.push_back(std::vector<ext::optional<Tool::ClangResolver::PreparedSource>>(groups.size()));
+    }
+
+    /*
+     * Compiling sources is most of the work here, and each source can be
+     * prepared on its own, so prepare them in parallel. They are still added
+     * to the tool context in order, so the invocations don't change.
+     */
+    std::vector<size_t> sourceGroups;
+    for (size_t n = 0; n < groups.size(); ++n) {
+        Tool::Input const &first = groups[n].front();
+        if (first.buildRule() != nullptr && first.buildRule()->script().empty() && BuildFileToolIdentifier(first, fallbackToolIdentifier) == Tool::ClangResolver::ToolIdentifier()) {
+            sourceGroups.push_back(n);
+        }
+    }
+
+    size_t count = passes.size() * sourceGroups.size();
+    if (count > 1) {
+        if (Tool::ClangResolver const *clangResolver = this->clangResolver(phaseEnvironment)) {
+            /* Sources for every pass are prepared together, not one pass at a time. */
+            Parallel::For(Parallel::DefaultJobs(), count, [&](size_t n) {
+                size_t pass = n / sourceGroups.size();
+                size_t group = sourceGroups[n % sourceGroups.size()];
+
+                Tool::Input const &first = groups[group].front();
+                preparedSources[pass][group] = clangResolver->prepareSource(&_toolContext, *passes[pass].first, first, BuildFileOutputDirectory(first, *passes[pass].second));
+            });
+        }
+    }
+
+    return preparedSources;
+}
+
 bool Phase::Context::
 resolveBuildFiles(
     Phase::Environment const &phaseEnvironment,
@@ -341,14 +436,55 @@ resolveBuildFiles(
     std::string const &outputDirectory,
     std::string const &fallbackToolIdentifier)
 {
-    for (std::vector<Tool::Input> const &files : groups) {
+    std::vector<std::vector<ext::optional<Tool::ClangResolver::PreparedSource>>> preparedSources = prepareSources(phaseEnvironment, { { &environment, &outputDirectory } }, groups, fallbackToolIdentifier);
+    return resolveBuildFiles(phaseEnvironment, environment, buildPhase, groups, outputDirectory, fallbackToolIdentifier, preparedSources.front());
+}
+
+bool Phase::Context::
+resolveBuildFiles(
+    Phase::Environment const &phaseEnvironment,
+    std::vector<std::pair<pbxsetting::Environment, std::string>> const &passes,
+    pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase,
+    std::vector<std::vector<Tool::Input>> const &groups,
+    std::string const &fallbackToolIdentifier)
+{
+    std::vector<std::pair<pbxsetting::Environment const *, std::string const *>> passPointers;
+    for (std::pair<pbxsetting::Environment, std::string> const &pass : passes) {
+        passPointers.push_back({ &pass.first, &pass.second });
+    }
+
+    std::vector<std::vector<ext::optional<Tool::ClangResolver::PreparedSource>>> preparedSources = prepareSources(phaseEnvironment, passPointers, groups, fallbackToolIdentifier);
+    for (size_t n = 0; n < passes.size(); ++n) {
+        if (!resolveBuildFiles(phaseEnvironment, passes[n].first, buildPhase, groups, passes[n].second, fallbackToolIdentifier, preparedSources[n])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Phase::Context::
+resolveBuildFiles(
+    Phase::Environment const &phaseEnvironment,
+    pbxsetting::Environment const &environment,
+    pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase,
+    std::vector<std::vector<Tool::Input>> const &groups,
+    std::string const &outputDirectory,
+    std::string const &fallbackToolIdentifier,
+    std::vector<ext::optional<Tool::ClangResolver::PreparedSource>> const &preparedSources)
+{
+    /*
+     * Files copied to the same directory are copied together, by a single invocation.
+     */
+    std::vector<std::pair<std::string, std::vector<Tool::Input>>> copies;
+    std::string copyLogMessageTitle;
+
+    for (size_t n = 0; n < groups.size(); ++n) {
+        std::vector<Tool::Input> const &files = groups[n];
         assert(!files.empty());
         Tool::Input const &first = files.front();
 
-        std::string fileOutputDirectory = outputDirectory;
-        if (first.localization()) {
-            fileOutputDirectory += "/" + *first.localization() + ".lproj";
-        }
+        std::string fileOutputDirectory = BuildFileOutputDirectory(first, outputDirectory);
 
         Target::BuildRules::BuildRule::shared_ptr const &buildRule = first.buildRule();
         if (buildRule == nullptr && fallbackToolIdentifier.empty()) {
@@ -365,38 +501,7 @@ resolveBuildFiles(
                 return false;
             }
         } else {
-            std::string toolIdentifier = fallbackToolIdentifier;
-
-            if (buildRule != nullptr) {
-                if (pbxspec::PBX::Tool::shared_ptr const &tool = buildRule->tool()) {
-                    /*
-                     * Some tools additionally limit their file types beyond what their build rule allows.
-                     * For example, the default compiler limits itself to just source files, despite its
-                     * default build rule specifying that it accepts all C-family inputs, including headers.
-                     */
-                    // TODO(grp): Is this the right way to make .h files not get compiled as resources?
-                    if (tool->fileTypes() || tool->inputFileTypes()) {
-                        if (first.fileType() != nullptr) {
-                            std::vector<std::string> toolFileTypes;
-                            if (tool->fileTypes()) {
-                                toolFileTypes.insert(toolFileTypes.end(), tool->fileTypes()->begin(), tool->fileTypes()->end());
-                            }
-                            if (tool->inputFileTypes()) {
-                                toolFileTypes.insert(toolFileTypes.end(), tool->inputFileTypes()->begin(), tool->inputFileTypes()->end());
-                            }
-
-                            std::string inputFileType = first.fileType()->identifier();
-                            bool toolAcceptsInputFileType = (toolFileTypes.empty() || std::find(toolFileTypes.begin(), toolFileTypes.end(), inputFileType) != toolFileTypes.end());
-
-                            if (toolAcceptsInputFileType) {
-                                toolIdentifier = tool->identifier();
-                            }
-                        }
-                    } else {
-                        toolIdentifier = tool->identifier();
-                    }
-                }
-            }
+            std::string toolIdentifier = BuildFileToolIdentifier(first, fallbackToolIdentifier);
 
             if (toolIdentifier.empty()) {
                 fprintf(stderr, "warning: no tool available for build rule\n");
@@ -412,7 +517,11 @@ resolveBuildFiles(
             } else if (toolIdentifier == Tool::ClangResolver::ToolIdentifier()) {
                 if (Tool::ClangResolver const *clangResolver = this->clangResolver(phaseEnvironment)) {
                     assert(files.size() == 1); // TODO(grp): Is this a valid assertion?
-                    clangResolver->resolveSource(&_toolContext, environment, first, fileOutputDirectory);
+                    if (preparedSources[n]) {
+                        clangResolver->addSource(&_toolContext, environment, *preparedSources[n]);
+                    } else {
+                        clangResolver->resolveSource(&_toolContext, environment, first, fileOutputDirectory);
+                    }
                 } else {
                     return false;
                 }
@@ -427,10 +536,15 @@ resolveBuildFiles(
                         logMessageTitle = "PBXCp";
                 }
 
-                if (Tool::CopyResolver const *copyResolver = this->copyResolver(phaseEnvironment)) {
-                    copyResolver->resolve(&_toolContext, environment, files, fileOutputDirectory, logMessageTitle);
+                copyLogMessageTitle = logMessageTitle;
+
+                auto it = std::find_if(copies.begin(), copies.end(), [&](std::pair<std::string, std::vector<Tool::Input>> const &copy) {
+                    return copy.first == fileOutputDirectory;
+                });
+                if (it == copies.end()) {
+                    copies.push_back({ fileOutputDirectory, files });
                 } else {
-                    return false;
+                    it->second.insert(it->second.end(), files.begin(), files.end());
                 }
             } else if (toolIdentifier == Tool::InterfaceBuilderResolver::CompilerToolIdentifier()) {
                 if (Tool::InterfaceBuilderResolver const *interfaceBuilderCompilerResolver = this->interfaceBuilderCompilerResolver(phaseEnvironment)) {
@@ -460,6 +574,16 @@ resolveBuildFiles(
         }
     }
 
+    if (!copies.empty()) {
+        if (Tool::CopyResolver const *copyResolver = this->copyResolver(phaseEnvironment)) {
+            for (std::pair<std::string, std::vector<Tool::Input>> const &copy : copies) {
+                copyResolver->resolve(&_toolContext, environment, copy.second, copy.first, copyLogMessageTitle);
+            }
+        } else {
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -15,11 +15,9 @@
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
 #include <pbxsetting/Value.h>
-#include <libutil/Filesystem.h>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
-using libutil::Filesystem;
 
 Phase::CopyFilesResolver::
 CopyFilesResolver(pbxproj::PBX::CopyFilesBuildPhase::shared_ptr const &buildPhase) :
@@ -85,17 +83,15 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
     std::string path = environment.expand(_buildPhase->dstPath());
     std::string outputDirectory = root + "/" + path;
 
-    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, environment, _buildPhase->files());
+    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(phaseEnvironment.buildContext().filesystem(), phaseEnvironment, environment, _buildPhase->files());
     std::vector<std::vector<Tool::Input>> groups = Phase::Context::Group(files);
 
     if (pbxsetting::Type::ParseBoolean(environment.resolve("APPLY_RULES_IN_COPY_FILES"))) {
         if (!phaseContext->resolveBuildFiles(phaseEnvironment, environment, _buildPhase, groups, outputDirectory, Tool::CopyResolver::ToolIdentifier())) {
             return false;
         }
-    } else {
-        for (Tool::Input const &file : files) {
-            copyResolver->resolve(&phaseContext->toolContext(), environment, { file }, outputDirectory, "PBXCp");
-        }
+    } else if (!files.empty()) {
+        copyResolver->resolve(&phaseContext->toolContext(), environment, files, outputDirectory, "PBXCp");
     }
 
     return true;
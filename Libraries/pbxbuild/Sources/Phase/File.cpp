@@ -19,7 +19,6 @@ namespace Phase = pbxbuild::Phase;
 namespace Target = pbxbuild::Target;
 namespace Tool = pbxbuild::Tool;
 namespace Build = pbxbuild::Build;
-using pbxbuild::FileTypeResolver;
 using libutil::Filesystem;
 
 std::vector<Tool::Input> Phase::File::
@@ -49,7 +48,7 @@ ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseE
                 pbxproj::PBX::FileReference::shared_ptr const &fileReference = std::static_pointer_cast <pbxproj::PBX::FileReference> (buildFile->fileRef());
 
                 std::string path = environment.expand(fileReference->resolve());
-                pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, fileReference, path);
+                pbxspec::PBX::FileType::shared_ptr fileType = buildEnvironment.fileTypeResolver()->resolve(filesystem, fileReference, path, buildContext.fileTypeCache());
 
                 Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                 Tool::Input file = Tool::Input(path, fileType, buildRule, fileNameDisambiguator, ext::nullopt, ext::nullopt, buildFile->attributes(), buildFile->compilerFlags());
@@ -77,7 +76,7 @@ ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseE
 
                 pbxproj::PBX::FileReference::shared_ptr const &fileReference = remote->second;
                 std::string path = remoteEnvironment->environment().expand(fileReference->resolve());
-                pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, fileReference, path);
+                pbxspec::PBX::FileType::shared_ptr fileType = buildEnvironment.fileTypeResolver()->resolve(filesystem, fileReference, path, buildContext.fileTypeCache());
 
                 Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                 Tool::Input file = Tool::Input(path, fileType, buildRule, ext::nullopt, ext::nullopt, ext::nullopt, buildFile->attributes(), buildFile->compilerFlags());
@@ -95,7 +94,7 @@ ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseE
                     std::string const &localization = fileReference->name();
 
                     std::string path = environment.expand(fileReference->resolve());
-                    pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, fileReference, path);
+                    pbxspec::PBX::FileType::shared_ptr fileType = buildEnvironment.fileTypeResolver()->resolve(filesystem, fileReference, path, buildContext.fileTypeCache());
 
                     Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                     Tool::Input file = Tool::Input(path, fileType, buildRule, fileNameDisambiguator, localization, buildFile->blueprintIdentifier(), buildFile->attributes(), buildFile->compilerFlags());
@@ -107,7 +106,7 @@ ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseE
                 pbxproj::XC::VersionGroup::shared_ptr const &versionGroup = std::static_pointer_cast <pbxproj::XC::VersionGroup> (buildFile->fileRef());
 
                 std::string path = environment.expand(versionGroup->resolve());
-                pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, versionGroup, path);
+                pbxspec::PBX::FileType::shared_ptr fileType = buildEnvironment.fileTypeResolver()->resolve(filesystem, versionGroup, path, buildContext.fileTypeCache());
 
                 Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                 Tool::Input file = Tool::Input(path, fileType, buildRule, fileNameDisambiguator, ext::nullopt, ext::nullopt, buildFile->attributes(), buildFile->compilerFlags());
@@ -17,14 +17,12 @@
 #include <pbxbuild/Tool/ToolResolver.h>
 #include <pbxbuild/Tool/LinkerResolver.h>
 #include <pbxbuild/Tool/CompilationInfo.h>
-#include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
 namespace Phase = pbxbuild::Phase;
 namespace Build = pbxbuild::Build;
 namespace Target = pbxbuild::Target;
 namespace Tool = pbxbuild::Tool;
-using libutil::Filesystem;
 using libutil::FSUtil;
 
 Phase::FrameworksResolver::
@@ -72,7 +70,7 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
     std::string workingDirectory = targetEnvironment.workingDirectory();
     std::string productsDirectory = targetEnvironment.environment().resolve("BUILT_PRODUCTS_DIR");
 
-    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, targetEnvironment.environment(), _buildPhase->files());
+    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(phaseEnvironment.buildContext().filesystem(), phaseEnvironment, targetEnvironment.environment(), _buildPhase->files());
 
     for (std::string const &variant : targetEnvironment.variants()) {
         pbxsetting::Environment variantEnvironment = pbxsetting::Environment(targetEnvironment.environment());
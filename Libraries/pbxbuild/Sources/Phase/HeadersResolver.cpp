@@ -12,11 +12,9 @@
 #include <pbxbuild/Phase/Context.h>
 #include <pbxbuild/Phase/File.h>
 #include <pbxbuild/Tool/CopyResolver.h>
-#include <libutil/Filesystem.h>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
-using libutil::Filesystem;
 
 Phase::HeadersResolver::
 HeadersResolver(pbxproj::PBX::HeadersBuildPhase::shared_ptr const &buildPhase) :
@@ -44,19 +42,32 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
     std::string publicOutputDirectory = targetBuildDirectory + "/" + environment.resolve("PUBLIC_HEADERS_FOLDER_PATH");
     std::string privateOutputDirectory = targetBuildDirectory + "/" + environment.resolve("PRIVATE_HEADERS_FOLDER_PATH");
 
-    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, environment, _buildPhase->files());
+    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(phaseEnvironment.buildContext().filesystem(), phaseEnvironment, environment, _buildPhase->files());
+
+    std::vector<Tool::Input> publicFiles;
+    std::vector<Tool::Input> privateFiles;
 
     for (Tool::Input const &file : files) {
         std::vector<std::string> const &attributes = file.attributes().value_or(std::vector<std::string>());
         bool isPublic  = std::find(attributes.begin(), attributes.end(), "Public") != attributes.end();
         bool isPrivate = std::find(attributes.begin(), attributes.end(), "Private") != attributes.end();
 
-        std::string const &outputDirectory = (isPublic ? publicOutputDirectory : privateOutputDirectory);
-
-        if (isPublic || isPrivate) {
-            copyResolver->resolve(&phaseContext->toolContext(), environment, { file }, outputDirectory, "CpHeader");
+        if (isPublic) {
+            publicFiles.push_back(file);
+        } else if (isPrivate) {
+            privateFiles.push_back(file);
         }
     }
 
+    /*
+     * Copy the headers for each visibility together.
+     */
+    if (!publicFiles.empty()) {
+        copyResolver->resolve(&phaseContext->toolContext(), environment, publicFiles, publicOutputDirectory, "CpHeader");
+    }
+    if (!privateFiles.empty()) {
+        copyResolver->resolve(&phaseContext->toolContext(), environment, privateFiles, privateOutputDirectory, "CpHeader");
+    }
+
     return true;
 }
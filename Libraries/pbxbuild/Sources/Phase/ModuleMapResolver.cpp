@@ -10,12 +10,19 @@
 #include <pbxbuild/Phase/ModuleMapResolver.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/Context.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Build/Environment.h>
+#include <pbxbuild/Tool/ClangResolver.h>
 #include <pbxbuild/Tool/CopyResolver.h>
+#include <pbxbuild/Tool/ExplicitModuleInfo.h>
 #include <pbxbuild/Tool/ModuleMapResolver.h>
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
 using libutil::FSUtil;
@@ -46,6 +53,79 @@ ProcessModuleMap(
     copyResolver->resolve(toolContext, environment, { input }, FSUtil::GetDirectoryName(entry.finalPath()), "Ditto");
 }
 
+static bool
+ExplicitModules(pbxsetting::Environment const &environment)
+{
+    return pbxsetting::Type::ParseBoolean(environment.resolve("CLANG_ENABLE_MODULES")) &&
+        pbxsetting::Type::ParseBoolean(environment.resolve("CLANG_ENABLE_EXPLICIT_MODULES"));
+}
+
+static bool
+BuildsExplicitModule(pbxbuild::Target::Environment const &targetEnvironment, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+    if (!ExplicitModules(environment) || !pbxsetting::Type::ParseBoolean(environment.resolve("DEFINES_MODULE"))) {
+        return false;
+    }
+
+    /* Module maps are only resolved for targets with sources. */
+    auto it = std::find_if(target->buildPhases().begin(), target->buildPhases().end(), [](pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase) -> bool {
+        return (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::Sources);
+    });
+    if (it == target->buildPhases().end()) {
+        return false;
+    }
+
+    return Tool::ModuleMapResolver::HasModuleMap(environment, target, targetEnvironment.workingDirectory());
+}
+
+static std::map<std::pair<std::string, std::string>, std::string>
+ExplicitModulePaths(pbxbuild::Target::Environment const &targetEnvironment)
+{
+    std::map<std::pair<std::string, std::string>, std::string> modulePaths;
+    for (std::string const &variant : targetEnvironment.variants()) {
+        for (std::string const &arch : targetEnvironment.architectures()) {
+            pbxsetting::Environment currentEnvironment = pbxsetting::Environment(targetEnvironment.environment());
+            currentEnvironment.insertFront(Phase::Environment::VariantLevel(variant), false);
+            currentEnvironment.insertFront(Phase::Environment::ArchitectureLevel(arch), false);
+
+            modulePaths.insert({ { variant, arch }, Tool::ExplicitModuleInfo::ModulePath(currentEnvironment) });
+        }
+    }
+    return modulePaths;
+}
+
+/*
+ * Find the modules built by the targets a target depends on, directly or
+ * through other targets. Dependencies come first, as modules they import
+ * are needed to load them.
+ */
+static void
+AddExplicitModules(
+    Phase::Environment const &phaseEnvironment,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> *visited,
+    std::vector<Tool::ExplicitModuleInfo> *explicitModuleInfo)
+{
+    for (pbxproj::PBX::TargetDependency::shared_ptr const &dependency : target->dependencies()) {
+        /* Only targets in the same project; others build their modules implicitly. */
+        pbxproj::PBX::Target::shared_ptr const &dependencyTarget = dependency->target();
+        if (dependencyTarget == nullptr || !visited->insert(dependencyTarget).second) {
+            continue;
+        }
+
+        AddExplicitModules(phaseEnvironment, dependencyTarget, visited, explicitModuleInfo);
+
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment = phaseEnvironment.buildContext().targetEnvironment(phaseEnvironment.buildEnvironment(), dependencyTarget);
+        if (!targetEnvironment || !BuildsExplicitModule(*targetEnvironment, dependencyTarget)) {
+            continue;
+        }
+
+        std::string moduleName = targetEnvironment->environment().resolve("PRODUCT_MODULE_NAME");
+        explicitModuleInfo->push_back(Tool::ExplicitModuleInfo(moduleName, ExplicitModulePaths(*targetEnvironment)));
+    }
+}
+
 bool Phase::ModuleMapResolver::
 resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext) const
 {
@@ -68,6 +148,14 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
      */
     moduleMapResolver->resolve(&phaseContext->toolContext(), environment, phaseEnvironment.target());
 
+    /*
+     * Compiles load the modules of the targets depended on, rather than building them again.
+     */
+    if (ExplicitModules(environment)) {
+        std::unordered_set<pbxproj::PBX::Target::shared_ptr> visited;
+        AddExplicitModules(phaseEnvironment, phaseEnvironment.target(), &visited, &phaseContext->toolContext().explicitModuleInfo());
+    }
+
     /*
      * Check if creating module maps is even requested.
      */
@@ -91,3 +179,68 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
     return true;
 }
 
+bool Phase::ModuleMapResolver::
+resolveExplicitModule(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext) const
+{
+    pbxbuild::Target::Environment const &targetEnvironment = phaseEnvironment.targetEnvironment();
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+
+    if (!BuildsExplicitModule(targetEnvironment, phaseEnvironment.target())) {
+        return true;
+    }
+
+    ext::optional<Tool::ModuleMapInfo::Entry> const &entry = phaseContext->toolContext().moduleMapInfo().moduleMap();
+    if (!entry) {
+        return true;
+    }
+
+    Tool::ClangResolver const *clangResolver = phaseContext->clangResolver(phaseEnvironment);
+    if (clangResolver == nullptr) {
+        return false;
+    }
+
+    /*
+     * Built from the module map in the product, so the headers it names are
+     * found there. Depends on everything copied into the product's headers
+     * and modules, but not the rest of the product.
+     */
+    std::string targetBuildDirectory = environment.resolve("TARGET_BUILD_DIR");
+    std::vector<std::string> directories = {
+        targetBuildDirectory + "/" + environment.resolve("PUBLIC_HEADERS_FOLDER_PATH") + "/",
+        targetBuildDirectory + "/" + environment.resolve("PRIVATE_HEADERS_FOLDER_PATH") + "/",
+        FSUtil::GetDirectoryName(entry->finalPath()) + "/",
+    };
+
+    std::vector<std::string> inputDependencies;
+    for (Tool::Invocation const &invocation : phaseContext->toolContext().invocations()) {
+        for (std::string const &output : invocation.outputs()) {
+            if (output == entry->finalPath()) {
+                continue;
+            }
+
+            for (std::string const &directory : directories) {
+                if (output.compare(0, directory.size(), directory) == 0) {
+                    inputDependencies.push_back(output);
+                    break;
+                }
+            }
+        }
+    }
+
+    pbxspec::PBX::FileType::shared_ptr fileType = phaseEnvironment.buildEnvironment().specManager()->fileType("sourcecode.c.objc", targetEnvironment.specDomains());
+    Tool::Input input = Tool::Input(entry->finalPath(), fileType);
+    std::string moduleName = environment.resolve("PRODUCT_MODULE_NAME");
+
+    for (std::string const &variant : targetEnvironment.variants()) {
+        for (std::string const &arch : targetEnvironment.architectures()) {
+            pbxsetting::Environment currentEnvironment = pbxsetting::Environment(environment);
+            currentEnvironment.insertFront(Phase::Environment::VariantLevel(variant), false);
+            currentEnvironment.insertFront(Phase::Environment::ArchitectureLevel(arch), false);
+
+            std::string output = Tool::ExplicitModuleInfo::ModulePath(currentEnvironment);
+            clangResolver->resolveModule(&phaseContext->toolContext(), currentEnvironment, moduleName, input, output, inputDependencies);
+        }
+    }
+
+    return true;
+}
@@ -23,15 +23,18 @@
 #include <pbxbuild/Tool/Context.h>
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
+#include <libutil/Trace.h>
+
+#include <algorithm>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
 namespace Target = pbxbuild::Target;
 
 Phase::PhaseInvocations::
-PhaseInvocations(std::vector<Tool::Invocation> const &invocations, std::vector<Tool::AuxiliaryFile> const &auxiliaryFiles) :
-    _invocations   (invocations),
-    _auxiliaryFiles(auxiliaryFiles)
+PhaseInvocations(std::vector<Tool::Invocation> &&invocations, std::vector<Tool::AuxiliaryFile> &&auxiliaryFiles) :
+    _invocations   (std::move(invocations)),
+    _auxiliaryFiles(std::move(auxiliaryFiles))
 {
 }
 
@@ -40,17 +43,43 @@ Phase::PhaseInvocations::
 {
 }
 
+static void
+ShareEnvironments(std::vector<Tool::Invocation> *invocations)
+{
+    /*
+     * Most tools in a target get the same environment, so there are only a
+     * few distinct ones to compare against.
+     */
+    std::vector<Tool::Invocation const *> distinct;
+    for (Tool::Invocation &invocation : *invocations) {
+        auto it = std::find_if(distinct.begin(), distinct.end(), [&invocation](Tool::Invocation const *other) {
+            return other->environment() == invocation.environment();
+        });
+
+        if (it != distinct.end()) {
+            invocation.shareEnvironment(**it);
+        } else {
+            distinct.push_back(&invocation);
+        }
+    }
+}
+
 Phase::PhaseInvocations Phase::PhaseInvocations::
 Create(Phase::Environment const &phaseEnvironment, pbxproj::PBX::Target::shared_ptr const &target)
 {
+    libutil::Trace::Span span("Resolve Phases", target->name());
+
     Target::Environment const &targetEnvironment = phaseEnvironment.targetEnvironment();
     pbxsetting::Environment const &environment = targetEnvironment.environment();
 
     /* Create the tool context for building. */
     Tool::SearchPaths searchPaths = Tool::SearchPaths::Create(
+        phaseEnvironment.buildContext().filesystem(),
         targetEnvironment.environment(),
-        targetEnvironment.workingDirectory());
+        targetEnvironment.workingDirectory(),
+        phaseEnvironment.buildContext().directoryCache());
     Tool::Context toolContext = Tool::Context(
+        phaseEnvironment.buildContext().filesystem(),
         targetEnvironment.sdk(),
         targetEnvironment.toolchains(),
         targetEnvironment.workingDirectory(),
@@ -165,6 +194,14 @@ Create(Phase::Environment const &phaseEnvironment, pbxproj::PBX::Target::shared_
         }
     }
 
+    /*
+     * Build the target's module for other targets, once its headers are in the product.
+     */
+    Phase::ModuleMapResolver moduleMap = Phase::ModuleMapResolver();
+    if (!moduleMap.resolveExplicitModule(phaseEnvironment, &phaseContext)) {
+        fprintf(stderr, "error: unable to resolve explicit module\n");
+    }
+
     /*
      * Add target-level invocations. Note these must come last as they use the context values set
      * by tools added above for the various build phases. For example, the final 'touch' must depend
@@ -209,6 +246,7 @@ Create(Phase::Environment const &phaseEnvironment, pbxproj::PBX::Target::shared_
             break;
     }
 
-    return Phase::PhaseInvocations(phaseContext.toolContext().invocations(), phaseContext.toolContext().auxiliaryFiles());
+    ShareEnvironments(&phaseContext.toolContext().invocations());
+    return Phase::PhaseInvocations(std::move(phaseContext.toolContext().invocations()), std::move(phaseContext.toolContext().auxiliaryFiles()));
 }
 
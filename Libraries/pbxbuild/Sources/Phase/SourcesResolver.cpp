@@ -14,6 +14,7 @@
 #include <pbxbuild/Target/Environment.h>
 #include <pbxbuild/Build/Environment.h>
 #include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Tool/AuxiliaryFile.h>
 #include <pbxbuild/Tool/ClangResolver.h>
 #include <pbxbuild/Tool/HeadermapResolver.h>
 #include <pbxbuild/Tool/DittoResolver.h>
@@ -21,13 +22,14 @@
 #include <pbxbuild/Tool/HeadermapInfo.h>
 #include <pbxbuild/Tool/PrecompiledHeaderInfo.h>
 #include <pbxbuild/Tool/SearchPaths.h>
-#include <libutil/Filesystem.h>
+#include <pbxsetting/Type.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+
 namespace Phase = pbxbuild::Phase;
 namespace Target = pbxbuild::Target;
 namespace Tool = pbxbuild::Tool;
-using libutil::Filesystem;
 using libutil::FSUtil;
 
 Phase::SourcesResolver::
@@ -98,6 +100,62 @@ CopySwiftModules(Phase::Environment const &phaseEnvironment, Phase::Context *pha
     return true;
 }
 
+std::vector<Tool::Input> Phase::SourcesResolver::
+UnitySources(Tool::Context *toolContext, pbxsetting::Environment const &environment, std::vector<Tool::Input> const &files, size_t size)
+{
+    std::vector<Tool::Input> result;
+    std::vector<std::vector<Tool::Input>> unityGroups;
+
+    for (Tool::Input const &file : files) {
+        bool combine = false;
+        if (file.fileType() != nullptr && !file.localization() && (!file.compilerFlags() || file.compilerFlags()->empty())) {
+            if (file.buildRule() != nullptr && file.buildRule()->script().empty() && file.buildRule()->tool() != nullptr && file.buildRule()->tool()->identifier() == Tool::ClangResolver::ToolIdentifier()) {
+                std::string const &fileType = file.fileType()->identifier();
+                combine = (fileType == "sourcecode.c.c" || fileType == "sourcecode.c.objc" || fileType == "sourcecode.cpp.cpp" || fileType == "sourcecode.cpp.objcpp");
+            }
+        }
+
+        if (!combine) {
+            result.push_back(file);
+            continue;
+        }
+
+        /* Fill the last unfilled group of the same type. */
+        auto it = std::find_if(unityGroups.rbegin(), unityGroups.rend(), [&](std::vector<Tool::Input> const &group) {
+            return group.front().fileType() == file.fileType() && group.front().buildRule() == file.buildRule();
+        });
+        if (it == unityGroups.rend() || it->size() >= size) {
+            unityGroups.push_back({ file });
+        } else {
+            it->push_back(file);
+        }
+    }
+
+    std::string directory = environment.resolve("DERIVED_FILE_DIR") + "/Unity";
+    for (size_t n = 0; n < unityGroups.size(); ++n) {
+        std::vector<Tool::Input> const &group = unityGroups[n];
+        Tool::Input const &first = group.front();
+
+        /* A source on its own is compiled as it is. */
+        if (group.size() == 1) {
+            result.push_back(first);
+            continue;
+        }
+
+        std::string contents;
+        for (Tool::Input const &file : group) {
+            contents += "#include \"" + file.path() + "\"\n";
+        }
+
+        std::string path = directory + "/Unity-" + std::to_string(n) + "." + FSUtil::GetFileExtension(first.path());
+        toolContext->auxiliaryFiles().push_back(Tool::AuxiliaryFile::Data(path, std::vector<uint8_t>(contents.begin(), contents.end())));
+
+        result.push_back(Tool::Input(path, first.fileType(), first.buildRule(), ext::nullopt, ext::nullopt, ext::nullopt, ext::nullopt, ext::nullopt));
+    }
+
+    return result;
+}
+
 bool Phase::SourcesResolver::
 resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext)
 {
@@ -109,13 +167,13 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
         return false;
     }
 
-    std::unique_ptr<Tool::HeadermapResolver> headermapResolver = Tool::HeadermapResolver::Create(buildEnvironment.specManager(), targetEnvironment.specDomains(), clangResolver->compiler());
+    std::unique_ptr<Tool::HeadermapResolver> headermapResolver = Tool::HeadermapResolver::Create(buildEnvironment.specManager(), targetEnvironment.specDomains(), clangResolver->compiler(), buildEnvironment.fileTypeResolver());
     if (headermapResolver == nullptr) {
         return false;
     }
 
     /* Populate the tool context with what's needed for compilation. */
-    headermapResolver->resolve(&phaseContext->toolContext(), targetEnvironment.environment(), phaseEnvironment.target());
+    headermapResolver->resolve(&phaseContext->toolContext(), targetEnvironment.environment(), phaseEnvironment.target(), phaseEnvironment.buildContext().headermapCache());
 
     /*
      * Module maps need to be generated.
@@ -125,7 +183,7 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
         fprintf(stderr, "error: unable to resolve module map\n");
     }
 
-    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, targetEnvironment.environment(), _buildPhase->files());
+    std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(phaseEnvironment.buildContext().filesystem(), phaseEnvironment, targetEnvironment.environment(), _buildPhase->files());
 
     /*
      * Split files based on whether their tool is architecture-neutral.
@@ -149,10 +207,19 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
         return false;
     }
 
+    /*
+     * Optionally compile C-family sources together, in fewer invocations.
+     */
+    int64_t unitySize = pbxsetting::Type::ParseInteger(targetEnvironment.environment().resolve("UNITY_BUILD_SIZE"));
+    if (unitySize > 1) {
+        architectureFiles = UnitySources(&phaseContext->toolContext(), targetEnvironment.environment(), architectureFiles, static_cast<size_t>(unitySize));
+    }
+
     /*
      * Resolve architecture-specific files.
      */
     std::vector<std::vector<Tool::Input>> architectureGroups = Phase::Context::Group(architectureFiles);
+    std::vector<std::pair<pbxsetting::Environment, std::string>> architecturePasses;
     for (std::string const &variant : targetEnvironment.variants()) {
         for (std::string const &arch : targetEnvironment.architectures()) {
             pbxsetting::Environment currentEnvironment = pbxsetting::Environment(targetEnvironment.environment());
@@ -160,13 +227,15 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
             currentEnvironment.insertFront(Phase::Environment::ArchitectureLevel(arch), false);
 
             std::string outputDirectory = currentEnvironment.expand(pbxsetting::Value::Parse("$(OBJECT_FILE_DIR_$(variant))/$(arch)"));
-
-            if (!phaseContext->resolveBuildFiles(phaseEnvironment, currentEnvironment, _buildPhase, architectureGroups, outputDirectory)) {
-                return false;
-            }
+            architecturePasses.push_back({ std::move(currentEnvironment), outputDirectory });
         }
     }
 
+    /* Each variant and architecture is prepared at the same time, and added in this order. */
+    if (!phaseContext->resolveBuildFiles(phaseEnvironment, architecturePasses, _buildPhase, architectureGroups)) {
+        return false;
+    }
+
     /*
      * For any built Swift modules, copy their outputs as needed.
      */
@@ -14,13 +14,11 @@
 #include <pbxbuild/Tool/SwiftStandardLibraryResolver.h>
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
-#include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
 namespace Target = pbxbuild::Target;
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
-using libutil::Filesystem;
 using libutil::FSUtil;
 
 Phase::SwiftResolver::
@@ -107,7 +105,7 @@ CollectScanDirectories(
             continue;
         }
 
-        std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, environment, buildPhase->files());
+        std::vector<Tool::Input> files = Phase::File::ResolveBuildFiles(phaseEnvironment.buildContext().filesystem(), phaseEnvironment, environment, buildPhase->files());
         for (Tool::Input const &file : files) {
             if (file.fileType() != nullptr && file.fileType()->isFrameworkWrapper()) {
                 directories.push_back(file.path());
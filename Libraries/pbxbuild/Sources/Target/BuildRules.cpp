@@ -29,41 +29,72 @@ Target::BuildRules::
 BuildRules(Target::BuildRules::BuildRule::vector const &buildRules) :
     _buildRules(buildRules)
 {
+    for (size_t index = 0; index < _buildRules.size(); ++index) {
+        BuildRule::shared_ptr const &buildRule = _buildRules[index];
+
+        /* Rules with file patterns only match by pattern. */
+        if (!buildRule->filePatterns().empty()) {
+            if (buildRule->filePatterns().find_first_of("*[") == std::string::npos) {
+                _fileNameRules.insert({ buildRule->filePatterns(), index });
+            } else {
+                _patternRules.push_back({ index, Wildcard::Compile(buildRule->filePatterns()) });
+            }
+        } else {
+            for (pbxspec::PBX::FileType::shared_ptr const &fileType : buildRule->fileTypes()) {
+                _fileTypeRules.insert({ fileType.get(), index });
+            }
+        }
+    }
 }
 
 Target::BuildRules::BuildRule::shared_ptr Target::BuildRules::
 resolve(pbxspec::PBX::FileType::shared_ptr const &fileType, std::string const &filePath) const
 {
-    for (BuildRule::shared_ptr const &buildRule : _buildRules) {
-        if (!buildRule->filePatterns().empty()) {
-            if (Wildcard::Match(buildRule->filePatterns(), FSUtil::GetBaseName(filePath))) {
-                return buildRule;
+    size_t first = _buildRules.size();
+
+    for (pbxspec::PBX::FileType const *FT = fileType.get(); FT != nullptr; FT = FT->base().get()) {
+        auto it = _fileTypeRules.find(FT);
+        if (it != _fileTypeRules.end()) {
+            first = std::min(first, it->second);
+        }
+    }
+
+    if (!_fileNameRules.empty() || !_patternRules.empty()) {
+        std::string fileName = FSUtil::GetBaseName(filePath);
+
+        auto it = _fileNameRules.find(fileName);
+        if (it != _fileNameRules.end()) {
+            first = std::min(first, it->second);
+        }
+
+        /* Sorted, so only patterns before the first match so far need checking. */
+        for (auto const &entry : _patternRules) {
+            if (entry.first >= first) {
+                break;
             }
-        } else {
-            pbxspec::PBX::FileType::vector const &fileTypes = buildRule->fileTypes();
-            for (pbxspec::PBX::FileType::shared_ptr FT = fileType; FT != nullptr; FT = FT->base()) {
-                if (std::find(fileTypes.begin(), fileTypes.end(), FT) != fileTypes.end()) {
-                    return buildRule;
-                }
+
+            if (entry.second.match(fileName)) {
+                first = entry.first;
+                break;
             }
         }
     }
 
-    return nullptr;
+    return (first < _buildRules.size() ? _buildRules[first] : nullptr);
 }
 
 static Target::BuildRules::BuildRule::shared_ptr
-ProjectBuildRule(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxproj::PBX::BuildRule::shared_ptr const &projBuildRule)
+ProjectBuildRule(pbxspec::DomainSet::shared_ptr const &domainSet, pbxproj::PBX::BuildRule::shared_ptr const &projBuildRule)
 {
     pbxspec::PBX::Tool::shared_ptr tool = nullptr;
     std::string const &TS = projBuildRule->compilerSpec();
     if (TS != "com.apple.compilers.proxy.script") {
-        tool = specManager->tool(TS, domains);
+        tool = domainSet->find<pbxspec::PBX::Tool>(TS);
         if (tool == nullptr) {
-            tool = std::static_pointer_cast<pbxspec::PBX::Tool>(specManager->compiler(TS, domains));
+            tool = domainSet->find<pbxspec::PBX::Compiler>(TS);
         }
         if (tool == nullptr) {
-            tool = std::static_pointer_cast<pbxspec::PBX::Tool>(specManager->linker(TS, domains));
+            tool = domainSet->find<pbxspec::PBX::Linker>(TS);
         }
 
         if (tool == nullptr) {
@@ -75,7 +106,7 @@ ProjectBuildRule(pbxspec::Manager::shared_ptr const &specManager, std::vector<st
     pbxspec::PBX::FileType::vector fileTypes;
     std::string const &FT = projBuildRule->fileType();
     if (FT != "pattern.proxy") {
-        pbxspec::PBX::FileType::shared_ptr fileType = specManager->fileType(FT, domains);
+        pbxspec::PBX::FileType::shared_ptr fileType = domainSet->find<pbxspec::PBX::FileType>(FT);
         if (fileType == nullptr) {
             fprintf(stderr, "warning: couldn't find input file type %s specified in build rule\n", FT.c_str());
             return nullptr;
@@ -98,19 +129,19 @@ ProjectBuildRule(pbxspec::Manager::shared_ptr const &specManager, std::vector<st
 }
 
 static Target::BuildRules::BuildRule::shared_ptr
-SpecificationBuildRule(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxspec::PBX::BuildRule::shared_ptr const &specBuildRule)
+SpecificationBuildRule(pbxspec::DomainSet::shared_ptr const &domainSet, pbxspec::PBX::BuildRule::shared_ptr const &specBuildRule)
 {
     if (!specBuildRule->compilerSpec()) {
         return nullptr;
     }
 
     std::string const &TS = *specBuildRule->compilerSpec();
-    pbxspec::PBX::Tool::shared_ptr tool = specManager->tool(TS, domains);
+    pbxspec::PBX::Tool::shared_ptr tool = domainSet->find<pbxspec::PBX::Tool>(TS);
     if (tool == nullptr) {
-        tool = std::static_pointer_cast<pbxspec::PBX::Tool>(specManager->compiler(TS, domains));
+        tool = domainSet->find<pbxspec::PBX::Compiler>(TS);
     }
     if (tool == nullptr) {
-        tool = std::static_pointer_cast<pbxspec::PBX::Tool>(specManager->linker(TS, domains));
+        tool = domainSet->find<pbxspec::PBX::Linker>(TS);
     }
 
     if (tool == nullptr) {
@@ -120,7 +151,7 @@ SpecificationBuildRule(pbxspec::Manager::shared_ptr const &specManager, std::vec
     pbxspec::PBX::FileType::vector fileTypes;
     if (specBuildRule->fileTypes()) {
         for (std::string const &FT : *specBuildRule->fileTypes()) {
-            pbxspec::PBX::FileType::shared_ptr fileType = specManager->fileType(FT, domains);
+            pbxspec::PBX::FileType::shared_ptr fileType = domainSet->find<pbxspec::PBX::FileType>(FT);
             if (fileType == nullptr) {
                 return nullptr;
             }
@@ -138,27 +169,27 @@ SpecificationBuildRule(pbxspec::Manager::shared_ptr const &specManager, std::vec
 }
 
 Target::BuildRules Target::BuildRules::
-Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, pbxproj::PBX::Target::shared_ptr const &target)
+Create(pbxspec::Manager::shared_ptr const &specManager, pbxspec::DomainSet::shared_ptr const &domainSet, pbxproj::PBX::Target::shared_ptr const &target)
 {
     Target::BuildRules::BuildRule::vector buildRules;
 
     if (target->type() == pbxproj::PBX::Target::Type::Native) {
         pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast <pbxproj::PBX::NativeTarget> (target);
         for (pbxproj::PBX::BuildRule::shared_ptr const &projBuildRule : nativeTarget->buildRules()) {
-            if (Target::BuildRules::BuildRule::shared_ptr buildRule = ProjectBuildRule(specManager, domains, projBuildRule)) {
+            if (Target::BuildRules::BuildRule::shared_ptr buildRule = ProjectBuildRule(domainSet, projBuildRule)) {
                 buildRules.push_back(buildRule);
             }
         }
     }
 
     for (pbxspec::PBX::BuildRule::shared_ptr const &specBuildRule : specManager->buildRules()) {
-        if (Target::BuildRules::BuildRule::shared_ptr buildRule = SpecificationBuildRule(specManager, domains, specBuildRule)) {
+        if (Target::BuildRules::BuildRule::shared_ptr buildRule = SpecificationBuildRule(domainSet, specBuildRule)) {
             buildRules.push_back(buildRule);
         }
     }
 
-    for (pbxspec::PBX::BuildRule::shared_ptr const &specBuildRule : specManager->synthesizedBuildRules(domains)) {
-        if (BuildRule::shared_ptr buildRule = SpecificationBuildRule(specManager, domains, specBuildRule)) {
+    for (pbxspec::PBX::BuildRule::shared_ptr const &specBuildRule : specManager->synthesizedBuildRules(domainSet->domains())) {
+        if (BuildRule::shared_ptr buildRule = SpecificationBuildRule(domainSet, specBuildRule)) {
             buildRules.push_back(buildRule);
         }
     }
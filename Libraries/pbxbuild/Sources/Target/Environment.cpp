@@ -16,6 +16,7 @@
 #include <pbxsetting/XC/Config.h>
 #include <libutil/FSUtil.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Trace.h>
 
 #include <algorithm>
 #include <set>
@@ -32,7 +33,7 @@ Environment(
     std::vector<xcsdk::SDK::Toolchain::shared_ptr> const &toolchains,
     std::vector<std::string> const &executablePaths,
     Target::BuildRules const &buildRules,
-    std::vector<std::string> const &specDomains,
+    pbxspec::DomainSet::shared_ptr const &specDomainSet,
     pbxspec::PBX::BuildSystem::shared_ptr const &buildSystem,
     pbxspec::PBX::ProductType::shared_ptr const &productType,
     pbxspec::PBX::PackageType::shared_ptr const &packageType,
@@ -45,7 +46,7 @@ Environment(
     _toolchains              (toolchains),
     _executablePaths         (executablePaths),
     _buildRules              (buildRules),
-    _specDomains             (specDomains),
+    _specDomainSet           (specDomainSet),
     _buildSystem             (buildSystem),
     _productType             (productType),
     _packageType             (packageType),
@@ -147,13 +148,13 @@ SDKSpecificationDomains(xcsdk::SDK::Target::shared_ptr const &sdk)
 }
 
 static pbxsetting::Level
-PlatformArchitecturesLevel(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains)
+PlatformArchitecturesLevel(pbxspec::DomainSet::shared_ptr const &specDomainSet)
 {
     std::vector<pbxsetting::Setting> architectureSettings;
     std::vector<std::string> platformArchitectures;
 
-    pbxspec::PBX::Architecture::vector architectures = specManager->architectures(specDomains);
-    for (pbxspec::PBX::Architecture::shared_ptr const &architecture : architectures) {
+    for (pbxspec::PBX::Specification::shared_ptr const &specification : specDomainSet->specifications(pbxspec::PBX::Architecture::Type())) {
+        pbxspec::PBX::Architecture::shared_ptr architecture = std::static_pointer_cast<pbxspec::PBX::Architecture>(specification);
         ext::optional<pbxsetting::Setting> architectureSetting = architecture->defaultSetting();
         if (architectureSetting) {
             architectureSettings.push_back(*architectureSetting);
@@ -202,14 +203,14 @@ ProductTypeLevel(pbxspec::PBX::ProductType::shared_ptr const &productType)
 }
 
 static pbxspec::PBX::BuildSystem::shared_ptr
-TargetBuildSystem(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains, pbxproj::PBX::Target::shared_ptr const &target)
+TargetBuildSystem(pbxspec::DomainSet::shared_ptr const &specDomainSet, pbxproj::PBX::Target::shared_ptr const &target)
 {
     if (target->type() == pbxproj::PBX::Target::Type::Native) {
-        return specManager->buildSystem("com.apple.build-system.native", specDomains);
+        return specDomainSet->find<pbxspec::PBX::BuildSystem>("com.apple.build-system.native");
     } else if (target->type() == pbxproj::PBX::Target::Type::Legacy) {
-        return specManager->buildSystem("com.apple.build-system.external", specDomains);
+        return specDomainSet->find<pbxspec::PBX::BuildSystem>("com.apple.build-system.external");
     } else if (target->type() == pbxproj::PBX::Target::Type::Aggregate) {
-       return specManager->buildSystem("com.apple.build-system.external", specDomains);
+       return specDomainSet->find<pbxspec::PBX::BuildSystem>("com.apple.build-system.external");
     } else {
         fprintf(stderr, "error: unknown target type\n");
         return nullptr;
@@ -219,9 +220,9 @@ TargetBuildSystem(pbxspec::Manager::shared_ptr const &specManager, std::vector<s
 static std::vector<std::string>
 ResolveArchitectures(pbxsetting::Environment const &environment)
 {
-    std::vector<std::string> archsVector = pbxsetting::Type::ParseList(environment.resolve("ARCHS"));
+    std::vector<std::string> archsVector = environment.resolveList("ARCHS");
     std::set<std::string> archs = std::set<std::string>(archsVector.begin(), archsVector.end());
-    std::vector<std::string> validArchsVector = pbxsetting::Type::ParseList(environment.resolve("VALID_ARCHS"));
+    std::vector<std::string> validArchsVector = environment.resolveList("VALID_ARCHS");
     std::set<std::string> validArchs = std::set<std::string>(validArchsVector.begin(), validArchsVector.end());
 
     std::vector<std::string> architectures;
@@ -232,7 +233,7 @@ ResolveArchitectures(pbxsetting::Environment const &environment)
 static std::vector<std::string>
 ResolveVariants(pbxsetting::Environment const &environment)
 {
-    return pbxsetting::Type::ParseList(environment.resolve("BUILD_VARIANTS"));
+    return environment.resolveList("BUILD_VARIANTS");
 }
 
 static pbxsetting::Level
@@ -267,6 +268,13 @@ ArchitecturesVariantsLevel(std::vector<std::string> const &architectures, std::v
 ext::optional<Target::Environment> Target::Environment::
 Create(Build::Environment const &buildEnvironment, Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
 {
+    libutil::Trace::Span span("Create Target Environment", target->name());
+
+    /* Targets of lazily opened projects are only fully parsed when built. */
+    if (!target->buildPhasesValid()) {
+        return ext::nullopt;
+    }
+
     /* Use the source root, which could have been modified by project options, rather than the raw project path. */
     std::string workingDirectory = target->project()->sourceRoot();
 
@@ -347,7 +355,9 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
         specDomains = SDKSpecificationDomains(sdk);
     }
 
-    pbxspec::PBX::BuildSystem::shared_ptr buildSystem = TargetBuildSystem(buildEnvironment.specManager(), specDomains, target);
+    pbxspec::DomainSet::shared_ptr specDomainSet = pbxspec::DomainSet::Create(*buildEnvironment.specManager(), specDomains);
+
+    pbxspec::PBX::BuildSystem::shared_ptr buildSystem = TargetBuildSystem(specDomainSet, target);
     if (buildSystem == nullptr) {
         fprintf(stderr, "error: unable to create build system\n");
         return ext::nullopt;
@@ -358,7 +368,7 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     if (target->type() == pbxproj::PBX::Target::Type::Native) {
         pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
 
-        productType = buildEnvironment.specManager()->productType(nativeTarget->productType(), specDomains);
+        productType = specDomainSet->find<pbxspec::PBX::ProductType>(nativeTarget->productType());
         if (productType == nullptr) {
             fprintf(stderr, "error: unable to find product type %s\n", nativeTarget->productType().c_str());
             return ext::nullopt;
@@ -366,7 +376,7 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
 
         // FIXME(grp): Should this always use the first package type?
         if (productType->packageTypes() && !productType->packageTypes()->empty()) {
-            packageType = buildEnvironment.specManager()->packageType(productType->packageTypes()->at(0), specDomains);
+            packageType = specDomainSet->find<pbxspec::PBX::PackageType>(productType->packageTypes()->at(0));
             if (packageType == nullptr) {
                 fprintf(stderr, "error: unable to find package type %s\n", productType->packageTypes()->at(0).c_str());
                 return ext::nullopt;
@@ -375,30 +385,35 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     }
 
     /*
-     * Now we have $(SDKROOT), and can make the real levels.
+     * Now we have $(SDKROOT), and can make the real levels. The levels up to
+     * the SDK's are the same for every target with this build system and SDK.
      */
-    pbxsetting::Environment environment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
-    environment.insertFront(buildSystem->defaultSettings(), true);
-    environment.insertFront(buildContext.baseSettings(), false);
-    environment.insertFront(pbxsetting::Level({
-        pbxsetting::Setting::Parse("GCC_VERSION", "$(DEFAULT_COMPILER)"),
-    }), false);
+    pbxsetting::Environment environment = buildContext.sdkEnvironment(buildSystem, sdk, [&]() {
+        pbxsetting::Environment environment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
+        environment.insertFront(buildSystem->defaultSettings(), true);
+        environment.insertFront(buildContext.baseSettings(), false);
+        environment.insertFront(pbxsetting::Level({
+            pbxsetting::Setting::Parse("GCC_VERSION", "$(DEFAULT_COMPILER)"),
+        }), false);
+
+        if (sdk->platform()->defaultProperties()) {
+            environment.insertFront(*sdk->platform()->defaultProperties(), false);
+        }
+        environment.insertFront(PlatformArchitecturesLevel(specDomainSet), false);
+        if (sdk->defaultProperties()) {
+            environment.insertFront(*sdk->defaultProperties(), false);
+        }
+        environment.insertFront(sdk->platform()->settings(), false);
+        environment.insertFront(sdk->settings(), false);
+        if (sdk->customProperties()) {
+            environment.insertFront(*sdk->customProperties(), false);
+        }
+        if (sdk->platform()->overrideProperties()) {
+            environment.insertFront(*sdk->platform()->overrideProperties(), false);
+        }
 
-    if (sdk->platform()->defaultProperties()) {
-        environment.insertFront(*sdk->platform()->defaultProperties(), false);
-    }
-    environment.insertFront(PlatformArchitecturesLevel(buildEnvironment.specManager(), specDomains), false);
-    if (sdk->defaultProperties()) {
-        environment.insertFront(*sdk->defaultProperties(), false);
-    }
-    environment.insertFront(sdk->platform()->settings(), false);
-    environment.insertFront(sdk->settings(), false);
-    if (sdk->customProperties()) {
-        environment.insertFront(*sdk->customProperties(), false);
-    }
-    if (sdk->platform()->overrideProperties()) {
-        environment.insertFront(*sdk->platform()->overrideProperties(), false);
-    }
+        return environment;
+    });
 
     if (packageType != nullptr) {
         environment.insertFront(PackageTypeLevel(packageType), false);
@@ -439,9 +454,12 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
         pbxsetting::Setting::Create("SDKROOT", sdk->path()),
     }), false);
 
+    /* The target environment is complete; tools resolve the same settings repeatedly. */
+    environment.setMemoized(true);
+
     /* Determine toolchains. Must be after the SDK levels are added, so they can be a fallback. */
     std::vector<xcsdk::SDK::Toolchain::shared_ptr> toolchains;
-    for (std::string const &toolchainName : pbxsetting::Type::ParseList(environment.resolve("TOOLCHAINS"))) {
+    for (std::string const &toolchainName : environment.resolveList("TOOLCHAINS")) {
         if (xcsdk::SDK::Toolchain::shared_ptr toolchain = buildEnvironment.sdkManager()->findToolchain(toolchainName)) {
             // TODO: Apply toolchain override build settings.
             toolchains.push_back(toolchain);
@@ -452,7 +470,7 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     std::shared_ptr<xcsdk::SDK::Manager> const &sdkManager = buildEnvironment.sdkManager();
     std::vector<std::string> executablePaths = sdkManager->executablePaths(sdk->platform(), sdk, toolchains);
 
-    auto buildRules = Target::BuildRules::Create(buildEnvironment.specManager(), specDomains, target);
+    auto buildRules = Target::BuildRules::Create(buildEnvironment.specManager(), specDomainSet, target);
     auto buildFileDisambiguation = BuildFileDisambiguation(target);
 
     return Environment(
@@ -460,7 +478,7 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
         toolchains,
         executablePaths,
         buildRules,
-        specDomains,
+        specDomainSet,
         buildSystem,
         productType,
         packageType,
@@ -0,0 +1,92 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/TargetIndex.h>
+#include <pbxproj/PBX/NativeTarget.h>
+
+using pbxbuild::TargetIndex;
+
+TargetIndex::
+TargetIndex()
+{
+}
+
+pbxproj::PBX::Target::shared_ptr TargetIndex::
+target(pbxproj::PBX::Project::shared_ptr const &project, std::string const &identifier) const
+{
+    auto PI = _projects.find(project);
+    if (PI == _projects.end()) {
+        return nullptr;
+    }
+
+    auto TI = PI->second.targets.find(identifier);
+    if (TI == PI->second.targets.end()) {
+        return nullptr;
+    }
+
+    return TI->second;
+}
+
+ext::optional<std::pair<pbxproj::PBX::Target::shared_ptr, pbxproj::PBX::FileReference::shared_ptr>> TargetIndex::
+product(pbxproj::PBX::Project::shared_ptr const &project, std::string const &identifier) const
+{
+    auto PI = _projects.find(project);
+    if (PI == _projects.end()) {
+        return ext::nullopt;
+    }
+
+    auto TI = PI->second.products.find(identifier);
+    if (TI == PI->second.products.end()) {
+        return ext::nullopt;
+    }
+
+    return TI->second;
+}
+
+pbxproj::PBX::Target::shared_ptr TargetIndex::
+productName(std::string const &name) const
+{
+    auto it = _productNames.find(name);
+    if (it == _productNames.end()) {
+        return nullptr;
+    }
+
+    return it->second;
+}
+
+TargetIndex TargetIndex::
+Create(std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> const &projects)
+{
+    TargetIndex index;
+
+    for (auto const &pair : projects) {
+        ProjectTargets &projectTargets = index._projects[pair.second];
+
+        for (pbxproj::PBX::Target::shared_ptr const &target : pair.second->targets()) {
+            /* Identifiers should be unique, but the first target is used if not. */
+            projectTargets.targets.insert({ target->blueprintIdentifier(), target });
+
+            if (target->type() != pbxproj::PBX::Target::Type::Native) {
+                /* Only native targets have products. */
+                continue;
+            }
+
+            pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
+            pbxproj::PBX::FileReference::shared_ptr const &productReference = nativeTarget->productReference();
+            if (productReference != nullptr) {
+                projectTargets.products.insert({ productReference->blueprintIdentifier(), { target, productReference } });
+
+                /* Use the product name because the path can't be resolved yet. */
+                index._productNames.insert({ productReference->name(), nativeTarget });
+            }
+        }
+    }
+
+    return index;
+}
@@ -89,7 +89,13 @@ resolve(
     arguments.insert(arguments.end(), deploymentTargetArguments.begin(), deploymentTargetArguments.end());
 
     // TODO(grp): This is a hack to work around missing `Condition` support in options.
-    arguments.erase(std::remove(arguments.begin(), arguments.end(), "--optimization"), arguments.end());
+    for (auto it = arguments.begin(); it != arguments.end();) {
+        if (*it == "--optimization" && (std::next(it) == arguments.end() || std::next(it)->empty())) {
+            it = arguments.erase(it);
+        } else {
+            ++it;
+        }
+    }
     arguments.erase(std::remove(arguments.begin(), arguments.end(), ""), arguments.end());
 
     // TODO(grp): These should be handled generically for all tools.
@@ -126,6 +132,7 @@ resolve(
      * Create the asset catalog invocation.
      */
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
     invocation.arguments() = arguments;
     invocation.environment() = environmentVariables;
@@ -11,6 +11,7 @@
 #include <pbxbuild/Tool/CompilerCommon.h>
 #include <pbxbuild/Tool/Context.h>
 #include <pbxbuild/Tool/CompilationInfo.h>
+#include <pbxbuild/Tool/ExplicitModuleInfo.h>
 #include <pbxbuild/Tool/HeadermapInfo.h>
 #include <pbxbuild/Tool/PrecompiledHeaderInfo.h>
 #include <pbxbuild/Tool/SearchPaths.h>
@@ -68,6 +69,21 @@ AppendFrameworkPathFlags(std::vector<std::string> *args, pbxsetting::Environment
     Tool::CompilerCommon::AppendCompoundFlags(args, "-F", true, searchPaths.frameworkSearchPaths());
 }
 
+static void
+AppendExplicitModuleFlags(std::vector<std::string> *args, std::vector<std::string> *moduleFiles, pbxsetting::Environment const &environment, std::vector<Tool::ExplicitModuleInfo> const &explicitModuleInfo)
+{
+    std::string variant = environment.resolve("variant");
+    std::string arch = environment.resolve("arch");
+
+    /* Loaded only if imported, so every module available can be passed. */
+    for (Tool::ExplicitModuleInfo const &module : explicitModuleInfo) {
+        if (ext::optional<std::string> modulePath = module.modulePath(variant, arch)) {
+            args->push_back("-fmodule-file=" + module.moduleName() + "=" + *modulePath);
+            moduleFiles->push_back(*modulePath);
+        }
+    }
+}
+
 static void
 AppendCustomFlags(std::vector<std::string> *args, pbxsetting::Environment const &environment, ext::optional<std::string> const &dialect)
 {
@@ -83,7 +99,7 @@ AppendCustomFlags(std::vector<std::string> *args, pbxsetting::Environment const
     flagSettings.push_back("PER_ARCH_CFLAGS_" + environment.resolve("CURRENT_ARCH"));
 
     for (std::string const &flagSetting : flagSettings) {
-        std::vector<std::string> flags = pbxsetting::Type::ParseList(environment.resolve(flagSetting));
+        std::vector<std::string> flags = environment.resolveList(flagSetting);
         args->insert(args->end(), flags.begin(), flags.end());
     }
 }
@@ -91,10 +107,10 @@ AppendCustomFlags(std::vector<std::string> *args, pbxsetting::Environment const
 static void
 AppendNotUsedInPrecompsFlags(std::vector<std::string> *args, pbxsetting::Environment const &environment)
 {
-    std::vector<std::string> preprocessorDefinitions = pbxsetting::Type::ParseList(environment.resolve("GCC_PREPROCESSOR_DEFINITIONS_NOT_USED_IN_PRECOMPS"));
+    std::vector<std::string> preprocessorDefinitions = environment.resolveList("GCC_PREPROCESSOR_DEFINITIONS_NOT_USED_IN_PRECOMPS");
     Tool::CompilerCommon::AppendCompoundFlags(args, "-D", true, preprocessorDefinitions);
 
-    std::vector<std::string> otherFlags = pbxsetting::Type::ParseList(environment.resolve("GCC_OTHER_CFLAGS_NOT_USED_IN_PRECOMPS"));
+    std::vector<std::string> otherFlags = environment.resolveList("GCC_OTHER_CFLAGS_NOT_USED_IN_PRECOMPS");
     args->insert(args->end(), otherFlags.begin(), otherFlags.end());
 }
 
@@ -181,6 +197,7 @@ resolvePrecompiledHeader(
     }
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _compiler->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
     invocation.arguments() = arguments;
     invocation.environment() = options.environment();
@@ -194,12 +211,160 @@ resolvePrecompiledHeader(
     toolContext->auxiliaryFiles().push_back(serializedFile);
 }
 
+void Tool::ClangResolver::
+resolveModule(
+    Tool::Context *toolContext,
+    pbxsetting::Environment const &environment,
+    std::string const &moduleName,
+    Tool::Input const &moduleMap,
+    std::string const &output,
+    std::vector<std::string> const &inputDependencies) const
+{
+    pbxspec::PBX::Tool::shared_ptr tool = std::static_pointer_cast <pbxspec::PBX::Tool> (_compiler);
+    Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { moduleMap }, { output });
+    pbxsetting::Environment const &env = toolEnvironment.environment();
+
+    /* Built with the same options as the sources of the module map's language. */
+    ext::optional<std::string> const &dialect = (moduleMap.fileType() != nullptr ? moduleMap.fileType()->GCCDialectName() : ext::nullopt);
+    std::shared_ptr<SourceTemplate const> sourceTemplate = this->sourceTemplate(toolContext, environment, toolEnvironment, moduleMap, dialect);
+
+    std::vector<std::string> arguments;
+    AppendDialectFlags(&arguments, dialect);
+    arguments.insert(arguments.end(), sourceTemplate->arguments.begin(), sourceTemplate->arguments.end());
+    arguments.push_back("-fmodules");
+    arguments.push_back("-fmodule-name=" + moduleName);
+    arguments.push_back("-Xclang");
+    arguments.push_back("-emit-module");
+    AppendDependencyInfoFlags(&arguments, _compiler, env);
+    AppendInputOutputFlags(&arguments, _compiler, moduleMap.path(), output);
+
+    std::vector<std::string> moduleInputDependencies = inputDependencies;
+    moduleInputDependencies.insert(moduleInputDependencies.end(), sourceTemplate->moduleFiles.begin(), sourceTemplate->moduleFiles.end());
+
+    std::string logMessage = CompileLogMessage(_compiler, "CompileModule", moduleMap.path(), dialect, output, env, toolContext->workingDirectory());
+
+    std::vector<Tool::Invocation::DependencyInfo> dependencyInfo;
+    if (_compiler->dependencyInfoFile()) {
+        dependencyInfo.push_back(Tool::Invocation::DependencyInfo(
+            dependency::DependencyInfoFormat::Makefile,
+            env.expand(*_compiler->dependencyInfoFile())));
+    }
+
+    Tool::Invocation invocation;
+    invocation.toolIdentifier() = _compiler->identifier();
+    invocation.executable() = Tool::Invocation::Executable::Determine(sourceTemplate->executable);
+    invocation.arguments() = arguments;
+    invocation.environment() = sourceTemplate->environment;
+    invocation.workingDirectory() = toolContext->workingDirectory();
+    invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
+    invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
+    invocation.inputDependencies() = moduleInputDependencies;
+    invocation.dependencyInfo() = dependencyInfo;
+    invocation.logMessage() = logMessage;
+    toolContext->invocations().push_back(invocation);
+}
+
+Tool::ClangResolver::PreparedSource::
+PreparedSource(
+    Tool::Invocation const &invocation,
+    std::shared_ptr<PrecompiledHeaderInfo> const &precompiledHeaderInfo,
+    ext::optional<std::string> const &dialect,
+    std::vector<std::string> const &linkerArgs) :
+    _invocation           (invocation),
+    _precompiledHeaderInfo(precompiledHeaderInfo),
+    _dialect              (dialect),
+    _linkerArgs           (linkerArgs)
+{
+}
+
 void Tool::ClangResolver::
 resolveSource(
     Tool::Context *toolContext,
     pbxsetting::Environment const &environment,
     Tool::Input const &input,
     std::string const &outputDirectory) const
+{
+    addSource(toolContext, environment, prepareSource(toolContext, environment, input, outputDirectory));
+}
+
+static std::vector<std::string>
+PrecompiledHeaderArguments(std::vector<std::string> const &arguments, ext::optional<std::string> const &dialect, std::vector<std::string> const &inputArguments)
+{
+    std::vector<std::string> precompiledHeaderArguments;
+    AppendDialectFlags(&precompiledHeaderArguments, dialect, "-header");
+    precompiledHeaderArguments.insert(precompiledHeaderArguments.end(), arguments.begin(), arguments.end());
+    // Added after, but need to have here in case it affects the precompiled header (as it often does).
+    precompiledHeaderArguments.insert(precompiledHeaderArguments.end(), inputArguments.begin(), inputArguments.end());
+    return precompiledHeaderArguments;
+}
+
+std::shared_ptr<Tool::ClangResolver::SourceTemplate const> Tool::ClangResolver::
+sourceTemplate(
+    Tool::Context const *toolContext,
+    pbxsetting::Environment const &environment,
+    Tool::Environment const &toolEnvironment,
+    Tool::Input const &input,
+    ext::optional<std::string> const &dialect) const
+{
+    /*
+     * Compiler options only depend on the file type, the variant and
+     * architecture being built, and the language dialect.
+     */
+    std::string key;
+    key += (input.fileType() != nullptr ? input.fileType()->identifier() : "") + '\0';
+    key += environment.resolve("variant") + '\0';
+    key += environment.resolve("arch") + '\0';
+    key += dialect.value_or("");
+
+    {
+        std::lock_guard<std::mutex> lock(_sourceTemplatesMutex);
+
+        auto it = _sourceTemplates.find(key);
+        if (it != _sourceTemplates.end()) {
+            return it->second;
+        }
+    }
+
+    pbxsetting::Environment const &env = toolEnvironment.environment();
+    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), input.fileType());
+    Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
+
+    auto sourceTemplate = std::make_shared<SourceTemplate>();
+    sourceTemplate->executable = tokens.executable();
+    sourceTemplate->environment = options.environment();
+    sourceTemplate->linkerArgs = options.linkerArgs();
+
+    std::vector<std::string> *arguments = &sourceTemplate->arguments;
+    arguments->insert(arguments->end(), tokens.arguments().begin(), tokens.arguments().end());
+    Tool::CompilerCommon::AppendIncludePathFlags(arguments, env, toolContext->searchPaths(), toolContext->headermapInfo());
+    AppendFrameworkPathFlags(arguments, env, toolContext->searchPaths());
+    AppendExplicitModuleFlags(arguments, &sourceTemplate->moduleFiles, env, toolContext->explicitModuleInfo());
+    AppendCustomFlags(arguments, env, dialect);
+
+    sourceTemplate->precompilePrefixHeader = pbxsetting::Type::ParseBoolean(env.resolve("GCC_PRECOMPILE_PREFIX_HEADER"));
+    std::string prefixHeader = env.resolve("GCC_PREFIX_HEADER");
+    if (!prefixHeader.empty()) {
+        sourceTemplate->prefixHeaderFile = FSUtil::ResolveRelativePath(prefixHeader, toolContext->workingDirectory());
+
+        if (sourceTemplate->precompilePrefixHeader) {
+            /* Shared by all sources without their own compiler flags. */
+            sourceTemplate->precompiledHeaderInfo = std::make_shared<Tool::PrecompiledHeaderInfo>(PrecompiledHeaderInfo::Create(_compiler, sourceTemplate->prefixHeaderFile, input.fileType(), PrecompiledHeaderArguments(*arguments, dialect, { })));
+        }
+    }
+
+    AppendNotUsedInPrecompsFlags(&sourceTemplate->notUsedInPrecompsArguments, env);
+
+    /* If another source created the same template first, use that one. */
+    std::lock_guard<std::mutex> lock(_sourceTemplatesMutex);
+    return _sourceTemplates.insert({ key, sourceTemplate }).first->second;
+}
+
+Tool::ClangResolver::PreparedSource Tool::ClangResolver::
+prepareSource(
+    Tool::Context const *toolContext,
+    pbxsetting::Environment const &environment,
+    Tool::Input const &input,
+    std::string const &outputDirectory) const
 {
     Tool::HeadermapInfo const &headermapInfo = toolContext->headermapInfo();
 
@@ -225,46 +390,36 @@ resolveSource(
     Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
     pbxsetting::Environment const &env = toolEnvironment.environment();
 
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), input.fileType());
-    Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
+    std::shared_ptr<SourceTemplate const> sourceTemplate = this->sourceTemplate(toolContext, environment, toolEnvironment, input, dialect);
 
     std::vector<std::string> inputDependencies;
     inputDependencies.insert(inputDependencies.end(), headermapInfo.systemHeadermapFiles().begin(), headermapInfo.systemHeadermapFiles().end());
     inputDependencies.insert(inputDependencies.end(), headermapInfo.userHeadermapFiles().begin(), headermapInfo.userHeadermapFiles().end());
+    inputDependencies.insert(inputDependencies.end(), sourceTemplate->moduleFiles.begin(), sourceTemplate->moduleFiles.end());
 
     std::vector<std::string> arguments;
     AppendDialectFlags(&arguments, dialect);
-    size_t dialectOffset = arguments.size();
-
-    arguments.insert(arguments.end(), tokens.arguments().begin(), tokens.arguments().end());
-    Tool::CompilerCommon::AppendIncludePathFlags(&arguments, env, toolContext->searchPaths(), headermapInfo);
-    AppendFrameworkPathFlags(&arguments, env, toolContext->searchPaths());
-    AppendCustomFlags(&arguments, env, dialect);
+    arguments.insert(arguments.end(), sourceTemplate->arguments.begin(), sourceTemplate->arguments.end());
 
-    bool precompilePrefixHeader = pbxsetting::Type::ParseBoolean(env.resolve("GCC_PRECOMPILE_PREFIX_HEADER"));
-    std::string prefixHeader = env.resolve("GCC_PREFIX_HEADER");
     std::shared_ptr<Tool::PrecompiledHeaderInfo> precompiledHeaderInfo = nullptr;
 
-    if (!prefixHeader.empty()) {
-        std::string prefixHeaderFile = FSUtil::ResolveRelativePath(prefixHeader, toolContext->workingDirectory());
+    if (!sourceTemplate->prefixHeaderFile.empty()) {
+        if (sourceTemplate->precompilePrefixHeader) {
+            if (inputArguments.empty()) {
+                precompiledHeaderInfo = sourceTemplate->precompiledHeaderInfo;
+            } else {
+                precompiledHeaderInfo = std::make_shared<Tool::PrecompiledHeaderInfo>(PrecompiledHeaderInfo::Create(_compiler, sourceTemplate->prefixHeaderFile, input.fileType(), PrecompiledHeaderArguments(sourceTemplate->arguments, dialect, inputArguments)));
+            }
 
-        if (precompilePrefixHeader) {
-            std::vector<std::string> precompiledHeaderArguments;
-            AppendDialectFlags(&precompiledHeaderArguments, dialect, "-header");
-            precompiledHeaderArguments.insert(precompiledHeaderArguments.end(), arguments.begin() + dialectOffset, arguments.end());
-            // Added below, but need to have here in case it affects the precompiled header (as it often does).
-            precompiledHeaderArguments.insert(precompiledHeaderArguments.end(), inputArguments.begin(), inputArguments.end());
-
-            precompiledHeaderInfo = std::make_shared<Tool::PrecompiledHeaderInfo>(PrecompiledHeaderInfo::Create(_compiler, prefixHeaderFile, input.fileType(), precompiledHeaderArguments));
             AppendPrefixHeaderFlags(&arguments, env.expand(precompiledHeaderInfo->logicalOutputPath()));
             inputDependencies.push_back(env.expand(precompiledHeaderInfo->compileOutputPath()));
         } else {
-            AppendPrefixHeaderFlags(&arguments, prefixHeaderFile);
-            inputDependencies.push_back(prefixHeaderFile);
+            AppendPrefixHeaderFlags(&arguments, sourceTemplate->prefixHeaderFile);
+            inputDependencies.push_back(sourceTemplate->prefixHeaderFile);
         }
     }
 
-    AppendNotUsedInPrecompsFlags(&arguments, env);
+    arguments.insert(arguments.end(), sourceTemplate->notUsedInPrecompsArguments.begin(), sourceTemplate->notUsedInPrecompsArguments.end());
     // After all of the configurable settings, so they can override.
     arguments.insert(arguments.end(), inputArguments.begin(), inputArguments.end());
     AppendDependencyInfoFlags(&arguments, _compiler, env);
@@ -280,9 +435,10 @@ resolveSource(
     }
 
     Tool::Invocation invocation;
-    invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _compiler->identifier();
+    invocation.executable() = Tool::Invocation::Executable::Determine(sourceTemplate->executable);
     invocation.arguments() = arguments;
-    invocation.environment() = options.environment();
+    invocation.environment() = sourceTemplate->environment;
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
@@ -290,6 +446,19 @@ resolveSource(
     invocation.dependencyInfo() = dependencyInfo;
     invocation.logMessage() = logMessage;
 
+    return PreparedSource(invocation, precompiledHeaderInfo, dialect, sourceTemplate->linkerArgs);
+}
+
+void Tool::ClangResolver::
+addSource(
+    Tool::Context *toolContext,
+    pbxsetting::Environment const &environment,
+    PreparedSource const &preparedSource) const
+{
+    Tool::Invocation const &invocation = preparedSource.invocation();
+    std::shared_ptr<Tool::PrecompiledHeaderInfo> const &precompiledHeaderInfo = preparedSource.precompiledHeaderInfo();
+    ext::optional<std::string> const &dialect = preparedSource.dialect();
+
     /* Add the compilation invocation to the context. */
     toolContext->invocations().push_back(invocation);
     auto variantArchitectureKey = std::make_pair(environment.resolve("variant"), environment.resolve("arch"));
@@ -322,7 +491,7 @@ resolveSource(
         compilationInfo->linkerDriver() = _compiler->execPath()->raw();
     }
 
-    for (std::string const &linkerArg : options.linkerArgs()) {
+    for (std::string const &linkerArg : preparedSource.linkerArgs()) {
         std::vector<std::string> *linkerArguments = &compilationInfo->linkerArguments();
 
         /* Avoid duplicating arguments for multiple compiler invocations. */
@@ -13,10 +13,12 @@ namespace Tool = pbxbuild::Tool;
 
 Tool::Context::
 Context(
+    libutil::Filesystem const *filesystem,
     xcsdk::SDK::Target::shared_ptr const &sdk,
     std::vector<xcsdk::SDK::Toolchain::shared_ptr> const &toolchains,
     std::string const &workingDirectory,
     Tool::SearchPaths const &searchPaths) :
+    _filesystem      (filesystem),
     _sdk             (sdk),
     _toolchains      (toolchains),
     _workingDirectory(workingDirectory),
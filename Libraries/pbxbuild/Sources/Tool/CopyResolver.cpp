@@ -14,8 +14,11 @@
 #include <pbxbuild/Tool/Context.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/md5.h>
 
 #include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 namespace Tool = pbxbuild::Tool;
 using libutil::Filesystem;
@@ -27,6 +30,24 @@ CopyResolver(pbxspec::PBX::Tool::shared_ptr const &tool) :
 {
 }
 
+static std::string
+FileListHash(std::string const &contents)
+{
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(contents.data()), contents.size());
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+
+    return ss.str();
+}
+
 void Tool::CopyResolver::
 resolve(
     Tool::Context *toolContext,
@@ -57,11 +78,27 @@ resolve(
     }
 
     /*
-     * Build the arguments: each input file, then the output directory.
+     * Build the arguments: each input file, then the output directory. When copying
+     * several files, list the inputs in a file instead, so any number of files can
+     * be copied by a single invocation without exceeding command line limits.
      */
     std::vector<std::string> args;
-    for (Tool::Input const &input : inputs) {
-        args.push_back(input.path());
+    if (inputs.size() > 1) {
+        std::string contents;
+        for (Tool::Input const &input : inputs) {
+            contents += input.path() + "\n";
+        }
+
+        std::string fileListPath = environment.resolve("TARGET_TEMP_DIR") + "/" + "CopyFileList-" + FileListHash(outputDirectory + "\n" + contents);
+        auto fileList = Tool::AuxiliaryFile::Data(fileListPath, std::vector<uint8_t>(contents.begin(), contents.end()));
+        toolContext->auxiliaryFiles().push_back(fileList);
+
+        args.push_back("-file-list");
+        args.push_back(fileListPath);
+    } else {
+        for (Tool::Input const &input : inputs) {
+            args.push_back(input.path());
+        }
     }
     args.push_back(outputDirectory);
 
@@ -86,6 +123,7 @@ resolve(
      * Create the copy invocation.
      */
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
     invocation.arguments() = tokens.arguments();
     invocation.environment() = options.environment();
@@ -0,0 +1,40 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/Tool/ExplicitModuleInfo.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Value.h>
+
+namespace Tool = pbxbuild::Tool;
+
+Tool::ExplicitModuleInfo::
+ExplicitModuleInfo(
+    std::string const &moduleName,
+    std::map<std::pair<std::string, std::string>, std::string> const &modulePaths) :
+    _moduleName (moduleName),
+    _modulePaths(modulePaths)
+{
+}
+
+ext::optional<std::string> Tool::ExplicitModuleInfo::
+modulePath(std::string const &variant, std::string const &architecture) const
+{
+    auto it = _modulePaths.find({ variant, architecture });
+    if (it == _modulePaths.end()) {
+        return ext::nullopt;
+    }
+
+    return it->second;
+}
+
+std::string Tool::ExplicitModuleInfo::
+ModulePath(pbxsetting::Environment const &environment)
+{
+    return environment.expand(pbxsetting::Value::Parse("$(OBJECT_FILE_DIR_$(variant))/$(arch)/$(PRODUCT_MODULE_NAME).pcm"));
+}
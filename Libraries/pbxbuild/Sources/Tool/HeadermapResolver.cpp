@@ -13,21 +13,25 @@
 #include <pbxbuild/Tool/Context.h>
 #include <pbxbuild/FileTypeResolver.h>
 #include <pbxbuild/HeaderMap.h>
+#include <pbxbuild/HeadermapCache.h>
+#include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
 namespace Tool = pbxbuild::Tool;
 using pbxbuild::HeaderMap;
+using pbxbuild::HeadermapCache;
 using pbxbuild::FileTypeResolver;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
 Tool::HeadermapResolver::
-HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager) :
-    _tool       (tool),
-    _compiler   (compiler),
-    _specManager(specManager)
+HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<FileTypeResolver> const &fileTypeResolver) :
+    _tool            (tool),
+    _compiler        (compiler),
+    _specManager     (specManager),
+    _fileTypeResolver(fileTypeResolver)
 {
 }
 
@@ -71,11 +75,92 @@ HeadermapSearchPaths(pbxspec::Manager::shared_ptr const &specManager, pbxsetting
     return orderedHeaderSearchPaths;
 }
 
+static std::vector<uint8_t>
+HeaderMapContents(std::vector<HeaderMap::Entry> const &entries)
+{
+    /* Adding all entries at once sizes the table once, rather than growing it. */
+    HeaderMap headerMap;
+    headerMap.add(entries);
+    return headerMap.write();
+}
+
+static std::shared_ptr<HeadermapCache::ProjectHeaders const>
+CreateProjectHeaders(Filesystem const *filesystem, FileTypeResolver const *fileTypeResolver, pbxsetting::Environment const &environment, pbxproj::PBX::Project::shared_ptr const &project)
+{
+    auto headers = std::make_shared<HeadermapCache::ProjectHeaders>();
+
+    for (pbxproj::PBX::FileReference::shared_ptr const &fileReference : project->fileReferences()) {
+        std::string filePath = environment.expand(fileReference->resolve());
+        pbxspec::PBX::FileType::shared_ptr fileType = fileTypeResolver->resolve(filesystem, fileReference, filePath);
+        if (fileType == nullptr || (fileType->identifier() != "sourcecode.c.h" && fileType->identifier() != "sourcecode.cpp.h")) {
+            continue;
+        }
+
+        std::string fileName = FSUtil::GetBaseName(filePath);
+        std::string fileDirectory = FSUtil::GetDirectoryName(filePath) + "/";
+        headers->projectHeaders.push_back({ fileName, fileDirectory, fileName });
+    }
+
+    std::vector<HeaderMap::Entry> allTargetHeaders;
+    std::vector<HeaderMap::Entry> allNonFrameworkTargetHeaders;
+
+    for (pbxproj::PBX::Target::shared_ptr const &projectTarget : project->targets()) {
+       for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : projectTarget->buildPhases()) {
+            if (buildPhase->type() != pbxproj::PBX::BuildPhase::Type::Headers) {
+                continue;
+            }
+
+            for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildPhase->files()) {
+                if (buildFile->fileRef() == nullptr || buildFile->fileRef()->type() != pbxproj::PBX::GroupItem::Type::FileReference) {
+                    continue;
+                }
+
+                pbxproj::PBX::FileReference::shared_ptr const &fileReference = std::static_pointer_cast <pbxproj::PBX::FileReference> (buildFile->fileRef());
+                std::string filePath = environment.expand(fileReference->resolve());
+                pbxspec::PBX::FileType::shared_ptr fileType = fileTypeResolver->resolve(filesystem, fileReference, filePath);
+                if (fileType == nullptr || (fileType->identifier() != "sourcecode.c.h" && fileType->identifier() != "sourcecode.cpp.h")) {
+                    continue;
+                }
+
+                HeadermapCache::TargetHeader header;
+                header.target        = projectTarget;
+                header.fileName      = FSUtil::GetBaseName(filePath);
+                header.fileDirectory = FSUtil::GetDirectoryName(filePath) + "/";
+                header.frameworkName = projectTarget->productName() + "/" + header.fileName;
+
+                std::vector<std::string> const &attributes = buildFile->attributes();
+                header.isPublic  = std::find(attributes.begin(), attributes.end(), "Public") != attributes.end();
+                header.isPrivate = std::find(attributes.begin(), attributes.end(), "Private") != attributes.end();
+
+                // TODO(grp): This is a little messy. Maybe check the product type specification, or the product reference's file type?
+                header.isNonFramework = (projectTarget->type() == pbxproj::PBX::Target::Type::Native && std::static_pointer_cast<pbxproj::PBX::NativeTarget>(projectTarget)->productType().find("framework") == std::string::npos);
+
+                if (header.isPublic || header.isPrivate) {
+                    allTargetHeaders.push_back({ header.frameworkName, header.fileDirectory, header.fileName });
+                    if (header.isNonFramework) {
+                        allNonFrameworkTargetHeaders.push_back({ header.frameworkName, header.fileDirectory, header.fileName });
+                    }
+                }
+
+                headers->targetHeaders.push_back(header);
+            }
+        }
+    }
+
+    /* These header maps are the same for every target in the project. */
+    headers->projectHeadersContents               = HeaderMapContents(headers->projectHeaders);
+    headers->allTargetHeadersContents             = HeaderMapContents(allTargetHeaders);
+    headers->allNonFrameworkTargetHeadersContents = HeaderMapContents(allNonFrameworkTargetHeaders);
+
+    return headers;
+}
+
 void Tool::HeadermapResolver::
 resolve(
     Tool::Context *toolContext,
     pbxsetting::Environment const &environment,
-    pbxproj::PBX::Target::shared_ptr const &target
+    pbxproj::PBX::Target::shared_ptr const &target,
+    HeadermapCache *headermapCache
 ) const
 {
     /* Add the compiler default environment, which contains the headermap setting defaults. */
@@ -90,102 +175,71 @@ resolve(
         // TODO(grp): Support VFS-based header maps.
     }
 
-    HeaderMap targetName;
-    HeaderMap ownTargetHeaders;
-    HeaderMap projectHeaders;
-    HeaderMap allTargetHeaders;
-    HeaderMap allNonFrameworkTargetHeaders;
+    std::vector<HeaderMap::Entry> targetName;
+    std::vector<HeaderMap::Entry> ownTargetHeaders;
 
     bool includeFlatEntriesForTargetBeingBuilt     = pbxsetting::Type::ParseBoolean(compilerEnvironment.resolve("HEADERMAP_INCLUDES_FLAT_ENTRIES_FOR_TARGET_BEING_BUILT"));
     bool includeFrameworkEntriesForAllProductTypes = pbxsetting::Type::ParseBoolean(compilerEnvironment.resolve("HEADERMAP_INCLUDES_FRAMEWORK_ENTRIES_FOR_ALL_PRODUCT_TYPES"));
     bool includeProjectHeaders                     = pbxsetting::Type::ParseBoolean(compilerEnvironment.resolve("HEADERMAP_INCLUDES_PROJECT_HEADERS"));
 
     // TODO(grp): Populate generated headers.
-    HeaderMap generatedFiles;
+    std::vector<HeaderMap::Entry> generatedFiles;
 
     pbxproj::PBX::Project::shared_ptr project = target->project();
 
+    /*
+     * The project's headers only depend on the target through the paths the
+     * file references resolve to, so share them between targets that resolve
+     * the project's paths the same way. References can be relative to the
+     * SDK and developer directories as well as the source and products.
+     */
+    auto create = [&]() {
+        return CreateProjectHeaders(toolContext->filesystem(), _fileTypeResolver.get(), compilerEnvironment, project);
+    };
+    std::shared_ptr<HeadermapCache::ProjectHeaders const> projectHeaders;
+    if (headermapCache != nullptr) {
+        std::string key = project->projectFile();
+        for (std::string const &setting : { "SRCROOT", "BUILT_PRODUCTS_DIR", "SDKROOT", "DEVELOPER_DIR" }) {
+            key += '\0' + compilerEnvironment.resolve(setting);
+        }
+        projectHeaders = headermapCache->project(key, create);
+    } else {
+        projectHeaders = create();
+    }
+
     std::vector<std::string> headermapSearchPaths = HeadermapSearchPaths(_specManager, compilerEnvironment, target, toolContext->searchPaths(), toolContext->workingDirectory());
     for (std::string const &path : headermapSearchPaths) {
-        Filesystem::GetDefaultUNSAFE()->readDirectory(path, false, [&](std::string const &fileName) -> bool {
+        toolContext->filesystem()->readDirectory(path, false, [&](std::string const &fileName) -> bool {
             // TODO(grp): Use FileTypeResolver when reliable.
             std::string extension = FSUtil::GetFileExtension(fileName);
             if (extension != "h" && extension != "hpp") {
                 return true;
             }
 
-            targetName.add(fileName, path + "/", fileName);
+            targetName.push_back({ fileName, path + "/", fileName });
             return true;
         });
     }
 
-    for (pbxproj::PBX::FileReference::shared_ptr const &fileReference : project->fileReferences()) {
-        std::string filePath = compilerEnvironment.expand(fileReference->resolve());
-        pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(Filesystem::GetDefaultUNSAFE(), _specManager, { pbxspec::Manager::AnyDomain() }, fileReference, filePath);
-        if (fileType == nullptr || (fileType->identifier() != "sourcecode.c.h" && fileType->identifier() != "sourcecode.cpp.h")) {
-            continue;
-        }
-
-        std::string fileName = FSUtil::GetBaseName(filePath);
-        std::string fileDirectory = FSUtil::GetDirectoryName(filePath) + "/";
-
-        projectHeaders.add(fileName, fileDirectory, fileName);
-        if (includeProjectHeaders) {
-            targetName.add(fileName, fileDirectory, fileName);
-        }
+    if (includeProjectHeaders) {
+        targetName.insert(targetName.end(), projectHeaders->projectHeaders.begin(), projectHeaders->projectHeaders.end());
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &projectTarget : project->targets()) {
-       for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : projectTarget->buildPhases()) {
-            if (buildPhase->type() != pbxproj::PBX::BuildPhase::Type::Headers) {
-                continue;
-            }
+    for (HeadermapCache::TargetHeader const &header : projectHeaders->targetHeaders) {
+        if (header.target == target) {
+            ownTargetHeaders.push_back({ header.fileName, header.fileDirectory, header.fileName });
 
-            for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildPhase->files()) {
-                if (buildFile->fileRef() == nullptr || buildFile->fileRef()->type() != pbxproj::PBX::GroupItem::Type::FileReference) {
-                    continue;
+            if (!header.isPublic && !header.isPrivate) {
+                ownTargetHeaders.push_back({ header.frameworkName, header.fileDirectory, header.fileName });
+                if (includeFlatEntriesForTargetBeingBuilt) {
+                    targetName.push_back({ header.frameworkName, header.fileDirectory, header.fileName });
                 }
+            }
+        }
 
-                pbxproj::PBX::FileReference::shared_ptr const &fileReference = std::static_pointer_cast <pbxproj::PBX::FileReference> (buildFile->fileRef());
-                std::string filePath = compilerEnvironment.expand(fileReference->resolve());
-                pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(Filesystem::GetDefaultUNSAFE(), _specManager, { pbxspec::Manager::AnyDomain() }, fileReference, filePath);
-                if (fileType == nullptr || (fileType->identifier() != "sourcecode.c.h" && fileType->identifier() != "sourcecode.cpp.h")) {
-                    continue;
-                }
-
-                std::string fileName = FSUtil::GetBaseName(filePath);
-                std::string fileDirectory = FSUtil::GetDirectoryName(filePath) + "/";
-                std::string frameworkName = projectTarget->productName() + "/" + fileName;
-
-                std::vector<std::string> const &attributes = buildFile->attributes();
-                bool isPublic  = std::find(attributes.begin(), attributes.end(), "Public") != attributes.end();
-                bool isPrivate = std::find(attributes.begin(), attributes.end(), "Private") != attributes.end();
-
-                if (projectTarget == target) {
-                    ownTargetHeaders.add(fileName, fileDirectory, fileName);
-
-                    if (!isPublic && !isPrivate) {
-                        ownTargetHeaders.add(frameworkName, fileDirectory, fileName);
-                        if (includeFlatEntriesForTargetBeingBuilt) {
-                            targetName.add(frameworkName, fileDirectory, fileName);
-                        }
-                    }
-                }
-
-                if (isPublic || isPrivate) {
-                    allTargetHeaders.add(frameworkName, fileDirectory, fileName);
-                    if (includeFrameworkEntriesForAllProductTypes) {
-                        targetName.add(frameworkName, fileDirectory, fileName);
-                    }
-
-                    // TODO(grp): This is a little messy. Maybe check the product type specification, or the product reference's file type?
-                    if (projectTarget->type() == pbxproj::PBX::Target::Type::Native && std::static_pointer_cast<pbxproj::PBX::NativeTarget>(projectTarget)->productType().find("framework") == std::string::npos) {
-                        allNonFrameworkTargetHeaders.add(frameworkName, fileDirectory, fileName);
-                        if (!includeFrameworkEntriesForAllProductTypes) {
-                            targetName.add(frameworkName, fileDirectory, fileName);
-                        }
-                    }
-                }
+        if (header.isPublic || header.isPrivate) {
+            if (includeFrameworkEntriesForAllProductTypes || header.isNonFramework) {
+                targetName.push_back({ header.frameworkName, header.fileDirectory, header.fileName });
             }
         }
     }
@@ -198,12 +252,12 @@ resolve(
     std::string headermapFileForProjectFiles                 = compilerEnvironment.resolve("CPP_HEADERMAP_FILE_FOR_PROJECT_FILES");
 
     std::vector<Tool::AuxiliaryFile> auxiliaryFiles = {
-        Tool::AuxiliaryFile::Data(headermapFile, targetName.write()),
-        Tool::AuxiliaryFile::Data(headermapFileForOwnTargetHeaders, ownTargetHeaders.write()),
-        Tool::AuxiliaryFile::Data(headermapFileForAllTargetHeaders, allTargetHeaders.write()),
-        Tool::AuxiliaryFile::Data(headermapFileForAllNonFrameworkTargetHeaders, allNonFrameworkTargetHeaders.write()),
-        Tool::AuxiliaryFile::Data(headermapFileForGeneratedFiles, generatedFiles.write()),
-        Tool::AuxiliaryFile::Data(headermapFileForProjectFiles, projectHeaders.write()),
+        Tool::AuxiliaryFile::Data(headermapFile, HeaderMapContents(targetName)),
+        Tool::AuxiliaryFile::Data(headermapFileForOwnTargetHeaders, HeaderMapContents(ownTargetHeaders)),
+        Tool::AuxiliaryFile::Data(headermapFileForAllTargetHeaders, projectHeaders->allTargetHeadersContents),
+        Tool::AuxiliaryFile::Data(headermapFileForAllNonFrameworkTargetHeaders, projectHeaders->allNonFrameworkTargetHeadersContents),
+        Tool::AuxiliaryFile::Data(headermapFileForGeneratedFiles, HeaderMapContents(generatedFiles)),
+        Tool::AuxiliaryFile::Data(headermapFileForProjectFiles, projectHeaders->projectHeadersContents),
     };
 
     toolContext->auxiliaryFiles().insert(toolContext->auxiliaryFiles().end(), auxiliaryFiles.begin(), auxiliaryFiles.end());
@@ -235,7 +289,7 @@ resolve(
 }
 
 std::unique_ptr<Tool::HeadermapResolver> Tool::HeadermapResolver::
-Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains, pbxspec::PBX::Compiler::shared_ptr const &compiler)
+Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains, pbxspec::PBX::Compiler::shared_ptr const &compiler, std::shared_ptr<FileTypeResolver> const &fileTypeResolver)
 {
     pbxspec::PBX::Tool::shared_ptr headermapTool = specManager->tool(Tool::HeadermapResolver::ToolIdentifier(), specDomains);
     if (headermapTool == nullptr) {
@@ -243,5 +297,5 @@ Create(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string>
         return nullptr;
     }
 
-    return std::unique_ptr<Tool::HeadermapResolver>(new Tool::HeadermapResolver(headermapTool, compiler, specManager));
+    return std::unique_ptr<Tool::HeadermapResolver>(new Tool::HeadermapResolver(headermapTool, compiler, specManager, fileTypeResolver));
 }
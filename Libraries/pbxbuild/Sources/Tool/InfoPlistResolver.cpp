@@ -63,6 +63,7 @@ resolve(
     environmentVariables.insert(buildSettingValues.begin(), buildSettingValues.end());
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
     invocation.arguments() = tokens.arguments();
     invocation.environment() = environmentVariables;
@@ -65,6 +65,7 @@ Determine(std::string const &executable)
 
 Tool::Invocation::
 Invocation() :
+    _environment            (std::make_shared<std::unordered_map<std::string, std::string>>()),
     _showEnvironmentInLog   (true),
     _createsProductStructure(false)
 {
@@ -75,3 +76,12 @@ Tool::Invocation::
 {
 }
 
+std::unordered_map<std::string, std::string> &Tool::Invocation::
+environment()
+{
+    if (_environment.use_count() > 1) {
+        _environment = std::make_shared<std::unordered_map<std::string, std::string>>(*_environment);
+    }
+    return *_environment;
+}
+
@@ -12,6 +12,7 @@
 #include <pbxbuild/Tool/Context.h>
 #include <pbxbuild/Tool/OptionsResult.h>
 #include <pbxbuild/Tool/Tokens.h>
+#include <pbxsetting/Type.h>
 #include <libutil/FSUtil.h>
 
 namespace Tool = pbxbuild::Tool;
@@ -43,6 +44,10 @@ resolve(
 
     special.insert(special.end(), additionalArguments.begin(), additionalArguments.end());
 
+    /*
+     * Pass the inputs in a file list rather than as arguments, so targets
+     * with many objects don't exceed the argument length limit.
+     */
     if (_linker->supportsInputFileList() || _linker->identifier() == Tool::LinkerResolver::LibtoolToolIdentifier()) {
         std::string path = environment.expand(pbxsetting::Value::Parse("$(LINK_FILE_LIST_$(variant)_$(arch))"));
         std::string contents;
@@ -108,6 +113,15 @@ resolve(
         }
     }
 
+    if (_linker->identifier() == Tool::LinkerResolver::LinkerToolIdentifier()) {
+        /* Let linkers that can, such as lld, link with several threads. */
+        int64_t threads = pbxsetting::Type::ParseInteger(environment.resolve("LD_THREADS"));
+        if (threads > 0) {
+            special.push_back("-Xlinker");
+            special.push_back("--threads=" + std::to_string(threads));
+        }
+    }
+
     pbxspec::PBX::Tool::shared_ptr tool = std::static_pointer_cast <pbxspec::PBX::Tool> (_linker);
     Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), inputFiles, { output });
     Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), nullptr);
@@ -120,15 +134,16 @@ resolve(
     }
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _linker->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
-    invocation.arguments() = arguments;
+    invocation.arguments() = std::move(arguments);
     invocation.environment() = options.environment();
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
     invocation.dependencyInfo() = dependencyInfo;
     invocation.logMessage() = tokens.logMessage();
-    toolContext->invocations().push_back(invocation);
+    toolContext->invocations().push_back(std::move(invocation));
 
     toolContext->auxiliaryFiles().insert(toolContext->auxiliaryFiles().end(), auxiliaries.begin(), auxiliaries.end());
 }
@@ -144,6 +144,15 @@ resolve(
     }
 }
 
+bool Tool::ModuleMapResolver::
+HasModuleMap(
+    pbxsetting::Environment const &environment,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    std::string const &workingDirectory)
+{
+    return static_cast<bool>(Contents(environment, target, workingDirectory));
+}
+
 std::unique_ptr<Tool::ModuleMapResolver> Tool::ModuleMapResolver::
 Create()
 {
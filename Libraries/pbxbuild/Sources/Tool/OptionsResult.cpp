@@ -15,6 +15,7 @@
 #include <plist/Dictionary.h>
 #include <plist/Object.h>
 #include <plist/String.h>
+#include <libutil/Filesystem.h>
 
 namespace Tool = pbxbuild::Tool;
 
@@ -84,9 +85,9 @@ AddOptionArgumentValues(std::vector<std::string> *arguments, pbxsetting::Environ
 {
     if ((option->type() == "StringList" || option->type() == "stringlist") ||
         (option->type() == "PathList" || option->type() == "pathlist")) {
-        std::vector<std::string> values = pbxsetting::Type::ParseList(environment.resolve(option->name()));
+        std::vector<std::string> values = environment.resolveList(option->name());
         if (option->flattenRecursiveSearchPathsInValue()) {
-            values = Tool::SearchPaths::ExpandRecursive(values, environment, workingDirectory);
+            values = Tool::SearchPaths::ExpandRecursive(libutil::Filesystem::GetDefaultUNSAFE(), values, environment, workingDirectory);
         }
 
         for (std::string const &value : values) {
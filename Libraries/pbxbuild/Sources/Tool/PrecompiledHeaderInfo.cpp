@@ -36,8 +36,13 @@ Tool::PrecompiledHeaderInfo::
 pbxsetting::Value Tool::PrecompiledHeaderInfo::
 logicalOutputPath() const
 {
-    pbxsetting::Value outputDirectory = pbxsetting::Value::Parse("$(PRECOMP_DESTINATION_DIR)/$(PRODUCT_NAME)-") + pbxsetting::Value::String(hash());
-    return outputDirectory + pbxsetting::Value::String("/" + FSUtil::GetBaseName(_prefixHeader));
+    /*
+     * Named only by what affects the precompiled header, so targets with the
+     * same prefix header and flags share it rather than each building their own.
+     */
+    std::string name = FSUtil::GetBaseName(_prefixHeader);
+    pbxsetting::Value outputDirectory = pbxsetting::Value::Parse("$(SHARED_PRECOMPS_DIR)/") + pbxsetting::Value::String(name + "-" + hash());
+    return outputDirectory + pbxsetting::Value::String("/" + name);
 }
 
 pbxsetting::Value Tool::PrecompiledHeaderInfo::
@@ -76,6 +81,8 @@ std::vector<uint8_t> Tool::PrecompiledHeaderInfo::
 serialize() const
 {
     std::string result;
+    result += _prefixHeader + "\n";
+    result += (_fileType != nullptr ? _fileType->identifier() : "") + "\n";
     for (std::string const &argument : _relevantArguments) {
         result += argument + "\n";
     }
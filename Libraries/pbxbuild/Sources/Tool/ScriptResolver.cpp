@@ -70,6 +70,7 @@ resolve(
     std::string fullWorkingDirectory = FSUtil::ResolveRelativePath(legacyTarget->buildWorkingDirectory(), toolContext->workingDirectory());
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(legacyTarget->buildToolPath());
     invocation.arguments() = pbxsetting::Type::ParseList(script);
     invocation.environment() = environmentVariables;
@@ -107,6 +108,10 @@ resolve(
         return FSUtil::ResolveRelativePath(path, toolContext->workingDirectory());
     });
 
+    if (outputFiles.empty()) {
+        fprintf(stderr, "warning: run script build phase '%s' will run during every build because it does not specify any outputs (in target '%s')\n", phaseEnvironment.resolve("BuildPhaseName").c_str(), environment.resolve("TARGET_NAME").c_str());
+    }
+
     std::string scriptFilePath = phaseEnvironment.expand(scriptPath);
     std::string contents = (!buildPhase->shellPath().empty() ? "#!" + buildPhase->shellPath() + "\n" : "") + buildPhase->shellScript();
     auto scriptFile = Tool::AuxiliaryFile::Data(scriptFilePath, std::vector<uint8_t>(contents.begin(), contents.end()), true);
@@ -116,10 +121,12 @@ resolve(
     std::unordered_map<std::string, std::string> environmentVariables = scriptEnvironment.computeValues(pbxsetting::Condition::Empty());
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::External("/bin/sh");
     invocation.arguments() = { "-c", Escape::Shell(scriptFilePath) };
     invocation.environment() = environmentVariables;
     invocation.workingDirectory() = toolContext->workingDirectory();
+    invocation.inputs() = { scriptFilePath }; /* Edits to the script run it again. */
     invocation.phonyInputs() = inputFiles; /* User-specified, may not exist. */
     invocation.outputs() = outputFiles;
     invocation.logMessage() = phaseEnvironment.expand(logMessage);
@@ -179,6 +186,7 @@ resolve(
     std::unordered_map<std::string, std::string> environmentVariables = ruleEnvironment.computeValues(pbxsetting::Condition::Empty());
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::External("/bin/sh");
     invocation.arguments() = { "-c", buildRule->script() };
     invocation.environment() = environmentVariables;
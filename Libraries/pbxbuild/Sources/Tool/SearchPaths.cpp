@@ -9,14 +9,17 @@
 
 #include <pbxbuild/Tool/SearchPaths.h>
 #include <pbxbuild/Tool/Context.h>
+#include <pbxbuild/DirectoryCache.h>
 #include <pbxsetting/Environment.h>
-#include <pbxsetting/Type.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Wildcard.h>
 
 namespace Tool = pbxbuild::Tool;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Wildcard;
+using pbxbuild::DirectoryCache;
 
 Tool::SearchPaths::
 SearchPaths(
@@ -31,11 +34,47 @@ SearchPaths(
 {
 }
 
+static bool
+MatchesAny(std::vector<std::string> const &patterns, std::string const &name)
+{
+    for (std::string const &pattern : patterns) {
+        if (Wildcard::Match(pattern, name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static void
-AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &environment, std::string const &workingDirectory, std::vector<std::string> const &paths)
+AppendSubdirectories(
+    std::vector<std::string> *args,
+    Filesystem const *filesystem,
+    DirectoryCache *directoryCache,
+    std::vector<std::string> const &included,
+    std::vector<std::string> const &excluded,
+    std::string const &path)
 {
-    Filesystem const *filesystem = Filesystem::GetDefaultUNSAFE();
+    for (DirectoryCache::Entry const &entry : *directoryCache->read(filesystem, path)) {
+        if (entry.type() != Filesystem::Type::Directory) {
+            continue;
+        }
 
+        /* Skip excluded directories and their contents, unless included. */
+        if (MatchesAny(excluded, entry.name()) && !MatchesAny(included, entry.name())) {
+            continue;
+        }
+
+        // TODO(grp): Follow symbolic links for RECURSIVE_SEARCH_PATHS_FOLLOW_SYMLINKS.
+        std::string subdirectory = path + "/" + entry.name();
+        args->push_back(subdirectory);
+        AppendSubdirectories(args, filesystem, directoryCache, included, excluded, subdirectory);
+    }
+}
+
+static void
+AppendPaths(std::vector<std::string> *args, Filesystem const *filesystem, pbxsetting::Environment const &environment, std::string const &workingDirectory, DirectoryCache *directoryCache, std::vector<std::string> const &paths)
+{
     for (std::string path : paths) {
         // TODO(grp): Is this the right place to insert the SDKROOT? Should all path lists have this, or just *_SEARCH_PATHS?
         std::string const system = "/System";
@@ -55,19 +94,16 @@ AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &envir
             std::string root = path.substr(0, path.size() - recursive.size());
             args->push_back(root);
 
-            std::string absoluteRoot = FSUtil::ResolveRelativePath(root, workingDirectory);
-            filesystem->readDirectory(absoluteRoot, true, [&](std::string const &relative) -> bool {
-                // TODO(grp): Use build settings for included and excluded recursive paths.
-                // Included: INCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
-                // Excluded: EXCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
-                // Follow: RECURSIVE_SEARCH_PATHS_FOLLOW_SYMLINKS
-
-                std::string absolute = absoluteRoot + "/" + relative;
-                if (filesystem->type(absolute) == Filesystem::Type::Directory) {
-                    args->push_back(relative);
-                }
-                return true;
-            });
+            /*
+             * Add each subdirectory, skipping the contents of excluded
+             * directories entirely rather than filtering them afterwards.
+             */
+            std::vector<std::string> included = environment.resolveList("INCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES");
+            std::vector<std::string> excluded = environment.resolveList("EXCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES");
+
+            DirectoryCache localDirectoryCache;
+            std::string absoluteRoot = FSUtil::NormalizePath(FSUtil::ResolveRelativePath(root, workingDirectory));
+            AppendSubdirectories(args, filesystem, (directoryCache != nullptr ? directoryCache : &localDirectoryCache), included, excluded, absoluteRoot);
         } else {
             args->push_back(path);
         }
@@ -75,29 +111,29 @@ AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &envir
 }
 
 std::vector<std::string> Tool::SearchPaths::
-ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory)
+ExpandRecursive(Filesystem const *filesystem, std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory, DirectoryCache *directoryCache)
 {
     std::vector<std::string> result;
-    AppendPaths(&result, environment, workingDirectory, paths);
+    AppendPaths(&result, filesystem, environment, workingDirectory, directoryCache, paths);
     return result;
 }
 
 Tool::SearchPaths Tool::SearchPaths::
-Create(pbxsetting::Environment const &environment, std::string const &workingDirectory)
+Create(Filesystem const *filesystem, pbxsetting::Environment const &environment, std::string const &workingDirectory, DirectoryCache *directoryCache)
 {
     std::vector<std::string> headerSearchPaths;
-    AppendPaths(&headerSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_HEADER_SEARCH_PATHS")));
-    AppendPaths(&headerSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("HEADER_SEARCH_PATHS")));
+    AppendPaths(&headerSearchPaths, filesystem, environment, workingDirectory, directoryCache, environment.resolveList("PRODUCT_TYPE_HEADER_SEARCH_PATHS"));
+    AppendPaths(&headerSearchPaths, filesystem, environment, workingDirectory, directoryCache, environment.resolveList("HEADER_SEARCH_PATHS"));
 
     std::vector<std::string> userHeaderSearchPaths;
-    AppendPaths(&userHeaderSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("USER_HEADER_SEARCH_PATHS")));
+    AppendPaths(&userHeaderSearchPaths, filesystem, environment, workingDirectory, directoryCache, environment.resolveList("USER_HEADER_SEARCH_PATHS"));
 
     std::vector<std::string> frameworkSearchPaths;
-    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("FRAMEWORK_SEARCH_PATHS")));
-    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_FRAMEWORK_SEARCH_PATHS")));
+    AppendPaths(&frameworkSearchPaths, filesystem, environment, workingDirectory, directoryCache, environment.resolveList("FRAMEWORK_SEARCH_PATHS"));
+    AppendPaths(&frameworkSearchPaths, filesystem, environment, workingDirectory, directoryCache, environment.resolveList("PRODUCT_TYPE_FRAMEWORK_SEARCH_PATHS"));
 
     std::vector<std::string> librarySearchPaths;
-    AppendPaths(&librarySearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("LIBRARY_SEARCH_PATHS")));
+    AppendPaths(&librarySearchPaths, filesystem, environment, workingDirectory, directoryCache, environment.resolveList("LIBRARY_SEARCH_PATHS"));
 
     return Tool::SearchPaths(headerSearchPaths, userHeaderSearchPaths, frameworkSearchPaths, librarySearchPaths);
 }
@@ -13,6 +13,7 @@
 #include <pbxbuild/Tool/OptionsResult.h>
 #include <pbxbuild/Tool/Tokens.h>
 #include <pbxbuild/Tool/Context.h>
+#include <pbxbuild/Build/Jobs.h>
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
 #include <xcsdk/SDK/Platform.h>
@@ -23,7 +24,11 @@
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+#include <map>
+
 namespace Tool = pbxbuild::Tool;
+namespace Build = pbxbuild::Build;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
@@ -34,7 +39,7 @@ SwiftResolver(pbxspec::PBX::Compiler::shared_ptr const &compiler) :
 }
 
 static std::string
-SwiftLibraryPath(pbxsetting::Environment const &environment, xcsdk::SDK::Target::shared_ptr const &sdk, std::vector<xcsdk::SDK::Toolchain::shared_ptr> const &toolchains)
+SwiftLibraryPath(Filesystem const *filesystem, pbxsetting::Environment const &environment, xcsdk::SDK::Target::shared_ptr const &sdk, std::vector<xcsdk::SDK::Toolchain::shared_ptr> const &toolchains)
 {
     std::string path = environment.resolve("SWIFT_LIBRARY_PATH");
     if (!path.empty()) {
@@ -62,7 +67,7 @@ SwiftLibraryPath(pbxsetting::Environment const &environment, xcsdk::SDK::Target:
             std::string path = toolchain->path() + "/" + "usr" + "/" + "lib" + "/" + subpath;
 
             /* If the Swift library exists, return the directory containing it. */
-            if (Filesystem::GetDefaultUNSAFE()->exists(path)) {
+            if (filesystem->exists(path)) {
                 return FSUtil::GetDirectoryName(path);
             }
         }
@@ -100,8 +105,19 @@ AppendOutputs(
     module->set("swift-dependencies", plist::String::New(moduleDependencies));
     outputInfo->set("", std::move(module));
 
+    /*
+     * Arguments and outputs keep the order of the phase, which is also the
+     * order objects are linked in. The output map is ordered by path, so it
+     * only changes when the sources do, not when they are reordered.
+     */
+    std::map<std::string, std::unique_ptr<plist::Dictionary>> inputOutputInfo;
+
     for (Tool::Input const &input : inputs) {
+        /* Sources with the same name would otherwise share their outputs. */
         std::string name = FSUtil::GetBaseNameWithoutExtension(input.path());
+        if (input.fileNameDisambiguator()) {
+            name = *input.fileNameDisambiguator();
+        }
 
         /* Add input argument. */
         args->push_back(input.path());
@@ -141,7 +157,11 @@ AppendOutputs(
         dict->set("diagnostics", plist::String::New(diagnostics));
         dict->set("dependencies", plist::String::New(dependencies));
         dict->set("swift-dependencies", plist::String::New(swiftDependencies));
-        outputInfo->set(input.path(), std::move(dict));
+        inputOutputInfo[input.path()] = std::move(dict);
+    }
+
+    for (auto &entry : inputOutputInfo) {
+        outputInfo->set(entry.first, std::move(entry.second));
     }
 
     /* Serialize output map as JSON. */
@@ -182,13 +202,13 @@ AppendPathFlags(std::vector<std::string> *args, pbxsetting::Environment const &e
     std::vector<std::string> specialIncludes = { environment.resolve("BUILT_PRODUCTS_DIR") };
     Tool::CompilerCommon::AppendCompoundFlags(args, "-I", false, specialIncludes);
 
-    std::vector<std::string> includes = pbxsetting::Type::ParseList(environment.resolve("SWIFT_INCLUDE_PATHS"));
+    std::vector<std::string> includes = environment.resolveList("SWIFT_INCLUDE_PATHS");
     Tool::CompilerCommon::AppendCompoundFlags(args, "-I", false, includes);
 
     std::vector<std::string> specialFrameworks = { environment.resolve("BUILT_PRODUCTS_DIR") };
     Tool::CompilerCommon::AppendCompoundFlags(args, "-F", false, specialFrameworks);
 
-    std::vector<std::string> frameworks = pbxsetting::Type::ParseList(environment.resolve("FRAMEWORK_SEARCH_PATHS"));
+    std::vector<std::string> frameworks = environment.resolveList("FRAMEWORK_SEARCH_PATHS");
     Tool::CompilerCommon::AppendCompoundFlags(args, "-F", false, frameworks);
 }
 
@@ -201,7 +221,7 @@ AppendCcFlags(std::vector<std::string> *args, pbxsetting::Environment const &env
     Tool::CompilerCommon::AppendIncludePathFlags(&arguments, environment, searchPaths, headermapInfo);
 
     /* Add definitions. */
-    std::vector<std::string> definitions = pbxsetting::Type::ParseList(environment.resolve("GCC_PREPROCESSOR_DEFINITIONS"));
+    std::vector<std::string> definitions = environment.resolveList("GCC_PREPROCESSOR_DEFINITIONS");
     Tool::CompilerCommon::AppendCompoundFlags(&arguments, "-D", true, definitions);
 
     /* Add flags prefixed with -Xcc. */
@@ -349,15 +369,30 @@ resolve(
     /* Compile object files. */
     arguments.push_back("-c");
 
-    /* Enable parallelization. */
+    /* Enable parallelization, within this compile's share of the build's jobs. */
+    std::string threads = std::to_string(Build::Jobs::SwiftThreads(environment));
     bool wholeModuleOptimization = (pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_WHOLE_MODULE_OPTIMIZATION")) || environment.resolve("SWIFT_OPTIMIZATION_LEVEL") == "-Owholemodule");
     if (!wholeModuleOptimization || !pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_USE_PARALLEL_WHOLE_MODULE_OPTIMIZATION"))) {
-        // TODO(grp): Get the number of parallel build tasks here.
-        arguments.push_back("-j8");
+        arguments.push_back("-j" + threads);
     } else {
-        // TODO(grp): Get the number of parallel build tasks here.
         arguments.push_back("-num-threads");
-        arguments.push_back("8");
+        arguments.push_back(threads);
+    }
+
+    /*
+     * Compile only what changed since the last build, as recorded in the
+     * build record; batch mode also compiles several files per frontend.
+     * Whole module builds compile everything at once, so neither applies.
+     */
+    if (!wholeModuleOptimization) {
+        std::string incremental = environment.resolve("SWIFT_ENABLE_INCREMENTAL_COMPILATION");
+        if ((incremental.empty() || pbxsetting::Type::ParseBoolean(incremental)) && std::find(arguments.begin(), arguments.end(), "-incremental") == arguments.end()) {
+            arguments.push_back("-incremental");
+        }
+
+        if (pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_ENABLE_BATCH_MODE")) && std::find(arguments.begin(), arguments.end(), "-enable-batch-mode") == arguments.end()) {
+            arguments.push_back("-enable-batch-mode");
+        }
     }
 
     /*
@@ -396,6 +431,7 @@ resolve(
      * Add the invocation.
      */
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _compiler->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
     invocation.arguments() = arguments;
     invocation.environment() = options.environment();
@@ -439,7 +475,7 @@ resolve(
     // TODO(grp): For multi-arch builds the below flags get added twice.
 
     /* Add Swift libraries to linker arguments. */
-    std::string swiftLibraryPath = SwiftLibraryPath(environment, toolContext->sdk(), toolContext->toolchains());
+    std::string swiftLibraryPath = SwiftLibraryPath(toolContext->filesystem(), environment, toolContext->sdk(), toolContext->toolchains());
     if (!swiftLibraryPath.empty()) {
         compilationInfo->linkerArguments().push_back("-L" + swiftLibraryPath);
     } else {
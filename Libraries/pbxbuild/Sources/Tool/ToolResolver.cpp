@@ -51,6 +51,7 @@ resolve(
     }
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
     invocation.arguments() = tokens.arguments();
     invocation.environment() = options.environment();
@@ -76,6 +77,7 @@ resolve(
     std::string const &resolvedLogMessage = (!logMessage.empty() ? logMessage : tokens.logMessage());
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
     invocation.arguments() = tokens.arguments();
     invocation.environment() = options.environment();
@@ -42,6 +42,7 @@ resolve(
     }
 
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.executable() = Tool::Invocation::Executable::External("/usr/bin/touch");
     invocation.arguments() = { "-c", input };
     invocation.workingDirectory() = toolContext->workingDirectory();
@@ -11,11 +11,16 @@
 #include <pbxsetting/Environment.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
 
 using pbxbuild::WorkspaceContext;
 using pbxbuild::DerivedDataHash;
+using pbxbuild::TargetIndex;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 WorkspaceContext::
 WorkspaceContext(
@@ -32,7 +37,8 @@ WorkspaceContext(
     _project        (project),
     _schemeGroups   (schemeGroups),
     _projects       (projects),
-    _configs        (configs)
+    _configs        (configs),
+    _targetIndex    (std::make_shared<TargetIndex const>(TargetIndex::Create(projects)))
 {
 }
 
@@ -93,8 +99,9 @@ loadedFilePaths() const
      * Add all schemes' data paths.
      */
     for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup : _schemeGroups) {
-        for (xcscheme::XC::Scheme::shared_ptr const &scheme : schemeGroup->schemes()) {
-            loadedFilePaths.push_back(scheme->path());
+        /* Including schemes not parsed, since they could be used later. */
+        for (std::string const &schemePath : schemeGroup->schemePaths()) {
+            loadedFilePaths.push_back(schemePath);
         }
     }
 
@@ -108,6 +115,64 @@ loadedFilePaths() const
     return loadedFilePaths;
 }
 
+void WorkspaceContext::
+saveProjectSnapshots(Filesystem *filesystem, pbxsetting::Environment const &baseEnvironment) const
+{
+    for (auto const &entry : _projects) {
+        std::string snapshotPath = ProjectSnapshotPath(filesystem, baseEnvironment, entry.second->projectFile());
+        if (!snapshotPath.empty()) {
+            entry.second->saveSnapshot(filesystem, snapshotPath);
+        }
+    }
+}
+
+std::string WorkspaceContext::
+ProjectSnapshotPath(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvironment, std::string const &projectPath)
+{
+    std::string derivedDataDirectory = baseEnvironment.resolve("DERIVED_DATA_DIR");
+    std::string resolvedPath = filesystem->resolvePath(projectPath);
+    if (derivedDataDirectory.empty() || resolvedPath.empty()) {
+        return std::string();
+    }
+
+    /* Named like the project's own build directory, so each project has one. */
+    DerivedDataHash derivedDataHash = DerivedDataHash::Create(resolvedPath);
+    return derivedDataDirectory + "/" + derivedDataHash.derivedDataHash() + "/Snapshots/project.pbxproj";
+}
+
+std::string WorkspaceContext::
+fileTypeCachePath(pbxsetting::Environment const &baseEnvironment) const
+{
+    std::string derivedDataDirectory = baseEnvironment.resolve("DERIVED_DATA_DIR");
+    if (derivedDataDirectory.empty()) {
+        return std::string();
+    }
+
+    return derivedDataDirectory + "/" + _derivedDataHash.derivedDataHash() + "/Snapshots/FileTypes";
+}
+
+/*
+ * Each file loaded is an independent parse, so they can be loaded at the
+ * same time; results are kept by index to preserve the order they would
+ * be loaded in one at a time.
+ */
+static void
+OpenProjects(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvironment, std::vector<pbxproj::PBX::Project::shared_ptr> *projects, std::vector<std::string> const &paths)
+{
+    std::vector<pbxproj::PBX::Project::shared_ptr> opened = std::vector<pbxproj::PBX::Project::shared_ptr>(paths.size());
+    Parallel::For(Parallel::DefaultJobs(), paths.size(), [&](size_t n) {
+        /* Only the targets that are built need their build phases. */
+        std::string snapshotPath = WorkspaceContext::ProjectSnapshotPath(filesystem, baseEnvironment, paths[n]);
+        opened[n] = pbxproj::PBX::Project::Open(filesystem, paths[n], true, snapshotPath);
+    });
+
+    for (pbxproj::PBX::Project::shared_ptr const &project : opened) {
+        if (project != nullptr) {
+            projects->push_back(project);
+        }
+    }
+}
+
 static void
 IterateWorkspaceItem(xcworkspace::XC::GroupItem::shared_ptr const &item, std::function<void(xcworkspace::XC::FileRef::shared_ptr const &)> const &cb)
 {
@@ -136,25 +201,22 @@ IterateWorkspaceFiles(xcworkspace::XC::Workspace::shared_ptr const &workspace, s
 }
 
 static void
-LoadWorkspaceProjects(Filesystem const *filesystem, std::vector<pbxproj::PBX::Project::shared_ptr> *projects, xcworkspace::XC::Workspace::shared_ptr const &workspace)
+LoadWorkspaceProjects(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvironment, std::vector<pbxproj::PBX::Project::shared_ptr> *projects, xcworkspace::XC::Workspace::shared_ptr const &workspace)
 {
+    std::vector<std::string> paths;
+    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
+        paths.push_back(ref->resolve(workspace));
+    });
+
     /*
      * Load all the projects in the workspace.
      */
-    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
-        std::string path = ref->resolve(workspace);
-
-        pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, path);
-        if (project != nullptr) {
-            projects->push_back(project);
-        }
-    });
+    OpenProjects(filesystem, baseEnvironment, projects, paths);
 }
 
 static void
-LoadConfigurationFiles(
-    Filesystem const *filesystem,
-    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> *configs,
+FindConfigurationFiles(
+    std::vector<std::pair<pbxproj::XC::BuildConfiguration::shared_ptr, std::string>> *configurationFiles,
     pbxsetting::Environment const &environment,
     pbxproj::XC::ConfigurationList::shared_ptr const &configurationList)
 {
@@ -163,16 +225,12 @@ LoadConfigurationFiles(
     }
 
     /*
-     * Load all configuration files in the list.
+     * Find all configuration files in the list.
      */
     for (pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration : configurationList->buildConfigurations()) {
         if (pbxproj::PBX::FileReference::shared_ptr const &configurationReference = buildConfiguration->baseConfigurationReference()) {
             std::string configurationPath = environment.expand(configurationReference->resolve());
-
-            /* Load the configuration file. */
-            if (ext::optional<pbxsetting::XC::Config> configuration = pbxsetting::XC::Config::Load(filesystem, environment, configurationPath)) {
-                configs->insert({ buildConfiguration, *configuration });
-            }
+            configurationFiles->push_back({ buildConfiguration, configurationPath });
         }
     }
 }
@@ -182,29 +240,36 @@ LoadNestedProjects(
     Filesystem const *filesystem,
     std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> *configs,
+    pbxsetting::XC::Config::Cache *configCache,
     pbxsetting::Environment const &baseEnvironment,
     std::vector<pbxproj::PBX::Project::shared_ptr> const &rootProjects)
 {
-    std::vector<pbxproj::PBX::Project::shared_ptr> nestedProjects;
+    std::vector<ext::optional<pbxsetting::Environment>> projectEnvironments = std::vector<ext::optional<pbxsetting::Environment>>(rootProjects.size());
+    std::vector<std::vector<std::pair<pbxproj::XC::BuildConfiguration::shared_ptr, std::string>>> projectConfigurationFiles =
+        std::vector<std::vector<std::pair<pbxproj::XC::BuildConfiguration::shared_ptr, std::string>>>(rootProjects.size());
+    std::vector<std::vector<std::string>> projectPaths = std::vector<std::vector<std::string>>(rootProjects.size());
 
     /*
      * Load all nested projects recursively.
      */
-    for (pbxproj::PBX::Project::shared_ptr const &project : rootProjects) {
+    Parallel::For(Parallel::DefaultJobs(), rootProjects.size(), [&](size_t n) {
+        pbxproj::PBX::Project::shared_ptr const &project = rootProjects[n];
+
         /*
          * Determine the settings environment to find the project paths. This may not be complete,
          * but it's unclear exactly what settings are available here. Notably, we don't yet know what
          * the configuration or what target to use, so just the project settings seems reasonable.
          */
-        pbxsetting::Environment environment = pbxsetting::Environment(baseEnvironment);
+        projectEnvironments[n] = pbxsetting::Environment(baseEnvironment);
+        pbxsetting::Environment &environment = *projectEnvironments[n];
         environment.insertFront(project->settings(), false);
 
         /*
-         * Load project and target configurations.
+         * Find project and target configurations.
          */
-        LoadConfigurationFiles(filesystem, configs, environment, project->buildConfigurationList());
+        FindConfigurationFiles(&projectConfigurationFiles[n], environment, project->buildConfigurationList());
         for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
-            LoadConfigurationFiles(filesystem, configs, environment, target->buildConfigurationList());
+            FindConfigurationFiles(&projectConfigurationFiles[n], environment, target->buildConfigurationList());
         }
 
         /*
@@ -212,18 +277,47 @@ LoadNestedProjects(
          */
         for (pbxproj::PBX::Project::ProjectReference const &projectReference : project->projectReferences()) {
             pbxproj::PBX::FileReference::shared_ptr const &projectFileReference = projectReference.projectReference();
-            std::string projectPath = environment.expand(projectFileReference->resolve());
-
-            /*
-             * Load the project.
-             */
-            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, projectPath);
-            if (project != nullptr) {
-                nestedProjects.push_back(project);
-            }
+            projectPaths[n].push_back(environment.expand(projectFileReference->resolve()));
+        }
+    });
+
+    /*
+     * Load the configuration files. Many build configurations usually share
+     * the same files, or include the same files, so each loaded file is kept
+     * and only loaded once. Files not yet loaded are loaded in parallel.
+     */
+    std::vector<std::pair<size_t, size_t>> configurationIndexes;
+    for (size_t n = 0; n < rootProjects.size(); ++n) {
+        for (size_t m = 0; m < projectConfigurationFiles[n].size(); ++m) {
+            configurationIndexes.push_back({ n, m });
+        }
+    }
+
+    std::vector<ext::optional<pbxsetting::XC::Config>> configurations = std::vector<ext::optional<pbxsetting::XC::Config>>(configurationIndexes.size());
+    Parallel::For(Parallel::DefaultJobs(), configurationIndexes.size(), [&](size_t n) {
+        std::pair<size_t, size_t> const &index = configurationIndexes[n];
+        std::string const &configurationPath = projectConfigurationFiles[index.first][index.second].second;
+        configurations[n] = pbxsetting::XC::Config::Load(filesystem, *projectEnvironments[index.first], configurationPath, configCache);
+    });
+
+    for (size_t n = 0; n < configurationIndexes.size(); ++n) {
+        if (configurations[n]) {
+            std::pair<size_t, size_t> const &index = configurationIndexes[n];
+            configs->insert({ projectConfigurationFiles[index.first][index.second].first, *configurations[n] });
         }
     }
 
+    std::vector<std::string> nestedPaths;
+    for (size_t n = 0; n < rootProjects.size(); ++n) {
+        nestedPaths.insert(nestedPaths.end(), projectPaths[n].begin(), projectPaths[n].end());
+    }
+
+    /*
+     * Load the projects.
+     */
+    std::vector<pbxproj::PBX::Project::shared_ptr> nestedProjects;
+    OpenProjects(filesystem, baseEnvironment, &nestedProjects, nestedPaths);
+
     /*
      * Append the nested projects. This has to be after the loop as `rootProjects` might alias `projects`.
      */
@@ -233,18 +327,24 @@ LoadNestedProjects(
         /*
          * Load nested projects of the nested projects.
          */
-        LoadNestedProjects(filesystem, projects, configs, baseEnvironment, nestedProjects);
+        LoadNestedProjects(filesystem, projects, configs, configCache, baseEnvironment, nestedProjects);
     }
 }
 
 static void
 LoadProjectSchemes(Filesystem const *filesystem, std::string const &userName, std::vector<xcscheme::SchemeGroup::shared_ptr> *schemeGroups, std::vector<pbxproj::PBX::Project::shared_ptr> const &projects)
 {
+    std::vector<xcscheme::SchemeGroup::shared_ptr> projectGroups = std::vector<xcscheme::SchemeGroup::shared_ptr>(projects.size());
+
     /*
-     * Load the schemes inside the projects.
+     * List the schemes inside the projects; each is parsed when used.
      */
-    for (pbxproj::PBX::Project::shared_ptr const &project : projects) {
-        xcscheme::SchemeGroup::shared_ptr projectGroup = xcscheme::SchemeGroup::Open(filesystem, userName, project->basePath(), project->projectFile(), project->name());
+    Parallel::For(Parallel::DefaultJobs(), projects.size(), [&](size_t n) {
+        pbxproj::PBX::Project::shared_ptr const &project = projects[n];
+        projectGroups[n] = xcscheme::SchemeGroup::Open(filesystem, userName, project->basePath(), project->projectFile(), project->name());
+    });
+
+    for (xcscheme::SchemeGroup::shared_ptr const &projectGroup : projectGroups) {
         if (projectGroup != nullptr) {
             schemeGroups->push_back(projectGroup);
         }
@@ -283,12 +383,13 @@ Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting:
     /*
      * Load projects within the workspace.
      */
-    LoadWorkspaceProjects(filesystem, &projects, workspace);
+    LoadWorkspaceProjects(filesystem, baseEnvironment, &projects, workspace);
 
     /*
      * Recursively load nested projects within those projects.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    pbxsetting::XC::Config::Cache configCache;
+    LoadNestedProjects(filesystem, &projects, &configs, &configCache, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including nested projects.
@@ -318,7 +419,8 @@ Project(Filesystem const *filesystem, std::string const &userName, pbxsetting::E
     /*
      * Recursively load nested projects within the project.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    pbxsetting::XC::Config::Cache configCache;
+    LoadNestedProjects(filesystem, &projects, &configs, &configCache, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including the root and nested projects.
@@ -0,0 +1,79 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Target/BuildRules.h>
+#include <libutil/MemoryFilesystem.h>
+
+namespace Target = pbxbuild::Target;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static pbxspec::Manager::shared_ptr
+CreateManager()
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Specifications", {
+            MemoryFilesystem::Entry::File("FileTypes.xcspec", Contents(
+                "("
+                "    { Identifier = file; Type = FileType; },"
+                "    { Identifier = text; Type = FileType; BasedOn = file; },"
+                "    { Identifier = sourcecode.c.c; Type = FileType; BasedOn = text; },"
+                "    { Identifier = text.script; Type = FileType; BasedOn = text; },"
+                ")")),
+        }),
+    });
+
+    pbxspec::Manager::shared_ptr manager = pbxspec::Manager::Create();
+    manager->registerDomains(&filesystem, { { "default", "/Specifications" } });
+    return manager;
+}
+
+static Target::BuildRules::BuildRule::shared_ptr
+Rule(std::string const &filePatterns, pbxspec::PBX::FileType::vector const &fileTypes)
+{
+    return std::make_shared<Target::BuildRules::BuildRule>(filePatterns, fileTypes, nullptr, std::string(), std::vector<pbxsetting::Value>());
+}
+
+TEST(BuildRules, Resolve)
+{
+    pbxspec::Manager::shared_ptr manager = CreateManager();
+    pbxspec::PBX::FileType::shared_ptr file = manager->fileType("file", { "default" });
+    pbxspec::PBX::FileType::shared_ptr text = manager->fileType("text", { "default" });
+    pbxspec::PBX::FileType::shared_ptr c = manager->fileType("sourcecode.c.c", { "default" });
+    pbxspec::PBX::FileType::shared_ptr script = manager->fileType("text.script", { "default" });
+    ASSERT_NE(nullptr, script);
+
+    Target::BuildRules::BuildRule::vector rules = {
+        Rule("*.y", { }),
+        Rule(std::string(), { c }),
+        Rule("special.c", { }),
+        Rule(std::string(), { text }),
+        Rule("[ab].c", { }),
+    };
+    Target::BuildRules buildRules = Target::BuildRules(rules);
+
+    EXPECT_EQ(rules[0], buildRules.resolve(file, "/src/parse.y"));
+    EXPECT_EQ(rules[1], buildRules.resolve(c, "/src/main.c"));
+
+    /* Earlier rules take precedence over later ones that also match. */
+    EXPECT_EQ(rules[1], buildRules.resolve(c, "/src/special.c"));
+    EXPECT_EQ(rules[1], buildRules.resolve(c, "/src/a.c"));
+    EXPECT_EQ(rules[2], buildRules.resolve(file, "/src/special.c"));
+    EXPECT_EQ(rules[4], buildRules.resolve(file, "/src/b.c"));
+
+    /* File types match rules for the types they are based on. */
+    EXPECT_EQ(rules[3], buildRules.resolve(script, "/src/run.sh"));
+    EXPECT_EQ(nullptr, buildRules.resolve(file, "/src/other"));
+}
@@ -0,0 +1,42 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/CompactGraph.h>
+
+using pbxbuild::CompactGraph;
+
+TEST(CompactGraph, Adjacent)
+{
+    CompactGraph graph = CompactGraph(4, { { 2, 1 }, { 0, 3 }, { 2, 0 }, { 0, 1 }, { 2, 1 } });
+    EXPECT_EQ(4, graph.size());
+
+    EXPECT_EQ(std::vector<size_t>({ 3, 1 }), std::vector<size_t>(graph.adjacent(0).begin(), graph.adjacent(0).end()));
+    EXPECT_TRUE(graph.adjacent(1).empty());
+    EXPECT_EQ(std::vector<size_t>({ 1, 0 }), std::vector<size_t>(graph.adjacent(2).begin(), graph.adjacent(2).end()));
+    EXPECT_TRUE(graph.adjacent(3).empty());
+}
+
+TEST(CompactGraph, Ordered)
+{
+    CompactGraph graph = CompactGraph(5, { { 0, 4 }, { 1, 3 }, { 3, 4 }, { 2, 0 } });
+
+    ext::optional<std::vector<size_t>> ordered = graph.ordered();
+    ASSERT_TRUE(ordered);
+    EXPECT_EQ(std::vector<size_t>({ 4, 0, 2, 3, 1 }), *ordered);
+}
+
+TEST(CompactGraph, Cycle)
+{
+    CompactGraph graph = CompactGraph(3, { { 0, 1 }, { 1, 2 }, { 2, 0 } });
+    EXPECT_FALSE(graph.ordered());
+
+    CompactGraph self = CompactGraph(2, { { 1, 1 } });
+    EXPECT_FALSE(self.ordered());
+}
@@ -0,0 +1,55 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/DirectoryCache.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxbuild::DirectoryCache;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+TEST(DirectoryCache, Read)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("root", {
+            MemoryFilesystem::Entry::File("b", { }),
+            MemoryFilesystem::Entry::Directory("a", {
+                MemoryFilesystem::Entry::File("nested", { }),
+            }),
+        }),
+    });
+
+    DirectoryCache directoryCache;
+    std::shared_ptr<std::vector<DirectoryCache::Entry> const> entries = directoryCache.read(&filesystem, "/root");
+    ASSERT_EQ(2, entries->size());
+    EXPECT_EQ("a", (*entries)[0].name());
+    EXPECT_EQ(Filesystem::Type::Directory, (*entries)[0].type());
+    EXPECT_EQ("b", (*entries)[1].name());
+    EXPECT_EQ(Filesystem::Type::File, (*entries)[1].type());
+
+    /* Missing directories have no entries. */
+    EXPECT_TRUE(directoryCache.read(&filesystem, "/missing")->empty());
+}
+
+TEST(DirectoryCache, Cached)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("root", {
+            MemoryFilesystem::Entry::File("file", { }),
+        }),
+    });
+
+    DirectoryCache directoryCache;
+    EXPECT_EQ(1, directoryCache.read(&filesystem, "/root")->size());
+
+    /* Later changes aren't seen for the rest of the build. */
+    EXPECT_TRUE(filesystem.createFile("/root/other"));
+    EXPECT_EQ(1, directoryCache.read(&filesystem, "/root")->size());
+}
@@ -0,0 +1,84 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/FileTypeCache.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxbuild::FileTypeCache;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+TEST(FileTypeCache, FindUnchanged)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("script", { '#', '!' }),
+        MemoryFilesystem::Entry::Directory("Bundle.framework", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    FileTypeCache cache;
+    EXPECT_FALSE(cache.find(&filesystem, "/script"));
+
+    cache.insert(&filesystem, "/script", "text.script");
+    cache.insert(&filesystem, "/Bundle.framework", "wrapper.framework");
+    EXPECT_EQ("text.script", cache.find(&filesystem, "/script").value_or(""));
+    EXPECT_EQ("wrapper.framework", cache.find(&filesystem, "/Bundle.framework").value_or(""));
+}
+
+TEST(FileTypeCache, FindChanged)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("script", { '#', '!' }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    FileTypeCache cache;
+    cache.insert(&filesystem, "/script", "text.script");
+
+    filesystem.setStamp(Filesystem::Stamp({ 3, 2 }));
+    EXPECT_FALSE(cache.find(&filesystem, "/script"));
+
+    /* Removed once changed, even if changed back. */
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+    EXPECT_FALSE(cache.find(&filesystem, "/script"));
+}
+
+TEST(FileTypeCache, InsertMissing)
+{
+    auto filesystem = MemoryFilesystem({ });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    /* Missing files have nothing to tell if they change. */
+    FileTypeCache cache;
+    cache.insert(&filesystem, "/missing.c", "sourcecode.c.c");
+    EXPECT_FALSE(cache.find(&filesystem, "/missing.c"));
+}
+
+TEST(FileTypeCache, SaveLoad)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("script", { '#', '!' }),
+        MemoryFilesystem::Entry::Directory("Bundle.framework", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    FileTypeCache cache;
+    cache.insert(&filesystem, "/script", "text.script");
+    cache.insert(&filesystem, "/Bundle.framework", "wrapper.framework");
+    ASSERT_TRUE(cache.save(&filesystem, "/DerivedData/FileTypes"));
+
+    FileTypeCache loaded;
+    ASSERT_TRUE(loaded.load(&filesystem, "/DerivedData/FileTypes"));
+    EXPECT_EQ("text.script", loaded.find(&filesystem, "/script").value_or(""));
+    EXPECT_EQ("wrapper.framework", loaded.find(&filesystem, "/Bundle.framework").value_or(""));
+
+    FileTypeCache missing;
+    EXPECT_FALSE(missing.load(&filesystem, "/DerivedData/Missing"));
+}
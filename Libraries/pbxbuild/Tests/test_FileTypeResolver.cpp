@@ -0,0 +1,151 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/FileTypeResolver.h>
+#include <pbxbuild/FileTypeCache.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxbuild::FileTypeResolver;
+using pbxbuild::FileTypeCache;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static pbxspec::Manager::shared_ptr
+CreateManager()
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Specifications", {
+            MemoryFilesystem::Entry::File("FileTypes.xcspec", Contents(
+                "("
+                "    { Identifier = file; Type = FileType; },"
+                "    { Identifier = folder; Type = FileType; IsFolder = YES; },"
+                "    { Identifier = text; Type = FileType; BasedOn = file; Extensions = (txt); },"
+                "    { Identifier = text.plist; Type = FileType; BasedOn = text; Extensions = (plist); },"
+                "    { Identifier = text.plist.info; Type = FileType; BasedOn = text.plist; FilenamePatterns = (\"Info.plist\"); },"
+                "    { Identifier = sourcecode.c.c; Type = FileType; BasedOn = text; Extensions = (c); },"
+                "    { Identifier = sourcecode.asm; Type = FileType; BasedOn = text; Extensions = (s); },"
+                "    { Identifier = archive.ar; Type = FileType; BasedOn = file; Extensions = (a); Prefix = (lib); },"
+                "    { Identifier = sourcecode.make; Type = FileType; BasedOn = text; FilenamePatterns = (Makefile, makefile); },"
+                "    { Identifier = text.readme; Type = FileType; BasedOn = text; Prefix = (README); },"
+                "    { Identifier = text.script; Type = FileType; BasedOn = text; MagicWord = (\"#!\"); },"
+                "    { Identifier = wrapper.framework; Type = FileType; IsFolder = YES; FilenamePatterns = (\"*.framework\"); },"
+                ")")),
+        }),
+    });
+
+    pbxspec::Manager::shared_ptr manager = pbxspec::Manager::Create();
+    manager->registerDomains(&filesystem, { { "default", "/Specifications" } });
+    return manager;
+}
+
+TEST(FileTypeResolver, Extension)
+{
+    ext::optional<FileTypeResolver> resolver = FileTypeResolver::Create(CreateManager(), { "default" });
+    ASSERT_TRUE(resolver);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    EXPECT_EQ("sourcecode.c.c", resolver->resolve(&filesystem, "/main.c")->identifier());
+    EXPECT_EQ("text.plist", resolver->resolve(&filesystem, "/Other.plist")->identifier());
+
+    /* Extensions match regardless of case. */
+    EXPECT_EQ("sourcecode.asm", resolver->resolve(&filesystem, "/start.S")->identifier());
+
+    /* Unknown files fall back to the generic type. */
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/unknown.xyz")->identifier());
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/unknown")->identifier());
+}
+
+TEST(FileTypeResolver, Specific)
+{
+    ext::optional<FileTypeResolver> resolver = FileTypeResolver::Create(CreateManager(), { "default" });
+    ASSERT_TRUE(resolver);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+
+    /* More specific file types are preferred. */
+    EXPECT_EQ("text.plist.info", resolver->resolve(&filesystem, "/Info.plist")->identifier());
+
+    /* All checks must match. */
+    EXPECT_EQ("archive.ar", resolver->resolve(&filesystem, "/libfoo.a")->identifier());
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/foo.a")->identifier());
+}
+
+TEST(FileTypeResolver, Folder)
+{
+    ext::optional<FileTypeResolver> resolver = FileTypeResolver::Create(CreateManager(), { "default" });
+    ASSERT_TRUE(resolver);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("directory.c", { }),
+        MemoryFilesystem::Entry::File("file.c", Contents("int main() { }")),
+    });
+
+    /* Existing files are only matched with types for their kind. */
+    EXPECT_EQ("folder", resolver->resolve(&filesystem, "/directory.c")->identifier());
+    EXPECT_EQ("sourcecode.c.c", resolver->resolve(&filesystem, "/file.c")->identifier());
+}
+
+TEST(FileTypeResolver, FileName)
+{
+    ext::optional<FileTypeResolver> resolver = FileTypeResolver::Create(CreateManager(), { "default" });
+    ASSERT_TRUE(resolver);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    EXPECT_EQ("sourcecode.make", resolver->resolve(&filesystem, "/project/makefile")->identifier());
+    EXPECT_EQ("text.readme", resolver->resolve(&filesystem, "/README")->identifier());
+    EXPECT_EQ("text.readme", resolver->resolve(&filesystem, "/README.md")->identifier());
+    EXPECT_EQ("wrapper.framework", resolver->resolve(&filesystem, "/Foo.framework")->identifier());
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/Makefile.in")->identifier());
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/READ")->identifier());
+}
+
+TEST(FileTypeResolver, MagicWord)
+{
+    ext::optional<FileTypeResolver> resolver = FileTypeResolver::Create(CreateManager(), { "default" });
+    ASSERT_TRUE(resolver);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("script", Contents("#!/bin/sh")),
+        MemoryFilesystem::Entry::File("binary", Contents("\x7f" "ELF")),
+        MemoryFilesystem::Entry::File("short", Contents("#")),
+    });
+
+    /* Contents are checked for files without other matches. */
+    EXPECT_EQ("text.script", resolver->resolve(&filesystem, "/script")->identifier());
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/binary")->identifier());
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/short")->identifier());
+}
+
+TEST(FileTypeResolver, Cache)
+{
+    ext::optional<FileTypeResolver> resolver = FileTypeResolver::Create(CreateManager(), { "default" });
+    ASSERT_TRUE(resolver);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("script", Contents("#!/bin/sh")),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    FileTypeCache cache;
+    EXPECT_EQ("text.script", resolver->resolve(&filesystem, "/script", &cache)->identifier());
+    EXPECT_EQ("text.script", cache.find(&filesystem, "/script").value_or(""));
+
+    /* Files with unchanged stamps aren't read again. */
+    ASSERT_TRUE(filesystem.write(Contents("plain"), "/script"));
+    ASSERT_TRUE(filesystem.setStamp("/script", Filesystem::Stamp({ 1, 1 })));
+    EXPECT_EQ("text.script", resolver->resolve(&filesystem, "/script", &cache)->identifier());
+    EXPECT_EQ("file", resolver->resolve(&filesystem, "/script")->identifier());
+}
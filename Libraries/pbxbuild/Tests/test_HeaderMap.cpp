@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/HeaderMap.h>
+
+#include <cstring>
+
+using pbxbuild::HeaderMap;
+
+static HMapHeader
+Header(std::vector<uint8_t> const &contents)
+{
+    HMapHeader header;
+    EXPECT_GE(contents.size(), sizeof(header));
+    ::memcpy(&header, contents.data(), sizeof(header));
+    return header;
+}
+
+TEST(HeaderMap, Add)
+{
+    std::vector<HeaderMap::Entry> entries;
+    for (int n = 0; n < 100; n++) {
+        std::string name = "header" + std::to_string(n) + ".h";
+        entries.push_back({ name, "/path/", name });
+    }
+
+    /* Keys differing only by case are duplicates. */
+    entries.push_back({ "HEADER1.h", "/other/", "HEADER1.h" });
+
+    HeaderMap bulk;
+    bulk.add(entries);
+    HMapHeader bulkHeader = Header(bulk.write());
+
+    HeaderMap single;
+    for (HeaderMap::Entry const &entry : entries) {
+        single.add(entry.key, entry.prefix, entry.suffix);
+    }
+    HMapHeader singleHeader = Header(single.write());
+
+    EXPECT_EQ(100, bulkHeader.NumEntries);
+    EXPECT_EQ(singleHeader.NumEntries, bulkHeader.NumEntries);
+    EXPECT_EQ(singleHeader.NumBuckets, bulkHeader.NumBuckets);
+    EXPECT_EQ(singleHeader.StringsOffset, bulkHeader.StringsOffset);
+}
+
+TEST(HeaderMap, Reserve)
+{
+    HeaderMap headerMap;
+    headerMap.reserve(1000);
+    HMapHeader header = Header(headerMap.write());
+    EXPECT_EQ(2048, header.NumBuckets);
+
+    /* Adding the reserved entries doesn't grow the table. */
+    for (int n = 0; n < 1000; n++) {
+        std::string name = "header" + std::to_string(n) + ".h";
+        EXPECT_TRUE(headerMap.add(name, "/path/", name));
+    }
+    header = Header(headerMap.write());
+    EXPECT_EQ(1000, header.NumEntries);
+    EXPECT_EQ(2048, header.NumBuckets);
+
+    /* Written maps read back. */
+    HeaderMap read;
+    EXPECT_TRUE(read.read(headerMap.write()));
+    EXPECT_FALSE(read.add("header1.h", "/path/", "header1.h"));
+}
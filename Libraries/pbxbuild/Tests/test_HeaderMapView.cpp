@@ -0,0 +1,72 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/HeaderMap.h>
+#include <pbxbuild/HeaderMapView.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxbuild::HeaderMap;
+using pbxbuild::HeaderMapView;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+TEST(HeaderMapView, Lookup)
+{
+    HeaderMap headerMap;
+    for (int n = 0; n < 100; n++) {
+        std::string name = "header" + std::to_string(n) + ".h";
+        headerMap.add("Module/" + name, "/path/", name);
+    }
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("map.hmap", headerMap.write()),
+    });
+
+    std::unique_ptr<HeaderMapView> view = HeaderMapView::Load(&filesystem, "/map.hmap");
+    ASSERT_NE(nullptr, view);
+    EXPECT_EQ(100, view->size());
+
+    EXPECT_EQ("/path/header1.h", *view->lookup("Module/header1.h"));
+    EXPECT_EQ("/path/header99.h", *view->lookup("Module/header99.h"));
+
+    /* Keys match without regard to case. */
+    EXPECT_EQ("/path/header1.h", *view->lookup("MODULE/Header1.h"));
+
+    EXPECT_FALSE(view->lookup("Module/header100.h"));
+    EXPECT_FALSE(view->lookup("header1.h"));
+
+    size_t count = 0;
+    view->iterate([&](char const *key, char const *prefix, char const *suffix) {
+        EXPECT_EQ("Module/" + std::string(suffix), key);
+        EXPECT_STREQ("/path/", prefix);
+        count++;
+    });
+    EXPECT_EQ(100, count);
+}
+
+TEST(HeaderMapView, Invalid)
+{
+    std::vector<uint8_t> contents = HeaderMap().write();
+    contents[0] = 'x';
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("empty.hmap", { }),
+        MemoryFilesystem::Entry::File("invalid.hmap", contents),
+    });
+
+    EXPECT_EQ(nullptr, HeaderMapView::Load(&filesystem, "/missing.hmap"));
+    EXPECT_EQ(nullptr, HeaderMapView::Load(&filesystem, "/empty.hmap"));
+    EXPECT_EQ(nullptr, HeaderMapView::Load(&filesystem, "/invalid.hmap"));
+
+    /* Buckets past the end of the file are rejected. */
+    std::vector<uint8_t> truncated = HeaderMap().write();
+    truncated.resize(sizeof(HMapHeader) + sizeof(HMapBucket));
+    EXPECT_EQ(nullptr, HeaderMapView::Create(std::unique_ptr<Filesystem::Mapping const>(new Filesystem::Mapping(truncated.data(), truncated.size()))));
+}
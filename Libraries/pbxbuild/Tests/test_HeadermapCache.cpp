@@ -0,0 +1,40 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/HeadermapCache.h>
+
+using pbxbuild::HeadermapCache;
+
+TEST(HeadermapCache, Cached)
+{
+    HeadermapCache cache;
+
+    int created = 0;
+    auto create = [&]() {
+        created++;
+
+        auto headers = std::make_shared<HeadermapCache::ProjectHeaders>();
+        headers->projectHeaders.push_back({ "header.h", "/path/", "header.h" });
+        return std::shared_ptr<HeadermapCache::ProjectHeaders const>(headers);
+    };
+
+    auto first = cache.project("project1", create);
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(1, first->projectHeaders.size());
+    EXPECT_EQ("header.h", first->projectHeaders[0].key);
+
+    /* Same key is only created once. */
+    EXPECT_EQ(first, cache.project("project1", create));
+    EXPECT_EQ(1, created);
+
+    /* Different key is created separately. */
+    EXPECT_NE(first, cache.project("project2", create));
+    EXPECT_EQ(2, created);
+}
@@ -0,0 +1,43 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Tool/Invocation.h>
+
+namespace Tool = pbxbuild::Tool;
+
+TEST(Invocation, ShareEnvironment)
+{
+    Tool::Invocation first;
+    first.environment() = { { "PATH", "/usr/bin" } };
+
+    Tool::Invocation second;
+    second.shareEnvironment(first);
+
+    Tool::Invocation const &constFirst = first;
+    Tool::Invocation const &constSecond = second;
+    EXPECT_EQ(&constFirst.environment(), &constSecond.environment());
+
+    /* Changing a shared environment changes only that invocation's copy. */
+    second.environment()["HOME"] = "/root";
+    EXPECT_NE(&constFirst.environment(), &constSecond.environment());
+    EXPECT_EQ(1, constFirst.environment().size());
+    EXPECT_EQ(2, constSecond.environment().size());
+}
+
+TEST(Invocation, Move)
+{
+    Tool::Invocation invocation;
+    invocation.arguments() = { "-c", "a.c" };
+    std::string const *argument = &invocation.arguments().front();
+
+    /* Moving keeps the same storage. */
+    Tool::Invocation moved = std::move(invocation);
+    EXPECT_EQ(argument, &moved.arguments().front());
+}
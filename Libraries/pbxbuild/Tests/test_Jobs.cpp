@@ -0,0 +1,61 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Build/Jobs.h>
+
+namespace Build = pbxbuild::Build;
+
+static pbxsetting::Environment
+CreateEnvironment(std::vector<pbxsetting::Setting> const &settings)
+{
+    pbxsetting::Environment environment;
+    environment.insertFront(pbxsetting::Level(settings), false);
+    return environment;
+}
+
+TEST(Jobs, Count)
+{
+    EXPECT_EQ(12, Build::Jobs::Count(CreateEnvironment({ pbxsetting::Setting::Create("XCBUILD_JOBS", "12") })));
+
+    /* Without a valid number, one per processor. */
+    EXPECT_LE(1, Build::Jobs::Count(CreateEnvironment({ })));
+    EXPECT_LE(1, Build::Jobs::Count(CreateEnvironment({ pbxsetting::Setting::Create("XCBUILD_JOBS", "0") })));
+}
+
+TEST(Jobs, SwiftShareJobs)
+{
+    /* A few Swift compiles, each with several threads. */
+    pbxsetting::Environment many = CreateEnvironment({ pbxsetting::Setting::Create("XCBUILD_JOBS", "64") });
+    EXPECT_EQ(8, Build::Jobs::SwiftCompiles(many));
+    EXPECT_EQ(8, Build::Jobs::SwiftThreads(many));
+
+    /* With few jobs, a single compile uses all of them. */
+    pbxsetting::Environment few = CreateEnvironment({ pbxsetting::Setting::Create("XCBUILD_JOBS", "4") });
+    EXPECT_EQ(1, Build::Jobs::SwiftCompiles(few));
+    EXPECT_EQ(4, Build::Jobs::SwiftThreads(few));
+}
+
+TEST(Jobs, SwiftPoolDepth)
+{
+    pbxsetting::Environment limited = CreateEnvironment({
+        pbxsetting::Setting::Create("XCBUILD_JOBS", "64"),
+        pbxsetting::Setting::Create("NINJA_SWIFT_POOL_DEPTH", "2"),
+    });
+    EXPECT_EQ(2, Build::Jobs::SwiftCompiles(limited));
+    EXPECT_EQ(32, Build::Jobs::SwiftThreads(limited));
+
+    /* Unlimited compiles get a thread each. */
+    pbxsetting::Environment unlimited = CreateEnvironment({
+        pbxsetting::Setting::Create("XCBUILD_JOBS", "64"),
+        pbxsetting::Setting::Create("NINJA_SWIFT_POOL_DEPTH", "0"),
+    });
+    EXPECT_EQ(64, Build::Jobs::SwiftCompiles(unlimited));
+    EXPECT_EQ(1, Build::Jobs::SwiftThreads(unlimited));
+}
@@ -0,0 +1,179 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Phase/SourcesResolver.h>
+#include <pbxbuild/Tool/Context.h>
+#include <pbxbuild/Tool/SearchPaths.h>
+#include <pbxsetting/Environment.h>
+#include <libutil/MemoryFilesystem.h>
+
+namespace Phase = pbxbuild::Phase;
+namespace Target = pbxbuild::Target;
+namespace Tool = pbxbuild::Tool;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static pbxspec::Manager::shared_ptr
+CreateManager()
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Specifications", {
+            MemoryFilesystem::Entry::File("Specifications.xcspec", Contents(
+                "("
+                "    { Identifier = sourcecode.c.c; Type = FileType; },"
+                "    { Identifier = sourcecode.cpp.cpp; Type = FileType; },"
+                "    { Identifier = com.apple.compilers.gcc; Type = Tool; },"
+                ")")),
+        }),
+    });
+
+    pbxspec::Manager::shared_ptr manager = pbxspec::Manager::Create();
+    manager->registerDomains(&filesystem, { { "default", "/Specifications" } });
+    return manager;
+}
+
+/*
+ * A build rule compiling a file type with clang.
+ */
+static Target::BuildRules::BuildRule::shared_ptr
+Rule(pbxspec::Manager::shared_ptr const &manager, std::string const &fileType)
+{
+    pbxspec::PBX::FileType::vector fileTypes = { manager->fileType(fileType, { "default" }) };
+    pbxspec::PBX::Tool::shared_ptr clang = manager->tool("com.apple.compilers.gcc", { "default" });
+    return std::make_shared<Target::BuildRules::BuildRule>(std::string(), fileTypes, clang, std::string(), std::vector<pbxsetting::Value>());
+}
+
+static Tool::Input
+Source(std::string const &path, Target::BuildRules::BuildRule::shared_ptr const &rule, ext::optional<std::vector<std::string>> const &compilerFlags = ext::nullopt)
+{
+    return Tool::Input(path, rule->fileTypes().front(), rule, ext::nullopt, ext::nullopt, ext::nullopt, ext::nullopt, compilerFlags);
+}
+
+static pbxsetting::Environment
+CreateEnvironment()
+{
+    pbxsetting::Environment environment;
+    environment.insertFront(pbxsetting::Level({
+        pbxsetting::Setting::Create("DERIVED_FILE_DIR", "/derived"),
+    }), false);
+    return environment;
+}
+
+static std::string
+AuxiliaryContents(Tool::Context const &toolContext, size_t index)
+{
+    std::vector<uint8_t> const &data = *toolContext.auxiliaryFiles()[index].chunks().front().data();
+    return std::string(data.begin(), data.end());
+}
+
+TEST(SourcesResolver, UnityBatches)
+{
+    pbxspec::Manager::shared_ptr manager = CreateManager();
+    Target::BuildRules::BuildRule::shared_ptr c = Rule(manager, "sourcecode.c.c");
+    ASSERT_NE(nullptr, c->tool());
+
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    pbxsetting::Environment environment = CreateEnvironment();
+
+    /* Five sources in batches of two leave the last on its own. */
+    Tool::Context partial = Tool::Context(&filesystem, nullptr, { }, "/", Tool::SearchPaths({ }, { }, { }, { }));
+    std::vector<Tool::Input> result = Phase::SourcesResolver::UnitySources(&partial, environment, {
+        Source("/src/a.c", c),
+        Source("/src/b.c", c),
+        Source("/src/c.c", c),
+        Source("/src/d.c", c),
+        Source("/src/e.c", c),
+    }, 2);
+
+    ASSERT_EQ(3, result.size());
+    EXPECT_EQ("/derived/Unity/Unity-0.c", result[0].path());
+    EXPECT_EQ("/derived/Unity/Unity-1.c", result[1].path());
+    EXPECT_EQ("/src/e.c", result[2].path());
+    EXPECT_EQ(c, result[0].buildRule());
+    EXPECT_EQ(c->fileTypes().front(), result[0].fileType());
+
+    ASSERT_EQ(2, partial.auxiliaryFiles().size());
+    EXPECT_EQ("/derived/Unity/Unity-0.c", partial.auxiliaryFiles()[0].path());
+    EXPECT_EQ("#include \"/src/a.c\"\n#include \"/src/b.c\"\n", AuxiliaryContents(partial, 0));
+    EXPECT_EQ("#include \"/src/c.c\"\n#include \"/src/d.c\"\n", AuxiliaryContents(partial, 1));
+
+    /* Sources filling their batches exactly leave none on their own. */
+    Tool::Context exact = Tool::Context(&filesystem, nullptr, { }, "/", Tool::SearchPaths({ }, { }, { }, { }));
+    result = Phase::SourcesResolver::UnitySources(&exact, environment, {
+        Source("/src/a.c", c),
+        Source("/src/b.c", c),
+        Source("/src/c.c", c),
+        Source("/src/d.c", c),
+    }, 2);
+
+    ASSERT_EQ(2, result.size());
+    EXPECT_EQ("/derived/Unity/Unity-0.c", result[0].path());
+    EXPECT_EQ("/derived/Unity/Unity-1.c", result[1].path());
+    EXPECT_EQ(2, exact.auxiliaryFiles().size());
+}
+
+TEST(SourcesResolver, UnitySeparate)
+{
+    pbxspec::Manager::shared_ptr manager = CreateManager();
+    Target::BuildRules::BuildRule::shared_ptr c = Rule(manager, "sourcecode.c.c");
+    Target::BuildRules::BuildRule::shared_ptr cpp = Rule(manager, "sourcecode.cpp.cpp");
+
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    Tool::Context toolContext = Tool::Context(&filesystem, nullptr, { }, "/", Tool::SearchPaths({ }, { }, { }, { }));
+
+    /* Sources of different types, or with their own flags, aren't combined. */
+    std::vector<Tool::Input> result = Phase::SourcesResolver::UnitySources(&toolContext, CreateEnvironment(), {
+        Source("/src/a.c", c),
+        Source("/src/b.cpp", cpp),
+        Source("/src/c.c", c, std::vector<std::string>({ "-O0" })),
+        Source("/src/d.c", c),
+        Source("/src/e.cpp", cpp),
+    }, 4);
+
+    ASSERT_EQ(3, result.size());
+    EXPECT_EQ("/src/c.c", result[0].path());
+    EXPECT_EQ("/derived/Unity/Unity-0.c", result[1].path());
+    EXPECT_EQ("/derived/Unity/Unity-1.cpp", result[2].path());
+    EXPECT_EQ(cpp, result[2].buildRule());
+
+    ASSERT_EQ(2, toolContext.auxiliaryFiles().size());
+    EXPECT_EQ("#include \"/src/a.c\"\n#include \"/src/d.c\"\n", AuxiliaryContents(toolContext, 0));
+    EXPECT_EQ("#include \"/src/b.cpp\"\n#include \"/src/e.cpp\"\n", AuxiliaryContents(toolContext, 1));
+}
+
+TEST(SourcesResolver, UnitySmallSizes)
+{
+    pbxspec::Manager::shared_ptr manager = CreateManager();
+    Target::BuildRules::BuildRule::shared_ptr c = Rule(manager, "sourcecode.c.c");
+
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    std::vector<Tool::Input> files = {
+        Source("/src/a.c", c),
+        Source("/src/b.c", c),
+        Source("/src/c.c", c),
+    };
+
+    /* Batches of one, or of no files, compile each source as it is. */
+    for (size_t size : { 0, 1 }) {
+        Tool::Context toolContext = Tool::Context(&filesystem, nullptr, { }, "/", Tool::SearchPaths({ }, { }, { }, { }));
+        std::vector<Tool::Input> result = Phase::SourcesResolver::UnitySources(&toolContext, CreateEnvironment(), files, size);
+
+        ASSERT_EQ(3, result.size());
+        EXPECT_EQ("/src/a.c", result[0].path());
+        EXPECT_EQ("/src/b.c", result[1].path());
+        EXPECT_EQ("/src/c.c", result[2].path());
+        EXPECT_TRUE(toolContext.auxiliaryFiles().empty());
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/TargetIndex.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxbuild::TargetIndex;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static std::string const ProjectContents =
+    "{\n"
+    "    archiveVersion = 1;\n"
+    "    objectVersion = 46;\n"
+    "    objects = {\n"
+    "        P = { isa = PBXProject; buildConfigurationList = L; mainGroup = G; targets = ( A, B ); };\n"
+    "        L = { isa = XCConfigurationList; buildConfigurations = ( ); };\n"
+    "        G = { isa = PBXGroup; children = ( AP, BP ); };\n"
+    "        A = { isa = PBXNativeTarget; name = A; productName = A; productReference = AP; buildConfigurationList = L; buildPhases = ( ); dependencies = ( ); };\n"
+    "        B = { isa = PBXNativeTarget; name = B; productName = B; productReference = BP; buildConfigurationList = L; buildPhases = ( ); dependencies = ( ); };\n"
+    "        AP = { isa = PBXFileReference; path = libA.a; sourceTree = BUILT_PRODUCTS_DIR; };\n"
+    "        BP = { isa = PBXFileReference; path = libB.a; sourceTree = BUILT_PRODUCTS_DIR; };\n"
+    "    };\n"
+    "    rootObject = P;\n"
+    "}\n";
+
+TEST(TargetIndex, Find)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("P.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", Contents(ProjectContents)),
+        }),
+    });
+
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/P.xcodeproj");
+    ASSERT_NE(project, nullptr);
+    ASSERT_EQ(project->targets().size(), 2);
+    pbxproj::PBX::Target::shared_ptr const &a = project->targets().at(0);
+    pbxproj::PBX::Target::shared_ptr const &b = project->targets().at(1);
+
+    TargetIndex index = TargetIndex::Create({ { "/P.xcodeproj", project } });
+
+    EXPECT_EQ(index.target(project, "A"), a);
+    EXPECT_EQ(index.target(project, "B"), b);
+    EXPECT_EQ(index.target(project, "AP"), nullptr);
+
+    auto product = index.product(project, "BP");
+    ASSERT_TRUE(product);
+    EXPECT_EQ(product->first, b);
+    EXPECT_EQ(product->second->name(), "libB.a");
+    EXPECT_FALSE(index.product(project, "B"));
+
+    EXPECT_EQ(index.productName("libA.a"), a);
+    EXPECT_EQ(index.productName("libC.a"), nullptr);
+
+    /* Only the indexed projects are found. */
+    EXPECT_EQ(index.target(nullptr, "A"), nullptr);
+}
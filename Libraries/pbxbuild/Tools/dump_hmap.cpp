@@ -8,10 +8,12 @@
  */
 
 #include <pbxbuild/HeaderMap.h>
+#include <pbxbuild/HeaderMapView.h>
 #include <libutil/Filesystem.h>
 #include <libutil/DefaultFilesystem.h>
 
 using pbxbuild::HeaderMap;
+using pbxbuild::HeaderMapView;
 using libutil::Filesystem;
 using libutil::DefaultFilesystem;
 
@@ -21,10 +23,34 @@ main(int argc, char **argv)
     DefaultFilesystem filesystem = DefaultFilesystem();
 
     if (argc < 2) {
-        fprintf(stderr, "usage: %s <file.hmap>\n", argv[0]);
+        fprintf(stderr, "usage: %s <file.hmap> [key ...]\n", argv[0]);
         return -1;
     }
 
+    /*
+     * Look up just the keys given, without reading the whole map.
+     */
+    if (argc > 2) {
+        std::unique_ptr<HeaderMapView> view = HeaderMapView::Load(&filesystem, argv[1]);
+        if (view == nullptr) {
+            fprintf(stderr, "error: cannot open '%s', not an hmap file\n", argv[1]);
+            return -1;
+        }
+
+        int result = 0;
+        for (int n = 2; n < argc; n++) {
+            ext::optional<std::string> path = view->lookup(argv[n]);
+            if (path) {
+                printf("%s -> %s\n", argv[n], path->c_str());
+            } else {
+                fprintf(stderr, "error: '%s' not found\n", argv[n]);
+                result = 1;
+            }
+        }
+
+        return result;
+    }
+
     std::vector<uint8_t> contents;
     if (!filesystem.read(&contents, argv[1])) {
         fprintf(stderr, "error: cannot open '%s', failed to read\n", argv[1]);
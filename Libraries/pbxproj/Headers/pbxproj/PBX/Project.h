@@ -56,11 +56,33 @@ private:
     Target::vector                     _targets;
     FileReference::vector              _fileReferences;
 
+private:
+    std::shared_ptr<Context>           _context;
+    std::string                        _snapshotHash;
+    mutable bool                       _snapshotFresh;
+
 public:
     Project();
 
 public:
-    static shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    /*
+     * Open a project. If lazy, each target's build phases are only parsed
+     * when first used, so targets that aren't built cost little more than
+     * their settings. The project's property list is kept until then.
+     *
+     * If a snapshot path is given and a snapshot there was saved from the
+     * same project file contents, the property list is read from it rather
+     * than parsed from the project file.
+     */
+    static shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path, bool lazy = false, std::string const &snapshotPath = std::string());
+
+public:
+    /*
+     * Save a snapshot of the project's property list, to open it faster the
+     * next time. Only lazily opened projects keep their property list. Does
+     * nothing if the project was opened from or saved to a fresh snapshot.
+     */
+    bool saveSnapshot(libutil::Filesystem *filesystem, std::string const &snapshotPath) const;
 
 public:
     inline XC::ConfigurationList::shared_ptr const &buildConfigurationList() const
@@ -117,6 +139,11 @@ public:
 public:
     std::string sourceRoot() const;
 
+protected:
+    friend class pbxproj::PBX::Target;
+    inline std::shared_ptr<Context> const &context() const
+    { return _context; }
+
 protected:
     friend class pbxproj::Context;
     inline void cacheObject(Object::shared_ptr const &object)
@@ -15,6 +15,10 @@
 #include <pbxproj/PBX/BuildPhase.h>
 #include <pbxproj/PBX/TargetDependency.h>
 
+#include <mutex>
+
+namespace plist { class Array; }
+
 namespace pbxproj { namespace PBX {
 
 class Project;
@@ -41,9 +45,17 @@ private:
     std::string                       _name;
     std::string                       _productName;
     XC::ConfigurationList::shared_ptr _buildConfigurationList;
-    PBX::BuildPhase::vector           _buildPhases;
     PBX::TargetDependency::vector     _dependencies;
 
+private:
+    /*
+     * Build phases of lazily parsed projects are parsed on first use.
+     */
+    mutable PBX::BuildPhase::vector   _buildPhases;
+    mutable std::once_flag            _buildPhasesParsed;
+    mutable bool                      _buildPhasesValid;
+    plist::Array const               *_lazyBuildPhases;
+
 protected:
     Target(std::string const &isa, Type type);
 
@@ -68,8 +80,13 @@ public:
     { return _buildConfigurationList; }
 
 public:
-    inline BuildPhase::vector const &buildPhases() const
-    { return _buildPhases; }
+    BuildPhase::vector const &buildPhases() const;
+
+    /*
+     * If the build phases were parsed. Projects opened lazily parse them
+     * now, and report an error if they can't be parsed; they are empty.
+     */
+    bool buildPhasesValid() const;
 
 public:
     inline TargetDependency::vector const &dependencies() const
@@ -80,6 +97,9 @@ public:
 
 protected:
     bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check) override;
+
+private:
+    bool parseBuildPhases(Context &context, plist::Array const *BPs);
 };
 
 } }
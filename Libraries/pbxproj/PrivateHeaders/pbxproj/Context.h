@@ -18,6 +18,7 @@
 #include <plist/Keys/Unpack.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -67,6 +68,14 @@ public:
     //
     plist::Dictionary const *objects;
 
+    //
+    // Lazy parsing: the property list stays with the context, so objects
+    // can be parsed once they are used. The mutex guards the caches.
+    //
+    bool                           lazy;
+    std::unique_ptr<plist::Object> contents;
+    std::mutex                     mutex;
+
     //
     // The main project
     //
@@ -103,6 +112,8 @@ public:
 public:
     Context()
     {
+        objects = nullptr;
+        lazy    = false;
         project = nullptr;
     }
 
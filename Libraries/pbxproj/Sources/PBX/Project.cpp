@@ -14,14 +14,19 @@
 #include <pbxproj/Context.h>
 #include <plist/Array.h>
 #include <plist/Boolean.h>
+#include <plist/CacheFile.h>
 #include <plist/Integer.h>
 #include <plist/String.h>
 #include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/md5.h>
 #include <process/Context.h>
 
+#include <iomanip>
+#include <sstream>
+
 using pbxproj::PBX::Project;
 using libutil::Filesystem;
 using libutil::FSUtil;
@@ -29,7 +34,8 @@ using libutil::FSUtil;
 Project::
 Project() :
     Object                 (Isa()),
-    _hasScannedForEncodings(false)
+    _hasScannedForEncodings(false),
+    _snapshotFresh         (false)
 {
 }
 
@@ -183,8 +189,59 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
     return true;
 }
 
+/*
+ * Increment when the snapshot contents change, so older snapshots are ignored.
+ */
+static int64_t const SnapshotVersion = 1;
+
+static std::string
+ContentsHash(uint8_t const *data, size_t size)
+{
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(data), size);
+
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+    return ss.str();
+}
+
+/*
+ * Read a snapshot saved from project file contents with the hash. The
+ * snapshot is returned whole; its "Contents" are the project property list.
+ */
+static std::unique_ptr<plist::Object>
+ReadSnapshot(Filesystem const *filesystem, std::string const &snapshotPath, std::string const &hash)
+{
+    if (snapshotPath.empty() || filesystem->type(snapshotPath) != Filesystem::Type::File) {
+        return nullptr;
+    }
+
+    std::unique_ptr<plist::Dictionary> snapshot = plist::CacheFile::Load(filesystem, snapshotPath, SnapshotVersion);
+    if (snapshot == nullptr) {
+        return nullptr;
+    }
+
+    auto snapshotHash = snapshot->value<plist::String>("Hash");
+    if (snapshotHash == nullptr || snapshotHash->value() != hash) {
+        return nullptr;
+    }
+
+    if (snapshot->value<plist::Dictionary>("Contents") == nullptr) {
+        return nullptr;
+    }
+
+    return std::move(snapshot);
+}
+
 Project::shared_ptr Project::
-Open(Filesystem const *filesystem, std::string const &path)
+Open(Filesystem const *filesystem, std::string const &path, bool lazy, std::string const &snapshotPath)
 {
     if (path.empty()) {
         fprintf(stderr, "error: project path is empty\n");
@@ -203,22 +260,32 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, realPath)) {
+    std::unique_ptr<libutil::Filesystem::Mapping const> contents = filesystem->map(realPath);
+    if (contents == nullptr) {
         fprintf(stderr, "error: project file %s is not readable\n", projectFileName.c_str());
         return nullptr;
     }
 
     //
-    // Parse property list
+    // Parse property list, or use the snapshot of it if still fresh.
     //
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
-        fprintf(stderr, "error: project file %s is not parseable: %s\n", projectFileName.c_str(), result.second.c_str());
-        return nullptr;
+    std::string hash = (!snapshotPath.empty() ? ContentsHash(contents->data(), contents->size()) : std::string());
+    std::pair<std::unique_ptr<plist::Object>, std::string> result;
+    plist::Dictionary *plist = nullptr;
+
+    if (std::unique_ptr<plist::Object> snapshot = ReadSnapshot(filesystem, snapshotPath, hash)) {
+        result.first = std::move(snapshot);
+        plist = plist::CastTo<plist::Dictionary>(result.first.get())->value<plist::Dictionary>("Contents");
+    } else {
+        result = plist::Format::Any::Deserialize(contents->data(), contents->size());
+        if (result.first == nullptr) {
+            fprintf(stderr, "error: project file %s is not parseable: %s\n", projectFileName.c_str(), result.second.c_str());
+            return nullptr;
+        }
+
+        plist = plist::CastTo<plist::Dictionary>(result.first.get());
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
     if (plist == nullptr) {
         fprintf(stderr, "error: project file %s is not a dictionary\n", projectFileName.c_str());
         return nullptr;
@@ -269,8 +336,11 @@ Open(Filesystem const *filesystem, std::string const &path)
     //
     // Initialize context
     //
-    Context context;
+    std::shared_ptr<Context> lazyContext = (lazy ? std::make_shared<Context>() : nullptr);
+    Context eagerContext;
+    Context &context = (lazy ? *lazyContext : eagerContext);
     context.objects = Os;
+    context.lazy    = lazy;
 
     //
     // Fetch the project dictionary (root object)
@@ -293,6 +363,10 @@ Open(Filesystem const *filesystem, std::string const &path)
     // Parse the project dictionary and create the project object.
     //
     auto project = context.parseObject(context.projects, PID, P);
+    if (project == nullptr) {
+        fprintf(stderr, "error: unable to parse project\n");
+        return nullptr;
+    }
 
     //
     // Save some useful info
@@ -302,6 +376,9 @@ Open(Filesystem const *filesystem, std::string const &path)
     project->_basePath    = FSUtil::GetDirectoryName(project->_projectFile);
     project->_name        = FSUtil::GetBaseNameWithoutExtension(project->_projectFile);
 
+    project->_snapshotHash  = hash;
+    project->_snapshotFresh = (plist != result.first.get());
+
     //
     // Transfer all file references from cache.
     //
@@ -309,9 +386,55 @@ Open(Filesystem const *filesystem, std::string const &path)
         project->_fileReferences.push_back(I.second);
     }
 
+    //
+    // Keep the property list for parsing the rest later. The context's
+    // references to the project are dropped so it doesn't keep itself.
+    //
+    if (lazy) {
+        lazyContext->contents = std::move(result.first);
+        lazyContext->project  = nullptr;
+        lazyContext->projects.clear();
+        project->_context     = lazyContext;
+    }
+
     return project;
 }
 
+bool Project::
+saveSnapshot(Filesystem *filesystem, std::string const &snapshotPath) const
+{
+    if (_snapshotFresh) {
+        return true;
+    }
+
+    if (_context == nullptr || _snapshotHash.empty()) {
+        return false;
+    }
+
+    auto snapshot = plist::Dictionary::New();
+    snapshot->set("Hash", plist::String::New(_snapshotHash));
+
+    {
+        /* Build phases may be parsing from the contents. */
+        std::lock_guard<std::mutex> lock(_context->mutex);
+
+        if (_context->contents == nullptr) {
+            return false;
+        }
+
+        snapshot->set("Contents", _context->contents->copy());
+    }
+
+    /* Other builds may be mapping the snapshot, so replace it rather than writing into it. */
+    if (!plist::CacheFile::Save(filesystem, snapshotPath, SnapshotVersion, std::move(snapshot))) {
+        fprintf(stderr, "warning: unable to write project snapshot %s\n", snapshotPath.c_str());
+        return false;
+    }
+
+    _snapshotFresh = true;
+    return true;
+}
+
 Project::ProjectReference::
 ProjectReference()
 {
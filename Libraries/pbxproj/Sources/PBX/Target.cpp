@@ -9,6 +9,7 @@
 
 #include <pbxproj/PBX/Target.h>
 #include <pbxproj/PBX/NativeTarget.h>
+#include <pbxproj/PBX/Project.h>
 #include <pbxproj/PBX/BuildPhases.h>
 #include <pbxproj/Context.h>
 #include <plist/Array.h>
@@ -22,11 +23,53 @@ using pbxproj::PBX::FileReference;
 
 Target::
 Target(std::string const &isa, Type type) :
-    Object(isa),
-    _type (type)
+    Object           (isa),
+    _type            (type),
+    _buildPhasesValid(true),
+    _lazyBuildPhases (nullptr)
 {
 }
 
+pbxproj::PBX::BuildPhase::vector const &Target::
+buildPhases() const
+{
+    std::call_once(_buildPhasesParsed, [this] {
+        if (_lazyBuildPhases == nullptr) {
+            return;
+        }
+
+        std::shared_ptr<Project> project = _project.lock();
+        if (project == nullptr || project->context() == nullptr) {
+            return;
+        }
+
+        /*
+         * Other targets in the project share the context's caches, so only
+         * parse one target's build phases at a time. Objects parsed now are
+         * still registered with the project.
+         */
+        Context *context = project->context().get();
+        std::lock_guard<std::mutex> lock(context->mutex);
+
+        context->project = project;
+        if (!const_cast<Target *>(this)->parseBuildPhases(*context, _lazyBuildPhases)) {
+            fprintf(stderr, "error: unable to parse build phases of target '%s'\n", _name.c_str());
+            _buildPhases.clear();
+            _buildPhasesValid = false;
+        }
+        context->project = nullptr;
+    });
+
+    return _buildPhases;
+}
+
+bool Target::
+buildPhasesValid() const
+{
+    buildPhases();
+    return _buildPhasesValid;
+}
+
 pbxsetting::Level Target::
 settings(void) const
 {
@@ -86,72 +129,10 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
     }
 
     if (BPs != nullptr) {
-        for (size_t n = 0; n < BPs->count(); n++) {
-            auto ID = BPs->value <plist::String> (n);
-            if (ID == nullptr) {
-                continue;
-            }
-
-            if (auto BPd = context.get <HeadersBuildPhase> (ID)) {
-                auto O = context.parseObject(context.headersBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <SourcesBuildPhase> (ID)) {
-                auto O = context.parseObject(context.sourcesBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <ResourcesBuildPhase> (ID)) {
-                auto O = context.parseObject(context.resourcesBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <FrameworksBuildPhase> (ID)) {
-                auto O = context.parseObject(context.frameworksBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <CopyFilesBuildPhase> (ID)) {
-                auto O = context.parseObject(context.copyFilesBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <ShellScriptBuildPhase> (ID)) {
-                auto O = context.parseObject(context.shellScriptBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <AppleScriptBuildPhase> (ID)) {
-                auto O = context.parseObject(context.appleScriptBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <RezBuildPhase> (ID)) {
-                auto O = context.parseObject(context.rezBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else {
-                fprintf(stderr, "warning: target '%s' contains unsupported build phase reference to '%s'\n",
-                        _name.c_str(), ID->value().c_str());
-            }
+        if (context.lazy) {
+            _lazyBuildPhases = BPs;
+        } else if (!parseBuildPhases(context, BPs)) {
+            return false;
         }
     }
 
@@ -172,3 +153,77 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+bool Target::
+parseBuildPhases(Context &context, plist::Array const *BPs)
+{
+    for (size_t n = 0; n < BPs->count(); n++) {
+        auto ID = BPs->value <plist::String> (n);
+        if (ID == nullptr) {
+            continue;
+        }
+
+        if (auto BPd = context.get <HeadersBuildPhase> (ID)) {
+            auto O = context.parseObject(context.headersBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else if (auto BPd = context.get <SourcesBuildPhase> (ID)) {
+            auto O = context.parseObject(context.sourcesBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else if (auto BPd = context.get <ResourcesBuildPhase> (ID)) {
+            auto O = context.parseObject(context.resourcesBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else if (auto BPd = context.get <FrameworksBuildPhase> (ID)) {
+            auto O = context.parseObject(context.frameworksBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else if (auto BPd = context.get <CopyFilesBuildPhase> (ID)) {
+            auto O = context.parseObject(context.copyFilesBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else if (auto BPd = context.get <ShellScriptBuildPhase> (ID)) {
+            auto O = context.parseObject(context.shellScriptBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else if (auto BPd = context.get <AppleScriptBuildPhase> (ID)) {
+            auto O = context.parseObject(context.appleScriptBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else if (auto BPd = context.get <RezBuildPhase> (ID)) {
+            auto O = context.parseObject(context.rezBuildPhases, ID->value(), BPd);
+            if (!O) {
+                return false;
+            }
+
+            _buildPhases.push_back(O);
+        } else {
+            fprintf(stderr, "warning: target '%s' contains unsupported build phase reference to '%s'\n",
+                    _name.c_str(), ID->value().c_str());
+        }
+    }
+
+    return true;
+}
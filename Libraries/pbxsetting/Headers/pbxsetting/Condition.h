@@ -10,8 +10,12 @@
 #ifndef __pbxsetting_Condition_h
 #define __pbxsetting_Condition_h
 
+#include <libutil/Wildcard.h>
+
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace pbxsetting {
 
@@ -20,6 +24,17 @@ public:
 private:
     std::unordered_map<std::string, std::string> _values;
 
+private:
+    /*
+     * The values again, with each key interned and each value compiled
+     * as a pattern, sorted by key. Matching walks these in step.
+     */
+    struct Entry {
+        uint32_t                   key;
+        libutil::Wildcard::Pattern pattern;
+    };
+    std::vector<Entry>                           _entries;
+
 public:
     Condition(std::unordered_map<std::string, std::string> const &values);
     ~Condition();
@@ -32,6 +47,10 @@ public:
     values() const { return _values; }
 
 public:
+    /*
+     * If each value here, as a pattern, matches the value for the same
+     * key in another condition. Doesn't allocate.
+     */
     bool
     match(Condition const &condition) const;
 
@@ -13,9 +13,11 @@
 #include <pbxsetting/Condition.h>
 #include <pbxsetting/Level.h>
 
-#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace pbxsetting {
 
@@ -25,8 +27,31 @@ namespace pbxsetting {
  */
 class Environment {
 private:
-    std::list<Level> _levels;
-    size_t           _offset;
+    /*
+     * Levels are kept in linked lists that are never modified once created.
+     * Copies of an environment share their levels, and adding a level to the
+     * front of a copy shares the rest, so environments built up from the
+     * same base share the base's levels.
+     */
+    struct Node {
+        Level                       level;
+        std::shared_ptr<Node const> next;
+    };
+
+private:
+    std::shared_ptr<Node const> _levels;
+    std::shared_ptr<Node const> _defaultLevels;
+
+private:
+    /*
+     * Resolved settings, keyed by condition and then setting name.
+     */
+    struct Memo {
+        std::mutex                                                                                   mutex;
+        std::unordered_map<std::string, std::unordered_map<std::string, std::string>>               values;
+        std::unordered_map<std::string, std::unordered_map<std::string, std::vector<std::string>>> lists;
+    };
+    std::shared_ptr<Memo> _memo;
 
 public:
     explicit Environment();
@@ -44,6 +69,16 @@ public:
     std::string
     resolve(std::string const &setting) const;
 
+public:
+    /*
+     * Evaluate a build setting in the environment, split as a list. When
+     * settings are remembered, so is the list, and it is only split once.
+     */
+    std::vector<std::string>
+    resolveList(std::string const &setting, Condition const &condition) const;
+    std::vector<std::string>
+    resolveList(std::string const &setting) const;
+
 public:
     /*
      * Expand an expression. Any build settings in that expression are evaluated.
@@ -75,6 +110,20 @@ public:
      */
     void insertBack(Level const &level, bool isDefault);
 
+public:
+    /*
+     * Remember resolved settings, so resolving the same setting again with
+     * the same condition is only a lookup. Copies of the environment share
+     * remembered settings until a level is added to either one.
+     */
+    void setMemoized(bool memoized);
+
+    /*
+     * If resolved settings are remembered.
+     */
+    bool memoized() const
+    { return _memo != nullptr; }
+
 public:
     /*
      * For debugging: print out the contents of all levels.
@@ -82,14 +131,22 @@ public:
     void dump() const;
 
 private:
+    /*
+     * Where a setting was found, for resolving its inherited value. The node
+     * is in the default levels if it is not in the other levels.
+     */
     struct InheritanceContext {
         bool valid;
         std::string setting;
-        std::list<Level>::const_iterator it;
+        Node const *node;
+        bool defaults;
     };
-    std::string resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const;
-    std::string resolveInheritance(Condition const &condition, InheritanceContext const &context) const;
+    void next(Node const **node, bool *defaults) const;
+    static std::shared_ptr<Node const> Append(std::shared_ptr<Node const> const &levels, Level const &level);
+    void resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context, std::string *result) const;
+    void resolveInheritance(Condition const &condition, InheritanceContext const &context, std::string *result) const;
     std::string resolveAssignment(Condition const &condition, std::string const &setting) const;
+    std::string resolveUncached(Condition const &condition, std::string const &setting) const;
 };
 
 }
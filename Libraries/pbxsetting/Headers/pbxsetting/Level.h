@@ -14,6 +14,8 @@
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Value.h>
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <memory>
@@ -28,6 +30,10 @@ namespace pbxsetting {
 class Level {
 private:
     std::shared_ptr<std::vector<Setting>> _settings;
+    /*
+     * Indexes into the settings for each setting name, in order.
+     */
+    std::shared_ptr<std::unordered_map<std::string, std::vector<size_t>>> _index;
 
 public:
     /*
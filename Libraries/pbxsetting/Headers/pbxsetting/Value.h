@@ -30,6 +30,25 @@ namespace pbxsetting {
  * This class stores, not resolves, build setting value.
  */
 class Value {
+public:
+    /*
+     * An operation applied to the value of a setting reference, such
+     * as the `quote` in `$(SETTING:quote)`.
+     */
+    enum class Operation {
+        Identifier,
+        C99ExtIdentifier,
+        RFC1034Identifier,
+        Quote,
+        Lower,
+        Upper,
+        StandardizePath,
+        Base,
+        Dir,
+        File,
+        Suffix,
+    };
+
 public:
     /*
      * A node in the AST describing the value. Can be a literal
@@ -48,6 +67,10 @@ public:
         ext::optional<std::string> _string;
         std::shared_ptr<Value>     _value;
 
+    private:
+        ext::optional<std::string> _setting;
+        std::vector<Operation>     _operations;
+
     public:
         Entry(std::string const &string);
         Entry(std::shared_ptr<Value> const &value);
@@ -63,6 +86,22 @@ public:
         { return _string; }
         std::shared_ptr<Value> const &value() const
         { return _value; }
+
+    public:
+        /*
+         * For references with a literal setting name, the name of the
+         * setting, split from any operations applied to it. Computed
+         * when the entry is created, so that it need not be resolved.
+         */
+        ext::optional<std::string> const &setting() const
+        { return _setting; }
+
+        /*
+         * For references with a literal setting name, the operations
+         * to apply to the setting's value, in order.
+         */
+        std::vector<Operation> const &operations() const
+        { return _operations; }
     };
 
 private:
@@ -93,6 +132,13 @@ public:
     std::string
     raw() const;
 
+public:
+    /*
+     * Parses the name of an operation. Fails for unknown operations.
+     */
+    static ext::optional<Operation>
+    ParseOperation(std::string const &name);
+
 public:
     /*
      * A value representing an empty string.
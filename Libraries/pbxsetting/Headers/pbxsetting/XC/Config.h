@@ -16,6 +16,9 @@
 #include <pbxsetting/Value.h>
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <ext/optional>
 
@@ -83,6 +86,32 @@ public:
         { return _config; }
     };
 
+    /*
+     * Configs already loaded, so a config included by many others, or used
+     * by many build configurations, is only read and parsed once. Safe to
+     * use from multiple threads.
+     */
+    class Cache {
+    private:
+        std::unordered_map<std::string, std::shared_ptr<Config>> _configs;
+        std::mutex                                                     _mutex;
+
+    public:
+        Cache();
+
+    public:
+        /*
+         * Find a loaded config. If it failed to load, finds null.
+         */
+        ext::optional<std::shared_ptr<Config>> find(std::string const &key);
+
+        /*
+         * Keep a loaded config, or null if it failed to load. If another
+         * was kept with the key first, returns that one instead.
+         */
+        std::shared_ptr<Config> insert(std::string const &key, std::shared_ptr<Config> const &config);
+    };
+
 private:
     std::string        _path;
     std::vector<Entry> _contents;
@@ -112,10 +141,12 @@ public:
 
 public:
     /*
-     * Load a config from a file in a filesystem.
+     * Load a config from a file in a filesystem. With a cache, configs
+     * already loaded from the same path are used again, including those
+     * the config includes.
      */
     static ext::optional<Config>
-    Load(libutil::Filesystem const *filesystem, Environment const &environment, std::string const &path);
+    Load(libutil::Filesystem const *filesystem, Environment const &environment, std::string const &path, Cache *cache = nullptr);
 };
 
 } }
@@ -10,13 +10,38 @@
 #include <pbxsetting/Condition.h>
 #include <libutil/Wildcard.h>
 
+#include <algorithm>
+#include <mutex>
+
 using pbxsetting::Condition;
 using libutil::Wildcard;
 
+/*
+ * A small number for each condition key, such as "sdk" or "arch", so keys
+ * compare as integers. Shared by every condition in the process.
+ */
+static uint32_t
+InternKey(std::string const &key)
+{
+    static std::mutex *mutex = new std::mutex();
+    static std::unordered_map<std::string, uint32_t> *keys = new std::unordered_map<std::string, uint32_t>();
+
+    std::lock_guard<std::mutex> lock(*mutex);
+    return keys->insert({ key, static_cast<uint32_t>(keys->size()) }).first->second;
+}
+
 Condition::
 Condition(std::unordered_map<std::string, std::string> const &values) :
     _values(values)
 {
+    _entries.reserve(_values.size());
+    for (auto const &entry : _values) {
+        _entries.push_back({ InternKey(entry.first), Wildcard::Compile(entry.second) });
+    }
+
+    std::sort(_entries.begin(), _entries.end(), [](Entry const &a, Entry const &b) {
+        return a.key < b.key;
+    });
 }
 
 Condition::
@@ -27,14 +52,18 @@ Condition::
 bool Condition::
 match(Condition const &condition) const
 {
-    auto OV = condition._values;
-    for (auto const &TE : _values) {
-        auto OE = OV.find(TE.first);
-        if (OE == OV.end()) {
+    /* Both sorted by key, so each key here is found by walking forward. */
+    auto OE = condition._entries.begin();
+    for (Entry const &TE : _entries) {
+        while (OE != condition._entries.end() && OE->key < TE.key) {
+            ++OE;
+        }
+
+        if (OE == condition._entries.end() || OE->key != TE.key) {
             return false;
         }
 
-        if (!Wildcard::Match(TE.second, OE->second)) {
+        if (!TE.pattern.match(OE->pattern.pattern())) {
             return false;
         }
     }
@@ -63,37 +63,43 @@ Environment(process::Context const *processContext)
     return Level(settings);
 }
 
+/*
+ * The levels below are fixed for the process. Each is parsed and indexed
+ * the first time it is needed; levels share their settings when copied, so
+ * every later environment reuses the same ones.
+ */
+
 Level DefaultSettings::
 Internal(void)
 {
-    std::vector<Setting> settings = {
+    static Level const level = Level({
         Setting::Parse("APPLE_INTERNAL_DEVELOPER_DIR", "$(APPLE_INTERNAL_DIR)/Developer"),
         Setting::Parse("APPLE_INTERNAL_DIR", "/AppleInternal"),
         Setting::Parse("APPLE_INTERNAL_DOCUMENTATION_DIR", "$(APPLE_INTERNAL_DIR)/Documentation"),
         Setting::Parse("APPLE_INTERNAL_LIBRARY_DIR", "$(APPLE_INTERNAL_DIR)/Library"),
         Setting::Parse("APPLE_INTERNAL_TOOLS", "$(APPLE_INTERNAL_DEVELOPER_DIR)/Tools"),
-    };
+    });
 
-    return Level(settings);
+    return level;
 }
 
 Level DefaultSettings::
 Local(void)
 {
-    std::vector<Setting> settings = {
+    static Level const level = Level({
         Setting::Create("LOCAL_ADMIN_APPS_DIR", "/Applications/Utilities"),
         Setting::Create("LOCAL_APPS_DIR", "/Applications"),
         Setting::Create("LOCAL_DEVELOPER_DIR", "/Library/Developer"),
         Setting::Create("LOCAL_LIBRARY_DIR", "/Library"),
-    };
+    });
 
-    return Level(settings);
+    return level;
 }
 
 Level DefaultSettings::
 System(void)
 {
-    std::vector<Setting> settings = {
+    static Level const level = Level({
         Setting::Parse("SYSTEM_ADMIN_APPS_DIR", "/Applications/Utilities"),
         Setting::Parse("SYSTEM_APPS_DIR", "/Applications"),
         Setting::Parse("SYSTEM_CORE_SERVICES_DIR", "/System/Library/CoreServices"),
@@ -120,15 +126,15 @@ System(void)
         Setting::Create("MAC_OS_X_VERSION_ACTUAL", "101101"),
         Setting::Create("MAC_OS_X_VERSION_MAJOR", "101100"),
         Setting::Create("MAC_OS_X_VERSION_MINOR", "1001"),
-    };
+    });
 
-    return Level(settings);
+    return level;
 }
 
 Level DefaultSettings::
 Architecture(void)
 {
-    std::vector<Setting> settings = {
+    static Level const level = Level({
 #if defined(__i386__) || defined(__x86_64__)
         Setting::Create("NATIVE_ARCH_32_BIT", "i386"),
         Setting::Create("NATIVE_ARCH_64_BIT", "x86_64"),
@@ -150,23 +156,23 @@ Architecture(void)
         Setting::Create("NATIVE_ARCH_64_BIT", "UNKNOWN"),
         Setting::Create("NATIVE_ARCH_ACTUAL", "UNKNOWN"),
 #endif
-    };
+    });
 
-    return Level(settings);
+    return level;
 }
 
 Level DefaultSettings::
 Build(void)
 {
-    std::vector<Setting> settings = {
+    static Level const level = Level({
         Setting::Create("XCODE_PRODUCT_BUILD_VERSION", "7C68"),
         Setting::Create("XCODE_VERSION_ACTUAL", "0720"),
         Setting::Create("XCODE_VERSION_MAJOR", "0700"),
         Setting::Create("XCODE_VERSION_MINOR", "0720"),
         Setting::Parse("XCODE_APP_SUPPORT_DIR", "$(DEVELOPER_LIBRARY_DIR)/Xcode"),
-    };
+    });
 
-    return Level(settings);
+    return level;
 }
 
 std::vector<Level> DefaultSettings::
@@ -8,9 +8,12 @@
  */
 
 #include <pbxsetting/Environment.h>
+#include <pbxsetting/Type.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Statistics.h>
 
 #include <algorithm>
+#include <map>
 #include <sstream>
 
 using pbxsetting::Environment;
@@ -18,21 +21,58 @@ using pbxsetting::Level;
 using pbxsetting::Condition;
 using pbxsetting::Setting;
 using pbxsetting::Value;
+using pbxsetting::Type;
 using libutil::FSUtil;
+using libutil::Statistics;
+
+static Statistics::Counter ResolveCalls("Environment::resolveAssignment calls");
+static Statistics::Counter ResolveDepth("Environment::resolveAssignment depth", true);
+
+/*
+ * Resolutions in progress on this thread. Settings referencing other
+ * settings resolve recursively, so this is how deeply they nest.
+ */
+static thread_local int64_t ThreadResolveDepth = 0;
 
 Environment::
 Environment() :
-    _offset(0)
+    _levels       (nullptr),
+    _defaultLevels(nullptr)
+{
+}
+
+void Environment::
+next(Node const **node, bool *defaults) const
+{
+    if (*node != nullptr) {
+        *node = (*node)->next.get();
+    }
+
+    /* After the last level, continue with the default levels. */
+    if (*node == nullptr && !*defaults) {
+        *node = _defaultLevels.get();
+        *defaults = true;
+    }
+}
+
+std::shared_ptr<Environment::Node const> Environment::
+Append(std::shared_ptr<Node const> const &levels, Level const &level)
 {
+    if (levels == nullptr) {
+        return std::make_shared<Node const>(Node { level, nullptr });
+    }
+
+    /* Levels can't be modified, so copy those before the new one. */
+    return std::make_shared<Node const>(Node { levels->level, Append(levels->next, level) });
 }
 
 static std::string
-ProcessOperation(std::string const &value, std::string const &operation)
+ProcessOperation(std::string const &value, Value::Operation operation)
 {
     const std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
     const std::string digits = "0123456789";
 
-    if (operation == "identifier" || operation == "c99extidentifier") {
+    if (operation == Value::Operation::Identifier || operation == Value::Operation::C99ExtIdentifier) {
         // TODO(grp): Support c99extidentifier correctly. Requires Unicode handling.
 
         const std::string begin = alphabet + "_";
@@ -46,7 +86,7 @@ ProcessOperation(std::string const &value, std::string const &operation)
         }
 
         return result;
-    } else if (operation == "rfc1034identifier") {
+    } else if (operation == Value::Operation::RFC1034Identifier) {
         const std::string begin = alphabet;
         const std::string subsequent = alphabet + digits + "-";
         const std::string end = alphabet + digits;
@@ -77,7 +117,7 @@ ProcessOperation(std::string const &value, std::string const &operation)
         }
 
         return result;
-    } else if (operation == "quote") {
+    } else if (operation == Value::Operation::Quote) {
         // FIXME(grp): This is (probably) valid, but not necessarily compatible. Algorithm from Python's shlex.quote().
         if (value.find_first_not_of(alphabet + digits + "@%_-+=:,./") == std::string::npos) {
             return value;
@@ -90,44 +130,60 @@ ProcessOperation(std::string const &value, std::string const &operation)
             }
             return "'" + result + "'";
         }
-    } else if (operation == "lower") {
+    } else if (operation == Value::Operation::Lower) {
         std::string result = value;
         std::transform(result.begin(), result.end(), result.begin(), ::tolower);
         return result;
-    } else if (operation == "upper") {
+    } else if (operation == Value::Operation::Upper) {
         std::string result = value;
         std::transform(result.begin(), result.end(), result.begin(), ::toupper);
         return result;
-    } else if (operation == "standardizepath") {
+    } else if (operation == Value::Operation::StandardizePath) {
         return FSUtil::NormalizePath(value);
-    } else if (operation == "base") {
+    } else if (operation == Value::Operation::Base) {
         return FSUtil::GetBaseNameWithoutExtension(value);
-    } else if (operation == "dir") {
+    } else if (operation == Value::Operation::Dir) {
         return FSUtil::GetDirectoryName(value);
-    } else if (operation == "file") {
+    } else if (operation == Value::Operation::File) {
         return FSUtil::GetBaseName(value);
-    } else if (operation == "suffix") {
+    } else if (operation == Value::Operation::Suffix) {
         return "." + FSUtil::GetFileExtension(value);
     } else {
-        fprintf(stderr, "warning: unknown build setting operation '%s'\n", operation.c_str());
         return value;
     }
 }
 
-std::string Environment::
-resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const
+void Environment::
+resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context, std::string *result) const
 {
-    std::string result;
     for (auto const &entry : value.entries()) {
         switch (entry.type()) {
             case Value::Entry::Type::String: {
-                result += *entry.string();
+                result->append(*entry.string());
                 break;
             }
             case Value::Entry::Type::Value: {
-                std::string resolved = resolveValue(condition, *entry.value(), context);
+                if (entry.setting()) {
+                    /* Literal reference: the setting and operations are already known. */
+                    std::string const &setting = *entry.setting();
+                    if (context.valid && entry.operations().empty() && (setting == context.setting || setting == "inherited")) {
+                        resolveInheritance(condition, context, result);
+                    } else if (entry.operations().empty()) {
+                        result->append(resolveAssignment(condition, setting));
+                    } else {
+                        std::string value = resolveAssignment(condition, setting);
+                        for (Value::Operation operation : entry.operations()) {
+                            value = ProcessOperation(value, operation);
+                        }
+                        result->append(value);
+                    }
+                    break;
+                }
+
+                std::string resolved;
+                resolveValue(condition, *entry.value(), context, &resolved);
                 if (context.valid && (resolved == context.setting || resolved == "inherited")) {
-                    result += resolveInheritance(condition, context);
+                    resolveInheritance(condition, context, result);
                 } else {
                     std::string setting = resolved;
 
@@ -141,45 +197,109 @@ resolveValue(Condition const &condition, Value const &value, InheritanceContext
                     while (colon != std::string::npos) {
                         std::string::size_type next = resolved.find(':', colon + 1);
 
-                        std::string operation = resolved.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
-                        value = ProcessOperation(value, operation);
+                        std::string name = resolved.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
+                        if (ext::optional<Value::Operation> operation = Value::ParseOperation(name)) {
+                            value = ProcessOperation(value, *operation);
+                        } else {
+                            fprintf(stderr, "warning: unknown build setting operation '%s'\n", name.c_str());
+                        }
 
                         colon = next;
                     }
 
-                    result += value;
+                    result->append(value);
                 }
                 break;
             }
         }
     }
-    return result;
 }
 
-std::string Environment::
-resolveInheritance(Condition const &condition, InheritanceContext const &context) const
+void Environment::
+resolveInheritance(Condition const &condition, InheritanceContext const &context, std::string *result) const
 {
     InheritanceContext ctx = context;
-    for (++ctx.it; ctx.it != _levels.end(); ++ctx.it) {
-        auto result = ctx.it->get(ctx.setting, condition);
-        if (result.first) {
-            return resolveValue(condition, result.second, ctx);
+    for (next(&ctx.node, &ctx.defaults); ctx.node != nullptr; next(&ctx.node, &ctx.defaults)) {
+        auto found = ctx.node->level.get(ctx.setting, condition);
+        if (found.first) {
+            resolveValue(condition, found.second, ctx, result);
+            return;
         }
     }
+}
 
-    return "";
+static std::string
+MemoKey(Condition const &condition)
+{
+    if (condition.values().empty()) {
+        return std::string();
+    }
+
+    /* Order the values so equal conditions have the same key. */
+    std::map<std::string, std::string> values(condition.values().begin(), condition.values().end());
+
+    std::string key;
+    for (auto const &value : values) {
+        key += value.first;
+        key += '=';
+        key += value.second;
+        key += '\0';
+    }
+    return key;
 }
 
 std::string Environment::
 resolveAssignment(Condition const &condition, std::string const &setting) const
 {
-    InheritanceContext context = { .valid = true, .setting = setting };
+    ResolveCalls.add();
+
+    if (_memo == nullptr) {
+        return resolveUncached(condition, setting);
+    }
+
+    std::string key = MemoKey(condition);
+
+    {
+        std::lock_guard<std::mutex> lock(_memo->mutex);
+
+        auto &values = _memo->values[key];
+        auto it = values.find(setting);
+        if (it != values.end()) {
+            return it->second;
+        }
+    }
+
+    /*
+     * Resolve without holding the lock: resolution is recursive, and copies
+     * sharing the memo may be resolving on other threads.
+     */
+    std::string value = resolveUncached(condition, setting);
+
+    std::lock_guard<std::mutex> lock(_memo->mutex);
+    _memo->values[key].insert({ setting, value });
+    return value;
+}
 
-    for (context.it = _levels.begin(); context.it != _levels.end(); ++context.it) {
-        Level const &level = *context.it;
+std::string Environment::
+resolveUncached(Condition const &condition, std::string const &setting) const
+{
+    struct Depth {
+        Depth() { ResolveDepth.maximum(++ThreadResolveDepth); }
+        ~Depth() { --ThreadResolveDepth; }
+    } depth;
+
+    InheritanceContext context = { .valid = true, .setting = setting, .node = _levels.get(), .defaults = false };
+    if (context.node == nullptr) {
+        next(&context.node, &context.defaults);
+    }
+
+    for (; context.node != nullptr; next(&context.node, &context.defaults)) {
+        Level const &level = context.node->level;
         auto result = level.get(setting, condition);
         if (result.first) {
-            return resolveValue(condition, result.second, context);
+            std::string value;
+            resolveValue(condition, result.second, context, &value);
+            return value;
         }
     }
 
@@ -193,7 +313,9 @@ resolveAssignment(Condition const &condition, std::string const &setting) const
 std::string Environment::
 expand(Value const &value, Condition const &condition) const
 {
-    return resolveValue(condition, value, { .valid = false });
+    std::string result;
+    resolveValue(condition, value, { .valid = false, .setting = std::string(), .node = nullptr, .defaults = false }, &result);
+    return result;
 }
 
 std::string Environment::
@@ -214,15 +336,56 @@ resolve(std::string const &setting) const
     return resolve(setting, Condition::Empty());
 }
 
+std::vector<std::string> Environment::
+resolveList(std::string const &setting, Condition const &condition) const
+{
+    if (_memo == nullptr) {
+        return Type::ParseList(resolveAssignment(condition, setting));
+    }
+
+    std::string key = MemoKey(condition);
+
+    {
+        std::lock_guard<std::mutex> lock(_memo->mutex);
+
+        auto &lists = _memo->lists[key];
+        auto it = lists.find(setting);
+        if (it != lists.end()) {
+            return it->second;
+        }
+    }
+
+    std::vector<std::string> list = Type::ParseList(resolveAssignment(condition, setting));
+
+    std::lock_guard<std::mutex> lock(_memo->mutex);
+    _memo->lists[key].insert({ setting, list });
+    return list;
+}
+
+std::vector<std::string> Environment::
+resolveList(std::string const &setting) const
+{
+    return resolveList(setting, Condition::Empty());
+}
+
 std::unordered_map<std::string, std::string> Environment::
 computeValues(Condition const &condition) const
 {
+    /*
+     * Resolve through a memoized copy. Each setting is then resolved once,
+     * after the settings it references, no matter how many others use it.
+     */
+    Environment memoized = Environment(*this);
+    memoized.setMemoized(true);
+
     std::unordered_map<std::string, std::string> values;
 
-    for (Level const &level : _levels) {
-        for (Setting const &setting : level.settings()) {
-            if (values.find(setting.name()) == values.end()) {
-                values[setting.name()] = resolve(setting.name(), condition);
+    for (Node const *node : { _levels.get(), _defaultLevels.get() }) {
+        for (; node != nullptr; node = node->next.get()) {
+            for (Setting const &setting : node->level.settings()) {
+                if (values.find(setting.name()) == values.end()) {
+                    values[setting.name()] = memoized.resolve(setting.name(), condition);
+                }
             }
         }
     }
@@ -230,47 +393,63 @@ computeValues(Condition const &condition) const
     return values;
 }
 
+void Environment::
+setMemoized(bool memoized)
+{
+    if (!memoized) {
+        _memo = nullptr;
+    } else if (_memo == nullptr) {
+        _memo = std::make_shared<Memo>();
+    }
+}
+
 void Environment::
 insertFront(Level const &level, bool isDefault)
 {
+    if (_memo != nullptr) {
+        _memo = std::make_shared<Memo>();
+    }
+
     if (!isDefault) {
-        _levels.push_front(level);
-        ++_offset;
+        _levels = std::make_shared<Node const>(Node { level, _levels });
     } else {
-        _levels.insert(std::next(_levels.begin(), _offset), level);
+        _defaultLevels = std::make_shared<Node const>(Node { level, _defaultLevels });
     }
 }
 
 void Environment::
 insertBack(Level const &level, bool isDefault)
 {
+    if (_memo != nullptr) {
+        _memo = std::make_shared<Memo>();
+    }
+
     if (!isDefault) {
-        _levels.insert(std::next(_levels.begin(), _offset), level);
-        ++_offset;
+        _levels = Append(_levels, level);
     } else {
-        _levels.push_back(level);
+        _defaultLevels = Append(_defaultLevels, level);
     }
 }
 
+static void
+DumpLevel(Level const &level)
+{
+    printf("Level:\n");
+    for (Setting const &setting : level.settings()) {
+        printf("    %s = %s\n", setting.name().c_str(), setting.value().raw().c_str());
+    }
+    printf("\n");
+}
+
 void Environment::
 dump() const
 {
-    size_t offset = 0;
-
-    for (Level const &level : _levels) {
-        if (offset == _offset) {
-            printf("=== Default Levels ===\n");
-        } else if (offset == 0) {
-            printf("=== Remaining Levels ===\n");
-        }
-
-        printf("Level:\n");
-        for (Setting const &setting : level.settings()) {
-            printf("    %s = %s\n", setting.name().c_str(), setting.value().raw().c_str());
-        }
-        printf("\n");
+    for (Node const *node = _levels.get(); node != nullptr; node = node->next.get()) {
+        DumpLevel(node->level);
+    }
 
-        ++offset;
+    printf("=== Default Levels ===\n");
+    for (Node const *node = _defaultLevels.get(); node != nullptr; node = node->next.get()) {
+        DumpLevel(node->level);
     }
 }
-
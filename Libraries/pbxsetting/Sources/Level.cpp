@@ -8,16 +8,24 @@
  */
 
 #include <pbxsetting/Level.h>
+#include <libutil/Statistics.h>
 
 using pbxsetting::Level;
 using pbxsetting::Condition;
 using pbxsetting::Setting;
 using pbxsetting::Value;
+using libutil::Statistics;
+
+static Statistics::Counter GetCalls("Level::get calls");
 
 Level::
 Level(std::vector<Setting> const &settings) :
-    _settings(std::make_shared<std::vector<Setting>>(settings))
+    _settings(std::make_shared<std::vector<Setting>>(settings)),
+    _index   (std::make_shared<std::unordered_map<std::string, std::vector<size_t>>>())
 {
+    for (size_t n = 0; n < _settings->size(); ++n) {
+        (*_index)[(*_settings)[n].name()].push_back(n);
+    }
 }
 
 Level::
@@ -28,9 +36,18 @@ Level::
 std::pair<bool, Value> Level::
 get(std::string const &setting, Condition const &condition) const
 {
-    for (auto it = _settings->rbegin(); it != _settings->rend(); ++it) {
-        if (it->match(setting, condition)) {
-            return std::make_pair(true, it->value());
+    GetCalls.add();
+
+    auto it = _index->find(setting);
+    if (it == _index->end()) {
+        return std::make_pair(false, Value::Empty());
+    }
+
+    /* Later settings override earlier ones, so check from the end. */
+    for (auto nt = it->second.rbegin(); nt != it->second.rend(); ++nt) {
+        Setting const &candidate = (*_settings)[*nt];
+        if (candidate.condition().match(condition)) {
+            return std::make_pair(true, candidate.value());
         }
     }
 
@@ -31,6 +31,31 @@ Entry(std::shared_ptr<Value> const &value) :
     _type (Type::Value),
     _value(value)
 {
+    /* Only literal references can be split ahead of time. */
+    if (_value->entries().size() != 1 || _value->entries().front().type() != Type::String) {
+        return;
+    }
+
+    std::string const &reference = *_value->entries().front().string();
+    std::string::size_type colon = reference.find(':');
+
+    std::vector<Operation> operations;
+    while (colon != std::string::npos) {
+        std::string::size_type next = reference.find(':', colon + 1);
+
+        std::string name = reference.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
+        ext::optional<Operation> operation = Value::ParseOperation(name);
+        if (!operation) {
+            /* Leave unknown operations to be reported when resolved. */
+            return;
+        }
+        operations.push_back(*operation);
+
+        colon = next;
+    }
+
+    _setting = reference.substr(0, reference.find(':'));
+    _operations = operations;
 }
 
 bool Value::Entry::
@@ -218,6 +243,36 @@ ParseValue(std::string const &value, size_t from, ValueDelimiter end = kDelimite
     } while (true);
 }
 
+ext::optional<Value::Operation> Value::
+ParseOperation(std::string const &name)
+{
+    if (name == "identifier") {
+        return Operation::Identifier;
+    } else if (name == "c99extidentifier") {
+        return Operation::C99ExtIdentifier;
+    } else if (name == "rfc1034identifier") {
+        return Operation::RFC1034Identifier;
+    } else if (name == "quote") {
+        return Operation::Quote;
+    } else if (name == "lower") {
+        return Operation::Lower;
+    } else if (name == "upper") {
+        return Operation::Upper;
+    } else if (name == "standardizepath") {
+        return Operation::StandardizePath;
+    } else if (name == "base") {
+        return Operation::Base;
+    } else if (name == "dir") {
+        return Operation::Dir;
+    } else if (name == "file") {
+        return Operation::File;
+    } else if (name == "suffix") {
+        return Operation::Suffix;
+    } else {
+        return ext::nullopt;
+    }
+}
+
 Value Value::
 Parse(std::string const &value)
 {
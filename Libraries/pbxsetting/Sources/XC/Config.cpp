@@ -47,6 +47,31 @@ Config::
 {
 }
 
+Config::Cache::
+Cache()
+{
+}
+
+ext::optional<std::shared_ptr<Config>> Config::Cache::
+find(std::string const &key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _configs.find(key);
+    if (it != _configs.end()) {
+        return it->second;
+    }
+
+    return ext::nullopt;
+}
+
+std::shared_ptr<Config> Config::Cache::
+insert(std::string const &key, std::shared_ptr<Config> const &config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _configs.insert({ key, config }).first->second;
+}
+
 Level Config::
 level() const
 {
@@ -98,8 +123,14 @@ ParseInclude(std::string const &value)
     }
 }
 
+static ext::optional<Config>
+Parse(Filesystem const *filesystem, Environment const &environment, std::string const &path, Config::Cache *cache);
+
+static std::shared_ptr<Config>
+LoadShared(Filesystem const *filesystem, Environment const &environment, std::string const &path, Config::Cache *cache);
+
 static ext::optional<Config::Entry>
-ParseDirective(Filesystem const *filesystem, Environment const &environment, std::string const &directory, std::string const &line)
+ParseDirective(Filesystem const *filesystem, Environment const &environment, std::string const &directory, std::string const &line, Config::Cache *cache)
 {
     std::string include = "include";
     if (line.compare(1, 1 + include.size(), include)) {
@@ -111,8 +142,8 @@ ParseDirective(Filesystem const *filesystem, Environment const &environment, std
             path = FSUtil::ResolveRelativePath(path, directory);
 
             /* Load included config. */
-            if (ext::optional<Config> config = Config::Load(filesystem, environment, path)) {
-                return Config::Entry(*parsed, std::make_shared<Config>(*config));
+            if (std::shared_ptr<Config> config = LoadShared(filesystem, environment, path, cache)) {
+                return Config::Entry(*parsed, config);
             } else {
                 /* Failed to load included config. */
                 return ext::nullopt;
@@ -127,8 +158,33 @@ ParseDirective(Filesystem const *filesystem, Environment const &environment, std
     }
 }
 
-ext::optional<Config> Config::
-Load(Filesystem const *filesystem, Environment const &environment, std::string const &path)
+static std::shared_ptr<Config>
+LoadShared(Filesystem const *filesystem, Environment const &environment, std::string const &path, Config::Cache *cache)
+{
+    if (cache == nullptr) {
+        ext::optional<Config> config = Parse(filesystem, environment, path, nullptr);
+        return (config ? std::make_shared<Config>(*config) : nullptr);
+    }
+
+    /*
+     * Included paths can only depend on the developer directory, so configs
+     * loaded with the same one are the same.
+     */
+    std::string key = FSUtil::NormalizePath(path) + '\0' + environment.resolve("DEVELOPER_DIR");
+    if (ext::optional<std::shared_ptr<Config>> config = cache->find(key)) {
+        return *config;
+    }
+
+    /*
+     * Load outside the cache's lock; if another thread loads the same config
+     * at the same time, the first one kept is used.
+     */
+    ext::optional<Config> config = Parse(filesystem, environment, path, cache);
+    return cache->insert(key, config ? std::make_shared<Config>(*config) : nullptr);
+}
+
+static ext::optional<Config>
+Parse(Filesystem const *filesystem, Environment const &environment, std::string const &path, Config::Cache *cache)
 {
     std::string directory = FSUtil::GetDirectoryName(path);
 
@@ -143,7 +199,7 @@ Load(Filesystem const *filesystem, Environment const &environment, std::string c
         contents.push_back('\n');
     }
 
-    std::vector<Entry> entries;
+    std::vector<Config::Entry> entries;
 
     bool slash = false;
     bool comment = false;
@@ -171,7 +227,7 @@ Load(Filesystem const *filesystem, Environment const &environment, std::string c
             if (!line.empty()) {
                 if (line.front() == '#') {
                     /* Parse directive. */
-                    if (ext::optional<Entry> entry = ParseDirective(filesystem, environment, directory, line)) {
+                    if (ext::optional<Config::Entry> entry = ParseDirective(filesystem, environment, directory, line, cache)) {
                         entries.push_back(*entry);
                     } else {
                         /* Failed to parse directive. */
@@ -189,7 +245,7 @@ Load(Filesystem const *filesystem, Environment const &environment, std::string c
 
                         /* Parse setting value. */
                         if (ext::optional<Setting> setting = Setting::Parse(line)) {
-                            Entry entry = Config::Entry(*setting);
+                            Config::Entry entry = Config::Entry(*setting);
                             entries.push_back(entry);
                         } else {
                             /* Failed to parse setting. */
@@ -210,3 +266,16 @@ Load(Filesystem const *filesystem, Environment const &environment, std::string c
     return Config(path, entries);
 }
 
+ext::optional<Config> Config::
+Load(Filesystem const *filesystem, Environment const &environment, std::string const &path, Cache *cache)
+{
+    if (cache == nullptr) {
+        return Parse(filesystem, environment, path, nullptr);
+    }
+
+    if (std::shared_ptr<Config> config = LoadShared(filesystem, environment, path, cache)) {
+        return *config;
+    }
+
+    return ext::nullopt;
+}
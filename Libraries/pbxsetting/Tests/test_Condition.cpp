@@ -62,3 +62,14 @@ TEST(Condition, MatchMultiple)
     EXPECT_FALSE(arch_sdk.match(arch));
 }
 
+
+TEST(Condition, MatchUnordered)
+{
+    /* Keys match regardless of the order conditions were created in. */
+    Condition variant_sdk = Condition(std::unordered_map<std::string, std::string>({ { "variant", "normal" }, { "sdk", "iphoneos*" } }));
+    Condition sdk_arch_variant = Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos10.0" }, { "arch", "arm64" }, { "variant", "normal" } }));
+    Condition sdk_arch = Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos10.0" }, { "arch", "arm64" } }));
+    EXPECT_TRUE(variant_sdk.match(sdk_arch_variant));
+    EXPECT_FALSE(variant_sdk.match(sdk_arch));
+    EXPECT_TRUE(Condition::Empty().match(sdk_arch));
+}
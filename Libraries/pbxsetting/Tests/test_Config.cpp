@@ -95,3 +95,35 @@ TEST(Config, Include)
     EXPECT_EQ(config->contents().at(0).config()->contents().at(0).setting()->value(), Value::String("VALUE"));
 }
 
+
+TEST(Config, Cache)
+{
+    Environment environment = Environment();
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("common.xcconfig", Contents("NAME = VALUE")),
+        MemoryFilesystem::Entry::File("a.xcconfig", Contents("#include \"common.xcconfig\"")),
+        MemoryFilesystem::Entry::File("b.xcconfig", Contents("#include \"./common.xcconfig\"")),
+    });
+
+    /* Included configs are loaded once, even through different paths. */
+    Config::Cache cache;
+    auto a = Config::Load(&filesystem, environment, "/a.xcconfig", &cache);
+    auto b = Config::Load(&filesystem, environment, "/b.xcconfig", &cache);
+    ASSERT_NE(a, ext::nullopt);
+    ASSERT_NE(b, ext::nullopt);
+    ASSERT_EQ(a->contents().size(), 1);
+    ASSERT_EQ(b->contents().size(), 1);
+    EXPECT_EQ(a->contents().at(0).config(), b->contents().at(0).config());
+
+    /* Changes aren't seen once loaded. */
+    ASSERT_TRUE(filesystem.write(Contents("#include \"missing.xcconfig\""), "/a.xcconfig"));
+    auto again = Config::Load(&filesystem, environment, "/a.xcconfig", &cache);
+    ASSERT_NE(again, ext::nullopt);
+    EXPECT_EQ(again->contents().at(0).config(), a->contents().at(0).config());
+
+    /* Failures are kept too. */
+    EXPECT_EQ(Config::Load(&filesystem, environment, "/missing.xcconfig", &cache), ext::nullopt);
+    ASSERT_TRUE(filesystem.write(Contents("NAME = VALUE"), "/missing.xcconfig"));
+    EXPECT_EQ(Config::Load(&filesystem, environment, "/missing.xcconfig", &cache), ext::nullopt);
+    EXPECT_NE(Config::Load(&filesystem, environment, "/missing.xcconfig"), ext::nullopt);
+}
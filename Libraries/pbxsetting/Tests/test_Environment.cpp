@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <pbxsetting/Environment.h>
 
+using pbxsetting::Condition;
 using pbxsetting::Environment;
 using pbxsetting::Level;
 using pbxsetting::Setting;
@@ -120,11 +121,13 @@ TEST(Environment, Operations)
         Setting::Parse("FILE", "$(PATH:file)"),
         Setting::Parse("SUFFIX", "$(PATH:suffix)"),
         Setting::Parse("MULTIPLE", "$(COMPLEX:identifier:upper)"),
+        Setting::Parse("NESTED", "$($(NAME):lower)"),
     }), false);
     environment.insertBack(Level({
         Setting::Parse("BASIC", "Hello, world."),
         Setting::Parse("COMPLEX", "-_'hello%."),
         Setting::Parse("PATH", "/path/to/../file.ext"),
+        Setting::Parse("NAME", "BASIC"),
     }), false);
     EXPECT_EQ(environment.resolve("IDENTIFIER"), "___hello__");
     EXPECT_EQ(environment.resolve("C99IDENTIFIER"), "___hello__");
@@ -137,6 +140,7 @@ TEST(Environment, Operations)
     EXPECT_EQ(environment.resolve("FILE"), "file.ext");
     EXPECT_EQ(environment.resolve("SUFFIX"), ".ext");
     EXPECT_EQ(environment.resolve("MULTIPLE"), "___HELLO__");
+    EXPECT_EQ(environment.resolve("NESTED"), "hello, world.");
 }
 
 TEST(Environment, Value)
@@ -172,3 +176,131 @@ TEST(Environment, Default)
     EXPECT_EQ(env.resolve("THREE"), "3");
 }
 
+
+TEST(Environment, Memoized)
+{
+    Environment env;
+    env.setMemoized(true);
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("TWO", "$(ONE)-two"),
+    }), false);
+    EXPECT_EQ(env.resolve("TWO"), "one-two");
+    EXPECT_EQ(env.resolve("TWO"), "one-two");
+
+    Environment copy = Environment(env);
+    copy.insertFront(Level({
+        Setting::Parse("ONE", "1"),
+    }), false);
+    EXPECT_EQ(copy.resolve("TWO"), "1-two");
+    EXPECT_EQ(env.resolve("TWO"), "one-two");
+
+    env.insertFront(Level({
+        Setting::Parse("TWO", "2"),
+    }), false);
+    EXPECT_EQ(env.resolve("TWO"), "2");
+}
+
+TEST(Environment, ResolveList)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("LIST", "$(ONE) \"two three\" four"),
+    }), false);
+    EXPECT_EQ(std::vector<std::string>({ "one", "two three", "four" }), env.resolveList("LIST"));
+    EXPECT_TRUE(env.resolveList("EMPTY").empty());
+
+    env.setMemoized(true);
+    EXPECT_EQ(std::vector<std::string>({ "one", "two three", "four" }), env.resolveList("LIST"));
+    EXPECT_EQ(std::vector<std::string>({ "one", "two three", "four" }), env.resolveList("LIST"));
+
+    env.insertFront(Level({
+        Setting::Parse("ONE", "1"),
+    }), false);
+    EXPECT_EQ(std::vector<std::string>({ "1", "two three", "four" }), env.resolveList("LIST"));
+}
+
+TEST(Environment, MemoizedCondition)
+{
+    Condition armv7 = Condition(std::unordered_map<std::string, std::string>({ { "arch", "armv7" } }));
+    Condition i386 = Condition(std::unordered_map<std::string, std::string>({ { "arch", "i386" } }));
+
+    Environment env;
+    env.setMemoized(true);
+    env.insertBack(Level({
+        Setting::Parse("ARCH", "any"),
+        Setting("ARCH", armv7, Value::String("armv7")),
+    }), false);
+    EXPECT_EQ(env.resolve("ARCH", armv7), "armv7");
+    EXPECT_EQ(env.resolve("ARCH", i386), "any");
+    EXPECT_EQ(env.resolve("ARCH"), "any");
+    EXPECT_EQ(env.resolve("ARCH", armv7), "armv7");
+}
+
+TEST(Environment, ComputeValues)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "$(TWO)-one"),
+        Setting::Parse("TWO", "$(THREE)-two"),
+    }), false);
+    env.insertBack(Level({
+        Setting::Parse("TWO", "2"),
+        Setting::Parse("THREE", "three"),
+        Setting::Parse("FOUR", "$(inherited) four"),
+    }), false);
+    env.insertBack(Level({
+        Setting::Parse("FOUR", "4"),
+    }), false);
+
+    std::unordered_map<std::string, std::string> values = env.computeValues(Condition::Empty());
+    EXPECT_EQ(values.size(), 4);
+    EXPECT_EQ(values["ONE"], "three-two-one");
+    EXPECT_EQ(values["TWO"], "three-two");
+    EXPECT_EQ(values["THREE"], "three");
+    EXPECT_EQ(values["FOUR"], "4 four");
+    EXPECT_FALSE(env.memoized());
+}
+
+TEST(Environment, Copies)
+{
+    Environment base;
+    base.insertBack(Level({
+        Setting::Parse("BASE", "base"),
+        Setting::Parse("VALUE", "base"),
+    }), false);
+    base.insertBack(Level({
+        Setting::Parse("DEFAULT", "default"),
+    }), true);
+
+    /* Changes to a copy don't change the environment it was copied from. */
+    Environment front = Environment(base);
+    front.insertFront(Level({
+        Setting::Parse("VALUE", "$(inherited) front"),
+    }), false);
+    front.insertFront(Level({
+        Setting::Parse("DEFAULT", "$(inherited) first"),
+    }), true);
+
+    Environment back = Environment(base);
+    back.insertBack(Level({
+        Setting::Parse("VALUE", "back"),
+        Setting::Parse("BACK", "back"),
+    }), false);
+    back.insertBack(Level({
+        Setting::Parse("DEFAULT", "last"),
+    }), true);
+
+    EXPECT_EQ(base.resolve("VALUE"), "base");
+    EXPECT_EQ(base.resolve("DEFAULT"), "default");
+    EXPECT_EQ(base.resolve("BACK"), "");
+
+    EXPECT_EQ(front.resolve("VALUE"), "base front");
+    EXPECT_EQ(front.resolve("DEFAULT"), "default first");
+    EXPECT_EQ(front.resolve("BASE"), "base");
+
+    EXPECT_EQ(back.resolve("VALUE"), "base");
+    EXPECT_EQ(back.resolve("DEFAULT"), "default");
+    EXPECT_EQ(back.resolve("BACK"), "back");
+}
@@ -0,0 +1,67 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxsetting/Level.h>
+
+using pbxsetting::Condition;
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+
+TEST(Level, Get)
+{
+    Level level = Level({
+        Setting::Create("FIRST", "first"),
+        Setting::Create("SECOND", "second"),
+    });
+
+    auto first = level.get("FIRST", Condition::Empty());
+    EXPECT_TRUE(first.first);
+    EXPECT_EQ(Value::String("first"), first.second);
+
+    auto second = level.get("SECOND", Condition::Empty());
+    EXPECT_TRUE(second.first);
+    EXPECT_EQ(Value::String("second"), second.second);
+
+    auto missing = level.get("MISSING", Condition::Empty());
+    EXPECT_FALSE(missing.first);
+}
+
+TEST(Level, Override)
+{
+    Level level = Level({
+        Setting::Create("SETTING", "first"),
+        Setting::Create("OTHER", "other"),
+        Setting::Create("SETTING", "second"),
+    });
+
+    auto result = level.get("SETTING", Condition::Empty());
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ(Value::String("second"), result.second);
+}
+
+TEST(Level, Condition)
+{
+    Condition armv7 = Condition(std::unordered_map<std::string, std::string>({ { "arch", "armv7" } }));
+    Condition i386 = Condition(std::unordered_map<std::string, std::string>({ { "arch", "i386" } }));
+
+    Level level = Level({
+        Setting::Create("SETTING", "any"),
+        Setting("SETTING", armv7, Value::String("armv7")),
+    });
+
+    auto matched = level.get("SETTING", armv7);
+    EXPECT_TRUE(matched.first);
+    EXPECT_EQ(Value::String("armv7"), matched.second);
+
+    auto unmatched = level.get("SETTING", i386);
+    EXPECT_TRUE(unmatched.first);
+    EXPECT_EQ(Value::String("any"), unmatched.second);
+}
@@ -209,3 +209,26 @@ TEST(Value, Add)
     ASSERT_EQ(string_string.entries().at(0).type(), Value::Entry::Type::String);
     EXPECT_EQ(*string_string.entries().at(0).string(), "teststring");
 }
+
+TEST(Value, Reference)
+{
+    Value simple = Value::Parse("$(SIMPLE)");
+    ASSERT_EQ(simple.entries().size(), 1);
+    ASSERT_TRUE(simple.entries().at(0).setting());
+    EXPECT_EQ(*simple.entries().at(0).setting(), "SIMPLE");
+    EXPECT_TRUE(simple.entries().at(0).operations().empty());
+
+    Value operations = Value::Parse("$(OPERATIONS:identifier:upper)");
+    ASSERT_EQ(operations.entries().size(), 1);
+    ASSERT_TRUE(operations.entries().at(0).setting());
+    EXPECT_EQ(*operations.entries().at(0).setting(), "OPERATIONS");
+    EXPECT_EQ(operations.entries().at(0).operations(), std::vector<Value::Operation>({ Value::Operation::Identifier, Value::Operation::Upper }));
+
+    Value nested = Value::Parse("$(NESTED_$(INNER))");
+    ASSERT_EQ(nested.entries().size(), 1);
+    EXPECT_FALSE(nested.entries().at(0).setting());
+
+    Value unknown = Value::Parse("$(UNKNOWN:unknown)");
+    ASSERT_EQ(unknown.entries().size(), 1);
+    EXPECT_FALSE(unknown.entries().at(0).setting());
+}
@@ -0,0 +1,195 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxsetting/Condition.h>
+#include <pbxsetting/DefaultSettings.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Level.h>
+#include <pbxsetting/Setting.h>
+#include <pbxsetting/Value.h>
+#include <pbxsetting/XC/Config.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+#include <cstdlib>
+
+using pbxsetting::Condition;
+using pbxsetting::DefaultSettings;
+using pbxsetting::Environment;
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+using libutil::MemoryFilesystem;
+
+/*
+ * Runs a function repeatedly and prints the average time per iteration. The
+ * function returns a size that is summed, so its work can't be optimized out.
+ */
+static void
+Benchmark(std::string const &name, size_t iterations, std::function<size_t()> const &function)
+{
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        checksum += function();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    printf("%-40s %12.2f us (%zu)\n", name.c_str(), microseconds / static_cast<double>(iterations), checksum);
+}
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+/*
+ * The levels of a typical iOS application target, from the front: command
+ * line overrides, the target, its xcconfig, the project, and the SDK. The
+ * default levels are behind those.
+ */
+static Environment
+TargetEnvironment(process::Context const *processContext)
+{
+    Environment environment;
+    for (Level const &level : DefaultSettings::Levels(processContext)) {
+        environment.insertFront(level, true);
+    }
+
+    environment.insertFront(Level({
+        Setting::Parse("SDKROOT", "/Applications/Xcode.app/Contents/Developer/Platforms/iPhoneOS.platform/Developer/SDKs/iPhoneOS.sdk"),
+        Setting::Parse("SDK_NAME", "iphoneos"),
+        Setting::Parse("PLATFORM_NAME", "iphoneos"),
+        Setting::Parse("PLATFORM_DIR", "/Applications/Xcode.app/Contents/Developer/Platforms/iPhoneOS.platform"),
+        Setting::Parse("PLATFORM_DEVELOPER_BIN_DIR", "$(PLATFORM_DIR)/Developer/usr/bin"),
+        Setting::Parse("IPHONEOS_DEPLOYMENT_TARGET", "9.0"),
+        Setting::Parse("DEPLOYMENT_TARGET_SETTING_NAME", "IPHONEOS_DEPLOYMENT_TARGET"),
+        Setting::Parse("VALID_ARCHS", "arm64 armv7 armv7s"),
+        Setting::Parse("ARCHS_STANDARD", "armv7 arm64"),
+        Setting::Parse("CODE_SIGN_IDENTITY", "iPhone Developer"),
+        Setting::Parse("TARGETED_DEVICE_FAMILY", "1,2"),
+    }), false);
+
+    environment.insertFront(Level({
+        Setting::Parse("PROJECT_NAME", "Application"),
+        Setting::Parse("PROJECT_DIR", "/Users/user/Application"),
+        Setting::Parse("SRCROOT", "$(PROJECT_DIR)"),
+        Setting::Parse("ARCHS", "$(ARCHS_STANDARD)"),
+        Setting::Parse("CONFIGURATION", "Debug"),
+        Setting::Parse("CLANG_ENABLE_MODULES", "YES"),
+        Setting::Parse("CLANG_ENABLE_OBJC_ARC", "YES"),
+        Setting::Parse("GCC_OPTIMIZATION_LEVEL", "0"),
+        Setting::Parse("GCC_PREPROCESSOR_DEFINITIONS", "DEBUG=1 $(inherited)"),
+        Setting::Parse("HEADER_SEARCH_PATHS", "$(inherited) $(SRCROOT)/Vendor/include"),
+        Setting::Parse("OTHER_CFLAGS", "-DPROJECT=$(PROJECT_NAME:c99extidentifier)"),
+    }), false);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("Base.xcconfig", Contents(
+            "WARNING_CFLAGS = -Wall -Wextra\n"
+            "GCC_TREAT_WARNINGS_AS_ERRORS = YES\n"
+            "OTHER_LDFLAGS = $(inherited) -ObjC\n"
+            "OTHER_LDFLAGS[sdk=iphonesimulator*] = $(inherited) -framework XCTest\n"
+            "SWIFT_VERSION = 3.0\n")),
+        MemoryFilesystem::Entry::File("Application.xcconfig", Contents(
+            "#include \"Base.xcconfig\"\n"
+            "PRODUCT_BUNDLE_IDENTIFIER = com.example.$(PRODUCT_NAME:rfc1034identifier)\n"
+            "INFOPLIST_FILE = $(SRCROOT)/$(PRODUCT_NAME)/Info.plist\n"
+            "LD_RUNPATH_SEARCH_PATHS = $(inherited) @executable_path/Frameworks\n"
+            "HEADER_SEARCH_PATHS = $(inherited) $(SRCROOT)/$(PRODUCT_NAME)/include\n"
+            "OTHER_CFLAGS[arch=arm64] = $(inherited) -DARM64=1\n")),
+    });
+    if (ext::optional<pbxsetting::XC::Config> config = pbxsetting::XC::Config::Load(&filesystem, environment, "/Application.xcconfig")) {
+        environment.insertFront(config->level(), false);
+    }
+
+    environment.insertFront(Level({
+        Setting::Parse("TARGET_NAME", "Application"),
+        Setting::Parse("PRODUCT_NAME", "$(TARGET_NAME)"),
+        Setting::Parse("PRODUCT_TYPE", "com.apple.product-type.application"),
+        Setting::Parse("WRAPPER_EXTENSION", "app"),
+        Setting::Parse("FULL_PRODUCT_NAME", "$(PRODUCT_NAME).$(WRAPPER_EXTENSION)"),
+        Setting::Parse("CONTENTS_FOLDER_PATH", "$(FULL_PRODUCT_NAME)"),
+        Setting::Parse("EXECUTABLE_FOLDER_PATH", "$(CONTENTS_FOLDER_PATH)"),
+        Setting::Parse("EXECUTABLE_PATH", "$(EXECUTABLE_FOLDER_PATH)/$(PRODUCT_NAME)"),
+        Setting::Parse("TARGET_BUILD_DIR", "$(BUILT_PRODUCTS_DIR)"),
+        Setting::Parse("OTHER_CFLAGS", "$(inherited) -DTARGET=$(TARGET_NAME)"),
+    }), false);
+
+    environment.insertFront(Level({
+        Setting::Parse("SYMROOT", "/tmp/Build/Products"),
+        Setting::Parse("OBJROOT", "/tmp/Build/Intermediates"),
+        Setting::Parse("GCC_PREPROCESSOR_DEFINITIONS", "$(inherited) OVERRIDE=1"),
+    }), false);
+
+    return environment;
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t iterations = (argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000);
+
+    process::MemoryContext processContext = process::MemoryContext(
+        "/usr/bin/xcbuild",
+        "/Users/user/Application",
+        { },
+        { { "HOME", "/Users/user" }, { "PATH", "/usr/bin:/bin" }, { "USER", "user" } },
+        501,
+        20,
+        "user",
+        "staff");
+
+    Environment environment = TargetEnvironment(&processContext);
+    Condition condition = Condition({ { "sdk", "iphoneos" }, { "arch", "arm64" }, { "variant", "normal" } });
+    Value executable = Value::Parse("$(TARGET_BUILD_DIR)/$(EXECUTABLE_PATH)");
+    Value flags = Value::Parse("$(OTHER_CFLAGS) $(WARNING_CFLAGS) -I$(HEADER_SEARCH_PATHS) -D$(GCC_PREPROCESSOR_DEFINITIONS)");
+
+    Benchmark("Value::Parse (literal)", iterations * 100, [] {
+        return Value::Parse("/usr/bin/clang").raw().size();
+    });
+    Benchmark("Value::Parse (nested)", iterations * 100, [] {
+        return Value::Parse("$(PRODUCT_NAME:rfc1034identifier)-$(CURRENT_PROJECT_VERSION_$(WRAPPER_EXTENSION))").raw().size();
+    });
+
+    Benchmark("Environment::resolve", iterations, [&] {
+        return environment.resolve("EXECUTABLE_PATH", condition).size()
+            + environment.resolve("OTHER_CFLAGS", condition).size()
+            + environment.resolve("OTHER_LDFLAGS", condition).size();
+    });
+    Benchmark("Environment::expand", iterations, [&] {
+        return environment.expand(executable, condition).size()
+            + environment.expand(flags, condition).size();
+    });
+    Benchmark("Environment::computeValues", iterations / 10 + 1, [&] {
+        return environment.computeValues(condition).size();
+    });
+
+    /* Memoized copies share the levels, but start without remembered settings. */
+    Benchmark("Environment::resolve (memoized)", iterations, [&] {
+        Environment memoized = Environment(environment);
+        memoized.setMemoized(true);
+        size_t size = 0;
+        for (size_t i = 0; i < 10; ++i) {
+            size += memoized.resolve("EXECUTABLE_PATH", condition).size();
+            size += memoized.resolve("OTHER_CFLAGS", condition).size();
+        }
+        return size;
+    });
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxspec_DomainSet_h
+#define __pbxspec_DomainSet_h
+
+#include <pbxspec/PBX/Specification.h>
+#include <pbxspec/Types.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pbxspec {
+
+class Manager;
+
+/*
+ * A list of domains to find specifications in, with each type's
+ * specifications merged across the domains up front. Finding a
+ * specification doesn't search the domains. Has the specifications, and
+ * their inheritance, as registered when it was created.
+ */
+class DomainSet {
+public:
+    typedef std::shared_ptr<DomainSet const> shared_ptr;
+
+private:
+    std::vector<std::string>                                                                 _domains;
+    std::array<PBX::Specification::vector, Types::Count>                                     _specifications;
+    std::array<std::unordered_map<std::string, PBX::Specification::shared_ptr>, Types::Count> _identifiers;
+
+private:
+    explicit DomainSet(std::vector<std::string> const &domains);
+
+public:
+    /*
+     * The domains, in the order they are searched.
+     */
+    std::vector<std::string> const &domains() const
+    { return _domains; }
+
+public:
+    /*
+     * The specifications of a type, in domain order.
+     */
+    PBX::Specification::vector const &
+    specifications(char const *type) const;
+
+    /*
+     * The first specification of a type with an identifier.
+     */
+    PBX::Specification::shared_ptr
+    specification(char const *type, std::string const &identifier) const;
+
+    /*
+     * The first specification of a type with an identifier, as that type.
+     */
+    template<typename T>
+    typename T::shared_ptr
+    find(std::string const &identifier) const
+    { return std::static_pointer_cast<T>(specification(T::Type(), identifier)); }
+
+public:
+    /*
+     * Merge the specifications in the domains, in the same order the
+     * manager would search them.
+     */
+    static DomainSet::shared_ptr
+    Create(Manager const &manager, std::vector<std::string> const &domains);
+};
+
+}
+
+#endif  // !__pbxspec_DomainSet_h
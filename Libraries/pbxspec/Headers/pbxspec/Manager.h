@@ -23,11 +23,13 @@
 #include <pbxspec/PBX/ProductType.h>
 #include <pbxspec/PBX/Specification.h>
 #include <pbxspec/PBX/Tool.h>
+#include <pbxspec/Types.h>
 
-#include <map>
+#include <array>
 #include <memory>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
@@ -40,9 +42,20 @@ public:
     typedef std::shared_ptr <Manager> shared_ptr;
 
 private:
-    std::unordered_set<std::string>                                           _domains;
-    std::map<std::string, std::map<char const *, PBX::Specification::vector>> _specifications;
-    PBX::BuildRule::vector                                                    _buildRules;
+    /*
+     * The specifications registered in a domain, by type index, and also
+     * by identifier for looking them up without searching.
+     */
+    struct DomainSpecifications {
+        std::string                                                                              name;
+        std::array<PBX::Specification::vector, Types::Count>                                     specifications;
+        std::array<std::unordered_map<std::string, PBX::Specification::shared_ptr>, Types::Count> identifiers;
+    };
+
+private:
+    std::unordered_set<std::string>   _domains;
+    std::vector<DomainSpecifications> _specifications;
+    PBX::BuildRule::vector            _buildRules;
 
 public:
     Manager();
@@ -130,6 +143,7 @@ public:
     bool registerBuildRules(libutil::Filesystem const *filesystem, std::string const &path);
 
 private:
+    DomainSpecifications const *findDomain(std::string const &name) const;
     void addSpecification(PBX::Specification::shared_ptr const &specification);
     bool inheritSpecification(PBX::Specification::shared_ptr const &specification);
 
@@ -21,6 +21,7 @@
 namespace plist { class Object; }
 namespace plist { class Dictionary; }
 namespace pbxsetting { class Setting; }
+namespace pbxspec { class Context; }
 
 namespace pbxspec { namespace PBX {
 
@@ -47,7 +48,7 @@ public:
 protected:
     std::string                              _name;
     ext::optional<std::string>               _displayName;
-    plist::Object                           *_displayValues;
+    std::shared_ptr<plist::Object const>     _displayValues;
     std::string                              _type;
     ext::optional<std::string>               _uiType;
     ext::optional<std::string>               _category;
@@ -63,11 +64,11 @@ protected:
     ext::optional<pbxsetting::Value>         _commandLineFlag;
     ext::optional<pbxsetting::Value>         _commandLineFlagIfFalse;
     ext::optional<pbxsetting::Value>         _commandLinePrefixFlag;
-    plist::Object                            *_commandLineArgs;
-    plist::Object                            *_additionalLinkerArgs;
+    std::shared_ptr<plist::Object const>     _commandLineArgs;
+    std::shared_ptr<plist::Object const>     _additionalLinkerArgs;
     ext::optional<pbxsetting::Value>          _defaultValue;
-    plist::Object                            *_allowedValues;
-    plist::Object                            *_values;
+    std::shared_ptr<plist::Object const>     _allowedValues;
+    std::shared_ptr<plist::Object const>     _values;
     ext::optional<std::vector<std::string>>  _architectures;
     ext::optional<std::vector<std::string>>  _fileTypes;
     ext::optional<std::vector<std::string>>  _conditionFlavors;
@@ -133,15 +134,15 @@ public:
     inline ext::optional<pbxsetting::Value> const &defaultValue() const
     { return _defaultValue; }
     inline plist::Object const *allowedValues() const
-    { return _allowedValues; }
+    { return _allowedValues.get(); }
     inline plist::Object const *values() const
-    { return _values; }
+    { return _values.get(); }
 
 public:
     inline ext::optional<std::string> const &commandLineCondition() const
     { return _commandLineCondition; }
     inline plist::Object const *commandLineArgs() const
-    { return _commandLineArgs; }
+    { return _commandLineArgs.get(); }
     inline ext::optional<pbxsetting::Value> const &commandLineFlag() const
     { return _commandLineFlag; }
     inline ext::optional<pbxsetting::Value> const &commandLineFlagIfFalse() const
@@ -151,7 +152,7 @@ public:
 
 public:
     inline plist::Object const *additionalLinkerArgs() const
-    { return _additionalLinkerArgs; }
+    { return _additionalLinkerArgs.get(); }
 
 public:
     inline bool isCommandInput() const
@@ -213,7 +214,7 @@ public:
     ext::optional<pbxsetting::Setting> defaultSetting(void) const;
 
 protected:
-    bool parse(plist::Dictionary const *dict);
+    bool parse(Context *context, plist::Dictionary const *dict);
 
 public:
     static PropertyOption::shared_ptr Create(plist::Dictionary const *dict);
@@ -56,7 +56,7 @@ protected:
     ext::optional<std::unordered_set<std::string>> _deletedProperties;
     ext::optional<std::unordered_map<std::string, pbxsetting::Value>> _environmentVariables;
     ext::optional<std::vector<int>>                _successExitCodes;
-    plist::Object                                 *_commandOutputParser;
+    std::shared_ptr<plist::Object const>          _commandOutputParser;
     ext::optional<bool>                            _isAbstract;
     ext::optional<bool>                            _isArchitectureNeutral;
     ext::optional<bool>                            _caresAboutInclusionDependencies;
@@ -156,7 +156,7 @@ public:
 
 public:
     inline plist::Object const *commandOutputParser() const
-    { return _commandOutputParser; }
+    { return _commandOutputParser.get(); }
 
 public:
     inline bool isAbstract() const
@@ -10,6 +10,9 @@
 #ifndef __pbxspec_Types_h
 #define __pbxspec_Types_h
 
+#include <cstddef>
+#include <ext/optional>
+
 namespace pbxspec { namespace Types {
 
 extern char const * const Architecture;
@@ -24,6 +27,22 @@ extern char const * const PackageType;
 extern char const * const ProductType;
 extern char const * const Tool;
 
+/*
+ * The number of types above. Each has an index below this, so
+ * specifications can be stored in a table by type.
+ */
+static size_t const Count = 11;
+
+/*
+ * The index of one of the types above, compared by pointer.
+ */
+ext::optional<size_t> Index(char const *type);
+
+/*
+ * The type with an index.
+ */
+char const *Name(size_t index);
+
 } }
 
 #endif  // !__pbxspec_Types_h
@@ -25,5 +25,6 @@
 #include <pbxspec/PBX/Tool.h>
 
 #include <pbxspec/Manager.h>
+#include <pbxspec/DomainSet.h>
 
 #endif  // !__pbxspec_pbxspec_h
@@ -11,6 +11,9 @@
 #define __pbxspec_Context_h
 
 #include <pbxspec/Manager.h>
+#include <plist/Object.h>
+
+#include <memory>
 
 namespace pbxspec {
 
@@ -20,6 +23,27 @@ public:
 
 public:
     std::string defaultType;
+
+public:
+    /*
+     * The property list being parsed, if it is shared, such as from the
+     * file cache. Shared property lists are never changed.
+     */
+    std::shared_ptr<plist::Object const> contents;
+
+public:
+    /*
+     * Keep part of the property list being parsed. If the property list is
+     * shared, the part keeps the whole list alive rather than being copied.
+     */
+    std::shared_ptr<plist::Object const> share(plist::Object const *object) const
+    {
+        if (contents != nullptr) {
+            return std::shared_ptr<plist::Object const>(contents, object);
+        } else {
+            return std::shared_ptr<plist::Object const>(object->copy());
+        }
+    }
 };
 
 }
@@ -14,6 +14,7 @@
 #include <pbxsetting/Setting.h>
 #include <pbxspec/PBX/PropertyOption.h>
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -40,6 +41,17 @@ public:
         return current ?: base;
     }
 
+    /*
+     * Override the base value with the current value. Shared values, such
+     * as parts of property lists, are shared with the base, not copied.
+     */
+    template<typename T>
+    static std::shared_ptr<T>
+    Override(std::shared_ptr<T> const &current, std::shared_ptr<T> const &base)
+    {
+        return (current != nullptr ? current : base);
+    }
+
 public:
     /*
      * Merge two vectors.
@@ -0,0 +1,68 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxspec/DomainSet.h>
+#include <pbxspec/Manager.h>
+
+using pbxspec::DomainSet;
+using pbxspec::Manager;
+using pbxspec::PBX::Specification;
+namespace Types = pbxspec::Types;
+
+DomainSet::
+DomainSet(std::vector<std::string> const &domains) :
+    _domains(domains)
+{
+}
+
+Specification::vector const &DomainSet::
+specifications(char const *type) const
+{
+    static Specification::vector const empty;
+
+    ext::optional<size_t> index = Types::Index(type);
+    if (!index) {
+        return empty;
+    }
+
+    return _specifications[*index];
+}
+
+Specification::shared_ptr DomainSet::
+specification(char const *type, std::string const &identifier) const
+{
+    ext::optional<size_t> index = Types::Index(type);
+    if (!index) {
+        return nullptr;
+    }
+
+    auto it = _identifiers[*index].find(identifier);
+    if (it == _identifiers[*index].end()) {
+        return nullptr;
+    }
+
+    return it->second;
+}
+
+DomainSet::shared_ptr DomainSet::
+Create(Manager const &manager, std::vector<std::string> const &domains)
+{
+    std::shared_ptr<DomainSet> domainSet = std::shared_ptr<DomainSet>(new DomainSet(domains));
+
+    for (size_t index = 0; index < Types::Count; ++index) {
+        domainSet->_specifications[index] = manager.specifications(Types::Name(index), domains);
+
+        /* Earlier domains take precedence, so keep the first specification with each identifier. */
+        for (Specification::shared_ptr const &specification : domainSet->_specifications[index]) {
+            domainSet->_identifiers[index].insert({ specification->identifier(), specification });
+        }
+    }
+
+    return domainSet;
+}
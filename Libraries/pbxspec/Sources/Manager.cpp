@@ -12,12 +12,18 @@
 #include <plist/Array.h>
 #include <plist/Dictionary.h>
 #include <plist/Object.h>
+#include <plist/FileCache.h>
 #include <plist/Format/Any.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
 
 using pbxspec::Manager;
 using pbxspec::Context;
+namespace Types = pbxspec::Types;
 using pbxspec::PBX::Specification;
 using pbxspec::PBX::Architecture;
 using pbxspec::PBX::BuildPhase;
@@ -33,6 +39,7 @@ using pbxspec::PBX::ProductType;
 using pbxspec::PBX::Tool;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 Manager::
 Manager()
@@ -44,36 +51,46 @@ Manager::
 {
 }
 
+Manager::DomainSpecifications const *Manager::
+findDomain(std::string const &name) const
+{
+    /* Domains are kept sorted by name, so searching any domain has a stable order. */
+    auto it = std::lower_bound(_specifications.begin(), _specifications.end(), name, [](DomainSpecifications const &domain, std::string const &name) {
+        return domain.name < name;
+    });
+    if (it == _specifications.end() || it->name != name) {
+        return nullptr;
+    }
+
+    return &*it;
+}
+
 template <typename T>
 typename T::vector Manager::
 findSpecifications(std::vector<std::string> const &domains, char const *type) const
 {
-    if (type == nullptr) {
+    ext::optional<size_t> index = Types::Index(type);
+    if (!index) {
         return typename T::vector();
     }
 
     typename T::vector specifications;
 
+    auto append = [&](DomainSpecifications const &domain) {
+        Specification::vector const &vector = domain.specifications[*index];
+        specifications.reserve(specifications.size() + vector.size());
+        for (Specification::shared_ptr const &specification : vector) {
+            specifications.emplace_back(std::static_pointer_cast<T>(specification));
+        }
+    };
+
     for (std::string const &domain : domains) {
         if (domain == AnyDomain()) {
-            for (auto const &entry : _specifications) {
-                auto const &it = entry.second.find(type);
-                if (it != entry.second.end()) {
-                    for (auto const &s : it->second) {
-                        specifications.emplace_back(std::static_pointer_cast<T>(s));
-                    }
-                }
-            }
-        } else {
-            auto const &doit = _specifications.find(domain);
-            if (doit != _specifications.end()) {
-                auto const &it = doit->second.find(type);
-                if (it != doit->second.end()) {
-                    for (auto const &s : it->second) {
-                        specifications.emplace_back(std::static_pointer_cast<T>(s));
-                    }
-                }
+            for (DomainSpecifications const &entry : _specifications) {
+                append(entry);
             }
+        } else if (DomainSpecifications const *entry = findDomain(domain)) {
+            append(*entry);
         }
     }
 
@@ -84,14 +101,32 @@ template <typename T>
 typename T::shared_ptr Manager::
 findSpecification(std::vector<std::string> const &domains, std::string const &identifier, char const *type) const
 {
-    typename T::vector vector = findSpecifications <T> (domains, type);
+    ext::optional<size_t> index = Types::Index(type);
+    if (!index) {
+        return nullptr;
+    }
 
-    auto I = std::find_if(vector.begin(), vector.end(), [&identifier](Specification::shared_ptr const &spec) -> bool {
-        return identifier == spec->identifier();
-    });
+    /* Identifiers are unique in a domain, so the first match is the one a search would find. */
+    auto find = [&](DomainSpecifications const &domain) -> typename T::shared_ptr {
+        auto it = domain.identifiers[*index].find(identifier);
+        if (it != domain.identifiers[*index].end()) {
+            return std::static_pointer_cast<T>(it->second);
+        }
+        return nullptr;
+    };
 
-    if (I != vector.end()) {
-        return *I;
+    for (std::string const &domain : domains) {
+        if (domain == AnyDomain()) {
+            for (DomainSpecifications const &entry : _specifications) {
+                if (typename T::shared_ptr specification = find(entry)) {
+                    return specification;
+                }
+            }
+        } else if (DomainSpecifications const *entry = findDomain(domain)) {
+            if (typename T::shared_ptr specification = find(*entry)) {
+                return specification;
+            }
+        }
     }
 
     return nullptr;
@@ -278,8 +313,9 @@ addSpecification(PBX::Specification::shared_ptr const &spec)
         return;
     }
 
-    if (spec->type() == nullptr) {
-        fprintf(stderr, "error: registering a specification with null type\n");
+    ext::optional<size_t> index = Types::Index(spec->type());
+    if (!index) {
+        fprintf(stderr, "error: registering a specification with unknown type\n");
         return;
     }
 
@@ -300,7 +336,17 @@ addSpecification(PBX::Specification::shared_ptr const &spec)
     fprintf(stderr, "adding %s spec to domain %s '%s'\n",
             spec->type(), spec->domain().c_str(), spec->identifier().c_str());
 #endif
-    _specifications[spec->domain()][spec->type()].push_back(spec);
+    auto it = std::lower_bound(_specifications.begin(), _specifications.end(), spec->domain(), [](DomainSpecifications const &domain, std::string const &name) {
+        return domain.name < name;
+    });
+    if (it == _specifications.end() || it->name != spec->domain()) {
+        DomainSpecifications domain;
+        domain.name = spec->domain();
+        it = _specifications.insert(it, std::move(domain));
+    }
+
+    it->specifications[*index].push_back(spec);
+    it->identifiers[*index].insert({ spec->identifier(), spec });
 }
 
 bool Manager::
@@ -346,7 +392,12 @@ inheritSpecification(PBX::Specification::shared_ptr const &specification)
 void Manager::
 registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains)
 {
-    PBX::Specification::vector specifications;
+    /*
+     * Find the specification files first, then parse them all at once. Each
+     * file parses independently; results are kept in the order found so
+     * registration and inheritance don't depend on which finished first.
+     */
+    std::vector<std::pair<std::string, Context>> files;
 
     for (auto const &domain : domains) {
         /*
@@ -372,7 +423,7 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
 
         switch (*type) {
             case Filesystem::Type::Directory: {
-                filesystem->readDirectory(realPath, true, [&](std::string const &filename) -> bool {
+                filesystem->readDirectory(realPath, true, [&](std::string const &filename, ext::optional<Filesystem::Type> type) -> bool {
                     std::string path = realPath + "/" + filename;
 
                     /* Support both *.xcspec and *.pbfilespec as a few of the latter remain in use. */
@@ -384,17 +435,8 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
                     bool file = FSUtil::GetFileExtension(path) == "pbfilespec";
                     context.defaultType = (file ? "FileType" : std::string());
 
-                    if (filesystem->type(path) != Filesystem::Type::Directory) {
-#if 0
-                        fprintf(stderr, "importing specification '%s'\n", path.c_str());
-#endif
-
-                        ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, path);
-                        if (fileSpecifications) {
-                            specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
-                        } else {
-                            fprintf(stderr, "warning: failed to import specification '%s'\n", path.c_str());
-                        }
+                    if (type != Filesystem::Type::Directory) {
+                        files.push_back({ path, context });
                     }
                     return true;
                 });
@@ -402,20 +444,29 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
             }
             case Filesystem::Type::SymbolicLink:
             case Filesystem::Type::File: {
-#if 0
-                fprintf(stderr, "importing specification '%s'\n", realPath.c_str());
-#endif
-                ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, realPath);
-                if (fileSpecifications) {
-                    specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
-                } else {
-                    fprintf(stderr, "warning: failed to import specification '%s'\n", realPath.c_str());
-                }
+                files.push_back({ realPath, context });
                 break;
             }
         }
     }
 
+    std::vector<ext::optional<PBX::Specification::vector>> fileSpecifications = std::vector<ext::optional<PBX::Specification::vector>>(files.size());
+    Parallel::For(Parallel::DefaultJobs(), files.size(), [&](size_t n) {
+#if 0
+        fprintf(stderr, "importing specification '%s'\n", files[n].first.c_str());
+#endif
+        fileSpecifications[n] = Specification::Open(filesystem, &files[n].second, files[n].first);
+    });
+
+    PBX::Specification::vector specifications;
+    for (size_t n = 0; n < files.size(); ++n) {
+        if (fileSpecifications[n]) {
+            specifications.insert(specifications.end(), fileSpecifications[n]->begin(), fileSpecifications[n]->end());
+        } else {
+            fprintf(stderr, "warning: failed to import specification '%s'\n", files[n].first.c_str());
+        }
+    }
+
     /*
      * Mark all of the domains regsitered. This is after all of the inputs so the
      * same domain can be registered multiple times (loaded from multiple paths)
@@ -447,12 +498,7 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
 bool Manager::
 registerBuildRules(Filesystem const *filesystem, std::string const &path)
 {
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, path)) {
-        return false;
-    }
-
-    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents).first;
+    std::shared_ptr<plist::Object const> plist = plist::FileCache::GetDefault()->read<plist::Format::Any>(filesystem, path);
     if (plist == nullptr) {
         return false;
     }
@@ -63,7 +63,7 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
             if (auto O = Os->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr option;
                 option.reset(new PropertyOption);
-                if (option->parse(O)) {
+                if (option->parse(context, O)) {
                     PropertyOption::Insert(&*_options, &_optionsUsed, option);
                 }
             }
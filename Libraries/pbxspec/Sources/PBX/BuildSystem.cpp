@@ -87,7 +87,7 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
             if (auto O = Os->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr option;
                 option.reset(new PropertyOption);
-                if (option->parse(O)) {
+                if (option->parse(context, O)) {
                     PropertyOption::Insert(&*_options, &_optionsUsed, option);
                 }
             }
@@ -100,7 +100,7 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
             if (auto P = Ps->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr property;
                 property.reset(new PropertyOption);
-                if (property->parse(P)) {
+                if (property->parse(context, P)) {
                     PropertyOption::Insert(&*_properties, &_propertiesUsed, property);
                 }
             }
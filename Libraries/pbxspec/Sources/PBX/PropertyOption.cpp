@@ -8,6 +8,7 @@
  */
 
 #include <pbxspec/PBX/PropertyOption.h>
+#include <pbxspec/Context.h>
 #include <pbxsetting/Setting.h>
 #include <plist/Array.h>
 #include <plist/Boolean.h>
@@ -16,39 +17,16 @@
 #include <plist/Keys/Unpack.h>
 
 using pbxspec::PBX::PropertyOption;
+using pbxspec::Context;
 
 PropertyOption::
-PropertyOption() :
-    _displayValues       (nullptr),
-    _commandLineArgs     (nullptr),
-    _additionalLinkerArgs(nullptr),
-    _allowedValues       (nullptr),
-    _values              (nullptr)
+PropertyOption()
 {
 }
 
 PropertyOption::
 ~PropertyOption()
 {
-    if (_additionalLinkerArgs != nullptr) {
-        _additionalLinkerArgs->release();
-    }
-
-    if (_values != nullptr) {
-        _values->release();
-    }
-
-    if (_displayValues != nullptr) {
-        _displayValues->release();
-    }
-
-    if (_allowedValues != nullptr) {
-        _allowedValues->release();
-    }
-
-    if (_commandLineArgs != nullptr) {
-        _commandLineArgs->release();
-    }
 }
 
 ext::optional<pbxsetting::Setting> PropertyOption::
@@ -62,7 +40,7 @@ defaultSetting(void) const
 }
 
 bool PropertyOption::
-parse(plist::Dictionary const *dict)
+parse(Context *context, plist::Dictionary const *dict)
 {
     std::unordered_set<std::string> seen;
     auto unpack = plist::Keys::Unpack("Property/Option", dict, &seen);
@@ -118,7 +96,7 @@ parse(plist::Dictionary const *dict)
     }
 
     if (DVs != nullptr) {
-        _displayValues = DVs->copy().release();
+        _displayValues = context->share(DVs);
     }
 
     if (T != nullptr) {
@@ -165,7 +143,7 @@ parse(plist::Dictionary const *dict)
     }
 
     if (CLA != nullptr) {
-        _commandLineArgs = CLA->copy().release();
+        _commandLineArgs = context->share(CLA);
     }
 
     if (CLF != nullptr) {
@@ -185,11 +163,11 @@ parse(plist::Dictionary const *dict)
     }
 
     if (AV != nullptr) {
-        _allowedValues = AV->copy().release();
+        _allowedValues = context->share(AV);
     }
 
     if (V != nullptr) {
-        _values = V->copy().release();
+        _values = context->share(V);
     }
 
     if (FTs != nullptr) {
@@ -256,7 +234,7 @@ parse(plist::Dictionary const *dict)
     }
 
     if (ALA != nullptr) {
-        _additionalLinkerArgs = ALA->copy().release();
+        _additionalLinkerArgs = context->share(ALA);
     }
 
     if (As != nullptr) {
@@ -274,8 +252,10 @@ parse(plist::Dictionary const *dict)
 PropertyOption::shared_ptr PropertyOption::
 Create(plist::Dictionary const *dict)
 {
+    Context context = Context();
+
     auto option = std::shared_ptr<PropertyOption>(new PropertyOption());
-    if (!option->parse(dict)) {
+    if (!option->parse(&context, dict)) {
         return nullptr;
     }
 
@@ -24,6 +24,7 @@
 #include <plist/Dictionary.h>
 #include <plist/Object.h>
 #include <plist/String.h>
+#include <plist/FileCache.h>
 #include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 #include <libutil/Filesystem.h>
@@ -203,20 +204,15 @@ Open(Filesystem const *filesystem, Context *context, std::string const &filename
         return ext::nullopt;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, realPath)) {
-        fprintf(stderr, "error: unable to read specification plist\n");
-        return ext::nullopt;
-    }
-
     //
     // Parse property list
     //
-    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents).first;
+    std::shared_ptr<plist::Object const> plist = plist::FileCache::GetDefault()->read<plist::Format::Any>(filesystem, realPath);
     if (plist == nullptr) {
-        fprintf(stderr, "error: unable to parse specification plist\n");
+        fprintf(stderr, "error: unable to read specification plist\n");
         return ext::nullopt;
     }
+    context->contents = plist;
 
     //
     // If this is a dictionary, then it's a single specification,
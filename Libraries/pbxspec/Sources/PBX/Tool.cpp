@@ -9,6 +9,7 @@
 
 #include <pbxspec/PBX/Tool.h>
 #include <pbxspec/Inherit.h>
+#include <pbxspec/Context.h>
 #include <pbxsetting/Type.h>
 #include <plist/Array.h>
 #include <plist/Boolean.h>
@@ -22,16 +23,12 @@ using pbxspec::PBX::Tool;
 
 Tool::
 Tool() :
-    Specification       (),
-    _commandOutputParser(nullptr)
+    Specification       ()
 {
 }
 
 Tool::~Tool()
 {
-    if (_commandOutputParser != nullptr) {
-        _commandOutputParser->release();
-    }
 }
 
 pbxsetting::Level Tool::
@@ -262,11 +259,7 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
     }
 
     if (COP != nullptr) {
-        if (_commandOutputParser != nullptr) {
-            _commandOutputParser->release();
-        }
-
-        _commandOutputParser = COP->copy().release();
+        _commandOutputParser = context->share(COP);
     }
 
     if (IA != nullptr) {
@@ -307,7 +300,7 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
             if (auto OP = OPs->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr option;
                 option.reset(new PropertyOption);
-                if (option->parse(OP)) {
+                if (option->parse(context, OP)) {
                     PropertyOption::Insert(&*_options, &_optionsUsed, option);
                 }
             }
@@ -368,7 +361,7 @@ inherit(Tool::shared_ptr const &b)
     _deletedProperties                   = Inherit::Combine(_deletedProperties, base->_deletedProperties);
     _environmentVariables                = Inherit::Combine(_environmentVariables, base->_environmentVariables);
     _successExitCodes                    = Inherit::Combine(_successExitCodes, base->_successExitCodes);
-    _commandOutputParser                 = _commandOutputParser ?: (base->_commandOutputParser ? base->_commandOutputParser->copy().release() : nullptr);
+    _commandOutputParser                 = Inherit::Override(_commandOutputParser, base->_commandOutputParser);
     _isAbstract                          = Inherit::Override(_isAbstract, base->_isAbstract);
     _isArchitectureNeutral               = Inherit::Override(_isArchitectureNeutral, base->_isArchitectureNeutral);
     _caresAboutInclusionDependencies     = Inherit::Override(_caresAboutInclusionDependencies, base->_caresAboutInclusionDependencies);
@@ -23,4 +23,36 @@ char const * const PackageType = "PackageType";
 char const * const ProductType = "ProductType";
 char const * const Tool = "Tool";
 
+static char const * const All[Count] = {
+    Architecture,
+    BuildPhase,
+    BuildSettings,
+    BuildStep,
+    BuildSystem,
+    Compiler,
+    FileType,
+    Linker,
+    PackageType,
+    ProductType,
+    Tool,
+};
+
+ext::optional<size_t>
+Index(char const *type)
+{
+    for (size_t index = 0; index < Count; ++index) {
+        if (All[index] == type) {
+            return index;
+        }
+    }
+
+    return ext::nullopt;
+}
+
+char const *
+Name(size_t index)
+{
+    return All[index];
+}
+
 } }
@@ -0,0 +1,55 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_CacheFile_h
+#define __plist_CacheFile_h
+
+#include <plist/Dictionary.h>
+#include <libutil/Filesystem.h>
+
+#include <memory>
+#include <string>
+
+namespace plist {
+
+namespace Format { class BinaryView; }
+
+/*
+ * A dictionary kept in a file between runs, such as a cache or log. Saved
+ * files have a version, to change when what is saved changes; files saved
+ * with any other version are ignored.
+ */
+class CacheFile {
+public:
+    /*
+     * Read a saved dictionary. Null if the file is missing, invalid, or
+     * was saved with another version.
+     */
+    static std::unique_ptr<Dictionary>
+    Load(libutil::Filesystem const *filesystem, std::string const &path, int64_t version);
+
+    /*
+     * Read a saved dictionary without decoding it; each value is decoded
+     * when it is first used.
+     */
+    static std::unique_ptr<Format::BinaryView>
+    LoadView(libutil::Filesystem const *filesystem, std::string const &path, int64_t version);
+
+public:
+    /*
+     * Save a dictionary with a version, creating its directory if needed.
+     * The file is written atomically, so readers never see it partly saved.
+     */
+    static bool
+    Save(libutil::Filesystem *filesystem, std::string const &path, int64_t version, std::unique_ptr<Dictionary> root);
+};
+
+}
+
+#endif  // !__plist_CacheFile_h
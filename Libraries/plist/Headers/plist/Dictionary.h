@@ -14,6 +14,7 @@
 #include <plist/Object.h>
 
 #include <algorithm>
+#include <iterator>
 #include <vector>
 #include <unordered_map>
 
@@ -21,8 +22,67 @@ namespace plist {
 
 class Dictionary : public Object {
 private:
-    std::vector<std::string>                                 _keys;
-    std::unordered_map<std::string, std::unique_ptr<Object>> _map;
+    typedef std::pair<std::string, std::unique_ptr<Object>> Entry;
+
+public:
+    /*
+     * Iterates the keys in insertion order.
+     */
+    class const_iterator : public std::iterator<std::random_access_iterator_tag, std::string const> {
+    private:
+        std::vector<Entry>::const_iterator _it;
+
+    public:
+        explicit const_iterator(std::vector<Entry>::const_iterator it) :
+            _it(it)
+        {
+        }
+
+    public:
+        inline std::string const &operator*() const
+        { return _it->first; }
+        inline std::string const *operator->() const
+        { return &_it->first; }
+        inline std::string const &operator[](difference_type n) const
+        { return _it[n].first; }
+
+    public:
+        inline const_iterator &operator++()
+        { ++_it; return *this; }
+        inline const_iterator operator++(int)
+        { return const_iterator(_it++); }
+        inline const_iterator &operator--()
+        { --_it; return *this; }
+        inline const_iterator operator--(int)
+        { return const_iterator(_it--); }
+        inline const_iterator &operator+=(difference_type n)
+        { _it += n; return *this; }
+        inline const_iterator &operator-=(difference_type n)
+        { _it -= n; return *this; }
+        inline const_iterator operator+(difference_type n) const
+        { return const_iterator(_it + n); }
+        inline const_iterator operator-(difference_type n) const
+        { return const_iterator(_it - n); }
+        inline difference_type operator-(const_iterator const &rhs) const
+        { return _it - rhs._it; }
+
+    public:
+        inline bool operator==(const_iterator const &rhs) const
+        { return _it == rhs._it; }
+        inline bool operator!=(const_iterator const &rhs) const
+        { return _it != rhs._it; }
+        inline bool operator<(const_iterator const &rhs) const
+        { return _it < rhs._it; }
+    };
+
+private:
+    /*
+     * Entries in insertion order. Most dictionaries are small, so keys are
+     * found by searching the entries. Above a few entries, an index from
+     * key hash to entry is kept as well.
+     */
+    std::vector<Entry>                      _entries;
+    std::unordered_multimap<size_t, size_t> _index;
 
 public:
     Dictionary()
@@ -37,30 +97,46 @@ public:
 public:
     static std::unique_ptr<Dictionary> New();
 
+private:
+    /*
+     * The largest dictionary without an index.
+     */
+    static inline size_t IndexThreshold()
+    {
+        return 12;
+    }
+
+    /*
+     * The index of the entry for a key, or count() if not found.
+     */
+    size_t find(std::string const &key) const;
+
+    void reindex();
+
 public:
     inline bool empty() const
     {
-        return _map.empty();
+        return _entries.empty();
     }
 
     inline size_t count() const
     {
-        return _map.size();
+        return _entries.size();
     }
 
     inline std::string const &key(size_t index) const
     {
-        return _keys[index];
+        return _entries[index].first;
     }
 
     inline Object const *value(size_t index) const
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].second.get() : nullptr;
     }
 
     inline Object *value(size_t index)
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].second.get() : nullptr;
     }
 
     template <typename T>
@@ -77,14 +153,12 @@ public:
 
     inline Object const *value(std::string const &key) const
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        return value(find(key));
     }
 
     inline Object *value(std::string const &key)
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        return value(find(key));
     }
 
     template <typename T>
@@ -102,37 +176,32 @@ public:
 public:
     inline void clear()
     {
-        _keys.clear();
-        _map.clear();
+        _entries.clear();
+        _index.clear();
     }
 
-public:
-    inline void set(std::string const &key, std::unique_ptr<Object> obj)
+    /*
+     * Make room for a number of keys without reallocating.
+     */
+    inline void reserve(size_t count)
     {
-        remove(key);
-        _keys.push_back(key);
-        _map.insert(std::make_pair(key, std::move(obj)));
+        _entries.reserve(count);
     }
 
-    inline void remove(std::string const &key)
-    {
-        auto it = _map.find(key);
-
-        if (it != _map.end()) {
-            _map.erase(it);
-            _keys.erase(std::find(_keys.begin(), _keys.end(), key));
-        }
-    }
+public:
+    void set(std::string const &key, std::unique_ptr<Object> obj);
+    void set(std::string &&key, std::unique_ptr<Object> obj);
+    void remove(std::string const &key);
 
 public:
-    inline std::vector<std::string>::const_iterator begin() const
+    inline const_iterator begin() const
     {
-        return _keys.begin();
+        return const_iterator(_entries.begin());
     }
 
-    inline std::vector<std::string>::const_iterator end() const
+    inline const_iterator end() const
     {
-        return _keys.end();
+        return const_iterator(_entries.end());
     }
 
 public:
@@ -174,8 +243,8 @@ public:
         if (count() != obj->count())
             return false;
 
-        for (auto const &it : _map) {
-            if (!value(it.first)->equals(obj->value(it.first)))
+        for (Entry const &entry : _entries) {
+            if (!entry.second->equals(obj->value(entry.first)))
                 return false;
         }
 
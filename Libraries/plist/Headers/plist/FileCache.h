@@ -0,0 +1,98 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_FileCache_h
+#define __plist_FileCache_h
+
+#include <plist/Object.h>
+#include <libutil/Filesystem.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace plist {
+
+namespace Format { class BinaryView; }
+
+/*
+ * Caches property lists read from files. A file is parsed again only if its
+ * stamp (size and modification time) changes; otherwise, the same object is
+ * shared by every reader. Shared objects must not be changed; copy them to
+ * make changes. Safe to use from multiple threads.
+ */
+class FileCache {
+private:
+    typedef std::unique_ptr<Object> (*Deserializer)(uint8_t const *data, size_t size);
+
+    struct Entry {
+        Deserializer                  deserialize;
+        libutil::Filesystem::Stamp    stamp;
+        std::shared_ptr<Object const> object;
+    };
+
+private:
+    std::unordered_map<std::string, std::vector<Entry>> _entries;
+    std::shared_ptr<Format::BinaryView>                 _store;
+    bool                                                _modified;
+    std::mutex                                          _mutex;
+
+public:
+    FileCache();
+
+public:
+    /*
+     * Read a property list file with a format, such as Format::Any. Null if
+     * the file can't be read or is not valid. Files on filesystems that have
+     * no stamps are not cached.
+     */
+    template<typename T>
+    std::shared_ptr<Object const> read(libutil::Filesystem const *filesystem, std::string const &path)
+    { return read(filesystem, path, &Deserialize<T>); }
+
+    /*
+     * Forget all cached files.
+     */
+    void clear();
+
+public:
+    /*
+     * Use a cache previously saved to a file for files read with
+     * Format::Any. Each file is only decoded from the saved cache when
+     * first read, and only if its stamp is unchanged since it was saved.
+     */
+    bool load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Save the files read with Format::Any, along with the still valid
+     * files from a loaded cache, so they can be loaded later. Nothing is
+     * written if no file was parsed since the cache was loaded.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path);
+
+private:
+    std::shared_ptr<Object const> read(libutil::Filesystem const *filesystem, std::string const &path, Deserializer deserialize);
+    std::shared_ptr<Object const> stored(std::string const &path, libutil::Filesystem::Stamp const &stamp);
+
+    template<typename T>
+    static std::unique_ptr<Object> Deserialize(uint8_t const *data, size_t size)
+    { return T::Deserialize(data, size).first; }
+
+public:
+    /*
+     * The cache shared by the whole process.
+     */
+    static FileCache *GetDefault();
+};
+
+}
+
+#endif  // !__plist_FileCache_h
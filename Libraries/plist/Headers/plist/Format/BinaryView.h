@@ -0,0 +1,100 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_BinaryView_h
+#define __plist_Format_BinaryView_h
+
+#include <plist/Object.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+struct BinaryParseContext;
+
+/*
+ * A binary property list that is only decoded as it is used. Objects are
+ * read through the offset table when first accessed, then kept until the
+ * view is destroyed. If the top level object is a dictionary, its keys are
+ * indexed so each value can be found without decoding the others.
+ *
+ * Not safe to use from multiple threads at once.
+ */
+class BinaryView {
+private:
+    std::vector<uint8_t>                      _contents;
+    std::unique_ptr<BinaryParseContext>       _context;
+
+private:
+    std::vector<std::string>                  _keys;
+    std::unordered_map<std::string, uint64_t> _values;
+
+private:
+    explicit BinaryView(std::vector<uint8_t> &&contents);
+
+public:
+    ~BinaryView();
+
+public:
+    /*
+     * The number of objects in the property list.
+     */
+    uint64_t count() const;
+
+    /*
+     * The error from the last object that could not be read.
+     */
+    std::string const &error() const;
+
+public:
+    /*
+     * The keys of the top level dictionary, in order. Empty if the top
+     * level object is not a dictionary.
+     */
+    std::vector<std::string> const &keys() const
+    { return _keys; }
+
+public:
+    /*
+     * The top level object, decoded with all of its contents.
+     */
+    Object const *root();
+
+    /*
+     * A value in the top level dictionary, decoded with its contents. Null
+     * if the key is not in the dictionary, or the value could not be read.
+     */
+    Object const *value(std::string const &key);
+    template<typename T>
+    T const *value(std::string const &key)
+    { return CastTo<T>(value(key)); }
+
+    /*
+     * An object by its reference in the offset table.
+     */
+    Object const *object(uint64_t reference);
+
+public:
+    /*
+     * Open a binary property list. Only the header, trailer, offset table,
+     * and the top level dictionary's keys are read.
+     */
+    static std::pair<std::unique_ptr<BinaryView>, std::string>
+    Create(std::vector<uint8_t> contents);
+};
+
+}
+}
+
+#endif  // !__plist_Format_BinaryView_h
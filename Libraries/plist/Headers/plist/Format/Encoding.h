@@ -32,11 +32,19 @@ private:
 
 public:
     static Encoding
-    Detect(std::vector<uint8_t> const &contents);
+    Detect(uint8_t const *data, size_t size);
+
+    static Encoding
+    Detect(std::vector<uint8_t> const &contents)
+    { return Detect(contents.data(), contents.size()); }
 
 public:
     static std::vector<uint8_t>
-    Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to);
+    Convert(uint8_t const *data, size_t size, Encoding from, Encoding to);
+
+    static std::vector<uint8_t>
+    Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to)
+    { return Convert(contents.data(), contents.size(), from, to); }
 
 public:
     static std::vector<uint8_t>
@@ -12,6 +12,7 @@
 
 #include <plist/Base.h>
 #include <plist/Object.h>
+#include <plist/Format/Handler.h>
 
 #include <vector>
 
@@ -26,21 +27,55 @@ protected:
 
 public:
     static std::unique_ptr<T>
-    Identify(std::vector<uint8_t> const &contents);
+    Identify(uint8_t const *data, size_t size);
+
+    static std::unique_ptr<T>
+    Identify(std::vector<uint8_t> const &contents)
+    {
+        return Identify(contents.data(), contents.size());
+    }
 
 public:
     static std::pair<std::unique_ptr<Object>, std::string>
-    Deserialize(std::vector<uint8_t> const &contents, T const &format);
+    Deserialize(uint8_t const *data, size_t size, T const &format);
 
     static std::pair<std::unique_ptr<Object>, std::string>
-    Deserialize(std::vector<uint8_t> const &contents)
+    Deserialize(uint8_t const *data, size_t size)
     {
-        std::unique_ptr<T> format = Identify(contents);
+        std::unique_ptr<T> format = Identify(data, size);
         if (format == nullptr) {
             return std::make_pair(nullptr, "couldn't identify format");
         }
 
-        return Deserialize(contents, *format);
+        return Deserialize(data, size, *format);
+    }
+
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Deserialize(std::vector<uint8_t> const &contents, T const &format)
+    {
+        return Deserialize(contents.data(), contents.size(), format);
+    }
+
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Deserialize(std::vector<uint8_t> const &contents)
+    {
+        return Deserialize(contents.data(), contents.size());
+    }
+
+public:
+    /*
+     * Passes the contents to a handler as they are read, without building
+     * an object tree. Returns true if all of the contents were read, or
+     * false with an error if they are invalid. If the handler stopped
+     * reading, returns false with no error.
+     */
+    static std::pair<bool, std::string>
+    Parse(uint8_t const *data, size_t size, T const &format, Handler *handler);
+
+    static std::pair<bool, std::string>
+    Parse(std::vector<uint8_t> const &contents, T const &format, Handler *handler)
+    {
+        return Parse(contents.data(), contents.size(), format, handler);
     }
 
 public:
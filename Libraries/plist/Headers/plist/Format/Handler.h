@@ -0,0 +1,54 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_Handler_h
+#define __plist_Format_Handler_h
+
+#include <plist/Base.h>
+#include <plist/Object.h>
+
+#include <string>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Receives the contents of a property list as they are read, rather than
+ * as an object tree. Containers are reported as they begin and end, each
+ * dictionary value is preceded by its key, and other values are passed as
+ * objects. Returning false from any method stops reading.
+ */
+class Handler {
+public:
+    virtual ~Handler();
+
+public:
+    virtual bool beginDictionary() = 0;
+    virtual bool endDictionary() = 0;
+
+public:
+    virtual bool beginArray() = 0;
+    virtual bool endArray() = 0;
+
+public:
+    /*
+     * The key for the next value in the current dictionary.
+     */
+    virtual bool key(std::string const &key) = 0;
+
+    /*
+     * A value that is not a container.
+     */
+    virtual bool value(std::unique_ptr<Object> value) = 0;
+};
+
+}
+}
+
+#endif  // !__plist_Format_Handler_h
@@ -20,9 +20,7 @@ namespace plist {
 
 class Object {
 protected:
-    Object()
-    {
-    }
+    Object();
 
 public:
     virtual ~Object()
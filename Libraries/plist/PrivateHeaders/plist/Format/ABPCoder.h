@@ -17,6 +17,7 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 typedef struct _ABPContext ABPContext;
 
@@ -45,6 +46,9 @@ typedef struct _ABPStreamCallBacks {
     off_t (*seek)(void *, off_t, int);
     ssize_t (*read)(void *, void *, size_t);
     ssize_t (*write)(void *, void const *, size_t);
+
+    /* Optional: expect about this many bytes to be written. */
+    void (*reserve)(void *, size_t);
 } ABPStreamCallBacks;
 
 typedef struct _ABPCreateCallBacks {
@@ -62,6 +66,18 @@ typedef struct _ABPProcessCallBacks {
     bool   (*process)(void *, plist::Object const **);
 } ABPProcessCallBacks;
 
+/*
+ * Hashes and compares objects that are not containers by their values, so
+ * equal values are only written once.
+ */
+struct ABPValueHash {
+    size_t operator()(plist::Object const *object) const;
+};
+
+struct ABPValueEqual {
+    bool operator()(plist::Object const *a, plist::Object const *b) const;
+};
+
 struct _ABPContext {
     unsigned                flags;
     abplist_header_t        header;
@@ -72,7 +88,11 @@ struct _ABPContext {
     std::unordered_map<plist::Object const *, int>                      references;
     std::unordered_map<plist::Object const *, plist::Object const *>    mappings;
     std::unordered_set<plist::Object const *>                           written;
-    std::unordered_map<plist::Dictionary const *, std::unordered_map<int, plist::String *>> keyStrings;
+    std::unordered_set<plist::Object const *, ABPValueHash, ABPValueEqual> uniques;
+    uint64_t                                                            preflightBytes;
+    uint64_t                                                            preflightReferences;
+    std::unordered_map<plist::Dictionary const *, std::vector<plist::String *>> keyStrings;
+    std::unordered_map<std::string, plist::String *>                    keyValues;
     union {
         ABPCreateCallBacks  createCallBacks;
         ABPProcessCallBacks processCallBacks;
@@ -105,6 +125,13 @@ size_t ABPReaderGetObjectsCount(ABPContext *context);
 plist::Object *ABPReadTopLevelObject(ABPContext *context);
 plist::Object *ABPReadObject(ABPContext *context, uint64_t reference);
 
+/*
+ * Reads the key and value references of a dictionary, without creating the
+ * dictionary or its contents. Fails if the object is not a dictionary.
+ */
+bool ABPReadDictionaryReferences(ABPContext *context, uint64_t reference,
+        std::vector<uint64_t> *keys, std::vector<uint64_t> *values);
+
 /* Writer */
 
 bool ABPWriterInit(ABPContext *context,
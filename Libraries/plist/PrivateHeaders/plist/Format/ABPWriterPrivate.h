@@ -85,6 +85,31 @@ __ABPWriteTypeAndLength(ABPContext *context, ABPRecordType type, uint64_t length
     return true;
 }
 
+static uint64_t
+__ABPLengthSize(uint64_t length)
+{
+    if (length < 0x0f) {
+        return 1;
+    } else if ((length & 0xFF) == length) {
+        return 2 + 1;
+    } else if ((length & 0xFFFF) == length) {
+        return 2 + 2;
+    } else if ((length & 0xFFFFFFFF) == length) {
+        return 2 + 4;
+    } else {
+        return 2 + 8;
+    }
+}
+
+static void
+__ABPReserve(ABPContext *context, size_t length)
+{
+    if (context->streamCallBacks.reserve != NULL) {
+        (*(context->streamCallBacks.reserve))(context->streamCallBacks.opaque,
+                                              length);
+    }
+}
+
 static bool
 __ABPWriteOffset(ABPContext *context, uint64_t offset)
 {
@@ -66,4 +66,14 @@ char *ASCIIPListCopyData(ASCIIPListLexer const *lexer);
 }
 #endif
 
+#ifdef __cplusplus
+#include <string>
+
+/*
+ * Copies the current token into a string, unquoting it. Tokens without
+ * escapes are copied straight from the input buffer.
+ */
+bool ASCIIPListCopyUnquotedString(ASCIIPListLexer const *lexer, int lossByte, std::string *string);
+#endif
+
 #endif  /* !__plist_ASCIIPListLexer_h */
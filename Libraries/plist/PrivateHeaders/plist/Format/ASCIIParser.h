@@ -11,8 +11,8 @@
 #define __plist_Format_ASCIIParser_h
 
 #include <plist/Format/ASCIIPListLexer.h>
+#include <plist/Format/Handler.h>
 #include <plist/Object.h>
-#include <plist/String.h>
 
 #include <stack>
 #include <string>
@@ -26,6 +26,7 @@ private:
         Parsing = 0,
         Done,
         Aborted,
+        Stopped,
     };
 
 private:
@@ -37,40 +38,32 @@ private:
     };
 
 private:
-    std::unique_ptr<plist::Object> _root;
+    Handler                       *_handler;
+    bool                           _root;
     int                            _level;
 
 private:
     ValueState                     _state;
     std::stack<ValueState>         _stateStack;
 
-private:
-    std::unique_ptr<plist::Object> _container;
-    std::stack<std::unique_ptr<plist::Object>> _containerStack;
-
-private:
-    std::unique_ptr<plist::String> _key;
-    std::stack<std::unique_ptr<plist::String>> _keyStack;
-
 private:
     ContextState                _contextState;
     std::string                 _error;
 
 public:
-    ASCIIParser();
+    explicit ASCIIParser(Handler *handler);
     ~ASCIIParser();
 
 public:
     bool parse(ASCIIPListLexer *lexer, bool strings);
 
 public:
-    std::unique_ptr<plist::Object> &root()
-    { return _root; }
     std::string error() const
     { return _error; }
 
 private:
     bool isAborted() const;
+    void stop();
     void abort(std::string const &error, int line = -1);
 
 private:
@@ -83,12 +76,15 @@ private:
     void decrementLevel();
 
 private:
-    bool push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key);
+    bool push(ValueState state);
     bool pop();
 
 private:
-    bool beginContainer(std::unique_ptr<plist::Object> container);
-    bool storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value);
+    bool beginValue();
+    bool endValue();
+
+private:
+    bool beginContainer(bool isArray);
     bool endContainer(bool isArray);
 
 private:
@@ -102,7 +98,7 @@ private:
     bool endDictionary();
 
 private:
-    bool storeKey(std::unique_ptr<plist::String> key);
+    bool storeKey(std::string const &key);
     bool storeValue(std::unique_ptr<plist::Object> value);
 };
 
@@ -21,11 +21,28 @@
 namespace plist {
 namespace Format {
 
+/*
+ * Parses XML as a stream of elements and character data. Documents in the
+ * subset used by property lists and schemes are parsed directly from the
+ * UTF-8 input; others, such as those with document type declarations that
+ * could declare entities, are parsed by libxml2. Both report the same
+ * elements and character data, including skipping whitespace-only text.
+ */
 class BaseXMLParser {
 private:
     ::xmlTextReaderPtr _parser;
     size_t             _depth;
 
+private:
+    uint8_t const                                *_begin;
+    uint8_t const                                *_cursor;
+    uint8_t const                                *_end;
+    bool                                          _stopped;
+    std::vector<std::string>                      _elements;
+    std::string                                   _name;
+    std::string                                   _text;
+    std::unordered_map<std::string, std::string> _attributes;
+
 private:
     size_t             _line;
     size_t             _column;
@@ -43,7 +60,21 @@ public:
     { return _error; }
 
 protected:
-    bool parse(std::vector<uint8_t> const &contents);
+    bool parse(uint8_t const *data, size_t size);
+
+private:
+    bool parseStream(uint8_t const *data, size_t size);
+    bool parseReader(uint8_t const *data, size_t size);
+
+private:
+    bool parseStreamDocument();
+    bool parseStreamName(std::string *name);
+    bool parseStreamReference(std::string *value);
+    bool parseStreamText();
+    bool parseStreamElement();
+    bool parseStreamEndElement();
+    bool skipStreamPast(char const *terminator);
+    void streamError(char const *message);
 
 protected:
     inline size_t depth() const
@@ -60,6 +91,12 @@ protected:
 
 protected:
     void error(std::string format, ...);
+
+protected:
+    /*
+     * Stops parsing without an error.
+     */
+    void stop();
 };
 
 }
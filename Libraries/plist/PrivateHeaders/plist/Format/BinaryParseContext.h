@@ -0,0 +1,58 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_BinaryParseContext_h
+#define __plist_Format_BinaryParseContext_h
+
+#include <plist/Format/ABPCoder.h>
+#include <plist/Format/Handler.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+
+#include <memory>
+#include <string>
+
+namespace plist {
+namespace Format {
+
+/*
+ * State for reading a binary property list from memory.
+ */
+struct BinaryParseContext {
+    ABPContext                    context;
+    ABPStreamCallBacks            streamCallBacks;
+    ABPCreateCallBacks            createCallBacks;
+
+    uint8_t const                *data;
+    size_t                        size;
+    off_t                         offset;
+
+    std::string                   error;
+
+    /*
+     * When reading with a handler, containers are not built: their contents
+     * are sent to the handler, and a placeholder is returned instead.
+     */
+    Handler                      *handler;
+    std::unique_ptr<Array>        arrayPlaceholder;
+    std::unique_ptr<Dictionary>   dictionaryPlaceholder;
+    bool                          stopped;
+};
+
+/*
+ * Sets up the context to read from the data, which must outlive it. If the
+ * handler is not null, containers are sent to it rather than built.
+ */
+void
+BinaryParseContextInit(BinaryParseContext *parseContext, uint8_t const *data, size_t size, Handler *handler);
+
+}
+}
+
+#endif  // !__plist_Format_BinaryParseContext_h
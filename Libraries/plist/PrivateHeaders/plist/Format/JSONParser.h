@@ -11,11 +11,11 @@
 #define __plist_Format_JSONParser_h
 
 #include <plist/Format/ASCIIPListLexer.h>
+#include <plist/Format/Handler.h>
 #include <plist/Object.h>
-#include <plist/String.h>
 
-#include <stack>
 #include <string>
+#include <vector>
 
 namespace plist {
 namespace Format {
@@ -26,6 +26,7 @@ private:
         Parsing = 0,
         Done,
         Aborted,
+        Stopped,
     };
 
 private:
@@ -37,40 +38,38 @@ private:
     };
 
 private:
-    std::unique_ptr<plist::Object> _root;
+    Handler                       *_handler;
+    bool                           _root;
     int                            _level;
 
 private:
     ValueState                     _state;
-    std::stack<ValueState>         _stateStack;
+    std::vector<ValueState>        _stateStack;
 
 private:
-    std::unique_ptr<plist::Object> _container;
-    std::stack<std::unique_ptr<plist::Object>> _containerStack;
-
-private:
-    std::unique_ptr<plist::String> _key;
-    std::stack<std::unique_ptr<plist::String>> _keyStack;
+    /*
+     * Reused for each key and number, so parsing them doesn't allocate.
+     */
+    std::string                    _token;
 
 private:
     ContextState                _contextState;
     std::string                 _error;
 
 public:
-    JSONParser();
+    explicit JSONParser(Handler *handler);
     ~JSONParser();
 
 public:
     bool parse(ASCIIPListLexer *lexer);
 
 public:
-    std::unique_ptr<plist::Object> &root()
-    { return _root; }
     std::string error() const
     { return _error; }
 
 private:
     bool isAborted() const;
+    void stop();
     void abort(std::string const &error);
 
 private:
@@ -83,12 +82,15 @@ private:
     void decrementLevel();
 
 private:
-    bool push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key);
+    bool push(ValueState state);
     bool pop();
 
 private:
-    bool beginContainer(std::unique_ptr<plist::Object> container);
-    bool storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value);
+    bool beginValue();
+    bool endValue();
+
+private:
+    bool beginContainer(bool isArray);
     bool endContainer(bool isArray);
 
 private:
@@ -102,7 +104,7 @@ private:
     bool endDictionary();
 
 private:
-    bool storeKey(std::unique_ptr<plist::String> key);
+    bool storeKey(std::string const &key);
     bool storeValue(std::unique_ptr<plist::Object> value);
 };
 
@@ -27,7 +27,7 @@ public:
     ~JSONWriter();
 
 public:
-    std::vector<uint8_t> contents() const
+    std::vector<uint8_t> const &contents() const
     { return _contents; }
 
 public:
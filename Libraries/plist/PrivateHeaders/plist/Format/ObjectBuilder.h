@@ -0,0 +1,65 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_ObjectBuilder_h
+#define __plist_Format_ObjectBuilder_h
+
+#include <plist/Format/Handler.h>
+
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Builds an object tree from the contents of a property list.
+ */
+class ObjectBuilder : public Handler {
+private:
+    struct Container {
+        std::unique_ptr<Object> object;
+        std::string             key;
+    };
+
+private:
+    std::unique_ptr<Object> _root;
+    std::vector<Container>  _containers;
+    bool                    _convertUIDs;
+
+public:
+    /*
+     * If converting UIDs, dictionaries with only an integer "CF$UID" key
+     * are replaced by a UID with that value.
+     */
+    explicit ObjectBuilder(bool convertUIDs = false);
+    ~ObjectBuilder();
+
+public:
+    /*
+     * The top level object, once it is complete.
+     */
+    std::unique_ptr<Object> &root()
+    { return _root; }
+
+public:
+    virtual bool beginDictionary();
+    virtual bool endDictionary();
+    virtual bool beginArray();
+    virtual bool endArray();
+    virtual bool key(std::string const &key);
+    virtual bool value(std::unique_ptr<Object> value);
+
+private:
+    bool end(ObjectType type);
+};
+
+}
+}
+
+#endif  // !__plist_Format_ObjectBuilder_h
@@ -11,37 +11,51 @@
 #define __plist_Format_XMLParser_h
 
 #include <plist/Format/BaseXMLParser.h>
-#include <plist/Object.h>
+#include <plist/Format/Handler.h>
 
 namespace plist {
 namespace Format {
 
 class XMLParser : public BaseXMLParser {
 private:
+    enum class Element {
+        None,
+        Array,
+        Dictionary,
+        String,
+        Integer,
+        Real,
+        Boolean,
+        Null,
+        Data,
+        Date,
+    };
+
     struct Key {
-        std::string value;
-        bool        valid;
-        bool        active;
+        bool valid;
+        bool active;
     };
 
     struct State {
         typedef std::vector <State> vector;
 
-        Object *current;
+        Element element;
         Key     key;
     };
 
 private:
-    Object        *_root;
+    Handler       *_handler;
+    bool           _root;
+    bool           _boolean;
     State::vector  _stack;
     State          _state;
     std::string    _cdata;
 
 public:
-    XMLParser();
+    explicit XMLParser(Handler *handler);
 
 public:
-    Object *parse(std::vector<uint8_t> const &contents);
+    bool parse(uint8_t const *data, size_t size);
 
 private:
     virtual void onBeginParse();
@@ -53,8 +67,9 @@ private:
     void onCharacterData(std::string const &cdata, size_t depth);
 
 private:
-    void push(Object *object);
+    void push(Element element);
     void pop();
+    bool emit(std::unique_ptr<Object> object);
 
 private:
     inline bool inArray() const;
@@ -0,0 +1,85 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/CacheFile.h>
+#include <plist/Integer.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/BinaryView.h>
+#include <libutil/FSUtil.h>
+
+#include <cstdio>
+
+using plist::CacheFile;
+using plist::Dictionary;
+using plist::Integer;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+static std::string const VersionKey = "Version";
+
+std::unique_ptr<Dictionary> CacheFile::
+Load(Filesystem const *filesystem, std::string const &path, int64_t version)
+{
+    std::unique_ptr<Filesystem::Mapping const> contents = filesystem->map(path);
+    if (contents == nullptr) {
+        return nullptr;
+    }
+
+    auto deserialize = Format::Binary::Deserialize(contents->data(), contents->size(), Format::Binary::Create());
+    if (CastTo<Dictionary>(deserialize.first.get()) == nullptr) {
+        fprintf(stderr, "warning: ignoring invalid %s: %s\n", path.c_str(), deserialize.second.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<Dictionary> root = std::unique_ptr<Dictionary>(static_cast<Dictionary *>(deserialize.first.release()));
+
+    Integer const *saved = root->value<Integer>(VersionKey);
+    if (saved == nullptr || saved->value() != version) {
+        return nullptr;
+    }
+
+    return root;
+}
+
+std::unique_ptr<plist::Format::BinaryView> CacheFile::
+LoadView(Filesystem const *filesystem, std::string const &path, int64_t version)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return nullptr;
+    }
+
+    auto view = Format::BinaryView::Create(std::move(contents));
+    if (view.first == nullptr) {
+        fprintf(stderr, "warning: ignoring invalid %s: %s\n", path.c_str(), view.second.c_str());
+        return nullptr;
+    }
+
+    Integer const *saved = view.first->value<Integer>(VersionKey);
+    if (saved == nullptr || saved->value() != version) {
+        return nullptr;
+    }
+
+    return std::move(view.first);
+}
+
+bool CacheFile::
+Save(Filesystem *filesystem, std::string const &path, int64_t version, std::unique_ptr<Dictionary> root)
+{
+    root->set(VersionKey, Integer::New(version));
+
+    auto serialize = Format::Binary::Serialize(root.get(), Format::Binary::Create());
+    if (serialize.first == nullptr) {
+        fprintf(stderr, "warning: unable to serialize %s: %s\n", path.c_str(), serialize.second.c_str());
+        return false;
+    }
+
+    return filesystem->createDirectory(FSUtil::GetDirectoryName(path), true) &&
+        filesystem->writeAtomically(*serialize.first, path);
+}
@@ -18,10 +18,82 @@ New()
     return std::unique_ptr<Dictionary>(new Dictionary());
 }
 
+size_t Dictionary::
+find(std::string const &key) const
+{
+    if (_index.empty()) {
+        for (size_t n = 0; n < _entries.size(); n++) {
+            if (_entries[n].first == key) {
+                return n;
+            }
+        }
+    } else {
+        auto range = _index.equal_range(std::hash<std::string>()(key));
+        for (auto it = range.first; it != range.second; ++it) {
+            if (_entries[it->second].first == key) {
+                return it->second;
+            }
+        }
+    }
+
+    return _entries.size();
+}
+
+void Dictionary::
+reindex()
+{
+    _index.clear();
+
+    if (_entries.size() > IndexThreshold()) {
+        _index.reserve(_entries.size());
+        for (size_t n = 0; n < _entries.size(); n++) {
+            _index.insert({ std::hash<std::string>()(_entries[n].first), n });
+        }
+    }
+}
+
+void Dictionary::
+set(std::string const &key, std::unique_ptr<Object> obj)
+{
+    set(std::string(key), std::move(obj));
+}
+
+void Dictionary::
+set(std::string &&key, std::unique_ptr<Object> obj)
+{
+    remove(key);
+
+    size_t hash = (!_index.empty() || _entries.size() >= IndexThreshold() ? std::hash<std::string>()(key) : 0);
+    _entries.push_back(Entry(std::move(key), std::move(obj)));
+
+    if (!_index.empty()) {
+        _index.insert({ hash, _entries.size() - 1 });
+    } else if (_entries.size() > IndexThreshold()) {
+        reindex();
+    }
+}
+
+void Dictionary::
+remove(std::string const &key)
+{
+    size_t index = find(key);
+    if (index == _entries.size()) {
+        return;
+    }
+
+    _entries.erase(_entries.begin() + index);
+
+    if (!_index.empty()) {
+        /* Entries after the removed one moved, so their indexes changed. */
+        reindex();
+    }
+}
+
 std::unique_ptr<Object> Dictionary::
 _copy() const
 {
     auto result = Dictionary::New();
+    result->reserve(count());
     for (size_t n = 0; n < count(); n++) {
         result->set(key(n), value(n)->copy());
     }
@@ -35,7 +107,7 @@ merge(Dictionary const *dict, bool replace)
         return;
 
     for (auto const &key : *dict) {
-        if (replace || _map.find(key) == _map.end()) {
+        if (replace || find(key) == count()) {
             set(key, dict->value(key)->copy());
         }
     }
@@ -0,0 +1,200 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/FileCache.h>
+#include <plist/CacheFile.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/BinaryView.h>
+#include <libutil/FSUtil.h>
+
+using plist::FileCache;
+using plist::CacheFile;
+using plist::Object;
+using plist::Dictionary;
+using plist::Integer;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+static int64_t const CacheVersion = 1;
+
+FileCache::
+FileCache() :
+    _modified(false)
+{
+}
+
+std::shared_ptr<Object const> FileCache::
+stored(std::string const &path, Filesystem::Stamp const &stamp)
+{
+    if (_store == nullptr) {
+        return nullptr;
+    }
+
+    Dictionary const *entry = _store->value<Dictionary>(path);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    Integer const *size             = entry->value<Integer>("Size");
+    Integer const *modificationTime = entry->value<Integer>("ModificationTime");
+    Object const  *contents         = entry->value("Contents");
+    if (size == nullptr || modificationTime == nullptr || contents == nullptr) {
+        return nullptr;
+    }
+
+    if (static_cast<uint64_t>(size->value()) != stamp.size || modificationTime->value() != stamp.modificationTime) {
+        return nullptr;
+    }
+
+    /* The object is owned by the saved cache, so keep that alive with it. */
+    return std::shared_ptr<Object const>(_store, contents);
+}
+
+std::shared_ptr<Object const> FileCache::
+read(Filesystem const *filesystem, std::string const &path, Deserializer deserialize)
+{
+    ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(path);
+
+    if (stamp) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _entries.find(path);
+        if (it != _entries.end()) {
+            for (Entry const &entry : it->second) {
+                if (entry.deserialize == deserialize && entry.stamp == *stamp) {
+                    return entry.object;
+                }
+            }
+        }
+
+        if (deserialize == &Deserialize<Format::Any>) {
+            if (std::shared_ptr<Object const> object = stored(path, *stamp)) {
+                _entries[path].push_back({ deserialize, *stamp, object });
+                return object;
+            }
+        }
+    }
+
+    /* Parse outside the lock, so other files can be read at the same time. */
+    std::unique_ptr<Filesystem::Mapping const> contents = filesystem->map(path);
+    if (contents == nullptr) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Object const> object = std::shared_ptr<Object const>(deserialize(contents->data(), contents->size()));
+    if (object == nullptr || !stamp) {
+        return object;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _modified = true;
+
+    std::vector<Entry> *entries = &_entries[path];
+    for (Entry &entry : *entries) {
+        if (entry.deserialize == deserialize) {
+            entry.stamp  = *stamp;
+            entry.object = object;
+            return object;
+        }
+    }
+
+    entries->push_back({ deserialize, *stamp, object });
+    return object;
+}
+
+void FileCache::
+clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _store = nullptr;
+    _modified = false;
+}
+
+bool FileCache::
+load(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<Format::BinaryView> view = CacheFile::LoadView(filesystem, path, CacheVersion);
+    if (view == nullptr) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _store = std::move(view);
+    return true;
+}
+
+static std::unique_ptr<Dictionary>
+StoreEntry(Filesystem::Stamp const &stamp, Object const *object)
+{
+    std::unique_ptr<Dictionary> entry = Dictionary::New();
+    entry->set("Size", Integer::New(static_cast<int64_t>(stamp.size)));
+    entry->set("ModificationTime", Integer::New(stamp.modificationTime));
+    entry->set("Contents", object->copy());
+    return entry;
+}
+
+bool FileCache::
+save(Filesystem *filesystem, std::string const &path)
+{
+    std::unique_ptr<Dictionary> store = Dictionary::New();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_modified) {
+            return true;
+        }
+
+        for (auto const &it : _entries) {
+            for (Entry const &entry : it.second) {
+                if (entry.deserialize == &Deserialize<Format::Any>) {
+                    store->set(it.first, StoreEntry(entry.stamp, entry.object.get()));
+                }
+            }
+        }
+
+        /*
+         * Keep files from the loaded cache that weren't read this time, as
+         * long as they haven't changed since.
+         */
+        if (_store != nullptr) {
+            for (std::string const &key : _store->keys()) {
+                if (!FSUtil::IsAbsolutePath(key) || store->value(key) != nullptr) {
+                    continue;
+                }
+
+                ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(key);
+                if (!stamp) {
+                    continue;
+                }
+
+                if (std::shared_ptr<Object const> object = stored(key, *stamp)) {
+                    store->set(key, StoreEntry(*stamp, object.get()));
+                }
+            }
+        }
+    }
+
+    if (!CacheFile::Save(filesystem, path, CacheVersion, std::move(store))) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _modified = false;
+    return true;
+}
+
+FileCache *FileCache::
+GetDefault()
+{
+    static FileCache *cache = new FileCache();
+    return cache;
+}
@@ -429,3 +429,64 @@ ABPReadTopLevelObject(ABPContext *context)
 {
     return ABPReadObject(context, context->trailer.topLevelObject);
 }
+
+bool
+ABPReadDictionaryReferences(ABPContext *context, uint64_t reference,
+        std::vector<uint64_t> *keys, std::vector<uint64_t> *values)
+{
+    int    byte;
+    size_t n, nitems;
+
+    if (context == NULL || keys == NULL || values == NULL)
+        return false;
+
+    /* Fail if not a reader, complete, or not opened. */
+    if ((context->flags & kABPContextComplete) != 0 ||
+        (context->flags & kABPContextOpened) == 0)
+        return false;
+
+    if (reference >= context->trailer.objectsCount) {
+        __ABPError(context, "reference out of range");
+        return false;
+    }
+
+    if (__ABPSeek(context, context->offsets[reference], SEEK_SET) < 0) {
+        __ABPError(context, "object reference's offset out of range");
+        return false;
+    }
+
+    byte = __ABPReadByte(context);
+    if (byte == EOF || __ABPByteToRecordType(byte) != kABPRecordTypeDictionary)
+        return false;
+
+    nitems = byte & 0x0f;
+    if (!__ABPReadLength(context, &nitems)) {
+        __ABPError(context, "EOF reading dictionary count value");
+        return false;
+    }
+
+    /* Keys are unique, so each is a different object. */
+    if (nitems > context->trailer.objectsCount) {
+        __ABPError(context, "corrupted dictionary count value");
+        return false;
+    }
+
+    keys->resize(nitems);
+    values->resize(nitems);
+
+    for (n = 0; n < nitems; n++) {
+        if (!__ABPReadReference(context, &(*keys)[n])) {
+            __ABPError(context, "corrupted dictionary's key references table");
+            return false;
+        }
+    }
+
+    for (n = 0; n < nitems; n++) {
+        if (!__ABPReadReference(context, &(*values)[n])) {
+            __ABPError(context, "corrupted dictionary's object references table");
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -11,6 +11,9 @@
 #include <plist/Format/Encoding.h>
 #include <plist/Objects.h>
 
+#include <cstring>
+#include <functional>
+
 using plist::Format::Encoding;
 using plist::Format::Encodings;
 using plist::ObjectType;
@@ -25,6 +28,7 @@ using plist::Null;
 using plist::UID;
 using plist::Array;
 using plist::Dictionary;
+using plist::CastTo;
 
 enum {
     kABPWriteObjectTopLevel  = (1 << 0), /* Object is top level. */
@@ -39,6 +43,58 @@ _ABPWritePreflightObject(ABPContext *context, Object const *object,
 static bool
 _ABPWriteObject(ABPContext *context, Object const *object, uint32_t flags);
 
+size_t ABPValueHash::
+operator()(Object const *object) const
+{
+    size_t hash = std::hash<int>()(static_cast<int>(object->type()));
+
+    if (String const *string = CastTo<String>(object)) {
+        hash ^= std::hash<std::string>()(string->value());
+    } else if (Integer const *integer = CastTo<Integer>(object)) {
+        hash ^= std::hash<int64_t>()(integer->value());
+    } else if (Real const *real = CastTo<Real>(object)) {
+        uint64_t bits;
+        double   value = real->value();
+        memcpy(&bits, &value, sizeof(bits));
+        hash ^= std::hash<uint64_t>()(bits);
+    } else if (Boolean const *boolean = CastTo<Boolean>(object)) {
+        hash ^= std::hash<bool>()(boolean->value());
+    } else if (Data const *data = CastTo<Data>(object)) {
+        /* FNV-1a */
+        uint64_t value = 14695981039346656037ULL;
+        for (uint8_t byte : data->value()) {
+            value = (value ^ byte) * 1099511628211ULL;
+        }
+        hash ^= static_cast<size_t>(value);
+    } else if (Date const *date = CastTo<Date>(object)) {
+        hash ^= std::hash<uint64_t>()(date->unixTimeValue());
+    } else if (UID const *uid = CastTo<UID>(object)) {
+        hash ^= std::hash<uint32_t>()(uid->value());
+    }
+
+    return hash;
+}
+
+bool ABPValueEqual::
+operator()(Object const *a, Object const *b) const
+{
+    if (a == b) {
+        return true;
+    } else if (a->type() != b->type()) {
+        return false;
+    }
+
+    if (Real const *real = CastTo<Real>(a)) {
+        /* Compare the bits: -0.0 and 0.0 are different values to write. */
+        double ra = real->value(), rb = CastTo<Real>(b)->value();
+        return (memcmp(&ra, &rb, sizeof(double)) == 0);
+    } else if (a->type() == Null::Type()) {
+        return true;
+    } else {
+        return a->equals(b);
+    }
+}
+
 static bool
 __ABPWriteOffsetTable(ABPContext *context)
 {
@@ -235,22 +291,32 @@ __ABPWriteString(ABPContext *context, String *string)
 }
 
 /*
- * Workaround for Dictionaries not having keys with identity. Map from integer key
- * index to key value to use as the identity when writing the key object out.
+ * Workaround for Dictionaries not having keys with identity. Each key value
+ * gets one string object, used as the identity when writing the key out; a
+ * dictionary's strings are found once, then used by index.
  */
-static String *
-__ABPDictionaryKeyString(ABPContext *context, Dictionary const *dict, int key)
+static std::vector<String *> const &
+__ABPDictionaryKeyStrings(ABPContext *context, Dictionary const *dict)
 {
-    std::unordered_map<int, String *> *map = &context->keyStrings[dict];
+    /* Look up before inserting: this is called for every dictionary reference. */
+    auto found = context->keyStrings.find(dict);
+    if (found != context->keyStrings.end()) {
+        return found->second;
+    }
 
-    auto it = map->find(key);
-    if (it != map->end()) {
-        return it->second;
-    } else {
-        auto string = String::New(dict->key(key));
-        map->insert({ key, string.get() });
-        return string.release();
+    std::vector<String *> *strings = &context->keyStrings[dict];
+    strings->reserve(dict->count());
+
+    for (size_t i = 0; i < dict->count(); ++i) {
+        auto it = context->keyValues.find(dict->key(i));
+        if (it == context->keyValues.end()) {
+            auto string = String::New(dict->key(i));
+            it = context->keyValues.insert({ dict->key(i), string.release() }).first;
+        }
+        strings->push_back(it->second);
     }
+
+    return *strings;
 }
 
 static inline void
@@ -290,8 +356,7 @@ __ABPWriteArray(ABPContext *context, Array const *array)
 static void
 __ABPWriteDictionaryReferences(ABPContext *context, Dictionary const *dict)
 {
-    for (int i = 0; i < dict->count(); ++i) {
-        String *key = __ABPDictionaryKeyString(context, dict, i);
+    for (String *key : __ABPDictionaryKeyStrings(context, dict)) {
         _ABPWriteObject(context, key, kABPWriteObjectReference);
     }
 
@@ -303,8 +368,7 @@ __ABPWriteDictionaryReferences(ABPContext *context, Dictionary const *dict)
 static void
 __ABPWriteDictionaryValues(ABPContext *context, Dictionary const *dict)
 {
-    for (int i = 0; i < dict->count(); ++i) {
-        String *key = __ABPDictionaryKeyString(context, dict, i);
+    for (String *key : __ABPDictionaryKeyStrings(context, dict)) {
         _ABPWriteObject(context, key, kABPWriteObjectValue);
     }
 
@@ -353,8 +417,7 @@ static void
 __ABPWritePreflightDictionaryReferences(ABPContext *context,
         Dictionary const *dict)
 {
-    for (int i = 0; i < dict->count(); ++i) {
-        String *key = __ABPDictionaryKeyString(context, dict, i);
+    for (String *key : __ABPDictionaryKeyStrings(context, dict)) {
         _ABPWritePreflightObject(context, key, 0);
     }
 
@@ -371,6 +434,34 @@ __ABPWritePreflightDictionary(ABPContext *context, Dictionary const *dict)
     return true;
 }
 
+static void
+__ABPWritePreflightSize(ABPContext *context, Object const *object)
+{
+    uint64_t size = 1;
+
+    if (Array const *array = CastTo<Array>(object)) {
+        size = __ABPLengthSize(array->count());
+        context->preflightReferences += array->count();
+    } else if (Dictionary const *dict = CastTo<Dictionary>(object)) {
+        size = __ABPLengthSize(dict->count());
+        context->preflightReferences += dict->count() * 2;
+    } else if (String const *string = CastTo<String>(object)) {
+        /* At most two bytes per character, if not ASCII. */
+        size_t length = string->value().size();
+        size = __ABPLengthSize(length) + length * 2;
+    } else if (Data const *data = CastTo<Data>(object)) {
+        size_t length = data->value().size();
+        size = __ABPLengthSize(length) + length;
+    } else if (object->type() == Integer::Type() ||
+               object->type() == Real::Type() ||
+               object->type() == Date::Type() ||
+               object->type() == UID::Type()) {
+        size = 1 + sizeof(uint64_t);
+    }
+
+    context->preflightBytes += size;
+}
+
 /*
  * Process an object, calls the user callback in order to
  * return a suitable object for the encoding; the object
@@ -398,6 +489,12 @@ _ABPWriterProcessObject(ABPContext *context, Object const **object, uint32_t *re
         if (userProcess && (*(context->processCallBacks.process))(
                     context->processCallBacks.opaque, &newObject)) {
             ObjectType type = newObject->type();
+
+            /* Write each value only once, whichever object it is in. */
+            if (type != Array::Type() && type != Dictionary::Type()) {
+                newObject = *context->uniques.insert(newObject).first;
+            }
+
             /* Cache mapping, but do so only if newObject is different
              * than the origObject or origObject is not a container.
              */
@@ -488,6 +585,9 @@ _ABPWritePreflightObject(ABPContext *context, Object const *object,
                 (Dictionary const *)object);
     }
 
+    /* Count how much will be written, once reference sizes are known. */
+    __ABPWritePreflightSize(context, object);
+
     if (!success) abort();
     return success;
 }
@@ -587,7 +687,9 @@ ABPWriterInit(ABPContext *context, ABPStreamCallBacks const *streamCallBacks,
     context->references       = std::unordered_map<plist::Object const *, int>();
     context->mappings         = std::unordered_map<plist::Object const *, plist::Object const *>();
     context->written          = std::unordered_set<plist::Object const *>();
-    context->keyStrings       = std::unordered_map<plist::Dictionary const *, std::unordered_map<int, plist::String *>>();
+    context->uniques          = std::unordered_set<plist::Object const *, ABPValueHash, ABPValueEqual>();
+    context->keyStrings       = std::unordered_map<plist::Dictionary const *, std::vector<plist::String *>>();
+    context->keyValues        = std::unordered_map<std::string, plist::String *>();
 
     return true;
 }
@@ -664,10 +766,8 @@ ABPWriterClose(ABPContext *context)
             return false;
     }
 
-    for (auto const &map : context->keyStrings) {
-        for (auto const &item : map.second) {
-            item.second->release();
-        }
+    for (auto const &item : context->keyValues) {
+        item.second->release();
     }
 
     _ABPContextFree(context);
@@ -706,6 +806,13 @@ ABPWriteTopLevelObject(ABPContext *context, Object const *object)
             context->trailer.objectRefByteSize = sizeof(uint8_t);
         }
 
+        /* Expect the objects, their references, and the offsets table. */
+        __ABPReserve(context, sizeof(context->header) +
+                context->preflightBytes +
+                context->preflightReferences * context->trailer.objectRefByteSize +
+                context->trailer.objectsCount * sizeof(uint64_t) +
+                sizeof(context->trailer));
+
         /* Allocate enough space for the offsets table. */
         context->offsets = (uint64_t *)calloc(
                 context->trailer.objectsCount, sizeof(uint64_t));
@@ -10,12 +10,17 @@
 #include <plist/Format/ASCII.h>
 #include <plist/Format/ASCIIParser.h>
 #include <plist/Format/ASCIIWriter.h>
+#include <plist/Format/ObjectBuilder.h>
 #include <plist/Objects.h>
 
+#include <algorithm>
+
 using plist::Format::Type;
 using plist::Format::Encoding;
 using plist::Format::Format;
 using plist::Format::ASCII;
+using plist::Format::Handler;
+using plist::Format::ObjectBuilder;
 using plist::Object;
 
 ASCII::
@@ -35,9 +40,9 @@ namespace plist { namespace Format {
 
 template<>
 std::unique_ptr<ASCII> Format<ASCII>::
-Identify(std::vector<uint8_t> const &contents)
+Identify(uint8_t const *data, size_t size)
 {
-    Encoding encoding = Encodings::Detect(contents);
+    Encoding encoding = Encodings::Detect(data, size);
 
     /*
      * Identification of ASCII is as follows:
@@ -64,7 +69,7 @@ Identify(std::vector<uint8_t> const &contents)
     enum State state = kStateBegin, pstate = state;
     bool identifier = false;
 
-    for (auto bp = contents.begin(); bp != contents.end();) {
+    for (uint8_t const *bp = data; bp != data + size;) {
         /* Conceal zeroes for UTF-16/32 encodings. */
         if (*bp == 0 || (state != kStateComment &&
                          state != kStateInlineComment &&
@@ -139,7 +144,7 @@ Identify(std::vector<uint8_t> const &contents)
                 case 0xef: /* UTF-8 */
                 case 0xbb:
                 case 0xbf:
-                    if (bp - contents.begin() < 4) {
+                    if (bp - data < 4) {
                         bp++;
                         continue;
                     } else {
@@ -219,27 +224,45 @@ Identify(std::vector<uint8_t> const &contents)
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<ASCII>::
-Deserialize(std::vector<uint8_t> const &contents, ASCII const &format)
+std::pair<bool, std::string> Format<ASCII>::
+Parse(uint8_t const *data, size_t size, ASCII const &format, Handler *handler)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
-
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+    /* UTF-8 contents are lexed in place, other encodings are converted. */
+    std::vector<uint8_t> converted;
+    if (format.encoding() == Encoding::UTF8) {
+        std::vector<uint8_t> BOM = Encodings::BOM(Encoding::UTF8);
+        if (size >= BOM.size() && std::equal(BOM.begin(), BOM.end(), data)) {
+            data += BOM.size();
+            size -= BOM.size();
+        }
+    } else {
+        converted = Encodings::Convert(data, size, format.encoding(), Encoding::UTF8);
+        data = converted.data();
+        size = converted.size();
+    }
 
     /* Create lexer. */
     ASCIIPListLexer lexer;
-    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data.data()), data.size(), kASCIIPListLexerStyleASCII);
+    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data), size, kASCIIPListLexerStyleASCII);
 
     /* Parse contents. */
-    ASCIIParser parser;
-    if (parser.parse(&lexer, format.strings())) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    ASCIIParser parser(handler);
+    bool success = parser.parse(&lexer, format.strings());
+    return std::make_pair(success, parser.error());
+}
+
+template<>
+std::pair<std::unique_ptr<Object>, std::string> Format<ASCII>::
+Deserialize(uint8_t const *data, size_t size, ASCII const &format)
+{
+    ObjectBuilder builder;
+
+    std::pair<bool, std::string> result = Parse(data, size, format, &builder);
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(std::move(builder.root()), std::string());
 }
 
 template<>
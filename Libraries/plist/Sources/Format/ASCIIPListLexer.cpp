@@ -14,6 +14,10 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /*
  * Syntax:
  *
@@ -68,6 +72,54 @@
 
 /** Helpers **/
 
+/*
+ * The character at a position, or '\0' past the end of the input. The
+ * input doesn't have to be terminated, such as when it's a mapped file.
+ */
+static inline char
+ASCIIPListLexerPeek(ASCIIPListLexer const *lexer, char const *p)
+{
+    return (p < lexer->endBuffer ? *p : '\0');
+}
+
+/*
+ * Skips ahead towards the first of four characters, but never past it or
+ * the end of the input. With SSE2, sixteen characters are checked at once;
+ * the caller's own loop then handles what is left.
+ */
+static inline char const *
+ASCIIPListLexerSkip(ASCIIPListLexer const *lexer, char const *p, char c0, char c1, char c2, char c3)
+{
+#if defined(__SSE2__)
+    __m128i const v0 = _mm_set1_epi8(c0);
+    __m128i const v1 = _mm_set1_epi8(c1);
+    __m128i const v2 = _mm_set1_epi8(c2);
+    __m128i const v3 = _mm_set1_epi8(c3);
+
+    while (lexer->endBuffer - p > 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+        __m128i match = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, v0), _mm_cmpeq_epi8(chunk, v1)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, v2), _mm_cmpeq_epi8(chunk, v3)));
+
+        int mask = _mm_movemask_epi8(match);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+
+        p += 16;
+    }
+#else
+    (void)lexer;
+    (void)c0;
+    (void)c1;
+    (void)c2;
+    (void)c3;
+#endif
+
+    return p;
+}
+
 static inline bool
 istokenseparator(char ch, ASCIIPListLexer *lexer)
 {
@@ -107,7 +159,9 @@ ASCIIPListLexerReadInlineComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0' && *p != '\n' && *p != '\r'; p++)
+    b = p;
+    p = ASCIIPListLexerSkip(lexer, p, '\0', '\n', '\r', '\0');
+    for (; p < lexer->endBuffer && *p != '\0' && *p != '\n' && *p != '\r'; p++)
         ;
     lexer->tokenLength = p - b;
     lexer->pointer = p;
@@ -121,11 +175,15 @@ ASCIIPListLexerReadLongComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0'; p++) {
+    for (b = p; ASCIIPListLexerPeek(lexer, p) != '\0'; p++) {
+        p = ASCIIPListLexerSkip(lexer, p, '\0', '\n', '*', '\0');
+
         if (p[0] == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
-        } else if (p[0] == '*' && p[1] == '/') {
+        } else if (p[0] == '\0') {
+            break;
+        } else if (p[0] == '*' && ASCIIPListLexerPeek(lexer, p + 1) == '/') {
             lexer->tokenLength = p - b;
             lexer->pointer = p + 2;
             return kASCIIPListLexerTokenLongComment;
@@ -141,14 +199,18 @@ ASCIIPListLexerReadSingleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\'' && *p != '\0'; p++) {
+    for (b = p; ASCIIPListLexerPeek(lexer, p) != '\'' && ASCIIPListLexerPeek(lexer, p) != '\0'; p++) {
+        p = ASCIIPListLexerSkip(lexer, p, '\'', '\0', '\n', '\0');
+
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
+        } else if (*p == '\'' || *p == '\0') {
+            break;
         }
     }
 
-    if (*p != '\'') {
+    if (ASCIIPListLexerPeek(lexer, p) != '\'') {
         return kASCIIPListLexerUnterminatedQuotedString;
     }
 
@@ -164,16 +226,23 @@ ASCIIPListLexerReadDoubleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\"' && *p != '\0'; p++) {
+    for (b = p; ASCIIPListLexerPeek(lexer, p) != '\"' && ASCIIPListLexerPeek(lexer, p) != '\0'; p++) {
+        p = ASCIIPListLexerSkip(lexer, p, '\"', '\0', '\n', '\\');
+
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
         } else if (*p == '\\') {
             p++;
+            if (p >= lexer->endBuffer) {
+                break;
+            }
+        } else if (*p == '\"' || *p == '\0') {
+            break;
         }
     }
 
-    if (*p != '\"') {
+    if (ASCIIPListLexerPeek(lexer, p) != '\"') {
         return kASCIIPListLexerUnterminatedQuotedString;
     }
 
@@ -189,7 +258,7 @@ ASCIIPListLexerReadData(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '>' && *p != '\0'; p++) {
+    for (b = p; ASCIIPListLexerPeek(lexer, p) != '>' && ASCIIPListLexerPeek(lexer, p) != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -203,7 +272,7 @@ ASCIIPListLexerReadData(ASCIIPListLexer *lexer)
         }
     }
 
-    if (*p != '>')
+    if (ASCIIPListLexerPeek(lexer, p) != '>')
         return kASCIIPListLexerUnterminatedData;
 
     lexer->tokenLength = p - b;
@@ -233,53 +302,53 @@ ASCIIPListLexerReadJSONNumber(ASCIIPListLexer *lexer)
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
 
-    if (*p == '-') {
+    if (ASCIIPListLexerPeek(lexer, p) == '-') {
         p++;
     }
 
-    if (!isdigit(*p)) {
+    if (!isdigit(ASCIIPListLexerPeek(lexer, p))) {
         return kASCIIPListLexerInvalidToken;
     }
-    bool zero = (*p == '0');
-    while (isdigit(*p)) {
+    bool zero = (ASCIIPListLexerPeek(lexer, p) == '0');
+    while (isdigit(ASCIIPListLexerPeek(lexer, p))) {
         /* Numbers cannot start with zero. */
-        if (zero && *p != '0') {
+        if (zero && ASCIIPListLexerPeek(lexer, p) != '0') {
             return kASCIIPListLexerInvalidToken;
         }
 
         p++;
     }
 
-    if (*p == '.') {
+    if (ASCIIPListLexerPeek(lexer, p) == '.') {
         integer = false;
 
         p++;
 
-        if (!isdigit(*p)) {
+        if (!isdigit(ASCIIPListLexerPeek(lexer, p))) {
             return kASCIIPListLexerInvalidToken;
         }
-        while (isdigit(*p)) {
+        while (isdigit(ASCIIPListLexerPeek(lexer, p))) {
             p++;
         }
     }
 
-    if (*p == 'e' || *p == 'E') {
+    if (ASCIIPListLexerPeek(lexer, p) == 'e' || ASCIIPListLexerPeek(lexer, p) == 'E') {
         integer = false;
 
         p++;
-        if (*p == '+' || *p == '-') {
+        if (ASCIIPListLexerPeek(lexer, p) == '+' || ASCIIPListLexerPeek(lexer, p) == '-') {
             p++;
         }
 
-        if (!isdigit(*p)) {
+        if (!isdigit(ASCIIPListLexerPeek(lexer, p))) {
             return kASCIIPListLexerInvalidToken;
         }
-        while (isdigit(*p)) {
+        while (isdigit(ASCIIPListLexerPeek(lexer, p))) {
             p++;
         }
     }
 
-    if (istokenseparator(*p, lexer)) {
+    if (istokenseparator(ASCIIPListLexerPeek(lexer, p), lexer)) {
         lexer->tokenLength = p - b;
         lexer->pointer = p;
         return (integer ? kASCIIPListLexerTokenNumberInteger : kASCIIPListLexerTokenNumberReal);
@@ -298,16 +367,16 @@ ASCIIPListLexerReadKeyword(ASCIIPListLexer *lexer)
     lexer->tokenBegin = p - lexer->inputBuffer;
 
     if (lexer->style == kASCIIPListLexerStyleJSON) {
-        if (*p == 't' && strncmp(p, "true", 4) == 0 &&
-            istokenseparator(*(p + 4), lexer)) {
+        if (ASCIIPListLexerPeek(lexer, p) == 't' && lexer->endBuffer - p >= 4 && strncmp(p, "true", 4) == 0 &&
+            istokenseparator(ASCIIPListLexerPeek(lexer, p + 4), lexer)) {
             p += 4;
             rc = kASCIIPListLexerTokenBoolTrue;
-        } else if (*p == 'f' && strncmp(p, "false", 5) == 0 &&
-                   istokenseparator(*(p + 5), lexer)) {
+        } else if (ASCIIPListLexerPeek(lexer, p) == 'f' && lexer->endBuffer - p >= 5 && strncmp(p, "false", 5) == 0 &&
+                   istokenseparator(ASCIIPListLexerPeek(lexer, p + 5), lexer)) {
             p += 5;
             rc = kASCIIPListLexerTokenBoolFalse;
-        } else if (*p == 'n' && strncmp(p, "null", 4) == 0 &&
-                   istokenseparator(*(p + 4), lexer)) {
+        } else if (ASCIIPListLexerPeek(lexer, p) == 'n' && lexer->endBuffer - p >= 4 && strncmp(p, "null", 4) == 0 &&
+                   istokenseparator(ASCIIPListLexerPeek(lexer, p + 4), lexer)) {
             p += 4;
             rc = kASCIIPListLexerTokenNull;
         }
@@ -316,9 +385,9 @@ ASCIIPListLexerReadKeyword(ASCIIPListLexer *lexer)
         /*
             * '$' is encountered in pbxproj files.
             */
-        while (isalnum(*p) || *p == '_' || *p == '.' || *p == '$' ||
-                              *p == '-' || *p == ':' || *p == '/') {
-            if (*p & 0x80) {
+        while (isalnum(ASCIIPListLexerPeek(lexer, p)) || ASCIIPListLexerPeek(lexer, p) == '_' || ASCIIPListLexerPeek(lexer, p) == '.' || ASCIIPListLexerPeek(lexer, p) == '$' ||
+                              ASCIIPListLexerPeek(lexer, p) == '-' || ASCIIPListLexerPeek(lexer, p) == ':' || ASCIIPListLexerPeek(lexer, p) == '/') {
+            if (ASCIIPListLexerPeek(lexer, p) & 0x80) {
                 rc = kASCIIPListLexerInvalidToken;
                 break;
             }
@@ -341,10 +410,10 @@ ASCIIPListLexerReadToken(ASCIIPListLexer *lexer)
     while (p < lexer->endBuffer) {
         switch (*p) {
             case '/': /* Comments */
-                if (p[1] == '/') {
+                if (ASCIIPListLexerPeek(lexer, p + 1) == '/') {
                     lexer->pointer = p;
                     return ASCIIPListLexerReadInlineComment(lexer);
-                } else if (p[1] == '*') {
+                } else if (ASCIIPListLexerPeek(lexer, p + 1) == '*') {
                     lexer->pointer = p;
                     return ASCIIPListLexerReadLongComment(lexer);
                 } else {
@@ -714,6 +783,25 @@ fail:
     return NULL;
 }
 
+bool
+ASCIIPListCopyUnquotedString(ASCIIPListLexer const *lexer, int lossByte, std::string *string)
+{
+    char const *token = lexer->inputBuffer + lexer->tokenBegin;
+
+    if (memchr(token, '\\', lexer->tokenLength) == NULL && memchr(token, '\0', lexer->tokenLength) == NULL) {
+        string->assign(token, lexer->tokenLength);
+        return true;
+    }
+
+    char *copy = ASCIIPListCopyUnquotedString(lexer, lossByte);
+    if (copy == NULL)
+        return false;
+
+    string->assign(copy);
+    free(copy);
+    return true;
+}
+
 /* Data copy */
 
 char *
@@ -9,22 +9,77 @@
 
 #include <plist/Format/BaseXMLParser.h>
 
+#include <algorithm>
+#include <iterator>
+
+#include <cctype>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 
 using plist::Format::BaseXMLParser;
 
 BaseXMLParser::BaseXMLParser() :
     _parser (nullptr),
-    _depth  (0)
+    _depth  (0),
+    _begin  (nullptr),
+    _cursor (nullptr),
+    _end    (nullptr),
+    _stopped(false)
+{
+}
+
+/*
+ * If the document can be parsed without libxml2. Document type declarations
+ * with an internal subset can declare entities, and CDATA sections are not
+ * reported by libxml2's reader, so leave both to it. Anything else starting
+ * with "<!" is an error either way, so libxml2 can report it too.
+ */
+static bool
+Streamable(uint8_t const *data, size_t size)
+{
+    uint8_t const *end = data + size;
+    for (uint8_t const *it = data; it < end; ++it) {
+        it = static_cast<uint8_t const *>(::memchr(it, '<', end - it));
+        if (it == nullptr) {
+            break;
+        }
+
+        size_t remaining = end - it;
+        if (remaining < 2 || it[1] != '!') {
+            continue;
+        }
+
+        if (remaining >= 4 && ::memcmp(it, "<!--", 4) == 0) {
+            continue;
+        } else if (remaining >= 9 && ::memcmp(it, "<!DOCTYPE", 9) == 0) {
+            uint8_t const *close = static_cast<uint8_t const *>(::memchr(it, '>', remaining));
+            if (close == nullptr || ::memchr(it, '[', close - it) != nullptr) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool BaseXMLParser::
+parse(uint8_t const *data, size_t size)
 {
+    if (Streamable(data, size)) {
+        return parseStream(data, size);
+    } else {
+        return parseReader(data, size);
+    }
 }
 
 bool BaseXMLParser::
-parse(std::vector<uint8_t> const &contents)
+parseReader(uint8_t const *data, size_t size)
 {
     _depth  = 0;
-    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(contents.data()), contents.size(), nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
+    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(data), size, nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
     if (_parser == nullptr) {
         return false;
     }
@@ -68,7 +123,7 @@ parse(std::vector<uint8_t> const &contents)
             xmlChar const *name = xmlTextReaderConstName(_parser);
             onStartElement(std::string(reinterpret_cast<char const *>(name)), attrs, _depth);
 
-            if (ret == 1) {
+            if (ret == 1 && _parser != nullptr) {
                 /* Empty element. */
                 onEndElement(std::string(reinterpret_cast<char const *>(name)), _depth);
             }
@@ -98,6 +153,403 @@ parse(std::vector<uint8_t> const &contents)
     return (ret == 0);
 }
 
+static inline bool
+IsBlank(uint8_t c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+static inline bool
+IsNameStart(uint8_t c)
+{
+    return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || c >= 0x80);
+}
+
+static inline bool
+IsName(uint8_t c)
+{
+    return (IsNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.');
+}
+
+static void
+AppendUTF8(std::string *value, uint32_t c)
+{
+    if (c < 0x80) {
+        value->push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        value->push_back(static_cast<char>(0xC0 | (c >> 6)));
+        value->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+        value->push_back(static_cast<char>(0xE0 | (c >> 12)));
+        value->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        value->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+        value->push_back(static_cast<char>(0xF0 | (c >> 18)));
+        value->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+        value->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        value->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+}
+
+bool BaseXMLParser::
+parseStream(uint8_t const *data, size_t size)
+{
+    _depth   = 0;
+    _begin   = data;
+    _cursor  = data;
+    _end     = data + size;
+    _stopped = false;
+    _elements.clear();
+
+    onBeginParse();
+
+    bool success = parseStreamDocument();
+
+    _depth  = 0;
+    _begin  = nullptr;
+    _cursor = nullptr;
+    _end    = nullptr;
+    onEndParse(success);
+
+    return success;
+}
+
+bool BaseXMLParser::
+parseStreamDocument()
+{
+    /* Byte order mark. */
+    if (_end - _cursor >= 3 && _cursor[0] == 0xEF && _cursor[1] == 0xBB && _cursor[2] == 0xBF) {
+        _cursor += 3;
+    }
+
+    bool root = false;
+    while (_cursor < _end) {
+        if (*_cursor != '<') {
+            if (!parseStreamText()) {
+                return false;
+            }
+
+            /* Like libxml2's reader, whitespace-only text isn't reported. */
+            if (std::all_of(_text.begin(), _text.end(), [](char c) { return IsBlank(static_cast<uint8_t>(c)); })) {
+                continue;
+            }
+
+            if (_elements.empty()) {
+                streamError("text outside of the root element");
+                return false;
+            }
+
+            _depth = _elements.size();
+            onCharacterData(_text, _depth);
+            if (_stopped) {
+                return false;
+            }
+        } else if (_end - _cursor >= 2 && _cursor[1] == '?') {
+            if (!skipStreamPast("?>")) {
+                return false;
+            }
+        } else if (_end - _cursor >= 4 && ::memcmp(_cursor, "<!--", 4) == 0) {
+            if (!skipStreamPast("-->")) {
+                return false;
+            }
+        } else if (_end - _cursor >= 2 && _cursor[1] == '!') {
+            /* Only document type declarations without an internal subset get here. */
+            if (root) {
+                streamError("document type declaration after the root element");
+                return false;
+            }
+            if (!skipStreamPast(">")) {
+                return false;
+            }
+        } else if (_end - _cursor >= 2 && _cursor[1] == '/') {
+            if (!parseStreamEndElement()) {
+                return false;
+            }
+        } else {
+            if (root && _elements.empty()) {
+                streamError("extra content at the end of the document");
+                return false;
+            }
+            root = true;
+
+            if (!parseStreamElement()) {
+                return false;
+            }
+        }
+    }
+
+    if (!root) {
+        streamError("document is empty");
+        return false;
+    } else if (!_elements.empty()) {
+        streamError("unexpected end of document");
+        return false;
+    }
+
+    return true;
+}
+
+bool BaseXMLParser::
+parseStreamName(std::string *name)
+{
+    uint8_t const *start = _cursor;
+    if (_cursor == _end || !IsNameStart(*_cursor)) {
+        streamError("expected a name");
+        return false;
+    }
+
+    while (_cursor < _end && IsName(*_cursor)) {
+        ++_cursor;
+    }
+
+    name->assign(reinterpret_cast<char const *>(start), _cursor - start);
+    return true;
+}
+
+bool BaseXMLParser::
+parseStreamReference(std::string *value)
+{
+    /* Skip the '&'. */
+    uint8_t const *start = ++_cursor;
+    uint8_t const *semicolon = static_cast<uint8_t const *>(::memchr(start, ';', std::min<size_t>(_end - start, 16)));
+    if (semicolon == nullptr) {
+        streamError("unterminated entity reference");
+        return false;
+    }
+
+    std::string name = std::string(reinterpret_cast<char const *>(start), semicolon - start);
+    if (name == "lt") {
+        value->push_back('<');
+    } else if (name == "gt") {
+        value->push_back('>');
+    } else if (name == "amp") {
+        value->push_back('&');
+    } else if (name == "apos") {
+        value->push_back('\'');
+    } else if (name == "quot") {
+        value->push_back('"');
+    } else if (name.size() >= 2 && name[0] == '#') {
+        bool hex = (name[1] == 'x');
+        std::string digits = name.substr(hex ? 2 : 1);
+
+        char *digitsEnd = nullptr;
+        unsigned long c = ::strtoul(digits.c_str(), &digitsEnd, hex ? 16 : 10);
+        if (digits.empty() || *digitsEnd != '\0' || !std::all_of(digits.begin(), digits.end(), ::isxdigit) ||
+            c == 0 || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+            streamError("invalid character reference");
+            return false;
+        }
+
+        AppendUTF8(value, static_cast<uint32_t>(c));
+    } else {
+        streamError("undefined entity");
+        return false;
+    }
+
+    _cursor = semicolon + 1;
+    return true;
+}
+
+bool BaseXMLParser::
+parseStreamText()
+{
+    _text.clear();
+
+    while (_cursor < _end && *_cursor != '<') {
+        /* Append the run of plain characters at once. */
+        uint8_t const *start = _cursor;
+        while (_cursor < _end && *_cursor != '<' && *_cursor != '&' && *_cursor != '\r') {
+            ++_cursor;
+        }
+        _text.append(reinterpret_cast<char const *>(start), _cursor - start);
+
+        if (_cursor == _end) {
+            break;
+        } else if (*_cursor == '&') {
+            if (!parseStreamReference(&_text)) {
+                return false;
+            }
+        } else if (*_cursor == '\r') {
+            /* Line endings are normalized to a line feed. */
+            _text.push_back('\n');
+            ++_cursor;
+            if (_cursor < _end && *_cursor == '\n') {
+                ++_cursor;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool BaseXMLParser::
+parseStreamElement()
+{
+    /* Skip the '<'. */
+    ++_cursor;
+    if (!parseStreamName(&_name)) {
+        return false;
+    }
+
+    _attributes.clear();
+
+    bool empty = false;
+    while (true) {
+        bool separated = false;
+        while (_cursor < _end && IsBlank(*_cursor)) {
+            separated = true;
+            ++_cursor;
+        }
+
+        if (_cursor == _end) {
+            streamError("unterminated start tag");
+            return false;
+        } else if (*_cursor == '>') {
+            ++_cursor;
+            break;
+        } else if (*_cursor == '/') {
+            if (_end - _cursor < 2 || _cursor[1] != '>') {
+                streamError("expected '>' after '/'");
+                return false;
+            }
+            _cursor += 2;
+            empty = true;
+            break;
+        } else if (!separated) {
+            streamError("expected whitespace before attribute");
+            return false;
+        }
+
+        std::string name;
+        if (!parseStreamName(&name)) {
+            return false;
+        }
+
+        while (_cursor < _end && IsBlank(*_cursor)) {
+            ++_cursor;
+        }
+        if (_cursor == _end || *_cursor != '=') {
+            streamError("expected '=' after attribute name");
+            return false;
+        }
+        ++_cursor;
+        while (_cursor < _end && IsBlank(*_cursor)) {
+            ++_cursor;
+        }
+
+        if (_cursor == _end || (*_cursor != '"' && *_cursor != '\'')) {
+            streamError("expected a quoted attribute value");
+            return false;
+        }
+        uint8_t quote = *_cursor++;
+
+        /* Whitespace in attribute values is normalized to spaces, but not in references. */
+        std::string value;
+        while (_cursor < _end && *_cursor != quote) {
+            if (*_cursor == '<') {
+                streamError("unescaped '<' in attribute value");
+                return false;
+            } else if (*_cursor == '&') {
+                if (!parseStreamReference(&value)) {
+                    return false;
+                }
+            } else if (*_cursor == '\r') {
+                value.push_back(' ');
+                ++_cursor;
+                if (_cursor < _end && *_cursor == '\n') {
+                    ++_cursor;
+                }
+            } else if (*_cursor == '\n' || *_cursor == '\t') {
+                value.push_back(' ');
+                ++_cursor;
+            } else {
+                value.push_back(static_cast<char>(*_cursor));
+                ++_cursor;
+            }
+        }
+        if (_cursor == _end) {
+            streamError("unterminated attribute value");
+            return false;
+        }
+        ++_cursor;
+
+        if (!_attributes.insert({ std::move(name), std::move(value) }).second) {
+            streamError("duplicate attribute");
+            return false;
+        }
+    }
+
+    _depth = _elements.size();
+    onStartElement(_name, _attributes, _depth);
+    if (_stopped) {
+        return false;
+    }
+
+    if (empty) {
+        onEndElement(_name, _depth);
+        if (_stopped) {
+            return false;
+        }
+    } else {
+        _elements.push_back(_name);
+    }
+
+    return true;
+}
+
+bool BaseXMLParser::
+parseStreamEndElement()
+{
+    /* Skip the '</'. */
+    _cursor += 2;
+    if (!parseStreamName(&_name)) {
+        return false;
+    }
+
+    while (_cursor < _end && IsBlank(*_cursor)) {
+        ++_cursor;
+    }
+    if (_cursor == _end || *_cursor != '>') {
+        streamError("expected '>' after end tag name");
+        return false;
+    }
+    ++_cursor;
+
+    if (_elements.empty() || _elements.back() != _name) {
+        streamError("mismatched end tag");
+        return false;
+    }
+    _elements.pop_back();
+
+    _depth = _elements.size();
+    onEndElement(_name, _depth);
+    if (_stopped) {
+        return false;
+    }
+
+    return true;
+}
+
+bool BaseXMLParser::
+skipStreamPast(char const *terminator)
+{
+    size_t length = ::strlen(terminator);
+    uint8_t const *found = std::search(_cursor, _end, terminator, terminator + length);
+    if (found == _end) {
+        streamError("unexpected end of document");
+        return false;
+    }
+
+    _cursor = found + length;
+    return true;
+}
+
+void BaseXMLParser::
+streamError(char const *message)
+{
+    error("%s", message);
+}
+
 void BaseXMLParser::
 onBeginParse()
 {
@@ -137,14 +589,28 @@ error(std::string format, ...)
     }
     va_end(ap);
 
-    _line = ::xmlTextReaderGetParserLineNumber(_parser);
-    _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    if (_begin != nullptr) {
+        /* Parsing directly: count lines up to the current position. */
+        _line = 1 + std::count(_begin, _cursor, '\n');
+        _column = 1 + (_cursor - std::find(std::reverse_iterator<uint8_t const *>(_cursor), std::reverse_iterator<uint8_t const *>(_begin), '\n').base());
+    } else {
+        _line = ::xmlTextReaderGetParserLineNumber(_parser);
+        _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    }
     _error = std::string(buf);
 
     if (buf != sErrorMessage) {
         ::free(buf);
     }
 
+    stop();
+}
+
+void BaseXMLParser::
+stop()
+{
+    _stopped = true;
+
     ::xmlFreeTextReader(_parser);
     _parser = nullptr;
 }
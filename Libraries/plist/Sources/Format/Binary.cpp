@@ -8,7 +8,7 @@
  */
 
 #include <plist/Format/Binary.h>
-#include <plist/Format/ABPCoder.h>
+#include <plist/Format/BinaryParseContext.h>
 #include <plist/Format/Encoding.h>
 #include <plist/Objects.h>
 
@@ -20,6 +20,7 @@ using plist::Format::Format;
 using plist::Format::Binary;
 using plist::Format::Encoding;
 using plist::Format::Encodings;
+using plist::Format::Handler;
 using plist::Object;
 using plist::String;
 using plist::Integer;
@@ -48,33 +49,21 @@ namespace plist { namespace Format {
 
 template<>
 std::unique_ptr<Binary> Format<Binary>::
-Identify(std::vector<uint8_t> const &contents)
+Identify(uint8_t const *data, size_t size)
 {
     size_t length = strlen(ABPLIST_MAGIC ABPLIST_VERSION);
 
-    if (contents.size() < length) {
+    if (size < length) {
         return nullptr;
     }
 
-    if (std::memcmp(contents.data(), ABPLIST_MAGIC ABPLIST_VERSION, length) == 0) {
+    if (std::memcmp(data, ABPLIST_MAGIC ABPLIST_VERSION, length) == 0) {
         return std::unique_ptr<Binary>(new Binary(Binary::Create()));
     }
 
     return nullptr;
 }
 
-struct BinaryParseContext {
-    ABPContext                    context;
-    ABPStreamCallBacks            streamCallBacks;
-    ABPCreateCallBacks            createCallBacks;
-
-    std::vector<uint8_t> const   *contents;
-    off_t                         offset;
-
-    std::unordered_set<Object *>  seen;
-    std::string                   error;
-};
-
 static off_t
 ReadSeek(void *opaque, off_t offset, int whence)
 {
@@ -88,13 +77,13 @@ ReadSeek(void *opaque, off_t offset, int whence)
             self->offset += offset;
             break;
         case SEEK_END:
-            self->offset = self->contents->size() + offset;
+            self->offset = self->size + offset;
         default:
             break;
     }
 
     /* Error if past the end. */
-    if (self->offset > self->contents->size()) {
+    if (self->offset > self->size) {
         return -1;
     }
 
@@ -108,18 +97,58 @@ ReadData(void *opaque, void *buffer, size_t size)
     auto self = reinterpret_cast <BinaryParseContext *> (opaque);
 
     /* Adjust size for remaining contents. */
-    size_t remaining = self->contents->size() - self->offset;
+    size_t remaining = self->size - self->offset;
     if (remaining < size) {
         size = remaining;
     }
 
     /* Copy into read buffer. */
-    ::memcpy(buffer, self->contents->data() + self->offset, size);
+    ::memcpy(buffer, self->data + self->offset, size);
 
     self->offset += size;
     return size;
 }
 
+static inline bool
+IsPlaceholder(BinaryParseContext *self, Object *object)
+{
+    return (object == self->arrayPlaceholder.get() || object == self->dictionaryPlaceholder.get());
+}
+
+static bool
+Emit(BinaryParseContext *self, uint64_t reference, Object *object)
+{
+    if (IsPlaceholder(self, object)) {
+        /* Contents already sent; forget it so later references are sent again. */
+        self->context.objects[reference] = nullptr;
+        return true;
+    }
+
+    if (!self->handler->value(object->copy())) {
+        self->stopped = true;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Takes a read object to add to a container. Containers are only filled
+ * in once, so they are taken from the reader rather than copied; a later
+ * reference to the same container reads it again. Other objects are kept
+ * by the reader to be shared, so they are copied.
+ */
+static Object *
+Take(BinaryParseContext *self, uint64_t reference, Object *object)
+{
+    if (object->type() == Array::Type() || object->type() == Dictionary::Type()) {
+        self->context.objects[reference] = nullptr;
+        return object;
+    }
+
+    return object->copy().release();
+}
+
 static Object *
 Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
 {
@@ -175,16 +204,13 @@ Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
             std::string string;
 
             if (nchars > 0) {
-                if (ReadSeek(opaque, offset, SEEK_SET) < 0) {
-                    return nullptr;
-                }
-
+                /* Copy straight from the input, without a read buffer. */
                 size_t nbytes = sizeof(char) * nchars;
-                string.resize(nbytes);
-                size_t nread = ReadData(opaque, &string[0], nbytes);
-                if (nread < nbytes) {
+                if (offset < 0 || static_cast<size_t>(offset) > self->size || self->size - offset < nbytes) {
                     return nullptr;
                 }
+
+                string.assign(reinterpret_cast<char const *>(self->data + offset), nbytes);
             }
 
             return String::New(std::move(string)).release();
@@ -197,19 +223,15 @@ Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
             std::vector<uint8_t> buffer;
 
             if (nchars > 0) {
-                if (ReadSeek(opaque, offset, SEEK_SET) < 0) {
-                    return nullptr;
-                }
-
+                /* Convert straight from the input, without a read buffer. */
                 size_t nbytes = sizeof(uint16_t) * nchars;
-                buffer.resize(nbytes);
-                size_t nread = ReadData(opaque, buffer.data(), nbytes);
-                if (nread < nbytes) {
+                if (offset < 0 || static_cast<size_t>(offset) > self->size || self->size - offset < nbytes) {
                     return nullptr;
                 }
+
+                buffer = Encodings::Convert(self->data + offset, nbytes, Encoding::UTF16BE, Encoding::UTF8);
             }
 
-            buffer = Encodings::Convert(buffer, Encoding::UTF16BE, Encoding::UTF8);
 
             std::string string = std::string(buffer.begin(), buffer.end());
             return String::New(std::move(string)).release();
@@ -221,6 +243,27 @@ Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
             uint64_t *refs  = reinterpret_cast <uint64_t *> (arg1);
             size_t    nrefs = *reinterpret_cast <size_t *> (arg2);
 
+            if (self->handler != nullptr) {
+                if (!self->handler->beginArray()) {
+                    self->stopped = true;
+                    return nullptr;
+                }
+
+                for (size_t n = 0; n < nrefs; n++) {
+                    auto object = ::ABPReadObject(&self->context, refs[n]);
+                    if (object == nullptr || !Emit(self, refs[n], object)) {
+                        return nullptr;
+                    }
+                }
+
+                if (!self->handler->endArray()) {
+                    self->stopped = true;
+                    return nullptr;
+                }
+
+                return self->arrayPlaceholder.get();
+            }
+
             auto array = Array::New();
 
             for (size_t n = 0; n < nrefs; n++) {
@@ -229,15 +272,7 @@ Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
                     return nullptr;
                 }
 
-                //
-                // Due to the memory layout of the `plist' objects,
-                // we must always copy objects.
-                //
-                if (self->seen.find(object) != self->seen.end()) {
-                    self->seen.insert(object);
-                }
-                object = object->copy().release();
-
+                object = Take(self, refs[n], object);
                 array->append(std::unique_ptr<Object>(object));
             }
             return array.release();
@@ -247,7 +282,48 @@ Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
             uint64_t *refs  = reinterpret_cast <uint64_t *> (arg1);
             size_t    nrefs = *reinterpret_cast <size_t *> (arg2);
 
+            if (self->handler != nullptr) {
+                if (!self->handler->beginDictionary()) {
+                    self->stopped = true;
+                    return nullptr;
+                }
+
+                for (size_t n = 0; n < nrefs; n++) {
+                    auto keyObject = ::ABPReadObject(&self->context, refs[n * 2 + 0]);
+                    if (IsPlaceholder(self, keyObject)) {
+                        self->context.objects[refs[n * 2 + 0]] = nullptr;
+                        return nullptr;
+                    }
+
+                    //
+                    // Key must be of string type.
+                    //
+                    auto keyString = CastTo <String> (keyObject);
+                    if (keyString == nullptr) {
+                        return nullptr;
+                    }
+
+                    if (!self->handler->key(keyString->value())) {
+                        self->stopped = true;
+                        return nullptr;
+                    }
+
+                    auto object = ::ABPReadObject(&self->context, refs[n * 2 + 1]);
+                    if (object == nullptr || !Emit(self, refs[n * 2 + 1], object)) {
+                        return nullptr;
+                    }
+                }
+
+                if (!self->handler->endDictionary()) {
+                    self->stopped = true;
+                    return nullptr;
+                }
+
+                return self->dictionaryPlaceholder.get();
+            }
+
             auto dict = Dictionary::New();
+            dict->reserve(nrefs);
 
             for (size_t n = 0; n < nrefs; n++) {
                 auto keyObject = ::ABPReadObject(&self->context, refs[n * 2 + 0]);
@@ -268,15 +344,7 @@ Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
                     return nullptr;
                 }
 
-                //
-                // Due to the memory layout of the `plist' objects,
-                // we must always copy objects.
-                //
-                if (self->seen.find(object) != self->seen.end()) {
-                    self->seen.insert(object);
-                }
-                object = object->copy().release();
-
+                object = Take(self, refs[n * 2 + 1], object);
                 dict->set(keyString->value(), std::unique_ptr<Object>(object));
             }
             return dict.release();
@@ -292,37 +360,74 @@ static void
 Error(void *opaque, char const *message)
 {
     auto self = reinterpret_cast <BinaryParseContext *> (opaque);
-    self->error = message;
+
+    /* Stopping by the handler is not an error. */
+    if (!self->stopped) {
+        self->error = message;
+    }
+}
+
+void
+BinaryParseContextInit(BinaryParseContext *parseContext, uint8_t const *data, size_t size, Handler *handler)
+{
+    parseContext->streamCallBacks.version = 0;
+    parseContext->streamCallBacks.opaque  = parseContext;
+    parseContext->streamCallBacks.close   = nullptr;
+    parseContext->streamCallBacks.write   = nullptr;
+    parseContext->streamCallBacks.seek    = &ReadSeek;
+    parseContext->streamCallBacks.read    = &ReadData;
+    parseContext->streamCallBacks.reserve = nullptr;
+
+    parseContext->createCallBacks.version = 0;
+    parseContext->createCallBacks.opaque  = parseContext;
+    parseContext->createCallBacks.create  = &Create;
+    parseContext->createCallBacks.error   = &Error;
+
+    parseContext->data                    = data;
+    parseContext->size                    = size;
+    parseContext->offset                  = 0;
+
+    parseContext->handler                 = handler;
+    parseContext->arrayPlaceholder        = (handler != nullptr ? Array::New() : nullptr);
+    parseContext->dictionaryPlaceholder   = (handler != nullptr ? Dictionary::New() : nullptr);
+    parseContext->stopped                 = false;
+
+    ::ABPReaderInit(&parseContext->context, &parseContext->streamCallBacks, &parseContext->createCallBacks);
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<Binary>::
-Deserialize(std::vector<uint8_t> const &contents, Binary const &format)
+std::pair<bool, std::string> Format<Binary>::
+Parse(uint8_t const *data, size_t size, Binary const &format, Handler *handler)
 {
     BinaryParseContext parseContext;
+    BinaryParseContextInit(&parseContext, data, size, handler);
 
-    parseContext.streamCallBacks.version = 0;
-    parseContext.streamCallBacks.opaque  = &parseContext;
-    parseContext.streamCallBacks.close   = nullptr;
-    parseContext.streamCallBacks.write   = nullptr;
-    parseContext.streamCallBacks.seek    = &ReadSeek;
-    parseContext.streamCallBacks.read    = &ReadData;
-
-    parseContext.createCallBacks.version = 0;
-    parseContext.createCallBacks.opaque  = &parseContext;
-    parseContext.createCallBacks.create  = &Create;
-    parseContext.createCallBacks.error   = &Error;
+    bool success = false;
+    if (::ABPReaderOpen(&parseContext.context)) {
+        uint64_t reference = parseContext.context.trailer.topLevelObject;
+        Object *topObject = ::ABPReadTopLevelObject(&parseContext.context);
+        if (topObject != nullptr) {
+            success = Emit(&parseContext, reference, topObject);
+        }
+        ::ABPReaderClose(&parseContext.context);
+    }
 
-    parseContext.contents                = &contents;
-    parseContext.offset                  = 0;
+    return std::make_pair(success, parseContext.error);
+}
 
-    ::ABPReaderInit(&parseContext.context, &parseContext.streamCallBacks, &parseContext.createCallBacks);
+template<>
+std::pair<std::unique_ptr<Object>, std::string> Format<Binary>::
+Deserialize(uint8_t const *data, size_t size, Binary const &format)
+{
+    BinaryParseContext parseContext;
+    BinaryParseContextInit(&parseContext, data, size, nullptr);
 
     std::unique_ptr<Object> object = nullptr;
     if (::ABPReaderOpen(&parseContext.context)) {
+        uint64_t reference = parseContext.context.trailer.topLevelObject;
         Object *topObject = ::ABPReadTopLevelObject(&parseContext.context);
         if (topObject != nullptr) {
-            object = topObject->copy();
+            object = std::unique_ptr<Object>(Take(&parseContext, reference, topObject));
         }
         ::ABPReaderClose(&parseContext.context);
     }
@@ -371,9 +476,9 @@ WriteData(void *opaque, void const *buffer, size_t size)
 {
     auto self = reinterpret_cast <BinaryWriteContext *> (opaque);
 
-    ssize_t needed = (self->contents.size() - self->offset + size);
-    if (needed > 0) {
-        self->contents.resize(self->contents.size() + needed);
+    size_t end = self->offset + size;
+    if (end > self->contents.size()) {
+        self->contents.resize(end);
     }
 
     /* Copy into read buffer. */
@@ -383,6 +488,13 @@ WriteData(void *opaque, void const *buffer, size_t size)
     return size;
 }
 
+static void
+WriteReserve(void *opaque, size_t size)
+{
+    auto self = reinterpret_cast <BinaryWriteContext *> (opaque);
+    self->contents.reserve(size);
+}
+
 bool Process(void *opaque, plist::Object const **object)
 {
     return true;
@@ -400,6 +512,7 @@ Serialize(Object const *object, Binary const &format)
     writeContext.streamCallBacks.seek    = &WriteSeek;
     writeContext.streamCallBacks.close   = nullptr;
     writeContext.streamCallBacks.read    = nullptr;
+    writeContext.streamCallBacks.reserve = &WriteReserve;
 
     writeContext.processCallBacks.version = 0;
     writeContext.processCallBacks.opaque = nullptr;
@@ -431,7 +544,7 @@ Serialize(Object const *object, Binary const &format)
         return std::make_pair(nullptr, "close failed");
     }
 
-    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(writeContext.contents.begin(), writeContext.contents.end())), std::string());
+    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(std::move(writeContext.contents))), std::string());
 }
 
 } }
@@ -0,0 +1,106 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/BinaryView.h>
+#include <plist/Format/BinaryParseContext.h>
+#include <plist/String.h>
+
+using plist::Format::BinaryView;
+using plist::Format::BinaryParseContext;
+using plist::Object;
+using plist::String;
+using plist::CastTo;
+
+BinaryView::
+BinaryView(std::vector<uint8_t> &&contents) :
+    _contents(std::move(contents)),
+    _context (new BinaryParseContext())
+{
+}
+
+BinaryView::
+~BinaryView()
+{
+    ::ABPReaderClose(&_context->context);
+}
+
+uint64_t BinaryView::
+count() const
+{
+    return _context->context.trailer.objectsCount;
+}
+
+std::string const &BinaryView::
+error() const
+{
+    return _context->error;
+}
+
+Object const *BinaryView::
+root()
+{
+    return ::ABPReadTopLevelObject(&_context->context);
+}
+
+Object const *BinaryView::
+value(std::string const &key)
+{
+    auto it = _values.find(key);
+    if (it == _values.end()) {
+        return nullptr;
+    }
+
+    return object(it->second);
+}
+
+Object const *BinaryView::
+object(uint64_t reference)
+{
+    return ::ABPReadObject(&_context->context, reference);
+}
+
+std::pair<std::unique_ptr<BinaryView>, std::string> BinaryView::
+Create(std::vector<uint8_t> contents)
+{
+    std::unique_ptr<BinaryView> view = std::unique_ptr<BinaryView>(new BinaryView(std::move(contents)));
+
+    BinaryParseContext *parseContext = view->_context.get();
+    BinaryParseContextInit(parseContext, view->_contents.data(), view->_contents.size(), nullptr);
+
+    if (!::ABPReaderOpen(&parseContext->context)) {
+        return std::make_pair(nullptr, parseContext->error);
+    }
+
+    /* Index the top level dictionary's keys, but not its values. */
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> values;
+    if (::ABPReadDictionaryReferences(&parseContext->context, parseContext->context.trailer.topLevelObject, &keys, &values)) {
+        view->_keys.reserve(keys.size());
+        view->_values.reserve(keys.size());
+
+        for (size_t n = 0; n < keys.size(); n++) {
+            String const *key = CastTo<String>(view->object(keys[n]));
+            if (key == nullptr) {
+                return std::make_pair(nullptr, "dictionary key is not a string");
+            }
+
+            /* As when deserializing, a repeated key uses the last value. */
+            auto result = view->_values.insert({ key->value(), values[n] });
+            if (result.second) {
+                view->_keys.push_back(key->value());
+            } else {
+                result.first->second = values[n];
+            }
+        }
+    } else if (!parseContext->error.empty()) {
+        return std::make_pair(nullptr, parseContext->error);
+    }
+
+    return std::make_pair(std::move(view), std::string());
+}
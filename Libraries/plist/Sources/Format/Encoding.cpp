@@ -11,6 +11,7 @@
 #include <plist/Format/unicode.h>
 
 #include <cassert>
+#include <cstring>
 
 #if !defined(__APPLE__)
 #include <endian.h>
@@ -20,19 +21,15 @@ using plist::Format::Encoding;
 using plist::Format::Encodings;
 
 Encoding Encodings::
-Detect(std::vector<uint8_t> const &contents)
+Detect(uint8_t const *data, size_t size)
 {
     /*
      * Check for a UTF-32 BOM. First as bytes overlap with UTF-16 LE.
      */
-    if (contents.size() >= 4) {
-        std::vector<uint8_t> UTF32BE_BOM = Encodings::BOM(Encoding::UTF32BE);
-        if (std::equal(UTF32BE_BOM.begin(), UTF32BE_BOM.end(), contents.begin())) {
+    if (size >= 4) {
+        if (data[0] == 0x00 && data[1] == 0x00 && data[2] == 0xFE && data[3] == 0xFF) {
             return Encoding::UTF32BE;
-        }
-
-        std::vector<uint8_t> UTF32LE_BOM = Encodings::BOM(Encoding::UTF32LE);
-        if (std::equal(UTF32LE_BOM.begin(), UTF32LE_BOM.end(), contents.begin())) {
+        } else if (data[0] == 0xFF && data[1] == 0xFE && data[2] == 0x00 && data[3] == 0x00) {
             return Encoding::UTF32LE;
         }
     }
@@ -40,14 +37,10 @@ Detect(std::vector<uint8_t> const &contents)
     /*
      * Check for a UTF-16 BOM.
      */
-    if (contents.size() >= 2) {
-        std::vector<uint8_t> UTF16BE_BOM = Encodings::BOM(Encoding::UTF16BE);
-        if (std::equal(UTF16BE_BOM.begin(), UTF16BE_BOM.end(), contents.begin())) {
+    if (size >= 2) {
+        if (data[0] == 0xFE && data[1] == 0xFF) {
             return Encoding::UTF16BE;
-        }
-
-        std::vector<uint8_t> UTF16LE_BOM = Encodings::BOM(Encoding::UTF16LE);
-        if (std::equal(UTF16LE_BOM.begin(), UTF16LE_BOM.end(), contents.begin())) {
+        } else if (data[0] == 0xFF && data[1] == 0xFE) {
             return Encoding::UTF16LE;
         }
     }
@@ -132,17 +125,198 @@ EndianSwapBuffer(std::vector<uint8_t> *buffer, Endian src, Endian dest)
     }
 }
 
-std::vector<uint8_t> Encodings::
-Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to)
+/*
+ * Converting between UTF-8 and UTF-16 is by far the most common conversion,
+ * so it is done directly rather than through the generic conversions. Runs
+ * of ASCII, which most strings files are mostly made of, are converted eight
+ * bytes at a time. Invalid sequences are skipped, as in the generic path.
+ */
+
+static uint64_t
+LoadWord(uint8_t const *data)
 {
-    std::vector<uint8_t> input = contents;
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+static std::vector<uint8_t>
+UTF8ToUTF16(uint8_t const *data, size_t size, Endian endian)
+{
+    /* Each byte of UTF-8 is at most one UTF-16 code unit. */
+    std::vector<uint8_t> result = std::vector<uint8_t>(size * sizeof(uint16_t));
+    uint8_t *out = result.data();
+
+    size_t low = (endian == Endian::Little ? 0 : 1);
+    size_t high = 1 - low;
+    auto write = [&out, low, high](uint16_t unit) {
+        out[low] = static_cast<uint8_t>(unit & 0xFF);
+        out[high] = static_cast<uint8_t>(unit >> 8);
+        out += sizeof(uint16_t);
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        /* Fast path: eight ASCII bytes. */
+        if (i + sizeof(uint64_t) <= size && (LoadWord(data + i) & UINT64_C(0x8080808080808080)) == 0) {
+            for (size_t n = 0; n < sizeof(uint64_t); n++) {
+                out[n * 2 + low] = data[i + n];
+                out[n * 2 + high] = 0;
+            }
+            out += sizeof(uint64_t) * sizeof(uint16_t);
+            i += sizeof(uint64_t);
+            continue;
+        }
 
-    /* Remove any BOM at the start. */
+        uint8_t lead = data[i];
+        if (lead < 0x80) {
+            write(lead);
+            i += 1;
+            continue;
+        }
+
+        /* Determine the sequence length and the minimum valid code point. */
+        size_t length;
+        uint32_t code;
+        uint32_t minimum;
+        if (lead >= 0xC2 && lead < 0xE0) {
+            length = 2;
+            code = lead & 0x1F;
+            minimum = 0x80;
+        } else if (lead >= 0xE0 && lead < 0xF0) {
+            length = 3;
+            code = lead & 0x0F;
+            minimum = 0x800;
+        } else if (lead >= 0xF0 && lead < 0xF5) {
+            length = 4;
+            code = lead & 0x07;
+            minimum = 0x10000;
+        } else {
+            /* Continuation byte without a lead byte, or an invalid lead byte. */
+            i += 1;
+            continue;
+        }
+
+        bool valid = (i + length <= size);
+        for (size_t n = 1; valid && n < length; n++) {
+            if ((data[i + n] & 0xC0) != 0x80) {
+                valid = false;
+            } else {
+                code = (code << 6) | (data[i + n] & 0x3F);
+            }
+        }
+        if (!valid) {
+            /* Skip the lead byte; the rest is reconsidered on its own. */
+            i += 1;
+            continue;
+        }
+        i += length;
+
+        if (code < minimum || code > 0x10FFFF || (code >= 0xD800 && code < 0xE000)) {
+            /* Overlong encoding, out of range, or an encoded surrogate. */
+            continue;
+        }
+
+        if (code >= 0x10000) {
+            write(static_cast<uint16_t>(0xD800 | ((code - 0x10000) >> 10)));
+            write(static_cast<uint16_t>(0xDC00 | ((code - 0x10000) & 0x3FF)));
+        } else {
+            write(static_cast<uint16_t>(code));
+        }
+    }
+
+    result.resize(out - result.data());
+    return result;
+}
+
+static std::vector<uint8_t>
+UTF16ToUTF8(uint8_t const *data, size_t size, Endian endian)
+{
+    size_t count = size / sizeof(uint16_t);
+
+    /* Each code unit is at most three bytes; surrogate pairs are four bytes for two. */
+    std::vector<uint8_t> result = std::vector<uint8_t>(count * 3);
+    uint8_t *out = result.data();
+
+    size_t low = (endian == Endian::Little ? 0 : 1);
+    size_t high = 1 - low;
+    auto read = [data, low, high](size_t index) -> uint16_t {
+        return static_cast<uint16_t>(data[index * 2 + low] | (data[index * 2 + high] << 8));
+    };
+
+    /* In memory, an ASCII code unit has a zero high byte and a low byte under 0x80. */
+    uint8_t maskBytes[sizeof(uint64_t)];
+    for (size_t n = 0; n < sizeof(uint64_t); n += sizeof(uint16_t)) {
+        maskBytes[n + low] = 0x80;
+        maskBytes[n + high] = 0xFF;
+    }
+    uint64_t mask = LoadWord(maskBytes);
+
+    size_t i = 0;
+    while (i < count) {
+        /* Fast path: four ASCII code units. */
+        if (i + 4 <= count && (LoadWord(data + i * 2) & mask) == 0) {
+            for (size_t n = 0; n < 4; n++) {
+                out[n] = data[(i + n) * 2 + low];
+            }
+            out += 4;
+            i += 4;
+            continue;
+        }
+
+        uint16_t unit = read(i);
+        i += 1;
+
+        if (unit < 0x80) {
+            *out++ = static_cast<uint8_t>(unit);
+        } else if (unit < 0x800) {
+            *out++ = static_cast<uint8_t>(0xC0 | (unit >> 6));
+            *out++ = static_cast<uint8_t>(0x80 | (unit & 0x3F));
+        } else if ((unit & 0xFC00) == 0xD800) {
+            if (i == count || (read(i) & 0xFC00) != 0xDC00) {
+                /* No second surrogate present. */
+                continue;
+            }
+
+            uint32_t code = (((unit & 0x3FF) << 10) | (read(i) & 0x3FF)) + 0x10000;
+            i += 1;
+
+            *out++ = static_cast<uint8_t>(0xF0 | (code >> 18));
+            *out++ = static_cast<uint8_t>(0x80 | ((code >> 12) & 0x3F));
+            *out++ = static_cast<uint8_t>(0x80 | ((code >> 6) & 0x3F));
+            *out++ = static_cast<uint8_t>(0x80 | (code & 0x3F));
+        } else if ((unit & 0xFC00) == 0xDC00) {
+            /* Second surrogate without a preceding first surrogate. */
+            continue;
+        } else {
+            *out++ = static_cast<uint8_t>(0xE0 | (unit >> 12));
+            *out++ = static_cast<uint8_t>(0x80 | ((unit >> 6) & 0x3F));
+            *out++ = static_cast<uint8_t>(0x80 | (unit & 0x3F));
+        }
+    }
+
+    result.resize(out - result.data());
+    return result;
+}
+
+std::vector<uint8_t> Encodings::
+Convert(uint8_t const *data, size_t size, Encoding from, Encoding to)
+{
+    /* Skip any BOM at the start. */
     std::vector<uint8_t> BOM = Encodings::BOM(from);
-    if (input.size() >= BOM.size() && std::equal(BOM.begin(), BOM.end(), contents.begin())) {
-        input.erase(input.begin(), input.begin() + BOM.size());
+    if (size >= BOM.size() && std::equal(BOM.begin(), BOM.end(), data)) {
+        data += BOM.size();
+        size -= BOM.size();
     }
 
+    if (from == Encoding::UTF8 && (to == Encoding::UTF16LE || to == Encoding::UTF16BE)) {
+        return UTF8ToUTF16(data, size, EncodingEndian(to));
+    } else if ((from == Encoding::UTF16LE || from == Encoding::UTF16BE) && to == Encoding::UTF8) {
+        return UTF16ToUTF8(data, size, EncodingEndian(from));
+    }
+
+    std::vector<uint8_t> input = std::vector<uint8_t>(data, data + size);
+
     /* No conversion needed, just byte swap if necessary. */
     if (from == to) {
         return input;
@@ -195,7 +369,7 @@ Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to)
         std::vector<uint8_t> result;
 
         if (to == Encoding::UTF16LE || to == Encoding::UTF16BE) {
-            result.resize(contents.size() * sizeof(uint16_t) * 3);
+            result.resize(size * sizeof(uint16_t) * 3);
             size_t length = ::utf8_to_utf16(
                 reinterpret_cast<uint16_t *>(result.data()), result.size() / sizeof(uint16_t),
                 reinterpret_cast<char *>(intermediate.data()), intermediate.size() / sizeof(char),
@@ -10,12 +10,15 @@
 #include <plist/Format/JSON.h>
 #include <plist/Format/JSONParser.h>
 #include <plist/Format/JSONWriter.h>
+#include <plist/Format/ObjectBuilder.h>
 
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Handler;
 using plist::Format::JSON;
 using plist::Format::JSONParser;
 using plist::Format::JSONWriter;
+using plist::Format::ObjectBuilder;
 using plist::Object;
 
 JSON::
@@ -27,32 +30,38 @@ namespace plist { namespace Format {
 
 template<>
 std::unique_ptr<JSON> Format<JSON>::
-Identify(std::vector<uint8_t> const &contents)
+Identify(uint8_t const *data, size_t size)
 {
     /* JSON is not a standard format. */
     return nullptr;
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<JSON>::
-Deserialize(std::vector<uint8_t> const &contents, JSON const &format)
+std::pair<bool, std::string> Format<JSON>::
+Parse(uint8_t const *data, size_t size, JSON const &format, Handler *handler)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
-
     /* Create lexer. */
     ASCIIPListLexer lexer;
-    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(contents.data()), contents.size(), kASCIIPListLexerStyleJSON);
+    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data), size, kASCIIPListLexerStyleJSON);
 
     /* Parse contents. */
-    JSONParser parser;
-    if (parser.parse(&lexer)) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    JSONParser parser(handler);
+    bool success = parser.parse(&lexer);
+    return std::make_pair(success, parser.error());
+}
+
+template<>
+std::pair<std::unique_ptr<Object>, std::string> Format<JSON>::
+Deserialize(uint8_t const *data, size_t size, JSON const &format)
+{
+    ObjectBuilder builder;
+
+    std::pair<bool, std::string> result = Parse(data, size, format, &builder);
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(std::move(builder.root()), std::string());
 }
 
 template<>
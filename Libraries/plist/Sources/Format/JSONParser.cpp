@@ -28,12 +28,11 @@ using plist::Dictionary;
 #endif
 
 JSONParser::
-JSONParser() :
-    _root(nullptr),
+JSONParser(Handler *handler) :
+    _handler(handler),
+    _root(false),
     _level(0),
     _state(ValueState::Init),
-    _container(nullptr),
-    _key(nullptr),
     _contextState(ContextState::Parsing)
 {
 }
@@ -46,7 +45,7 @@ JSONParser::
 bool JSONParser::
 isAborted() const
 {
-    return _contextState == ContextState::Aborted;
+    return _contextState == ContextState::Aborted || _contextState == ContextState::Stopped;
 }
 
 bool JSONParser::
@@ -84,8 +83,16 @@ abort(std::string const &error)
     _contextState = ContextState::Aborted;
 }
 
+void JSONParser::
+stop()
+{
+    /* The handler asked to stop; this is not an error. */
+    _error.clear();
+    _contextState = ContextState::Stopped;
+}
+
 bool JSONParser::
-push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key)
+push(ValueState state)
 {
     if (isAborted()) {
         return false;
@@ -94,25 +101,10 @@ push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr
     /* If valid state, push, otherwise just set the new state. */
     if (_state != ValueState::Init) {
         /* Push the old state */
-        _containerStack.push(std::move(_container));
-        _keyStack.push(std::move(_key));
-        _stateStack.push(_state);
+        _stateStack.push_back(_state);
     }
 
     _state = state;
-
-    if (container != nullptr) {
-        _container = std::move(container);
-    } else {
-        _container = nullptr;
-    }
-
-    if (key != nullptr) {
-        _key = std::move(key);
-    } else {
-        _key = nullptr;
-    }
-
     return true;
 }
 
@@ -126,87 +118,69 @@ pop()
             return false; /* Underflow! */
 
         /* Reset current state. */
-        _container = nullptr;
-        _key = nullptr;
-
         _state = ValueState::Init;
         return true;
     }
 
     /* Pop state */
-    _state = std::move(_stateStack.top());
-    _stateStack.pop();
-
-    _container = std::move(_containerStack.top());
-    _containerStack.pop();
-
-    _key = std::move(_keyStack.top());
-    _keyStack.pop();
+    _state = _stateStack.back();
+    _stateStack.pop_back();
 
     return true;
 }
 
 /*
- * Generic container handling.
+ * Check a value can be stored in the current state.
  */
 bool JSONParser::
-beginContainer(std::unique_ptr<plist::Object> object)
+beginValue()
 {
-    ValueState state;
-
-    if (object->type() == Array::Type()) {
-        state = ValueState::Array;
-    } else {
-        state = ValueState::Dictionary;
-    }
-
-    if (!push(state, std::move(object), nullptr)) {
-        abort("Cannot push the current state.");
+    if (_state == ValueState::Init) {
+        if (_root) {
+            abort("Double root.");
+            return false;
+        }
+    } else if (_state == ValueState::Dictionary) {
+        abort("Storing value with no dictionary key.");
         return false;
     }
 
     return true;
 }
 
+/*
+ * Update the state after a value is stored.
+ */
 bool JSONParser::
-storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value)
+endValue()
 {
-    if (_container == nullptr) {
-        if (_key != nullptr) {
-            abort("Storing key/value pair with no container.");
-            return false;
-        }
-
-        /* Make current value the root. */
-        if (_root != nullptr) {
-            abort("Double root.");
-            return false;
-        }
-
-        _root = std::move(value);
-        return true;
+    if (_state == ValueState::Init) {
+        _root = true;
+    } else if (_state == ValueState::DictionaryValue) {
+        _state = ValueState::Dictionary;
     }
 
-    if (key != nullptr) {
-        if (_container->type() != Dictionary::Type()) {
-            abort("Storing key/value with no dictionary container.");
-            return false;
-        }
-
-        plist::Dictionary *dict = static_cast<plist::Dictionary *>(_container.get());
-        dict->set(key->value(), std::move(value));
+    return true;
+}
 
-        _state = ValueState::Dictionary;
-    } else {
-        if (_container->type() != Array::Type()) {
-            abort("Storing value with no array container.");
-            return false;
-        }
+/*
+ * Generic container handling.
+ */
+bool JSONParser::
+beginContainer(bool isArray)
+{
+    if (!beginValue()) {
+        return false;
+    }
 
-        plist::Array *array = static_cast<plist::Array *>(_container.get());
-        array->append(std::move(value));
+    if (!(isArray ? _handler->beginArray() : _handler->beginDictionary())) {
+        stop();
+        return false;
+    }
 
-        _state = ValueState::Array;
+    if (!push(isArray ? ValueState::Array : ValueState::Dictionary)) {
+        abort("Cannot push the current state.");
+        return false;
     }
 
     return true;
@@ -215,30 +189,14 @@ storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object>
 bool JSONParser::
 endContainer(bool isArray)
 {
-    std::unique_ptr<plist::String> key;
-    std::unique_ptr<plist::Object> value;
-    bool success;
-
     /* Check state is consistant. */
     if (_state != (isArray ? ValueState::Array : ValueState::Dictionary)) {
         abort("Closing array/dictionary in wrong state.");
         return false;
     }
 
-    if (_container == nullptr) {
-        abort("Closing non-opened container.");
-        return false;
-    }
-
-    value = std::move(_container);
-    if (value == nullptr) {
-        abort("Couldn't copy container.");
-        return false;
-    }
-
-    /* Is this the right type of container? */
-    if (value->type() != (isArray ? Array::Type() : Dictionary::Type())) {
-        abort("Closing wrong kind of container.");
+    if (!(isArray ? _handler->endArray() : _handler->endDictionary())) {
+        stop();
         return false;
     }
 
@@ -247,26 +205,13 @@ endContainer(bool isArray)
         return false;
     }
 
-    /* Take ownership of the saved key. */
-    key = std::move(_key);
-    _key = nullptr;
-
-    success = storeKeyValue(std::move(key), std::move(value));
-
-    return success;
+    return endValue();
 }
 
 bool JSONParser::
 beginArray()
 {
-    std::unique_ptr<plist::Array> array = Array::New();
-    if (array == nullptr) {
-        abort("Cannot create an array.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(array));
-    return success;
+    return beginContainer(true);
 }
 
 bool JSONParser::
@@ -278,14 +223,7 @@ endArray()
 bool JSONParser::
 beginDictionary()
 {
-    std::unique_ptr<plist::Dictionary> dict = Dictionary::New();
-    if (dict == nullptr) {
-        abort("Cannot create a dictionary.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(dict));
-    return success;
+    return beginContainer(false);
 }
 
 bool JSONParser::
@@ -298,23 +236,17 @@ endDictionary()
  * Store the key of the current dictionary.
  */
 bool JSONParser::
-storeKey(std::unique_ptr<plist::String> key)
+storeKey(std::string const &key)
 {
-    if (key == nullptr) {
-        key = String::New();
-
-        if (key == nullptr) {
-            abort("Cannot create empty key.");
-            return false;
-        }
-    }
-
     if (_state != ValueState::Dictionary) {
         abort("Storing key in wrong state.");
         return false;
     }
 
-    _key = std::move(key);
+    if (!_handler->key(key)) {
+        stop();
+        return false;
+    }
 
     _state = ValueState::DictionaryValue;
     return true;
@@ -323,16 +255,16 @@ storeKey(std::unique_ptr<plist::String> key)
 bool JSONParser::
 storeValue(std::unique_ptr<plist::Object> value)
 {
-    bool success;
-
-    success = storeKeyValue(std::move(_key), std::move(value));
-    _key = nullptr;
+    if (!beginValue()) {
+        return false;
+    }
 
-    if (_state == ValueState::DictionaryValue) {
-        _state = ValueState::Dictionary;
+    if (!_handler->value(std::move(value))) {
+        stop();
+        return false;
     }
 
-    return success;
+    return endValue();
 }
 
 bool JSONParser::
@@ -477,11 +409,12 @@ parse(ASCIIPListLexer *lexer)
                             return false;
                         }
 
+                        /* Numbers have no escapes to remove. */
+                        _token.assign(lexer->inputBuffer + lexer->tokenBegin, lexer->tokenLength);
+
                         char *end = NULL;
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        long long value = ::strtoll(contents, &end, 0);
-                        bool success = (end != contents);
-                        free(contents);
+                        long long value = ::strtoll(_token.c_str(), &end, 0);
+                        bool success = (end != _token.c_str());
 
                         if (success) {
                             std::unique_ptr<Integer> integer = Integer::New(value);
@@ -500,11 +433,11 @@ parse(ASCIIPListLexer *lexer)
                             return false;
                         }
 
+                        _token.assign(lexer->inputBuffer + lexer->tokenBegin, lexer->tokenLength);
+
                         char *end = NULL;
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        double value = ::strtod(contents, &end);
-                        bool success = (end != contents);
-                        free(contents);
+                        double value = ::strtod(_token.c_str(), &end);
+                        bool success = (end != _token.c_str());
 
                         if (success) {
                             std::unique_ptr<Real> real = Real::New(value);
@@ -518,24 +451,26 @@ parse(ASCIIPListLexer *lexer)
                             return false;
                         }
                     } else if (token == kASCIIPListLexerTokenQuotedString) {
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        std::unique_ptr<String> string = String::New(std::string(contents));
-                        free(contents);
-
-                        if (string == NULL) {
-                            abort("OOM when copying string");
-                            return false;
-                        }
-
-                        /* Container context */
+                        /* Keys are only passed to the handler, so reuse one string for them. */
                         if (isDictionary) {
-                            JSONDebug("Storing string %s as key", string->value().c_str());
-                            if (!storeKey(std::move(string))) {
+                            if (!ASCIIPListCopyUnquotedString(lexer, '?', &_token)) {
+                                abort("OOM when copying string");
+                                return false;
+                            }
+
+                            JSONDebug("Storing string %s as key", _token.c_str());
+                            if (!storeKey(_token)) {
                                 return false;
                             }
                         } else {
-                            JSONDebug("Storing string %s", string->value().c_str());
-                            if (!storeValue(std::move(string))) {
+                            std::string contents;
+                            if (!ASCIIPListCopyUnquotedString(lexer, '?', &contents)) {
+                                abort("OOM when copying string");
+                                return false;
+                            }
+
+                            JSONDebug("Storing string %s", contents.c_str());
+                            if (!storeValue(String::New(std::move(contents)))) {
                                 return false;
                             }
                         }
@@ -0,0 +1,114 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/ObjectBuilder.h>
+#include <plist/Objects.h>
+
+using plist::Format::ObjectBuilder;
+using plist::Object;
+using plist::ObjectType;
+using plist::Array;
+using plist::Dictionary;
+using plist::Integer;
+using plist::UID;
+
+ObjectBuilder::
+ObjectBuilder(bool convertUIDs) :
+    _root       (nullptr),
+    _convertUIDs(convertUIDs)
+{
+}
+
+ObjectBuilder::
+~ObjectBuilder()
+{
+}
+
+bool ObjectBuilder::
+beginDictionary()
+{
+    _containers.push_back({ Dictionary::New(), std::string() });
+    return true;
+}
+
+bool ObjectBuilder::
+endDictionary()
+{
+    return end(Dictionary::Type());
+}
+
+bool ObjectBuilder::
+beginArray()
+{
+    _containers.push_back({ Array::New(), std::string() });
+    return true;
+}
+
+bool ObjectBuilder::
+endArray()
+{
+    return end(Array::Type());
+}
+
+bool ObjectBuilder::
+key(std::string const &key)
+{
+    if (_containers.empty() || _containers.back().object->type() != Dictionary::Type()) {
+        return false;
+    }
+
+    _containers.back().key = key;
+    return true;
+}
+
+bool ObjectBuilder::
+value(std::unique_ptr<Object> value)
+{
+    if (_containers.empty()) {
+        if (_root != nullptr) {
+            return false;
+        }
+
+        _root = std::move(value);
+        return true;
+    }
+
+    Container *container = &_containers.back();
+    if (Array *array = CastTo<Array>(container->object.get())) {
+        array->append(std::move(value));
+    } else if (Dictionary *dict = CastTo<Dictionary>(container->object.get())) {
+        dict->set(std::move(container->key), std::move(value));
+        container->key.clear();
+    }
+
+    return true;
+}
+
+bool ObjectBuilder::
+end(ObjectType type)
+{
+    if (_containers.empty() || _containers.back().object->type() != type) {
+        return false;
+    }
+
+    std::unique_ptr<Object> object = std::move(_containers.back().object);
+    _containers.pop_back();
+
+    if (_convertUIDs) {
+        if (Dictionary const *dict = CastTo<Dictionary>(object.get())) {
+            if (dict->count() == 1 && dict->key(0) == "CF$UID") {
+                if (Integer const *integer = dict->value<Integer>(0)) {
+                    object = UID::New(integer->value());
+                }
+            }
+        }
+    }
+
+    return value(std::move(object));
+}
@@ -9,12 +9,17 @@
 
 #include <plist/Format/SimpleXML.h>
 #include <plist/Format/SimpleXMLParser.h>
+#include <plist/Objects.h>
 
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Handler;
 using plist::Format::SimpleXML;
 using plist::Format::SimpleXMLParser;
 using plist::Object;
+using plist::Array;
+using plist::Dictionary;
+using plist::CastTo;
 
 SimpleXML::
 SimpleXML(Encoding encoding) :
@@ -26,7 +31,7 @@ namespace plist { namespace Format {
 
 template<>
 std::unique_ptr<SimpleXML> Format<SimpleXML>::
-Identify(std::vector<uint8_t> const &contents)
+Identify(uint8_t const *data, size_t size)
 {
     /*
      * To identify XML document, we look for a <? or <!, ignoring
@@ -35,7 +40,7 @@ Identify(std::vector<uint8_t> const &contents)
 
     uint8_t last = '\0';
 
-    for (auto bp = contents.begin(); bp != contents.end();) {
+    for (uint8_t const *bp = data; bp != data + size;) {
         /* Conceal zeroes for UTF-16/32 encodings. */
         if (*bp == 0 || isspace(*bp)) {
             bp++;
@@ -46,9 +51,9 @@ Identify(std::vector<uint8_t> const &contents)
                 /* Found <? or <! */
             }
 
-            Encoding encoding = Encodings::Detect(contents);
+            Encoding encoding = Encodings::Detect(data, size);
             return std::unique_ptr<SimpleXML>(new SimpleXML(SimpleXML::Create(encoding)));
-        } else if (bp - contents.begin() < 4) {
+        } else if (bp - data < 4) {
             /*
              * We conceal some BOM chars for UTF encodings in the first
              * four bytes.
@@ -74,12 +79,12 @@ Identify(std::vector<uint8_t> const &contents)
 
 template<>
 std::pair<std::unique_ptr<Object>, std::string> Format<SimpleXML>::
-Deserialize(std::vector<uint8_t> const &contents, SimpleXML const &format)
+Deserialize(uint8_t const *data, size_t size, SimpleXML const &format)
 {
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+    std::vector<uint8_t> const converted = Encodings::Convert(data, size, format.encoding(), Encoding::UTF8);
 
     SimpleXMLParser parser;
-    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data));
+    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(converted));
     if (root == nullptr) {
         return std::make_pair(nullptr, parser.error());
     }
@@ -87,6 +92,55 @@ Deserialize(std::vector<uint8_t> const &contents, SimpleXML const &format)
     return std::make_pair(std::move(root), std::string());
 }
 
+static bool
+Emit(Handler *handler, Object const *object)
+{
+    if (Dictionary const *dictionary = CastTo<Dictionary>(object)) {
+        if (!handler->beginDictionary()) {
+            return false;
+        }
+
+        for (size_t n = 0; n < dictionary->count(); n++) {
+            if (!handler->key(dictionary->key(n)) || !Emit(handler, dictionary->value(n))) {
+                return false;
+            }
+        }
+
+        return handler->endDictionary();
+    } else if (Array const *array = CastTo<Array>(object)) {
+        if (!handler->beginArray()) {
+            return false;
+        }
+
+        for (size_t n = 0; n < array->count(); n++) {
+            if (!Emit(handler, array->value(n))) {
+                return false;
+            }
+        }
+
+        return handler->endArray();
+    } else {
+        return handler->value(object->copy());
+    }
+}
+
+template<>
+std::pair<bool, std::string> Format<SimpleXML>::
+Parse(uint8_t const *data, size_t size, SimpleXML const &format, Handler *handler)
+{
+    /*
+     * Repeated elements are combined into an array, so an element can't be
+     * passed on until the rest of its parent has been read. Read the whole
+     * document first, then pass its contents to the handler.
+     */
+    std::pair<std::unique_ptr<Object>, std::string> result = Deserialize(data, size, format);
+    if (result.first == nullptr) {
+        return std::make_pair(false, result.second);
+    }
+
+    return std::make_pair(Emit(handler, result.first.get()), std::string());
+}
+
 template<>
 std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> Format<SimpleXML>::
 Serialize(Object const *object, SimpleXML const &format)
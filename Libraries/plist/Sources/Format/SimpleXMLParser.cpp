@@ -27,7 +27,7 @@ parse(std::vector<uint8_t> const &contents)
     if (_root != nullptr)
         return nullptr;
 
-    if (!BaseXMLParser::parse(contents))
+    if (!BaseXMLParser::parse(contents.data(), contents.size()))
         return nullptr;
 
     return _root;
@@ -10,10 +10,13 @@
 #include <plist/Format/XML.h>
 #include <plist/Format/XMLParser.h>
 #include <plist/Format/XMLWriter.h>
+#include <plist/Format/ObjectBuilder.h>
 
 using plist::Format::Type;
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Handler;
+using plist::Format::ObjectBuilder;
 using plist::Format::XML;
 using plist::Format::XMLParser;
 using plist::Format::XMLWriter;
@@ -35,7 +38,7 @@ namespace plist { namespace Format {
 
 template<>
 std::unique_ptr<XML> Format<XML>::
-Identify(std::vector<uint8_t> const &contents)
+Identify(uint8_t const *data, size_t size)
 {
     /*
      * To identify XML document, we look for a <? or <!, ignoring
@@ -44,7 +47,7 @@ Identify(std::vector<uint8_t> const &contents)
 
     uint8_t last = '\0';
 
-    for (auto bp = contents.begin(); bp != contents.end();) {
+    for (uint8_t const *bp = data; bp != data + size;) {
         /* Conceal zeroes for UTF-16/32 encodings. */
         if (*bp == 0 || isspace(*bp)) {
             bp++;
@@ -55,9 +58,9 @@ Identify(std::vector<uint8_t> const &contents)
                 /* Found <? or <! */
             }
 
-            Encoding encoding = Encodings::Detect(contents);
+            Encoding encoding = Encodings::Detect(data, size);
             return std::unique_ptr<XML>(new XML(XML::Create(encoding)));
-        } else if (bp - contents.begin() < 4) {
+        } else if (bp - data < 4) {
             /*
              * We conceal some BOM chars for UTF encodings in the first
              * four bytes.
@@ -81,19 +84,30 @@ Identify(std::vector<uint8_t> const &contents)
     return nullptr;
 }
 
+template<>
+std::pair<bool, std::string> Format<XML>::
+Parse(uint8_t const *data, size_t size, XML const &format, Handler *handler)
+{
+    std::vector<uint8_t> const converted = Encodings::Convert(data, size, format.encoding(), Encoding::UTF8);
+
+    XMLParser parser(handler);
+    bool success = parser.parse(converted.data(), converted.size());
+    return std::make_pair(success, parser.error());
+}
+
 template<>
 std::pair<std::unique_ptr<Object>, std::string> Format<XML>::
-Deserialize(std::vector<uint8_t> const &contents, XML const &format)
+Deserialize(uint8_t const *data, size_t size, XML const &format)
 {
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+    /* Convert CF$UID dictionaries into UID objects. */
+    ObjectBuilder builder(true);
 
-    XMLParser parser;
-    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data));
-    if (root == nullptr) {
-        return std::make_pair(nullptr, parser.error());
+    std::pair<bool, std::string> result = Parse(data, size, format, &builder);
+    if (!result.first || builder.root() == nullptr) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    return std::make_pair(std::move(root), std::string());
+    return std::make_pair(std::move(builder.root()), std::string());
 }
 
 template<>
@@ -12,31 +12,31 @@
 #include <plist/Objects.h>
 
 using plist::Format::XMLParser;
+using plist::Format::Handler;
 using plist::Object;
 
-XMLParser::XMLParser() :
+XMLParser::XMLParser(Handler *handler) :
     BaseXMLParser(),
-    _root        (nullptr)
+    _handler     (handler),
+    _root        (false),
+    _boolean     (false)
 {
 }
 
-Object *XMLParser::
-parse(std::vector<uint8_t> const &contents)
+bool XMLParser::
+parse(uint8_t const *data, size_t size)
 {
-    if (_root != nullptr)
-        return nullptr;
-
-    if (!BaseXMLParser::parse(contents))
-        return nullptr;
+    if (_root)
+        return false;
 
-    return _root;
+    return BaseXMLParser::parse(data, size);
 }
 
 void XMLParser::
 onBeginParse()
 {
-    _root             = nullptr;
-    _state.current    = nullptr;
+    _root             = false;
+    _state.element    = Element::None;
     _state.key.valid  = false;
     _state.key.active = false;
 }
@@ -44,22 +44,8 @@ onBeginParse()
 void XMLParser::
 onEndParse(bool success)
 {
-    if (!success) {
-        if (_state.current != nullptr && _state.current != _root) {
-            _state.current->release();
-        }
-        for (auto const &s : _stack) {
-            if (s.current != _state.current && s.current != _root) {
-                s.current->release();
-            }
-        }
-        _stack.clear();
-        if (_root != nullptr) {
-            _root->release();
-            _root = nullptr;
-        }
-    }
-    _state.current    = nullptr;
+    _stack.clear();
+    _state.element    = Element::None;
     _state.key.valid  = false;
     _state.key.active = false;
     _cdata.clear();
@@ -79,11 +65,15 @@ onStartElement(std::string const &name, std::unordered_map<std::string, std::str
     // If we have a root, and depth == 1 there's an extra
     // entry after the first element, bail out.
     //
-    if (depth == 1 && _root != nullptr) {
+    if (depth == 1 && _root) {
         error("unexpected element '%s' after root element", name.c_str());
         return;
     }
 
+    if (depth == 1) {
+        _root = true;
+    }
+
     if (!beginObject(name)) {
         return;
     }
@@ -121,13 +111,13 @@ inContainer() const
 inline bool XMLParser::
 inArray() const
 {
-    return (CastTo <Array> (_state.current) != nullptr);
+    return (_state.element == Element::Array);
 }
 
 inline bool XMLParser::
 inDictionary() const
 {
-    return (CastTo <Dictionary> (_state.current) != nullptr);
+    return (_state.element == Element::Dictionary);
 }
 
 inline bool XMLParser::
@@ -139,11 +129,11 @@ isExpectingKey() const
 inline bool XMLParser::
 isExpectingCDATA() const
 {
-    return (CastTo <Integer> (_state.current) != nullptr ||
-            CastTo <Real> (_state.current) != nullptr ||
-            CastTo <String> (_state.current) != nullptr ||
-            CastTo <Data> (_state.current) != nullptr ||
-            CastTo <Date> (_state.current) != nullptr ||
+    return (_state.element == Element::Integer ||
+            _state.element == Element::Real ||
+            _state.element == Element::String ||
+            _state.element == Element::Data ||
+            _state.element == Element::Date ||
             (inDictionary() && _state.key.active));
 }
 
@@ -232,50 +222,50 @@ endObject(std::string const &name)
 }
 
 void XMLParser::
-push(Object *object)
+push(Element element)
 {
-    if (_state.current != nullptr) {
-        _stack.push_back(_state);
-    }
-    _state.current    = object;
+    _stack.push_back(_state);
+    _state.element    = element;
     _state.key.valid  = false;
     _state.key.active = false;
-    if (_root == nullptr) {
-        _root = _state.current;
-    }
 }
 
 void XMLParser::
 pop()
 {
-    if (_stack.empty() && _state.current == nullptr) {
+    if (_stack.empty()) {
         error("stack underflow");
         return;
     }
 
-    if (_state.current != _root) {
-        State old = _state;
-        _state = _stack.back();
-        _stack.pop_back();
+    _state = _stack.back();
+    _stack.pop_back();
 
-        if (auto array = CastTo <Array> (_state.current)) {
-            array->append(std::unique_ptr<Object>(old.current));
-        } else if (auto dict = CastTo <Dictionary> (_state.current)) {
-            if (!isExpectingKey()) {
-                dict->set(_state.key.value, std::unique_ptr<Object>(old.current));
-                _state.key.valid  = false;
-                _state.key.active = false;
-            }
-        }
-    }
+    /* The key has been used by the value that just ended. */
+    _state.key.valid  = false;
+    _state.key.active = false;
 
     _cdata.clear();
 }
 
+bool XMLParser::
+emit(std::unique_ptr<Object> object)
+{
+    pop();
+
+    if (!_handler->value(std::move(object))) {
+        stop();
+    }
+    return true;
+}
+
 bool XMLParser::
 beginArray()
 {
-    push(Array::New().release());
+    push(Element::Array);
+    if (!_handler->beginArray()) {
+        stop();
+    }
     return true;
 }
 
@@ -283,44 +273,36 @@ bool XMLParser::
 endArray()
 {
     pop();
+    if (!_handler->endArray()) {
+        stop();
+    }
     return true;
 }
 
 bool XMLParser::
 beginDictionary()
 {
-    push(Dictionary::New().release());
-    _state.key.valid  = false;
-    _state.key.active = false;
+    push(Element::Dictionary);
+    if (!_handler->beginDictionary()) {
+        stop();
+    }
     return true;
 }
 
 bool XMLParser::
 endDictionary()
 {
-    if (auto dict = CastTo<Dictionary>(_state.current)) {
-        /* Convert CF$UID dictionaries into UID objects. */
-        if (dict->count() == 1) {
-            std::string const &key = dict->key(0);
-            Object const *value = dict->value(0);
-            if (key == "CF$UID" && value->type() == Integer::Type()) {
-                Integer const *integer = CastTo<Integer>(value);
-
-                uint32_t value = integer->value();
-                _state.current->release();
-                _state.current = UID::New(value).release();
-            }
-        }
-    }
-
     pop();
+    if (!_handler->endDictionary()) {
+        stop();
+    }
     return true;
 }
 
 bool XMLParser::
 beginString()
 {
-    push(String::New().release());
+    push(Element::String);
     _cdata.clear();
     return true;
 }
@@ -328,15 +310,13 @@ beginString()
 bool XMLParser::
 endString()
 {
-    CastTo <String> (_state.current)->setValue(_cdata);
-    pop();
-    return true;
+    return emit(String::New(std::move(_cdata)));
 }
 
 bool XMLParser::
 beginInteger()
 {
-    push(Integer::New().release());
+    push(Element::Integer);
     _cdata.clear();
     return true;
 }
@@ -347,9 +327,7 @@ endInteger()
     char *end = NULL;
     long long integer = ::strtoll(_cdata.c_str(), &end, 0);
     if (end != _cdata.c_str()) {
-        CastTo <Integer> (_state.current)->setValue(integer);
-        pop();
-        return true;
+        return emit(Integer::New(integer));
     } else {
         pop();
         return false;
@@ -359,7 +337,7 @@ endInteger()
 bool XMLParser::
 beginReal()
 {
-    push(Real::New().release());
+    push(Element::Real);
     _cdata.clear();
     return true;
 }
@@ -370,9 +348,7 @@ endReal()
     char *end = NULL;
     double real = ::strtod(_cdata.c_str(), &end);
     if (end != _cdata.c_str()) {
-        CastTo <Real> (_state.current)->setValue(real);
-        pop();
-        return true;
+        return emit(Real::New(real));
     } else {
         pop();
         return false;
@@ -382,35 +358,34 @@ endReal()
 bool XMLParser::
 beginNull()
 {
-    push(Null::New().release());
+    push(Element::Null);
     return true;
 }
 
 bool XMLParser::
 endNull()
 {
-    pop();
-    return true;
+    return emit(Null::New());
 }
 
 bool XMLParser::
 beginBoolean(bool value)
 {
-    push(Boolean::New(value).release());
+    push(Element::Boolean);
+    _boolean = value;
     return true;
 }
 
 bool XMLParser::
 endBoolean()
 {
-    pop();
-    return true;
+    return emit(Boolean::New(_boolean));
 }
 
 bool XMLParser::
 beginData()
 {
-    push(Data::New().release());
+    push(Element::Data);
     _cdata.clear();
     return true;
 }
@@ -418,15 +393,15 @@ beginData()
 bool XMLParser::
 endData()
 {
-    CastTo <Data> (_state.current)->setBase64Value(_cdata);
-    pop();
-    return true;
+    std::unique_ptr<Data> data = Data::New();
+    data->setBase64Value(_cdata);
+    return emit(std::move(data));
 }
 
 bool XMLParser::
 beginDate()
 {
-    push(Date::New().release());
+    push(Element::Date);
     _cdata.clear();
     return true;
 }
@@ -434,9 +409,7 @@ beginDate()
 bool XMLParser::
 endDate()
 {
-    CastTo <Date> (_state.current)->setStringValue(_cdata);
-    pop();
-    return true;
+    return emit(Date::New(_cdata));
 }
 
 bool XMLParser::
@@ -453,7 +426,9 @@ endKey()
 {
     _state.key.active = false;
     _state.key.valid = true;
-    _state.key.value = _cdata;
+    if (!_handler->key(_cdata)) {
+        stop();
+    }
     _cdata.clear();
     return true;
 }
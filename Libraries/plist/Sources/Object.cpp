@@ -8,8 +8,18 @@
  */
 
 #include <plist/Object.h>
+#include <libutil/Statistics.h>
 
 using plist::Object;
+using libutil::Statistics;
+
+static Statistics::Counter Objects("plist objects created");
+
+Object::
+Object()
+{
+    Objects.add();
+}
 
 std::unique_ptr<Object> Object::
 Coerce(Object const *obj)
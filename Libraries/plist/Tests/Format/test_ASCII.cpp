@@ -45,6 +45,33 @@ TEST(ASCII, QuotedString)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+TEST(ASCII, EscapedString)
+{
+    auto contents = Contents("{ a = \"one\\ntwo\"; \"b\\\\c\" = plain; }\n");
+
+    auto deserialize = ASCII::Deserialize(contents, ASCII::Create(false, Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+
+    auto dictionary = plist::CastTo<Dictionary>(deserialize.first.get());
+    ASSERT_NE(dictionary, nullptr);
+    ASSERT_NE(dictionary->value<String>("a"), nullptr);
+    EXPECT_EQ(dictionary->value<String>("a")->value(), "one\ntwo");
+    ASSERT_NE(dictionary->value<String>("b\\c"), nullptr);
+    EXPECT_EQ(dictionary->value<String>("b\\c")->value(), "plain");
+}
+
+TEST(ASCII, Unterminated)
+{
+    /* The input isn't terminated, so lexing must stop at its end. */
+    for (std::string const &string : { "\"abc", "'abc", "/* abc", "<0a0b", "{ a = \"long enough to be scanned in bulk" }) {
+        std::vector<uint8_t> contents = Contents(string);
+        contents.shrink_to_fit();
+
+        auto deserialize = ASCII::Deserialize(contents, ASCII::Create(false, Encoding::UTF8));
+        EXPECT_EQ(deserialize.first, nullptr);
+    }
+}
+
 TEST(ASCII, UnquotedString)
 {
     auto contents = Contents("string\n");
@@ -146,3 +173,21 @@ TEST(ASCII, CommentWithStarAndSlash)
     dictionary->set("key", String::New("value"));
     EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
 }
+
+TEST(ASCII, Pointer)
+{
+    /* Parses from a view, such as a mapped file, skipping the BOM. */
+    std::string contents = "\xef\xbb\xbf{ key = value; }\n";
+    uint8_t const *data = reinterpret_cast<uint8_t const *>(contents.data());
+
+    std::unique_ptr<ASCII> format = ASCII::Identify(data, contents.size());
+    ASSERT_NE(format, nullptr);
+    EXPECT_EQ(format->encoding(), Encoding::UTF8);
+
+    auto deserialize = ASCII::Deserialize(data, contents.size(), *format);
+    ASSERT_NE(deserialize.first, nullptr);
+
+    auto dictionary = Dictionary::New();
+    dictionary->set("key", String::New("value"));
+    EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
+}
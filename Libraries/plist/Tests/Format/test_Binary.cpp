@@ -9,10 +9,15 @@
 
 #include <gtest/gtest.h>
 #include <plist/Format/Binary.h>
+#include <plist/Format/BinaryView.h>
 #include <plist/Objects.h>
 
 using plist::Format::Binary;
+using plist::Format::BinaryView;
+using plist::Object;
 using plist::String;
+using plist::Integer;
+using plist::Array;
 using plist::Dictionary;
 
 TEST(Binary, UnicodeString)
@@ -42,3 +47,113 @@ TEST(Binary, UnicodeString)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+TEST(Binary, View)
+{
+    auto array = Array::New();
+    array->append(String::New("x"));
+
+    auto dict = Dictionary::New();
+    dict->set("a", String::New("one"));
+    dict->set("b", array->copy());
+    dict->set("c", Integer::New(3));
+
+    auto serialize = Binary::Serialize(dict.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    auto view = BinaryView::Create(*serialize.first);
+    ASSERT_NE(view.first, nullptr);
+    EXPECT_EQ(view.first->keys(), std::vector<std::string>({ "a", "b", "c" }));
+
+    /* Values are found by key, without reading the whole dictionary. */
+    String const *a = view.first->value<String>("a");
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(a->value(), "one");
+
+    Integer const *c = view.first->value<Integer>("c");
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(c->value(), 3);
+
+    Object const *b = view.first->value("b");
+    ASSERT_NE(b, nullptr);
+    EXPECT_TRUE(b->equals(array.get()));
+
+    EXPECT_EQ(view.first->value("d"), nullptr);
+    EXPECT_EQ(view.first->value<Integer>("a"), nullptr);
+
+    /* The whole contents are the same as when deserialized. */
+    Object const *root = view.first->root();
+    ASSERT_NE(root, nullptr);
+    EXPECT_TRUE(root->equals(dict.get()));
+}
+
+TEST(Binary, ViewInvalid)
+{
+    auto view = BinaryView::Create(std::vector<uint8_t>({ 0x62, 0x70, 0x6c, 0x69, 0x73, 0x74, 0x30, 0x30 }));
+    EXPECT_EQ(view.first, nullptr);
+    EXPECT_NE(view.second, "");
+
+    /* Other top level objects have no keys. */
+    auto string = String::New("top");
+    auto serialize = Binary::Serialize(string.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    auto stringView = BinaryView::Create(*serialize.first);
+    ASSERT_NE(stringView.first, nullptr);
+    EXPECT_TRUE(stringView.first->keys().empty());
+    EXPECT_EQ(stringView.first->value("top"), nullptr);
+    ASSERT_NE(stringView.first->root(), nullptr);
+    EXPECT_TRUE(stringView.first->root()->equals(string.get()));
+}
+
+TEST(Binary, UniqueValues)
+{
+    auto array = Array::New();
+    array->append(String::New("x"));
+    array->append(Integer::New(1));
+
+    auto dict = Dictionary::New();
+    dict->set("a", String::New("x"));
+    dict->set("b", String::New("x"));
+    dict->set("c", std::move(array));
+    dict->set("d", Integer::New(1));
+
+    auto other = Dictionary::New();
+    other->set("a", Integer::New(1));
+    dict->set("e", std::move(other));
+
+    auto serialize = Binary::Serialize(dict.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    /* Equal values and keys are written once: two dictionaries, one array, five keys, "x" and 1. */
+    auto view = BinaryView::Create(*serialize.first);
+    ASSERT_NE(view.first, nullptr);
+    EXPECT_EQ(view.first->count(), 10);
+
+    auto deserialize = Binary::Deserialize(*serialize.first, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(dict.get()));
+}
+
+TEST(Binary, SharedContainer)
+{
+    /* An array containing the same array twice. */
+    std::vector<uint8_t> contents = {
+        0x62, 0x70, 0x6c, 0x69, 0x73, 0x74, 0x30, 0x30, 0xa2, 0x01, 0x01, 0xa1,
+        0x02, 0x51, 0x78, 0x08, 0x0b, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x0f,
+    };
+
+    auto inner = Array::New();
+    inner->append(String::New("x"));
+
+    auto array = Array::New();
+    array->append(inner->copy());
+    array->append(inner->copy());
+
+    auto deserialize = Binary::Deserialize(contents, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr) << deserialize.second;
+    EXPECT_TRUE(deserialize.first->equals(array.get()));
+}
@@ -168,3 +168,80 @@ TEST(Encoding, ConvertStripBOM)
         EXPECT_FALSE(std::equal(BOM.begin(), BOM.end(), converted.begin()));
     }
 }
+
+static void
+AppendUTF8(std::vector<uint8_t> *buffer, uint32_t code)
+{
+    if (code < 0x80) {
+        buffer->insert(buffer->end(), { static_cast<uint8_t>(code) });
+    } else if (code < 0x800) {
+        buffer->insert(buffer->end(), { static_cast<uint8_t>(0xC0 | (code >> 6)), static_cast<uint8_t>(0x80 | (code & 0x3F)) });
+    } else if (code < 0x10000) {
+        buffer->insert(buffer->end(), { static_cast<uint8_t>(0xE0 | (code >> 12)), static_cast<uint8_t>(0x80 | ((code >> 6) & 0x3F)), static_cast<uint8_t>(0x80 | (code & 0x3F)) });
+    } else {
+        buffer->insert(buffer->end(), { static_cast<uint8_t>(0xF0 | (code >> 18)), static_cast<uint8_t>(0x80 | ((code >> 12) & 0x3F)), static_cast<uint8_t>(0x80 | ((code >> 6) & 0x3F)), static_cast<uint8_t>(0x80 | (code & 0x3F)) });
+    }
+}
+
+static void
+AppendUTF16(std::vector<uint8_t> *buffer, uint32_t code, bool little)
+{
+    std::vector<uint16_t> units;
+    if (code < 0x10000) {
+        units = { static_cast<uint16_t>(code) };
+    } else {
+        units = { static_cast<uint16_t>(0xD800 | ((code - 0x10000) >> 10)), static_cast<uint16_t>(0xDC00 | ((code - 0x10000) & 0x3FF)) };
+    }
+
+    for (uint16_t unit : units) {
+        if (little) {
+            buffer->insert(buffer->end(), { static_cast<uint8_t>(unit), static_cast<uint8_t>(unit >> 8) });
+        } else {
+            buffer->insert(buffer->end(), { static_cast<uint8_t>(unit >> 8), static_cast<uint8_t>(unit) });
+        }
+    }
+}
+
+TEST(Encoding, ConvertUTF16)
+{
+    /* Mix ASCII runs of each length around one, two, three, and four byte characters. */
+    std::vector<uint32_t> characters = { 0x41, 0xE9, 0x20AC, 0xF8FF, 0xFFFD, 0x1F4A9, 0x10FFFF };
+    std::vector<uint32_t> codes;
+    for (size_t run = 0; run < 20; run++) {
+        for (uint32_t character : characters) {
+            for (size_t n = 0; n < run; n++) {
+                codes.push_back(0x61 + (n % 26));
+            }
+            codes.push_back(character);
+        }
+    }
+
+    std::vector<uint8_t> UTF8;
+    std::vector<uint8_t> UTF16LE;
+    std::vector<uint8_t> UTF16BE;
+    for (uint32_t code : codes) {
+        AppendUTF8(&UTF8, code);
+        AppendUTF16(&UTF16LE, code, true);
+        AppendUTF16(&UTF16BE, code, false);
+    }
+
+    EXPECT_EQ(Encodings::Convert(UTF8, Encoding::UTF8, Encoding::UTF16LE), UTF16LE);
+    EXPECT_EQ(Encodings::Convert(UTF8, Encoding::UTF8, Encoding::UTF16BE), UTF16BE);
+    EXPECT_EQ(Encodings::Convert(UTF16LE, Encoding::UTF16LE, Encoding::UTF8), UTF8);
+    EXPECT_EQ(Encodings::Convert(UTF16BE, Encoding::UTF16BE, Encoding::UTF8), UTF8);
+}
+
+TEST(Encoding, ConvertUTF16Invalid)
+{
+    /* Invalid UTF-8 is skipped: a lone continuation, a truncated sequence, an overlong encoding, and an encoded surrogate. */
+    std::vector<uint8_t> UTF8 = { 'a', 0x80, 'b', 0xE2, 0x82, 'c', 0xC0, 0xAF, 'd', 0xED, 0xA0, 0x80, 'e', 0xE2 };
+    EXPECT_EQ(Encodings::Convert(UTF8, Encoding::UTF8, Encoding::UTF16LE), std::vector<uint8_t>({
+        'a', 0, 'b', 0, 'c', 0, 'd', 0, 'e', 0,
+    }));
+
+    /* Unpaired surrogates are skipped, as is a trailing odd byte. */
+    std::vector<uint8_t> UTF16 = { 'a', 0, 0x3D, 0xD8, 'b', 0, 0xA9, 0xDC, 'c', 0, 0x3D, 0xD8, 'd' };
+    EXPECT_EQ(Encodings::Convert(UTF16, Encoding::UTF16LE, Encoding::UTF8), std::vector<uint8_t>({
+        'a', 'b', 'c',
+    }));
+}
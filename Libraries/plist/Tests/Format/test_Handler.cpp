@@ -0,0 +1,228 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/JSON.h>
+#include <plist/Format/SimpleXML.h>
+#include <plist/Format/XML.h>
+#include <plist/Objects.h>
+
+#include <string>
+#include <vector>
+
+using plist::Format::ASCII;
+using plist::Format::Binary;
+using plist::Format::Encoding;
+using plist::Format::Handler;
+using plist::Format::JSON;
+using plist::Format::SimpleXML;
+using plist::Format::XML;
+using plist::Object;
+using plist::String;
+using plist::Integer;
+using plist::Boolean;
+using plist::Array;
+using plist::Dictionary;
+using plist::CastTo;
+
+/*
+ * Records each event, and stops after a number of events.
+ */
+class Recorder : public Handler {
+private:
+    size_t _limit;
+
+public:
+    std::vector<std::string> events;
+
+public:
+    explicit Recorder(size_t limit = static_cast<size_t>(-1)) :
+        _limit(limit)
+    {
+    }
+
+private:
+    bool record(std::string const &event)
+    {
+        events.push_back(event);
+        return (events.size() < _limit);
+    }
+
+public:
+    virtual bool beginDictionary()
+    { return record("{"); }
+    virtual bool endDictionary()
+    { return record("}"); }
+    virtual bool beginArray()
+    { return record("["); }
+    virtual bool endArray()
+    { return record("]"); }
+    virtual bool key(std::string const &key)
+    { return record("key " + key); }
+
+    virtual bool value(std::unique_ptr<Object> value)
+    {
+        if (String const *string = CastTo<String>(value.get())) {
+            return record("string " + string->value());
+        } else if (Integer const *integer = CastTo<Integer>(value.get())) {
+            return record("integer " + std::to_string(integer->value()));
+        } else if (Boolean const *boolean = CastTo<Boolean>(value.get())) {
+            return record(boolean->value() ? "true" : "false");
+        } else {
+            return record("value");
+        }
+    }
+};
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(Handler, ASCII)
+{
+    std::vector<uint8_t> contents = Contents("{ a = (1, \"x\"); b = { }; }");
+
+    Recorder recorder;
+    auto result = ASCII::Parse(contents, ASCII::Create(false, Encoding::UTF8), &recorder);
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ(result.second, "");
+    EXPECT_EQ(recorder.events, std::vector<std::string>({
+        "{", "key a", "[", "string 1", "string x", "]", "key b", "{", "}", "}",
+    }));
+}
+
+TEST(Handler, JSON)
+{
+    std::vector<uint8_t> contents = Contents("{ \"a\": [ 1, true ], \"b\": \"c\" }");
+
+    Recorder recorder;
+    auto result = JSON::Parse(contents, JSON::Create(), &recorder);
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ(recorder.events, std::vector<std::string>({
+        "{", "key a", "[", "integer 1", "true", "]", "key b", "string c", "}",
+    }));
+}
+
+TEST(Handler, XML)
+{
+    std::vector<uint8_t> contents = Contents(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<plist version=\"1.0\">\n"
+        "<dict>\n"
+        "  <key>a</key>\n"
+        "  <array><integer>1</integer><false/></array>\n"
+        "  <key>b</key>\n"
+        "  <dict><key>CF$UID</key><integer>2</integer></dict>\n"
+        "</dict>\n"
+        "</plist>\n");
+
+    /* Dictionaries are not converted to UIDs when parsing. */
+    Recorder recorder;
+    auto result = XML::Parse(contents, XML::Create(Encoding::UTF8), &recorder);
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ(recorder.events, std::vector<std::string>({
+        "{", "key a", "[", "integer 1", "false", "]", "key b", "{", "key CF$UID", "integer 2", "}", "}",
+    }));
+}
+
+TEST(Handler, SimpleXML)
+{
+    std::vector<uint8_t> contents = Contents(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<Scheme version=\"1.3\">\n"
+        "  <Action name=\"a\"/>\n"
+        "  <Action name=\"b\"/>\n"
+        "  <Options parallel=\"YES\"/>\n"
+        "</Scheme>\n");
+
+    /* Repeated elements are combined into an array. */
+    Recorder recorder;
+    auto result = SimpleXML::Parse(contents, SimpleXML::Create(Encoding::UTF8), &recorder);
+    EXPECT_TRUE(result.first) << result.second;
+    EXPECT_EQ(recorder.events, std::vector<std::string>({
+        "{", "key Scheme", "{", "key version", "string 1.3",
+        "key Action", "[", "{", "key name", "string a", "}", "{", "key name", "string b", "}", "]",
+        "key Options", "{", "key parallel", "true", "}", "}", "}",
+    }));
+
+    Recorder stopped = Recorder(4);
+    auto stoppedResult = SimpleXML::Parse(contents, SimpleXML::Create(Encoding::UTF8), &stopped);
+    EXPECT_FALSE(stoppedResult.first);
+    EXPECT_EQ(stoppedResult.second, "");
+    EXPECT_EQ(stopped.events.size(), 4);
+}
+
+TEST(Handler, Binary)
+{
+    auto array = Array::New();
+    array->append(String::New("x"));
+
+    auto dict = Dictionary::New();
+    dict->set("a", array->copy());
+    dict->set("b", Integer::New(3));
+    dict->set("c", array->copy());
+
+    auto serialize = Binary::Serialize(dict.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    Recorder recorder;
+    auto result = Binary::Parse(*serialize.first, Binary::Create(), &recorder);
+    EXPECT_TRUE(result.first) << result.second;
+    EXPECT_EQ(recorder.events, std::vector<std::string>({
+        "{", "key a", "[", "string x", "]", "key b", "integer 3", "key c", "[", "string x", "]", "}",
+    }));
+}
+
+TEST(Handler, Stop)
+{
+    std::vector<uint8_t> ascii = Contents("{ a = (1, 2); b = 3; }");
+    Recorder asciiRecorder = Recorder(4);
+    auto asciiResult = ASCII::Parse(ascii, ASCII::Create(false, Encoding::UTF8), &asciiRecorder);
+    EXPECT_FALSE(asciiResult.first);
+    EXPECT_EQ(asciiResult.second, "");
+    EXPECT_EQ(asciiRecorder.events.size(), 4);
+
+    std::vector<uint8_t> json = Contents("{ \"a\": [ 1, 2 ], \"b\": 3 }");
+    Recorder jsonRecorder = Recorder(4);
+    auto jsonResult = JSON::Parse(json, JSON::Create(), &jsonRecorder);
+    EXPECT_FALSE(jsonResult.first);
+    EXPECT_EQ(jsonResult.second, "");
+    EXPECT_EQ(jsonRecorder.events.size(), 4);
+
+    std::vector<uint8_t> xml = Contents("<plist><dict><key>a</key><array><integer>1</integer><integer>2</integer></array></dict></plist>");
+    Recorder xmlRecorder = Recorder(4);
+    auto xmlResult = XML::Parse(xml, XML::Create(Encoding::UTF8), &xmlRecorder);
+    EXPECT_FALSE(xmlResult.first);
+    EXPECT_EQ(xmlResult.second, "");
+    EXPECT_EQ(xmlRecorder.events.size(), 4);
+
+    auto deserialize = ASCII::Deserialize(ascii, ASCII::Create(false, Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+    auto binary = Binary::Serialize(deserialize.first.get(), Binary::Create());
+    ASSERT_NE(binary.first, nullptr);
+    Recorder binaryRecorder = Recorder(4);
+    auto binaryResult = Binary::Parse(*binary.first, Binary::Create(), &binaryRecorder);
+    EXPECT_FALSE(binaryResult.first);
+    EXPECT_EQ(binaryResult.second, "");
+    EXPECT_EQ(binaryRecorder.events.size(), 4);
+}
+
+TEST(Handler, Invalid)
+{
+    std::vector<uint8_t> contents = Contents("{ a = (1, 2; }");
+
+    Recorder recorder;
+    auto result = ASCII::Parse(contents, ASCII::Create(false, Encoding::UTF8), &recorder);
+    EXPECT_FALSE(result.first);
+    EXPECT_NE(result.second, "");
+}
@@ -70,3 +70,36 @@ TEST(XML, UID)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+TEST(XML, Text)
+{
+    auto contents = Contents(std::string(XMLHeader) + "<array>\n\t<string>a &amp; b &#65;&#x263A;</string>\n\t<string>line\r\nline</string>\n\t<string> </string>\n\t<string>a<!-- comment -->b</string>\n</array>\n" + std::string(XMLFooter));
+
+    auto deserialize = XML::Deserialize(contents, XML::Create(Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+
+    auto array = Array::New();
+    array->append(String::New("a & b A\xE2\x98\xBA"));
+    array->append(String::New("line\nline"));
+    array->append(String::New(""));
+    array->append(String::New("ab"));
+    EXPECT_TRUE(deserialize.first->equals(array.get()));
+}
+
+TEST(XML, DocumentTypeEntities)
+{
+    /* Entities declared in the document are handled by libxml2. */
+    auto contents = Contents("<!DOCTYPE plist [ <!ENTITY name \"value\"> ]>\n<plist version=\"1.0\">\n<string>&name;</string>\n</plist>\n");
+
+    auto deserialize = XML::Deserialize(contents, XML::Create(Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(String::New("value").get()));
+}
+
+TEST(XML, Invalid)
+{
+    EXPECT_EQ(nullptr, XML::Deserialize(Contents(std::string(XMLHeader) + "<string>a</strin>\n" + XMLFooter), XML::Create(Encoding::UTF8)).first);
+    EXPECT_EQ(nullptr, XML::Deserialize(Contents(std::string(XMLHeader) + "<string>&undefined;</string>\n" + XMLFooter), XML::Create(Encoding::UTF8)).first);
+    EXPECT_EQ(nullptr, XML::Deserialize(Contents(std::string(XMLHeader) + "<string>a</string>\n" + XMLFooter + "<plist/>\n"), XML::Create(Encoding::UTF8)).first);
+    EXPECT_EQ(nullptr, XML::Deserialize(Contents(std::string(XMLHeader) + "<string>a</string>\n"), XML::Create(Encoding::UTF8)).first);
+}
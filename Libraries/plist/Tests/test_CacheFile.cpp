@@ -0,0 +1,60 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/CacheFile.h>
+#include <plist/Objects.h>
+#include <plist/Format/BinaryView.h>
+#include <libutil/MemoryFilesystem.h>
+
+using plist::CacheFile;
+using plist::Dictionary;
+using plist::String;
+using libutil::MemoryFilesystem;
+
+TEST(CacheFile, SaveLoad)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+
+    std::unique_ptr<Dictionary> saved = Dictionary::New();
+    saved->set("Key", String::New("value"));
+    EXPECT_TRUE(CacheFile::Save(&filesystem, "/cache/file", 2, std::move(saved)));
+    EXPECT_EQ(filesystem.type("/cache/file"), libutil::Filesystem::Type::File);
+
+    std::unique_ptr<Dictionary> loaded = CacheFile::Load(&filesystem, "/cache/file", 2);
+    ASSERT_NE(loaded, nullptr);
+    ASSERT_NE(loaded->value<String>("Key"), nullptr);
+    EXPECT_EQ(loaded->value<String>("Key")->value(), "value");
+
+    auto view = CacheFile::LoadView(&filesystem, "/cache/file", 2);
+    ASSERT_NE(view, nullptr);
+    ASSERT_NE(view->value<String>("Key"), nullptr);
+    EXPECT_EQ(view->value<String>("Key")->value(), "value");
+
+    /* Nothing is left beside the saved file. */
+    size_t count = 0;
+    filesystem.readDirectory("/cache", false, [&](std::string const &name) { count++; });
+    EXPECT_EQ(count, 1);
+}
+
+TEST(CacheFile, Ignored)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("invalid", std::vector<uint8_t>({ 'b', 'a', 'd' })),
+    });
+    EXPECT_TRUE(CacheFile::Save(&filesystem, "/file", 1, Dictionary::New()));
+
+    /* Files saved with another version are ignored. */
+    EXPECT_EQ(CacheFile::Load(&filesystem, "/file", 2), nullptr);
+    EXPECT_EQ(CacheFile::LoadView(&filesystem, "/file", 2), nullptr);
+
+    EXPECT_EQ(CacheFile::Load(&filesystem, "/invalid", 1), nullptr);
+    EXPECT_EQ(CacheFile::LoadView(&filesystem, "/invalid", 1), nullptr);
+    EXPECT_EQ(CacheFile::Load(&filesystem, "/missing", 1), nullptr);
+}
@@ -0,0 +1,97 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Objects.h>
+
+using plist::Dictionary;
+using plist::String;
+using plist::Integer;
+
+TEST(Dictionary, Order)
+{
+    auto dict = Dictionary::New();
+    dict->reserve(3);
+    dict->set("b", Integer::New(1));
+    dict->set("a", Integer::New(2));
+    dict->set("c", Integer::New(3));
+
+    ASSERT_EQ(dict->count(), 3);
+    EXPECT_EQ(dict->key(0), "b");
+    EXPECT_EQ(dict->key(1), "a");
+    EXPECT_EQ(dict->key(2), "c");
+    EXPECT_EQ(dict->value<Integer>(1)->value(), 2);
+    EXPECT_EQ(dict->value<Integer>("c")->value(), 3);
+
+    std::vector<std::string> keys = std::vector<std::string>(dict->begin(), dict->end());
+    EXPECT_EQ(keys, std::vector<std::string>({ "b", "a", "c" }));
+}
+
+TEST(Dictionary, Replace)
+{
+    auto dict = Dictionary::New();
+    dict->set("a", Integer::New(1));
+    dict->set("b", Integer::New(2));
+    dict->set("a", String::New("one"));
+
+    /* Replaced keys move to the end. */
+    ASSERT_EQ(dict->count(), 2);
+    EXPECT_EQ(dict->key(0), "b");
+    EXPECT_EQ(dict->key(1), "a");
+    EXPECT_EQ(dict->value<String>("a")->value(), "one");
+
+    dict->remove("b");
+    ASSERT_EQ(dict->count(), 1);
+    EXPECT_EQ(dict->key(0), "a");
+    EXPECT_EQ(dict->value("b"), nullptr);
+}
+
+TEST(Dictionary, Copy)
+{
+    auto dict = Dictionary::New();
+    for (int n = 0; n < 100; n++) {
+        dict->set(std::to_string(n), Integer::New(n));
+    }
+
+    auto copy = dict->copy();
+    ASSERT_EQ(copy->count(), 100);
+    for (size_t n = 0; n < copy->count(); n++) {
+        EXPECT_EQ(copy->key(n), std::to_string(n));
+        EXPECT_EQ(copy->value<Integer>(n)->value(), (int)n);
+    }
+    EXPECT_TRUE(copy->equals(dict.get()));
+}
+
+TEST(Dictionary, Large)
+{
+    auto dict = Dictionary::New();
+    for (int n = 0; n < 100; n++) {
+        dict->set(std::to_string(n), Integer::New(n));
+    }
+
+    dict->remove("10");
+    dict->set("20", Integer::New(-20));
+    ASSERT_EQ(dict->count(), 99);
+    EXPECT_EQ(dict->value("10"), nullptr);
+    EXPECT_EQ(dict->key(97), "99");
+    EXPECT_EQ(dict->key(98), "20");
+    EXPECT_EQ(dict->value<Integer>("20")->value(), -20);
+    for (int n = 21; n < 100; n++) {
+        EXPECT_EQ(dict->value<Integer>(std::to_string(n))->value(), n);
+    }
+
+    /* Shrinking back below the index threshold. */
+    for (int n = 0; n < 100; n++) {
+        if (n != 50) {
+            dict->remove(std::to_string(n));
+        }
+    }
+    ASSERT_EQ(dict->count(), 1);
+    EXPECT_EQ(dict->value<Integer>("50")->value(), 50);
+}
@@ -0,0 +1,110 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/FileCache.h>
+#include <plist/Format/Any.h>
+#include <plist/Objects.h>
+#include <libutil/MemoryFilesystem.h>
+
+using plist::FileCache;
+using plist::Object;
+using plist::String;
+using plist::CastTo;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(FileCache, Shared)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file.plist", Contents("\"one\"")),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+    FileCache cache;
+
+    std::shared_ptr<Object const> first = cache.read<plist::Format::Any>(&filesystem, "/file.plist");
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(CastTo<String>(first.get())->value(), "one");
+
+    /* Files with unchanged stamps are not parsed again. */
+    EXPECT_TRUE(filesystem.write(Contents("\"two\""), "/file.plist"));
+    EXPECT_TRUE(filesystem.setStamp("/file.plist", Filesystem::Stamp({ 1, 1 })));
+    std::shared_ptr<Object const> second = cache.read<plist::Format::Any>(&filesystem, "/file.plist");
+    EXPECT_EQ(second, first);
+
+    /* Changed files are. */
+    EXPECT_TRUE(filesystem.setStamp("/file.plist", Filesystem::Stamp({ 1, 2 })));
+    std::shared_ptr<Object const> third = cache.read<plist::Format::Any>(&filesystem, "/file.plist");
+    ASSERT_NE(third, nullptr);
+    EXPECT_NE(third, first);
+    EXPECT_EQ(CastTo<String>(third.get())->value(), "two");
+}
+
+TEST(FileCache, Uncached)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file.plist", Contents("\"one\"")),
+        MemoryFilesystem::Entry::File("invalid.plist", Contents("{")),
+    });
+    FileCache cache;
+
+    /* Without stamps, files are always parsed. */
+    std::shared_ptr<Object const> first = cache.read<plist::Format::Any>(&filesystem, "/file.plist");
+    std::shared_ptr<Object const> second = cache.read<plist::Format::Any>(&filesystem, "/file.plist");
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_NE(first, second);
+
+    EXPECT_EQ(cache.read<plist::Format::Any>(&filesystem, "/invalid.plist"), nullptr);
+    EXPECT_EQ(cache.read<plist::Format::Any>(&filesystem, "/missing.plist"), nullptr);
+}
+
+TEST(FileCache, Saved)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("one.plist", Contents("\"one\"")),
+        MemoryFilesystem::Entry::File("two.plist", Contents("\"two\"")),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    FileCache first;
+    EXPECT_NE(first.read<plist::Format::Any>(&filesystem, "/one.plist"), nullptr);
+    EXPECT_NE(first.read<plist::Format::Any>(&filesystem, "/two.plist"), nullptr);
+    EXPECT_TRUE(first.save(&filesystem, "/cache/files.plist"));
+    EXPECT_TRUE(filesystem.isReadable("/cache/files.plist"));
+
+    /* Saved files are used while their stamps are unchanged. */
+    EXPECT_TRUE(filesystem.write(Contents("\"changed\""), "/one.plist"));
+    EXPECT_TRUE(filesystem.setStamp("/one.plist", Filesystem::Stamp({ 1, 1 })));
+    FileCache second;
+    EXPECT_TRUE(second.load(&filesystem, "/cache/files.plist"));
+    std::shared_ptr<Object const> one = second.read<plist::Format::Any>(&filesystem, "/one.plist");
+    ASSERT_NE(one, nullptr);
+    EXPECT_EQ(CastTo<String>(one.get())->value(), "one");
+
+    /* Nothing was parsed, so there is nothing new to save. */
+    EXPECT_TRUE(second.save(&filesystem, "/cache/other.plist"));
+    EXPECT_FALSE(filesystem.isReadable("/cache/other.plist"));
+
+    /* Changed files are parsed again. */
+    EXPECT_TRUE(filesystem.setStamp("/one.plist", Filesystem::Stamp({ 1, 2 })));
+    FileCache third;
+    EXPECT_TRUE(third.load(&filesystem, "/cache/files.plist"));
+    std::shared_ptr<Object const> changed = third.read<plist::Format::Any>(&filesystem, "/one.plist");
+    ASSERT_NE(changed, nullptr);
+    EXPECT_EQ(CastTo<String>(changed.get())->value(), "changed");
+
+    EXPECT_FALSE(third.load(&filesystem, "/missing.plist"));
+}
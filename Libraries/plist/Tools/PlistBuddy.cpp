@@ -25,11 +25,13 @@
 #include <libutil/Filesystem.h>
 #include <libutil/DefaultFilesystem.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <queue>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #if defined(HAVE_LINENOISE)
 #include <linenoise.h>
@@ -48,7 +50,8 @@ private:
     ext::optional<bool>         _xml;
 
 private:
-    ext::optional<std::string>  _command;
+    std::vector<std::string>    _commands;
+    ext::optional<std::string>  _script;
 
 private:
     std::string                 _input;
@@ -64,8 +67,10 @@ public:
     { return _xml.value_or(false); }
 
 public:
-    ext::optional<std::string> command() const
-    { return _command; }
+    std::vector<std::string> const &commands() const
+    { return _commands; }
+    ext::optional<std::string> const &script() const
+    { return _script; }
 
 public:
     std::string input() const
@@ -98,7 +103,9 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
     } else if (arg == "-x") {
         return libutil::Options::Current(&_xml, arg, it);
     } else if (arg == "-c") {
-        return libutil::Options::Next<std::string>(&_command, args, it);
+        return libutil::Options::AppendNext<std::string>(&_commands, args, it);
+    } else if (arg == "-f") {
+        return libutil::Options::Next<std::string>(&_script, args, it);
     } else if (!arg.empty() && arg[0] != '-') {
         _input = arg;
         return std::make_pair(true, std::string());
@@ -143,6 +150,7 @@ Help(std::string const &error = std::string())
 #define INDENT "  "
     fprintf(stderr, "\noptions:\n");
     fprintf(stderr, INDENT "-c \"<command>\" command to execute, otherwise run in interactive mode\n");
+    fprintf(stderr, INDENT "-f <script> file of commands to execute, one per line\n");
     fprintf(stderr, INDENT "-x output will be in xml plist format\n");
     fprintf(stderr, INDENT "-h print help including commands\n");
 #undef INDENT
@@ -506,6 +514,35 @@ Merge(plist::Object *object, std::string &mergeSource, std::queue<std::string> *
     }
 }
 
+static bool
+ReadScript(Filesystem const *filesystem, std::string const &path, std::vector<std::string> *commands)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        fprintf(stderr, "error: unable to read %s\n", path.c_str());
+        return false;
+    }
+
+    /* One command per line; blank lines and lines starting with '#' are skipped. */
+    auto begin = contents.begin();
+    while (begin != contents.end()) {
+        auto end = std::find(begin, contents.end(), '\n');
+        std::string line = std::string(begin, end);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        std::string::size_type first = line.find_first_not_of(" \t");
+        if (first != std::string::npos && line[first] != '#') {
+            commands->push_back(line);
+        }
+
+        begin = (end == contents.end() ? end : end + 1);
+    }
+
+    return true;
+}
+
 static bool
 ProcessCommand(Filesystem *filesystem, std::string const &path, bool xml, RootObjectContainer &root, std::string const &input, bool *mutated, bool *keepReading)
 {
@@ -528,6 +565,7 @@ ProcessCommand(Filesystem *filesystem, std::string const &path, bool xml, RootOb
         std::queue<std::string> keyPath;
         return Print(root.object.get(), keyPath, xml, filesystem, path);
     } else if (command == "Exit") {
+        *keepReading = false;
         return true;
     } else if (command == "Set") {
         if (tokens.size() < 2) {
@@ -633,15 +671,35 @@ main(int argc, char **argv)
     }
 
     bool success = true;
-    if (options.command()) {
-        bool keepReading = true; // unused here
+    std::vector<std::string> commands = options.commands();
+    if (options.script() && !ReadScript(&filesystem, *options.script(), &commands)) {
+        return 1;
+    }
+
+    if (!commands.empty()) {
+        /*
+         * Apply every command to the one parsed tree, then save it once. The
+         * file is only written if the commands all succeed and leave the tree
+         * different from how it was read, so scripts that set values which
+         * are already current don't touch the file.
+         */
+        std::unique_ptr<plist::Object> original = root.object->copy();
+
+        bool keepReading = true;
         bool mutated = false;
-        success &= ProcessCommand(&filesystem, options.input(), options.xml(), root, *options.command(), &mutated, &keepReading);
-        /* If there was a failure, mutated would be false */
-        if (mutated) {
+        for (std::string const &command : commands) {
+            if (!ProcessCommand(&filesystem, options.input(), options.xml(), root, command, &mutated, &keepReading)) {
+                return 1;
+            }
+            if (!keepReading) {
+                break;
+            }
+        }
+
+        if (mutated && !root.object->equals(original.get())) {
             /* Save result. */
             std::queue<std::string> keyPath;
-            Print(root.object.get(), keyPath, options.xml(), &filesystem, options.input());
+            success &= Print(root.object.get(), keyPath, options.xml(), &filesystem, options.input());
         }
     } else {
         char *line;
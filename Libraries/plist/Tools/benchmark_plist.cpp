@@ -0,0 +1,220 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Object.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/JSON.h>
+#include <plist/Format/SimpleXML.h>
+#include <plist/Format/XML.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+#include <cstdlib>
+
+using libutil::DefaultFilesystem;
+
+/*
+ * Count allocations, to compare the allocations made per object.
+ */
+static std::atomic<size_t> Allocations(0);
+
+void *
+operator new(size_t size)
+{
+    Allocations++;
+    void *pointer = std::malloc(size != 0 ? size : 1);
+    if (pointer == nullptr) {
+        /* Built without exceptions. */
+        std::abort();
+    }
+    return pointer;
+}
+
+void
+operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void
+operator delete(void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+/*
+ * The number of objects in a property list, including itself.
+ */
+static size_t
+Count(plist::Object const *object)
+{
+    size_t count = 1;
+    if (plist::Array const *array = plist::CastTo<plist::Array>(object)) {
+        for (size_t i = 0; i < array->count(); ++i) {
+            count += Count(array->value(i));
+        }
+    } else if (plist::Dictionary const *dictionary = plist::CastTo<plist::Dictionary>(object)) {
+        for (size_t i = 0; i < dictionary->count(); ++i) {
+            count += Count(dictionary->value(i));
+        }
+    }
+    return count;
+}
+
+/*
+ * Totals for one direction of one format across the corpus.
+ */
+struct Measurement {
+    size_t bytes       = 0;
+    size_t objects     = 0;
+    size_t allocations = 0;
+    double seconds     = 0;
+    size_t failures    = 0;
+
+    void print(std::string const &name) const
+    {
+        if (objects == 0) {
+            printf("%-24s %10s\n", name.c_str(), "-");
+            return;
+        }
+
+        double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+        printf("%-24s %10.1f MB/s %10.2f allocations/object", name.c_str(), megabytes / seconds, static_cast<double>(allocations) / static_cast<double>(objects));
+        if (failures != 0) {
+            printf(" (%zu failed)", failures);
+        }
+        printf("\n");
+    }
+};
+
+/*
+ * Serializes each file in a format, then times reading and writing it. The
+ * serializer to read from can be a different format, for formats that can
+ * only be read.
+ */
+template<typename T, typename S>
+static void
+Benchmark(std::string const &name, std::vector<std::unique_ptr<plist::Object>> const &corpus, T const &format, S const &serializer, bool serialize, size_t iterations)
+{
+    Measurement read;
+    Measurement write;
+
+    for (std::unique_ptr<plist::Object> const &object : corpus) {
+        auto serialized = plist::Format::Format<S>::Serialize(object.get(), serializer);
+        if (serialized.first == nullptr) {
+            read.failures++;
+            continue;
+        }
+        std::vector<uint8_t> const &contents = *serialized.first;
+        size_t objects = Count(object.get());
+
+        size_t allocations = Allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            plist::Format::Format<T>::Deserialize(contents, format);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        if (plist::Format::Format<T>::Deserialize(contents, format).first == nullptr) {
+            read.failures++;
+            continue;
+        }
+
+        read.bytes += contents.size() * iterations;
+        read.objects += objects * iterations;
+        read.allocations += Allocations - allocations;
+        read.seconds += std::chrono::duration<double>(end - start).count();
+
+        if (serialize) {
+            allocations = Allocations;
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i) {
+                plist::Format::Format<T>::Serialize(object.get(), format);
+            }
+            end = std::chrono::steady_clock::now();
+
+            write.bytes += contents.size() * iterations;
+            write.objects += objects * iterations;
+            write.allocations += Allocations - allocations;
+            write.seconds += std::chrono::duration<double>(end - start).count();
+        }
+    }
+
+    read.print(name + " deserialize");
+    if (serialize) {
+        write.print(name + " serialize");
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: benchmark_plist iterations file...\n\n");
+        fprintf(stderr, "Measures reading and writing each property list format.\n");
+        fprintf(stderr, "Each file, in any format, is converted to each format first.\n");
+        return -1;
+    }
+
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    size_t iterations = std::strtoul(argv[1], NULL, 10);
+
+    /*
+     * Load the corpus.
+     */
+    size_t bytes = 0;
+    size_t objects = 0;
+    std::vector<std::unique_ptr<plist::Object>> corpus;
+    for (int i = 2; i < argc; ++i) {
+        std::vector<uint8_t> contents;
+        if (!filesystem.read(&contents, argv[i])) {
+            fprintf(stderr, "error: unable to read %s\n", argv[i]);
+            return -1;
+        }
+
+        auto deserialized = plist::Format::Any::Deserialize(contents);
+        if (deserialized.first == nullptr) {
+            fprintf(stderr, "error: unable to parse %s: %s\n", argv[i], deserialized.second.c_str());
+            return -1;
+        }
+
+        bytes += contents.size();
+        objects += Count(deserialized.first.get());
+        corpus.push_back(std::move(deserialized.first));
+    }
+    printf("%zu files, %zu bytes, %zu objects\n\n", corpus.size(), bytes, objects);
+
+    /*
+     * Measure each format.
+     */
+    plist::Format::ASCII ascii = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
+    plist::Format::XML xml = plist::Format::XML::Create(plist::Format::Encoding::UTF8);
+    plist::Format::SimpleXML simpleXML = plist::Format::SimpleXML::Create(plist::Format::Encoding::UTF8);
+    plist::Format::JSON json = plist::Format::JSON::Create();
+    plist::Format::Binary binary = plist::Format::Binary::Create();
+
+    Benchmark("ASCII", corpus, ascii, ascii, true, iterations);
+    Benchmark("XML", corpus, xml, xml, true, iterations);
+    /* Simple XML can't be written, so it reads what XML writes. */
+    Benchmark("SimpleXML", corpus, simpleXML, xml, false, iterations);
+    Benchmark("JSON", corpus, json, json, true, iterations);
+    Benchmark("Binary", corpus, binary, binary, true, iterations);
+
+    return 0;
+}
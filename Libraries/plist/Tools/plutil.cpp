@@ -26,16 +26,19 @@
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/DefaultContext.h>
 #include <process/Context.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <iostream>
 
 using libutil::Filesystem;
 using libutil::DefaultFilesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 class Options {
 public:
@@ -99,6 +102,7 @@ public:
 
 private:
     std::vector<std::string>   _inputs;
+    ext::optional<std::string> _batch;
     ext::optional<std::string> _output;
     ext::optional<std::string> _extension;
     ext::optional<bool>        _separator;
@@ -130,6 +134,8 @@ public:
 public:
     std::vector<std::string> const &inputs() const
     { return _inputs; }
+    ext::optional<std::string> const &batch() const
+    { return _batch; }
     ext::optional<std::string> const &output() const
     { return _output; }
     ext::optional<std::string> const &extension() const
@@ -177,24 +183,33 @@ Adjustment(Type type, std::string const &path, std::unique_ptr<plist::Object con
 {
 }
 
+static ext::optional<Options::Format>
+FormatNamed(std::string const &name)
+{
+    if (name == "xml1") {
+        auto xml = plist::Format::XML::Create(plist::Format::Encoding::UTF8);
+        return Options::Format(plist::Format::Any::Create(xml));
+    } else if (name == "binary1") {
+        auto binary = plist::Format::Binary::Create();
+        return Options::Format(plist::Format::Any::Create(binary));
+    } else if (name == "openstep1" || name == "ascii1") {
+        auto ascii = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
+        return Options::Format(plist::Format::Any::Create(ascii));
+    } else if (name == "json") {
+        return Options::Format(plist::Format::JSON::Create());
+    } else {
+        return ext::nullopt;
+    }
+}
+
 static std::pair<bool, std::string>
 NextFormat(ext::optional<Options::Format> *format, std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
 {
     ext::optional<std::string> value;
     std::pair<bool, std::string> result = libutil::Options::Next<std::string>(&value, args, it);
     if (result.first) {
-        if (*value == "xml1") {
-            auto xml = plist::Format::XML::Create(plist::Format::Encoding::UTF8);
-            *format = Options::Format(plist::Format::Any::Create(xml));
-        } else if (*value == "binary1") {
-            auto binary = plist::Format::Binary::Create();
-            *format = Options::Format(plist::Format::Any::Create(binary));
-        } else if (*value == "openstep1" || *value == "ascii1") {
-            auto ascii = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
-            *format = Options::Format(plist::Format::Any::Create(ascii));
-        } else if (*value == "json") {
-            *format = Options::Format(plist::Format::JSON::Create());
-        } else {
+        *format = FormatNamed(*value);
+        if (!*format) {
             return std::make_pair(false, "unknown format " + *value);
         }
     }
@@ -401,6 +416,8 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
 
         _convert = format;
         return result;
+    } else if (arg == "-batch") {
+        return libutil::Options::Next<std::string>(&_batch, args, it);
     } else if (arg == "-e") {
         return libutil::Options::Next<std::string>(&_extension, args, it);
     } else if (arg == "-o") {
@@ -438,6 +455,7 @@ Help(std::string const &error = std::string())
     fprintf(stderr, INDENT "-replace <key> <value>\n");
     fprintf(stderr, INDENT "-remove <key>\n");
     fprintf(stderr, INDENT "-extract <key> <format>\n");
+    fprintf(stderr, INDENT "-batch <manifest> (lines of <input> <tab> <output> <tab> <format>)\n");
 
     fprintf(stderr, "\nvalues:\n");
     fprintf(stderr, INDENT "-bool <YES|NO>\n");
@@ -600,7 +618,7 @@ PerformAdjustment(plist::Object *object, plist::Object **rootObject, std::string
 }
 
 static bool
-Modify(Filesystem *filesystem, Options const &options, std::string const &file, std::unique_ptr<plist::Object> object, Options::Format const &inputFormat)
+Modify(Filesystem *filesystem, Options const &options, std::unique_ptr<plist::Object> object, Options::Format const &inputFormat, ext::optional<Options::Format> const &convert, std::string const &output)
 {
     plist::Object *writeObject = object.get();
 
@@ -641,7 +659,7 @@ Modify(Filesystem *filesystem, Options const &options, std::string const &file,
     /* Convert to desired format. */
     std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> serialize;
 
-    Options::Format outputFormat = options.convert().value_or(inputFormat);
+    Options::Format outputFormat = convert.value_or(inputFormat);
     if (ext::optional<plist::Format::Any> any = outputFormat.any()) {
         serialize = plist::Format::Any::Serialize(writeObject, *any);
     } else if (ext::optional<plist::Format::JSON> json = outputFormat.json()) {
@@ -656,7 +674,6 @@ Modify(Filesystem *filesystem, Options const &options, std::string const &file,
     }
 
     /* Write to output. */
-    std::string output = OutputPath(options, file);
     if (!Write(filesystem, *serialize.first, output)) {
         fprintf(stderr, "error: unable to write\n");
         return false;
@@ -665,6 +682,136 @@ Modify(Filesystem *filesystem, Options const &options, std::string const &file,
     return true;
 }
 
+static bool
+Load(Filesystem const *filesystem, std::string const &file, std::unique_ptr<plist::Object> *root, ext::optional<Options::Format> *format)
+{
+    std::pair<bool, std::vector<uint8_t>> result = Read(filesystem, file);
+    if (!result.first) {
+        fprintf(stderr, "error: unable to read %s\n", file.c_str());
+        return false;
+    }
+
+    /* Deserialize input, storing input format. */
+    if (auto any = plist::Format::Any::Identify(result.second)) {
+        auto deserialize = plist::Format::Any::Deserialize(result.second, *any);
+        if (deserialize.first == nullptr) {
+            fprintf(stderr, "error: %s\n", deserialize.second.c_str());
+            return false;
+        }
+
+        *root = std::move(deserialize.first);
+        *format = Options::Format(*any);
+    } else {
+        auto json = plist::Format::JSON::Create();
+        auto deserialize = plist::Format::JSON::Deserialize(result.second, json);
+        if (deserialize.first == nullptr) {
+            fprintf(stderr, "error: input %s not a plist or json\n", file.c_str());
+            return false;
+        }
+
+        *root = std::move(deserialize.first);
+        *format = Options::Format(json);
+    }
+
+    return true;
+}
+
+/*
+ * A conversion listed in a batch manifest.
+ */
+struct BatchEntry {
+    std::string     input;
+    std::string     output;
+    Options::Format format;
+};
+
+static bool
+ParseManifest(std::vector<uint8_t> const &contents, std::vector<BatchEntry> *entries)
+{
+    std::string manifest = std::string(contents.begin(), contents.end());
+
+    size_t line = 0;
+    std::string::size_type start = 0;
+    while (start < manifest.size()) {
+        std::string::size_type end = manifest.find('\n', start);
+        if (end == std::string::npos) {
+            end = manifest.size();
+        }
+
+        std::string text = manifest.substr(start, end - start);
+        start = end + 1;
+        line++;
+
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        if (text.empty()) {
+            continue;
+        }
+
+        /* Tabs separate the fields, so paths can contain spaces. */
+        std::string::size_type first = text.find('\t');
+        std::string::size_type second = (first != std::string::npos ? text.find('\t', first + 1) : std::string::npos);
+        if (second == std::string::npos || text.find('\t', second + 1) != std::string::npos) {
+            fprintf(stderr, "error: manifest line %zu: expected input, output, and format\n", line);
+            return false;
+        }
+
+        std::string input = text.substr(0, first);
+        std::string output = text.substr(first + 1, second - first - 1);
+        std::string name = text.substr(second + 1);
+
+        /* Several conversions at once can't share the standard streams. */
+        if (input.empty() || output.empty() || input == "-" || output == "-") {
+            fprintf(stderr, "error: manifest line %zu: invalid path\n", line);
+            return false;
+        }
+
+        ext::optional<Options::Format> format = FormatNamed(name);
+        if (!format) {
+            fprintf(stderr, "error: manifest line %zu: unknown format %s\n", line, name.c_str());
+            return false;
+        }
+
+        entries->push_back({ input, output, *format });
+    }
+
+    return true;
+}
+
+static bool
+Batch(Filesystem *filesystem, Options const &options)
+{
+    std::pair<bool, std::vector<uint8_t>> result = Read(filesystem, *options.batch());
+    if (!result.first) {
+        fprintf(stderr, "error: unable to read %s\n", options.batch()->c_str());
+        return false;
+    }
+
+    std::vector<BatchEntry> entries;
+    if (!ParseManifest(result.second, &entries)) {
+        return false;
+    }
+
+    /*
+     * Each conversion is independent, so convert as many at once as there
+     * are jobs available.
+     */
+    std::atomic<bool> success = { true };
+    Parallel::For(Parallel::DefaultJobs(), entries.size(), [&](size_t n) {
+        BatchEntry const &entry = entries[n];
+
+        std::unique_ptr<plist::Object> root;
+        ext::optional<Options::Format> format;
+        if (!Load(filesystem, entry.input, &root, &format) ||
+            !Modify(filesystem, options, std::move(root), *format, entry.format, entry.output)) {
+            success = false;
+        }
+    });
+
+    return success;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -679,7 +826,10 @@ main(int argc, char **argv)
 
     /* Detect conflicting mode options. */
     bool modify = (options.convert() || !options.adjustments().empty());
-    if ((modify && options.lint()) ||
+    bool batch = static_cast<bool>(options.batch());
+    if ((batch && (options.convert() || options.lint() || options.print() || options.help())) ||
+        (batch && (!options.inputs().empty() || options.output() || options.extension())) ||
+        (modify && options.lint()) ||
         (modify && options.print()) ||
         (modify && options.help()) ||
         (options.lint() && options.print()) ||
@@ -691,6 +841,9 @@ main(int argc, char **argv)
     /* Perform actions. */
     if (options.help()) {
         return Help();
+    } else if (batch) {
+        /* Conversions listed in a manifest, with any adjustments applied to each. */
+        return (Batch(&filesystem, options) ? 0 : 1);
     } else {
         bool success = true;
 
@@ -700,43 +853,16 @@ main(int argc, char **argv)
 
         /* Actions applied to each input file separately. */
         for (std::string const &file : options.inputs()) {
-            std::pair<bool, std::vector<uint8_t>> result = Read(&filesystem, file);
-            if (!result.first) {
-                fprintf(stderr, "error: unable to read %s\n", file.c_str());
-                success = false;
-                continue;
-            }
-
-            /* Deserialize input, storing input format. */
             ext::optional<Options::Format> format;
             std::unique_ptr<plist::Object> root;
-
-            if (auto any = plist::Format::Any::Identify(result.second)) {
-                auto deserialize = plist::Format::Any::Deserialize(result.second, *any);
-                if (deserialize.first != nullptr) {
-                    root = std::move(deserialize.first);
-                    format = Options::Format(*any);
-                } else {
-                    fprintf(stderr, "error: %s\n", deserialize.second.c_str());
-                    success = false;
-                    continue;
-                }
-            } else {
-                auto json = plist::Format::JSON::Create();
-                auto deserialize = plist::Format::JSON::Deserialize(result.second, json);
-                if (deserialize.first != nullptr) {
-                    root = std::move(deserialize.first);
-                    format = Options::Format(json);
-                } else {
-                    fprintf(stderr, "error: input %s not a plist or json\n", file.c_str());
-                    success = false;
-                    continue;
-                }
+            if (!Load(&filesystem, file, &root, &format)) {
+                success = false;
+                continue;
             }
 
             /* Perform the sepcific action. */
             if (modify) {
-                success &= Modify(&filesystem, options, file, std::move(root), *format);
+                success &= Modify(&filesystem, options, std::move(root), *format, options.convert(), OutputPath(options, file));
             } else if (options.print()) {
                 success &= Print(&filesystem, options, std::move(root));
             } else if (options.lint() || true) {
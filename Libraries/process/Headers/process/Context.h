@@ -10,6 +10,7 @@
 #ifndef __process_Context_h
 #define __process_Context_h
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -17,6 +18,8 @@
 
 namespace process {
 
+class EnvironmentBlock;
+
 /*
  * The information passed into a launched process.
  */
@@ -52,6 +55,12 @@ public:
      */
     virtual ext::optional<std::string> environmentVariable(std::string const &variable) const = 0;
 
+    /*
+     * All environment variables, formatted to pass to a new process. By
+     * default, formatted each time.
+     */
+    virtual std::shared_ptr<EnvironmentBlock const> environmentBlock() const;
+
 public:
     /*
      * Active user ID.
@@ -12,20 +12,46 @@
 
 #include <process/Launcher.h>
 
+#include <unordered_map>
+#include <sys/types.h>
+
 namespace libutil { class Filesystem; }
 
 namespace process {
 
 /*
- * Abstract process launcher.
+ * Launches real processes. Started processes are supervised by waiting on
+ * process exit notifications: kqueue on Darwin and pidfd on Linux, falling
+ * back to periodically polling for exited children elsewhere.
  */
 class DefaultLauncher : public Launcher {
+private:
+    struct Process {
+        Handle     handle;
+        Completion completion;
+        int        descriptor;
+    };
+
+private:
+    Handle                               _nextHandle;
+    std::unordered_map<pid_t, Process>   _processes;
+    int                                  _queue;
+
 public:
     DefaultLauncher();
     ~DefaultLauncher();
 
 public:
-    virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context);
+    using Launcher::launch;
+    virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage, std::string *output);
+
+public:
+    virtual ext::optional<Handle> start(libutil::Filesystem *filesystem, Context const *context, Completion const &completion);
+    virtual size_t wait(bool block);
+    virtual size_t pending() const;
+
+private:
+    size_t reap();
 };
 
 }
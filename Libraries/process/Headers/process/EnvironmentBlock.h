@@ -0,0 +1,84 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __process_EnvironmentBlock_h
+#define __process_EnvironmentBlock_h
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace process {
+
+/*
+ * Environment variables formatted for a new process, as a null-terminated
+ * array of "NAME=VALUE" strings. Formatting touches every variable, so
+ * processes launched with the same environment can share one block.
+ */
+class EnvironmentBlock {
+public:
+    /*
+     * Shares blocks between identical environments. Safe to use from
+     * multiple threads.
+     */
+    class Cache {
+    private:
+        std::unordered_multimap<size_t, std::shared_ptr<EnvironmentBlock const>> _blocks;
+        std::mutex                                                                _mutex;
+
+    public:
+        Cache();
+
+    public:
+        /*
+         * The block for an environment, formatting it only if no block
+         * for the same variables was requested before.
+         */
+        std::shared_ptr<EnvironmentBlock const>
+        block(std::unordered_map<std::string, std::string> const &variables);
+    };
+
+private:
+    std::unordered_map<std::string, std::string> _variables;
+    std::vector<std::string>                     _entries;
+    std::vector<char const *>                    _pointers;
+
+public:
+    explicit EnvironmentBlock(std::unordered_map<std::string, std::string> const &variables);
+
+    /* The pointers refer to the entries, so blocks are not copied. */
+    EnvironmentBlock(EnvironmentBlock const &) = delete;
+    EnvironmentBlock &operator=(EnvironmentBlock const &) = delete;
+
+public:
+    /*
+     * The variables in the block.
+     */
+    std::unordered_map<std::string, std::string> const &variables() const
+    { return _variables; }
+
+    /*
+     * The block, to pass to a new process.
+     */
+    char *const *data() const
+    { return const_cast<char *const *>(_pointers.data()); }
+
+public:
+    /*
+     * A hash of a set of variables, independent of their order.
+     */
+    static size_t
+    Hash(std::unordered_map<std::string, std::string> const &variables);
+};
+
+}
+
+#endif  // !__process_EnvironmentBlock_h
@@ -11,8 +11,13 @@
 #define __process_Launcher_h
 
 #include <process/Context.h>
+#include <process/ResourceUsage.h>
 
+#include <functional>
 #include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; }
@@ -23,6 +28,21 @@ namespace process {
  * Abstract process launcher.
  */
 class Launcher {
+public:
+    /*
+     * Identifies a process started with `start()`.
+     */
+    using Handle = uint64_t;
+
+    /*
+     * Called once a started process exits, with its exit code.
+     */
+    using Completion = std::function<void(Handle handle, ext::optional<int> exitCode)>;
+
+private:
+    Handle _nextHandle;
+    std::vector<std::tuple<Handle, Completion, ext::optional<int>>> _completed;
+
 protected:
     Launcher();
     ~Launcher();
@@ -32,7 +52,50 @@ public:
      * Launch and wait for a process. The filesystem is symbolic, to note
      * that launching a process could arbitrarily affect the filesystem.
      */
-    virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context) = 0;
+    ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context)
+    { return launch(filesystem, context, nullptr); }
+
+    /*
+     * Launch and wait for a process, and measure the resources it used.
+     * The usage is left unset if the launcher can't measure it.
+     */
+    ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage)
+    { return launch(filesystem, context, usage, nullptr); }
+
+    /*
+     * Launch and wait for a process. If `output` is set, the process's
+     * standard output and error are collected into it, in the order they
+     * were written, rather than shared with this process. Collection ends
+     * when nothing holds the output open, so background processes that
+     * keep it open delay the launch returning until they exit.
+     */
+    virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage, std::string *output) = 0;
+
+public:
+    /*
+     * Start a process without waiting for it to exit. The completion is
+     * called from `wait()` after the process exits. Returns the handle for
+     * the process, or nothing if it could not be started.
+     *
+     * Starting and waiting for processes is not thread safe; use a single
+     * thread to supervise all started processes.
+     *
+     * The default implementation runs the process to completion with
+     * `launch()`, then delivers the completion from the next `wait()`.
+     */
+    virtual ext::optional<Handle> start(libutil::Filesystem *filesystem, Context const *context, Completion const &completion);
+
+    /*
+     * Delivers completions for started processes that have exited. If
+     * `block` is set and processes are pending, waits for at least one
+     * to exit. Returns the number of completions delivered.
+     */
+    virtual size_t wait(bool block);
+
+    /*
+     * The number of started processes with undelivered completions.
+     */
+    virtual size_t pending() const;
 };
 
 }
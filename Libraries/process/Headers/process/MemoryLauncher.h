@@ -32,7 +32,8 @@ public:
     ~MemoryLauncher();
 
 public:
-    virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context);
+    using Launcher::launch;
+    virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage, std::string *output);
 };
 
 }
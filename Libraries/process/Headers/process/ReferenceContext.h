@@ -0,0 +1,75 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __process_ReferenceContext_h
+#define __process_ReferenceContext_h
+
+#include <process/Context.h>
+
+namespace process {
+
+/*
+ * A process context referring to arguments and environment variables kept
+ * elsewhere, rather than copying them as a memory context does. They must
+ * outlive the context.
+ */
+class ReferenceContext : public Context {
+private:
+    std::string                                         _executablePath;
+    std::string const                                  &_currentDirectory;
+    std::vector<std::string> const                     &_commandLineArguments;
+    std::unordered_map<std::string, std::string> const &_environmentVariables;
+    std::shared_ptr<EnvironmentBlock const>             _environmentBlock;
+
+private:
+    Context const                                      *_user;
+
+public:
+    /*
+     * The user and group come from another context. The environment block,
+     * if any, must hold the same variables; otherwise one is formatted for
+     * each launch.
+     */
+    ReferenceContext(
+        std::string const &executablePath,
+        std::string const &currentDirectory,
+        std::vector<std::string> const &commandLineArguments,
+        std::unordered_map<std::string, std::string> const &environmentVariables,
+        std::shared_ptr<EnvironmentBlock const> const &environmentBlock,
+        Context const *user);
+    virtual ~ReferenceContext();
+
+public:
+    virtual std::string const &executablePath() const
+    { return _executablePath; }
+    virtual std::string const &currentDirectory() const
+    { return _currentDirectory; }
+
+public:
+    virtual std::vector<std::string> const &commandLineArguments() const
+    { return _commandLineArguments; }
+    virtual std::unordered_map<std::string, std::string> const &environmentVariables() const
+    { return _environmentVariables; }
+    virtual ext::optional<std::string> environmentVariable(std::string const &variable) const;
+    virtual std::shared_ptr<EnvironmentBlock const> environmentBlock() const;
+
+public:
+    virtual int32_t userID() const
+    { return _user->userID(); }
+    virtual int32_t groupID() const
+    { return _user->groupID(); }
+    virtual std::string const &userName() const
+    { return _user->userName(); }
+    virtual std::string const &groupName() const
+    { return _user->groupName(); }
+};
+
+}
+
+#endif  // !__process_ReferenceContext_h
@@ -0,0 +1,61 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __process_ResourceUsage_h
+#define __process_ResourceUsage_h
+
+#include <cstdint>
+
+namespace process {
+
+/*
+ * The resources used by a process that has exited.
+ */
+class ResourceUsage {
+private:
+    int64_t _userTime;
+    int64_t _systemTime;
+    int64_t _maximumResidentSetSize;
+    int64_t _blockInputs;
+    int64_t _blockOutputs;
+
+public:
+    ResourceUsage(int64_t userTime, int64_t systemTime, int64_t maximumResidentSetSize, int64_t blockInputs, int64_t blockOutputs);
+
+public:
+    /*
+     * CPU time spent in the process, in microseconds.
+     */
+    int64_t userTime() const
+    { return _userTime; }
+
+    /*
+     * CPU time spent in the kernel for the process, in microseconds.
+     */
+    int64_t systemTime() const
+    { return _systemTime; }
+
+    /*
+     * The most memory resident at once, in bytes.
+     */
+    int64_t maximumResidentSetSize() const
+    { return _maximumResidentSetSize; }
+
+    /*
+     * Block input and output operations.
+     */
+    int64_t blockInputs() const
+    { return _blockInputs; }
+    int64_t blockOutputs() const
+    { return _blockOutputs; }
+};
+
+}
+
+#endif  // !__process_ResourceUsage_h
@@ -0,0 +1,108 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __process_SimulatedLauncher_h
+#define __process_SimulatedLauncher_h
+
+#include <process/Launcher.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <utility>
+
+namespace process {
+
+/*
+ * Simulates processes taking a time and using an amount of memory, without
+ * running anything, to measure how a build schedules its processes.
+ *
+ * Time is simulated: each process finishes a duration after the simulated
+ * time it started, and launches return in the order their processes finish,
+ * advancing the simulated time. The process finishing first only finishes
+ * once no other process could start before it: no expected launches are
+ * still to come, and either `slots` processes are running or nothing has
+ * started or finished for the settle time. Callers must launch the processes
+ * that can start within that time of another finishing, which in-memory
+ * builds do in much less than a millisecond, or expect them beforehand.
+ *
+ * Launches can come from any number of threads.
+ */
+class SimulatedLauncher : public Launcher {
+public:
+    /*
+     * A simulated process: how long it takes in microseconds, the most
+     * memory it uses in bytes, and its exit code.
+     */
+    struct Process {
+        int64_t duration;
+        int64_t memory;
+        int     exitCode;
+    };
+
+    /*
+     * Finds the process to simulate for a launch, or nothing if the launch
+     * should fail.
+     */
+    using Simulate = std::function<ext::optional<Process>(Context const *context)>;
+
+private:
+    Simulate                                  _simulate;
+    size_t                                    _slots;
+    std::chrono::microseconds                 _settle;
+
+private:
+    mutable std::mutex                        _mutex;
+    std::condition_variable                   _condition;
+    std::set<std::pair<int64_t, uint64_t>>    _running;
+    std::chrono::steady_clock::time_point     _changed;
+    uint64_t                                  _next;
+    size_t                                    _expected;
+    int64_t                                   _time;
+    int64_t                                   _memory;
+    int64_t                                   _peakMemory;
+    size_t                                    _peakRunning;
+
+public:
+    SimulatedLauncher(Simulate const &simulate, size_t slots, std::chrono::microseconds settle = std::chrono::milliseconds(2));
+    ~SimulatedLauncher();
+
+public:
+    using Launcher::launch;
+    virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage, std::string *output);
+
+public:
+    /*
+     * Keep processes from finishing until this many more launches have
+     * started, for callers that know which launches are coming regardless
+     * of how long their threads take to get there.
+     */
+    void expect(size_t launches);
+
+public:
+    /*
+     * The simulated time, in microseconds, when the last process finished.
+     */
+    int64_t time() const;
+
+    /*
+     * The most memory used by processes running at once, in bytes.
+     */
+    int64_t peakMemory() const;
+
+    /*
+     * The most processes running at once.
+     */
+    size_t peakRunning() const;
+};
+
+}
+
+#endif  // !__process_SimulatedLauncher_h
@@ -8,11 +8,13 @@
  */
 
 #include <process/Context.h>
+#include <process/EnvironmentBlock.h>
 
 #include <sstream>
 #include <unordered_set>
 
 using process::Context;
+using process::EnvironmentBlock;
 
 Context::
 Context()
@@ -24,6 +26,12 @@ Context::
 {
 }
 
+std::shared_ptr<process::EnvironmentBlock const> Context::
+environmentBlock() const
+{
+    return std::make_shared<EnvironmentBlock const>(environmentVariables());
+}
+
 std::vector<std::string> Context::
 executableSearchPaths() const
 {
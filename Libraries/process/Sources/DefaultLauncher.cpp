@@ -8,27 +8,104 @@
  */
 
 #include <process/DefaultLauncher.h>
+#include <process/EnvironmentBlock.h>
 #include <libutil/Filesystem.h>
 
+#include <cerrno>
+#include <csignal>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#if defined(__APPLE__)
+#include <Availability.h>
+#include <sys/event.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/syscall.h>
+#endif
+
+/*
+ * Changing directory in a spawned process needs a non-standard extension.
+ */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define HAVE_POSIX_SPAWN_CHDIR 1
+#elif defined(__APPLE__) && defined(__MAC_10_15) && __MAC_OS_X_VERSION_MIN_REQUIRED >= __MAC_10_15
+#define HAVE_POSIX_SPAWN_CHDIR 1
+#endif
+
 using process::DefaultLauncher;
 using libutil::Filesystem;
 
 DefaultLauncher::
 DefaultLauncher() :
-    Launcher()
+    Launcher   (),
+    _nextHandle(0),
+    _queue     (-1)
 {
 }
 
 DefaultLauncher::
 ~DefaultLauncher()
 {
+    for (auto const &entry : _processes) {
+        if (entry.second.descriptor != -1) {
+            ::close(entry.second.descriptor);
+        }
+    }
+
+    if (_queue != -1) {
+        ::close(_queue);
+    }
 }
 
-ext::optional<int> DefaultLauncher::
-launch(Filesystem *filesystem, Context const *context)
+/*
+ * Open a pipe for collecting output. Both ends are closed on exec, so other
+ * processes started meanwhile don't hold it open; the spawned process gets
+ * its own copies.
+ */
+static bool
+OpenPipe(int descriptors[2])
+{
+#if defined(__linux__)
+    return ::pipe2(descriptors, O_CLOEXEC) == 0;
+#else
+    if (::pipe(descriptors) != 0) {
+        return false;
+    }
+
+    ::fcntl(descriptors[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(descriptors[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+/*
+ * Read everything written to a pipe until every writer has closed it.
+ */
+static void
+ReadPipe(int descriptor, std::string *output)
+{
+    char buffer[16384];
+    while (true) {
+        ssize_t size = ::read(descriptor, buffer, sizeof(buffer));
+        if (size > 0) {
+            output->append(buffer, static_cast<size_t>(size));
+        } else if (size == 0 || errno != EINTR) {
+            break;
+        }
+    }
+}
+
+/*
+ * Spawn a process for a context. If `output` is a descriptor, the process
+ * writes its standard output and error to it.
+ */
+static ext::optional<pid_t>
+Spawn(Filesystem *filesystem, process::Context const *context, int output)
 {
     /*
      * Extract input data for exec, so no C++ is required after fork.
@@ -43,10 +120,11 @@ launch(Filesystem *filesystem, Context const *context)
     char const *cDirectory = directory.c_str();
 
     /* Compute command-line arguments. */
+    std::vector<std::string> const &arguments = context->commandLineArguments();
     std::vector<char const *> execArgs;
+    execArgs.reserve(arguments.size() + 2);
     execArgs.push_back(cPath);
 
-    std::vector<std::string> arguments = context->commandLineArguments();
     for (std::string const &argument : arguments) {
         execArgs.push_back(argument.c_str());
     }
@@ -54,23 +132,65 @@ launch(Filesystem *filesystem, Context const *context)
     execArgs.push_back(nullptr);
     char *const *cExecArgs = const_cast<char *const *>(execArgs.data());
 
-    /* Compute environment variables. */
-    std::vector<std::string> envValues;
-    for (auto const &value : context->environmentVariables()) {
-        envValues.push_back(value.first + "=" + value.second);
-    }
-
-    std::vector<char const *> execEnv;
-    for (auto const &value : envValues) {
-        execEnv.push_back(value.c_str());
-    }
-    execEnv.push_back(nullptr);
-    char *const *cExecEnv = const_cast<char *const *>(execEnv.data());
+    /* Environment variables, formatted once and shared if the context can. */
+    std::shared_ptr<process::EnvironmentBlock const> environmentBlock = context->environmentBlock();
+    char *const *cExecEnv = environmentBlock->data();
 
     /* Compute user. */
     uid_t uid = context->userID();
     gid_t gid = context->groupID();
 
+#if HAVE_POSIX_SPAWN_CHDIR
+    /*
+     * Spawn new process. This avoids copying the page tables of this process
+     * as fork does, but can't change users. Use it when that isn't needed.
+     */
+    if (uid == ::getuid() && uid == ::geteuid() && gid == ::getgid() && gid == ::getegid()) {
+        posix_spawn_file_actions_t actions;
+        if (::posix_spawn_file_actions_init(&actions) != 0) {
+            return ext::nullopt;
+        }
+
+        if (::posix_spawn_file_actions_addchdir_np(&actions, cDirectory) != 0) {
+            ::posix_spawn_file_actions_destroy(&actions);
+            return ext::nullopt;
+        }
+
+        if (output != -1) {
+            if (::posix_spawn_file_actions_adddup2(&actions, output, STDOUT_FILENO) != 0 ||
+                ::posix_spawn_file_actions_adddup2(&actions, output, STDERR_FILENO) != 0) {
+                ::posix_spawn_file_actions_destroy(&actions);
+                return ext::nullopt;
+            }
+        }
+
+        /* Launched tools expect the default SIGPIPE, even if this process ignores it. */
+        posix_spawnattr_t attributes;
+        if (::posix_spawnattr_init(&attributes) != 0) {
+            ::posix_spawn_file_actions_destroy(&actions);
+            return ext::nullopt;
+        }
+
+        sigset_t defaultSignals;
+        sigemptyset(&defaultSignals);
+        sigaddset(&defaultSignals, SIGPIPE);
+        ::posix_spawnattr_setsigdefault(&attributes, &defaultSignals);
+        ::posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF);
+
+        pid_t pid;
+        int error = ::posix_spawn(&pid, cPath, &actions, &attributes, cExecArgs, cExecEnv);
+        ::posix_spawnattr_destroy(&attributes);
+        ::posix_spawn_file_actions_destroy(&actions);
+
+        if (error != 0) {
+            /* Spawn failed. */
+            return ext::nullopt;
+        }
+
+        return pid;
+    }
+#endif
+
     /*
      * Fork new process.
      */
@@ -80,29 +200,213 @@ launch(Filesystem *filesystem, Context const *context)
         return ext::nullopt;
     } else if (pid == 0) {
         /* Fork succeeded, new process. */
+        if (output != -1) {
+            if (::dup2(output, STDOUT_FILENO) == -1 || ::dup2(output, STDERR_FILENO) == -1) {
+                ::_exit(1);
+            }
+        }
+
         if (::chdir(cDirectory) == -1) {
             ::perror("chdir");
             ::_exit(1);
         }
 
-        if (::setuid(uid) == -1) {
-            ::perror("setuid");
-            ::_exit(1);
-        }
+        ::signal(SIGPIPE, SIG_DFL);
 
+        /* Change group first, as changing user can drop the permission to. */
         if (::setgid(gid) == -1) {
             ::perror("setgid");
             ::_exit(1);
         }
 
+        if (::setuid(uid) == -1) {
+            ::perror("setuid");
+            ::_exit(1);
+        }
+
         ::execve(cPath, cExecArgs, cExecEnv);
         ::_exit(-1);
 
         return ext::nullopt;
     } else {
         /* Fork succeeded, existing process. */
+        return pid;
+    }
+}
+
+static int64_t
+Microseconds(struct timeval const &time)
+{
+    return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_usec;
+}
+
+ext::optional<int> DefaultLauncher::
+launch(Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage, std::string *output)
+{
+    int descriptors[2] = { -1, -1 };
+    if (output != nullptr && !OpenPipe(descriptors)) {
+        return ext::nullopt;
+    }
+
+    ext::optional<pid_t> pid = Spawn(filesystem, context, descriptors[1]);
+
+    /* Only the process writes to the pipe, so the read sees it close. */
+    if (descriptors[1] != -1) {
+        ::close(descriptors[1]);
+    }
+
+    if (!pid) {
+        if (descriptors[0] != -1) {
+            ::close(descriptors[0]);
+        }
+        return ext::nullopt;
+    }
+
+    /* Read before waiting, so the process doesn't block on a full pipe. */
+    if (descriptors[0] != -1) {
+        ReadPipe(descriptors[0], output);
+        ::close(descriptors[0]);
+    }
+
+    /* Waiting with wait4 also reports the resources used by just this child. */
+    int status;
+    struct rusage rusage;
+    while (::wait4(*pid, &status, 0, &rusage) == -1) {
+        if (errno != EINTR) {
+            return ext::nullopt;
+        }
+    }
+
+    if (usage != nullptr) {
+#if defined(__APPLE__)
+        /* Reported in bytes rather than kilobytes. */
+        int64_t maximumResidentSetSize = rusage.ru_maxrss;
+#else
+        int64_t maximumResidentSetSize = static_cast<int64_t>(rusage.ru_maxrss) * 1024;
+#endif
+
+        *usage = ResourceUsage(
+            Microseconds(rusage.ru_utime),
+            Microseconds(rusage.ru_stime),
+            maximumResidentSetSize,
+            rusage.ru_inblock,
+            rusage.ru_oublock);
+    }
+
+    return WEXITSTATUS(status);
+}
+
+ext::optional<DefaultLauncher::Handle> DefaultLauncher::
+start(Filesystem *filesystem, Context const *context, Completion const &completion)
+{
+    ext::optional<pid_t> pid = Spawn(filesystem, context, -1);
+    if (!pid) {
+        return ext::nullopt;
+    }
+
+    /*
+     * Register for a notification when the process exits. If that fails, the
+     * process is still found by polling. A process exiting before it's been
+     * registered is found by the sweep for exited processes in `wait()`.
+     */
+    int descriptor = -1;
+#if defined(__APPLE__)
+    if (_queue == -1) {
+        _queue = ::kqueue();
+    }
+
+    if (_queue != -1) {
+        struct kevent event;
+        EV_SET(&event, *pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr);
+        ::kevent(_queue, &event, 1, nullptr, 0, nullptr);
+    }
+#elif defined(__linux__) && defined(SYS_pidfd_open)
+    descriptor = static_cast<int>(::syscall(SYS_pidfd_open, *pid, 0));
+#endif
+
+    Handle handle = _nextHandle++;
+    _processes.insert({ *pid, { handle, completion, descriptor } });
+    return handle;
+}
+
+size_t DefaultLauncher::
+reap()
+{
+    std::vector<std::tuple<Handle, Completion, ext::optional<int>>> completed;
+
+    for (auto it = _processes.begin(); it != _processes.end();) {
         int status;
-        ::waitpid(pid, &status, 0);
-        return WEXITSTATUS(status);
+        pid_t result = ::waitpid(it->first, &status, WNOHANG);
+        if (result == 0 || (result == -1 && errno == EINTR)) {
+            ++it;
+            continue;
+        }
+
+        /* Either exited, or can no longer be waited on. */
+        ext::optional<int> exitCode;
+        if (result == it->first) {
+            exitCode = WEXITSTATUS(status);
+        }
+
+        if (it->second.descriptor != -1) {
+            ::close(it->second.descriptor);
+        }
+
+        completed.push_back(std::make_tuple(it->second.handle, it->second.completion, exitCode));
+        it = _processes.erase(it);
+    }
+
+    /* Completions can start more processes, so deliver after the sweep. */
+    for (auto const &entry : completed) {
+        std::get<1>(entry)(std::get<0>(entry), std::get<2>(entry));
     }
+
+    return completed.size();
+}
+
+size_t DefaultLauncher::
+wait(bool block)
+{
+    /* Processes run to completion with the default implementation. */
+    size_t delivered = Launcher::wait(false);
+
+    while (true) {
+        delivered += reap();
+        if (delivered > 0 || !block || _processes.empty()) {
+            return delivered;
+        }
+
+        /*
+         * Block until a process exits. When not notified of every process
+         * exiting, poll periodically instead.
+         */
+#if defined(__APPLE__)
+        if (_queue != -1) {
+            struct kevent event;
+            ::kevent(_queue, nullptr, 0, &event, 1, nullptr);
+        } else {
+            ::usleep(10000);
+        }
+#elif defined(__linux__) && defined(SYS_pidfd_open)
+        std::vector<struct pollfd> descriptors;
+        bool complete = true;
+        for (auto const &entry : _processes) {
+            if (entry.second.descriptor != -1) {
+                descriptors.push_back({ entry.second.descriptor, POLLIN, 0 });
+            } else {
+                complete = false;
+            }
+        }
+
+        ::poll(descriptors.data(), descriptors.size(), complete ? -1 : 10);
+#else
+        ::usleep(10000);
+#endif
+    }
+}
+
+size_t DefaultLauncher::
+pending() const
+{
+    return Launcher::pending() + _processes.size();
 }
@@ -0,0 +1,65 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <process/EnvironmentBlock.h>
+
+using process::EnvironmentBlock;
+
+EnvironmentBlock::
+EnvironmentBlock(std::unordered_map<std::string, std::string> const &variables) :
+    _variables(variables)
+{
+    _entries.reserve(_variables.size());
+    for (auto const &variable : _variables) {
+        _entries.push_back(variable.first + "=" + variable.second);
+    }
+
+    /* Only once all entries are in place, as adding them can move them. */
+    _pointers.reserve(_entries.size() + 1);
+    for (std::string const &entry : _entries) {
+        _pointers.push_back(entry.c_str());
+    }
+    _pointers.push_back(nullptr);
+}
+
+size_t EnvironmentBlock::
+Hash(std::unordered_map<std::string, std::string> const &variables)
+{
+    /* Summed, as equal maps can list their variables in different orders. */
+    std::hash<std::string> hash;
+    size_t result = variables.size();
+    for (auto const &variable : variables) {
+        result += hash(variable.first) * 31 + hash(variable.second);
+    }
+    return result;
+}
+
+EnvironmentBlock::Cache::
+Cache()
+{
+}
+
+std::shared_ptr<EnvironmentBlock const> EnvironmentBlock::Cache::
+block(std::unordered_map<std::string, std::string> const &variables)
+{
+    size_t hash = EnvironmentBlock::Hash(variables);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto range = _blocks.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->variables() == variables) {
+            return it->second;
+        }
+    }
+
+    auto block = std::make_shared<EnvironmentBlock const>(variables);
+    _blocks.insert({ hash, block });
+    return block;
+}
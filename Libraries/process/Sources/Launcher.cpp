@@ -12,7 +12,8 @@
 using process::Launcher;
 
 Launcher::
-Launcher()
+Launcher() :
+    _nextHandle(0)
 {
 }
 
@@ -21,3 +22,35 @@ Launcher::
 {
 }
 
+ext::optional<Launcher::Handle> Launcher::
+start(libutil::Filesystem *filesystem, Context const *context, Completion const &completion)
+{
+    ext::optional<int> exitCode = launch(filesystem, context);
+    if (!exitCode) {
+        return ext::nullopt;
+    }
+
+    Handle handle = _nextHandle++;
+    _completed.push_back(std::make_tuple(handle, completion, exitCode));
+    return handle;
+}
+
+size_t Launcher::
+wait(bool block)
+{
+    /* Completions can start more processes, so don't deliver in place. */
+    std::vector<std::tuple<Handle, Completion, ext::optional<int>>> completed;
+    std::swap(completed, _completed);
+
+    for (auto const &entry : completed) {
+        std::get<1>(entry)(std::get<0>(entry), std::get<2>(entry));
+    }
+
+    return completed.size();
+}
+
+size_t Launcher::
+pending() const
+{
+    return _completed.size();
+}
@@ -26,7 +26,7 @@ MemoryLauncher::
 }
 
 ext::optional<int> MemoryLauncher::
-launch(Filesystem *filesystem, Context const *context)
+launch(Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage, std::string *output)
 {
     auto it = _handlers.find(context->executablePath());
     if (it != _handlers.end()) {
@@ -0,0 +1,58 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <process/ReferenceContext.h>
+#include <process/EnvironmentBlock.h>
+
+using process::ReferenceContext;
+using process::EnvironmentBlock;
+
+ReferenceContext::
+ReferenceContext(
+    std::string const &executablePath,
+    std::string const &currentDirectory,
+    std::vector<std::string> const &commandLineArguments,
+    std::unordered_map<std::string, std::string> const &environmentVariables,
+    std::shared_ptr<EnvironmentBlock const> const &environmentBlock,
+    Context const *user) :
+    Context              (),
+    _executablePath      (executablePath),
+    _currentDirectory    (currentDirectory),
+    _commandLineArguments(commandLineArguments),
+    _environmentVariables(environmentVariables),
+    _environmentBlock    (environmentBlock),
+    _user                (user)
+{
+}
+
+ReferenceContext::
+~ReferenceContext()
+{
+}
+
+ext::optional<std::string> ReferenceContext::
+environmentVariable(std::string const &variable) const
+{
+    auto it = _environmentVariables.find(variable);
+    if (it != _environmentVariables.end()) {
+        return it->second;
+    } else {
+        return ext::nullopt;
+    }
+}
+
+std::shared_ptr<EnvironmentBlock const> ReferenceContext::
+environmentBlock() const
+{
+    if (_environmentBlock != nullptr) {
+        return _environmentBlock;
+    }
+
+    return Context::environmentBlock();
+}
@@ -0,0 +1,22 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <process/ResourceUsage.h>
+
+using process::ResourceUsage;
+
+ResourceUsage::
+ResourceUsage(int64_t userTime, int64_t systemTime, int64_t maximumResidentSetSize, int64_t blockInputs, int64_t blockOutputs) :
+    _userTime              (userTime),
+    _systemTime            (systemTime),
+    _maximumResidentSetSize(maximumResidentSetSize),
+    _blockInputs           (blockInputs),
+    _blockOutputs          (blockOutputs)
+{
+}
@@ -0,0 +1,117 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <process/SimulatedLauncher.h>
+
+#include <algorithm>
+
+using process::SimulatedLauncher;
+using libutil::Filesystem;
+
+SimulatedLauncher::
+SimulatedLauncher(Simulate const &simulate, size_t slots, std::chrono::microseconds settle) :
+    Launcher    (),
+    _simulate   (simulate),
+    _slots      (std::max<size_t>(slots, 1)),
+    _settle     (settle),
+    _changed    (std::chrono::steady_clock::now()),
+    _next       (0),
+    _expected   (0),
+    _time       (0),
+    _memory     (0),
+    _peakMemory (0),
+    _peakRunning(0)
+{
+}
+
+SimulatedLauncher::
+~SimulatedLauncher()
+{
+}
+
+ext::optional<int> SimulatedLauncher::
+launch(Filesystem *filesystem, Context const *context, ext::optional<ResourceUsage> *usage, std::string *output)
+{
+    ext::optional<Process> process = _simulate(context);
+    if (!process) {
+        return ext::nullopt;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    /* Processes finishing at the same time finish in the order they started. */
+    std::pair<int64_t, uint64_t> finish = std::make_pair(_time + std::max<int64_t>(process->duration, 0), _next++);
+    _running.insert(finish);
+    if (_expected > 0) {
+        _expected--;
+    }
+    _memory += process->memory;
+    _peakMemory = std::max(_peakMemory, _memory);
+    _peakRunning = std::max(_peakRunning, _running.size());
+    _changed = std::chrono::steady_clock::now();
+    _condition.notify_all();
+
+    while (true) {
+        if (*_running.begin() != finish || _expected > 0) {
+            _condition.wait(lock);
+            continue;
+        }
+
+        if (_running.size() >= _slots) {
+            break;
+        }
+
+        /* Wait to see if anything else starts before this finishes. */
+        std::chrono::steady_clock::time_point settled = _changed + _settle;
+        if (std::chrono::steady_clock::now() >= settled) {
+            break;
+        }
+        _condition.wait_until(lock, settled);
+    }
+
+    _running.erase(finish);
+    _time = finish.first;
+    _memory -= process->memory;
+    _changed = std::chrono::steady_clock::now();
+    _condition.notify_all();
+
+    if (usage != nullptr) {
+        *usage = ResourceUsage(process->duration, 0, process->memory, 0, 0);
+    }
+
+    return process->exitCode;
+}
+
+void SimulatedLauncher::
+expect(size_t launches)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _expected += launches;
+}
+
+int64_t SimulatedLauncher::
+time() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _time;
+}
+
+int64_t SimulatedLauncher::
+peakMemory() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _peakMemory;
+}
+
+size_t SimulatedLauncher::
+peakRunning() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _peakRunning;
+}
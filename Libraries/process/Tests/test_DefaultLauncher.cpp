@@ -0,0 +1,145 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <process/DefaultLauncher.h>
+#include <process/MemoryContext.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <unistd.h>
+
+using process::DefaultLauncher;
+using process::MemoryContext;
+using libutil::DefaultFilesystem;
+
+static MemoryContext
+ShellContext(std::string const &script, std::string const &directory = "/")
+{
+    return MemoryContext(
+        "/bin/sh",
+        directory,
+        { "-c", script },
+        std::unordered_map<std::string, std::string>(),
+        ::getuid(),
+        ::getgid(),
+        "user",
+        "group");
+}
+
+TEST(DefaultLauncher, Launch)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    MemoryContext success = ShellContext("exit 0");
+    EXPECT_EQ(0, launcher.launch(&filesystem, &success));
+
+    MemoryContext failure = ShellContext("exit 3");
+    EXPECT_EQ(3, launcher.launch(&filesystem, &failure));
+}
+
+TEST(DefaultLauncher, Environment)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    /* Runs in the requested directory. */
+    MemoryContext directory = ShellContext("test \"$(pwd -P)\" = \"$(cd /tmp && pwd -P)\"", "/tmp");
+    EXPECT_EQ(0, launcher.launch(&filesystem, &directory));
+
+    /* Only the requested environment is passed. */
+    MemoryContext environment = ShellContext("test \"$VARIABLE\" = value && test -z \"$HOME\"");
+    environment.environmentVariables() = { { "VARIABLE", "value" } };
+    EXPECT_EQ(0, launcher.launch(&filesystem, &environment));
+}
+
+TEST(DefaultLauncher, Output)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    /* Both streams are collected, in the order written. */
+    MemoryContext context = ShellContext("echo one; echo two >&2; echo three");
+    std::string output;
+    EXPECT_EQ(0, launcher.launch(&filesystem, &context, nullptr, &output));
+    EXPECT_EQ("one\ntwo\nthree\n", output);
+
+    /* More than fits in a pipe's buffer at once. */
+    MemoryContext large = ShellContext("i=0; while [ $i -lt 20000 ]; do echo 0123456789; i=$((i + 1)); done; exit 2");
+    output.clear();
+    EXPECT_EQ(2, launcher.launch(&filesystem, &large, nullptr, &output));
+    EXPECT_EQ(20000 * 11, output.size());
+}
+
+TEST(DefaultLauncher, ResourceUsage)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    /* Spins long enough to be measured. */
+    MemoryContext busy = ShellContext("i=0; while [ $i -lt 20000 ]; do i=$((i + 1)); done");
+    ext::optional<process::ResourceUsage> usage;
+    EXPECT_EQ(0, launcher.launch(&filesystem, &busy, &usage));
+    ASSERT_TRUE(usage);
+    EXPECT_GT(usage->userTime() + usage->systemTime(), 0);
+    EXPECT_GT(usage->maximumResidentSetSize(), 0);
+    EXPECT_GE(usage->blockInputs(), 0);
+    EXPECT_GE(usage->blockOutputs(), 0);
+}
+
+TEST(DefaultLauncher, Start)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    std::unordered_map<DefaultLauncher::Handle, ext::optional<int>> exitCodes;
+    auto completion = [&](DefaultLauncher::Handle handle, ext::optional<int> exitCode) {
+        exitCodes.insert({ handle, exitCode });
+    };
+
+    /* Start several processes at once, finishing in reverse order. */
+    std::vector<DefaultLauncher::Handle> handles;
+    for (int index = 0; index < 4; ++index) {
+        MemoryContext context = ShellContext("sleep 0." + std::to_string(4 - index) + "; exit " + std::to_string(index));
+        ext::optional<DefaultLauncher::Handle> handle = launcher.start(&filesystem, &context, completion);
+        ASSERT_TRUE(handle);
+        handles.push_back(*handle);
+    }
+    EXPECT_EQ(4, launcher.pending());
+
+    while (launcher.pending() > 0) {
+        EXPECT_LT(0, launcher.wait(true));
+    }
+
+    ASSERT_EQ(4, exitCodes.size());
+    for (int index = 0; index < 4; ++index) {
+        EXPECT_EQ(index, exitCodes[handles[index]]);
+    }
+
+    /* Nothing to wait for. */
+    EXPECT_EQ(0, launcher.wait(true));
+}
+
+TEST(DefaultLauncher, StartMissing)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    MemoryContext context = MemoryContext(
+        "/nonexistent/executable",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        ::getuid(),
+        ::getgid(),
+        "user",
+        "group");
+    EXPECT_FALSE(launcher.start(&filesystem, &context, [](DefaultLauncher::Handle handle, ext::optional<int> exitCode) { }));
+    EXPECT_EQ(0, launcher.pending());
+}
@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <process/EnvironmentBlock.h>
+#include <process/ReferenceContext.h>
+#include <process/MemoryContext.h>
+
+#include <algorithm>
+
+using process::EnvironmentBlock;
+using process::ReferenceContext;
+using process::MemoryContext;
+
+static std::vector<std::string>
+Entries(EnvironmentBlock const &block)
+{
+    std::vector<std::string> entries;
+    for (char *const *entry = block.data(); *entry != nullptr; ++entry) {
+        entries.push_back(*entry);
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+TEST(EnvironmentBlock, Format)
+{
+    EnvironmentBlock block({ { "A", "1" }, { "B", "" } });
+    EXPECT_EQ(std::vector<std::string>({ "A=1", "B=" }), Entries(block));
+
+    EnvironmentBlock empty({ });
+    EXPECT_TRUE(Entries(empty).empty());
+}
+
+TEST(EnvironmentBlock, Cache)
+{
+    EnvironmentBlock::Cache cache;
+
+    /* Equal environments share a block. */
+    auto first = cache.block({ { "A", "1" }, { "B", "2" } });
+    auto second = cache.block({ { "B", "2" }, { "A", "1" } });
+    EXPECT_EQ(first, second);
+
+    auto different = cache.block({ { "A", "1" }, { "B", "3" } });
+    EXPECT_NE(first, different);
+    EXPECT_EQ(std::vector<std::string>({ "A=1", "B=3" }), Entries(*different));
+}
+
+TEST(EnvironmentBlock, ReferenceContext)
+{
+    MemoryContext user = MemoryContext("/user", "/", { }, { }, 1, 2, "user", "group");
+
+    std::string directory = "/directory";
+    std::vector<std::string> arguments = { "-c" };
+    std::unordered_map<std::string, std::string> variables = { { "A", "1" } };
+    ReferenceContext context = ReferenceContext("/bin/sh", directory, arguments, variables, nullptr, &user);
+
+    /* Changes to the referenced values are seen. */
+    arguments.push_back("true");
+    variables["B"] = "2";
+    EXPECT_EQ(std::vector<std::string>({ "-c", "true" }), context.commandLineArguments());
+    EXPECT_EQ(std::string("2"), context.environmentVariable("B"));
+    EXPECT_EQ(std::vector<std::string>({ "A=1", "B=2" }), Entries(*context.environmentBlock()));
+
+    EXPECT_EQ(1, context.userID());
+    EXPECT_EQ("group", context.groupName());
+}
@@ -0,0 +1,63 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <process/MemoryLauncher.h>
+#include <process/MemoryContext.h>
+#include <libutil/MemoryFilesystem.h>
+
+using process::MemoryLauncher;
+using process::MemoryContext;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+TEST(MemoryLauncher, Start)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    MemoryLauncher launcher = MemoryLauncher({
+        { "/tool", [](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            return static_cast<int>(context->commandLineArguments().size());
+        } },
+    });
+
+    MemoryContext context = MemoryContext(
+        "/tool",
+        "/",
+        { "one", "two" },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /* Completions are only delivered when waiting. */
+    ext::optional<int> result;
+    ext::optional<MemoryLauncher::Handle> handle = launcher.start(&filesystem, &context, [&](MemoryLauncher::Handle handle, ext::optional<int> exitCode) {
+        result = exitCode;
+    });
+    ASSERT_TRUE(handle);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(1, launcher.pending());
+
+    EXPECT_EQ(1, launcher.wait(true));
+    EXPECT_EQ(2, result);
+    EXPECT_EQ(0, launcher.pending());
+
+    /* Unknown tools fail to start. */
+    MemoryContext unknown = MemoryContext(
+        "/unknown",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+    EXPECT_FALSE(launcher.start(&filesystem, &unknown, [](MemoryLauncher::Handle handle, ext::optional<int> exitCode) { }));
+}
@@ -0,0 +1,104 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <process/SimulatedLauncher.h>
+#include <process/MemoryContext.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <thread>
+
+using process::SimulatedLauncher;
+using process::MemoryContext;
+using libutil::MemoryFilesystem;
+
+static MemoryContext
+Context(std::string const &executable, std::string const &name)
+{
+    return MemoryContext(
+        executable,
+        "/",
+        { name },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+}
+
+static SimulatedLauncher::Simulate
+Simulate()
+{
+    return [](process::Context const *context) -> ext::optional<SimulatedLauncher::Process> {
+        if (context->executablePath() != "/tool") {
+            return ext::nullopt;
+        }
+
+        std::string const &name = context->commandLineArguments().front();
+        if (name == "short") {
+            return SimulatedLauncher::Process { 1000, 100, 0 };
+        } else if (name == "long") {
+            return SimulatedLauncher::Process { 5000, 300, 0 };
+        } else {
+            return SimulatedLauncher::Process { 2000, 200, 1 };
+        }
+    };
+}
+
+TEST(SimulatedLauncher, Launch)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    SimulatedLauncher launcher(Simulate(), 1);
+
+    MemoryContext failing = Context("/tool", "failing");
+    ext::optional<process::ResourceUsage> usage;
+    EXPECT_EQ(1, launcher.launch(&filesystem, &failing, &usage));
+    ASSERT_TRUE(usage);
+    EXPECT_EQ(2000, usage->userTime());
+    EXPECT_EQ(200, usage->maximumResidentSetSize());
+
+    /* Run one at a time, each starts when the last finished. */
+    MemoryContext shorter = Context("/tool", "short");
+    EXPECT_EQ(0, launcher.launch(&filesystem, &shorter));
+    EXPECT_EQ(3000, launcher.time());
+    EXPECT_EQ(200, launcher.peakMemory());
+
+    /* Unknown processes fail to launch. */
+    MemoryContext unknown = Context("/unknown", "short");
+    EXPECT_FALSE(launcher.launch(&filesystem, &unknown));
+    EXPECT_EQ(3000, launcher.time());
+}
+
+TEST(SimulatedLauncher, Parallel)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    SimulatedLauncher launcher(Simulate(), 2);
+
+    /* The shorter process finishes first, while the longer is still running. */
+    launcher.expect(2);
+    std::vector<std::string> finished;
+    std::mutex mutex;
+    auto run = [&](std::string const &name) {
+        MemoryContext context = Context("/tool", name);
+        launcher.launch(&filesystem, &context);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(name);
+    };
+
+    std::thread first = std::thread(run, "long");
+    std::thread second = std::thread(run, "short");
+    first.join();
+    second.join();
+
+    EXPECT_EQ(std::vector<std::string>({ "short", "long" }), finished);
+    EXPECT_EQ(5000, launcher.time());
+    EXPECT_EQ(2, launcher.peakRunning());
+    EXPECT_EQ(400, launcher.peakMemory());
+}
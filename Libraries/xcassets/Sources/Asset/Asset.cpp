@@ -38,11 +38,13 @@
 #include <plist/Integer.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 
 using xcassets::Asset::Asset;
 using xcassets::FullyQualifiedName;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 Asset::
 Asset(FullyQualifiedName const &name, std::string const &path) :
@@ -260,35 +262,35 @@ LoadContents(Filesystem const *filesystem, std::string const &path, std::unique_
     std::string contentsPath = path + "/" + "Contents.json";
 
     /*
-     * Check if the contents file exists. Not existing is valid for some asset types.
+     * Read in the contents file. Catalogs have many small contents files,
+     * so each thread reads them all into the same buffer.
      */
-    if (filesystem->isReadable(contentsPath)) {
+    static thread_local std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, contentsPath)) {
         /*
-         * Read in the contents file.
+         * Only check if the contents file exists when it can't be read, as
+         * most assets have one. Not existing is valid for some asset types.
          */
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, contentsPath)) {
-            return false;
-        }
-
-        /*
-         * If the Contents.json file exists, it must be JSON.
-         */
-        auto deserialized = plist::Format::JSON::Deserialize(contents, plist::Format::JSON::Create());
-        if (!deserialized.first) {
-            return false;
-        }
+        return !filesystem->isReadable(contentsPath);
+    }
 
-        /*
-         * If the Contents.json file exists, it must be a dictionary.
-         */
-        if (deserialized.first->type() != plist::Dictionary::Type()) {
-            return false;
-        }
+    /*
+     * If the Contents.json file exists, it must be JSON.
+     */
+    auto deserialized = plist::Format::JSON::Deserialize(contents, plist::Format::JSON::Create());
+    if (!deserialized.first) {
+        return false;
+    }
 
-        *contentsDictionary = plist::static_unique_pointer_cast<plist::Dictionary>(std::move(deserialized.first));
+    /*
+     * If the Contents.json file exists, it must be a dictionary.
+     */
+    if (deserialized.first->type() != plist::Dictionary::Type()) {
+        return false;
     }
 
+    *contentsDictionary = plist::static_unique_pointer_cast<plist::Dictionary>(std::move(deserialized.first));
+
     return true;
 }
 
@@ -297,26 +299,40 @@ LoadChildren(Filesystem const *filesystem, std::string const &path, FullyQualifi
 {
     bool error = false;
 
-    filesystem->readDirectory(path, false, [&](std::string const &fileName) -> void {
-        std::string child = path + "/" + fileName;
+    std::vector<std::string> groups = name.groups();
+    if (providesNamespace) {
+        // TODO: Should fully qualified names include extensions?
+        groups.push_back(name.name());
+    }
 
-        if (filesystem->type(child) == Filesystem::Type::Directory) {
-            std::vector<std::string> groups = name.groups();
-            if (providesNamespace) {
-                // TODO: Should fully qualified names include extensions?
-                groups.push_back(name.name());
-            }
+    /*
+     * Only directories are assets; the type comes from the directory listing.
+     */
+    std::vector<std::string> paths;
+    filesystem->readDirectory(path, false, [&](std::string const &fileName, ext::optional<Filesystem::Type> type) -> void {
+        if (type == Filesystem::Type::Directory) {
+            paths.push_back(path + "/" + fileName);
+        }
+    });
 
-            std::unique_ptr<Asset> asset = Asset::Load(filesystem, child, groups);
-            if (asset == nullptr) {
-                fprintf(stderr, "error: failed to load asset: %s\n", child.c_str());
-                error = true;
-                return;
-            }
+    /*
+     * Load the children concurrently, including reading and parsing their
+     * contents. Each child is stored in its own slot to keep the order.
+     */
+    std::vector<std::unique_ptr<Asset>> loaded = std::vector<std::unique_ptr<Asset>>(paths.size());
+    Parallel::For(Parallel::DefaultJobs(), paths.size(), [&](size_t n) {
+        loaded[n] = Asset::Load(filesystem, paths[n], groups);
+    });
 
-            children->push_back(std::move(asset));
+    for (size_t n = 0; n < paths.size(); n++) {
+        if (loaded[n] == nullptr) {
+            fprintf(stderr, "error: failed to load asset: %s\n", paths[n].c_str());
+            error = true;
+            continue;
         }
-    });
+
+        children->push_back(std::move(loaded[n]));
+    }
 
     return error;
 }
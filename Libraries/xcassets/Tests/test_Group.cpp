@@ -69,3 +69,37 @@ TEST(Group, FlatNamespace)
     xcassets::Asset::Asset const *firstAsset = group->children().front().get();
     EXPECT_EQ(firstAsset->name().string(), "Inner");
 }
+
+TEST(Group, ChildrenOrder)
+{
+    /* Enough nested children to load on several threads. */
+    std::vector<MemoryFilesystem::Entry> groups;
+    for (int i = 0; i < 50; i++) {
+        std::vector<MemoryFilesystem::Entry> inner;
+        for (int j = 0; j < 10; j++) {
+            inner.push_back(MemoryFilesystem::Entry::Directory("Inner" + std::to_string(j), { }));
+        }
+        groups.push_back(MemoryFilesystem::Entry::Directory("Group" + std::to_string(i), inner));
+    }
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Outer", groups),
+    });
+
+    /* Load asset. */
+    auto asset = xcassets::Asset::Asset::Load(&filesystem, "/Outer", { }, xcassets::Asset::Group::Extension());
+    auto group = libutil::static_unique_pointer_cast<xcassets::Asset::Group>(std::move(asset));
+    ASSERT_NE(group, nullptr);
+
+    /* Verify children are in directory order. */
+    ASSERT_EQ(group->children().size(), 50);
+    for (int i = 0; i < 50; i++) {
+        xcassets::Asset::Asset const *child = group->children()[i].get();
+        EXPECT_EQ(child->name().string(), "Group" + std::to_string(i));
+
+        ASSERT_EQ(child->children().size(), 10);
+        for (int j = 0; j < 10; j++) {
+            EXPECT_EQ(child->children()[j]->name().string(), "Inner" + std::to_string(j));
+        }
+    }
+}
@@ -37,6 +37,7 @@ public:
     enum Type {
         Build,
         ShowBuildSettings,
+        Query,
         List,
         Version,
         Usage,
@@ -47,6 +48,7 @@ public:
         Find,
         ExportArchive,
         Localizations,
+        BuildService,
     };
 
 public:
@@ -16,6 +16,7 @@ namespace process { class Launcher; }
 
 namespace xcdriver {
 
+class BuildService;
 class Options;
 
 class BuildAction {
@@ -25,7 +26,7 @@ private:
 
 public:
     static int
-    Run(process::Context const *processContext, process::Launcher *processLauncher, libutil::Filesystem *filesystem, Options const &options);
+    Run(process::Context const *processContext, process::Launcher *processLauncher, libutil::Filesystem *filesystem, Options const &options, BuildService *buildService = nullptr);
 };
 
 }
@@ -0,0 +1,89 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcdriver_BuildService_h
+#define __xcdriver_BuildService_h
+
+#include <pbxbuild/Build/Environment.h>
+#include <xcexecution/WorkspaceCache.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+namespace process { class Launcher; }
+
+namespace xcdriver {
+
+/*
+ * Keeps the build environment and loaded workspaces in memory between
+ * builds. The service listens on a local socket; clients send their
+ * arguments, environment, working directory and output, and the service
+ * runs the invocation as if it were the client, one at a time.
+ *
+ * Loaded workspaces and their targets' environments are used again until
+ * one of their files changes, as reported by a file watcher where that is
+ * supported. The build environment is created again when a client's
+ * environment differs; restart the service after installing specifications
+ * or SDKs.
+ *
+ * The socket must be in a directory only the user can access, and both
+ * ends check that the other is running as the same user.
+ */
+class BuildService {
+private:
+    libutil::Filesystem const                    *_filesystem;
+    std::unordered_map<std::string, std::string>  _environmentVariables;
+    std::string                                   _userName;
+    ext::optional<pbxbuild::Build::Environment>   _buildEnvironment;
+    std::shared_ptr<xcexecution::WorkspaceCache>  _workspaceCache;
+
+public:
+    BuildService(libutil::Filesystem const *filesystem);
+    ~BuildService();
+
+public:
+    /*
+     * The build environment for a build, kept from an earlier build if
+     * the process context has the same environment and user. It loads
+     * SDKs as they are needed through the service's own filesystem, not
+     * one belonging to a single build.
+     */
+    ext::optional<pbxbuild::Build::Environment>
+    buildEnvironment(process::Context const *processContext);
+
+    /*
+     * The workspaces loaded by earlier builds.
+     */
+    std::shared_ptr<xcexecution::WorkspaceCache> const &workspaceCache() const
+    { return _workspaceCache; }
+
+public:
+    /*
+     * Run a build service listening on a socket path. Only returns if the
+     * service fails, or if the socket's directory is not private.
+     */
+    static int
+    Run(process::Context const *processContext, process::Launcher *processLauncher, libutil::Filesystem *filesystem, std::string const &socketPath);
+
+    /*
+     * Send an invocation to the build service listening on a socket path,
+     * and wait for its result. The build's output goes to this process's
+     * standard output and error.
+     */
+    static int
+    Forward(process::Context const *processContext, std::string const &socketPath);
+};
+
+}
+
+#endif // !__xcdriver_BuildService_h
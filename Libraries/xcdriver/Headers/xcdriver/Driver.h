@@ -16,14 +16,20 @@ namespace process { class Launcher; }
 
 namespace xcdriver {
 
+class BuildService;
+
 class Driver {
 private:
     Driver();
     ~Driver();
 
 public:
+    /*
+     * Run the driver. Builds run inside a build service use what the
+     * service keeps between builds.
+     */
     static int
-    Run(process::Context const *processContext, process::Launcher *processLauncher, libutil::Filesystem *filesystem);
+    Run(process::Context const *processContext, process::Launcher *processLauncher, libutil::Filesystem *filesystem, BuildService *buildService = nullptr);
 };
 
 }
@@ -49,10 +49,26 @@ private:
     ext::optional<std::string> _formatter;
     ext::optional<std::string> _executor;
     ext::optional<bool>        _generate;
+    ext::optional<bool>        _actionCache;
+    ext::optional<bool>        _auditInputs;
+    ext::optional<bool>        _scanDependencies;
+    ext::optional<bool>        _criticalPath;
+    ext::optional<std::string> _eventStream;
+    ext::optional<std::string> _trace;
+    ext::optional<bool>        _traceMemory;
+    ext::optional<bool>        _stats;
+    std::vector<std::string>   _buildTuples;
+    ext::optional<std::string> _shard;
+
+private:
+    ext::optional<std::string> _buildService;
+    ext::optional<std::string> _useBuildService;
 
 private:
     ext::optional<bool>        _parallelizeTargets;
     ext::optional<int>         _jobs;
+    ext::optional<int>         _memoryLimit;
+    ext::optional<bool>        _keepGoing;
     ext::optional<bool>        _dryRun;
     ext::optional<bool>        _hideShellScriptEnvironment;
 
@@ -60,6 +76,7 @@ private:
     ext::optional<bool>        _list;
     ext::optional<bool>        _showSDKs;
     ext::optional<bool>        _showBuildSettings;
+    ext::optional<std::string> _query;
 
 private:
     ext::optional<std::string> _xcconfig;
@@ -158,12 +175,54 @@ public:
     /* Extension. */
     bool generate() const
     { return _generate.value_or(false); }
+    /* Extension. */
+    bool actionCache() const
+    { return _actionCache.value_or(false); }
+    /* Extension. */
+    bool auditInputs() const
+    { return _auditInputs.value_or(false); }
+    /* Extension. */
+    bool scanDependencies() const
+    { return _scanDependencies.value_or(false); }
+    /* Extension. */
+    bool criticalPath() const
+    { return _criticalPath.value_or(false); }
+    /* Extension. */
+    ext::optional<std::string> const &eventStream() const
+    { return _eventStream; }
+    /* Extension. */
+    ext::optional<std::string> const &trace() const
+    { return _trace; }
+    /* Extension. */
+    bool traceMemory() const
+    { return _traceMemory.value_or(false); }
+    /* Extension. */
+    bool stats() const
+    { return _stats.value_or(false); }
+    /* Extension. */
+    std::vector<std::string> const &buildTuples() const
+    { return _buildTuples; }
+    /* Extension. */
+    ext::optional<std::string> const &shard() const
+    { return _shard; }
+
+public:
+    /* Extension. */
+    ext::optional<std::string> const &buildService() const
+    { return _buildService; }
+    /* Extension. */
+    ext::optional<std::string> const &useBuildService() const
+    { return _useBuildService; }
 
 public:
     bool parallelizeTargets() const
     { return _parallelizeTargets.value_or(false); }
     ext::optional<int> jobs() const
     { return _jobs; }
+    ext::optional<int> memoryLimit() const
+    { return _memoryLimit; }
+    bool keepGoing() const
+    { return _keepGoing.value_or(false); }
     bool dryRun() const
     { return _dryRun.value_or(false); }
     bool hideShellScriptEnvironment() const
@@ -176,6 +235,9 @@ public:
     { return _showSDKs.value_or(false); }
     bool showBuildSettings() const
     { return _showBuildSettings.value_or(false); }
+    /* Extension. */
+    ext::optional<std::string> const &query() const
+    { return _query; }
 
 public:
     ext::optional<std::string> const &xcconfig() const
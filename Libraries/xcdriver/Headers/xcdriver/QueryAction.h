@@ -0,0 +1,38 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcdriver_QueryAction_h
+#define __xcdriver_QueryAction_h
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+
+namespace xcdriver {
+
+class BuildService;
+class Options;
+
+/*
+ * Prints the graph of targets and invocations a build would run, without
+ * running anything. Resolves the graph the same way a build does, using a
+ * build service's loaded workspaces if there is one.
+ */
+class QueryAction {
+private:
+    QueryAction();
+    ~QueryAction();
+
+public:
+    static int
+    Run(process::Context const *processContext, libutil::Filesystem const *filesystem, Options const &options, BuildService *buildService);
+};
+
+}
+
+#endif // !__xcdriver_QueryAction_h
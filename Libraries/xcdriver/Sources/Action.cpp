@@ -40,6 +40,9 @@ CreateOverrideLevels(process::Context const *processContext, Filesystem const *f
     if (options.arch()) {
         settings.push_back(pbxsetting::Setting::Create("ARCHS", *options.arch()));
     }
+    if (options.jobs()) {
+        settings.push_back(pbxsetting::Setting::Create("XCBUILD_JOBS", std::to_string(*options.jobs())));
+    }
     levels.push_back(pbxsetting::Level(settings));
 
     levels.push_back(options.settings());
@@ -105,7 +108,9 @@ VerifyBuildActions(std::vector<std::string> const &actions)
 Action::Type Action::
 Determine(Options const &options)
 {
-    if (options.version()) {
+    if (options.buildService()) {
+        return BuildService;
+    } else if (options.version()) {
         return Version;
     } else if (options.usage()) {
         return Usage;
@@ -127,6 +132,8 @@ Determine(Options const &options)
         return List;
     } else if (options.showBuildSettings()) {
         return ShowBuildSettings;
+    } else if (options.query()) {
+        return Query;
     } else {
         return Build;
     }
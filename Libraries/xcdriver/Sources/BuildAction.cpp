@@ -9,21 +9,34 @@
 
 #include <xcdriver/BuildAction.h>
 #include <xcdriver/Action.h>
+#include <xcdriver/BuildService.h>
 #include <xcdriver/Options.h>
 #include <xcexecution/NinjaExecutor.h>
 #include <xcexecution/SimpleExecutor.h>
+#include <xcexecution/WorkspaceCache.h>
 #include <xcformatter/DefaultFormatter.h>
+#include <xcformatter/EventFormatter.h>
 #include <xcformatter/NullFormatter.h>
 #include <builtin/Registry.h>
+#include <plist/FileCache.h>
 #include <libutil/Base.h>
+#include <libutil/CachingFilesystem.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+#include <libutil/Trace.h>
 #include <process/Context.h>
 
+#include <algorithm>
+
 #include <unistd.h>
 
+using xcdriver::Action;
 using xcdriver::BuildAction;
 using xcdriver::Options;
+using libutil::CachingFilesystem;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 BuildAction::
 BuildAction()
@@ -57,20 +70,87 @@ CreateExecutor(
     ext::optional<std::string> const &executor,
     std::shared_ptr<xcformatter::Formatter> const &formatter,
     bool dryRun,
-    bool generate)
+    bool generate,
+    xcexecution::SimpleExecutor::Options const &simpleOptions)
 {
     if (!executor || *executor == "simple") {
         auto registry = builtin::Registry::Default();
-        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry);
+        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry, simpleOptions);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     } else if (*executor == "ninja") {
-        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate);
+        if (simpleOptions.shardCount > 1) {
+            fprintf(stderr, "warning: sharding is only supported by the simple executor\n");
+        }
+
+        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate, simpleOptions.actionCache);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     }
 
     return nullptr;
 }
 
+/*
+ * The builds for one SDK and configuration, performed in order.
+ */
+struct Destination {
+    ext::optional<std::string> sdk;
+    ext::optional<std::string> configuration;
+    std::vector<std::string>   actions;
+};
+
+static ext::optional<std::vector<Destination>>
+ParseBuildTuples(Options const &options)
+{
+    std::vector<Destination> destinations;
+    if (options.buildTuples().empty()) {
+        return destinations;
+    }
+
+    /* The other options are the first destination. */
+    std::vector<std::string> defaultActions = (!options.actions().empty() ? options.actions() : std::vector<std::string>({ "build" }));
+    destinations.push_back(Destination { options.sdk(), options.configuration(), defaultActions });
+
+    for (std::string const &tuple : options.buildTuples()) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (true) {
+            size_t end = tuple.find(':', start);
+            parts.push_back(tuple.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+
+        if (parts.size() > 3) {
+            fprintf(stderr, "error: invalid build tuple '%s'\n", tuple.c_str());
+            return ext::nullopt;
+        }
+        parts.resize(3);
+
+        /* Empty parts are the same as the other options. */
+        std::vector<std::string> actions = (!parts[0].empty() ? std::vector<std::string>({ parts[0] }) : defaultActions);
+        if (!Action::VerifyBuildActions(actions)) {
+            return ext::nullopt;
+        }
+
+        ext::optional<std::string> sdk = (!parts[1].empty() ? ext::make_optional(parts[1]) : options.sdk());
+        ext::optional<std::string> configuration = (!parts[2].empty() ? ext::make_optional(parts[2]) : options.configuration());
+
+        /* Actions for the same destination build on each other, so run in order. */
+        auto it = std::find_if(destinations.begin(), destinations.end(), [&](Destination const &destination) {
+            return destination.sdk == sdk && destination.configuration == configuration;
+        });
+        if (it == destinations.end()) {
+            destinations.push_back(Destination { sdk, configuration, { } });
+            it = destinations.end() - 1;
+        }
+        it->actions.insert(it->actions.end(), actions.begin(), actions.end());
+    }
+
+    return destinations;
+}
+
 static bool
 VerifySupportedOptions(Options const &options)
 {
@@ -86,8 +166,14 @@ VerifySupportedOptions(Options const &options)
         fprintf(stderr, "warning: destination option not implemented\n");
     }
 
-    if (options.parallelizeTargets() || options.jobs()) {
-        fprintf(stderr, "warning: job control option not implemented\n");
+    if (options.jobs() && *options.jobs() < 1) {
+        fprintf(stderr, "error: invalid number of jobs %d\n", *options.jobs());
+        return false;
+    }
+
+    if (options.memoryLimit() && *options.memoryLimit() < 1) {
+        fprintf(stderr, "error: invalid memory limit %d\n", *options.memoryLimit());
+        return false;
     }
 
     if (options.enableAddressSanitizer() || options.enableThreadSanitizer() || options.enableCodeCoverage()) {
@@ -116,7 +202,7 @@ VerifySupportedOptions(Options const &options)
 }
 
 int BuildAction::
-Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, Options const &options)
+Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, Options const &options, BuildService *buildService)
 {
     // TODO(grp): Implement these options.
     if (!VerifySupportedOptions(options)) {
@@ -128,6 +214,26 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
         return -1;
     }
 
+    /* Further destinations to build, each for its own SDK and configuration. */
+    ext::optional<std::vector<Destination>> destinations = ParseBuildTuples(options);
+    if (!destinations) {
+        return -1;
+    }
+
+    /*
+     * Record where the build spends its time, from here on.
+     */
+    ext::optional<std::string> tracePath;
+    if (options.trace()) {
+        tracePath = FSUtil::ResolveRelativePath(*options.trace(), processContext->currentDirectory());
+        if (options.traceMemory()) {
+            libutil::Trace::StartMemory();
+        }
+        libutil::Trace::Start();
+    } else if (options.traceMemory()) {
+        fprintf(stderr, "warning: memory is only recorded in a trace\n");
+    }
+
     /*
      * Create the formatter to format the build log.
      */
@@ -137,28 +243,110 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
         return -1;
     }
 
+    /* Build events are written alongside the build log. */
+    if (options.eventStream()) {
+        std::string eventStreamPath = FSUtil::ResolveRelativePath(*options.eventStream(), processContext->currentDirectory());
+        formatter = xcformatter::EventFormatter::Create(formatter, eventStreamPath);
+        if (formatter == nullptr) {
+            fprintf(stderr, "error: unable to open event stream '%s'\n", eventStreamPath.c_str());
+            return -1;
+        }
+    }
+
+    /*
+     * Determine how many invocations can run at once. Like xcodebuild, default
+     * to one job per processor when not specified. Loading and resolving the
+     * build in parallel uses the same number of jobs.
+     */
+    libutil::Parallel::SetDefaultJobs(options.jobs() ? static_cast<size_t>(std::max(*options.jobs(), 1)) : 0);
+
+    xcexecution::SimpleExecutor::Options executorOptions;
+    executorOptions.jobs = libutil::Parallel::DefaultJobs();
+
+    /*
+     * Limit the memory used by running tools, in bytes. Unlimited when not specified.
+     */
+    executorOptions.memoryLimit = (options.memoryLimit() ? static_cast<size_t>(*options.memoryLimit()) * 1024 * 1024 : 0);
+
+    executorOptions.parallelizeTargets = options.parallelizeTargets();
+    executorOptions.actionCache = options.actionCache();
+    executorOptions.auditInputs = options.auditInputs();
+    executorOptions.criticalPath = options.criticalPath();
+    executorOptions.keepGoing = options.keepGoing();
+    executorOptions.scanDependencies = options.scanDependencies();
+
+    /*
+     * Which part of the targets this machine builds, numbered from one on the
+     * command line. Builds all of them when not specified.
+     */
+    if (options.shard()) {
+        unsigned long index = 0;
+        unsigned long count = 0;
+        char extra = '\0';
+        if (sscanf(options.shard()->c_str(), "%lu/%lu%c", &index, &count, &extra) != 2 || index < 1 || index > count) {
+            fprintf(stderr, "error: invalid shard '%s'\n", options.shard()->c_str());
+            return -1;
+        }
+
+        executorOptions.shardIndex = static_cast<size_t>(index - 1);
+        executorOptions.shardCount = static_cast<size_t>(count);
+    }
+
     /*
      * Create the executor used to perform the build.
      */
-    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate());
+    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate(), executorOptions);
     if (executor == nullptr) {
         fprintf(stderr, "error: unknown executor '%s'\n", options.executor()->c_str());
         return -1;
     }
 
+    /*
+     * Loading the build environment and settings checks the same paths many
+     * times over, and nothing changes them while it does. The build itself
+     * resolves targets through its build context's cache instead, which the
+     * executor invalidates whenever the tools it runs can change files.
+     */
+    CachingFilesystem cachingFilesystem(filesystem);
+
+    /*
+     * Most of the specifications and SDKs have not changed since the last
+     * build; use their saved property lists rather than parsing them.
+     */
+    ext::optional<std::string> propertyListCachePath = pbxbuild::Build::Environment::CachePath(processContext);
+    if (buildService == nullptr && propertyListCachePath && filesystem->isReadable(*propertyListCachePath)) {
+        plist::FileCache::GetDefault()->load(filesystem, *propertyListCachePath);
+    }
+
     /*
      * Use the default build environment. We don't need anything custom here.
+     * A build service keeps the environment from earlier builds.
      */
-    ext::optional<pbxbuild::Build::Environment> buildEnvironment = pbxbuild::Build::Environment::Default(processContext, filesystem);
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment;
+    {
+        libutil::Trace::Span span("Load Build Environment");
+        buildEnvironment = (buildService != nullptr ?
+            buildService->buildEnvironment(processContext) :
+            pbxbuild::Build::Environment::Default(processContext, &cachingFilesystem));
+    }
     if (!buildEnvironment) {
         fprintf(stderr, "error: couldn't create build environment\n");
         return -1;
     }
 
+    /*
+     * Save the property lists parsed for the environment for later builds.
+     * The file is replaced atomically, so concurrent builds never see it
+     * partly written.
+     */
+    if (buildService == nullptr && propertyListCachePath && !plist::FileCache::GetDefault()->save(filesystem, *propertyListCachePath)) {
+        fprintf(stderr, "warning: unable to save property list cache to %s\n", propertyListCachePath->c_str());
+    }
+
     /* The build settings passed in on the command line override all others. */
     std::vector<pbxsetting::Level> overrideLevels = Action::CreateOverrideLevels(
         processContext,
-        filesystem,
+        &cachingFilesystem,
         buildEnvironment->baseEnvironment(),
         options,
         processContext->currentDirectory());
@@ -168,11 +356,79 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
      * build context, but is not required to when the parameters haven't changed from a cache.
      */
     xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels);
+    if (buildService != nullptr) {
+        parameters.workspaceCache() = buildService->workspaceCache();
+    }
 
     /*
      * Perform the build!
      */
-    bool success = executor->build(processContext, processLauncher, filesystem, *buildEnvironment, parameters);
+    bool success;
+    if (destinations->empty()) {
+        libutil::Trace::Span span("Build");
+        success = executor->build(processContext, processLauncher, filesystem, *buildEnvironment, parameters);
+    } else {
+        /*
+         * Each destination is built from the same build environment and the
+         * same loaded workspace, so it is loaded once here before they start.
+         */
+        if (parameters.workspaceCache() == nullptr) {
+            parameters.workspaceCache() = std::make_shared<xcexecution::WorkspaceCache>();
+        }
+        if (!parameters.loadWorkspace(filesystem, processContext->userName(), *buildEnvironment, processContext->currentDirectory())) {
+            return 1;
+        }
+
+        std::vector<std::vector<xcexecution::Parameters>> destinationParameters;
+        for (Destination const &destination : *destinations) {
+            std::vector<pbxsetting::Level> destinationLevels = overrideLevels;
+            if (destination.sdk) {
+                destinationLevels.push_back(pbxsetting::Level({ pbxsetting::Setting::Create("SDKROOT", *destination.sdk) }));
+            }
+
+            std::vector<xcexecution::Parameters> actionParameters;
+            for (std::string const &action : destination.actions) {
+                xcexecution::Parameters actionParameter = xcexecution::Parameters(
+                    options.workspace(),
+                    options.project(),
+                    options.scheme(),
+                    (!options.target().empty() ? ext::make_optional(options.target()) : ext::nullopt),
+                    options.allTargets(),
+                    { action },
+                    destination.configuration,
+                    destinationLevels);
+                actionParameter.workspaceCache() = parameters.workspaceCache();
+                actionParameters.push_back(actionParameter);
+            }
+            destinationParameters.push_back(actionParameters);
+        }
+
+        /*
+         * Build the destinations one after another. They share intermediates,
+         * the build log, and the formatter, so they can't be built at once.
+         */
+        success = true;
+        for (std::vector<xcexecution::Parameters> const &actionParameters : destinationParameters) {
+            for (xcexecution::Parameters const &actionParameter : actionParameters) {
+                std::unique_ptr<xcexecution::Executor> actionExecutor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate(), executorOptions);
+
+                libutil::Trace::Span span("Build");
+                if (!actionExecutor->build(processContext, processLauncher, filesystem, *buildEnvironment, actionParameter)) {
+                    success = false;
+                    break;
+                }
+            }
+
+            if (!success) {
+                break;
+            }
+        }
+    }
+
+    if (tracePath && !libutil::Trace::Write(filesystem, *tracePath)) {
+        fprintf(stderr, "warning: unable to write trace to %s\n", tracePath->c_str());
+    }
+
     if (!success) {
         return 1;
     }
@@ -0,0 +1,482 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcdriver/BuildService.h>
+#include <xcdriver/Driver.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/FileWatcher.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Ownership.h>
+#include <process/Context.h>
+#include <process/MemoryContext.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using xcdriver::BuildService;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Ownership;
+
+BuildService::
+BuildService(Filesystem const *filesystem) :
+    _filesystem    (filesystem),
+    _workspaceCache(std::make_shared<xcexecution::WorkspaceCache>(libutil::FileWatcher::Create()))
+{
+}
+
+BuildService::
+~BuildService()
+{
+}
+
+ext::optional<pbxbuild::Build::Environment> BuildService::
+buildEnvironment(process::Context const *processContext)
+{
+    /* The environment's settings come from the process environment. */
+    if (_buildEnvironment && _environmentVariables == processContext->environmentVariables() && _userName == processContext->userName()) {
+        return _buildEnvironment;
+    }
+
+    _buildEnvironment = pbxbuild::Build::Environment::Default(processContext, _filesystem);
+    _environmentVariables = processContext->environmentVariables();
+    _userName = processContext->userName();
+
+    /* Workspaces were loaded with the old environment's settings. */
+    _workspaceCache->clear();
+
+    return _buildEnvironment;
+}
+
+/*
+ * A request is a length and a binary property list, sent along with the
+ * client's output descriptors. The reply is the invocation's exit status.
+ */
+
+/*
+ * Report closed connections as errors rather than signals.
+ */
+#if defined(MSG_NOSIGNAL)
+static int const SendFlags = MSG_NOSIGNAL;
+#else
+static int const SendFlags = 0;
+#endif
+
+static int
+CreateSocket()
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+#if defined(SO_NOSIGPIPE)
+    int value = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#endif
+
+    return fd;
+}
+
+static bool
+WriteAll(int fd, uint8_t const *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, SendFlags);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written <= 0) {
+            return false;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static bool
+ReadAll(int fd, uint8_t *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t read = ::read(fd, data, size);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        } else if (read <= 0) {
+            return false;
+        }
+
+        data += read;
+        size -= read;
+    }
+
+    return true;
+}
+
+static bool
+SendRequest(int socket, std::vector<uint8_t> const &contents, int const fds[2])
+{
+    uint32_t size = static_cast<uint32_t>(contents.size());
+
+    struct iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len  = sizeof(size);
+
+    char control[CMSG_SPACE(sizeof(int) * 2)];
+    ::memset(control, 0, sizeof(control));
+
+    struct msghdr message;
+    ::memset(&message, 0, sizeof(message));
+    message.msg_iov        = &iov;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control;
+    message.msg_controllen = sizeof(control);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type  = SCM_RIGHTS;
+    header->cmsg_len   = CMSG_LEN(sizeof(int) * 2);
+    ::memcpy(CMSG_DATA(header), fds, sizeof(int) * 2);
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(socket, &message, SendFlags);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent != sizeof(size)) {
+        return false;
+    }
+
+    return WriteAll(socket, contents.data(), contents.size());
+}
+
+static bool
+ReceiveRequest(int socket, std::vector<uint8_t> *contents, int fds[2])
+{
+    uint32_t size = 0;
+
+    struct iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len  = sizeof(size);
+
+    char control[CMSG_SPACE(sizeof(int) * 2)];
+    ::memset(control, 0, sizeof(control));
+
+    struct msghdr message;
+    ::memset(&message, 0, sizeof(message));
+    message.msg_iov        = &iov;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = ::recvmsg(socket, &message, 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received <= 0) {
+        return false;
+    }
+
+    fds[0] = -1;
+    fds[1] = -1;
+    for (struct cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS && header->cmsg_len == CMSG_LEN(sizeof(int) * 2)) {
+            ::memcpy(fds, CMSG_DATA(header), sizeof(int) * 2);
+        }
+    }
+
+    /* The rest of the length may come separately. */
+    if (fds[0] < 0 || fds[1] < 0 || !ReadAll(socket, reinterpret_cast<uint8_t *>(&size) + received, sizeof(size) - received)) {
+        if (fds[0] >= 0) {
+            ::close(fds[0]);
+        }
+        if (fds[1] >= 0) {
+            ::close(fds[1]);
+        }
+        return false;
+    }
+
+    contents->resize(size);
+    if (!ReadAll(socket, contents->data(), contents->size())) {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return false;
+    }
+
+    return true;
+}
+
+static std::vector<uint8_t>
+CreateRequest(process::Context const *processContext)
+{
+    auto arguments = plist::Array::New();
+    std::vector<std::string> const &commandLineArguments = processContext->commandLineArguments();
+    for (auto it = commandLineArguments.begin(); it != commandLineArguments.end(); ++it) {
+        /* The service runs the build itself. */
+        if (*it == "-useBuildService") {
+            if (it + 1 != commandLineArguments.end()) {
+                ++it;
+            }
+            continue;
+        }
+
+        arguments->append(plist::String::New(*it));
+    }
+
+    auto environment = plist::Dictionary::New();
+    for (auto const &entry : processContext->environmentVariables()) {
+        environment->set(entry.first, plist::String::New(entry.second));
+    }
+
+    auto request = plist::Dictionary::New();
+    request->set("ExecutablePath", plist::String::New(processContext->executablePath()));
+    request->set("CurrentDirectory", plist::String::New(processContext->currentDirectory()));
+    request->set("Arguments", std::move(arguments));
+    request->set("Environment", std::move(environment));
+
+    auto serialize = plist::Format::Binary::Serialize(request.get(), plist::Format::Binary::Create());
+    return (serialize.first != nullptr ? *serialize.first : std::vector<uint8_t>());
+}
+
+static ext::optional<process::MemoryContext>
+ParseRequest(process::Context const *serviceContext, std::vector<uint8_t> const &contents)
+{
+    auto deserialize = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create());
+    plist::Dictionary const *request = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    if (request == nullptr) {
+        return ext::nullopt;
+    }
+
+    auto executablePath = request->value<plist::String>("ExecutablePath");
+    auto currentDirectory = request->value<plist::String>("CurrentDirectory");
+    auto arguments = request->value<plist::Array>("Arguments");
+    auto environment = request->value<plist::Dictionary>("Environment");
+    if (executablePath == nullptr || currentDirectory == nullptr || arguments == nullptr || environment == nullptr) {
+        return ext::nullopt;
+    }
+
+    std::vector<std::string> commandLineArguments;
+    for (size_t n = 0; n < arguments->count(); n++) {
+        if (auto argument = arguments->value<plist::String>(n)) {
+            commandLineArguments.push_back(argument->value());
+        }
+    }
+
+    std::unordered_map<std::string, std::string> environmentVariables;
+    for (size_t n = 0; n < environment->count(); n++) {
+        if (auto value = environment->value<plist::String>(n)) {
+            environmentVariables.insert({ environment->key(n), value->value() });
+        }
+    }
+
+    /* Clients can only connect as the service's user. */
+    return process::MemoryContext(
+        executablePath->value(),
+        currentDirectory->value(),
+        commandLineArguments,
+        environmentVariables,
+        serviceContext->userID(),
+        serviceContext->groupID(),
+        serviceContext->userName(),
+        serviceContext->groupName());
+}
+
+static bool
+SocketAddress(std::string const &socketPath, struct sockaddr_un *address)
+{
+    ::memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address->sun_path)) {
+        fprintf(stderr, "error: build service socket path %s is too long\n", socketPath.c_str());
+        return false;
+    }
+
+    ::memcpy(address->sun_path, socketPath.c_str(), socketPath.size());
+    return true;
+}
+
+static void
+ServeConnection(BuildService *buildService, process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, int connection)
+{
+    std::vector<uint8_t> contents;
+    int fds[2];
+    if (!ReceiveRequest(connection, &contents, fds)) {
+        fprintf(stderr, "warning: invalid build service request\n");
+        return;
+    }
+
+    ext::optional<process::MemoryContext> requestContext = ParseRequest(processContext, contents);
+
+    /*
+     * Run with the client's output as this process's output, so what the
+     * build prints and the tools it runs write go to the client.
+     */
+    ::fflush(stdout);
+    ::fflush(stderr);
+    int savedOutput = ::fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+    int savedError = ::fcntl(STDERR_FILENO, F_DUPFD_CLOEXEC, 0);
+    ::dup2(fds[0], STDOUT_FILENO);
+    ::dup2(fds[1], STDERR_FILENO);
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    int32_t status = 1;
+    if (requestContext) {
+        status = xcdriver::Driver::Run(&*requestContext, processLauncher, filesystem, buildService);
+    } else {
+        fprintf(stderr, "error: invalid build service request\n");
+    }
+
+    ::fflush(stdout);
+    ::fflush(stderr);
+    ::dup2(savedOutput, STDOUT_FILENO);
+    ::dup2(savedError, STDERR_FILENO);
+    ::close(savedOutput);
+    ::close(savedError);
+
+    WriteAll(connection, reinterpret_cast<uint8_t const *>(&status), sizeof(status));
+}
+
+int BuildService::
+Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, std::string const &socketPath)
+{
+    struct sockaddr_un address;
+    if (!SocketAddress(socketPath, &address)) {
+        return 1;
+    }
+
+    /* Others could replace the socket in a shared directory. */
+    std::string socketDirectory = FSUtil::GetDirectoryName(FSUtil::ResolveRelativePath(socketPath, processContext->currentDirectory()));
+    if (!Ownership::IsPrivateDirectory(socketDirectory)) {
+        fprintf(stderr, "error: build service socket directory %s is accessible to other users\n", socketDirectory.c_str());
+        return 1;
+    }
+
+    int listener = CreateSocket();
+    if (listener < 0) {
+        fprintf(stderr, "error: unable to create build service socket: %s\n", ::strerror(errno));
+        return 1;
+    }
+
+    /* Replace a socket left by an earlier service. */
+    struct stat st;
+    if (::lstat(socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        ::unlink(socketPath.c_str());
+    }
+
+    if (::bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        ::listen(listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "error: unable to listen on build service socket %s: %s\n", socketPath.c_str(), ::strerror(errno));
+        ::close(listener);
+        return 1;
+    }
+
+    fprintf(stderr, "Build service listening on %s\n", socketPath.c_str());
+
+    /*
+     * Clients going away, while their build writes to their output or
+     * their result is sent, shouldn't stop the service. Launched tools
+     * still get the default behavior.
+     */
+    ::signal(SIGPIPE, SIG_IGN);
+
+    BuildService buildService = BuildService(filesystem);
+    for (;;) {
+        int connection = ::accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            fprintf(stderr, "error: unable to accept build service connection: %s\n", ::strerror(errno));
+            break;
+        }
+        ::fcntl(connection, F_SETFD, FD_CLOEXEC);
+
+        /* Builds run as the service's user, so only serve that user. */
+        if (!Ownership::SocketPeerIsUser(connection)) {
+            fprintf(stderr, "warning: refused build service connection from another user\n");
+            ::close(connection);
+            continue;
+        }
+
+        ServeConnection(&buildService, processContext, processLauncher, filesystem, connection);
+        ::close(connection);
+    }
+
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    return 1;
+}
+
+int BuildService::
+Forward(process::Context const *processContext, std::string const &socketPath)
+{
+    struct sockaddr_un address;
+    if (!SocketAddress(socketPath, &address)) {
+        return 1;
+    }
+
+    int connection = CreateSocket();
+    if (connection < 0) {
+        fprintf(stderr, "error: unable to create build service socket: %s\n", ::strerror(errno));
+        return 1;
+    }
+
+    if (::connect(connection, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) {
+        fprintf(stderr, "error: unable to connect to build service at %s: %s\n", socketPath.c_str(), ::strerror(errno));
+        ::close(connection);
+        return 1;
+    }
+
+    /* The client's output goes to the service, so it must be the same user's. */
+    if (!Ownership::SocketPeerIsUser(connection)) {
+        fprintf(stderr, "error: build service at %s is run by another user\n", socketPath.c_str());
+        ::close(connection);
+        return 1;
+    }
+
+    ::fflush(stdout);
+    ::fflush(stderr);
+
+    int const fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+    std::vector<uint8_t> request = CreateRequest(processContext);
+    if (request.empty() || !SendRequest(connection, request, fds)) {
+        fprintf(stderr, "error: unable to send request to build service\n");
+        ::close(connection);
+        return 1;
+    }
+
+    int32_t status;
+    if (!ReadAll(connection, reinterpret_cast<uint8_t *>(&status), sizeof(status))) {
+        fprintf(stderr, "error: build service closed the connection\n");
+        ::close(connection);
+        return 1;
+    }
+
+    ::close(connection);
+    return status;
+}
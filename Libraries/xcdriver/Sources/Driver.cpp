@@ -11,15 +11,18 @@
 #include <xcdriver/Action.h>
 #include <xcdriver/Options.h>
 #include <xcdriver/BuildAction.h>
+#include <xcdriver/BuildService.h>
 #include <xcdriver/FindAction.h>
 #include <xcdriver/HelpAction.h>
 #include <xcdriver/LicenseAction.h>
 #include <xcdriver/ListAction.h>
+#include <xcdriver/QueryAction.h>
 #include <xcdriver/ShowSDKsAction.h>
 #include <xcdriver/ShowBuildSettingsAction.h>
 #include <xcdriver/UsageAction.h>
 #include <xcdriver/VersionAction.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Statistics.h>
 #include <process/Context.h>
 
 #include <string>
@@ -28,7 +31,19 @@
 using xcdriver::Driver;
 using xcdriver::Action;
 using xcdriver::Options;
+using xcdriver::BuildAction;
+using xcdriver::BuildService;
+using xcdriver::FindAction;
+using xcdriver::HelpAction;
+using xcdriver::LicenseAction;
+using xcdriver::ListAction;
+using xcdriver::QueryAction;
+using xcdriver::ShowSDKsAction;
+using xcdriver::ShowBuildSettingsAction;
+using xcdriver::UsageAction;
+using xcdriver::VersionAction;
 using libutil::Filesystem;
+using libutil::Statistics;
 
 Driver::
 Driver()
@@ -40,22 +55,16 @@ Driver::
 {
 }
 
-int Driver::
-Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem)
+static int
+RunAction(Action::Type action, process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, Options const &options, BuildService *buildService)
 {
-    Options options;
-    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
-    if (!result.first) {
-        fprintf(stderr, "error: %s\n", result.second.c_str());
-        return 1;
-    }
-
-    Action::Type action = Action::Determine(options);
     switch (action) {
         case Action::Build:
-            return BuildAction::Run(processContext, processLauncher, filesystem, options);
+            return BuildAction::Run(processContext, processLauncher, filesystem, options, buildService);
         case Action::ShowBuildSettings:
             return ShowBuildSettingsAction::Run(processContext, filesystem, options);
+        case Action::Query:
+            return QueryAction::Run(processContext, filesystem, options, buildService);
         case Action::List:
             return ListAction::Run(processContext, filesystem, options);
         case Action::Version:
@@ -79,7 +88,47 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
         case Action::Localizations:
             fprintf(stderr, "warning: localizations not implemented\n");
             break;
+        case Action::BuildService:
+            return BuildService::Run(processContext, processLauncher, filesystem, *options.buildService());
     }
 
     return 0;
 }
+
+int Driver::
+Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, BuildService *buildService)
+{
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
+    if (!result.first) {
+        fprintf(stderr, "error: %s\n", result.second.c_str());
+        return 1;
+    }
+
+    if (options.buildService() && buildService != nullptr) {
+        fprintf(stderr, "error: already running in a build service\n");
+        return 1;
+    }
+
+    /* Send the whole invocation to a running build service. */
+    if (options.useBuildService()) {
+        if (buildService != nullptr) {
+            fprintf(stderr, "error: already running in a build service\n");
+            return 1;
+        }
+
+        return BuildService::Forward(processContext, *options.useBuildService());
+    }
+
+    if (options.stats()) {
+        Statistics::Start();
+    }
+
+    int ret = RunAction(Action::Determine(options), processContext, processLauncher, filesystem, options, buildService);
+
+    if (options.stats()) {
+        fprintf(stderr, "\nStatistics:\n%s", Statistics::Report().c_str());
+    }
+
+    return ret;
+}
@@ -72,6 +72,55 @@ Run(process::Context const *processContext)
         "    -generate                                   "
         "specify that an execution engine based on generating another build "
         "language should regenerate\n");
+    fprintf(
+        stdout,
+        "    -actionCache                                "
+        "restore the outputs of compiles from a cache in derived data when "
+        "their inputs are unchanged\n");
+    fprintf(
+        stdout,
+        "    -auditInputs                                "
+        "trace tools with fsatrace and report reads of files they do not "
+        "declare as inputs\n");
+    fprintf(
+        stdout,
+        "    -scanDependencies                           "
+        "find the headers compiles include with clang-scan-deps before "
+        "running them, to order and cache them by those headers\n");
+    fprintf(
+        stdout,
+        "    -criticalPath                               "
+        "report the critical path and parallelism after a build with "
+        "parallelized targets\n");
+    fprintf(
+        stdout,
+        "    -eventStream PATH                           "
+        "write build events with timings to a file, one JSON object per "
+        "line\n");
+    fprintf(
+        stdout,
+        "    -trace PATH                                 "
+        "write where the build spends its time to a file for chrome://tracing\n");
+    fprintf(
+        stdout,
+        "    -traceMemory                                "
+        "also record the memory allocated by each part of the build in the "
+        "trace\n");
+    fprintf(
+        stdout,
+        "    -stats                                      "
+        "print how often hot paths such as setting lookups and file system "
+        "calls ran\n");
+    fprintf(
+        stdout,
+        "    -buildTuple ACTION:SDK:CONFIGURATION        "
+        "also perform ACTION for SDK and CONFIGURATION, sharing the loaded "
+        "workspace; may be repeated. empty parts use the other options\n");
+    fprintf(
+        stdout,
+        "    -shard INDEX/COUNT                          "
+        "split the targets into COUNT balanced shards, and only build shard "
+        "INDEX and what it depends on\n");
     fprintf(
         stdout,
         "    -project NAME                               "
@@ -129,11 +178,22 @@ Run(process::Context const *processContext)
     fprintf(
         stdout,
         "    -jobs NUMBER                                "
-        "not yet implemented\n");
+        "run up to NUMBER jobs at once\n");
+    fprintf(
+        stdout,
+        "    -memoryLimit MEGABYTES                      "
+        "only start tools while those running are expected to use at most "
+        "MEGABYTES of memory, based on the memory they used before\n");
+    fprintf(
+        stdout,
+        "    -keepGoing                                  "
+        "after a failure, keep building everything that does not depend on "
+        "it, and report every failure at the end\n");
     fprintf(
         stdout,
         "    -dry-run                                    "
-        "print build output without producing any build products\n");
+        "print build output without producing any build products, and "
+        "estimate how long the build would take from earlier builds\n");
     fprintf(
         stdout,
         "    -hideShellScriptEnvironment                 "
@@ -146,6 +206,11 @@ Run(process::Context const *processContext)
         stdout,
         "    -showBuildSettings                          "
         "print the build settings and their values for the given target\n");
+    fprintf(
+        stdout,
+        "    -query dot|json                             "
+        "print the targets, the invocations that build them, and their "
+        "inputs and outputs without building\n");
     fprintf(
         stdout,
         "    -list                                       "
@@ -68,6 +68,10 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Current<bool>(&_parallelizeTargets, arg);
     } else if (arg == "-jobs") {
         return libutil::Options::Next<int>(&_jobs, args, it);
+    } else if (arg == "-memoryLimit") {
+        return libutil::Options::Next<int>(&_memoryLimit, args, it);
+    } else if (arg == "-keepGoing" || arg == "-keep-going") {
+        return libutil::Options::Current<bool>(&_keepGoing, arg);
     } else if (arg == "-dryrun" || arg == "-n") {
         return libutil::Options::Current<bool>(&_dryRun, arg);
     } else if (arg == "-hideShellScriptEnvironment") {
@@ -78,6 +82,8 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Current<bool>(&_showBuildSettings, arg);
     } else if (arg == "-list") {
         return libutil::Options::Current<bool>(&_list, arg);
+    } else if (arg == "-query") {
+        return libutil::Options::Next<std::string>(&_query, args, it);
     } else if (arg == "-find" || arg == "-find-executable") {
         return libutil::Options::Next<std::string>(&_findExecutable, args, it);
     } else if (arg == "-find-library") {
@@ -130,6 +136,30 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_formatter, args, it);
     } else if (arg == "-generate") {
         return libutil::Options::Current<bool>(&_generate, arg);
+    } else if (arg == "-actionCache") {
+        return libutil::Options::Current<bool>(&_actionCache, arg);
+    } else if (arg == "-trace") {
+        return libutil::Options::Next<std::string>(&_trace, args, it);
+    } else if (arg == "-traceMemory") {
+        return libutil::Options::Current<bool>(&_traceMemory, arg);
+    } else if (arg == "-stats") {
+        return libutil::Options::Current<bool>(&_stats, arg);
+    } else if (arg == "-eventStream") {
+        return libutil::Options::Next<std::string>(&_eventStream, args, it);
+    } else if (arg == "-criticalPath") {
+        return libutil::Options::Current<bool>(&_criticalPath, arg);
+    } else if (arg == "-auditInputs") {
+        return libutil::Options::Current<bool>(&_auditInputs, arg);
+    } else if (arg == "-scanDependencies") {
+        return libutil::Options::Current<bool>(&_scanDependencies, arg);
+    } else if (arg == "-buildTuple") {
+        return libutil::Options::AppendNext<std::string>(&_buildTuples, args, it);
+    } else if (arg == "-shard") {
+        return libutil::Options::Next<std::string>(&_shard, args, it);
+    } else if (arg == "-buildService") {
+        return libutil::Options::Next<std::string>(&_buildService, args, it);
+    } else if (arg == "-useBuildService") {
+        return libutil::Options::Next<std::string>(&_useBuildService, args, it);
     } else if (!arg.empty() && arg[0] != '-') {
         if (arg.find('=') != std::string::npos) {
             if (ext::optional<pbxsetting::Setting> setting = pbxsetting::Setting::Parse(arg)) {
@@ -0,0 +1,83 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcdriver/QueryAction.h>
+#include <xcdriver/Action.h>
+#include <xcdriver/BuildService.h>
+#include <xcdriver/Options.h>
+#include <xcexecution/BuildGraph.h>
+#include <libutil/Filesystem.h>
+#include <process/Context.h>
+
+using xcdriver::QueryAction;
+using xcdriver::Options;
+using libutil::Filesystem;
+
+QueryAction::
+QueryAction()
+{
+}
+
+QueryAction::
+~QueryAction()
+{
+}
+
+int QueryAction::
+Run(process::Context const *processContext, Filesystem const *filesystem, Options const &options, BuildService *buildService)
+{
+    std::string const &format = *options.query();
+    if (format != "dot" && format != "json") {
+        fprintf(stderr, "error: unknown query format %s\n", format.c_str());
+        return -1;
+    }
+
+    if (!Action::VerifyBuildActions(options.actions())) {
+        return -1;
+    }
+
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment = (buildService != nullptr ?
+        buildService->buildEnvironment(processContext) :
+        pbxbuild::Build::Environment::Default(processContext, filesystem));
+    if (!buildEnvironment) {
+        fprintf(stderr, "error: couldn't create build environment\n");
+        return -1;
+    }
+
+    std::vector<pbxsetting::Level> overrideLevels = Action::CreateOverrideLevels(processContext, filesystem, buildEnvironment->baseEnvironment(), options, processContext->currentDirectory());
+    xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels);
+    if (buildService != nullptr) {
+        parameters.workspaceCache() = buildService->workspaceCache();
+    }
+
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext = parameters.loadWorkspace(filesystem, processContext->userName(), *buildEnvironment, processContext->currentDirectory());
+    if (!workspaceContext) {
+        return -1;
+    }
+
+    ext::optional<pbxbuild::Build::Context> buildContext = parameters.createBuildContext(*workspaceContext);
+    if (!buildContext) {
+        return -1;
+    }
+
+    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> graph = parameters.resolveDependencies(*buildEnvironment, *buildContext);
+    if (!graph) {
+        return -1;
+    }
+
+    ext::optional<xcexecution::BuildGraph> buildGraph = xcexecution::BuildGraph::Create(*buildEnvironment, *buildContext, *graph);
+    if (!buildGraph) {
+        return -1;
+    }
+
+    std::string output = (format == "dot" ? buildGraph->dot() : buildGraph->json());
+    fwrite(output.data(), 1, output.size(), stdout);
+
+    return 0;
+}
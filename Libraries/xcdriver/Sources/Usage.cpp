@@ -26,6 +26,7 @@ Text(std::string const &name) {
         "[-formatter [default]] "
         "[-executor [simple|ninja]] "
         "[-generate] "
+        "[-useBuildService <socketpath>] "
         "[<buildaction>]..." << std::endl;
 
     result << "       " << name << " "
@@ -39,6 +40,7 @@ Text(std::string const &name) {
         "[-formatter [default]] "
         "[-executor [simple|ninja]] "
         "[-generate] "
+        "[-useBuildService <socketpath>] "
         "[<buildaction>]..." << std::endl;
 
     result << "       " << name << " "
@@ -52,6 +54,7 @@ Text(std::string const &name) {
         "[-formatter [default]] "
         "[-executor [simple|ninja]] "
         "[-generate] "
+        "[-useBuildService <socketpath>] "
         "[<buildaction>]..." << std::endl;
 
     result << "       " << name << " -version "
@@ -63,6 +66,8 @@ Text(std::string const &name) {
 
     result << "       " << name << " -showsdks" << std::endl;
 
+    result << "       " << name << " -buildService <socketpath>" << std::endl;
+
     result << "       " << name << " -exportArchive "
         "-archivePath <xcarchivepath> "
         "-exportPath <destinationpath> "
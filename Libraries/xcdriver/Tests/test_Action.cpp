@@ -32,3 +32,23 @@ TEST(Action, VersionOverrides)
     EXPECT_EQ(Action::Determine(options), Action::Version);
 }
 
+
+TEST(Action, BuildService)
+{
+    Options options;
+    auto result = libutil::Options::Parse<Options>(&options, { "-buildService", "/tmp/xcbuild.sock", "-version" });
+    ASSERT_TRUE(result.first);
+
+    EXPECT_EQ(Action::Determine(options), Action::BuildService);
+    EXPECT_EQ(*options.buildService(), "/tmp/xcbuild.sock");
+}
+
+TEST(Action, Query)
+{
+    Options options;
+    auto result = libutil::Options::Parse<Options>(&options, { "-query", "json", "-scheme", "All" });
+    ASSERT_TRUE(result.first);
+
+    EXPECT_EQ(Action::Determine(options), Action::Query);
+    EXPECT_EQ(*options.query(), "json");
+}
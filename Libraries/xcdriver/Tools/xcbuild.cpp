@@ -9,10 +9,54 @@
 
 #include <xcdriver/Driver.h>
 #include <libutil/DefaultFilesystem.h>
+#include <libutil/Trace.h>
 #include <process/DefaultContext.h>
 #include <process/DefaultLauncher.h>
 
+#include <cstdlib>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define MallocSize(pointer) malloc_size(pointer)
+#else
+#include <malloc.h>
+#define MallocSize(pointer) malloc_usable_size(pointer)
+#endif
+
 using libutil::DefaultFilesystem;
+using libutil::Trace;
+
+/*
+ * Report allocations to the trace, so it can record the memory used by each
+ * part of the build. Other forms of `new` and `delete` use these.
+ */
+void *
+operator new(size_t size)
+{
+    void *pointer = std::malloc(size != 0 ? size : 1);
+    if (pointer == nullptr) {
+        /* Built without exceptions. */
+        std::abort();
+    }
+
+    Trace::Allocated(MallocSize(pointer));
+    return pointer;
+}
+
+void
+operator delete(void *pointer) noexcept
+{
+    if (pointer != nullptr) {
+        Trace::Freed(MallocSize(pointer));
+        std::free(pointer);
+    }
+}
+
+void
+operator delete(void *pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
 
 int
 main(int argc, char **argv)
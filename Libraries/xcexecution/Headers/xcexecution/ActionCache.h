@@ -0,0 +1,127 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_ActionCache_h
+#define __xcexecution_ActionCache_h
+
+#include <xcexecution/RemoteCache.h>
+#include <pbxbuild/Tool/Invocation.h>
+#include <libutil/Filesystem.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace xcexecution {
+
+/*
+ * Caches the outputs of actions by the contents of their inputs, rather
+ * than by modification times, so outputs can be restored after switching
+ * branches back and forth.
+ *
+ * An action is found by a key hashed from its command and the contents of
+ * its declared inputs. For each key, the cache keeps the inputs discovered
+ * by earlier runs, such as included headers, along with their contents; an
+ * action hits when all of one run's discovered inputs are unchanged. The
+ * outputs are stored by the hash of their contents in an object store.
+ *
+ * Safe to share between processes and threads: files are written then moved
+ * into place.
+ *
+ * With a remote cache, actions missing locally are looked up remotely and
+ * copied into the local cache, and stored actions are uploaded, so results
+ * are shared between machines.
+ */
+class ActionCache {
+private:
+    std::string        _path;
+    RemoteCache const *_remote;
+
+private:
+    std::shared_ptr<std::unordered_map<std::string, std::pair<libutil::Filesystem::Stamp, std::string>>> _executableHashes;
+    std::shared_ptr<std::mutex>                                                                          _executableHashesMutex;
+
+public:
+    explicit ActionCache(std::string const &path, RemoteCache const *remote = nullptr);
+
+public:
+    /*
+     * The directory containing the cache.
+     */
+    std::string const &path() const
+    { return _path; }
+
+    /*
+     * The remote cache backing the local cache, if any.
+     */
+    RemoteCache const *remote() const
+    { return _remote; }
+
+public:
+    /*
+     * Restore the outputs of an action from the cache. Returns if the
+     * outputs were found and restored.
+     */
+    bool restore(libutil::Filesystem *filesystem, std::string const &key, std::vector<std::string> const &outputs) const;
+
+    /*
+     * Store the outputs of an action that succeeded, along with the inputs
+     * discovered when it ran. Fails if any output can't be read, or if
+     * it can't be uploaded to the remote cache.
+     */
+    bool store(libutil::Filesystem *filesystem, std::string const &key, std::vector<std::string> const &discoveredInputs, std::vector<std::string> const &outputs) const;
+
+public:
+    /*
+     * Describe the command run by an action. The executable is identified
+     * by its path and the hash of its contents, so the same tool installed
+     * at another time or on another machine is the same command. Hashes are
+     * remembered until the executable's stamp changes. Nothing if the
+     * executable has no stamp or can't be read.
+     */
+    ext::optional<std::string> command(
+        libutil::Filesystem const *filesystem,
+        std::string const &executablePath,
+        std::vector<std::string> const &arguments,
+        std::unordered_map<std::string, std::string> const &environment,
+        std::string const &workingDirectory) const;
+
+private:
+    ext::optional<std::string> executableHash(libutil::Filesystem const *filesystem, std::string const &executablePath) const;
+
+public:
+    /*
+     * If an invocation can be cached: compile invocations declare their
+     * outputs, and their dependency info lists everything else they read.
+     */
+    static bool Cacheable(pbxbuild::Tool::Invocation const &invocation);
+
+    /*
+     * The key for an action with a command and declared inputs and outputs.
+     * Nothing if an input exists but can't be read.
+     */
+    static ext::optional<std::string> Key(
+        libutil::Filesystem const *filesystem,
+        std::string const &command,
+        std::vector<std::string> const &inputs,
+        std::vector<std::string> const &outputs);
+
+    /*
+     * The default cache directory, shared by all workspaces in a derived
+     * data directory.
+     */
+    static std::string DefaultPath(std::string const &derivedDataDirectory);
+};
+
+}
+
+#endif // !__xcexecution_ActionCache_h
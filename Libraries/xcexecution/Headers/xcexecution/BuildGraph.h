@@ -0,0 +1,111 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_BuildGraph_h
+#define __xcexecution_BuildGraph_h
+
+#include <pbxbuild/CompactGraph.h>
+#include <pbxbuild/DirectedGraph.h>
+#include <pbxbuild/Tool/Invocation.h>
+#include <pbxproj/PBX/Target.h>
+
+#include <string>
+#include <vector>
+#include <ext/optional>
+
+namespace pbxbuild {
+namespace Build { class Context; }
+namespace Build { class Environment; }
+}
+
+namespace xcexecution {
+
+/*
+ * The targets of a build and the invocations that would build them, as
+ * resolved for a build but without running anything. Invocations depend on
+ * the invocations in the same target producing their inputs.
+ */
+class BuildGraph {
+public:
+    /*
+     * A target, the targets it depends on by index, and its invocations
+     * in the order they would run.
+     */
+    struct Target {
+        std::string                             name;
+        std::vector<size_t>                     dependencies;
+        std::vector<pbxbuild::Tool::Invocation> invocations;
+    };
+
+private:
+    std::vector<Target> _targets;
+
+public:
+    explicit BuildGraph(std::vector<Target> const &targets);
+
+public:
+    /*
+     * The targets, in the order they would build.
+     */
+    std::vector<Target> const &targets() const
+    { return _targets; }
+
+public:
+    /*
+     * The invocations each of a target's invocations depends on, by index.
+     */
+    static std::vector<std::vector<size_t>>
+    Dependencies(std::vector<pbxbuild::Tool::Invocation> const &invocations);
+
+public:
+    /*
+     * Serialize the graph as a Graphviz digraph. Each target is a cluster
+     * of its invocations; edges point from a dependency to its dependent.
+     */
+    std::string dot() const;
+
+    /*
+     * Serialize the graph as JSON, including each invocation's inputs and
+     * outputs and the invocations it depends on.
+     */
+    std::string json() const;
+
+public:
+    /*
+     * Graph of the invocations each invocation depends on, by index.
+     */
+    static pbxbuild::CompactGraph
+    InvocationGraph(std::vector<pbxbuild::Tool::Invocation> const &invocations);
+
+    /*
+     * Order invocations so each comes after the ones it depends on, and
+     * otherwise in the order they were given. Fails if the invocations
+     * depend on each other in a cycle. The invocations are moved into the
+     * result when they are no longer needed.
+     */
+    static ext::optional<std::vector<pbxbuild::Tool::Invocation>>
+    SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations);
+    static ext::optional<std::vector<pbxbuild::Tool::Invocation>>
+    SortInvocations(std::vector<pbxbuild::Tool::Invocation> &&invocations);
+
+public:
+    /*
+     * Resolve the invocations for each target of a target graph, the same
+     * way a build does.
+     */
+    static ext::optional<BuildGraph>
+    Create(
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph);
+};
+
+}
+
+#endif // !__xcexecution_BuildGraph_h
@@ -0,0 +1,119 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_BuildLog_h
+#define __xcexecution_BuildLog_h
+
+#include <pbxbuild/Tool/Invocation.h>
+#include <libutil/Filesystem.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace xcexecution {
+
+/*
+ * Records the invocations run by a build, so later builds can skip the
+ * invocations that are up to date. An invocation is up to date if its
+ * command is unchanged, and none of its inputs, including inputs that may
+ * not exist, the inputs found in its dependency info, or its outputs changed
+ * since it last succeeded.
+ *
+ * Invocations are identified by their outputs; invocations without any
+ * outputs are never up to date. How long each invocation took when it last
+ * ran is also kept, to estimate how long a build will take, as is the most
+ * memory each tool has used. Not thread safe.
+ */
+class BuildLog {
+private:
+    struct Entry {
+        std::string                                                                       command;
+        std::vector<std::pair<std::string, ext::optional<libutil::Filesystem::Stamp>>> stamps;
+        ext::optional<int64_t>                                                            duration;
+    };
+
+private:
+    std::unordered_map<std::string, Entry>   _entries;
+    std::unordered_map<std::string, int64_t> _memory;
+    bool                                     _modified;
+
+public:
+    BuildLog();
+
+public:
+    /*
+     * If an invocation is up to date, and can be skipped.
+     */
+    bool upToDate(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation) const;
+
+    /*
+     * Record that an invocation succeeded, along with the current stamps
+     * of its inputs and outputs, and how long it took in microseconds if
+     * it ran. Nothing is recorded if the stamps can't be read or its
+     * dependency info is invalid.
+     */
+    void record(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation, ext::optional<int64_t> duration = ext::nullopt);
+
+    /*
+     * How long an invocation took in microseconds when it last ran, if
+     * known. Kept when its inputs change, but not once it fails.
+     */
+    ext::optional<int64_t> duration(pbxbuild::Tool::Invocation const &invocation) const;
+
+    /*
+     * Forget an invocation, so it is run next time.
+     */
+    void forget(pbxbuild::Tool::Invocation const &invocation);
+
+    /*
+     * Call a function for each recorded invocation, with its outputs, the
+     * other paths it depended on, and how long it took if known. Order is
+     * unspecified.
+     */
+    void iterate(std::function<void(std::vector<std::string> const &outputs, std::vector<std::string> const &inputs, ext::optional<int64_t> duration)> const &function) const;
+
+public:
+    /*
+     * Record the most memory an invocation of a tool had resident at once,
+     * in bytes. The largest seen for each tool is kept, so estimates of
+     * the memory the tool needs stay on the safe side.
+     */
+    void recordMemory(std::string const &tool, int64_t bytes);
+
+    /*
+     * The most memory an invocation of a tool has used, if known.
+     */
+    ext::optional<int64_t> memory(std::string const &tool) const;
+
+public:
+    /*
+     * Load a log saved to a file. Fails if the file is missing or invalid.
+     */
+    bool load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Save the log to a file, if it changed since it was loaded.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path);
+
+public:
+    /*
+     * A hash of everything an invocation runs with: its executable,
+     * arguments, environment and working directory.
+     */
+    static std::string CommandHash(pbxbuild::Tool::Invocation const &invocation);
+};
+
+}
+
+#endif // !__xcexecution_BuildLog_h
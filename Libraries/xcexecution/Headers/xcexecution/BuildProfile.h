@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_BuildProfile_h
+#define __xcexecution_BuildProfile_h
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xcexecution {
+
+/*
+ * Records when each job of a build ran and what it waited on, to find what
+ * bounds the build's wall time.
+ *
+ * The critical path is found by starting from the job that finished last
+ * and repeatedly stepping to the dependency that finished last, as that is
+ * the one it waited for. Time between that dependency finishing and the job
+ * starting was spent waiting for a free job slot.
+ *
+ * Not thread safe; callers serialize access.
+ */
+class BuildProfile {
+public:
+    /*
+     * A job of the build. Unnamed jobs only order other jobs, and are left
+     * out of reports. Times are microseconds since the profile was created,
+     * or negative if the job did not run.
+     */
+    struct Job {
+        std::string         target;
+        std::string         name;
+        std::vector<size_t> dependencies;
+        int64_t             start;
+        int64_t             finish;
+    };
+
+private:
+    std::chrono::steady_clock::time_point _start;
+    std::vector<Job>                      _jobs;
+
+public:
+    BuildProfile();
+
+public:
+    /*
+     * The jobs added, in order.
+     */
+    std::vector<Job> const &jobs() const
+    { return _jobs; }
+
+public:
+    /*
+     * Add a job, waiting on other jobs by index. Returns its index.
+     */
+    size_t add(std::string const &target, std::string const &name, std::vector<size_t> const &dependencies);
+
+    /*
+     * Record a job starting or finishing now, or at a time.
+     */
+    void start(size_t index);
+    void start(size_t index, int64_t time);
+    void finish(size_t index);
+    void finish(size_t index, int64_t time);
+
+    /*
+     * Record when each job would run if it took the matching duration in
+     * microseconds, with at most `slots` jobs running at once. Ready jobs
+     * start lowest index first, as in a build. Jobs taking no time don't
+     * need a slot.
+     */
+    void simulate(size_t slots, std::vector<int64_t> const &durations);
+
+public:
+    /*
+     * The named jobs on the critical path, from first to last.
+     */
+    std::vector<size_t> criticalPath() const;
+
+    /*
+     * How long, in microseconds, each number of named jobs was running at
+     * once, indexed by the number of jobs.
+     */
+    std::vector<int64_t> parallelism() const;
+
+    /*
+     * A readable report of the critical path and parallelism.
+     */
+    std::string report() const;
+};
+
+}
+
+#endif // !__xcexecution_BuildProfile_h
@@ -0,0 +1,45 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_BuildShards_h
+#define __xcexecution_BuildShards_h
+
+#include <cstdint>
+#include <vector>
+
+namespace xcexecution {
+
+/*
+ * Splits the targets of a build between several machines, each building
+ * one shard. A target can only build once its dependencies have, so each
+ * shard builds the targets nothing else depends on that were assigned to
+ * it, along with everything those targets depend on. Dependencies shared
+ * between shards build in each of them; with a shared action cache, their
+ * compiles are restored from whichever shard built them first.
+ *
+ * Partitions only depend on their inputs, so every machine finds the same
+ * shards when given the same targets and durations.
+ */
+class BuildShards {
+public:
+    /*
+     * Partition targets, each with the targets it depends on by index and
+     * how long it is expected to take, into `count` shards with a similar
+     * total duration. The largest targets are assigned first, each to the
+     * shard it adds the least to, counting both how long it leaves that
+     * shard and the work it repeats from others. Returns the targets each
+     * shard builds, by index in increasing order.
+     */
+    static std::vector<std::vector<size_t>>
+    Partition(std::vector<std::vector<size_t>> const &dependencies, std::vector<int64_t> const &durations, size_t count);
+};
+
+}
+
+#endif // !__xcexecution_BuildShards_h
@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_CommandRemoteCache_h
+#define __xcexecution_CommandRemoteCache_h
+
+#include <xcexecution/RemoteCache.h>
+
+#include <ext/optional>
+
+namespace process { class Context; }
+namespace process { class Launcher; }
+
+namespace xcexecution {
+
+/*
+ * Remote cache that runs a helper command for each transfer, so any shared
+ * storage can be used without building in a network client:
+ *
+ *     helper get <ac|cas> <name> <path>
+ *     helper put <ac|cas> <name> <path>
+ *
+ * Action entries are "ac" and objects are "cas", matching the paths of the
+ * Bazel HTTP cache protocol; a helper for such a server can be one `curl`.
+ * The helper exits with zero on success and non-zero for a missing entry.
+ * It runs with the environment of the build, for any credentials it needs.
+ *
+ * Builds find the helper in the `XCBUILD_ACTION_CACHE_REMOTE` environment
+ * variable.
+ */
+class CommandRemoteCache : public RemoteCache {
+private:
+    process::Launcher      *_launcher;
+    process::Context const *_context;
+    std::string             _helper;
+
+public:
+    CommandRemoteCache(process::Launcher *launcher, process::Context const *context, std::string const &helper);
+    virtual ~CommandRemoteCache();
+
+public:
+    /*
+     * The path to the helper command.
+     */
+    std::string const &helper() const
+    { return _helper; }
+
+public:
+    virtual bool fetch(libutil::Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const;
+    virtual bool upload(libutil::Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const;
+
+public:
+    /*
+     * The helper command configured for a process, if any.
+     */
+    static ext::optional<std::string> Helper(process::Context const *context);
+
+private:
+    bool run(libutil::Filesystem *filesystem, std::string const &operation, Kind kind, std::string const &name, std::string const &path) const;
+};
+
+}
+
+#endif // !__xcexecution_CommandRemoteCache_h
@@ -0,0 +1,76 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_DependencyScanner_h
+#define __xcexecution_DependencyScanner_h
+
+#include <pbxbuild/Tool/Invocation.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+namespace process { class Launcher; }
+
+namespace xcexecution {
+
+/*
+ * Finds the headers compiles include before they run, rather than from the
+ * dependency info they write when they do. All the compiles of a target are
+ * scanned together by one `clang-scan-deps`, which scans them in parallel
+ * and only preprocesses what it needs to.
+ *
+ * Compiles including headers that don't exist yet, such as ones generated
+ * earlier in the build, fail to scan and are left as they were.
+ */
+class DependencyScanner {
+public:
+    /*
+     * If an invocation is a Clang compile that can be scanned.
+     */
+    static bool Scannable(pbxbuild::Tool::Invocation const &invocation);
+
+    /*
+     * A compilation database for compiles, each with the path to its
+     * compiler. Dependency info arguments are left out, so each compile's
+     * dependencies are listed under its output.
+     */
+    static std::string CompilationDatabase(std::vector<std::pair<std::string, pbxbuild::Tool::Invocation const *>> const &compiles);
+
+    /*
+     * The inputs for each of the outputs in the output of the scanner.
+     * Anything else in the output, such as errors for compiles that failed
+     * to scan, is ignored.
+     */
+    static std::unordered_map<std::string, std::vector<std::string>>
+    Dependencies(std::string const &output, std::unordered_set<std::string> const &outputs);
+
+    /*
+     * Scan the scannable invocations, and add the headers they include to
+     * their input dependencies. The compilation database is written to a
+     * path for the scanner to read. Returns if the scanner ran.
+     */
+    static bool Scan(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        std::string const &scannerPath,
+        std::string const &databasePath,
+        std::vector<std::string> const &executablePaths,
+        size_t jobs,
+        std::vector<pbxbuild::Tool::Invocation> *invocations);
+};
+
+}
+
+#endif // !__xcexecution_DependencyScanner_h
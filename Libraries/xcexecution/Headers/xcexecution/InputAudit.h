@@ -0,0 +1,99 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_InputAudit_h
+#define __xcexecution_InputAudit_h
+
+#include <pbxbuild/Tool/Invocation.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Audits whether invocations declare everything they read. Invocations run
+ * under a file access tracer, and the files read are compared against the
+ * declared inputs, input dependencies, outputs, and dependency info. Tools
+ * whose invocations read only declared files can safely be cached.
+ *
+ * The tracer is `fsatrace`, which records accesses by interposing on the
+ * C library, without needing privileges to trace.
+ */
+class InputAudit {
+private:
+    std::string              _tracerPath;
+    std::string              _temporaryDirectory;
+    std::vector<std::string> _ignoredDirectories;
+    std::atomic<size_t>      _nextTrace;
+
+private:
+    std::map<std::string, std::pair<size_t, size_t>> _tools;
+
+public:
+    InputAudit(std::string const &tracerPath, std::string const &temporaryDirectory, std::vector<std::string> const &ignoredDirectories);
+
+public:
+    /*
+     * The path to the tracer.
+     */
+    std::string const &tracerPath() const
+    { return _tracerPath; }
+
+    /*
+     * Directories of the system and developer tools, which are not expected
+     * to be declared as inputs.
+     */
+    std::vector<std::string> const &ignoredDirectories() const
+    { return _ignoredDirectories; }
+
+    /*
+     * For each audited tool, the number of invocations audited and the
+     * number of those with undeclared reads.
+     */
+    std::map<std::string, std::pair<size_t, size_t>> const &tools() const
+    { return _tools; }
+
+public:
+    /*
+     * A new path to write a trace to. Thread safe.
+     */
+    std::string tracePath();
+
+    /*
+     * The arguments to the tracer to run a command, writing a trace.
+     */
+    std::vector<std::string> arguments(std::string const &tracePath, std::string const &executablePath, std::vector<std::string> const &arguments) const;
+
+    /*
+     * Read and remove a trace, then return the files read by the invocation
+     * that it did not declare. Not thread safe.
+     */
+    std::vector<std::string> audit(libutil::Filesystem *filesystem, pbxbuild::Tool::Invocation const &invocation, std::string const &executablePath, std::string const &tracePath);
+
+public:
+    /*
+     * The files read in a trace, excluding files also written.
+     */
+    static std::vector<std::string> Reads(std::string const &trace);
+
+    /*
+     * The system directories ignored by default.
+     */
+    static std::vector<std::string> DefaultIgnoredDirectories();
+};
+
+}
+
+#endif // !__xcexecution_InputAudit_h
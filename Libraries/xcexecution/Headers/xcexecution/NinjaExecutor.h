@@ -21,10 +21,18 @@ namespace xcexecution {
 
 /*
  * Concrete executor that generates Ninja files.
+ *
+ * With `actionCache`, compile invocations run through the action cache tool,
+ * which restores their outputs from the cache in derived data when the same
+ * invocation ran before with the same inputs. A remote cache helper named in
+ * `XCBUILD_ACTION_CACHE_REMOTE` is passed on to the tool.
  */
 class NinjaExecutor : public Executor {
+private:
+    bool _actionCache;
+
 public:
-    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool actionCache);
     ~NinjaExecutor();
 
 public:
@@ -44,8 +52,12 @@ private:
         pbxbuild::Build::Context const &buildContext,
         pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
         std::string const &dependencyInfoToolPath,
+        std::string const &actionCacheCommand,
+        std::string const &builtinClientPath,
+        std::string const &builtinSocketPath,
         std::string const &ninjaPath,
         std::string const &configurationHashPath,
+        std::string const &inputsManifestPath,
         std::string const &intermediatesDirectory);
     bool buildOutputDirectories(
         ninja::Writer *writer,
@@ -54,11 +66,18 @@ private:
     bool buildTargetInvocations(
         process::Context const *processContext,
         libutil::Filesystem *filesystem,
+        libutil::Filesystem const *executableLookup,
         std::string const &dependencyInfoToolPath,
+        std::string const &actionCacheCommand,
+        std::string const &builtinClientPath,
+        std::string const &builtinSocketPath,
+        std::unordered_map<std::string, std::string> const &toolPools,
+        std::string const &inputsHash,
         pbxproj::PBX::Target::shared_ptr const &target,
         pbxbuild::Target::Environment const &targetEnvironment,
         std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
-        std::vector<pbxbuild::Tool::Invocation> const &invocations);
+        std::vector<pbxbuild::Tool::Invocation> const &invocations,
+        std::vector<std::pair<std::string, ninja::Writer>> *sharedNinja);
 
 private:
     bool buildAuxiliaryFile(
@@ -70,12 +89,18 @@ private:
         pbxbuild::Tool::Invocation const &invocation,
         std::string const &executablePath,
         std::string const &dependencyInfoToolPath,
+        std::string const &actionCacheCommand,
+        std::string const &builtinClientPath,
+        std::string const &builtinSocketPath,
+        std::unordered_map<std::string, std::string> const &toolPools,
+        std::unordered_map<std::string, std::pair<std::string, size_t>> const &commandPrefixes,
+        std::unordered_map<std::string, std::string> const &sharedEnvironments,
         std::string const &temporaryDirectory,
         std::string const &after);
 
 public:
     static std::unique_ptr<NinjaExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool actionCache);
 };
 
 }
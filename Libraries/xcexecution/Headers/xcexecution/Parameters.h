@@ -14,7 +14,9 @@
 #include <pbxbuild/Build/Context.h>
 #include <pbxbuild/DirectedGraph.h>
 #include <pbxbuild/WorkspaceContext.h>
+#include <xcexecution/WorkspaceCache.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <ext/optional>
@@ -39,6 +41,9 @@ private:
     ext::optional<std::string>     _configuration;
     std::vector<pbxsetting::Level> _overrideLevels;
 
+private:
+    std::shared_ptr<WorkspaceCache> _workspaceCache;
+
 public:
     Parameters(
         ext::optional<std::string> const &workspace,
@@ -99,6 +104,16 @@ public:
     std::vector<pbxsetting::Level> const &overrideLevels() const
     { return _overrideLevels; }
 
+public:
+    /*
+     * Where to keep the loaded workspace for later builds, if anywhere.
+     * Not part of the parameters' canonical arguments.
+     */
+    std::shared_ptr<WorkspaceCache> const &workspaceCache() const
+    { return _workspaceCache; }
+    std::shared_ptr<WorkspaceCache> &workspaceCache()
+    { return _workspaceCache; }
+
 public:
     /*
      * The canonical set of arguments to reproduce these parameters.
@@ -112,7 +127,8 @@ public:
 
 public:
     /*
-     * Loads the workspace from the build parameters.
+     * Loads the workspace from the build parameters. Uses the workspace
+     * cache, if any, when the workspace's files have not changed.
      */
     ext::optional<pbxbuild::WorkspaceContext> loadWorkspace(
         libutil::Filesystem const *filesystem,
@@ -120,6 +136,14 @@ public:
         pbxbuild::Build::Environment const &buildEnvironment,
         std::string const &workingDirectory) const;
 
+private:
+    ext::optional<pbxbuild::WorkspaceContext> openWorkspace(
+        libutil::Filesystem const *filesystem,
+        std::string const &userName,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        std::string const &workingDirectory) const;
+
+public:
     /*
      * Creates the build context for a specific action.
      */
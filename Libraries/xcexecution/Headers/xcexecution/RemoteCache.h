@@ -0,0 +1,54 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_RemoteCache_h
+#define __xcexecution_RemoteCache_h
+
+#include <string>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Abstract storage shared between machines, backing an action cache. Like
+ * the local cache, it holds action entries by key and objects by the hash
+ * of their contents; entries are transferred through local files.
+ */
+class RemoteCache {
+public:
+    /*
+     * The kinds of entries stored.
+     */
+    enum class Kind {
+        Action,
+        Object,
+    };
+
+protected:
+    RemoteCache();
+
+public:
+    virtual ~RemoteCache();
+
+public:
+    /*
+     * Download an entry into a local file. Returns if the entry was found.
+     */
+    virtual bool fetch(libutil::Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const = 0;
+
+    /*
+     * Upload a local file as an entry. Returns if the entry was stored.
+     */
+    virtual bool upload(libutil::Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const = 0;
+};
+
+}
+
+#endif // !__xcexecution_RemoteCache_h
@@ -11,21 +11,116 @@
 #define __xcexecution_SimpleExecutor_h
 
 #include <xcexecution/Executor.h>
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/InputAudit.h>
+#include <xcexecution/BuildProfile.h>
+#include <xcexecution/BuildLog.h>
+#include <xcexecution/BuildGraph.h>
+#include <pbxbuild/DirectedGraph.h>
 #include <pbxbuild/Tool/AuxiliaryFile.h>
 #include <builtin/Registry.h>
+#include <process/EnvironmentBlock.h>
+
+#include <mutex>
+#include <unordered_set>
 
 namespace xcexecution {
 
 /*
- * Simple executor that simply runs invocations in sequence. Advanced features
- * like incremental builds, dependency info, and such are not supported.
+ * Simple executor that runs invocations directly. Up to `jobs` invocations
+ * run at once, in an order respecting the dependencies between them.
+ *
+ * Builds are incremental: succeeded invocations are recorded in a build log
+ * in the intermediates directory, along with the inputs from their dependency
+ * info, and skipped by later builds while they are up to date.
+ *
+ * With `actionCache`, the outputs of compile invocations are also kept by the
+ * contents of their inputs in a cache in derived data, and restored when the
+ * same invocation runs again with the same inputs, such as after switching
+ * branches back. The cache can be shared between machines by naming a remote
+ * cache helper in the `XCBUILD_ACTION_CACHE_REMOTE` environment variable.
+ *
+ * With `auditInputs`, external invocations run under a file access tracer,
+ * and reads of files they don't declare are reported, to find which tools
+ * can be cached. Every invocation runs, and none are restored from the cache.
+ *
+ * With `criticalPath`, when targets are parallelized, when each invocation
+ * ran and what it waited on is recorded, and the critical path through the
+ * build and how many invocations ran at once are reported at the end.
+ *
+ * With a `memoryLimit`, in bytes, invocations only start while the memory
+ * the running ones are expected to use stays within it. Each tool is expected
+ * to use as much memory as its invocations have used before, as recorded in
+ * the build log; tools that haven't run before, and builtins, are expected
+ * to use none. An invocation always starts when nothing else is running.
+ *
+ * With `keepGoing`, a failed invocation only stops the invocations and
+ * targets that depend on it. Everything else is still built, and every
+ * failed invocation is reported at the end.
+ *
+ * With `scanDependencies`, the headers each target's compiles include are
+ * found with `clang-scan-deps` before they run, and added to their input
+ * dependencies. Compiles then wait for the invocations generating headers
+ * they include, and the action cache keys them by those headers too.
+ *
+ * With a `shardCount` above one, the targets are split between that many
+ * machines, and only the targets of shard `shardIndex` are built: those
+ * assigned to it and everything they depend on. Every machine must find the
+ * same shards, so durations come from a build log named by the
+ * `XCBUILD_SHARD_BUILD_LOG` environment variable, such as one saved from a
+ * full build, or are otherwise guessed from the kind of each tool.
+ *
+ * Dry runs estimate how long the build would take, from how long each
+ * invocation took when it last ran, as recorded in the build log. Which
+ * invocations would run and when is found the same way as in a build.
+ *
+ * By default, each target is finished before the next target is started. With
+ * `parallelizeTargets`, the invocations of all targets are instead scheduled
+ * together, ordered only by target dependencies and input and output paths.
  */
 class SimpleExecutor : public Executor {
+public:
+    /*
+     * How the build is performed. Each option is described above.
+     */
+    struct Options {
+        size_t jobs               = 1;
+        size_t memoryLimit        = 0;
+        bool   parallelizeTargets = false;
+        bool   actionCache        = false;
+        bool   auditInputs        = false;
+        bool   criticalPath       = false;
+        bool   keepGoing          = false;
+        bool   scanDependencies   = false;
+        size_t shardIndex         = 0;
+        size_t shardCount         = 1;
+    };
+
+private:
+    class Scheduler;
+
 private:
     builtin::Registry _builtins;
+    size_t            _jobs;
+    size_t            _memoryLimit;
+    bool              _parallelizeTargets;
+    bool              _actionCache;
+    bool              _auditInputs;
+    bool              _criticalPath;
+    bool              _keepGoing;
+    bool              _scanDependencies;
+    size_t            _shardIndex;
+    size_t            _shardCount;
+
+private:
+    /*
+     * Invocations mostly share their environments, so each is formatted
+     * for new processes once.
+     */
+    std::shared_ptr<process::EnvironmentBlock::Cache> _environmentBlocks;
 
 public:
-    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, Options const &options);
     ~SimpleExecutor();
 
 public:
@@ -36,29 +131,173 @@ public:
         pbxbuild::Build::Environment const &buildEnvironment,
         Parameters const &buildParameters);
 
+public:
+    /*
+     * The maximum number of invocations to run at once.
+     */
+    size_t jobs() const
+    { return _jobs; }
+
+    /*
+     * The most memory the running invocations are expected to use, in
+     * bytes, or zero for no limit.
+     */
+    size_t memoryLimit() const
+    { return _memoryLimit; }
+
+    /*
+     * If independent targets are built at the same time.
+     */
+    bool parallelizeTargets() const
+    { return _parallelizeTargets; }
+
+    /*
+     * If the outputs of compile invocations are cached by their inputs.
+     */
+    bool actionCache() const
+    { return _actionCache; }
+
+    /*
+     * If invocations are traced to find reads of undeclared inputs.
+     */
+    bool auditInputs() const
+    { return _auditInputs; }
+
+    /*
+     * If the critical path through the build is reported at the end.
+     */
+    bool criticalPath() const
+    { return _criticalPath; }
+
+    /*
+     * If everything not waiting on a failed invocation is still built.
+     */
+    bool keepGoing() const
+    { return _keepGoing; }
+
+    /*
+     * If the headers compiles include are found before they run.
+     */
+    bool scanDependencies() const
+    { return _scanDependencies; }
+
+    /*
+     * Which of how many shards of the targets to build.
+     */
+    size_t shardIndex() const
+    { return _shardIndex; }
+    size_t shardCount() const
+    { return _shardCount; }
+
+public:
+    /*
+     * Estimate which invocations of a build would run and how long the
+     * build would take, with the configured jobs and target ordering.
+     * Invocations without a recorded duration take as long as others of
+     * the same tool took on average.
+     */
+    std::string estimate(
+        libutil::Filesystem const *filesystem,
+        BuildGraph const &graph,
+        BuildLog const &buildLog) const;
+
 public:
     bool writeAuxiliaryFiles(
         libutil::Filesystem *filesystem,
         std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles);
+
+    /*
+     * Invocations up to date in the build log are skipped, and succeeded
+     * invocations are recorded in it. Every invocation runs without one.
+     * Outputs are restored from and stored in the action cache, if any.
+     * External invocations are traced with the input audit, if any.
+     * External tools are found through the executable lookup filesystem.
+     */
     std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> performInvocations(
         process::Context const *processContext,
         process::Launcher *processLauncher,
         libutil::Filesystem *filesystem,
+        libutil::Filesystem const *executableLookup,
         std::vector<std::string> const &executablePaths,
         std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-        bool createProductStructure);
+        bool createProductStructure,
+        BuildLog *buildLog,
+        ActionCache const *actionCache,
+        InputAudit *inputAudit);
     std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTarget(
         process::Context const *processContext,
         process::Launcher *processLauncher,
         libutil::Filesystem *filesystem,
+        libutil::Filesystem const *executableLookup,
         pbxproj::PBX::Target::shared_ptr const &target,
         pbxbuild::Target::Environment const &targetEnvironment,
         std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
-        std::vector<pbxbuild::Tool::Invocation> const &invocations);
+        std::vector<pbxbuild::Tool::Invocation> &&invocations,
+        BuildLog *buildLog,
+        ActionCache const *actionCache,
+        InputAudit *inputAudit);
+
+private:
+    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> shardTargets(
+        process::Context const *processContext,
+        libutil::Filesystem const *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets);
+
+private:
+    void scanInvocations(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        pbxbuild::Target::Environment const &targetEnvironment,
+        std::vector<pbxbuild::Tool::Invocation> *invocations);
+
+private:
+    bool buildTargetsInOrder(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        libutil::Filesystem const *executableLookup,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+        BuildLog *buildLog,
+        ActionCache const *actionCache,
+        InputAudit *inputAudit);
+    bool buildTargets(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        libutil::Filesystem const *executableLookup,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+        BuildLog *buildLog,
+        ActionCache const *actionCache,
+        InputAudit *inputAudit,
+        BuildProfile *buildProfile);
+    bool performInvocation(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        libutil::Filesystem const *executableLookup,
+        std::vector<std::string> const &executablePaths,
+        pbxbuild::Tool::Invocation const &invocation,
+        std::mutex *outputMutex,
+        std::unordered_set<std::string> *createdDirectories,
+        std::mutex *builtinMutex,
+        BuildLog *buildLog,
+        ActionCache const *actionCache,
+        InputAudit *inputAudit);
 
 public:
     static std::unique_ptr<SimpleExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, Options const &options);
 };
 
 }
@@ -0,0 +1,93 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_WorkspaceCache_h
+#define __xcexecution_WorkspaceCache_h
+
+#include <pbxbuild/WorkspaceContext.h>
+#include <pbxbuild/Build/Context.h>
+#include <libutil/FileWatcher.h>
+#include <libutil/Filesystem.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace xcexecution {
+
+/*
+ * Keeps loaded workspaces between builds in one process, such as in the
+ * build service. A workspace is used again until any of the files it was
+ * loaded from changes. Workspaces are only kept when the filesystem can
+ * stamp every loaded file, so their changes can be seen. With a file
+ * watcher, changed files are reported as they change rather than found
+ * by reading every file's stamp on each build. Safe to share between
+ * builds running at the same time.
+ */
+class WorkspaceCache {
+private:
+    struct Entry {
+        pbxbuild::WorkspaceContext                                       workspaceContext;
+        std::vector<std::pair<std::string, libutil::Filesystem::Stamp>> stamps;
+        bool                                                             watched;
+        std::unordered_map<std::string, pbxbuild::Build::Context>        buildContexts;
+    };
+
+private:
+    std::unordered_map<std::string, Entry> _entries;
+    std::unique_ptr<libutil::FileWatcher>  _fileWatcher;
+    std::shared_ptr<std::mutex>            _mutex;
+
+public:
+    WorkspaceCache();
+    explicit WorkspaceCache(std::unique_ptr<libutil::FileWatcher> fileWatcher);
+
+private:
+    void update();
+
+public:
+    /*
+     * Find a workspace loaded with a key, if none of its files changed.
+     */
+    ext::optional<pbxbuild::WorkspaceContext>
+    find(libutil::Filesystem const *filesystem, std::string const &key);
+
+    /*
+     * Keep a loaded workspace for a key, with the current stamps of its
+     * files. Files modified since the load started, rounded down to the
+     * second for filesystems with coarse times, may have changed while
+     * they were read, so the workspace is only kept if none were.
+     */
+    void insert(libutil::Filesystem const *filesystem, std::string const &key, pbxbuild::WorkspaceContext const &workspaceContext, std::chrono::system_clock::time_point loadStarted);
+
+    /*
+     * Use the target environments from an earlier build of a kept workspace
+     * with the same options, so only targets in changed workspaces are
+     * computed again. Otherwise, keep this build's for later builds.
+     *
+     * Resolved invocations are not kept: they also depend on directories
+     * listed for recursive search paths and files checked for existence,
+     * which aren't recorded, so a change to those wouldn't be noticed.
+     */
+    void shareTargetEnvironments(std::string const &key, pbxbuild::Build::Context *buildContext);
+
+    /*
+     * Forget all loaded workspaces.
+     */
+    void clear();
+};
+
+}
+
+#endif // !__xcexecution_WorkspaceCache_h
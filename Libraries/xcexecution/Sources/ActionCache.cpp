@@ -0,0 +1,479 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <plist/Array.h>
+#include <plist/Boolean.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+using xcexecution::ActionCache;
+using xcexecution::RemoteCache;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Permissions;
+
+/*
+ * The number of runs with different discovered inputs kept for each key.
+ */
+static size_t const MaximumRuns = 8;
+
+ActionCache::
+ActionCache(std::string const &path, RemoteCache const *remote) :
+    _path                 (path),
+    _remote               (remote),
+    _executableHashes     (std::make_shared<std::unordered_map<std::string, std::pair<Filesystem::Stamp, std::string>>>()),
+    _executableHashesMutex(std::make_shared<std::mutex>())
+{
+}
+
+static std::string
+Hash(uint8_t const *data, size_t size)
+{
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(data), size);
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+    return ss.str();
+}
+
+/*
+ * Hash the contents of a file. Missing files hash to an empty string; fails
+ * if the file exists but can't be read.
+ */
+static bool
+HashFile(Filesystem const *filesystem, std::string const &path, std::string *hash)
+{
+    if (filesystem->type(path) != Filesystem::Type::File) {
+        *hash = std::string();
+        return !filesystem->exists(path);
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return false;
+    }
+
+    *hash = Hash(contents.data(), contents.size());
+    return true;
+}
+
+static bool
+WriteAtomically(Filesystem *filesystem, std::vector<uint8_t> const &contents, std::string const &path)
+{
+    return filesystem->createDirectory(FSUtil::GetDirectoryName(path), true) && filesystem->writeAtomically(contents, path);
+}
+
+static std::string
+ObjectPath(std::string const &root, std::string const &hash)
+{
+    return root + "/objects/" + hash.substr(0, 2) + "/" + hash;
+}
+
+static std::string
+ActionPath(std::string const &root, std::string const &key)
+{
+    return root + "/actions/" + key.substr(0, 2) + "/" + key;
+}
+
+/*
+ * Objects are named by the hash of their contents, so a fetched object can
+ * be checked before it is trusted. Actions can't be checked the same way.
+ */
+static bool
+VerifyFetched(Filesystem const *filesystem, xcexecution::RemoteCache::Kind kind, std::string const &name, std::string const &path)
+{
+    if (kind != xcexecution::RemoteCache::Kind::Object) {
+        return true;
+    }
+
+    std::string hash;
+    return HashFile(filesystem, path, &hash) && hash == name;
+}
+
+/*
+ * Fetch an entry from the remote cache into the local cache.
+ */
+static bool
+FetchAtomically(Filesystem *filesystem, xcexecution::RemoteCache const *remote, xcexecution::RemoteCache::Kind kind, std::string const &name, std::string const &path)
+{
+    std::string temporaryPath = FSUtil::GetTemporaryPath(path);
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true) ||
+        !remote->fetch(filesystem, kind, name, temporaryPath) ||
+        !VerifyFetched(filesystem, kind, name, temporaryPath) ||
+        !filesystem->moveFile(temporaryPath, path)) {
+        filesystem->removeFile(temporaryPath);
+        return false;
+    }
+
+    return true;
+}
+
+static std::unique_ptr<plist::Array>
+LoadRuns(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (filesystem->type(path) != Filesystem::Type::File || !filesystem->read(&contents, path)) {
+        return nullptr;
+    }
+
+    auto deserialize = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create());
+    if (plist::CastTo<plist::Array>(deserialize.first.get()) == nullptr) {
+        return nullptr;
+    }
+
+    return plist::static_unique_pointer_cast<plist::Array>(std::move(deserialize.first));
+}
+
+static bool
+ReadObject(Filesystem *filesystem, std::string const &root, xcexecution::RemoteCache const *remote, std::string const &hash, std::vector<uint8_t> *contents)
+{
+    std::string objectPath = ObjectPath(root, hash);
+    if (filesystem->type(objectPath) != Filesystem::Type::File) {
+        if (remote == nullptr || !FetchAtomically(filesystem, remote, xcexecution::RemoteCache::Kind::Object, hash, objectPath)) {
+            return false;
+        }
+    }
+
+    return filesystem->read(contents, objectPath);
+}
+
+/*
+ * Restore the outputs of the first run with unchanged inputs. Returns the
+ * run restored, or nothing.
+ */
+static plist::Dictionary const *
+RestoreRuns(Filesystem *filesystem, std::string const &root, xcexecution::RemoteCache const *remote, plist::Array const *runs, std::vector<std::string> const &outputs)
+{
+    if (runs == nullptr) {
+        return nullptr;
+    }
+
+    for (size_t n = 0; n < runs->count(); ++n) {
+        auto run = runs->value<plist::Dictionary>(n);
+        auto inputs = (run != nullptr ? run->value<plist::Dictionary>("Inputs") : nullptr);
+        auto runOutputs = (run != nullptr ? run->value<plist::Array>("Outputs") : nullptr);
+        if (inputs == nullptr || runOutputs == nullptr || runOutputs->count() != outputs.size()) {
+            continue;
+        }
+
+        /* Only used if every input discovered by the run is unchanged. */
+        bool matches = true;
+        for (size_t i = 0; i < inputs->count() && matches; ++i) {
+            auto hash = inputs->value<plist::String>(i);
+            std::string current;
+            matches = (hash != nullptr && HashFile(filesystem, inputs->key(i), &current) && current == hash->value());
+        }
+        if (!matches) {
+            continue;
+        }
+
+        /* Read every object first, so no outputs are written for a partial hit. */
+        std::vector<std::pair<std::vector<uint8_t>, bool>> contents;
+        for (size_t i = 0; i < runOutputs->count() && matches; ++i) {
+            auto output = runOutputs->value<plist::Dictionary>(i);
+            auto hash = (output != nullptr ? output->value<plist::String>("Hash") : nullptr);
+            auto executable = (output != nullptr ? output->value<plist::Boolean>("Executable") : nullptr);
+
+            std::vector<uint8_t> data;
+            if (hash == nullptr || !ReadObject(filesystem, root, remote, hash->value(), &data)) {
+                matches = false;
+                continue;
+            }
+
+            contents.push_back({ std::move(data), executable != nullptr && executable->value() });
+        }
+        if (!matches) {
+            continue;
+        }
+
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            /* Leave unchanged outputs alone, so anything depending on them is not rebuilt. */
+            std::vector<uint8_t> existing;
+            if (filesystem->type(outputs[i]) != Filesystem::Type::File || !filesystem->read(&existing, outputs[i]) || existing != contents[i].first) {
+                if (!filesystem->createDirectory(FSUtil::GetDirectoryName(outputs[i]), true) || !filesystem->write(contents[i].first, outputs[i])) {
+                    return nullptr;
+                }
+            }
+
+            if (contents[i].second && !filesystem->isExecutable(outputs[i])) {
+                Permissions permissions = Permissions(
+                    { Permissions::Permission::Read, Permissions::Permission::Write, Permissions::Permission::Execute },
+                    { Permissions::Permission::Read, Permissions::Permission::Execute },
+                    { Permissions::Permission::Read, Permissions::Permission::Execute });
+                if (!filesystem->writeFilePermissions(outputs[i], Permissions::Operation::Set, permissions)) {
+                    return nullptr;
+                }
+            }
+        }
+
+        return run;
+    }
+
+    return nullptr;
+}
+
+/*
+ * Write the runs for an action: the new run first, then earlier runs with
+ * different inputs, up to the maximum number of runs.
+ */
+static bool
+WriteRuns(Filesystem *filesystem, std::string const &path, std::unique_ptr<plist::Dictionary> run, std::vector<plist::Array const *> const &existing)
+{
+    auto runs = plist::Array::New();
+    std::vector<plist::Dictionary const *> runInputs;
+    if (auto inputs = run->value<plist::Dictionary>("Inputs")) {
+        runInputs.push_back(inputs);
+    }
+    runs->append(std::move(run));
+
+    for (plist::Array const *previousRuns : existing) {
+        for (size_t n = 0; previousRuns != nullptr && n < previousRuns->count() && runs->count() < MaximumRuns; ++n) {
+            auto previous = previousRuns->value<plist::Dictionary>(n);
+            auto previousInputs = (previous != nullptr ? previous->value<plist::Dictionary>("Inputs") : nullptr);
+            if (previousInputs == nullptr || std::any_of(runInputs.begin(), runInputs.end(), [&](plist::Dictionary const *inputs) { return previousInputs->equals(inputs); })) {
+                continue;
+            }
+
+            runInputs.push_back(previousInputs);
+            runs->append(previous->copy());
+        }
+    }
+
+    auto serialize = plist::Format::Binary::Serialize(runs.get(), plist::Format::Binary::Create());
+    if (serialize.first == nullptr) {
+        return false;
+    }
+
+    return WriteAtomically(filesystem, *serialize.first, path);
+}
+
+/*
+ * Load the runs for an action from the remote cache.
+ */
+static std::unique_ptr<plist::Array>
+FetchRuns(Filesystem *filesystem, xcexecution::RemoteCache const *remote, std::string const &key, std::string const &path)
+{
+    /* Fetched beside the local entry, so the local runs are kept. */
+    std::string remotePath = FSUtil::GetTemporaryPath(path + ".remote");
+    if (remote == nullptr || !FetchAtomically(filesystem, remote, xcexecution::RemoteCache::Kind::Action, key, remotePath)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<plist::Array> runs = LoadRuns(filesystem, remotePath);
+    filesystem->removeFile(remotePath);
+    return runs;
+}
+
+bool ActionCache::
+restore(Filesystem *filesystem, std::string const &key, std::vector<std::string> const &outputs) const
+{
+    std::string actionPath = ActionPath(_path, key);
+    std::unique_ptr<plist::Array> runs = LoadRuns(filesystem, actionPath);
+    if (RestoreRuns(filesystem, _path, _remote, runs.get(), outputs) != nullptr) {
+        return true;
+    }
+
+    /* Runs from other machines are kept locally once used. */
+    std::unique_ptr<plist::Array> remoteRuns = FetchRuns(filesystem, _remote, key, actionPath);
+    plist::Dictionary const *run = RestoreRuns(filesystem, _path, _remote, remoteRuns.get(), outputs);
+    if (run == nullptr) {
+        return false;
+    }
+
+    WriteRuns(filesystem, actionPath, plist::static_unique_pointer_cast<plist::Dictionary>(run->copy()), { runs.get() });
+    return true;
+}
+
+bool ActionCache::
+store(Filesystem *filesystem, std::string const &key, std::vector<std::string> const &discoveredInputs, std::vector<std::string> const &outputs) const
+{
+    auto inputs = plist::Dictionary::New();
+    for (std::string const &input : discoveredInputs) {
+        std::string hash;
+        if (!HashFile(filesystem, input, &hash)) {
+            return false;
+        }
+
+        inputs->set(input, plist::String::New(hash));
+    }
+
+    auto runOutputs = plist::Array::New();
+    for (std::string const &output : outputs) {
+        std::vector<uint8_t> contents;
+        if (filesystem->type(output) != Filesystem::Type::File || !filesystem->read(&contents, output)) {
+            return false;
+        }
+
+        /* Objects are named by their contents, so existing objects are already right. */
+        std::string hash = Hash(contents.data(), contents.size());
+        std::string objectPath = ObjectPath(_path, hash);
+        if (filesystem->type(objectPath) != Filesystem::Type::File) {
+            if (!WriteAtomically(filesystem, contents, objectPath)) {
+                return false;
+            }
+        }
+        if (_remote != nullptr && !_remote->upload(filesystem, RemoteCache::Kind::Object, hash, objectPath)) {
+            return false;
+        }
+
+        auto value = plist::Dictionary::New();
+        value->set("Hash", plist::String::New(hash));
+        value->set("Executable", plist::Boolean::New(filesystem->isExecutable(output)));
+        runOutputs->append(std::move(value));
+    }
+
+    auto run = plist::Dictionary::New();
+    run->set("Inputs", std::move(inputs));
+    run->set("Outputs", std::move(runOutputs));
+
+    /* Newest run first; older runs with the same inputs are replaced. */
+    std::string actionPath = ActionPath(_path, key);
+    std::unique_ptr<plist::Array> existing = LoadRuns(filesystem, actionPath);
+    if (_remote == nullptr) {
+        return WriteRuns(filesystem, actionPath, std::move(run), { existing.get() });
+    }
+
+    /* Keep runs uploaded by other machines, then share the merged runs. */
+    std::unique_ptr<plist::Array> remoteRuns = FetchRuns(filesystem, _remote, key, actionPath);
+    if (!WriteRuns(filesystem, actionPath, std::move(run), { existing.get(), remoteRuns.get() })) {
+        return false;
+    }
+
+    return _remote->upload(filesystem, RemoteCache::Kind::Action, key, actionPath);
+}
+
+bool ActionCache::
+Cacheable(pbxbuild::Tool::Invocation const &invocation)
+{
+    if (!invocation.executable() || !invocation.executable()->external()) {
+        return false;
+    }
+
+    if (invocation.outputs().empty() || invocation.dependencyInfo().empty() || invocation.createsProductStructure()) {
+        return false;
+    }
+
+    /* Directories list all of their contents, not just what was read. */
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        if (dependencyInfo.format() == dependency::DependencyInfoFormat::Directory) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ext::optional<std::string> ActionCache::
+executableHash(Filesystem const *filesystem, std::string const &executablePath) const
+{
+    ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(executablePath);
+    if (!stamp) {
+        return ext::nullopt;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(*_executableHashesMutex);
+        auto it = _executableHashes->find(executablePath);
+        if (it != _executableHashes->end() && it->second.first == *stamp) {
+            return it->second.second;
+        }
+    }
+
+    /* Tools are large, so hash them once for each time they change. */
+    std::string hash;
+    if (!HashFile(filesystem, executablePath, &hash) || hash.empty()) {
+        return ext::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(*_executableHashesMutex);
+    (*_executableHashes)[executablePath] = { *stamp, hash };
+    return hash;
+}
+
+ext::optional<std::string> ActionCache::
+command(
+    Filesystem const *filesystem,
+    std::string const &executablePath,
+    std::vector<std::string> const &arguments,
+    std::unordered_map<std::string, std::string> const &environment,
+    std::string const &workingDirectory) const
+{
+    ext::optional<std::string> hash = executableHash(filesystem, executablePath);
+    if (!hash) {
+        return ext::nullopt;
+    }
+
+    std::string command = executablePath + '\n';
+    command += *hash + '\n';
+
+    for (std::string const &argument : arguments) {
+        command += argument;
+        command += '\0';
+    }
+    command += '\n';
+
+    /* Environment order is unspecified, so sort it first. */
+    std::map<std::string, std::string> sortedEnvironment = std::map<std::string, std::string>(environment.begin(), environment.end());
+    for (auto const &entry : sortedEnvironment) {
+        command += entry.first + '=' + entry.second;
+        command += '\0';
+    }
+    command += '\n';
+
+    command += workingDirectory;
+    return command;
+}
+
+ext::optional<std::string> ActionCache::
+Key(
+    Filesystem const *filesystem,
+    std::string const &command,
+    std::vector<std::string> const &inputs,
+    std::vector<std::string> const &outputs)
+{
+    std::string key = command + '\n';
+
+    for (std::string const &input : inputs) {
+        std::string hash;
+        if (!HashFile(filesystem, input, &hash)) {
+            return ext::nullopt;
+        }
+
+        key += input + '\0' + hash + '\n';
+    }
+
+    for (std::string const &output : outputs) {
+        key += output + '\n';
+    }
+
+    return Hash(reinterpret_cast<uint8_t const *>(key.data()), key.size());
+}
+
+std::string ActionCache::
+DefaultPath(std::string const &derivedDataDirectory)
+{
+    return derivedDataDirectory + "/" + "ActionCache";
+}
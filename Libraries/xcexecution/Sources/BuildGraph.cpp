@@ -0,0 +1,297 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/BuildGraph.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Build/Environment.h>
+#include <pbxbuild/Phase/Environment.h>
+#include <pbxbuild/Phase/PhaseInvocations.h>
+#include <libutil/Escape.h>
+#include <libutil/PathTable.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <cstdio>
+
+using xcexecution::BuildGraph;
+using libutil::Escape;
+using libutil::PathTable;
+
+BuildGraph::
+BuildGraph(std::vector<Target> const &targets) :
+    _targets(targets)
+{
+}
+
+pbxbuild::CompactGraph BuildGraph::
+InvocationGraph(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+{
+    /* Interned, so matching inputs to outputs compares identifiers. */
+    PathTable paths;
+    std::unordered_map<PathTable::Id, size_t> outputToInvocation;
+    for (size_t index = 0; index < invocations.size(); ++index) {
+        for (std::string const &output : invocations[index].outputs()) {
+            outputToInvocation.insert({ paths.intern(output), index });
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> edges;
+    auto insertProducer = [&](size_t index, std::string const &input) {
+        if (ext::optional<PathTable::Id> id = paths.find(input)) {
+            auto it = outputToInvocation.find(*id);
+            if (it != outputToInvocation.end()) {
+                edges.push_back({ index, it->second });
+            }
+        }
+    };
+
+    for (size_t index = 0; index < invocations.size(); ++index) {
+        pbxbuild::Tool::Invocation const &invocation = invocations[index];
+
+        for (std::string const &input : invocation.inputs()) {
+            insertProducer(index, input);
+        }
+        for (std::string const &phonyInput : invocation.phonyInputs()) {
+            insertProducer(index, phonyInput);
+        }
+        for (std::string const &inputDependency : invocation.inputDependencies()) {
+            insertProducer(index, inputDependency);
+        }
+    }
+
+    return pbxbuild::CompactGraph(invocations.size(), edges);
+}
+
+ext::optional<std::vector<pbxbuild::Tool::Invocation>> BuildGraph::
+SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+{
+    return SortInvocations(std::vector<pbxbuild::Tool::Invocation>(invocations));
+}
+
+ext::optional<std::vector<pbxbuild::Tool::Invocation>> BuildGraph::
+SortInvocations(std::vector<pbxbuild::Tool::Invocation> &&invocations)
+{
+    pbxbuild::CompactGraph graph = InvocationGraph(invocations);
+
+    ext::optional<std::vector<size_t>> orderedInvocations = graph.ordered();
+    if (!orderedInvocations) {
+        return ext::nullopt;
+    }
+
+    std::vector<pbxbuild::Tool::Invocation> result;
+    result.reserve(orderedInvocations->size());
+    for (size_t index : *orderedInvocations) {
+        result.push_back(std::move(invocations[index]));
+    }
+    return result;
+}
+
+std::vector<std::vector<size_t>> BuildGraph::
+Dependencies(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+{
+    pbxbuild::CompactGraph graph = InvocationGraph(invocations);
+
+    /* Sorted, so the output is the same each time. */
+    std::vector<std::vector<size_t>> result;
+    for (size_t index = 0; index < invocations.size(); ++index) {
+        std::vector<size_t> dependencies = std::vector<size_t>(graph.adjacent(index).begin(), graph.adjacent(index).end());
+        std::sort(dependencies.begin(), dependencies.end());
+        result.push_back(dependencies);
+    }
+    return result;
+}
+
+static std::string
+DotString(std::string const &value)
+{
+    std::string result = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    result += "\"";
+    return result;
+}
+
+static std::string
+InvocationName(pbxbuild::Tool::Invocation const &invocation)
+{
+    if (!invocation.logMessage().empty()) {
+        return invocation.logMessage();
+    } else if (!invocation.outputs().empty()) {
+        return invocation.outputs().front();
+    } else {
+        return invocation.toolIdentifier();
+    }
+}
+
+std::string BuildGraph::
+dot() const
+{
+    std::string result = "digraph build {\n";
+    result += "    compound = true;\n";
+    result += "    node [shape = box];\n";
+
+    for (size_t t = 0; t < _targets.size(); ++t) {
+        Target const &target = _targets[t];
+        std::string prefix = "t" + std::to_string(t);
+
+        result += "    subgraph cluster_" + std::to_string(t) + " {\n";
+        result += "        label = " + DotString(target.name) + ";\n";
+
+        /* An anchor node, so targets without invocations can have edges. */
+        result += "        " + prefix + " [shape = point, style = invis];\n";
+
+        for (size_t i = 0; i < target.invocations.size(); ++i) {
+            result += "        " + prefix + "_" + std::to_string(i) + " [label = " + DotString(InvocationName(target.invocations[i])) + "];\n";
+        }
+
+        std::vector<std::vector<size_t>> dependencies = Dependencies(target.invocations);
+        for (size_t i = 0; i < dependencies.size(); ++i) {
+            for (size_t dependency : dependencies[i]) {
+                result += "        " + prefix + "_" + std::to_string(dependency) + " -> " + prefix + "_" + std::to_string(i) + ";\n";
+            }
+        }
+
+        result += "    }\n";
+    }
+
+    for (size_t t = 0; t < _targets.size(); ++t) {
+        for (size_t dependency : _targets[t].dependencies) {
+            std::string from = "t" + std::to_string(dependency);
+            std::string to = "t" + std::to_string(t);
+            result += "    " + from + " -> " + to + " [ltail = cluster_" + std::to_string(dependency) + ", lhead = cluster_" + std::to_string(t) + ", style = bold];\n";
+        }
+    }
+
+    result += "}\n";
+    return result;
+}
+
+static std::string
+JSONArray(std::vector<std::string> const &values)
+{
+    std::string result = "[";
+    for (std::string const &value : values) {
+        result += (result.size() > 1 ? "," : "") + Escape::JSON(value);
+    }
+    result += "]";
+    return result;
+}
+
+static std::string
+JSONArray(std::vector<size_t> const &values)
+{
+    std::string result = "[";
+    for (size_t value : values) {
+        result += (result.size() > 1 ? "," : "") + std::to_string(value);
+    }
+    result += "]";
+    return result;
+}
+
+std::string BuildGraph::
+json() const
+{
+    std::string result = "{\"targets\":[";
+
+    for (size_t t = 0; t < _targets.size(); ++t) {
+        Target const &target = _targets[t];
+
+        result += (t > 0 ? ",\n" : "\n");
+        result += "{\"name\":" + Escape::JSON(target.name);
+        result += ",\"dependencies\":" + JSONArray(target.dependencies);
+        result += ",\"invocations\":[";
+
+        std::vector<std::vector<size_t>> dependencies = Dependencies(target.invocations);
+        for (size_t i = 0; i < target.invocations.size(); ++i) {
+            pbxbuild::Tool::Invocation const &invocation = target.invocations[i];
+
+            std::string executable;
+            if (invocation.executable()) {
+                executable = invocation.executable()->builtin() ? *invocation.executable()->builtin() : invocation.executable()->external().value_or(std::string());
+            }
+
+            result += (i > 0 ? ",\n" : "\n");
+            result += "{\"tool\":" + Escape::JSON(invocation.toolIdentifier());
+            result += ",\"executable\":" + Escape::JSON(executable);
+            result += ",\"message\":" + Escape::JSON(invocation.logMessage());
+            result += ",\"inputs\":" + JSONArray(invocation.inputs());
+            result += ",\"outputs\":" + JSONArray(invocation.outputs());
+            result += ",\"phony_inputs\":" + JSONArray(invocation.phonyInputs());
+            result += ",\"input_dependencies\":" + JSONArray(invocation.inputDependencies());
+            result += ",\"order_dependencies\":" + JSONArray(invocation.orderDependencies());
+            result += ",\"dependencies\":" + JSONArray(dependencies[i]);
+            result += "}";
+        }
+
+        result += "]}";
+    }
+
+    result += "\n]}\n";
+    return result;
+}
+
+ext::optional<BuildGraph> BuildGraph::
+Create(
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph)
+{
+    ext::optional<std::vector<pbxproj::PBX::Target::shared_ptr>> orderedTargets = targetGraph.ordered();
+    if (!orderedTargets) {
+        fprintf(stderr, "error: cycle detected in target dependencies\n");
+        return ext::nullopt;
+    }
+
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> indexes;
+    for (size_t index = 0; index < orderedTargets->size(); ++index) {
+        indexes.insert({ orderedTargets->at(index), index });
+    }
+
+    std::vector<Target> targets;
+    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
+        Target result;
+        result.name = target->name();
+
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
+            result.dependencies.push_back(indexes.at(dependency));
+        }
+        std::sort(result.dependencies.begin(), result.dependencies.end());
+
+        /* As in a build, targets without an environment have nothing to run. */
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        if (!targetEnvironment) {
+            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+            targets.push_back(std::move(result));
+            continue;
+        }
+
+        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+
+        ext::optional<std::vector<pbxbuild::Tool::Invocation>> invocations = SortInvocations(std::move(phaseInvocations.invocations()));
+        if (!invocations) {
+            fprintf(stderr, "error: cycle detected building invocation graph for %s\n", target->name().c_str());
+            return ext::nullopt;
+        }
+
+        result.invocations = std::move(*invocations);
+        targets.push_back(std::move(result));
+    }
+
+    return BuildGraph(targets);
+}
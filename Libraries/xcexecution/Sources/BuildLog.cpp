@@ -0,0 +1,351 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/BuildLog.h>
+#include <dependency/DependencyInfoMerger.h>
+#include <plist/Array.h>
+#include <plist/CacheFile.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+using xcexecution::BuildLog;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+static int64_t const LogVersion = 1;
+
+BuildLog::
+BuildLog() :
+    _modified(false)
+{
+}
+
+static std::string
+InvocationKey(pbxbuild::Tool::Invocation const &invocation)
+{
+    std::string key;
+    for (std::string const &output : invocation.outputs()) {
+        key += output;
+        key += '\n';
+    }
+    return key;
+}
+
+static ext::optional<Filesystem::Stamp>
+ReadStamp(Filesystem const *filesystem, std::string const &path)
+{
+    /* Outputs can be directories, such as those in the product structure. */
+    if (ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(path)) {
+        return stamp;
+    }
+    return filesystem->readDirectoryStamp(path);
+}
+
+bool BuildLog::
+upToDate(Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation) const
+{
+    if (invocation.outputs().empty()) {
+        return false;
+    }
+
+    auto it = _entries.find(InvocationKey(invocation));
+    if (it == _entries.end() || it->second.command != CommandHash(invocation)) {
+        return false;
+    }
+
+    for (auto const &stamp : it->second.stamps) {
+        if (ReadStamp(filesystem, stamp.first) != stamp.second) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BuildLog::
+record(Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation, ext::optional<int64_t> duration)
+{
+    if (invocation.outputs().empty()) {
+        return;
+    }
+
+    /* Without the discovered inputs, changes to them would be missed. */
+    dependency::DependencyInfoMerger merger = dependency::DependencyInfoMerger(invocation.workingDirectory());
+    for (std::string const &input : invocation.inputs()) {
+        merger.add(input);
+    }
+    /* Inputs that may not exist, such as those declared by scripts, too. */
+    for (std::string const &input : invocation.phonyInputs()) {
+        merger.add(input);
+    }
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        std::string path = FSUtil::ResolveRelativePath(dependencyInfo.path(), invocation.workingDirectory());
+        if (!merger.add(filesystem, dependencyInfo.format(), path)) {
+            forget(invocation);
+            return;
+        }
+    }
+
+    Entry entry;
+    entry.command = CommandHash(invocation);
+
+    /* Outputs restored without running keep the time they last took. */
+    entry.duration = duration;
+    if (!entry.duration) {
+        entry.duration = this->duration(invocation);
+    }
+
+    for (std::string const *input : merger.inputs()) {
+        ext::optional<Filesystem::Stamp> stamp = ReadStamp(filesystem, *input);
+        if (!stamp && filesystem->exists(*input)) {
+            /* Without a stamp, changes to the input can't be seen. */
+            forget(invocation);
+            return;
+        }
+
+        /* Inputs missing now must still be missing. */
+        entry.stamps.push_back({ *input, stamp });
+    }
+
+    for (std::string const &output : invocation.outputs()) {
+        ext::optional<Filesystem::Stamp> stamp = ReadStamp(filesystem, output);
+        if (!stamp) {
+            /* Outputs that weren't written must be written next time. */
+            forget(invocation);
+            return;
+        }
+
+        entry.stamps.push_back({ output, stamp });
+    }
+
+    _entries[InvocationKey(invocation)] = std::move(entry);
+    _modified = true;
+}
+
+void BuildLog::
+forget(pbxbuild::Tool::Invocation const &invocation)
+{
+    if (_entries.erase(InvocationKey(invocation)) != 0) {
+        _modified = true;
+    }
+}
+
+void BuildLog::
+iterate(std::function<void(std::vector<std::string> const &outputs, std::vector<std::string> const &inputs, ext::optional<int64_t> duration)> const &function) const
+{
+    for (auto const &entry : _entries) {
+        std::vector<std::string> outputs;
+        std::string::size_type start = 0;
+        std::string::size_type end;
+        while ((end = entry.first.find('\n', start)) != std::string::npos) {
+            outputs.push_back(entry.first.substr(start, end - start));
+            start = end + 1;
+        }
+
+        std::vector<std::string> inputs;
+        for (auto const &stamp : entry.second.stamps) {
+            if (std::find(outputs.begin(), outputs.end(), stamp.first) == outputs.end()) {
+                inputs.push_back(stamp.first);
+            }
+        }
+
+        function(outputs, inputs, entry.second.duration);
+    }
+}
+
+ext::optional<int64_t> BuildLog::
+duration(pbxbuild::Tool::Invocation const &invocation) const
+{
+    auto it = _entries.find(InvocationKey(invocation));
+    if (it == _entries.end()) {
+        return ext::nullopt;
+    }
+
+    return it->second.duration;
+}
+
+void BuildLog::
+recordMemory(std::string const &tool, int64_t bytes)
+{
+    auto it = _memory.find(tool);
+    if (it == _memory.end() || it->second < bytes) {
+        _memory[tool] = bytes;
+        _modified = true;
+    }
+}
+
+ext::optional<int64_t> BuildLog::
+memory(std::string const &tool) const
+{
+    auto it = _memory.find(tool);
+    if (it == _memory.end()) {
+        return ext::nullopt;
+    }
+
+    return it->second;
+}
+
+bool BuildLog::
+load(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<plist::Dictionary> root = plist::CacheFile::Load(filesystem, path, LogVersion);
+    auto entries = (root != nullptr ? root->value<plist::Dictionary>("Entries") : nullptr);
+    if (entries == nullptr) {
+        return false;
+    }
+
+    for (size_t n = 0; n < entries->count(); ++n) {
+        auto dict = entries->value<plist::Dictionary>(n);
+        auto command = (dict != nullptr ? dict->value<plist::String>("Command") : nullptr);
+        auto stamps = (dict != nullptr ? dict->value<plist::Array>("Stamps") : nullptr);
+        if (command == nullptr || stamps == nullptr) {
+            continue;
+        }
+
+        Entry entry;
+        entry.command = command->value();
+        if (auto duration = dict->value<plist::Integer>("Duration")) {
+            entry.duration = duration->value();
+        }
+
+        bool valid = true;
+        for (size_t i = 0; i < stamps->count() && valid; ++i) {
+            auto stamp = stamps->value<plist::Dictionary>(i);
+            auto stampPath = (stamp != nullptr ? stamp->value<plist::String>("Path") : nullptr);
+            if (stampPath == nullptr) {
+                valid = false;
+                continue;
+            }
+
+            auto size = stamp->value<plist::Integer>("Size");
+            auto modificationTime = stamp->value<plist::Integer>("ModificationTime");
+            if (size != nullptr && modificationTime != nullptr) {
+                Filesystem::Stamp value = { static_cast<uint64_t>(size->value()), modificationTime->value() };
+                entry.stamps.push_back({ stampPath->value(), value });
+            } else {
+                /* Missing when recorded. */
+                entry.stamps.push_back({ stampPath->value(), ext::nullopt });
+            }
+        }
+
+        if (valid) {
+            _entries[entries->key(n)] = std::move(entry);
+        }
+    }
+
+    /* Logs saved before memory was recorded have none. */
+    if (auto memory = root->value<plist::Dictionary>("Memory")) {
+        for (size_t n = 0; n < memory->count(); ++n) {
+            if (auto bytes = memory->value<plist::Integer>(n)) {
+                _memory[memory->key(n)] = bytes->value();
+            }
+        }
+    }
+
+    _modified = false;
+    return true;
+}
+
+bool BuildLog::
+save(Filesystem *filesystem, std::string const &path)
+{
+    if (!_modified) {
+        return true;
+    }
+
+    auto entries = plist::Dictionary::New();
+    for (auto const &it : _entries) {
+        auto dict = plist::Dictionary::New();
+        dict->set("Command", plist::String::New(it.second.command));
+        if (it.second.duration) {
+            dict->set("Duration", plist::Integer::New(*it.second.duration));
+        }
+
+        auto stamps = plist::Array::New();
+        for (auto const &stamp : it.second.stamps) {
+            auto value = plist::Dictionary::New();
+            value->set("Path", plist::String::New(stamp.first));
+            if (stamp.second) {
+                value->set("Size", plist::Integer::New(static_cast<int64_t>(stamp.second->size)));
+                value->set("ModificationTime", plist::Integer::New(stamp.second->modificationTime));
+            }
+            stamps->append(std::move(value));
+        }
+        dict->set("Stamps", std::move(stamps));
+
+        entries->set(it.first, std::move(dict));
+    }
+
+    auto memory = plist::Dictionary::New();
+    for (auto const &it : _memory) {
+        memory->set(it.first, plist::Integer::New(it.second));
+    }
+
+    auto root = plist::Dictionary::New();
+    root->set("Entries", std::move(entries));
+    root->set("Memory", std::move(memory));
+    if (!plist::CacheFile::Save(filesystem, path, LogVersion, std::move(root))) {
+        return false;
+    }
+
+    _modified = false;
+    return true;
+}
+
+std::string BuildLog::
+CommandHash(pbxbuild::Tool::Invocation const &invocation)
+{
+    std::string command;
+
+    if (ext::optional<pbxbuild::Tool::Invocation::Executable> const &executable = invocation.executable()) {
+        if (ext::optional<std::string> const &builtin = executable->builtin()) {
+            command += "builtin:" + *builtin;
+        } else if (ext::optional<std::string> const &external = executable->external()) {
+            command += "external:" + *external;
+        }
+    }
+    command += '\n';
+
+    for (std::string const &argument : invocation.arguments()) {
+        command += argument;
+        command += '\0';
+    }
+    command += '\n';
+
+    /* Environment order is unspecified, so sort it first. */
+    std::map<std::string, std::string> environment = std::map<std::string, std::string>(invocation.environment().begin(), invocation.environment().end());
+    for (auto const &entry : environment) {
+        command += entry.first + '=' + entry.second;
+        command += '\0';
+    }
+    command += '\n';
+
+    command += invocation.workingDirectory();
+
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(command.data()), command.size());
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+    return ss.str();
+}
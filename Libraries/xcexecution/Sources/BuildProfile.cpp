@@ -0,0 +1,267 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/BuildProfile.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <set>
+#include <cstdio>
+
+using xcexecution::BuildProfile;
+
+BuildProfile::
+BuildProfile() :
+    _start(std::chrono::steady_clock::now())
+{
+}
+
+size_t BuildProfile::
+add(std::string const &target, std::string const &name, std::vector<size_t> const &dependencies)
+{
+    _jobs.push_back({ target, name, dependencies, -1, -1 });
+    return _jobs.size() - 1;
+}
+
+static int64_t
+Now(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BuildProfile::
+start(size_t index)
+{
+    start(index, Now(_start));
+}
+
+void BuildProfile::
+start(size_t index, int64_t time)
+{
+    _jobs[index].start = time;
+}
+
+void BuildProfile::
+finish(size_t index)
+{
+    finish(index, Now(_start));
+}
+
+void BuildProfile::
+finish(size_t index, int64_t time)
+{
+    _jobs[index].finish = time;
+}
+
+void BuildProfile::
+simulate(size_t slots, std::vector<int64_t> const &durations)
+{
+    std::vector<size_t> waiting = std::vector<size_t>(_jobs.size(), 0);
+    std::vector<std::vector<size_t>> dependents = std::vector<std::vector<size_t>>(_jobs.size());
+    for (size_t index = 0; index < _jobs.size(); ++index) {
+        _jobs[index].start = -1;
+        _jobs[index].finish = -1;
+
+        for (size_t dependency : _jobs[index].dependencies) {
+            if (dependency != index && dependency < _jobs.size()) {
+                waiting[index]++;
+                dependents[dependency].push_back(index);
+            }
+        }
+    }
+
+    std::set<size_t> ready;
+    for (size_t index = 0; index < _jobs.size(); ++index) {
+        if (waiting[index] == 0) {
+            ready.insert(index);
+        }
+    }
+
+    /* Running jobs, soonest to finish first. */
+    using Running = std::pair<int64_t, size_t>;
+    std::priority_queue<Running, std::vector<Running>, std::greater<Running>> running;
+
+    int64_t time = 0;
+    while (!ready.empty() || !running.empty()) {
+        /* Start what can start now; instant jobs finish right away. */
+        while (!ready.empty()) {
+            auto it = ready.begin();
+            size_t index = *it;
+            int64_t duration = (index < durations.size() ? durations[index] : 0);
+            if (duration > 0 && running.size() >= std::max<size_t>(slots, 1)) {
+                /* Instant jobs behind it can still start. */
+                it = std::find_if(ready.begin(), ready.end(), [&](size_t other) {
+                    return other >= durations.size() || durations[other] <= 0;
+                });
+                if (it == ready.end()) {
+                    break;
+                }
+                index = *it;
+                duration = 0;
+            }
+            ready.erase(it);
+
+            _jobs[index].start = time;
+            if (duration > 0) {
+                running.push({ time + duration, index });
+            } else {
+                _jobs[index].finish = time;
+                for (size_t dependent : dependents[index]) {
+                    if (--waiting[dependent] == 0) {
+                        ready.insert(dependent);
+                    }
+                }
+            }
+        }
+
+        if (running.empty()) {
+            break;
+        }
+
+        /* Advance to the next job finishing. */
+        Running next = running.top();
+        running.pop();
+        time = next.first;
+        _jobs[next.second].finish = time;
+        for (size_t dependent : dependents[next.second]) {
+            if (--waiting[dependent] == 0) {
+                ready.insert(dependent);
+            }
+        }
+    }
+}
+
+std::vector<size_t> BuildProfile::
+criticalPath() const
+{
+    /* Start from the job that finished last. No job is the end of the path. */
+    size_t none = _jobs.size();
+    size_t current = none;
+    for (size_t n = 0; n < _jobs.size(); ++n) {
+        if (_jobs[n].finish >= 0 && (current == none || _jobs[n].finish >= _jobs[current].finish)) {
+            current = n;
+        }
+    }
+
+    std::vector<size_t> path;
+    while (current != none) {
+        Job const &job = _jobs[current];
+        if (!job.name.empty()) {
+            path.push_back(current);
+        }
+
+        /* The dependency that finished last is the one this job waited for. */
+        size_t previous = none;
+        for (size_t dependency : job.dependencies) {
+            if (dependency < _jobs.size() && _jobs[dependency].finish >= 0 && (previous == none || _jobs[dependency].finish > _jobs[previous].finish)) {
+                previous = dependency;
+            }
+        }
+        current = previous;
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::vector<int64_t> BuildProfile::
+parallelism() const
+{
+    /* Starts sort before finishes at the same time, so instant jobs count. */
+    std::vector<std::pair<int64_t, int>> events;
+    for (Job const &job : _jobs) {
+        if (!job.name.empty() && job.start >= 0 && job.finish >= 0) {
+            events.push_back({ job.start, 1 });
+            events.push_back({ job.finish, -1 });
+        }
+    }
+    std::sort(events.begin(), events.end(), [](std::pair<int64_t, int> const &a, std::pair<int64_t, int> const &b) {
+        return a.first < b.first || (a.first == b.first && a.second > b.second);
+    });
+
+    std::vector<int64_t> result;
+    size_t running = 0;
+    int64_t previous = 0;
+    for (std::pair<int64_t, int> const &event : events) {
+        if (running > 0 || !result.empty()) {
+            if (result.size() <= running) {
+                result.resize(running + 1, 0);
+            }
+            result[running] += event.first - previous;
+        }
+
+        previous = event.first;
+        running += event.second;
+    }
+
+    return result;
+}
+
+static std::string
+Seconds(int64_t microseconds)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3fs", static_cast<double>(microseconds) / 1000000.0);
+    return buffer;
+}
+
+std::string BuildProfile::
+report() const
+{
+    std::string result;
+
+    std::vector<size_t> path = criticalPath();
+    int64_t pathTime = 0;
+    for (size_t index : path) {
+        pathTime += _jobs[index].finish - _jobs[index].start;
+    }
+
+    int64_t buildTime = 0;
+    for (Job const &job : _jobs) {
+        buildTime = std::max(buildTime, job.finish);
+    }
+
+    result += "Critical path: " + Seconds(pathTime) + " running of " + Seconds(buildTime) + "\n";
+
+    int64_t previousFinish = 0;
+    for (size_t index : path) {
+        Job const &job = _jobs[index];
+        result += "    " + Seconds(job.finish - job.start);
+        if (job.start > previousFinish) {
+            result += " (after " + Seconds(job.start - previousFinish) + " waiting)";
+        }
+        result += " " + job.target + ": " + job.name + "\n";
+        previousFinish = job.finish;
+    }
+    result += "\n";
+
+    std::vector<int64_t> profile = parallelism();
+    int64_t total = 0;
+    int64_t weighted = 0;
+    for (size_t running = 0; running < profile.size(); ++running) {
+        total += profile[running];
+        weighted += profile[running] * static_cast<int64_t>(running);
+    }
+
+    result += "Parallelism:";
+    if (total > 0) {
+        char average[32];
+        snprintf(average, sizeof(average), " %.2f jobs on average", static_cast<double>(weighted) / static_cast<double>(total));
+        result += average;
+    }
+    result += "\n";
+    for (size_t running = 0; running < profile.size(); ++running) {
+        if (profile[running] > 0) {
+            result += "    " + std::to_string(running) + " running: " + Seconds(profile[running]) + "\n";
+        }
+    }
+
+    return result;
+}
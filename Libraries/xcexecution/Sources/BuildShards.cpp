@@ -0,0 +1,108 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/BuildShards.h>
+
+#include <algorithm>
+
+using xcexecution::BuildShards;
+
+std::vector<std::vector<size_t>> BuildShards::
+Partition(std::vector<std::vector<size_t>> const &dependencies, std::vector<int64_t> const &durations, size_t count)
+{
+    size_t size = dependencies.size();
+
+    /* Each target with everything it depends on, directly or not. */
+    std::vector<std::vector<size_t>> closures;
+    std::vector<int64_t> closureDurations;
+    std::vector<bool> depended = std::vector<bool>(size, false);
+    for (size_t target = 0; target < size; ++target) {
+        std::vector<bool> visited = std::vector<bool>(size, false);
+        std::vector<size_t> stack = { target };
+        visited[target] = true;
+
+        std::vector<size_t> closure;
+        int64_t duration = 0;
+        while (!stack.empty()) {
+            size_t index = stack.back();
+            stack.pop_back();
+            closure.push_back(index);
+            duration += durations[index];
+
+            for (size_t dependency : dependencies[index]) {
+                depended[dependency] = true;
+                if (!visited[dependency]) {
+                    visited[dependency] = true;
+                    stack.push_back(dependency);
+                }
+            }
+        }
+
+        closures.push_back(closure);
+        closureDurations.push_back(duration);
+    }
+
+    /* Only targets nothing depends on need assigning; the rest come along. */
+    std::vector<size_t> roots;
+    for (size_t target = 0; target < size; ++target) {
+        if (!depended[target]) {
+            roots.push_back(target);
+        }
+    }
+    std::stable_sort(roots.begin(), roots.end(), [&](size_t a, size_t b) {
+        return closureDurations[a] > closureDurations[b];
+    });
+
+    count = std::max<size_t>(count, 1);
+    std::vector<std::vector<bool>> built = std::vector<std::vector<bool>>(count, std::vector<bool>(size, false));
+    std::vector<int64_t> loads = std::vector<int64_t>(count, 0);
+
+    for (size_t root : roots) {
+        /*
+         * Only what a shard doesn't already build adds to it. Building the
+         * same dependency in another shard is counted again, so targets stay
+         * with their dependencies unless another shard is much shorter.
+         */
+        size_t best = 0;
+        int64_t bestLoad = 0;
+        int64_t bestScore = 0;
+        for (size_t shard = 0; shard < count; ++shard) {
+            int64_t added = 0;
+            for (size_t index : closures[root]) {
+                if (!built[shard][index]) {
+                    added += durations[index];
+                }
+            }
+
+            int64_t score = loads[shard] + added * 2;
+            if (shard == 0 || score < bestScore) {
+                best = shard;
+                bestLoad = loads[shard] + added;
+                bestScore = score;
+            }
+        }
+
+        for (size_t index : closures[root]) {
+            built[best][index] = true;
+        }
+        loads[best] = bestLoad;
+    }
+
+    std::vector<std::vector<size_t>> result;
+    for (size_t shard = 0; shard < count; ++shard) {
+        std::vector<size_t> targets;
+        for (size_t target = 0; target < size; ++target) {
+            if (built[shard][target]) {
+                targets.push_back(target);
+            }
+        }
+        result.push_back(targets);
+    }
+    return result;
+}
@@ -0,0 +1,87 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/CommandRemoteCache.h>
+#include <process/Context.h>
+#include <process/Launcher.h>
+#include <process/MemoryContext.h>
+#include <libutil/Filesystem.h>
+
+using xcexecution::CommandRemoteCache;
+using libutil::Filesystem;
+
+CommandRemoteCache::
+CommandRemoteCache(process::Launcher *launcher, process::Context const *context, std::string const &helper) :
+    RemoteCache(),
+    _launcher  (launcher),
+    _context   (context),
+    _helper    (helper)
+{
+}
+
+CommandRemoteCache::
+~CommandRemoteCache()
+{
+}
+
+bool CommandRemoteCache::
+run(Filesystem *filesystem, std::string const &operation, Kind kind, std::string const &name, std::string const &path) const
+{
+    std::string kindName;
+    switch (kind) {
+        case Kind::Action:
+            kindName = "ac";
+            break;
+        case Kind::Object:
+            kindName = "cas";
+            break;
+    }
+
+    process::MemoryContext context = process::MemoryContext(
+        _helper,
+        _context->currentDirectory(),
+        { operation, kindName, name, path },
+        _context->environmentVariables(),
+        _context->userID(),
+        _context->groupID(),
+        _context->userName(),
+        _context->groupName());
+
+    ext::optional<int> exitCode = _launcher->launch(filesystem, &context);
+    return (exitCode && *exitCode == 0);
+}
+
+bool CommandRemoteCache::
+fetch(Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const
+{
+    /* A helper could fail after starting to write; only complete files count. */
+    if (!run(filesystem, "get", kind, name, path)) {
+        filesystem->removeFile(path);
+        return false;
+    }
+
+    return (filesystem->type(path) == Filesystem::Type::File);
+}
+
+bool CommandRemoteCache::
+upload(Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const
+{
+    return run(filesystem, "put", kind, name, path);
+}
+
+ext::optional<std::string> CommandRemoteCache::
+Helper(process::Context const *context)
+{
+    ext::optional<std::string> helper = context->environmentVariable("XCBUILD_ACTION_CACHE_REMOTE");
+    if (helper && helper->empty()) {
+        return ext::nullopt;
+    }
+
+    return helper;
+}
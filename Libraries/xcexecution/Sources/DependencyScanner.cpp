@@ -0,0 +1,218 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/DependencyScanner.h>
+#include <dependency/MakefileDependencyInfo.h>
+#include <process/Context.h>
+#include <process/Launcher.h>
+#include <process/MemoryContext.h>
+#include <libutil/Escape.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+
+using xcexecution::DependencyScanner;
+using libutil::Escape;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+bool DependencyScanner::
+Scannable(pbxbuild::Tool::Invocation const &invocation)
+{
+    if (!invocation.executable() || !invocation.executable()->external()) {
+        return false;
+    }
+
+    if (invocation.toolIdentifier().compare(0, 30, "com.apple.compilers.llvm.clang") != 0) {
+        return false;
+    }
+
+    /* One source, compiled to one output the dependencies are listed under. */
+    if (invocation.inputs().size() != 1 || invocation.outputs().empty()) {
+        return false;
+    }
+
+    return std::any_of(invocation.dependencyInfo().begin(), invocation.dependencyInfo().end(), [](pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo) {
+        return dependencyInfo.format() == dependency::DependencyInfoFormat::Makefile;
+    });
+}
+
+std::string DependencyScanner::
+CompilationDatabase(std::vector<std::pair<std::string, pbxbuild::Tool::Invocation const *>> const &compiles)
+{
+    std::string result = "[";
+
+    for (auto const &compile : compiles) {
+        pbxbuild::Tool::Invocation const *invocation = compile.second;
+
+        result += (result.size() > 1 ? ",\n" : "\n");
+        result += "{\"directory\":" + Escape::JSON(invocation->workingDirectory());
+        result += ",\"file\":" + Escape::JSON(invocation->inputs().front());
+        result += ",\"output\":" + Escape::JSON(invocation->outputs().front());
+        result += ",\"arguments\":[" + Escape::JSON(compile.first);
+
+        std::vector<std::string> const &arguments = invocation->arguments();
+        for (auto it = arguments.begin(); it != arguments.end(); ++it) {
+            if (*it == "-MD" || *it == "-MMD") {
+                continue;
+            } else if (*it == "-MT" || *it == "-MQ" || *it == "-MF") {
+                if (it + 1 != arguments.end()) {
+                    ++it;
+                }
+                continue;
+            }
+
+            result += "," + Escape::JSON(*it);
+        }
+
+        result += "]}";
+    }
+
+    result += "\n]\n";
+    return result;
+}
+
+std::unordered_map<std::string, std::vector<std::string>> DependencyScanner::
+Dependencies(std::string const &output, std::unordered_set<std::string> const &outputs)
+{
+    std::unordered_map<std::string, std::string> targets;
+    for (std::string const &path : outputs) {
+        targets.insert({ Escape::Makefile(path) + ":", path });
+    }
+
+    std::unordered_map<std::string, std::vector<std::string>> result;
+
+    /*
+     * Each rule starts with one of the outputs, and continues while lines
+     * end with a backslash. Rules are parsed one at a time, so other lines
+     * between them don't affect them.
+     */
+    std::string rule;
+    bool continued = false;
+
+    size_t start = 0;
+    while (start < output.size()) {
+        size_t end = output.find('\n', start);
+        if (end == std::string::npos) {
+            end = output.size();
+        }
+        std::string line = output.substr(start, end - start);
+        start = end + 1;
+
+        if (!continued) {
+            size_t colon = line.find(':');
+            while (colon != std::string::npos && colon > 0 && line[colon - 1] == '\\') {
+                colon = line.find(':', colon + 1);
+            }
+
+            if (colon == std::string::npos || targets.find(line.substr(0, colon + 1)) == targets.end()) {
+                continue;
+            }
+        }
+
+        rule += line + "\n";
+        continued = (!line.empty() && line.back() == '\\');
+        if (continued) {
+            continue;
+        }
+
+        if (ext::optional<dependency::MakefileDependencyInfo> makefile = dependency::MakefileDependencyInfo::Deserialize(rule)) {
+            for (dependency::DependencyInfo const &dependencyInfo : makefile->dependencyInfo()) {
+                for (std::string const &path : dependencyInfo.outputs()) {
+                    std::vector<std::string> *inputs = &result[path];
+                    inputs->insert(inputs->end(), dependencyInfo.inputs().begin(), dependencyInfo.inputs().end());
+                }
+            }
+        }
+        rule.clear();
+    }
+
+    return result;
+}
+
+bool DependencyScanner::
+Scan(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    std::string const &scannerPath,
+    std::string const &databasePath,
+    std::vector<std::string> const &executablePaths,
+    size_t jobs,
+    std::vector<pbxbuild::Tool::Invocation> *invocations)
+{
+    std::vector<std::pair<std::string, pbxbuild::Tool::Invocation const *>> compiles;
+    std::unordered_map<std::string, pbxbuild::Tool::Invocation *> outputToInvocation;
+    std::unordered_set<std::string> outputs;
+
+    for (pbxbuild::Tool::Invocation &invocation : *invocations) {
+        if (!Scannable(invocation)) {
+            continue;
+        }
+
+        std::string const &external = *invocation.executable()->external();
+        ext::optional<std::string> path;
+        if (FSUtil::IsAbsolutePath(external)) {
+            path = external;
+        } else {
+            path = filesystem->findExecutable(external, executablePaths);
+        }
+        if (!path) {
+            continue;
+        }
+
+        compiles.push_back({ *path, &invocation });
+        outputToInvocation.insert({ invocation.outputs().front(), &invocation });
+        outputs.insert(invocation.outputs().front());
+    }
+
+    if (compiles.empty()) {
+        return true;
+    }
+
+    std::string database = CompilationDatabase(compiles);
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(databasePath), true) ||
+        !filesystem->write(std::vector<uint8_t>(database.begin(), database.end()), databasePath)) {
+        return false;
+    }
+
+    process::MemoryContext context = process::MemoryContext(
+        scannerPath,
+        processContext->currentDirectory(),
+        { "-format", "make", "-j", std::to_string(jobs), "-compilation-database", databasePath },
+        processContext->environmentVariables(),
+        processContext->userID(),
+        processContext->groupID(),
+        processContext->userName(),
+        processContext->groupName());
+
+    /* Compiles that fail to scan fail the scanner, but the others are still listed. */
+    std::string output;
+    if (!processLauncher->launch(filesystem, &context, nullptr, &output)) {
+        return false;
+    }
+
+    for (auto const &entry : Dependencies(output, outputs)) {
+        pbxbuild::Tool::Invocation *invocation = outputToInvocation.at(entry.first);
+
+        std::unordered_set<std::string> existing;
+        existing.insert(invocation->inputs().begin(), invocation->inputs().end());
+        existing.insert(invocation->inputDependencies().begin(), invocation->inputDependencies().end());
+
+        for (std::string const &input : entry.second) {
+            std::string path = FSUtil::ResolveRelativePath(input, invocation->workingDirectory());
+            if (existing.insert(path).second) {
+                invocation->inputDependencies().push_back(path);
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,173 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/InputAudit.h>
+#include <dependency/DependencyInfoMerger.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_set>
+
+#include <unistd.h>
+
+using xcexecution::InputAudit;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+InputAudit::
+InputAudit(std::string const &tracerPath, std::string const &temporaryDirectory, std::vector<std::string> const &ignoredDirectories) :
+    _tracerPath        (tracerPath),
+    _temporaryDirectory(temporaryDirectory),
+    _ignoredDirectories(ignoredDirectories),
+    _nextTrace         (0)
+{
+}
+
+std::string InputAudit::
+tracePath()
+{
+    return _temporaryDirectory + "/xcbuild-trace-" + std::to_string(::getpid()) + "-" + std::to_string(_nextTrace++);
+}
+
+std::vector<std::string> InputAudit::
+arguments(std::string const &tracePath, std::string const &executablePath, std::vector<std::string> const &arguments) const
+{
+    /* Record reads, writes, moves, and deletes. */
+    std::vector<std::string> tracerArguments = { "rwmd", tracePath, "--", executablePath };
+    tracerArguments.insert(tracerArguments.end(), arguments.begin(), arguments.end());
+    return tracerArguments;
+}
+
+static std::string
+AbsolutePath(std::string const &path, std::string const &workingDirectory)
+{
+    return FSUtil::NormalizePath(FSUtil::ResolveRelativePath(path, workingDirectory));
+}
+
+std::vector<std::string> InputAudit::
+audit(Filesystem *filesystem, pbxbuild::Tool::Invocation const &invocation, std::string const &executablePath, std::string const &tracePath)
+{
+    std::vector<uint8_t> contents;
+    bool traced = filesystem->read(&contents, tracePath);
+    filesystem->removeFile(tracePath);
+
+    std::unordered_set<std::string> declared;
+    declared.insert(AbsolutePath(executablePath, invocation.workingDirectory()));
+
+    dependency::DependencyInfoMerger merger = dependency::DependencyInfoMerger(invocation.workingDirectory());
+    for (std::string const &input : invocation.inputs()) {
+        merger.add(input);
+    }
+    for (std::string const &input : invocation.inputDependencies()) {
+        merger.add(input);
+    }
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        std::string path = AbsolutePath(dependencyInfo.path(), invocation.workingDirectory());
+        declared.insert(path);
+        merger.add(filesystem, dependencyInfo.format(), path);
+    }
+    for (std::string const *input : merger.inputs()) {
+        declared.insert(AbsolutePath(*input, invocation.workingDirectory()));
+    }
+    for (std::string const &output : invocation.outputs()) {
+        declared.insert(AbsolutePath(output, invocation.workingDirectory()));
+    }
+
+    std::vector<std::string> undeclared;
+    if (traced) {
+        for (std::string const &read : Reads(std::string(contents.begin(), contents.end()))) {
+            std::string path = AbsolutePath(read, invocation.workingDirectory());
+            if (declared.find(path) != declared.end()) {
+                continue;
+            }
+
+            bool ignored = std::any_of(_ignoredDirectories.begin(), _ignoredDirectories.end(), [&](std::string const &directory) {
+                return path.compare(0, directory.size(), directory) == 0 && (path.size() == directory.size() || path[directory.size()] == '/');
+            });
+
+            /* Directories are listed rather than read. */
+            if (!ignored && filesystem->type(path) == Filesystem::Type::File) {
+                undeclared.push_back(path);
+            }
+        }
+    }
+
+    std::sort(undeclared.begin(), undeclared.end());
+
+    /* Without a trace, nothing is known about the reads. */
+    std::pair<size_t, size_t> &tool = _tools[FSUtil::GetBaseName(executablePath)];
+    tool.first++;
+    if (!traced || !undeclared.empty()) {
+        tool.second++;
+    }
+
+    return undeclared;
+}
+
+std::vector<std::string> InputAudit::
+Reads(std::string const &trace)
+{
+    std::vector<std::string> reads;
+    std::unordered_set<std::string> seen;
+    std::unordered_set<std::string> written;
+
+    std::istringstream stream = std::istringstream(trace);
+    std::string line;
+    while (std::getline(stream, line)) {
+        /* Each line is an operation then its paths, separated by '|'. */
+        if (line.size() < 3 || line[1] != '|') {
+            continue;
+        }
+
+        std::string path = line.substr(2);
+        switch (line[0]) {
+            case 'r':
+                if (seen.insert(path).second) {
+                    reads.push_back(path);
+                }
+                break;
+            case 'w':
+            case 'd':
+                written.insert(path);
+                break;
+            case 'm':
+                /* Moves list the destination, then the source. */
+                written.insert(path.substr(0, path.find('|')));
+                break;
+            default:
+                break;
+        }
+    }
+
+    reads.erase(std::remove_if(reads.begin(), reads.end(), [&](std::string const &path) {
+        return written.find(path) != written.end();
+    }), reads.end());
+    return reads;
+}
+
+std::vector<std::string> InputAudit::
+DefaultIgnoredDirectories()
+{
+    return {
+        "/bin",
+        "/dev",
+        "/etc",
+        "/lib",
+        "/lib64",
+        "/proc",
+        "/sys",
+        "/usr",
+        "/Library",
+        "/System",
+        "/private/etc",
+        "/private/var/db",
+    };
+}
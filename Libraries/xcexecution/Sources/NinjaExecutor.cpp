@@ -9,35 +9,58 @@
 
 #include <xcexecution/NinjaExecutor.h>
 
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/CommandRemoteCache.h>
 #include <xcexecution/Parameters.h>
+#include <pbxbuild/Build/Jobs.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/PhaseInvocations.h>
+#include <pbxbuild/Tool/AssetCatalogResolver.h>
+#include <pbxbuild/Tool/InterfaceBuilderResolver.h>
+#include <pbxbuild/Tool/LinkerResolver.h>
+#include <pbxbuild/Tool/SwiftResolver.h>
+#include <pbxsetting/Type.h>
 #include <ninja/Writer.h>
 #include <ninja/Value.h>
 #include <plist/Data.h>
+#include <libutil/CachingFilesystem.h>
 #include <libutil/Escape.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+#include <libutil/PathTable.h>
+#include <libutil/Trace.h>
 #include <process/Context.h>
 #include <process/MemoryContext.h>
 #include <process/Launcher.h>
+#include <builtin/Server.h>
 #include <libutil/md5.h>
 
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 
+using xcexecution::ActionCache;
+using xcexecution::CommandRemoteCache;
 using xcexecution::NinjaExecutor;
 using xcexecution::Parameters;
 using libutil::Escape;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 
 NinjaExecutor::
-NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
-    Executor(formatter, dryRun, generate)
+NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool actionCache) :
+    Executor    (formatter, dryRun, generate),
+    _actionCache(actionCache)
 {
 }
 
@@ -114,6 +137,219 @@ NinjaHash(std::string const &input)
     return ss.str();
 }
 
+/*
+ * By default, allow half as many of a pool's tools as there are jobs.
+ */
+static size_t
+NinjaPoolDefaultDepth(pbxsetting::Environment const &environment)
+{
+    return std::max<size_t>(pbxbuild::Build::Jobs::Count(environment) / 2, 1);
+}
+
+struct NinjaPool {
+    std::string name;
+    std::string depthSetting;
+    size_t (*defaultDepth)(pbxsetting::Environment const &);
+    std::vector<std::string> toolIdentifiers;
+};
+
+static std::vector<NinjaPool> const &
+NinjaPools()
+{
+    /*
+     * Tools that can use a lot of memory each. Running as many of these as
+     * there are cores can exhaust memory, so they are limited separately.
+     */
+    static std::vector<NinjaPool> const *pools = new std::vector<NinjaPool>({
+        { "link", "NINJA_LINK_POOL_DEPTH", &NinjaPoolDefaultDepth, {
+            pbxbuild::Tool::LinkerResolver::LinkerToolIdentifier(),
+            pbxbuild::Tool::LinkerResolver::LibtoolToolIdentifier(),
+        } },
+        /* Swift compiles use several threads each, and divide the jobs between them. */
+        { "swift", "NINJA_SWIFT_POOL_DEPTH", &pbxbuild::Build::Jobs::SwiftCompiles, {
+            pbxbuild::Tool::SwiftResolver::ToolIdentifier(),
+        } },
+        { "assetcatalog", "NINJA_ASSET_CATALOG_POOL_DEPTH", &NinjaPoolDefaultDepth, {
+            pbxbuild::Tool::AssetCatalogResolver::ToolIdentifier(),
+        } },
+        /* One per storyboard or XIB; each loads its whole document graph. */
+        { "ibtool", "NINJA_IBTOOL_POOL_DEPTH", &NinjaPoolDefaultDepth, {
+            pbxbuild::Tool::InterfaceBuilderResolver::CompilerToolIdentifier(),
+            pbxbuild::Tool::InterfaceBuilderResolver::StoryboardCompilerToolIdentifier(),
+        } },
+    });
+    return *pools;
+}
+
+static std::unordered_map<std::string, std::string>
+WriteNinjaPools(ninja::Writer *writer, pbxsetting::Environment const &environment)
+{
+    std::unordered_map<std::string, std::string> toolPools;
+
+    for (NinjaPool const &pool : NinjaPools()) {
+        /*
+         * By default, the depth comes from the build's jobs. A depth of zero
+         * removes the limit.
+         */
+        int64_t depth = static_cast<int64_t>(pool.defaultDepth(environment));
+
+        std::string depthValue = environment.resolve(pool.depthSetting);
+        if (!depthValue.empty()) {
+            depth = pbxsetting::Type::ParseInteger(depthValue);
+        }
+
+        if (depth <= 0) {
+            continue;
+        }
+
+        writer->pool(pool.name, static_cast<int>(depth));
+        for (std::string const &toolIdentifier : pool.toolIdentifiers) {
+            toolPools.insert({ toolIdentifier, pool.name });
+        }
+    }
+
+    return toolPools;
+}
+
+static std::string
+TargetNinjaInputsHash(
+    Filesystem const *filesystem,
+    Parameters const &buildParameters,
+    std::string const &dependencyInfoToolPath,
+    std::string const &actionCacheCommand,
+    std::string const &builtinClientPath,
+    std::string const &builtinSocketPath,
+    std::unordered_map<std::string, std::string> const &toolPools,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment)
+{
+    /* Separate each input with a NUL, which can't appear in them. */
+    std::string inputs;
+    auto append = [&inputs](std::string const &input) {
+        inputs += input;
+        inputs += '\0';
+    };
+
+    append(buildParameters.canonicalHash());
+    append(dependencyInfoToolPath);
+    append(actionCacheCommand);
+    append(builtinClientPath);
+    append(builtinSocketPath);
+    append(target->name());
+    append(target->blueprintIdentifier());
+
+    /* Invocations refer to pools by name, so only declared pools can be used. */
+    std::map<std::string, std::string> orderedToolPools = std::map<std::string, std::string>(toolPools.begin(), toolPools.end());
+    for (auto const &toolPool : orderedToolPools) {
+        append(toolPool.first);
+        append(toolPool.second);
+    }
+
+    /*
+     * The target's build phases and files come from its project. Without a
+     * finer-grained view of which objects the target uses, include it all.
+     */
+    std::vector<uint8_t> project;
+    if (!filesystem->read(&project, target->project()->dataFile())) {
+        /* Unreadable project: the hash can't match any earlier one. */
+        append(std::string(1, '\1'));
+    }
+    append(std::string(project.begin(), project.end()));
+
+    for (std::string const &executablePath : targetEnvironment.executablePaths()) {
+        append(executablePath);
+    }
+
+    /*
+     * Settings, in a stable order. These include any configuration files,
+     * the SDK, and everything else the target's invocations are built from.
+     */
+    std::unordered_map<std::string, std::string> values = targetEnvironment.environment().computeValues(pbxsetting::Condition::Empty());
+    std::map<std::string, std::string> orderedValues = std::map<std::string, std::string>(values.begin(), values.end());
+    for (auto const &value : orderedValues) {
+        append(value.first);
+        append(value.second);
+    }
+
+    return NinjaHash(inputs);
+}
+
+static std::string
+TargetNinjaInputsComment(std::string const &inputsHash)
+{
+    return "Inputs: " + inputsHash;
+}
+
+static bool
+TargetNinjaUpToDate(Filesystem const *filesystem, std::string const &path, std::string const &inputsHash)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return false;
+    }
+
+    /*
+     * The inputs hash is written as a comment near the top of the file.
+     */
+    ninja::Writer writer;
+    writer.comment(TargetNinjaInputsComment(inputsHash));
+    std::string comment = writer.serialize();
+
+    return std::search(contents.begin(), contents.end(), comment.begin(), comment.end()) != contents.end();
+}
+
+static std::string
+TargetNinjaSharedComment(std::string const &path)
+{
+    return "Shared: " + path;
+}
+
+/*
+ * The shared Ninja files a target's Ninja file uses, from the comments
+ * noting them near the top of the file.
+ */
+static std::vector<std::string>
+TargetNinjaSharedPaths(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<std::string> paths;
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return paths;
+    }
+
+    ninja::Writer writer;
+    writer.comment(TargetNinjaSharedComment(""));
+    std::string prefix = writer.serialize();
+    prefix.pop_back();
+
+    std::string text = std::string(contents.begin(), contents.end());
+    for (size_t start = text.find(prefix); start != std::string::npos; start = text.find(prefix, start)) {
+        start += prefix.size();
+        size_t end = text.find('\n', start);
+        paths.push_back(text.substr(start, end - start));
+    }
+
+    return paths;
+}
+
+/*
+ * Outputs shared between targets, such as precompiled headers, are built by
+ * a Ninja file of their own, so they're only built once however many
+ * targets use them.
+ */
+static bool
+IsSharedOutput(std::string const &path, std::string const &sharedDirectory)
+{
+    return !sharedDirectory.empty() && path.size() > sharedDirectory.size() && path.compare(0, sharedDirectory.size(), sharedDirectory) == 0 && path[sharedDirectory.size()] == '/';
+}
+
+static std::string
+SharedNinjaWriteAuxiliaryFiles(std::string const &directory)
+{
+    return "write-auxiliary-files-" + directory;
+}
+
 static ext::optional<std::string>
 NinjaExecutablePath(
     process::Context const *processContext,
@@ -139,6 +375,44 @@ NinjaExecutablePath(
     }
 }
 
+static std::string
+NinjaInvocationExecutable(
+    pbxbuild::Tool::Invocation const &invocation,
+    std::string const &executablePath,
+    std::string const &builtinClientPath,
+    std::string const &builtinSocketPath)
+{
+    /*
+     * Must escape for shell arguments as Ninja passes the command string directly
+     * to the shell, which would interpret spaces, etc as meaningful.
+     */
+    if (invocation.executable()->builtin() && !builtinClientPath.empty()) {
+        /* Run builtin tools in the builtin server, rather than starting each one. */
+        return Escape::Shell(builtinClientPath) + " " + Escape::Shell(builtinSocketPath) + " " + Escape::Shell(*invocation.executable()->builtin());
+    } else {
+        return Escape::Shell(executablePath);
+    }
+}
+
+static std::string
+NinjaInvocationEnvironment(pbxbuild::Tool::Invocation const &invocation)
+{
+    /*
+     * Build the invocation environment. To set the environment, we use standard shell syntax.
+     * Use `env` to avoid Bash-specific limitations on environment variables. Specifically, some
+     * versions of Bash don't allow setting "UID". Pass -i to clear out the environment.
+     */
+    std::string environment;
+    for (auto it = invocation.environment().begin(); it != invocation.environment().end(); ++it) {
+        if (it != invocation.environment().begin()) {
+            environment += " ";
+        }
+        environment += it->first + "=" + Escape::Shell(it->second);
+    }
+
+    return environment;
+}
+
 static std::string
 NinjaInvocationPhonyOutput(pbxbuild::Tool::Invocation const &invocation)
 {
@@ -194,13 +468,17 @@ WriteNinjaRegenerate(
     std::string const &workingDirectory,
     std::string const &ninjaPath,
     std::string const &configurationHashPath,
-    std::vector<std::string> const &inputPaths)
+    std::vector<std::string> const &inputPaths,
+    bool actionCache)
 {
     /*
      * Regenerate using this executor. Force regeneration to avoid recursively
      * executing Ninja when Ninja itself calls this generate command.
      */
     std::vector<std::string> generateArguments = { "-generate", "-executor", "ninja" };
+    if (actionCache) {
+        generateArguments.push_back("-actionCache");
+    }
 
     /*
      * Add arguments necessary to recreate the same set of build parameters.
@@ -218,7 +496,8 @@ WriteNinjaRegenerate(
      * Escape executable and input parameters for Ninja.
      */
     for (std::string const &arg : generateArguments) {
-        exec += " " + Escape::Shell(arg);
+        exec += ' ';
+        Escape::Shell(arg, &exec);
     }
     std::vector<ninja::Value> inputPathValues;
     inputPathValues.push_back(ninja::Value::String(configurationHashPath));
@@ -250,23 +529,118 @@ WriteNinjaRegenerate(
 }
 
 static bool
-WriteNinja(Filesystem *filesystem, ninja::Writer const &writer, std::string const &path)
+WriteNinja(Filesystem *filesystem, ninja::Writer const &writer, std::string const &path, bool touch)
 {
     if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true)) {
         return false;
     }
 
-    std::string contents = writer.serialize();
-    std::vector<uint8_t> copy = std::vector<uint8_t>(contents.begin(), contents.end());
-    if (!filesystem->write(copy, path)) {
+    std::vector<uint8_t> const &contents = writer.contents();
+
+    /*
+     * Leave identical files alone so their modification time is preserved,
+     * unless the caller needs the file to appear updated.
+     */
+    if (!touch && filesystem->type(path) == Filesystem::Type::File) {
+        std::vector<uint8_t> existing;
+        if (filesystem->read(&existing, path) && existing == contents) {
+            return true;
+        }
+    }
+
+    /* A running Ninja never reads a partially written file. */
+    return filesystem->writeAtomically(contents, path);
+}
+
+static std::string
+NinjaInputsManifestLine(Filesystem const *filesystem, std::string const &path)
+{
+    /*
+     * Each line has a loaded file's size, modification time, contents hash, and
+     * path. The path goes last, since it can contain spaces.
+     */
+    Filesystem::Stamp stamp = filesystem->readFileStamp(path).value_or(Filesystem::Stamp({ 0, 0 }));
+
+    std::string hash;
+    std::vector<uint8_t> contents;
+    if (filesystem->read(&contents, path)) {
+        hash = NinjaHash(std::string(contents.begin(), contents.end()));
+    } else {
+        /* Unreadable: no hash, so it can't match later. */
+        hash = "-";
+    }
+
+    return std::to_string(stamp.size) + " " + std::to_string(stamp.modificationTime) + " " + hash + " " + path + "\n";
+}
+
+static bool
+WriteNinjaInputsManifest(Filesystem *filesystem, std::string const &manifestPath, std::vector<std::string> const &inputPaths)
+{
+    std::string manifest;
+    for (std::string const &inputPath : inputPaths) {
+        manifest += NinjaInputsManifestLine(filesystem, inputPath);
+    }
+
+    return filesystem->write(std::vector<uint8_t>(manifest.begin(), manifest.end()), manifestPath);
+}
+
+static bool
+NinjaInputsUnchanged(Filesystem const *filesystem, std::string const &manifestPath, std::vector<std::string> *inputPaths, bool *restamped)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, manifestPath)) {
+        /* No record of the inputs, so they could have changed. */
         return false;
     }
 
+    std::string manifest = std::string(contents.begin(), contents.end());
+    *restamped = false;
+
+    std::string::size_type start = 0;
+    while (start < manifest.size()) {
+        std::string::size_type end = manifest.find('\n', start);
+        if (end == std::string::npos) {
+            return false;
+        }
+
+        std::string line = manifest.substr(start, end - start);
+        start = end + 1;
+
+        std::string::size_type sizeEnd = line.find(' ');
+        std::string::size_type timeEnd = (sizeEnd != std::string::npos ? line.find(' ', sizeEnd + 1) : std::string::npos);
+        std::string::size_type hashEnd = (timeEnd != std::string::npos ? line.find(' ', timeEnd + 1) : std::string::npos);
+        if (hashEnd == std::string::npos) {
+            return false;
+        }
+
+        std::string path = line.substr(hashEnd + 1);
+        inputPaths->push_back(path);
+
+        /*
+         * Usually the stamp alone shows the file is unchanged. Otherwise, compare the
+         * contents: files are often touched without changing, like by source control.
+         */
+        ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(path);
+        if (stamp && line.compare(0, timeEnd, std::to_string(stamp->size) + " " + std::to_string(stamp->modificationTime)) == 0) {
+            continue;
+        }
+
+        std::vector<uint8_t> fileContents;
+        if (!filesystem->read(&fileContents, path)) {
+            return false;
+        }
+        if (NinjaHash(std::string(fileContents.begin(), fileContents.end())) != line.substr(timeEnd + 1, hashEnd - timeEnd - 1)) {
+            return false;
+        }
+
+        *restamped = true;
+    }
+
     return true;
 }
 
 static bool
-ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters const &buildParameters, std::string const &ninjaPath, std::string const &configurationHashPath)
+ShouldGenerateNinja(Filesystem const *filesystem, bool generate, std::string const &configurationHash, std::string const &ninjaPath, std::string const &configurationHashPath)
 {
     /*
      * If explicitly asked to generate, definitely need to regenerate.
@@ -299,7 +673,7 @@ ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters cons
         /* Can't be read, same as not existing. */
         return true;
     }
-    if (std::string(contents.begin(), contents.end()) != buildParameters.canonicalHash()) {
+    if (std::string(contents.begin(), contents.end()) != configurationHash) {
         return true;
     }
 
@@ -339,6 +713,7 @@ build(
     std::string intermediatesDirectory = environment.resolve("OBJROOT");
     std::string ninjaPath = intermediatesDirectory + "/" + "build.ninja";
     std::string configurationHashPath = intermediatesDirectory + "/" + ".ninja-configuration";
+    std::string inputsManifestPath = intermediatesDirectory + "/" + ".ninja-inputs";
 
     /*
      * Find the dependency info tool.
@@ -346,10 +721,70 @@ build(
     std::string executableRoot = FSUtil::GetDirectoryName(processContext->executablePath());
     std::string dependencyInfoToolPath = executableRoot + "/" + "dependency-info-tool";
 
+    /*
+     * Find the action cache tool, which compile invocations run through. The
+     * cache is shared by all workspaces, so switching between them also hits.
+     */
+    std::string actionCacheCommand;
+    std::string actionCacheToolPath = executableRoot + "/" + "action-cache-tool";
+    if (_actionCache && filesystem->isExecutable(actionCacheToolPath)) {
+        std::string actionCachePath = ActionCache::DefaultPath(environment.resolve("DERIVED_DATA_DIR"));
+        actionCacheCommand = Escape::Shell(actionCacheToolPath) + " --cache " + Escape::Shell(actionCachePath);
+        if (ext::optional<std::string> helper = CommandRemoteCache::Helper(processContext)) {
+            actionCacheCommand += " --remote " + Escape::Shell(*helper);
+        }
+    }
+
+    /*
+     * The Ninja file depends on the parameters, and on whether the action cache is used.
+     */
+    std::string configurationHash = buildParameters.canonicalHash();
+    if (!actionCacheCommand.empty()) {
+        configurationHash += "\n" + actionCacheCommand;
+    }
+
+    /*
+     * Find the builtin server and its client. Builtin tools run through the server when
+     * both are available. The socket is in a directory private to the user, with a name
+     * kept short to fit in a socket address.
+     */
+    std::string builtinServerPath = executableRoot + "/" + "builtin-server";
+    std::string builtinClientPath = executableRoot + "/" + "builtin-client";
+    std::string builtinSocketPath;
+    ext::optional<std::string> builtinSocketDirectory = builtin::Server::SocketDirectory(processContext);
+    if (builtinSocketDirectory && filesystem->isExecutable(builtinServerPath) && filesystem->isExecutable(builtinClientPath)) {
+        builtinSocketPath = *builtinSocketDirectory + "/builtin-" + NinjaHash(intermediatesDirectory) + ".sock";
+    } else {
+        builtinClientPath = std::string();
+    }
+
+    /*
+     * Check the files loaded to generate the Ninja file. If any changed, it's out of
+     * date. If some were only touched, record their new stamps and update the Ninja
+     * file's modification time too, so Ninja doesn't regenerate it for them either.
+     */
+    bool generate = ShouldGenerateNinja(filesystem, _generate, configurationHash, ninjaPath, configurationHashPath);
+    if (!generate) {
+        std::vector<std::string> inputPaths;
+        bool restamped = false;
+
+        if (!NinjaInputsUnchanged(filesystem, inputsManifestPath, &inputPaths, &restamped)) {
+            generate = true;
+        } else if (restamped) {
+            std::vector<uint8_t> contents;
+            if (!WriteNinjaInputsManifest(filesystem, inputsManifestPath, inputPaths) ||
+                !filesystem->read(&contents, ninjaPath) ||
+                !filesystem->write(contents, ninjaPath + ".tmp") ||
+                !filesystem->moveFile(ninjaPath + ".tmp", ninjaPath)) {
+                generate = true;
+            }
+        }
+    }
+
     /*
      * If the Ninja file needs to be generated, generate it.
      */
-    if (ShouldGenerateNinja(filesystem, _generate, buildParameters, ninjaPath, configurationHashPath)) {
+    if (generate) {
         fprintf(stderr, "Generating Ninja files...\n");
 
         /*
@@ -362,12 +797,21 @@ build(
             return false;
         }
 
+        /* Later builds can open the projects from the snapshots. */
+        workspaceContext->saveProjectSnapshots(filesystem, buildEnvironment.baseEnvironment());
+
         ext::optional<pbxbuild::Build::Context> buildContext = buildParameters.createBuildContext(*workspaceContext);
         if (!buildContext) {
             fprintf(stderr, "error: unable to create build context\n");
             return false;
         }
 
+        /* File types detected by earlier builds are used again for unchanged files. */
+        std::string fileTypeCachePath = workspaceContext->fileTypeCachePath(buildEnvironment.baseEnvironment());
+        if (!fileTypeCachePath.empty()) {
+            buildContext->fileTypeCache()->load(filesystem, fileTypeCachePath);
+        }
+
         ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
         if (!targetGraph) {
             fprintf(stderr, "error: unable to resolve dependencies\n");
@@ -385,8 +829,12 @@ build(
             *buildContext,
             *targetGraph,
             dependencyInfoToolPath,
+            actionCacheCommand,
+            builtinClientPath,
+            builtinSocketPath,
             ninjaPath,
             configurationHashPath,
+            inputsManifestPath,
             intermediatesDirectory);
 
         if (!result) {
@@ -394,11 +842,14 @@ build(
             return false;
         }
 
+        if (!fileTypeCachePath.empty()) {
+            buildContext->fileTypeCache()->save(filesystem, fileTypeCachePath);
+        }
+
         /*
          * Write out the configuration hash for the parameters in the Ninja.
          */
-        std::string hashContents = buildParameters.canonicalHash();
-        auto contents = std::vector<uint8_t>(hashContents.begin(), hashContents.end());
+        auto contents = std::vector<uint8_t>(configurationHash.begin(), configurationHash.end());
         if (!filesystem->write(contents, configurationHashPath)) {
             fprintf(stderr, "error: failed to generate ninja configuration hash\n");
             return false;
@@ -447,7 +898,17 @@ build(
             arguments.push_back("-n");
         }
 
-        // TODO(grp): Pass number of jobs if specified.
+        /*
+         * Run as many jobs as the build was asked to, if specified.
+         */
+        pbxsetting::Environment jobsEnvironment = pbxsetting::Environment(environment);
+        for (pbxsetting::Level const &level : buildParameters.overrideLevels()) {
+            jobsEnvironment.insertFront(level, false);
+        }
+        if (!jobsEnvironment.resolve("XCBUILD_JOBS").empty()) {
+            arguments.push_back("-j");
+            arguments.push_back(std::to_string(pbxbuild::Build::Jobs::Count(jobsEnvironment)));
+        }
 
         /*
          * Run Ninja and return if it failed. Ninja itself does the build.
@@ -462,7 +923,46 @@ build(
             processContext->userName(),
             processContext->groupName());
 
-        ext::optional<int> exitCode = processLauncher->launch(filesystem, &ninja);
+        /*
+         * Start the builtin server for Ninja's builtin tool invocations. If it can't
+         * be started, the builtin client runs each tool itself instead.
+         */
+        bool builtinServer = false;
+        if (!builtinSocketPath.empty() && !_dryRun) {
+            process::MemoryContext server = process::MemoryContext(
+                builtinServerPath,
+                intermediatesDirectory,
+                { builtinSocketPath },
+                processContext->environmentVariables(),
+                processContext->userID(),
+                processContext->groupID(),
+                processContext->userName(),
+                processContext->groupName());
+
+            builtinServer = static_cast<bool>(processLauncher->start(filesystem, &server, [](process::Launcher::Handle handle, ext::optional<int> exitCode) { }));
+        }
+
+        ext::optional<int> exitCode;
+        {
+            libutil::Trace::Span ninjaSpan("Run Ninja");
+            exitCode = processLauncher->launch(filesystem, &ninja);
+        }
+
+        /*
+         * Stop the builtin server. If it isn't listening yet, try again briefly; left
+         * running, it stops on its own once idle.
+         */
+        if (builtinServer) {
+            for (int attempt = 0; attempt < 100 && processLauncher->pending(); ++attempt) {
+                if (builtin::Server::Stop(builtinSocketPath)) {
+                    processLauncher->wait(true);
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    processLauncher->wait(false);
+                }
+            }
+        }
+
         if (!exitCode || *exitCode != 0) {
             return false;
         }
@@ -480,10 +980,16 @@ buildAction(
     pbxbuild::Build::Context const &buildContext,
     pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
     std::string const &dependencyInfoToolPath,
+    std::string const &actionCacheCommand,
+    std::string const &builtinClientPath,
+    std::string const &builtinSocketPath,
     std::string const &ninjaPath,
     std::string const &configurationHashPath,
+    std::string const &inputsManifestPath,
     std::string const &intermediatesDirectory)
 {
+    libutil::Trace::Span span("Generate Ninja");
+
     /*
      * Write out a Ninja file for the build as a whole. Note each target will have a separate
      * file, this is to coordinate the build between targets.
@@ -516,10 +1022,121 @@ buildAction(
     writer.rule(NinjaRuleName(), ninja::Value::Expression("cd $dir && env -i $env $exec && $depexec"));
 
     /*
-     * Go over each target and write out Ninja targets for the start and end of each.
-     * Don't bother topologically sorting the targets now, since Ninja will do that for us.
+     * Add pools to limit how many memory-heavy tools run at once. The depths
+     * come from the build settings shared by all targets.
+     */
+    pbxsetting::Environment poolEnvironment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
+    poolEnvironment.insertFront(buildContext.baseSettings(), false);
+    poolEnvironment.insertFront(buildContext.actionSettings(), false);
+    for (pbxsetting::Level const &level : buildContext.overrideLevels()) {
+        poolEnvironment.insertFront(level, false);
+    }
+    std::unordered_map<std::string, std::string> toolPools = WriteNinjaPools(&writer, poolEnvironment);
+    writer.newline();
+
+    /*
+     * Generate each target's Ninja file. Targets are independent once the target graph
+     * is known, so this happens in parallel, and only the top-level file is written in
+     * order afterwards. The order the targets are written in doesn't matter to Ninja.
+     */
+    std::vector<pbxproj::PBX::Target::shared_ptr> targets = std::vector<pbxproj::PBX::Target::shared_ptr>(targetGraph.nodes().begin(), targetGraph.nodes().end());
+    std::vector<ext::optional<std::string>> targetPaths = std::vector<ext::optional<std::string>>(targets.size());
+    std::vector<std::vector<std::string>> targetSharedPaths = std::vector<std::vector<std::string>>(targets.size());
+    std::vector<std::vector<std::pair<std::string, ninja::Writer>>> targetSharedNinja = std::vector<std::vector<std::pair<std::string, ninja::Writer>>>(targets.size());
+    std::atomic<bool> failed = { false };
+
+    /*
+     * Targets find the same tools in the same directories. Nothing runs while
+     * the Ninja files are generated, so where each was found can't change.
+     */
+    libutil::CachingFilesystem executableLookup(filesystem);
+
+    Parallel::For(Parallel::DefaultJobs(), targets.size(), [&](size_t n) {
+        if (failed) {
+            return;
+        }
+
+        pbxproj::PBX::Target::shared_ptr const &target = targets[n];
+        libutil::Trace::Span targetSpan("Generate Target Ninja", target->name());
+
+        /*
+         * Resolve this target.
+         */
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        if (!targetEnvironment) {
+            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+            return;
+        }
+
+        std::string targetPath = TargetNinjaPath(target, *targetEnvironment);
+        targetPaths[n] = targetPath;
+
+        /*
+         * If nothing the target's Ninja file is generated from has changed,
+         * keep the existing file rather than generating its invocations again.
+         */
+        std::string inputsHash = TargetNinjaInputsHash(filesystem, buildParameters, dependencyInfoToolPath, actionCacheCommand, builtinClientPath, builtinSocketPath, toolPools, target, *targetEnvironment);
+        if (TargetNinjaUpToDate(filesystem, targetPath, inputsHash)) {
+            targetSharedPaths[n] = TargetNinjaSharedPaths(filesystem, targetPath);
+            return;
+        }
+
+        /*
+         * Generate the target's invocations and write out the Ninja file to build it.
+         */
+        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+
+        libutil::Trace::Span writeSpan("Write Target Ninja", target->name());
+        if (!buildTargetInvocations(processContext, filesystem, &executableLookup, dependencyInfoToolPath, actionCacheCommand, builtinClientPath, builtinSocketPath, toolPools, inputsHash, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), phaseInvocations.invocations(), &targetSharedNinja[n])) {
+            fprintf(stderr, "error: failed to build target ninja\n");
+            failed = true;
+        }
+
+        for (std::pair<std::string, ninja::Writer> const &sharedNinja : targetSharedNinja[n]) {
+            targetSharedPaths[n].push_back(sharedNinja.first);
+        }
+    });
+
+    if (failed) {
+        return false;
+    }
+
+    /*
+     * Write and load each shared Ninja file once, however many targets use
+     * it. Targets that weren't generated again still use their shared files.
+     */
+    std::unordered_set<std::string> sharedPaths;
+    for (size_t n = 0; n < targets.size(); ++n) {
+        for (std::pair<std::string, ninja::Writer> const &sharedNinja : targetSharedNinja[n]) {
+            if (sharedPaths.insert(sharedNinja.first).second) {
+                if (!WriteNinja(filesystem, sharedNinja.second, sharedNinja.first, false)) {
+                    fprintf(stderr, "error: unable to write shared ninja: %s\n", sharedNinja.first.c_str());
+                    return false;
+                }
+            }
+        }
+    }
+
+    std::unordered_set<std::string> loadedSharedPaths;
+    for (size_t n = 0; n < targets.size(); ++n) {
+        for (std::string const &sharedPath : targetSharedPaths[n]) {
+            if (loadedSharedPaths.insert(sharedPath).second) {
+                writer.subninja(ninja::Value::String(sharedPath));
+            }
+        }
+    }
+
+    /*
+     * Go over each target and write out Ninja targets for the start of each, and load
+     * the target's own Ninja file, which has the rest of the target's build.
      */
-    for (pbxproj::PBX::Target::shared_ptr const &target : targetGraph.nodes()) {
+    for (size_t n = 0; n < targets.size(); ++n) {
+        pbxproj::PBX::Target::shared_ptr const &target = targets[n];
+        if (!targetPaths[n]) {
+            /* Target environment couldn't be created. */
+            continue;
+        }
 
         /*
          * Beginning target depends on finishing the targets before that. This is implemented
@@ -538,18 +1155,6 @@ buildAction(
          * previous targets.
          */
 
-        /*
-         * Resolve this target and generate its invocations.
-         */
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
-            continue;
-        }
-
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
-
         /*
          * As described above, the target's begin depends on all of the target dependencies.
          */
@@ -565,67 +1170,10 @@ buildAction(
         std::string targetBegin = TargetNinjaBegin(target);
         writer.build({ ninja::Value::String(targetBegin) }, "phony", dependenciesFinished);
 
-        /*
-         * Add the phony target for the checkpoint after writing auxiliary files.
-         */
-        std::string targetWriteAuxiliaryFiles = TargetNinjaWriteAuxiliaryFiles(target);
-        std::vector<ninja::Value> auxiliaryFileOutputs = { ninja::Value::String(targetBegin) };
-        for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : phaseInvocations.auxiliaryFiles()) {
-            auxiliaryFileOutputs.push_back(ninja::Value::String(auxiliaryFile.path()));
-        }
-        writer.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
-
-        /*
-         * Write out the Ninja file to build this target.
-         */
-        if (!buildTargetInvocations(processContext, filesystem, dependencyInfoToolPath, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), phaseInvocations.invocations())) {
-            fprintf(stderr, "error: failed to build target ninja\n");
-            return false;
-        }
-
         /*
          * Load the Ninja file generated for this target.
          */
-        std::string targetPath = TargetNinjaPath(target, *targetEnvironment);
-        writer.subninja(ninja::Value::String(targetPath));
-
-        /*
-         * As described above, the target's finish depends on all of the invocation outputs.
-         */
-        std::unordered_set<std::string> invocationOutputs;
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            if (!invocation.executable()) {
-                /* No outputs. */
-                continue;
-            }
-
-            std::vector<std::string> outputs = NinjaInvocationOutputs(invocation);
-            invocationOutputs.insert(outputs.begin(), outputs.end());
-        }
-
-        /*
-         * Add phony rules for input dependencies that we don't know if they exist.
-         * This can come up, for example, for user-specified custom script inputs.
-         * However, avoid adding the phony invocation if a real output *does* include
-         * the phony input, to avoid Ninja complaining about duplicate rules.
-         */
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            for (std::string const &phonyInput : invocation.phonyInputs()) {
-                if (invocationOutputs.find(phonyInput) == invocationOutputs.end()) {
-                    writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
-                }
-            }
-        }
-
-        /*
-         * Add the phony target for ending this target's build.
-         */
-        std::string targetFinish = TargetNinjaFinish(target);
-        std::vector<ninja::Value> invocationOutputsValues;
-        for (std::string const &output : invocationOutputs) {
-            invocationOutputsValues.push_back(ninja::Value::String(output));
-        }
-        writer.build({ ninja::Value::String(targetFinish) }, "phony", { }, { }, invocationOutputsValues);
+        writer.subninja(ninja::Value::String(*targetPaths[n]));
     }
 
     /*
@@ -643,16 +1191,28 @@ buildAction(
         processContext->currentDirectory(),
         ninjaPath,
         configurationHashPath,
-        inputPaths);
+        inputPaths,
+        _actionCache);
 
     /*
-     * Serialize the Ninja file into the build root.
+     * Serialize the Ninja file into the build root. Always update it: it's the
+     * output of the regenerate rule, and Ninja would keep regenerating a file
+     * that stayed older than its inputs.
      */
-    if (!WriteNinja(filesystem, writer, ninjaPath)) {
+    libutil::Trace::Span writeSpan("Write Ninja");
+    if (!WriteNinja(filesystem, writer, ninjaPath, true)) {
         fprintf(stderr, "error: failed to write Ninja to %s\n", ninjaPath.c_str());
         return false;
     }
 
+    /*
+     * Record the loaded files, to check for changes without loading the workspace.
+     */
+    if (!WriteNinjaInputsManifest(filesystem, inputsManifestPath, inputPaths)) {
+        fprintf(stderr, "error: failed to write Ninja inputs to %s\n", inputsManifestPath.c_str());
+        return false;
+    }
+
     /*
      * Note where the Ninja file is written.
      */
@@ -665,61 +1225,271 @@ bool NinjaExecutor::
 buildTargetInvocations(
     process::Context const *processContext,
     Filesystem *filesystem,
+    Filesystem const *executableLookup,
     std::string const &dependencyInfoToolPath,
+    std::string const &actionCacheCommand,
+    std::string const &builtinClientPath,
+    std::string const &builtinSocketPath,
+    std::unordered_map<std::string, std::string> const &toolPools,
+    std::string const &inputsHash,
     pbxproj::PBX::Target::shared_ptr const &target,
     pbxbuild::Target::Environment const &targetEnvironment,
     std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
-    std::vector<pbxbuild::Tool::Invocation> const &invocations)
+    std::vector<pbxbuild::Tool::Invocation> const &invocations,
+    std::vector<std::pair<std::string, ninja::Writer>> *sharedNinja)
 {
     /*
-     * Start building the Ninja file for this target.
+     * Start building the Ninja file for this target. Note the inputs hash,
+     * so the file can be reused if the target's inputs haven't changed.
      */
     ninja::Writer writer;
     writer.comment("xcbuild ninja");
     writer.comment("Target: " + target->name());
+    writer.comment(TargetNinjaInputsComment(inputsHash));
+
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
+
+    /*
+     * Separate out auxiliary files and invocations shared with other targets.
+     * They go in a Ninja file for their directory, noted in this target's.
+     */
+    std::string sharedDirectory = environment.resolve("SHARED_PRECOMPS_DIR");
+    std::vector<pbxbuild::Tool::AuxiliaryFile> targetAuxiliaryFiles;
+    std::vector<pbxbuild::Tool::Invocation> targetInvocations;
+    std::map<std::string, std::pair<std::vector<pbxbuild::Tool::AuxiliaryFile>, std::vector<pbxbuild::Tool::Invocation>>> sharedOutputs;
+
+    for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : auxiliaryFiles) {
+        if (IsSharedOutput(auxiliaryFile.path(), sharedDirectory)) {
+            sharedOutputs[FSUtil::GetDirectoryName(auxiliaryFile.path())].first.push_back(auxiliaryFile);
+        } else {
+            targetAuxiliaryFiles.push_back(auxiliaryFile);
+        }
+    }
+
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        bool shared = (invocation.executable() && !invocation.outputs().empty());
+        for (std::string const &output : invocation.outputs()) {
+            shared = shared && IsSharedOutput(output, sharedDirectory);
+        }
+
+        if (shared) {
+            sharedOutputs[FSUtil::GetDirectoryName(invocation.outputs().front())].second.push_back(invocation);
+        } else {
+            targetInvocations.push_back(invocation);
+        }
+    }
+
+    for (auto const &entry : sharedOutputs) {
+        std::string const &directory = entry.first;
+        std::string path = directory + "/" + "build.ninja";
+        writer.comment(TargetNinjaSharedComment(path));
+
+        ninja::Writer sharedWriter;
+        sharedWriter.comment("xcbuild ninja");
+        sharedWriter.comment("Directory: " + directory);
+        sharedWriter.newline();
+
+        /* Not ordered after any target, as any of them could use these. */
+        std::string writeAuxiliaryFiles = SharedNinjaWriteAuxiliaryFiles(directory);
+        std::vector<ninja::Value> sharedAuxiliaryFileOutputs;
+        for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : entry.second.first) {
+            sharedAuxiliaryFileOutputs.push_back(ninja::Value::String(auxiliaryFile.path()));
+        }
+        sharedWriter.build({ ninja::Value::String(writeAuxiliaryFiles) }, "phony", sharedAuxiliaryFileOutputs);
+
+        for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : entry.second.first) {
+            if (!buildAuxiliaryFile(&sharedWriter, auxiliaryFile, std::string())) {
+                return false;
+            }
+        }
+
+        for (pbxbuild::Tool::Invocation const &invocation : entry.second.second) {
+            ext::optional<std::string> executablePath = NinjaExecutablePath(processContext, executableLookup, targetEnvironment.executablePaths(), *invocation.executable());
+            if (!executablePath) {
+                fprintf(stderr, "unable to find executable: %s\n", invocation.executable()->builtin().value_or(invocation.executable()->external().value_or("<NONE>")).c_str());
+                return false;
+            }
+
+            if (!buildInvocation(&sharedWriter, invocation, *executablePath, dependencyInfoToolPath, actionCacheCommand, builtinClientPath, builtinSocketPath, toolPools, { }, { }, directory, writeAuxiliaryFiles)) {
+                return false;
+            }
+        }
+
+        sharedNinja->push_back({ path, sharedWriter });
+    }
     writer.newline();
 
     std::string targetBegin = TargetNinjaBegin(target);
     std::string targetWriteAuxiliaryFiles = TargetNinjaWriteAuxiliaryFiles(target);
 
-    pbxsetting::Environment const &environment = targetEnvironment.environment();
-    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
+
+    /*
+     * Add the phony target for the checkpoint after writing auxiliary files.
+     */
+    std::vector<ninja::Value> auxiliaryFileOutputs = { ninja::Value::String(targetBegin) };
+    for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : targetAuxiliaryFiles) {
+        auxiliaryFileOutputs.push_back(ninja::Value::String(auxiliaryFile.path()));
+    }
+    writer.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
 
     /*
      * Write auxiliary files to run first.
      */
-    for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : auxiliaryFiles) {
+    for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : targetAuxiliaryFiles) {
         if (!buildAuxiliaryFile(&writer, auxiliaryFile, targetBegin)) {
             return false;
         }
     }
 
     /*
-     * Add the build command for each invocation.
+     * Find each invocation's executable.
      */
-    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+    std::vector<ext::optional<std::string>> executablePaths;
+    for (pbxbuild::Tool::Invocation const &invocation : targetInvocations) {
         // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
         if (invocation.executable()) {
-            /* Find invocation executable. */
-            ext::optional<std::string> executablePath = NinjaExecutablePath(processContext, filesystem, targetEnvironment.executablePaths(), *invocation.executable());
+            ext::optional<std::string> executablePath = NinjaExecutablePath(processContext, executableLookup, targetEnvironment.executablePaths(), *invocation.executable());
             if (!executablePath) {
                 fprintf(stderr, "unable to find executable: %s\n", invocation.executable()->builtin().value_or(invocation.executable()->external().value_or("<NONE>")).c_str());
 
                 return false;
             }
 
+            executablePaths.push_back(executablePath);
+        } else {
+            executablePaths.push_back(ext::nullopt);
+        }
+    }
+
+    /*
+     * Many invocations differ only by their last few arguments, such as compiling
+     * each source file. Find the arguments shared by all invocations of the same
+     * executable, and the environments shared between invocations.
+     */
+    std::vector<std::string> executables;
+    std::unordered_map<std::string, std::vector<std::string>> executableArguments;
+    std::unordered_map<std::string, size_t> executableCounts;
+    std::vector<std::string> environments;
+    std::unordered_map<std::string, size_t> environmentCounts;
+
+    for (size_t n = 0; n < targetInvocations.size(); ++n) {
+        pbxbuild::Tool::Invocation const &invocation = targetInvocations[n];
+        if (!executablePaths[n]) {
+            continue;
+        }
+
+        std::string executable = NinjaInvocationExecutable(invocation, *executablePaths[n], builtinClientPath, builtinSocketPath);
+        auto arguments = executableArguments.find(executable);
+        if (arguments == executableArguments.end()) {
+            executables.push_back(executable);
+            executableArguments.insert({ executable, invocation.arguments() });
+        } else {
+            size_t shared = 0;
+            while (shared < arguments->second.size() && shared < invocation.arguments().size() && arguments->second[shared] == invocation.arguments()[shared]) {
+                shared++;
+            }
+            arguments->second.resize(shared);
+        }
+        executableCounts[executable]++;
+
+        std::string environment = NinjaInvocationEnvironment(invocation);
+        if (!environment.empty() && environmentCounts[environment]++ == 0) {
+            environments.push_back(environment);
+        }
+    }
+
+    /*
+     * Write the shared parts as variables, in the order first used.
+     */
+    std::unordered_map<std::string, std::pair<std::string, size_t>> commandPrefixes;
+    for (std::string const &executable : executables) {
+        if (executableCounts[executable] > 1) {
+            std::vector<std::string> const &arguments = executableArguments[executable];
+
+            std::string prefix = executable;
+            for (std::string const &arg : arguments) {
+                prefix += ' ';
+                Escape::Shell(arg, &prefix);
+            }
+
+            std::string name = "command_" + std::to_string(commandPrefixes.size());
+            writer.binding({ name, ninja::Value::String(prefix) });
+            commandPrefixes.insert({ executable, { name, arguments.size() } });
+        }
+    }
+
+    std::unordered_map<std::string, std::string> sharedEnvironments;
+    for (std::string const &environment : environments) {
+        if (environmentCounts[environment] > 1) {
+            std::string name = "environment_" + std::to_string(sharedEnvironments.size());
+            writer.binding({ name, ninja::Value::String(environment) });
+            sharedEnvironments.insert({ environment, name });
+        }
+    }
+
+    if (!commandPrefixes.empty() || !sharedEnvironments.empty()) {
+        writer.newline();
+    }
+
+    /*
+     * Add the build command for each invocation.
+     */
+    for (size_t n = 0; n < targetInvocations.size(); ++n) {
+        if (executablePaths[n]) {
             /* Write invocations to run after auxiliary files. */
-            if (!buildInvocation(&writer, invocation, *executablePath, dependencyInfoToolPath, temporaryDirectory, targetWriteAuxiliaryFiles)) {
+            if (!buildInvocation(&writer, targetInvocations[n], *executablePaths[n], dependencyInfoToolPath, actionCacheCommand, builtinClientPath, builtinSocketPath, toolPools, commandPrefixes, sharedEnvironments, temporaryDirectory, targetWriteAuxiliaryFiles)) {
                 return false;
             }
         }
     }
 
+    /*
+     * The target's finish depends on all of the invocation outputs. Outputs
+     * are interned to find duplicates, and kept in the order they are found.
+     */
+    libutil::PathTable invocationOutputPaths;
+    std::unordered_set<libutil::PathTable::Id> invocationOutputs;
+    std::vector<ninja::Value> invocationOutputsValues;
+    for (pbxbuild::Tool::Invocation const &invocation : targetInvocations) {
+        if (!invocation.executable()) {
+            /* No outputs. */
+            continue;
+        }
+
+        for (std::string const &output : NinjaInvocationOutputs(invocation)) {
+            if (invocationOutputs.insert(invocationOutputPaths.intern(output)).second) {
+                invocationOutputsValues.push_back(ninja::Value::String(output));
+            }
+        }
+    }
+
+    /*
+     * Add phony rules for input dependencies that we don't know if they exist.
+     * This can come up, for example, for user-specified custom script inputs.
+     * However, avoid adding the phony invocation if a real output *does* include
+     * the phony input, to avoid Ninja complaining about duplicate rules.
+     */
+    for (pbxbuild::Tool::Invocation const &invocation : targetInvocations) {
+        for (std::string const &phonyInput : invocation.phonyInputs()) {
+            ext::optional<libutil::PathTable::Id> id = invocationOutputPaths.find(phonyInput);
+            if (!id || invocationOutputs.find(*id) == invocationOutputs.end()) {
+                writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
+            }
+        }
+    }
+
+    /*
+     * Add the phony target for ending this target's build.
+     */
+    std::string targetFinish = TargetNinjaFinish(target);
+    writer.build({ ninja::Value::String(targetFinish) }, "phony", { }, { }, invocationOutputsValues);
+
     /*
      * Serialize the Ninja file into the build root.
      */
     std::string path = TargetNinjaPath(target, targetEnvironment);
-    if (!WriteNinja(filesystem, writer, path)) {
+    if (!WriteNinja(filesystem, writer, path, false)) {
         fprintf(stderr, "error: unable to write target ninja: %s\n", path.c_str());
         return false;
     }
@@ -735,13 +1505,19 @@ buildAuxiliaryFile(
 {
     std::vector<ninja::Value> inputs;
     std::vector<ninja::Value> outputs = { ninja::Value::String(auxiliaryFile.path()) };
-    std::vector<ninja::Value> orderDependencies = { ninja::Value::String(after) };
+    std::vector<ninja::Value> orderDependencies;
+    if (!after.empty()) {
+        orderDependencies.push_back(ninja::Value::String(after));
+    }
 
     /*
-     * Build up the command to create the auxiliary file.
+     * Build up the command to create the auxiliary file. It is written next
+     * to the file, and only replaces it if the contents changed, so anything
+     * depending on it is not rebuilt.
      */
     std::string escapedPath = Escape::Shell(auxiliaryFile.path());
-    std::string exec = "echo -n > " + escapedPath;
+    std::string escapedTemporaryPath = Escape::Shell(auxiliaryFile.path() + ".tmp");
+    std::string exec = "echo -n > " + escapedTemporaryPath;
     for (pbxbuild::Tool::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
         exec += " && ";
 
@@ -763,13 +1539,16 @@ buildAuxiliaryFile(
         }
 
         exec += " >> ";
-        exec += escapedPath;
+        exec += escapedTemporaryPath;
     }
 
-    /* Mark the file as executable if necessary. */
+    exec += " && ";
+    exec += "if cmp -s " + escapedTemporaryPath + " " + escapedPath + "; then rm -f " + escapedTemporaryPath + "; else mv -f " + escapedTemporaryPath + " " + escapedPath + "; fi";
+
+    /* Mark the file as executable if it isn't already. */
     if (auxiliaryFile.executable()) {
         exec += " && ";
-        exec += "chmod 0755 " + escapedPath;
+        exec += "{ test -x " + escapedPath + " || chmod 0755 " + escapedPath + "; }";
     }
 
     /*
@@ -781,6 +1560,7 @@ buildAuxiliaryFile(
         { "dir", ninja::Value::String("/") },
         { "exec", ninja::Value::String(exec) },
         { "depexec", ninja::Value::String("true") },
+        { "restat", ninja::Value::String("1") },
     };
     writer->build(outputs, NinjaRuleName(), inputs, bindings, { }, orderDependencies);
 
@@ -793,29 +1573,76 @@ buildInvocation(
     pbxbuild::Tool::Invocation const &invocation,
     std::string const &executablePath,
     std::string const &dependencyInfoToolPath,
+    std::string const &actionCacheCommand,
+    std::string const &builtinClientPath,
+    std::string const &builtinSocketPath,
+    std::unordered_map<std::string, std::string> const &toolPools,
+    std::unordered_map<std::string, std::pair<std::string, size_t>> const &commandPrefixes,
+    std::unordered_map<std::string, std::string> const &sharedEnvironments,
     std::string const &temporaryDirectory,
     std::string const &after)
 {
     /*
-     * Build the invocation arguments. Must escape for shell arguments as Ninja passes
-     * the command string directly to the shell, which would interpret spaces, etc as meaningful.
+     * Build the invocation command. If other invocations in the target run the same
+     * executable, the arguments they all start with are in a shared variable.
      */
-    std::string exec = Escape::Shell(executablePath);
-    for (std::string const &arg : invocation.arguments()) {
-        exec += " " + Escape::Shell(arg);
+    std::string executable = NinjaInvocationExecutable(invocation, executablePath, builtinClientPath, builtinSocketPath);
+    auto commandPrefix = commandPrefixes.find(executable);
+
+    std::string exec;
+    size_t sharedArguments = 0;
+    if (commandPrefix != commandPrefixes.end()) {
+        sharedArguments = commandPrefix->second.second;
+    } else {
+        exec = executable;
+    }
+    for (size_t n = sharedArguments; n < invocation.arguments().size(); ++n) {
+        exec += ' ';
+        Escape::Shell(invocation.arguments()[n], &exec);
+    }
+
+    ninja::Value execValue = ninja::Value::String(exec);
+    if (commandPrefix != commandPrefixes.end()) {
+        execValue = ninja::Value::Expression("$" + commandPrefix->second.first) + execValue;
     }
 
     /*
-     * Build the invocation environment. To set the environment, we use standard shell syntax.
-     * Use `env` to avoid Bash-specific limitations on environment variables. Specifically, some
-     * versions of Bash don't allow setting "UID". Pass -i to clear out the environment.
+     * Run cacheable invocations through the action cache tool, which either
+     * restores their outputs and dependency info or runs them.
      */
-    std::string environment;
-    for (auto it = invocation.environment().begin(); it != invocation.environment().end(); ++it) {
-        if (it != invocation.environment().begin()) {
-            environment += " ";
+    if (!actionCacheCommand.empty() && ActionCache::Cacheable(invocation)) {
+        std::string actionCacheExec = actionCacheCommand;
+        for (std::string const &input : invocation.inputs()) {
+            actionCacheExec += " --input ";
+            Escape::Shell(input, &actionCacheExec);
         }
-        environment += it->first + "=" + Escape::Shell(it->second);
+        for (std::string const &output : invocation.outputs()) {
+            actionCacheExec += " --output ";
+            Escape::Shell(output, &actionCacheExec);
+        }
+        for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+            std::string formatName;
+            if (!dependency::DependencyInfoFormats::Name(dependencyInfo.format(), &formatName)) {
+                return false;
+            }
+
+            actionCacheExec += ' ';
+            Escape::Shell(formatName + ":" + dependencyInfo.path(), &actionCacheExec);
+        }
+        actionCacheExec += " -- ";
+
+        execValue = ninja::Value::String(actionCacheExec) + execValue;
+    }
+
+    /*
+     * Build the invocation environment, sharing it with other invocations if possible.
+     */
+    std::string environment = NinjaInvocationEnvironment(invocation);
+    ninja::Value environmentValue = ninja::Value::String(environment);
+
+    auto sharedEnvironment = sharedEnvironments.find(environment);
+    if (sharedEnvironment != sharedEnvironments.end()) {
+        environmentValue = ninja::Value::Expression("$" + sharedEnvironment->second);
     }
 
     /*
@@ -830,7 +1657,11 @@ buildInvocation(
     std::string dependencyInfoFile;
     std::string dependencyInfoExec;
 
-    if (!invocation.dependencyInfo().empty()) {
+    if (invocation.dependencyInfo().size() == 1 && invocation.dependencyInfo().front().format() == dependency::DependencyInfoFormat::Makefile) {
+        /* A single Makefile is already what Ninja reads; use it directly without converting. */
+        dependencyInfoFile = invocation.dependencyInfo().front().path();
+        dependencyInfoExec = "true";
+    } else if (!invocation.dependencyInfo().empty()) {
         /* Determine the first output; Ninja expects that as the Makefile rule. */
         std::string output = NinjaInvocationOutputs(invocation).front();
 
@@ -853,10 +1684,20 @@ buildInvocation(
             dependencyInfoArguments.push_back(formatName + ":" + dependencyInfo.path());
         }
 
+        /* Only read directories that changed since the last build. */
+        for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+            if (dependencyInfo.format() == dependency::DependencyInfoFormat::Directory) {
+                dependencyInfoArguments.push_back("--manifest");
+                dependencyInfoArguments.push_back(temporaryDirectory + "/" + ".ninja-directory-manifest-" + NinjaHash(output));
+                break;
+            }
+        }
+
         /* Create the command for converting the dependency info. */
         dependencyInfoExec = Escape::Shell(dependencyInfoToolPath);
         for (std::string const &arg : dependencyInfoArguments) {
-            dependencyInfoExec += " " + Escape::Shell(arg);
+            dependencyInfoExec += ' ';
+            Escape::Shell(arg, &dependencyInfoExec);
         }
     } else {
         // TODO(grp): Avoid the need for an empty dependency info command if not used.
@@ -869,16 +1710,26 @@ buildInvocation(
     std::vector<ninja::Binding> bindings = {
         { "description", ninja::Value::String(description) },
         { "dir", ninja::Value::String(Escape::Shell(invocation.workingDirectory())) },
-        { "exec", ninja::Value::String(exec) },
+        { "exec", execValue },
     };
     if (!environment.empty()) {
-        bindings.push_back({ "env", ninja::Value::String(environment) });
+        bindings.push_back({ "env", environmentValue });
     }
     if (!dependencyInfoExec.empty()) {
         bindings.push_back({ "depexec", ninja::Value::String(dependencyInfoExec) });
     }
     if (!dependencyInfoFile.empty()) {
+        /* Record dependencies in Ninja's log, rather than parsing the file on each build. */
         bindings.push_back({ "depfile", ninja::Value::String(dependencyInfoFile) });
+        bindings.push_back({ "deps", ninja::Value::String("gcc") });
+    }
+
+    /*
+     * Limit parallelism for tools in a pool.
+     */
+    auto pool = toolPools.find(invocation.toolIdentifier());
+    if (pool != toolPools.end()) {
+        bindings.push_back({ "pool", ninja::Value::String(pool->second) });
     }
 
     /*
@@ -927,11 +1778,12 @@ buildInvocation(
 }
 
 std::unique_ptr<NinjaExecutor> NinjaExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool actionCache)
 {
     return std::unique_ptr<NinjaExecutor>(new NinjaExecutor(
         formatter,
         dryRun,
-        generate
+        generate,
+        actionCache
     ));
 }
@@ -12,8 +12,10 @@
 #include <pbxbuild/Build/DependencyResolver.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Trace.h>
 #include <libutil/md5.h>
 
+#include <chrono>
 #include <sstream>
 #include <iomanip>
 
@@ -38,7 +40,8 @@ Parameters(
     _allTargets    (allTargets),
     _actions       (actions),
     _configuration (configuration),
-    _overrideLevels(overrideLevels)
+    _overrideLevels(overrideLevels),
+    _workspaceCache(nullptr)
 {
 }
 
@@ -115,10 +118,11 @@ canonicalHash() const
 }
 
 static pbxproj::PBX::Project::shared_ptr
-OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &projectPath, std::string const &directory)
+OpenProject(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvironment, ext::optional<std::string> const &projectPath, std::string const &directory)
 {
     if (projectPath) {
-        return pbxproj::PBX::Project::Open(filesystem, *projectPath);
+        std::string snapshotPath = pbxbuild::WorkspaceContext::ProjectSnapshotPath(filesystem, baseEnvironment, *projectPath);
+        return pbxproj::PBX::Project::Open(filesystem, *projectPath, true, snapshotPath);
     } else {
         bool multiple = false;
         std::string projectName;
@@ -142,7 +146,8 @@ OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &proj
             fprintf(stderr, "error: no project found\n");
             return nullptr;
         } else {
-            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, directory + "/" + projectName);
+            std::string snapshotPath = pbxbuild::WorkspaceContext::ProjectSnapshotPath(filesystem, baseEnvironment, directory + "/" + projectName);
+            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, directory + "/" + projectName, true, snapshotPath);
             if (project == nullptr) {
                 fprintf(stderr, "error: unable to open project '%s'\n", projectName.c_str());
             }
@@ -153,6 +158,38 @@ OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &proj
 
 ext::optional<pbxbuild::WorkspaceContext> Parameters::
 loadWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuild::Build::Environment const &buildEnvironment, std::string const &workingDirectory) const
+{
+    libutil::Trace::Span span("Load Workspace");
+
+    if (_workspaceCache == nullptr) {
+        return openWorkspace(filesystem, userName, buildEnvironment, workingDirectory);
+    }
+
+    /* Identify what is loaded; the same path is the same workspace. */
+    std::string key = userName + "\n";
+    if (_workspace) {
+        key += "workspace\n" + FSUtil::ResolveRelativePath(*_workspace, workingDirectory);
+    } else if (_project) {
+        key += "project\n" + FSUtil::ResolveRelativePath(*_project, workingDirectory);
+    } else {
+        key += "directory\n" + workingDirectory;
+    }
+
+    if (ext::optional<pbxbuild::WorkspaceContext> workspaceContext = _workspaceCache->find(filesystem, key)) {
+        return workspaceContext;
+    }
+
+    std::chrono::system_clock::time_point loadStarted = std::chrono::system_clock::now();
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext = openWorkspace(filesystem, userName, buildEnvironment, workingDirectory);
+    if (workspaceContext) {
+        _workspaceCache->insert(filesystem, key, *workspaceContext, loadStarted);
+    }
+
+    return workspaceContext;
+}
+
+ext::optional<pbxbuild::WorkspaceContext> Parameters::
+openWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuild::Build::Environment const &buildEnvironment, std::string const &workingDirectory) const
 {
     if (_workspace) {
         xcworkspace::XC::Workspace::shared_ptr workspace = xcworkspace::XC::Workspace::Open(filesystem, *_workspace);
@@ -163,7 +200,7 @@ loadWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuil
 
         return pbxbuild::WorkspaceContext::Workspace(filesystem, userName, buildEnvironment.baseEnvironment(), workspace);
     } else {
-        pbxproj::PBX::Project::shared_ptr project = OpenProject(filesystem, _project, workingDirectory);
+        pbxproj::PBX::Project::shared_ptr project = OpenProject(filesystem, buildEnvironment.baseEnvironment(), _project, workingDirectory);
         if (project == nullptr) {
             return ext::nullopt;
         }
@@ -227,7 +264,7 @@ createBuildContext(pbxbuild::WorkspaceContext const &workspaceContext) const
         }
     }
 
-    return pbxbuild::Build::Context(
+    pbxbuild::Build::Context buildContext = pbxbuild::Build::Context(
         workspaceContext,
         scheme,
         schemeGroup,
@@ -235,6 +272,20 @@ createBuildContext(pbxbuild::WorkspaceContext const &workspaceContext) const
         configuration,
         defaultConfiguration,
         _overrideLevels);
+
+    /*
+     * Targets in a workspace kept from an earlier build with the same options
+     * have the same environments, so they don't need to be computed again.
+     */
+    if (_workspaceCache != nullptr) {
+        std::string key;
+        for (std::string const &argument : canonicalArguments()) {
+            key += argument + '\0';
+        }
+        _workspaceCache->shareTargetEnvironments(key, &buildContext);
+    }
+
+    return buildContext;
 }
 
 ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> Parameters::
@@ -10,27 +10,419 @@
 #include <xcexecution/SimpleExecutor.h>
 
 #include <xcexecution/Parameters.h>
+#include <xcexecution/BuildGraph.h>
+#include <xcexecution/BuildShards.h>
+#include <xcexecution/CommandRemoteCache.h>
+#include <xcexecution/DependencyScanner.h>
 #include <builtin/Driver.h>
+#include <dependency/DependencyInfoMerger.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/PhaseInvocations.h>
+#include <pbxbuild/Tool/InterfaceBuilderResolver.h>
+#include <pbxbuild/Tool/LinkerResolver.h>
+#include <pbxbuild/Tool/ScriptResolver.h>
+#include <pbxbuild/Tool/SwiftResolver.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Level.h>
+#include <libutil/CachingFilesystem.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Trace.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/Context.h>
-#include <process/MemoryContext.h>
+#include <process/ReferenceContext.h>
 #include <process/Launcher.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <sys/types.h>
 #include <sys/stat.h>
 
 using xcexecution::SimpleExecutor;
+using xcexecution::BuildGraph;
+using xcexecution::BuildShards;
+using xcexecution::CommandRemoteCache;
+using xcexecution::DependencyScanner;
+using xcexecution::InputAudit;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Parallel;
 using libutil::Permissions;
 
+/*
+ * Runs jobs on a pool of worker threads as soon as the jobs they depend on
+ * have finished. Jobs can be added while others are already running. Once
+ * any job fails, no more jobs are started, unless keeping going, when only
+ * the jobs waiting on the failed job are not started.
+ *
+ * With more than one thread, ready jobs start in order of the longest
+ * estimated path from them through the jobs waiting on them, so that long
+ * chains of dependent jobs start as early as possible. With a memory limit,
+ * jobs only start while the memory of the running jobs stays within it,
+ * or when no other job is running.
+ */
+class SimpleExecutor::Scheduler {
+public:
+    /*
+     * An invocation to perform, with the paths to search for its executable,
+     * an estimate of how long it takes in microseconds, and of the memory it
+     * uses in bytes. Jobs without an invocation executable only serve to
+     * order other jobs.
+     */
+    struct Job {
+        pbxbuild::Tool::Invocation      invocation;
+        std::vector<std::string> const *executablePaths;
+        std::string                     target;
+        int64_t                         estimate;
+        int64_t                         memory;
+    };
+
+    /*
+     * Performs a job, returning if it succeeded.
+     */
+    using Perform = std::function<bool(Job const &job)>;
+
+private:
+    struct Node {
+        Job const          *job;
+        size_t              waiting;
+        std::vector<size_t> dependencies;
+        std::vector<size_t> dependents;
+        int64_t             priority;
+        bool                finished;
+    };
+
+private:
+    Perform                  _perform;
+    BuildProfile            *_profile;
+    bool                     _prioritize;
+    int64_t                  _memoryLimit;
+    bool                     _keepGoing;
+    std::deque<Job>          _jobs;
+    std::vector<Node>        _nodes;
+    int64_t                  _estimate;
+
+private:
+    std::mutex               _mutex;
+    std::condition_variable  _condition;
+    std::set<std::pair<int64_t, size_t>> _ready;
+    size_t                   _running;
+    int64_t                  _memory;
+    size_t                   _finished;
+    bool                     _closed;
+    std::vector<pbxbuild::Tool::Invocation> _failures;
+
+private:
+    std::vector<std::thread> _threads;
+
+public:
+    /*
+     * Jobs are recorded in the profile, if any, in the order they are added.
+     * A memory limit of zero admits jobs regardless of their memory.
+     */
+    Scheduler(size_t threads, size_t memoryLimit, bool keepGoing, Perform const &perform, BuildProfile *profile = nullptr);
+    ~Scheduler();
+
+public:
+    /*
+     * The number of jobs added so far. Added jobs are indexed in order.
+     */
+    size_t size() const
+    { return _nodes.size(); }
+
+public:
+    /*
+     * Adds jobs to run. Each job waits on the jobs at the indexes in the
+     * matching entry of `dependencies`, which may refer to jobs added in
+     * the same call. Ready jobs with the same priority are started lowest
+     * index first; with one thread, that is the only order used.
+     */
+    void add(std::vector<Job> const &jobs, std::vector<std::vector<size_t>> const &dependencies);
+
+    /*
+     * If any job has failed.
+     */
+    bool failed();
+
+    /*
+     * Waits for all jobs to finish, or for running jobs to finish after a
+     * failure. Returns the invocations that failed, and if any jobs were
+     * left unfinished due to a dependency cycle. When keeping going, the
+     * jobs waiting on failed jobs are left unfinished.
+     */
+    std::pair<std::vector<pbxbuild::Tool::Invocation>, bool> finish();
+
+private:
+    void prioritize(size_t index);
+    std::set<std::pair<int64_t, size_t>>::iterator admit();
+    void work();
+};
+
+SimpleExecutor::Scheduler::
+Scheduler(size_t threads, size_t memoryLimit, bool keepGoing, Perform const &perform, BuildProfile *profile) :
+    _perform    (perform),
+    _profile    (profile),
+    _prioritize (threads > 1),
+    _memoryLimit(static_cast<int64_t>(memoryLimit)),
+    _keepGoing  (keepGoing),
+    _estimate   (0),
+    _running    (0),
+    _memory     (0),
+    _finished   (0),
+    _closed     (false)
+{
+    for (size_t thread = 0; thread < threads; ++thread) {
+        _threads.push_back(std::thread(&Scheduler::work, this));
+    }
+}
+
+SimpleExecutor::Scheduler::
+~Scheduler()
+{
+    finish();
+}
+
+void SimpleExecutor::Scheduler::
+add(std::vector<Job> const &jobs, std::vector<std::vector<size_t>> const &dependencies)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    size_t base = _nodes.size();
+    for (Job const &job : jobs) {
+        _jobs.push_back(job);
+        _nodes.push_back({ &_jobs.back(), 0, std::vector<size_t>(), std::vector<size_t>(), (_prioritize ? job.estimate : 0), false });
+        _estimate += job.estimate;
+    }
+
+    for (size_t index = base; index < _nodes.size(); ++index) {
+        for (size_t dependency : dependencies[index - base]) {
+            /* Finished jobs can't be waited on; skip them. */
+            if (dependency != index && !_nodes[dependency].finished) {
+                _nodes[index].waiting++;
+                _nodes[index].dependencies.push_back(dependency);
+                _nodes[dependency].dependents.push_back(index);
+            }
+        }
+    }
+
+    if (_prioritize) {
+        for (size_t index = _nodes.size(); index > base; --index) {
+            prioritize(index - 1);
+        }
+    }
+
+    if (_profile != nullptr) {
+        for (size_t index = base; index < _nodes.size(); ++index) {
+            Job const *job = _nodes[index].job;
+            _profile->add(job->target, job->invocation.executable() ? job->invocation.logMessage() : std::string(), dependencies[index - base]);
+        }
+    }
+
+    for (size_t index = base; index < _nodes.size(); ++index) {
+        if (_nodes[index].waiting == 0) {
+            _ready.insert({ -_nodes[index].priority, index });
+        }
+    }
+
+    _condition.notify_all();
+}
+
+void SimpleExecutor::Scheduler::
+prioritize(size_t index)
+{
+    /*
+     * Raise the priority of the jobs a job waits on to cover the path through
+     * it. Priorities never exceed the total estimate, so that a cycle, which
+     * is reported once the jobs finish, still ends here.
+     */
+    std::vector<size_t> pending = { index };
+    while (!pending.empty()) {
+        Node const &node = _nodes[pending.back()];
+        pending.pop_back();
+
+        for (size_t dependency : node.dependencies) {
+            Node &dependencyNode = _nodes[dependency];
+            int64_t priority = node.priority + dependencyNode.job->estimate;
+            if (dependencyNode.finished || priority <= dependencyNode.priority || priority > _estimate) {
+                continue;
+            }
+
+            /* Ready jobs are ordered by priority, so move them along with it. */
+            if (_ready.erase({ -dependencyNode.priority, dependency }) > 0) {
+                _ready.insert({ -priority, dependency });
+            }
+            dependencyNode.priority = priority;
+            pending.push_back(dependency);
+        }
+    }
+}
+
+bool SimpleExecutor::Scheduler::
+failed()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return !_failures.empty();
+}
+
+std::pair<std::vector<pbxbuild::Tool::Invocation>, bool> SimpleExecutor::Scheduler::
+finish()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _closed = true;
+    _condition.notify_all();
+    lock.unlock();
+
+    for (std::thread &thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+
+    lock.lock();
+    bool cycle = (_failures.empty() && _finished != _nodes.size());
+    return std::make_pair(_failures, cycle);
+}
+
+std::set<std::pair<int64_t, size_t>>::iterator SimpleExecutor::Scheduler::
+admit()
+{
+    if (_memoryLimit == 0 || _running == 0) {
+        return _ready.begin();
+    }
+
+    /* Lower priority jobs can start while higher ones wait for memory. */
+    return std::find_if(_ready.begin(), _ready.end(), [this](std::pair<int64_t, size_t> const &ready) {
+        return _memory + _nodes[ready.second].job->memory <= _memoryLimit;
+    });
+}
+
+void SimpleExecutor::Scheduler::
+work()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true) {
+        /* Wait for a job to be ready, or for all jobs to be finished. */
+        _condition.wait(lock, [this]{ return (!_keepGoing && !_failures.empty()) || admit() != _ready.end() || (_closed && _running == 0); });
+        if ((!_keepGoing && !_failures.empty()) || _ready.empty()) {
+            break;
+        }
+
+        auto ready = admit();
+        size_t index = ready->second;
+        _ready.erase(ready);
+        Job const *job = _nodes[index].job;
+
+        _running++;
+        _memory += job->memory;
+        if (_profile != nullptr) {
+            _profile->start(index);
+        }
+        lock.unlock();
+
+        bool success = _perform(*job);
+
+        lock.lock();
+        _running--;
+        _memory -= job->memory;
+        if (_profile != nullptr) {
+            _profile->finish(index);
+        }
+
+        _finished++;
+        _nodes[index].finished = true;
+
+        if (!success) {
+            /*
+             * Stop starting new jobs; running jobs are waited for. Keeping
+             * going, the jobs waiting on this one are never ready instead.
+             */
+            _failures.push_back(job->invocation);
+        } else {
+            for (size_t dependent : _nodes[index].dependents) {
+                if (--_nodes[dependent].waiting == 0) {
+                    _ready.insert({ -_nodes[dependent].priority, dependent });
+                }
+            }
+        }
+
+        _condition.notify_all();
+    }
+}
+
+/*
+ * How long an invocation is expected to take in microseconds, to prioritize
+ * the jobs that are waited on the longest.
+ */
+static int64_t
+EstimateInvocation(xcexecution::BuildLog const *buildLog, pbxbuild::Tool::Invocation const &invocation)
+{
+    if (!invocation.executable()) {
+        return 0;
+    }
+
+    if (buildLog != nullptr) {
+        if (ext::optional<int64_t> duration = buildLog->duration(invocation)) {
+            return *duration;
+        }
+    }
+
+    /* Without a previous run, guess from the kind of tool. */
+    std::string const &tool = invocation.toolIdentifier();
+    if (tool == pbxbuild::Tool::SwiftResolver::ToolIdentifier()) {
+        return 4000000;
+    } else if (tool == pbxbuild::Tool::LinkerResolver::LinkerToolIdentifier() || tool == pbxbuild::Tool::LinkerResolver::LibtoolToolIdentifier()) {
+        return 2000000;
+    } else if (tool.compare(0, 19, "com.apple.compilers") == 0 ||
+               tool == pbxbuild::Tool::InterfaceBuilderResolver::CompilerToolIdentifier() ||
+               tool == pbxbuild::Tool::InterfaceBuilderResolver::StoryboardCompilerToolIdentifier() ||
+               tool == pbxbuild::Tool::ScriptResolver::ToolIdentifier()) {
+        return 1000000;
+    } else if (invocation.executable()->builtin()) {
+        return 10000;
+    } else {
+        return 100000;
+    }
+}
+
+/*
+ * How much memory an invocation is expected to use in bytes, to keep the
+ * running invocations within the memory limit. Builtins run in this process.
+ */
+static int64_t
+EstimateMemory(xcexecution::BuildLog const *buildLog, pbxbuild::Tool::Invocation const &invocation)
+{
+    if (buildLog == nullptr || !invocation.executable() || invocation.executable()->builtin()) {
+        return 0;
+    }
+
+    return buildLog->memory(invocation.toolIdentifier()).value_or(0);
+}
+
 SimpleExecutor::
-SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins) :
-    Executor (formatter, dryRun, false),
-    _builtins(builtins)
+SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, Options const &options) :
+    Executor           (formatter, dryRun, false),
+    _builtins          (builtins),
+    _jobs              (options.jobs > 0 ? options.jobs : 1),
+    _memoryLimit       (options.memoryLimit),
+    _parallelizeTargets(options.parallelizeTargets),
+    _actionCache       (options.actionCache),
+    _auditInputs       (options.auditInputs),
+    _criticalPath      (options.criticalPath),
+    _keepGoing         (options.keepGoing),
+    _scanDependencies  (options.scanDependencies),
+    _shardIndex        (options.shardIndex),
+    _shardCount        (options.shardCount > 0 ? options.shardCount : 1),
+    _environmentBlocks (std::make_shared<process::EnvironmentBlock::Cache>())
 {
 }
 
@@ -52,11 +444,20 @@ build(
         return false;
     }
 
+    /* Later builds can open the projects from the snapshots. */
+    workspaceContext->saveProjectSnapshots(filesystem, buildEnvironment.baseEnvironment());
+
     ext::optional<pbxbuild::Build::Context> buildContext = buildParameters.createBuildContext(*workspaceContext);
     if (!buildContext) {
         return false;
     }
 
+    /* File types detected by earlier builds are used again for unchanged files. */
+    std::string fileTypeCachePath = workspaceContext->fileTypeCachePath(buildEnvironment.baseEnvironment());
+    if (!fileTypeCachePath.empty()) {
+        buildContext->fileTypeCache()->load(filesystem, fileTypeCachePath);
+    }
+
     xcformatter::Formatter::Print(_formatter->begin(*buildContext));
 
     ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
@@ -70,88 +471,413 @@ build(
         return false;
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
-        xcformatter::Formatter::Print(_formatter->beginTarget(*buildContext, target));
+    /* Target environments are independent, so create them all up front in parallel. */
+    buildContext->prepareTargetEnvironments(buildEnvironment, *orderedTargets);
 
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            continue;
+    /* Sharded builds only build their part of the targets. */
+    if (_shardCount > 1) {
+        targetGraph = shardTargets(processContext, filesystem, buildEnvironment, *buildContext, *targetGraph, *orderedTargets);
+        if (!targetGraph) {
+            return false;
         }
 
-        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, *buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
-        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
-
-        auto result = buildTarget(processContext, processLauncher, filesystem, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), phaseInvocations.invocations());
-        if (!result.first) {
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            xcformatter::Formatter::Print(_formatter->failure(*buildContext, result.second));
+        size_t count = orderedTargets->size();
+        orderedTargets = targetGraph->ordered();
+        if (!orderedTargets) {
+            fprintf(stderr, "error: cycle detected in target dependencies\n");
             return false;
         }
 
-        xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+        fprintf(stderr, "note: building shard %zu of %zu: %zu of %zu targets\n", _shardIndex + 1, _shardCount, orderedTargets->size(), count);
     }
 
-    xcformatter::Formatter::Print(_formatter->success(*buildContext));
-    return true;
+    /*
+     * The build log is shared by all targets, so it goes in the build-level
+     * intermediates directory. A missing or invalid log runs everything.
+     */
+    pbxsetting::Environment environment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
+    environment.insertFront(pbxsetting::Level(workspaceContext->derivedDataHash().overrideSettings()), false);
+    std::string buildLogPath = environment.resolve("OBJROOT") + "/" + ".xcbuild-build-log";
+
+    /*
+     * Audited builds run every invocation, so all of them are traced. The
+     * tracer is found in the search path like other tools.
+     */
+    std::unique_ptr<InputAudit> inputAudit;
+    if (_auditInputs && !_dryRun) {
+        if (ext::optional<std::string> tracerPath = filesystem->findExecutable("fsatrace", processContext->executableSearchPaths())) {
+            std::vector<std::string> ignoredDirectories = InputAudit::DefaultIgnoredDirectories();
+            std::string developerRoot = environment.resolve("DEVELOPER_DIR");
+            if (!developerRoot.empty()) {
+                ignoredDirectories.push_back(developerRoot);
+            }
+
+            std::string temporaryDirectory = processContext->environmentVariable("TMPDIR").value_or("/tmp");
+            inputAudit = std::unique_ptr<InputAudit>(new InputAudit(*tracerPath, temporaryDirectory, ignoredDirectories));
+        } else {
+            fprintf(stderr, "warning: unable to find fsatrace to audit inputs\n");
+        }
+    }
+
+    /*
+     * Audited builds don't use the log, so every invocation runs and the
+     * log is left as it was.
+     */
+    BuildLog buildLog;
+    if (inputAudit == nullptr) {
+        buildLog.load(filesystem, buildLogPath);
+    }
+
+    /*
+     * The action cache is shared by all workspaces, so switching between them
+     * also hits. A remote cache shares it with other machines.
+     */
+    std::unique_ptr<CommandRemoteCache> remoteCache;
+    ext::optional<ActionCache> actionCache;
+    if (_actionCache && inputAudit == nullptr) {
+        if (ext::optional<std::string> helper = CommandRemoteCache::Helper(processContext)) {
+            remoteCache = std::unique_ptr<CommandRemoteCache>(new CommandRemoteCache(processLauncher, processContext, *helper));
+        }
+        actionCache = ActionCache(ActionCache::DefaultPath(environment.resolve("DERIVED_DATA_DIR")), remoteCache.get());
+    }
+
+    /*
+     * Each invocation of a tool looks it up in the same directories. Tools
+     * are not expected to appear or move during the build, so remember where
+     * they were found until it ends.
+     */
+    libutil::CachingFilesystem executableLookup(filesystem);
+
+    /* Only scheduling all targets together knows every dependency edge. */
+    BuildProfile buildProfile;
+    if (_criticalPath && !_parallelizeTargets) {
+        fprintf(stderr, "warning: critical path analysis requires parallelized targets\n");
+    }
+
+    bool success = (_parallelizeTargets ?
+        buildTargets(processContext, processLauncher, filesystem, &executableLookup, buildEnvironment, *buildContext, *targetGraph, *orderedTargets, inputAudit == nullptr ? &buildLog : nullptr, actionCache ? &*actionCache : nullptr, inputAudit.get(), _criticalPath ? &buildProfile : nullptr) :
+        buildTargetsInOrder(processContext, processLauncher, filesystem, &executableLookup, buildEnvironment, *buildContext, *targetGraph, *orderedTargets, inputAudit == nullptr ? &buildLog : nullptr, actionCache ? &*actionCache : nullptr, inputAudit.get()));
+
+    /*
+     * Even failed builds keep the invocations that succeeded. Dry runs read
+     * the log to estimate the build, but don't change it.
+     */
+    if (!_dryRun && inputAudit == nullptr && !buildLog.save(filesystem, buildLogPath)) {
+        fprintf(stderr, "warning: failed to save build log to %s\n", buildLogPath.c_str());
+    }
+
+    if (!fileTypeCachePath.empty()) {
+        buildContext->fileTypeCache()->save(filesystem, fileTypeCachePath);
+    }
+
+    if (_dryRun && success) {
+        if (ext::optional<BuildGraph> graph = BuildGraph::Create(buildEnvironment, *buildContext, *targetGraph)) {
+            xcformatter::Formatter::Print("\n" + estimate(filesystem, *graph, buildLog));
+        }
+    }
+
+    if (_criticalPath && _parallelizeTargets && !_dryRun) {
+        std::string report = buildProfile.report();
+        xcformatter::Formatter::Print("\n" + report);
+
+        std::string reportPath = environment.resolve("OBJROOT") + "/" + "xcbuild-critical-path.txt";
+        if (!filesystem->createDirectory(FSUtil::GetDirectoryName(reportPath), true) || !filesystem->write(std::vector<uint8_t>(report.begin(), report.end()), reportPath)) {
+            fprintf(stderr, "warning: failed to write critical path to %s\n", reportPath.c_str());
+        }
+    }
+
+    if (inputAudit != nullptr) {
+        for (auto const &tool : inputAudit->tools()) {
+            fprintf(stderr, "note: input audit: %s: %zu of %zu invocations read undeclared inputs\n", tool.first.c_str(), tool.second.second, tool.second.first);
+        }
+    }
+
+    return success;
 }
 
-static ext::optional<std::vector<pbxbuild::Tool::Invocation>>
-SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> SimpleExecutor::
+shardTargets(
+    process::Context const *processContext,
+    Filesystem const *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets)
 {
-    std::unordered_map<std::string, pbxbuild::Tool::Invocation const *> outputToInvocation;
-    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
-        for (std::string const &output : invocation.outputs()) {
-            outputToInvocation.insert({ output, &invocation });
+    if (_shardIndex >= _shardCount) {
+        fprintf(stderr, "error: shard %zu is not one of %zu shards\n", _shardIndex + 1, _shardCount);
+        return ext::nullopt;
+    }
+
+    /* Without a shared log, every machine guesses the same durations. */
+    BuildLog shardLog;
+    bool loaded = false;
+    if (ext::optional<std::string> shardLogPath = processContext->environmentVariable("XCBUILD_SHARD_BUILD_LOG")) {
+        loaded = shardLog.load(filesystem, *shardLogPath);
+        if (!loaded) {
+            fprintf(stderr, "warning: unable to load shard build log %s\n", shardLogPath->c_str());
         }
     }
 
-    pbxbuild::DirectedGraph<pbxbuild::Tool::Invocation const *> graph;
-    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
-        std::unordered_set<pbxbuild::Tool::Invocation const *> emptySet;
-        graph.insert(&invocation, emptySet);
+    /* The target graph's order can differ between machines, but names don't. */
+    std::vector<pbxproj::PBX::Target::shared_ptr> targets = orderedTargets;
+    std::sort(targets.begin(), targets.end(), [](pbxproj::PBX::Target::shared_ptr const &a, pbxproj::PBX::Target::shared_ptr const &b) {
+        return std::make_pair(a->name(), a->blueprintIdentifier()) < std::make_pair(b->name(), b->blueprintIdentifier());
+    });
 
-        for (std::string const &input : invocation.inputs()) {
-            auto it = outputToInvocation.find(input);
-            if (it != outputToInvocation.end()) {
-                graph.insert(&invocation, { it->second });
-            }
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> indexes;
+    for (size_t index = 0; index < targets.size(); ++index) {
+        indexes.insert({ targets[index], index });
+    }
+
+    std::vector<std::vector<size_t>> dependencies;
+    std::vector<int64_t> durations;
+    for (pbxproj::PBX::Target::shared_ptr const &target : targets) {
+        std::vector<size_t> targetDependencies;
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
+            targetDependencies.push_back(indexes.at(dependency));
         }
-        for (std::string const &phonyInputs : invocation.phonyInputs()) {
-            auto it = outputToInvocation.find(phonyInputs);
-            if (it != outputToInvocation.end()) {
-                graph.insert(&invocation, { it->second });
+        std::sort(targetDependencies.begin(), targetDependencies.end());
+        dependencies.push_back(targetDependencies);
+
+        int64_t duration = 0;
+        if (ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target)) {
+            pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+            pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+            for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
+                duration += EstimateInvocation(loaded ? &shardLog : nullptr, invocation);
             }
         }
-        for (std::string const &inputDependency : invocation.inputDependencies()) {
-            auto it = outputToInvocation.find(inputDependency);
-            if (it != outputToInvocation.end()) {
-                graph.insert(&invocation, { it->second });
+        durations.push_back(duration);
+    }
+
+    std::vector<std::vector<size_t>> shards = BuildShards::Partition(dependencies, durations, _shardCount);
+
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> shardGraph;
+    for (size_t index : shards[_shardIndex]) {
+        shardGraph.insert(targets[index], targetGraph.adjacent(targets[index]));
+    }
+    return shardGraph;
+}
+
+static std::string
+EstimateSeconds(int64_t microseconds)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3fs", static_cast<double>(microseconds) / 1000000.0);
+    return buffer;
+}
+
+std::string SimpleExecutor::
+estimate(Filesystem const *filesystem, BuildGraph const &graph, BuildLog const &buildLog) const
+{
+    /* Invocations that never ran take as long as others of the same tool. */
+    std::unordered_map<std::string, std::pair<int64_t, int64_t>> toolDurations;
+    std::pair<int64_t, int64_t> allDurations = { 0, 0 };
+    for (BuildGraph::Target const &target : graph.targets()) {
+        for (pbxbuild::Tool::Invocation const &invocation : target.invocations) {
+            if (ext::optional<int64_t> duration = buildLog.duration(invocation)) {
+                toolDurations[invocation.toolIdentifier()].first += *duration;
+                toolDurations[invocation.toolIdentifier()].second++;
+                allDurations.first += *duration;
+                allDurations.second++;
             }
         }
     }
 
-    std::vector<pbxbuild::Tool::Invocation> result;
+    /*
+     * Jobs are laid out as the build schedules them: each target's
+     * invocations, then a job for its product structure and one for the
+     * target finishing. An invocation runs if it is out of date, or if an
+     * invocation producing one of its inputs runs.
+     */
+    BuildProfile profile;
+    std::vector<int64_t> durations;
+    std::vector<bool> runs;
+    std::unordered_map<std::string, size_t> outputToJob;
+    std::vector<size_t> targetToJob;
 
-    ext::optional<std::vector<pbxbuild::Tool::Invocation const *>> orderedInvocations = graph.ordered();
-    if (!orderedInvocations) {
-        return ext::nullopt;
+    size_t invocations = 0;
+    size_t running = 0;
+    size_t unknown = 0;
+    int64_t work = 0;
+
+    for (size_t t = 0; t < graph.targets().size(); ++t) {
+        BuildGraph::Target const &target = graph.targets()[t];
+
+        size_t base = profile.jobs().size();
+        size_t structure = base + target.invocations.size();
+        size_t finished = structure + 1;
+
+        std::vector<size_t> targetDependencies;
+        if (_parallelizeTargets) {
+            for (size_t dependency : target.dependencies) {
+                targetDependencies.push_back(targetToJob[dependency]);
+            }
+        } else if (t > 0) {
+            targetDependencies.push_back(targetToJob[t - 1]);
+        }
+
+        for (size_t index = 0; index < target.invocations.size(); ++index) {
+            for (std::string const &output : target.invocations[index].outputs()) {
+                outputToJob[output] = base + index;
+            }
+        }
+
+        std::vector<size_t> structureDependencies;
+        std::vector<size_t> finishedDependencies;
+
+        for (size_t index = 0; index < target.invocations.size(); ++index) {
+            pbxbuild::Tool::Invocation const &invocation = target.invocations[index];
+
+            std::vector<size_t> dependencies = targetDependencies;
+            if (invocation.createsProductStructure()) {
+                structureDependencies.push_back(base + index);
+            } else {
+                dependencies.push_back(structure);
+            }
+            finishedDependencies.push_back(base + index);
+
+            bool run = !buildLog.upToDate(filesystem, invocation);
+            for (std::vector<std::string> const *paths : { &invocation.inputs(), &invocation.phonyInputs(), &invocation.inputDependencies() }) {
+                for (std::string const &path : *paths) {
+                    auto it = outputToJob.find(path);
+                    if (it != outputToJob.end()) {
+                        dependencies.push_back(it->second);
+                        if (it->second < runs.size() && runs[it->second]) {
+                            run = true;
+                        }
+                    }
+                }
+            }
+
+            int64_t duration = 0;
+            if (!invocation.executable()) {
+                run = false;
+            } else {
+                invocations++;
+            }
+
+            if (run) {
+                running++;
+
+                if (ext::optional<int64_t> recorded = buildLog.duration(invocation)) {
+                    duration = *recorded;
+                } else {
+                    unknown++;
+
+                    auto it = toolDurations.find(invocation.toolIdentifier());
+                    std::pair<int64_t, int64_t> const &similar = (it != toolDurations.end() ? it->second : allDurations);
+                    duration = (similar.second > 0 ? similar.first / similar.second : 0);
+                }
+
+                work += duration;
+            }
+
+            /* Invocations that would be skipped are left out of the report. */
+            profile.add(target.name, run ? invocation.logMessage() : std::string(), dependencies);
+            durations.push_back(duration);
+            runs.push_back(run);
+        }
+
+        profile.add(target.name, std::string(), structureDependencies);
+        durations.push_back(0);
+        runs.push_back(false);
+        profile.add(target.name, std::string(), finishedDependencies);
+        durations.push_back(0);
+        runs.push_back(false);
+
+        targetToJob.push_back(finished);
     }
 
-    for (pbxbuild::Tool::Invocation const *invocation : *orderedInvocations) {
-        result.push_back(*invocation);
+    profile.simulate(_jobs, durations);
+
+    std::string result = "Estimate: " + std::to_string(running) + " of " + std::to_string(invocations) + " invocations would run";
+    if (unknown > 0) {
+        result += ", " + std::to_string(unknown) + " without a recorded duration";
     }
+    result += "\n";
+    result += "    " + EstimateSeconds(work) + " of work with " + std::to_string(_jobs) + " jobs" + (_parallelizeTargets ? " and parallelized targets" : "") + "\n\n";
+    result += profile.report();
     return result;
 }
 
+bool SimpleExecutor::
+buildTargetsInOrder(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    Filesystem const *executableLookup,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+    BuildLog *buildLog,
+    ActionCache const *actionCache,
+    InputAudit *inputAudit)
+{
+    /* When keeping going, targets depending on failed targets are skipped. */
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> failedTargets;
+    std::vector<pbxbuild::Tool::Invocation> failures;
+
+    for (pbxproj::PBX::Target::shared_ptr const &target : orderedTargets) {
+        std::unordered_set<pbxproj::PBX::Target::shared_ptr> dependencies = targetGraph.adjacent(target);
+        if (std::any_of(dependencies.begin(), dependencies.end(), [&](pbxproj::PBX::Target::shared_ptr const &dependency) { return failedTargets.count(dependency) != 0; })) {
+            fprintf(stderr, "warning: not building %s, which depends on a target that failed\n", target->name().c_str());
+            failedTargets.insert(target);
+            continue;
+        }
+
+        xcformatter::Formatter::Print(_formatter->beginTarget(buildContext, target));
+
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        if (!targetEnvironment) {
+            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+            xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, target));
+            continue;
+        }
+
+        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
+        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+
+        auto result = buildTarget(processContext, processLauncher, filesystem, executableLookup, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), std::move(phaseInvocations.invocations()), buildLog, actionCache, inputAudit);
+
+        /* Later targets are resolved against what this target created. */
+        buildContext.filesystem()->invalidate();
+
+        if (!result.first) {
+            xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, target));
+            if (!_keepGoing) {
+                xcformatter::Formatter::Print(_formatter->failure(buildContext, result.second));
+                return false;
+            }
+
+            failedTargets.insert(target);
+            failures.insert(failures.end(), result.second.begin(), result.second.end());
+            continue;
+        }
+
+        xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, target));
+    }
+
+    if (!failedTargets.empty()) {
+        xcformatter::Formatter::Print(_formatter->failure(buildContext, failures));
+        return false;
+    }
+
+    xcformatter::Formatter::Print(_formatter->success(buildContext));
+    return true;
+}
+
 bool SimpleExecutor::
 writeAuxiliaryFiles(
     Filesystem *filesystem,
     std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles)
 {
+    /* Directories and output come first, in order; the files can then be written in any order. */
+    std::vector<bool> setExecutable;
     for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : auxiliaryFiles) {
         std::string directory = FSUtil::GetDirectoryName(auxiliaryFile.path());
         if (filesystem->type(directory) != Filesystem::Type::Directory) {
@@ -166,156 +892,647 @@ writeAuxiliaryFiles(
 
         xcformatter::Formatter::Print(_formatter->writeAuxiliaryFile(auxiliaryFile.path()));
 
-        if (!_dryRun) {
-            std::vector<uint8_t> data;
+        setExecutable.push_back(auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path()));
+        if (setExecutable.back()) {
+            xcformatter::Formatter::Print(_formatter->setAuxiliaryExecutable(auxiliaryFile.path()));
+        }
+    }
 
-            for (pbxbuild::Tool::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
-                switch (chunk.type()) {
-                    case pbxbuild::Tool::AuxiliaryFile::Chunk::Type::Data: {
-                        data.insert(data.end(), chunk.data()->begin(), chunk.data()->end());
-                        break;
-                    }
-                    case pbxbuild::Tool::AuxiliaryFile::Chunk::Type::File: {
-                        std::vector<uint8_t> contents;
-                        if (!filesystem->read(&contents, *chunk.file())) {
-                            return false;
-                        }
-                        data.insert(data.end(), contents.begin(), contents.end());
-                        break;
+    if (_dryRun) {
+        return true;
+    }
+
+    auto write = [&](size_t index) -> bool {
+        pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile = auxiliaryFiles[index];
+        std::vector<uint8_t> data;
+
+        for (pbxbuild::Tool::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
+            switch (chunk.type()) {
+                case pbxbuild::Tool::AuxiliaryFile::Chunk::Type::Data: {
+                    data.insert(data.end(), chunk.data()->begin(), chunk.data()->end());
+                    break;
+                }
+                case pbxbuild::Tool::AuxiliaryFile::Chunk::Type::File: {
+                    std::vector<uint8_t> contents;
+                    if (!filesystem->read(&contents, *chunk.file())) {
+                        return false;
                     }
-                    default: abort();
+                    data.insert(data.end(), contents.begin(), contents.end());
+                    break;
                 }
+                default: abort();
             }
+        }
 
+        /* Leave unchanged files alone, so anything depending on them is not rebuilt. */
+        std::vector<uint8_t> existing;
+        if (filesystem->type(auxiliaryFile.path()) != Filesystem::Type::File || !filesystem->read(&existing, auxiliaryFile.path()) || existing != data) {
             if (!filesystem->write(data, auxiliaryFile.path())) {
                 return false;
             }
         }
 
-        if (auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path())) {
-            xcformatter::Formatter::Print(_formatter->setAuxiliaryExecutable(auxiliaryFile.path()));
+        if (setExecutable[index]) {
+            Permissions permissions = Permissions(
+                { Permissions::Permission::Read, Permissions::Permission::Write, Permissions::Permission::Execute },
+                { Permissions::Permission::Read, Permissions::Permission::Execute },
+                { Permissions::Permission::Read, Permissions::Permission::Execute });
+            if (!filesystem->writeFilePermissions(auxiliaryFile.path(), Permissions::Operation::Set, permissions)) {
+                return false;
+            }
+        }
 
-            if (!_dryRun) {
-                Permissions permissions = Permissions(
-                    { Permissions::Permission::Read, Permissions::Permission::Write, Permissions::Permission::Execute },
-                    { Permissions::Permission::Read, Permissions::Permission::Execute },
-                    { Permissions::Permission::Read, Permissions::Permission::Execute });
-                if (!filesystem->writeFilePermissions(auxiliaryFile.path(), Permissions::Operation::Set, permissions)) {
-                    return false;
+        return true;
+    };
+
+    /* Each file is independent, so write them on up to one thread per job. */
+    std::atomic<bool> success = ATOMIC_VAR_INIT(true);
+    Parallel::For(_jobs, auxiliaryFiles.size(), [&](size_t index) {
+        if (success && !write(index)) {
+            success = false;
+        }
+    });
+
+    return success;
+}
+
+bool SimpleExecutor::
+buildTargets(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    Filesystem const *executableLookup,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+    BuildLog *buildLog,
+    ActionCache const *actionCache,
+    InputAudit *inputAudit,
+    BuildProfile *buildProfile)
+{
+    std::mutex outputMutex;
+    std::unordered_set<std::string> createdDirectories;
+    std::mutex builtinMutex;
+
+    /* Kept alive for the executable paths referenced by scheduled jobs. */
+    std::list<pbxbuild::Target::Environment> targetEnvironments;
+
+    Scheduler scheduler(_jobs, _memoryLimit, _keepGoing, [&](Scheduler::Job const &job) -> bool {
+        if (_dryRun || !job.invocation.executable()) {
+            return true;
+        }
+
+        bool succeeded = performInvocation(processContext, processLauncher, filesystem, executableLookup, *job.executablePaths, job.invocation, &outputMutex, &createdDirectories, &builtinMutex, buildLog, actionCache, inputAudit);
+
+        /* Targets resolved from now on can depend on what the invocation created. */
+        buildContext.filesystem()->invalidate();
+        return succeeded;
+    }, buildProfile);
+
+    /*
+     * Each target is resolved and then scheduled, while the invocations of the
+     * targets before it are already running.
+     */
+    std::unordered_map<std::string, size_t> outputToJob;
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> targetToJob;
+
+    bool success = true;
+    for (pbxproj::PBX::Target::shared_ptr const &target : orderedTargets) {
+        /* When keeping going, targets after a failure still wait on the targets they depend on. */
+        if (!_keepGoing && scheduler.failed()) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> outputLock(outputMutex);
+        xcformatter::Formatter::Print(_formatter->beginTarget(buildContext, target));
+        outputLock.unlock();
+
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        if (!targetEnvironment) {
+            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+            outputLock.lock();
+            xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, target));
+            continue;
+        }
+        targetEnvironments.push_back(std::move(*targetEnvironment));
+
+        outputLock.lock();
+        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
+        outputLock.unlock();
+
+        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, targetEnvironments.back());
+        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+
+        outputLock.lock();
+        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+
+        xcformatter::Formatter::Print(_formatter->beginWriteAuxiliaryFiles(target));
+        bool auxiliaryFilesSuccess = this->writeAuxiliaryFiles(filesystem, phaseInvocations.auxiliaryFiles());
+        buildContext.filesystem()->invalidate();
+        xcformatter::Formatter::Print(_formatter->finishWriteAuxiliaryFiles(target));
+        outputLock.unlock();
+        if (!auxiliaryFilesSuccess) {
+            success = false;
+            break;
+        }
+
+        /* The filesystem is shared with running invocations. */
+        outputLock.lock();
+        scanInvocations(processContext, processLauncher, filesystem, target, targetEnvironments.back(), &phaseInvocations.invocations());
+        outputLock.unlock();
+
+        ext::optional<std::vector<pbxbuild::Tool::Invocation>> orderedInvocations = BuildGraph::SortInvocations(std::move(phaseInvocations.invocations()));
+        if (!orderedInvocations) {
+            fprintf(stderr, "error: cycle detected building invocation graph\n");
+            success = false;
+            break;
+        }
+
+        /*
+         * The jobs for a target are its invocations, then a job finished once
+         * the product structure is created, then a job finished with the target.
+         */
+        size_t base = scheduler.size();
+        size_t structure = base + orderedInvocations->size();
+        size_t finished = structure + 1;
+
+        std::vector<size_t> targetDependencies;
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
+            auto it = targetToJob.find(dependency);
+            if (it != targetToJob.end()) {
+                targetDependencies.push_back(it->second);
+            }
+        }
+
+        for (size_t index = 0; index < orderedInvocations->size(); ++index) {
+            for (std::string const &output : (*orderedInvocations)[index].outputs()) {
+                outputToJob[output] = base + index;
+            }
+        }
+
+        std::vector<Scheduler::Job> jobs;
+        std::vector<std::vector<size_t>> dependencies;
+        std::vector<size_t> structureDependencies;
+        std::vector<size_t> finishedDependencies;
+
+        /* The build log is shared with running invocations. */
+        outputLock.lock();
+
+        for (size_t index = 0; index < orderedInvocations->size(); ++index) {
+            pbxbuild::Tool::Invocation const &invocation = (*orderedInvocations)[index];
+
+            std::vector<size_t> invocationDependencies = targetDependencies;
+            if (invocation.createsProductStructure()) {
+                structureDependencies.push_back(base + index);
+            } else {
+                invocationDependencies.push_back(structure);
+            }
+            finishedDependencies.push_back(base + index);
+
+            for (std::vector<std::string> const *paths : { &invocation.inputs(), &invocation.phonyInputs(), &invocation.inputDependencies() }) {
+                for (std::string const &path : *paths) {
+                    auto it = outputToJob.find(path);
+                    if (it != outputToJob.end()) {
+                        invocationDependencies.push_back(it->second);
+                    }
                 }
             }
+
+            jobs.push_back({ invocation, &targetEnvironments.back().executablePaths(), target->name(), EstimateInvocation(buildLog, invocation), EstimateMemory(buildLog, invocation) });
+            dependencies.push_back(invocationDependencies);
+        }
+        outputLock.unlock();
+
+        jobs.push_back({ pbxbuild::Tool::Invocation(), nullptr, target->name(), 0, 0 });
+        dependencies.push_back(structureDependencies);
+        jobs.push_back({ pbxbuild::Tool::Invocation(), nullptr, target->name(), 0, 0 });
+        dependencies.push_back(finishedDependencies);
+
+        targetToJob.insert({ target, finished });
+        scheduler.add(jobs, dependencies);
+    }
+
+    std::pair<std::vector<pbxbuild::Tool::Invocation>, bool> result = scheduler.finish();
+    if (result.second) {
+        fprintf(stderr, "error: cycle detected building invocation graph\n");
+        success = false;
+    }
+
+    for (pbxproj::PBX::Target::shared_ptr const &target : orderedTargets) {
+        if (targetToJob.find(target) != targetToJob.end()) {
+            xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, target));
         }
     }
 
+    if (!success || !result.first.empty()) {
+        xcformatter::Formatter::Print(_formatter->failure(buildContext, result.first));
+        return false;
+    }
+
+    xcformatter::Formatter::Print(_formatter->success(buildContext));
     return true;
 }
 
-std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
-performInvocations(
+/*
+ * The dependency info is cached along with the outputs, for the build log to read.
+ */
+static std::vector<std::string>
+ActionCacheOutputs(pbxbuild::Tool::Invocation const &invocation)
+{
+    std::vector<std::string> outputs = invocation.outputs();
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        outputs.push_back(FSUtil::ResolveRelativePath(dependencyInfo.path(), invocation.workingDirectory()));
+    }
+    return outputs;
+}
+
+static bool
+StoreActionOutputs(Filesystem *filesystem, xcexecution::ActionCache const &actionCache, std::string const &key, pbxbuild::Tool::Invocation const &invocation)
+{
+    dependency::DependencyInfoMerger merger = dependency::DependencyInfoMerger(invocation.workingDirectory());
+    for (std::string const &input : invocation.inputs()) {
+        merger.add(input);
+    }
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        if (!merger.add(filesystem, dependencyInfo.format(), FSUtil::ResolveRelativePath(dependencyInfo.path(), invocation.workingDirectory()))) {
+            return false;
+        }
+    }
+
+    std::vector<std::string> discoveredInputs;
+    for (std::string const *input : merger.inputs()) {
+        discoveredInputs.push_back(*input);
+    }
+
+    return actionCache.store(filesystem, key, discoveredInputs, ActionCacheOutputs(invocation));
+}
+
+/*
+ * Microseconds since a time.
+ */
+static int64_t
+Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * Create a directory once per build. Directories whose parent this already
+ * created skip walking up the path to find which parents are missing.
+ */
+static bool
+CreateDirectory(Filesystem *filesystem, std::string const &directory, std::unordered_set<std::string> *createdDirectories)
+{
+    if (createdDirectories->find(directory) != createdDirectories->end()) {
+        return true;
+    }
+
+    bool recursive = (createdDirectories->find(FSUtil::GetDirectoryName(directory)) == createdDirectories->end());
+    if (!filesystem->createDirectory(directory, recursive)) {
+        return false;
+    }
+
+    createdDirectories->insert(directory);
+    return true;
+}
+
+static bool
+RecordInvocation(Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation, bool success, xcexecution::BuildLog *buildLog, ext::optional<int64_t> duration = ext::nullopt)
+{
+    if (buildLog != nullptr) {
+        if (success) {
+            buildLog->record(filesystem, invocation, duration);
+        } else {
+            /* Outputs may be partially written, so never skip it next time. */
+            buildLog->forget(invocation);
+        }
+    }
+
+    return success;
+}
+
+bool SimpleExecutor::
+performInvocation(
     process::Context const *processContext,
     process::Launcher *processLauncher,
     Filesystem *filesystem,
+    Filesystem const *executableLookup,
     std::vector<std::string> const &executablePaths,
-    std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-    bool createProductStructure)
+    pbxbuild::Tool::Invocation const &invocation,
+    std::mutex *outputMutex,
+    std::unordered_set<std::string> *createdDirectories,
+    std::mutex *builtinMutex,
+    BuildLog *buildLog,
+    ActionCache const *actionCache,
+    InputAudit *inputAudit)
 {
-    for (pbxbuild::Tool::Invocation const &invocation : orderedInvocations) {
-        // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
-        if (!invocation.executable()) {
-            continue;
+    libutil::Trace::Span span("Run Invocation", invocation.logMessage());
+
+    pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
+    bool createProductStructure = invocation.createsProductStructure();
+
+    /*
+     * The formatter, build log and created directories are shared between all
+     * running invocations, so only access them while holding the output lock.
+     * The filesystem is safe to use without it, as running tools do.
+     */
+    std::unique_lock<std::mutex> outputLock(*outputMutex);
+
+    if (buildLog != nullptr && buildLog->upToDate(filesystem, invocation)) {
+        return true;
+    }
+
+    for (std::string const &output : invocation.outputs()) {
+        if (!CreateDirectory(filesystem, FSUtil::GetDirectoryName(output), createdDirectories)) {
+            return false;
         }
-        pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
+    }
 
-        if (invocation.createsProductStructure() != createProductStructure) {
-            continue;
+    if (ext::optional<std::string> const &builtin = executable.builtin()) {
+        /* Builtin tool, find and run in-process. */
+        std::shared_ptr<builtin::Driver> driver = _builtins.driver(*builtin);
+        if (driver == nullptr) {
+            /* Failed to find builtin tool. */
+            return false;
         }
 
-        if (!_dryRun) {
-            bool success = true;
+        xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *builtin, createProductStructure));
+        outputLock.unlock();
 
-            for (std::string const &output : invocation.outputs()) {
-                std::string directory = FSUtil::GetDirectoryName(output);
+        /* Refers to the invocation, rather than copying it. */
+        process::ReferenceContext context = process::ReferenceContext(
+            *builtin,
+            invocation.workingDirectory(),
+            invocation.arguments(),
+            invocation.environment(),
+            nullptr,
+            processContext);
 
-                if (!filesystem->createDirectory(directory, true)) {
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
+        /*
+         * Reentrant drivers run alongside each other, sharing the filesystem's
+         * caches and the process-wide property list cache. Others run one at
+         * a time.
+         */
+        std::unique_lock<std::mutex> builtinLock(*builtinMutex, std::defer_lock);
+        if (!driver->reentrant()) {
+            builtinLock.lock();
+        }
+        auto start = std::chrono::steady_clock::now();
+        int exitCode = driver->run(&context, filesystem);
+        int64_t duration = Elapsed(start);
+        if (builtinLock.owns_lock()) {
+            builtinLock.unlock();
+        }
+
+        outputLock.lock();
+        xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *builtin, createProductStructure, exitCode, ext::nullopt));
+
+        return RecordInvocation(filesystem, invocation, exitCode == 0, buildLog, duration);
+    } else if (ext::optional<std::string> const &external = executable.external()) {
+        /* External tool, find on the filesystem. */
+        ext::optional<std::string> path;
+        if (FSUtil::IsAbsolutePath(*external)) {
+            if (filesystem->isExecutable(*external)) {
+                path = external;
             }
+        } else {
+            path = executableLookup->findExecutable(*external, executablePaths);
+        }
 
-            if (ext::optional<std::string> const &builtin = executable.builtin()) {
-                /* Builtin tool, find and run in-process. */
-                if (std::shared_ptr<builtin::Driver> driver = _builtins.driver(*builtin)) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *builtin, createProductStructure));
-
-                    process::MemoryContext context = process::MemoryContext(
-                        *builtin,
-                        invocation.workingDirectory(),
-                        invocation.arguments(),
-                        invocation.environment(),
-                        processContext->userID(),
-                        processContext->groupID(),
-                        processContext->userName(),
-                        processContext->groupName());
-                    int exitCode = driver->run(&context, filesystem);
-                    success = (exitCode == 0);
-
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *builtin, createProductStructure));
-                } else {
-                    /* Failed to find builtin tool. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
-            } else if (ext::optional<std::string> const &external = executable.external()) {
-                /* External tool, find on the filesystem. */
-                ext::optional<std::string> path;
-                if (FSUtil::IsAbsolutePath(*external)) {
-                    if (filesystem->isExecutable(*external)) {
-                        path = external;
-                    }
-                } else {
-                    path = filesystem->findExecutable(*external, executablePaths);
+        if (!path) {
+            /* Failed to find executable. */
+            return false;
+        }
+
+        /*
+         * Restore the outputs if the same invocation ran before with the same
+         * inputs. Hashing the inputs and reading the cache can take a while,
+         * so happen alongside other invocations, without the output lock.
+         */
+        ext::optional<std::string> actionKey;
+        if (actionCache != nullptr && ActionCache::Cacheable(invocation)) {
+            outputLock.unlock();
+
+            if (ext::optional<std::string> command = actionCache->command(filesystem, *path, invocation.arguments(), invocation.environment(), invocation.workingDirectory())) {
+                /* Scanned headers are known before running, so they can be part of the key. */
+                std::vector<std::string> keyInputs = invocation.inputs();
+                if (_scanDependencies) {
+                    keyInputs.insert(keyInputs.end(), invocation.inputDependencies().begin(), invocation.inputDependencies().end());
                 }
 
-                if (path) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *path, createProductStructure));
-
-                    process::MemoryContext context = process::MemoryContext(
-                        *path,
-                        invocation.workingDirectory(),
-                        invocation.arguments(),
-                        invocation.environment(),
-                        processContext->userID(),
-                        processContext->groupID(),
-                        processContext->userName(),
-                        processContext->groupName());
-                    ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
-                    success = (exitCode && *exitCode == 0);
-
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *path, createProductStructure));
-                } else {
-                    /* Failed to find executable. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                actionKey = ActionCache::Key(filesystem, *command, keyInputs, ActionCacheOutputs(invocation));
+            }
+
+            bool restored = (actionKey && actionCache->restore(filesystem, *actionKey, ActionCacheOutputs(invocation)));
+
+            outputLock.lock();
+            if (restored) {
+                return RecordInvocation(filesystem, invocation, true, buildLog);
+            }
+        }
+
+        xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *path, createProductStructure));
+        outputLock.unlock();
+
+        /* Audited invocations run under the tracer, which runs the tool. */
+        std::string tracePath;
+        if (inputAudit != nullptr) {
+            tracePath = inputAudit->tracePath();
+        }
+
+        std::vector<std::string> auditArguments;
+        if (inputAudit != nullptr) {
+            auditArguments = inputAudit->arguments(tracePath, *path, invocation.arguments());
+        }
+
+        process::ReferenceContext context = process::ReferenceContext(
+            inputAudit != nullptr ? inputAudit->tracerPath() : *path,
+            invocation.workingDirectory(),
+            inputAudit != nullptr ? auditArguments : invocation.arguments(),
+            invocation.environment(),
+            _environmentBlocks->block(invocation.environment()),
+            processContext);
+        /*
+         * With several jobs, collect each tool's output and print it all at
+         * once when it finishes, so output from tools running alongside each
+         * other isn't interleaved.
+         */
+        std::string output;
+        ext::optional<process::ResourceUsage> usage;
+        auto start = std::chrono::steady_clock::now();
+        ext::optional<int> exitCode = processLauncher->launch(filesystem, &context, &usage, (_jobs > 1 ? &output : nullptr));
+        int64_t duration = Elapsed(start);
+        if (usage) {
+            span.value("user_time_us", usage->userTime());
+            span.value("system_time_us", usage->systemTime());
+            span.value("max_rss_bytes", usage->maximumResidentSetSize());
+            span.value("block_inputs", usage->blockInputs());
+            span.value("block_outputs", usage->blockOutputs());
+        }
+
+        outputLock.lock();
+        if (!output.empty()) {
+            fwrite(output.data(), 1, output.size(), stdout);
+        }
+        xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *path, createProductStructure, exitCode, usage));
+
+        if (buildLog != nullptr && usage) {
+            buildLog->recordMemory(invocation.toolIdentifier(), usage->maximumResidentSetSize());
+        }
+
+        if (inputAudit != nullptr) {
+            for (std::string const &undeclared : inputAudit->audit(filesystem, invocation, *path, tracePath)) {
+                fprintf(stderr, "warning: %s read undeclared input %s\n", FSUtil::GetBaseName(*path).c_str(), undeclared.c_str());
+            }
+        }
+
+        if (actionKey && exitCode && *exitCode == 0) {
+            /* Hashes and copies the outputs, so also without the output lock. */
+            outputLock.unlock();
+            bool stored = StoreActionOutputs(filesystem, *actionCache, *actionKey, invocation);
+            outputLock.lock();
+
+            if (!stored) {
+                fprintf(stderr, "warning: unable to store outputs in action cache %s\n", actionCache->path().c_str());
+            }
+        }
+
+        return RecordInvocation(filesystem, invocation, exitCode && *exitCode == 0, buildLog, duration);
+    } else {
+        abort();
+    }
+}
+
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+performInvocations(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    Filesystem const *executableLookup,
+    std::vector<std::string> const &executablePaths,
+    std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
+    bool createProductStructure,
+    BuildLog *buildLog,
+    ActionCache const *actionCache,
+    InputAudit *inputAudit)
+{
+    if (_dryRun) {
+        return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
+    }
+
+    /*
+     * Find the invocations each invocation is waiting on. Invocations not run in
+     * this pass are still part of the graph, so that ordering is preserved for
+     * invocations depending on each other through them.
+     */
+    pbxbuild::CompactGraph graph = BuildGraph::InvocationGraph(orderedInvocations);
+
+    std::vector<Scheduler::Job> jobs;
+    std::vector<std::vector<size_t>> dependencies;
+    for (size_t index = 0; index < orderedInvocations.size(); ++index) {
+        pbxbuild::Tool::Invocation const &invocation = orderedInvocations[index];
+        std::vector<size_t> invocationDependencies = std::vector<size_t>(graph.adjacent(index).begin(), graph.adjacent(index).end());
+
+        jobs.push_back({ invocation, &executablePaths, std::string(), EstimateInvocation(buildLog, invocation), EstimateMemory(buildLog, invocation) });
+        dependencies.push_back(invocationDependencies);
+    }
+
+    std::mutex outputMutex;
+    std::unordered_set<std::string> createdDirectories;
+    std::mutex builtinMutex;
+
+    /*
+     * Once the product structure exists, create the output directories of
+     * the invocations in this pass together, parents before their contents,
+     * rather than checking them again before each invocation. The product
+     * structure itself is left to its own invocations, as they can create
+     * links where other outputs would otherwise create directories.
+     */
+    if (!createProductStructure) {
+        std::vector<std::string> directories;
+        for (pbxbuild::Tool::Invocation const &invocation : orderedInvocations) {
+            if (invocation.executable() && !invocation.createsProductStructure()) {
+                for (std::string const &output : invocation.outputs()) {
+                    directories.push_back(FSUtil::GetDirectoryName(output));
                 }
-            } else {
-                abort();
             }
+        }
 
-            if (!success) {
-                return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+        std::sort(directories.begin(), directories.end());
+        directories.erase(std::unique(directories.begin(), directories.end()), directories.end());
+        for (std::string const &directory : directories) {
+            if (!CreateDirectory(filesystem, directory, &createdDirectories)) {
+                return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
             }
         }
     }
 
+    /*
+     * As the invocations are passed in order, a single job runs them exactly
+     * in that order.
+     */
+    Scheduler scheduler(std::min(_jobs, orderedInvocations.size()), _memoryLimit, _keepGoing, [&](Scheduler::Job const &job) -> bool {
+        // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
+        if (!job.invocation.executable() || job.invocation.createsProductStructure() != createProductStructure) {
+            return true;
+        }
+
+        return performInvocation(processContext, processLauncher, filesystem, executableLookup, *job.executablePaths, job.invocation, &outputMutex, &createdDirectories, &builtinMutex, buildLog, actionCache, inputAudit);
+    });
+    scheduler.add(jobs, dependencies);
+
+    std::pair<std::vector<pbxbuild::Tool::Invocation>, bool> result = scheduler.finish();
+    if (!result.first.empty()) {
+        return std::make_pair(false, result.first);
+    }
+
+    if (result.second) {
+        fprintf(stderr, "error: cycle detected building invocation graph\n");
+        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+    }
+
     return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
 }
 
+void SimpleExecutor::
+scanInvocations(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment,
+    std::vector<pbxbuild::Tool::Invocation> *invocations)
+{
+    if (!_scanDependencies || _dryRun) {
+        return;
+    }
+
+    ext::optional<std::string> scannerPath = filesystem->findExecutable("clang-scan-deps", targetEnvironment.executablePaths());
+    if (!scannerPath) {
+        fprintf(stderr, "warning: unable to find clang-scan-deps to scan dependencies of %s\n", target->name().c_str());
+        return;
+    }
+
+    std::string databasePath = targetEnvironment.environment().resolve("TARGET_TEMP_DIR") + "/" + "ScanDependencies.json";
+    if (!DependencyScanner::Scan(processContext, processLauncher, filesystem, *scannerPath, databasePath, targetEnvironment.executablePaths(), _jobs, invocations)) {
+        fprintf(stderr, "warning: unable to scan dependencies of %s\n", target->name().c_str());
+    }
+}
+
 std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
 buildTarget(
     process::Context const *processContext,
     process::Launcher *processLauncher,
     Filesystem *filesystem,
+    Filesystem const *executableLookup,
     pbxproj::PBX::Target::shared_ptr const &target,
     pbxbuild::Target::Environment const &targetEnvironment,
     std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
-    std::vector<pbxbuild::Tool::Invocation> const &invocations)
+    std::vector<pbxbuild::Tool::Invocation> &&invocations,
+    BuildLog *buildLog,
+    ActionCache const *actionCache,
+    InputAudit *inputAudit)
 {
     xcformatter::Formatter::Print(_formatter->beginWriteAuxiliaryFiles(target));
     bool auxiliaryFilesSuccess = this->writeAuxiliaryFiles(filesystem, auxiliaryFiles);
@@ -324,20 +1541,22 @@ buildTarget(
         return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
     }
 
-    ext::optional<std::vector<pbxbuild::Tool::Invocation>> orderedInvocations = SortInvocations(invocations);
+    scanInvocations(processContext, processLauncher, filesystem, target, targetEnvironment, &invocations);
+
+    ext::optional<std::vector<pbxbuild::Tool::Invocation>> orderedInvocations = BuildGraph::SortInvocations(std::move(invocations));
     if (!orderedInvocations) {
         fprintf(stderr, "error: cycle detected building invocation graph\n");
         return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
     }
 
     xcformatter::Formatter::Print(_formatter->beginCreateProductStructure(target));
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> structureResult = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, true);
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> structureResult = performInvocations(processContext, processLauncher, filesystem, executableLookup, targetEnvironment.executablePaths(), *orderedInvocations, true, buildLog, actionCache, inputAudit);
     xcformatter::Formatter::Print(_formatter->finishCreateProductStructure(target));
     if (!structureResult.first) {
         return structureResult;
     }
 
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> invocationsResult = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, false);
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> invocationsResult = performInvocations(processContext, processLauncher, filesystem, executableLookup, targetEnvironment.executablePaths(), *orderedInvocations, false, buildLog, actionCache, inputAudit);
     if (!invocationsResult.first) {
         return invocationsResult;
     }
@@ -346,11 +1565,12 @@ buildTarget(
 }
 
 std::unique_ptr<SimpleExecutor> SimpleExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, Options const &options)
 {
     return std::unique_ptr<SimpleExecutor>(new SimpleExecutor(
         formatter,
         dryRun,
-        builtins
+        builtins,
+        options
     ));
 }
@@ -0,0 +1,176 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/WorkspaceCache.h>
+
+using xcexecution::WorkspaceCache;
+using libutil::Filesystem;
+using libutil::FileWatcher;
+
+WorkspaceCache::
+WorkspaceCache() :
+    _fileWatcher(nullptr),
+    _mutex      (std::make_shared<std::mutex>())
+{
+}
+
+WorkspaceCache::
+WorkspaceCache(std::unique_ptr<FileWatcher> fileWatcher) :
+    _fileWatcher(std::move(fileWatcher)),
+    _mutex      (std::make_shared<std::mutex>())
+{
+}
+
+void WorkspaceCache::
+update()
+{
+    if (_fileWatcher == nullptr) {
+        return;
+    }
+
+    /*
+     * Forget workspaces with watched files that changed. If changes could
+     * have been missed, forget every watched workspace.
+     */
+    std::unordered_set<std::string> changed;
+    bool complete = _fileWatcher->changes(&changed);
+
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        bool stale = false;
+        if (it->second.watched) {
+            stale = !complete;
+            for (auto const &stamp : it->second.stamps) {
+                if (stale) {
+                    break;
+                }
+                stale = (changed.find(stamp.first) != changed.end());
+            }
+        }
+
+        if (stale) {
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+ext::optional<pbxbuild::WorkspaceContext> WorkspaceCache::
+find(Filesystem const *filesystem, std::string const &key)
+{
+    std::lock_guard<std::mutex> lock(*_mutex);
+
+    update();
+
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        return ext::nullopt;
+    }
+
+    if (it->second.watched) {
+        /* Any change would have been reported. */
+        return it->second.workspaceContext;
+    }
+
+    for (auto const &stamp : it->second.stamps) {
+        ext::optional<Filesystem::Stamp> current = filesystem->readFileStamp(stamp.first);
+        if (!current || *current != stamp.second) {
+            /* Changed since loaded; it will be loaded again. */
+            _entries.erase(it);
+            return ext::nullopt;
+        }
+    }
+
+    return it->second.workspaceContext;
+}
+
+void WorkspaceCache::
+insert(Filesystem const *filesystem, std::string const &key, pbxbuild::WorkspaceContext const &workspaceContext, std::chrono::system_clock::time_point loadStarted)
+{
+    std::lock_guard<std::mutex> lock(*_mutex);
+
+    update();
+    _entries.erase(key);
+
+    std::vector<std::string> paths = workspaceContext.loadedFilePaths();
+
+    /*
+     * Watch the loaded files, if possible; otherwise their stamps are read
+     * again each time the workspace is used. Watched before the stamps are
+     * read, so no change goes unseen in between.
+     */
+    bool watched = (_fileWatcher != nullptr);
+    for (std::string const &path : paths) {
+        if (watched && !_fileWatcher->watch(path)) {
+            watched = false;
+        }
+    }
+
+    /* Stamps are in nanoseconds since the epoch, like the system clock. */
+    int64_t racy = std::chrono::duration_cast<std::chrono::seconds>(loadStarted.time_since_epoch()).count() * 1000000000;
+
+    std::vector<std::pair<std::string, Filesystem::Stamp>> stamps;
+    for (std::string const &path : paths) {
+        ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(path);
+        if (!stamp) {
+            /* Without a stamp, changes to the file can't be seen. */
+            return;
+        }
+
+        if (stamp->modificationTime >= racy) {
+            /* Possibly changed while loading; what was read may be older than the stamp. */
+            return;
+        }
+
+        stamps.push_back({ path, *stamp });
+    }
+
+    _entries.insert({ key, Entry { workspaceContext, stamps, watched, {} } });
+}
+
+void WorkspaceCache::
+shareTargetEnvironments(std::string const &key, pbxbuild::Build::Context *buildContext)
+{
+    std::lock_guard<std::mutex> lock(*_mutex);
+
+    pbxbuild::WorkspaceContext const &workspaceContext = buildContext->workspaceContext();
+
+    for (auto &entry : _entries) {
+        /* Only the kept workspace itself has the same targets. */
+        if (entry.second.workspaceContext.workspace() != workspaceContext.workspace() ||
+            entry.second.workspaceContext.project() != workspaceContext.project()) {
+            continue;
+        }
+
+        auto it = entry.second.buildContexts.find(key);
+        if (it != entry.second.buildContexts.end()) {
+            buildContext->shareTargetEnvironments(it->second);
+        } else {
+            /* Keep only the target environments, not the other caches for one build. */
+            pbxbuild::Build::Context kept = pbxbuild::Build::Context(
+                buildContext->workspaceContext(),
+                buildContext->scheme(),
+                buildContext->schemeGroup(),
+                buildContext->action(),
+                buildContext->configuration(),
+                buildContext->defaultConfiguration(),
+                buildContext->overrideLevels());
+            kept.shareTargetEnvironments(*buildContext);
+            entry.second.buildContexts.insert({ key, kept });
+        }
+        return;
+    }
+}
+
+void WorkspaceCache::
+clear()
+{
+    std::lock_guard<std::mutex> lock(*_mutex);
+    _entries.clear();
+}
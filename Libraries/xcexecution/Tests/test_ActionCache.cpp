@@ -0,0 +1,241 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/ActionCache.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+using xcexecution::ActionCache;
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static std::string
+Read(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem->read(&contents, path));
+    return std::string(contents.begin(), contents.end());
+}
+
+TEST(ActionCache, RestoreByContents)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", Contents("int main;")),
+        MemoryFilesystem::Entry::File("main.h", Contents("one")),
+        MemoryFilesystem::Entry::File("main.o", Contents("object one")),
+    });
+
+    ActionCache cache = ActionCache("/cache");
+    ext::optional<std::string> key = ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/main.o" });
+    ASSERT_NE(ext::nullopt, key);
+    EXPECT_FALSE(cache.restore(&filesystem, *key, { "/main.o" }));
+    ASSERT_TRUE(cache.store(&filesystem, *key, { "/main.c", "/main.h" }, { "/main.o" }));
+
+    /* A different discovered input is a different run. */
+    ASSERT_TRUE(filesystem.write(Contents("two"), "/main.h"));
+    ASSERT_TRUE(filesystem.write(Contents("object two"), "/main.o"));
+    EXPECT_FALSE(cache.restore(&filesystem, *key, { "/main.o" }));
+    ASSERT_TRUE(cache.store(&filesystem, *key, { "/main.c", "/main.h" }, { "/main.o" }));
+
+    /* Switching back restores the earlier output. */
+    ASSERT_TRUE(filesystem.write(Contents("one"), "/main.h"));
+    EXPECT_TRUE(cache.restore(&filesystem, *key, { "/main.o" }));
+    EXPECT_EQ("object one", Read(&filesystem, "/main.o"));
+
+    /* Removed outputs are restored too. */
+    ASSERT_TRUE(filesystem.write(Contents("two"), "/main.h"));
+    ASSERT_TRUE(filesystem.removeFile("/main.o"));
+    EXPECT_TRUE(cache.restore(&filesystem, *key, { "/main.o" }));
+    EXPECT_EQ("object two", Read(&filesystem, "/main.o"));
+}
+
+TEST(ActionCache, Key)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", Contents("int main;")),
+    });
+
+    ext::optional<std::string> key = ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/main.o" });
+    ASSERT_NE(ext::nullopt, key);
+    EXPECT_EQ(key, ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/main.o" }));
+
+    /* The command, outputs and input contents are all part of the key. */
+    EXPECT_NE(key, ActionCache::Key(&filesystem, "cc -O2", { "/main.c" }, { "/main.o" }));
+    EXPECT_NE(key, ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/other.o" }));
+    ASSERT_TRUE(filesystem.write(Contents("int main = 1;"), "/main.c"));
+    EXPECT_NE(key, ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/main.o" }));
+
+    /* But not when the inputs were changed. */
+    ASSERT_TRUE(filesystem.write(Contents("int main;"), "/main.c"));
+    EXPECT_EQ(key, ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/main.o" }));
+}
+
+TEST(ActionCache, Command)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("cc", { }),
+    });
+
+    /* Without a stamp, changes to the executable can't be seen. */
+    ActionCache cache = ActionCache("/cache");
+    EXPECT_EQ(ext::nullopt, cache.command(&filesystem, "/cc", { "-c" }, { }, "/"));
+}
+
+TEST(ActionCache, CommandByContents)
+{
+    DefaultFilesystem filesystem;
+    char directoryTemplate[] = "/tmp/xcbuild-test-action-cache-XXXXXX";
+    ASSERT_NE(nullptr, ::mkdtemp(directoryTemplate));
+    std::string executable = std::string(directoryTemplate) + "/cc";
+
+    ASSERT_TRUE(filesystem.write(Contents("one"), executable));
+    ActionCache first = ActionCache("/cache");
+    ext::optional<std::string> command = first.command(&filesystem, executable, { "-c" }, { }, "/");
+    ASSERT_NE(ext::nullopt, command);
+
+    /* The same tool installed at another time is the same command. */
+    struct timeval times[2] = { { 1000, 0 }, { 1000, 0 } };
+    ASSERT_EQ(0, ::utimes(executable.c_str(), times));
+    ActionCache second = ActionCache("/cache");
+    EXPECT_EQ(command, second.command(&filesystem, executable, { "-c" }, { }, "/"));
+
+    /* A changed tool is not, even after its hash was remembered. */
+    ASSERT_TRUE(filesystem.write(Contents("two!"), executable));
+    EXPECT_NE(command, first.command(&filesystem, executable, { "-c" }, { }, "/"));
+
+    ASSERT_TRUE(filesystem.removeDirectory(directoryTemplate, true));
+}
+
+TEST(ActionCache, Cacheable)
+{
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("/cc");
+    invocation.outputs() = { "/main.o" };
+    EXPECT_FALSE(ActionCache::Cacheable(invocation));
+
+    /* Only invocations listing what they read are cached. */
+    invocation.dependencyInfo().push_back(pbxbuild::Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, "/main.d"));
+    EXPECT_TRUE(ActionCache::Cacheable(invocation));
+
+    auto builtin = invocation;
+    builtin.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("builtin-copy");
+    EXPECT_FALSE(ActionCache::Cacheable(builtin));
+
+    auto directory = invocation;
+    directory.dependencyInfo().push_back(pbxbuild::Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Directory, "/Resources"));
+    EXPECT_FALSE(ActionCache::Cacheable(directory));
+}
+
+/*
+ * A remote cache kept in a directory of the same filesystem.
+ */
+class DirectoryRemoteCache : public xcexecution::RemoteCache {
+public:
+    mutable size_t uploads = 0;
+
+public:
+    virtual bool fetch(Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const
+    {
+        std::vector<uint8_t> contents;
+        return filesystem->read(&contents, Entry(kind, name)) && filesystem->write(contents, path);
+    }
+
+    virtual bool upload(Filesystem *filesystem, Kind kind, std::string const &name, std::string const &path) const
+    {
+        uploads++;
+        std::vector<uint8_t> contents;
+        return filesystem->read(&contents, path) && filesystem->createDirectory("/remote", true) && filesystem->write(contents, Entry(kind, name));
+    }
+
+private:
+    static std::string Entry(Kind kind, std::string const &name)
+    {
+        return std::string("/remote/") + (kind == Kind::Action ? "ac-" : "cas-") + name;
+    }
+};
+
+TEST(ActionCache, Remote)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", Contents("int main;")),
+        MemoryFilesystem::Entry::File("main.o", Contents("object")),
+    });
+
+    DirectoryRemoteCache remote;
+    ActionCache first = ActionCache("/first", &remote);
+    ActionCache second = ActionCache("/second", &remote);
+
+    ext::optional<std::string> key = ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/main.o" });
+    ASSERT_NE(ext::nullopt, key);
+    ASSERT_TRUE(first.store(&filesystem, *key, { "/main.c" }, { "/main.o" }));
+    EXPECT_EQ(2, remote.uploads);
+
+    /* Another machine restores from the remote cache. */
+    ASSERT_TRUE(filesystem.removeFile("/main.o"));
+    EXPECT_TRUE(second.restore(&filesystem, *key, { "/main.o" }));
+    EXPECT_EQ("object", Read(&filesystem, "/main.o"));
+
+    /* And keeps what it used locally. */
+    ASSERT_TRUE(filesystem.removeDirectory("/remote", true));
+    ASSERT_TRUE(filesystem.removeFile("/main.o"));
+    EXPECT_TRUE(second.restore(&filesystem, *key, { "/main.o" }));
+    EXPECT_EQ("object", Read(&filesystem, "/main.o"));
+
+    /* Without a remote cache, only local entries are used. */
+    ActionCache local = ActionCache("/local");
+    EXPECT_FALSE(local.restore(&filesystem, *key, { "/main.o" }));
+}
+
+TEST(ActionCache, RemoteObjectVerified)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", Contents("int main;")),
+        MemoryFilesystem::Entry::File("main.o", Contents("object")),
+    });
+
+    DirectoryRemoteCache remote;
+    ActionCache first = ActionCache("/first", &remote);
+    ActionCache second = ActionCache("/second", &remote);
+
+    ext::optional<std::string> key = ActionCache::Key(&filesystem, "cc", { "/main.c" }, { "/main.o" });
+    ASSERT_NE(ext::nullopt, key);
+    ASSERT_TRUE(first.store(&filesystem, *key, { "/main.c" }, { "/main.o" }));
+
+    /* Objects whose contents don't match their name are not restored or kept. */
+    bool corrupted = false;
+    ASSERT_TRUE(filesystem.readDirectory("/remote", false, [&](std::string const &name) {
+        if (name.compare(0, 4, "cas-") == 0) {
+            corrupted = filesystem.write(Contents("corrupt"), "/remote/" + name);
+        }
+    }));
+    ASSERT_TRUE(corrupted);
+
+    ASSERT_TRUE(filesystem.removeFile("/main.o"));
+    EXPECT_FALSE(second.restore(&filesystem, *key, { "/main.o" }));
+    EXPECT_FALSE(filesystem.exists("/main.o"));
+
+    size_t files = 0;
+    filesystem.readDirectory("/second", true, [&](std::string const &name) {
+        if (filesystem.type("/second/" + name) == Filesystem::Type::File) {
+            files++;
+        }
+    });
+    EXPECT_EQ(0, files);
+}
@@ -0,0 +1,94 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/BuildGraph.h>
+
+using xcexecution::BuildGraph;
+
+static pbxbuild::Tool::Invocation
+Invocation(std::string const &message, std::vector<std::string> const &inputs, std::vector<std::string> const &outputs)
+{
+    pbxbuild::Tool::Invocation invocation;
+    invocation.logMessage() = message;
+    invocation.inputs() = inputs;
+    invocation.outputs() = outputs;
+    return invocation;
+}
+
+static std::vector<BuildGraph::Target>
+Targets()
+{
+    BuildGraph::Target library;
+    library.name = "Library";
+    library.invocations = {
+        Invocation("Compile a.c", { "a.c" }, { "a.o" }),
+        Invocation("Compile b.c", { "b.c" }, { "b.o" }),
+        Invocation("Link", { "a.o", "b.o" }, { "libLibrary.a" }),
+    };
+
+    BuildGraph::Target application;
+    application.name = "Application \"App\"";
+    application.dependencies = { 0 };
+
+    return { library, application };
+}
+
+TEST(BuildGraph, Dependencies)
+{
+    std::vector<BuildGraph::Target> targets = Targets();
+
+    std::vector<std::vector<size_t>> dependencies = BuildGraph::Dependencies(targets[0].invocations);
+    ASSERT_EQ(3, dependencies.size());
+    EXPECT_TRUE(dependencies[0].empty());
+    EXPECT_TRUE(dependencies[1].empty());
+    EXPECT_EQ(std::vector<size_t>({ 0, 1 }), dependencies[2]);
+}
+
+TEST(BuildGraph, SortInvocations)
+{
+    std::vector<pbxbuild::Tool::Invocation> invocations = {
+        Invocation("Link", { "a.o" }, { "a" }),
+        Invocation("Compile", { "a.c" }, { "a.o" }),
+    };
+
+    auto sorted = BuildGraph::SortInvocations(invocations);
+    ASSERT_TRUE(sorted);
+    EXPECT_EQ("Compile", sorted->at(0).logMessage());
+    EXPECT_EQ("Link", sorted->at(1).logMessage());
+
+    /* Invocations producing each other's inputs can't be ordered. */
+    invocations.push_back(Invocation("Generate", { "a" }, { "a.c" }));
+    EXPECT_FALSE(BuildGraph::SortInvocations(invocations));
+}
+
+TEST(BuildGraph, JSON)
+{
+    BuildGraph graph = BuildGraph(Targets());
+    std::string json = graph.json();
+
+    EXPECT_EQ(0, json.find("{\"targets\":["));
+    EXPECT_NE(std::string::npos, json.find("{\"name\":\"Library\",\"dependencies\":[],\"invocations\":["));
+    EXPECT_NE(std::string::npos, json.find("\"message\":\"Link\",\"inputs\":[\"a.o\",\"b.o\"],\"outputs\":[\"libLibrary.a\"]"));
+    EXPECT_NE(std::string::npos, json.find("\"dependencies\":[0,1]}"));
+    EXPECT_NE(std::string::npos, json.find("{\"name\":\"Application \\\"App\\\"\",\"dependencies\":[0],\"invocations\":[]}"));
+}
+
+TEST(BuildGraph, Dot)
+{
+    BuildGraph graph = BuildGraph(Targets());
+    std::string dot = graph.dot();
+
+    EXPECT_EQ(0, dot.find("digraph build {\n"));
+    EXPECT_NE(std::string::npos, dot.find("label = \"Application \\\"App\\\"\";"));
+    EXPECT_NE(std::string::npos, dot.find("t0_2 [label = \"Link\"];"));
+    EXPECT_NE(std::string::npos, dot.find("t0_0 -> t0_2;"));
+    EXPECT_NE(std::string::npos, dot.find("t0_1 -> t0_2;"));
+    EXPECT_NE(std::string::npos, dot.find("t0 -> t1 [ltail = cluster_0, lhead = cluster_1, style = bold];"));
+}
@@ -0,0 +1,261 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/BuildLog.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::BuildLog;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static pbxbuild::Tool::Invocation
+CompileInvocation()
+{
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("/cc");
+    invocation.arguments() = { "-c", "/main.c", "-o", "/main.o" };
+    invocation.workingDirectory() = "/";
+    invocation.inputs() = { "/main.c" };
+    invocation.outputs() = { "/main.o" };
+    return invocation;
+}
+
+TEST(BuildLog, UpToDate)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.o", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    BuildLog log;
+    pbxbuild::Tool::Invocation invocation = CompileInvocation();
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+
+    log.record(&filesystem, invocation);
+    EXPECT_TRUE(log.upToDate(&filesystem, invocation));
+
+    /* Changed inputs are rebuilt. */
+    EXPECT_TRUE(filesystem.setStamp("/main.c", Filesystem::Stamp({ 0, 2 })));
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+    log.record(&filesystem, invocation);
+    EXPECT_TRUE(log.upToDate(&filesystem, invocation));
+
+    /* Changed or removed outputs are rebuilt. */
+    EXPECT_TRUE(filesystem.setStamp("/main.o", Filesystem::Stamp({ 0, 2 })));
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+    log.record(&filesystem, invocation);
+    ASSERT_TRUE(filesystem.removeFile("/main.o"));
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildLog, ChangedCommand)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.o", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    BuildLog log;
+    log.record(&filesystem, CompileInvocation());
+
+    pbxbuild::Tool::Invocation arguments = CompileInvocation();
+    arguments.arguments().push_back("-O2");
+    EXPECT_FALSE(log.upToDate(&filesystem, arguments));
+
+    pbxbuild::Tool::Invocation environment = CompileInvocation();
+    environment.environment()["PATH"] = "/usr/bin";
+    EXPECT_FALSE(log.upToDate(&filesystem, environment));
+
+    EXPECT_TRUE(log.upToDate(&filesystem, CompileInvocation()));
+}
+
+TEST(BuildLog, DependencyInfo)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.h", { }),
+        MemoryFilesystem::Entry::File("main.o", { }),
+        MemoryFilesystem::Entry::File("main.d", std::vector<uint8_t>({ 'm', 'a', 'i', 'n', '.', 'o', ':', ' ', 'm', 'a', 'i', 'n', '.', 'h', '\n' })),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    pbxbuild::Tool::Invocation invocation = CompileInvocation();
+    invocation.dependencyInfo().push_back(pbxbuild::Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, "main.d"));
+
+    BuildLog log;
+    log.record(&filesystem, invocation);
+    EXPECT_TRUE(log.upToDate(&filesystem, invocation));
+
+    /* Discovered inputs are rebuilt when changed. */
+    EXPECT_TRUE(filesystem.setStamp("/main.h", Filesystem::Stamp({ 0, 2 })));
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+
+    /* Without its dependency info, an invocation is never up to date. */
+    ASSERT_TRUE(filesystem.removeFile("/main.d"));
+    log.record(&filesystem, invocation);
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildLog, PhonyInputs)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("script.sh", { }),
+        MemoryFilesystem::Entry::File("input.txt", { }),
+        MemoryFilesystem::Entry::File("output.txt", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("/bin/sh");
+    invocation.arguments() = { "-c", "/script.sh" };
+    invocation.workingDirectory() = "/";
+    invocation.inputs() = { "/script.sh" };
+    invocation.phonyInputs() = { "/input.txt", "/missing.txt" };
+    invocation.outputs() = { "/output.txt" };
+
+    BuildLog log;
+    log.record(&filesystem, invocation);
+    EXPECT_TRUE(log.upToDate(&filesystem, invocation));
+
+    /* Declared inputs are rebuilt when changed. */
+    EXPECT_TRUE(filesystem.setStamp("/input.txt", Filesystem::Stamp({ 0, 2 })));
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+    log.record(&filesystem, invocation);
+    EXPECT_TRUE(log.upToDate(&filesystem, invocation));
+
+    /* Or when one that was missing appears. */
+    ASSERT_TRUE(filesystem.write({ }, "/missing.txt"));
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildLog, NotRecorded)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    /* Invocations that didn't write their outputs are run again. */
+    BuildLog log;
+    log.record(&filesystem, CompileInvocation());
+    ASSERT_TRUE(filesystem.write({ }, "/main.o"));
+    EXPECT_FALSE(log.upToDate(&filesystem, CompileInvocation()));
+
+    /* As are invocations without any outputs. */
+    pbxbuild::Tool::Invocation invocation = CompileInvocation();
+    invocation.outputs().clear();
+    log.record(&filesystem, invocation);
+    EXPECT_FALSE(log.upToDate(&filesystem, invocation));
+
+    /* Without stamps, changes can't be seen. */
+    auto unstamped = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.o", { }),
+    });
+    log.record(&unstamped, CompileInvocation());
+    EXPECT_FALSE(log.upToDate(&unstamped, CompileInvocation()));
+}
+
+TEST(BuildLog, SaveLoad)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.o", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    {
+        BuildLog log;
+        log.record(&filesystem, CompileInvocation());
+        ASSERT_TRUE(log.save(&filesystem, "/build/log"));
+    }
+
+    BuildLog log;
+    ASSERT_TRUE(log.load(&filesystem, "/build/log"));
+    EXPECT_TRUE(log.upToDate(&filesystem, CompileInvocation()));
+
+    log.forget(CompileInvocation());
+    EXPECT_FALSE(log.upToDate(&filesystem, CompileInvocation()));
+
+    EXPECT_FALSE(log.load(&filesystem, "/build/missing"));
+}
+
+TEST(BuildLog, Duration)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.o", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    BuildLog log;
+    EXPECT_FALSE(log.duration(CompileInvocation()));
+
+    log.record(&filesystem, CompileInvocation(), 1500);
+    EXPECT_EQ(1500, *log.duration(CompileInvocation()));
+
+    /* Restored outputs keep how long the invocation took to run. */
+    EXPECT_TRUE(filesystem.setStamp("/main.c", Filesystem::Stamp({ 0, 2 })));
+    log.record(&filesystem, CompileInvocation());
+    EXPECT_EQ(1500, *log.duration(CompileInvocation()));
+
+    /* Out of date invocations still know how long they took. */
+    EXPECT_TRUE(filesystem.setStamp("/main.c", Filesystem::Stamp({ 0, 3 })));
+    EXPECT_FALSE(log.upToDate(&filesystem, CompileInvocation()));
+    EXPECT_EQ(1500, *log.duration(CompileInvocation()));
+
+    ASSERT_TRUE(log.save(&filesystem, "/build/log"));
+    BuildLog loaded;
+    ASSERT_TRUE(loaded.load(&filesystem, "/build/log"));
+    EXPECT_EQ(1500, *loaded.duration(CompileInvocation()));
+}
+
+TEST(BuildLog, Memory)
+{
+    auto filesystem = MemoryFilesystem({ });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    BuildLog log;
+    EXPECT_FALSE(log.memory("com.apple.pbx.linkers.ld"));
+
+    /* The most memory seen is kept. */
+    log.recordMemory("com.apple.pbx.linkers.ld", 2000);
+    log.recordMemory("com.apple.pbx.linkers.ld", 1000);
+    EXPECT_EQ(2000, *log.memory("com.apple.pbx.linkers.ld"));
+    EXPECT_FALSE(log.memory("com.apple.compilers.gcc"));
+
+    ASSERT_TRUE(log.save(&filesystem, "/build/log"));
+    BuildLog loaded;
+    ASSERT_TRUE(loaded.load(&filesystem, "/build/log"));
+    EXPECT_EQ(2000, *loaded.memory("com.apple.pbx.linkers.ld"));
+}
+
+TEST(BuildLog, Iterate)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.o", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    BuildLog log;
+    log.record(&filesystem, CompileInvocation(), 1500);
+
+    size_t count = 0;
+    log.iterate([&](std::vector<std::string> const &outputs, std::vector<std::string> const &inputs, ext::optional<int64_t> duration) {
+        EXPECT_EQ(std::vector<std::string>({ "/main.o" }), outputs);
+        EXPECT_EQ(std::vector<std::string>({ "/main.c" }), inputs);
+        EXPECT_EQ(1500, duration.value_or(0));
+        count++;
+    });
+    EXPECT_EQ(1, count);
+}
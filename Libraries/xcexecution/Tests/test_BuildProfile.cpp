@@ -0,0 +1,94 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/BuildProfile.h>
+
+using xcexecution::BuildProfile;
+
+static void
+Record(BuildProfile *profile, size_t index, int64_t start, int64_t finish)
+{
+    profile->start(index, start);
+    profile->finish(index, finish);
+}
+
+TEST(BuildProfile, CriticalPath)
+{
+    /*
+     * Two compiles run at once, and the link waits for both through an
+     * unnamed ordering job. The slower compile is on the critical path.
+     */
+    BuildProfile profile;
+    size_t fast = profile.add("App", "CompileC fast.o", { });
+    size_t slow = profile.add("App", "CompileC slow.o", { });
+    size_t order = profile.add("App", "", { fast, slow });
+    size_t link = profile.add("App", "Ld App", { order });
+    size_t skipped = profile.add("App", "Touch App", { link });
+
+    Record(&profile, fast, 0, 100);
+    Record(&profile, slow, 0, 300);
+    Record(&profile, order, 300, 300);
+    Record(&profile, link, 400, 500);
+    (void)skipped;
+
+    EXPECT_EQ(std::vector<size_t>({ slow, link }), profile.criticalPath());
+
+    /* 100us with two running, 300us with one, and 100us with none. */
+    std::vector<int64_t> parallelism = profile.parallelism();
+    ASSERT_EQ(3, parallelism.size());
+    EXPECT_EQ(100, parallelism[0]);
+    EXPECT_EQ(300, parallelism[1]);
+    EXPECT_EQ(100, parallelism[2]);
+
+    std::string report = profile.report();
+    EXPECT_NE(std::string::npos, report.find("Critical path: 0.000s running of 0.001s"));
+    EXPECT_NE(std::string::npos, report.find("0.000s (after 0.000s waiting) App: Ld App"));
+    EXPECT_EQ(std::string::npos, report.find("fast.o"));
+}
+
+TEST(BuildProfile, Simulate)
+{
+    /*
+     * Three compiles and a link, with two slots: the third compile waits
+     * for the first to finish, and the link waits for all of them.
+     */
+    BuildProfile profile;
+    size_t a = profile.add("App", "CompileC a.o", { });
+    size_t b = profile.add("App", "CompileC b.o", { });
+    size_t c = profile.add("App", "CompileC c.o", { });
+    size_t order = profile.add("App", "", { a, b, c });
+    size_t link = profile.add("App", "Ld App", { order });
+
+    profile.simulate(2, { 100, 300, 100, 0, 50 });
+
+    std::vector<BuildProfile::Job> const &jobs = profile.jobs();
+    EXPECT_EQ(0, jobs[a].start);
+    EXPECT_EQ(0, jobs[b].start);
+    EXPECT_EQ(100, jobs[c].start);
+    EXPECT_EQ(200, jobs[c].finish);
+    EXPECT_EQ(300, jobs[order].start);
+    EXPECT_EQ(300, jobs[order].finish);
+    EXPECT_EQ(300, jobs[link].start);
+    EXPECT_EQ(350, jobs[link].finish);
+
+    EXPECT_EQ(std::vector<size_t>({ b, link }), profile.criticalPath());
+
+    /* With one slot, everything runs in order. */
+    profile.simulate(1, { 100, 300, 100, 0, 50 });
+    EXPECT_EQ(400, jobs[c].start);
+    EXPECT_EQ(550, jobs[link].finish);
+}
+
+TEST(BuildProfile, Empty)
+{
+    BuildProfile profile;
+    EXPECT_TRUE(profile.criticalPath().empty());
+    EXPECT_TRUE(profile.parallelism().empty());
+}
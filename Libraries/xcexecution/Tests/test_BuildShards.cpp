@@ -0,0 +1,50 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/BuildShards.h>
+
+using xcexecution::BuildShards;
+
+TEST(BuildShards, Balanced)
+{
+    /* Four independent targets of different sizes. */
+    std::vector<std::vector<size_t>> shards = BuildShards::Partition({ { }, { }, { }, { } }, { 5, 4, 3, 2 }, 2);
+    ASSERT_EQ(2, shards.size());
+    EXPECT_EQ(std::vector<size_t>({ 0, 3 }), shards[0]);
+    EXPECT_EQ(std::vector<size_t>({ 1, 2 }), shards[1]);
+}
+
+TEST(BuildShards, Dependencies)
+{
+    /*
+     * Two applications share a library; a third only needs its own. Each
+     * shard builds everything its applications depend on.
+     */
+    std::vector<std::vector<size_t>> dependencies = {
+        { },
+        { 0 },
+        { 0 },
+        { },
+        { 3 },
+    };
+    std::vector<std::vector<size_t>> shards = BuildShards::Partition(dependencies, { 10, 1, 1, 4, 4 }, 2);
+    ASSERT_EQ(2, shards.size());
+    EXPECT_EQ(std::vector<size_t>({ 0, 1, 2 }), shards[0]);
+    EXPECT_EQ(std::vector<size_t>({ 3, 4 }), shards[1]);
+}
+
+TEST(BuildShards, MoreShardsThanTargets)
+{
+    std::vector<std::vector<size_t>> shards = BuildShards::Partition({ { }, { 0 } }, { 1, 1 }, 3);
+    ASSERT_EQ(3, shards.size());
+    EXPECT_EQ(std::vector<size_t>({ 0, 1 }), shards[0]);
+    EXPECT_TRUE(shards[1].empty());
+    EXPECT_TRUE(shards[2].empty());
+}
@@ -0,0 +1,84 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/CommandRemoteCache.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+#include <process/MemoryLauncher.h>
+
+using xcexecution::CommandRemoteCache;
+using xcexecution::RemoteCache;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static process::MemoryContext
+Context(std::unordered_map<std::string, std::string> const &environment)
+{
+    return process::MemoryContext("/xcbuild", "/", { }, environment, 0, 0, "root", "wheel");
+}
+
+TEST(CommandRemoteCache, Transfer)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("object", std::vector<uint8_t>({ 'o' })),
+    });
+
+    /* Stores entries under a directory, like a helper for a shared mount. */
+    std::vector<std::vector<std::string>> calls;
+    auto launcher = process::MemoryLauncher({
+        { "/helper", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            std::vector<std::string> const &arguments = context->commandLineArguments();
+            calls.push_back(arguments);
+
+            std::string entry = "/remote/" + arguments[1] + "/" + arguments[2];
+            std::vector<uint8_t> contents;
+            if (arguments[0] == "put") {
+                return (filesystem->read(&contents, arguments[3]) && filesystem->createDirectory("/remote/" + arguments[1], true) && filesystem->write(contents, entry)) ? 0 : 1;
+            } else {
+                if (filesystem->type(entry) != Filesystem::Type::File) {
+                    /* A partial download is removed. */
+                    filesystem->write({ }, arguments[3]);
+                    return 1;
+                }
+                return (filesystem->read(&contents, entry) && filesystem->write(contents, arguments[3])) ? 0 : 1;
+            }
+        } },
+    });
+
+    process::MemoryContext context = Context({ });
+    CommandRemoteCache remote = CommandRemoteCache(&launcher, &context, "/helper");
+
+    EXPECT_FALSE(remote.fetch(&filesystem, RemoteCache::Kind::Object, "abc", "/fetched"));
+    EXPECT_FALSE(filesystem.exists("/fetched"));
+
+    EXPECT_TRUE(remote.upload(&filesystem, RemoteCache::Kind::Object, "abc", "/object"));
+    EXPECT_TRUE(remote.fetch(&filesystem, RemoteCache::Kind::Object, "abc", "/fetched"));
+    EXPECT_TRUE(filesystem.exists("/fetched"));
+
+    /* Action entries are in a separate namespace. */
+    EXPECT_FALSE(remote.fetch(&filesystem, RemoteCache::Kind::Action, "abc", "/action"));
+
+    ASSERT_EQ(4, calls.size());
+    EXPECT_EQ(std::vector<std::string>({ "get", "cas", "abc", "/fetched" }), calls[0]);
+    EXPECT_EQ(std::vector<std::string>({ "put", "cas", "abc", "/object" }), calls[1]);
+    EXPECT_EQ(std::vector<std::string>({ "get", "ac", "abc", "/action" }), calls[3]);
+}
+
+TEST(CommandRemoteCache, Helper)
+{
+    process::MemoryContext none = Context({ });
+    EXPECT_EQ(ext::nullopt, CommandRemoteCache::Helper(&none));
+
+    process::MemoryContext empty = Context({ { "XCBUILD_ACTION_CACHE_REMOTE", "" } });
+    EXPECT_EQ(ext::nullopt, CommandRemoteCache::Helper(&empty));
+
+    process::MemoryContext helper = Context({ { "XCBUILD_ACTION_CACHE_REMOTE", "/helper" } });
+    EXPECT_EQ(std::string("/helper"), CommandRemoteCache::Helper(&helper));
+}
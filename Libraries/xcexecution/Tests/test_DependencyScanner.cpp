@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/DependencyScanner.h>
+
+using xcexecution::DependencyScanner;
+
+static pbxbuild::Tool::Invocation
+Compile(std::string const &input, std::string const &output)
+{
+    pbxbuild::Tool::Invocation invocation;
+    invocation.toolIdentifier() = "com.apple.compilers.llvm.clang.1_0.compiler";
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("clang");
+    invocation.arguments() = { "-x", "c", "-MMD", "-MT", "dependencies", "-MF", output + ".d", "-c", input, "-o", output };
+    invocation.workingDirectory() = "/project";
+    invocation.inputs() = { input };
+    invocation.outputs() = { output };
+    invocation.dependencyInfo() = { pbxbuild::Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, output + ".d") };
+    return invocation;
+}
+
+TEST(DependencyScanner, Scannable)
+{
+    EXPECT_TRUE(DependencyScanner::Scannable(Compile("/project/a.c", "/build/a.o")));
+
+    pbxbuild::Tool::Invocation builtin = Compile("/project/a.c", "/build/a.o");
+    builtin.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("builtin-copy");
+    EXPECT_FALSE(DependencyScanner::Scannable(builtin));
+
+    pbxbuild::Tool::Invocation link = Compile("/project/a.c", "/build/a.o");
+    link.toolIdentifier() = "com.apple.pbx.linkers.ld";
+    EXPECT_FALSE(DependencyScanner::Scannable(link));
+
+    pbxbuild::Tool::Invocation undependent = Compile("/project/a.c", "/build/a.o");
+    undependent.dependencyInfo().clear();
+    EXPECT_FALSE(DependencyScanner::Scannable(undependent));
+}
+
+TEST(DependencyScanner, CompilationDatabase)
+{
+    pbxbuild::Tool::Invocation invocation = Compile("/project/a.c", "/build/a.o");
+    std::string database = DependencyScanner::CompilationDatabase({ { "/usr/bin/clang", &invocation } });
+
+    /* Dependency info arguments are dropped along with their values. */
+    EXPECT_EQ(
+        "[\n"
+        "{\"directory\":\"/project\",\"file\":\"/project/a.c\",\"output\":\"/build/a.o\","
+        "\"arguments\":[\"/usr/bin/clang\",\"-x\",\"c\",\"-c\",\"/project/a.c\",\"-o\",\"/build/a.o\"]}\n"
+        "]\n",
+        database);
+}
+
+TEST(DependencyScanner, Dependencies)
+{
+    std::string output =
+        "/build/a.o: /project/a.c /project/a.h \\\n"
+        "  /project/b\\ c.h\n"
+        "/project/b.c:1:10: fatal error: 'missing.h' file not found\n"
+        "other.o: other.c\n"
+        "/build/b.o: /project/b.c\n";
+
+    std::unordered_map<std::string, std::vector<std::string>> dependencies = DependencyScanner::Dependencies(output, { "/build/a.o", "/build/b.o" });
+    ASSERT_EQ(2, dependencies.size());
+    EXPECT_EQ(std::vector<std::string>({ "/project/a.c", "/project/a.h", "/project/b c.h" }), dependencies["/build/a.o"]);
+    EXPECT_EQ(std::vector<std::string>({ "/project/b.c" }), dependencies["/build/b.o"]);
+}
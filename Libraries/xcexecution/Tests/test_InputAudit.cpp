@@ -0,0 +1,82 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/InputAudit.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::InputAudit;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(InputAudit, Reads)
+{
+    std::string trace =
+        "r|/main.c\n"
+        "r|/main.h\n"
+        "r|/main.c\n"
+        "w|/main.o\n"
+        "r|/main.o\n"
+        "w|/tmp/scratch\n"
+        "m|/tmp/moved|/tmp/scratch\n"
+        "r|/tmp/moved\n"
+        "d|/tmp/deleted\n"
+        "r|/tmp/deleted\n"
+        "invalid\n";
+
+    /* Files the process wrote itself are not inputs. */
+    EXPECT_EQ(std::vector<std::string>({ "/main.c", "/main.h" }), InputAudit::Reads(trace));
+}
+
+TEST(InputAudit, Audit)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("cc", { }),
+        MemoryFilesystem::Entry::File("main.c", { }),
+        MemoryFilesystem::Entry::File("main.h", { }),
+        MemoryFilesystem::Entry::File("other.h", { }),
+        MemoryFilesystem::Entry::File("main.d", Contents("main.o: main.h\n")),
+        MemoryFilesystem::Entry::Directory("usr", {
+            MemoryFilesystem::Entry::File("stdio.h", { }),
+        }),
+        MemoryFilesystem::Entry::Directory("tmp", {
+            MemoryFilesystem::Entry::File("trace", Contents("r|/cc\nr|/main.c\nr|/main.h\nr|/other.h\nr|/usr/stdio.h\nr|/main.d\nr|/\n")),
+        }),
+    });
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("/cc");
+    invocation.workingDirectory() = "/";
+    invocation.inputs() = { "main.c" };
+    invocation.outputs() = { "main.o" };
+    invocation.dependencyInfo().push_back(pbxbuild::Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, "main.d"));
+
+    /* Declared and discovered inputs and ignored directories are expected. */
+    InputAudit audit("/fsatrace", "/tmp", { "/usr" });
+    EXPECT_EQ(std::vector<std::string>({ "/other.h" }), audit.audit(&filesystem, invocation, "/cc", "/tmp/trace"));
+    EXPECT_FALSE(filesystem.exists("/tmp/trace"));
+
+    /* A missing trace counts as undeclared, since the reads are unknown. */
+    EXPECT_EQ(std::vector<std::string>(), audit.audit(&filesystem, invocation, "/cc", "/tmp/trace"));
+
+    ASSERT_EQ(1, audit.tools().size());
+    EXPECT_EQ(std::make_pair(size_t(2), size_t(2)), audit.tools().at("cc"));
+}
+
+TEST(InputAudit, Arguments)
+{
+    InputAudit audit("/fsatrace", "/tmp", { });
+    EXPECT_NE(audit.tracePath(), audit.tracePath());
+    EXPECT_EQ(std::vector<std::string>({ "rwmd", "/trace", "--", "/cc", "-c", "main.c" }), audit.arguments("/trace", "/cc", { "-c", "main.c" }));
+}
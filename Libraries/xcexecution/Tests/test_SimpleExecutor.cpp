@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 #include <xcexecution/SimpleExecutor.h>
+#include <xcexecution/BuildLog.h>
 #include <xcformatter/NullFormatter.h>
 #include <pbxbuild/Tool/Invocation.h>
 #include <builtin/Driver.h>
@@ -17,6 +18,11 @@
 #include <process/MemoryLauncher.h>
 #include <libutil/MemoryFilesystem.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 using xcexecution::SimpleExecutor;
 using libutil::Filesystem;
 using libutil::MemoryFilesystem;
@@ -28,11 +34,13 @@ public:
 private:
     std::string _name;
     Impl        _impl;
+    bool        _reentrant;
 
 public:
-    Driver(std::string const &name, Impl const &impl) :
+    Driver(std::string const &name, Impl const &impl, bool reentrant = false) :
         _name(name),
-        _impl(impl)
+        _impl(impl),
+        _reentrant(reentrant)
     {
     }
 
@@ -41,8 +49,10 @@ public:
     { return _name; }
 
 public:
-    virtual int run(process::Context const *processContext, Filesystem *filesystem)
+    virtual int run(process::Context const *processContext, Filesystem *filesystem) const
     { return _impl(processContext, filesystem); }
+    virtual bool reentrant() const
+    { return _reentrant; }
 };
 
 TEST(SimpleExecutor, PropagateToolResult)
@@ -95,19 +105,23 @@ TEST(SimpleExecutor, PropagateToolResult)
     /* Create test executor. */
     auto formatter = xcformatter::NullFormatter::Create();
     std::vector<std::string> const executablePaths = { "/" };
-    SimpleExecutor executor = SimpleExecutor(formatter, false, registry);
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, SimpleExecutor::Options());
 
     /* Succeed if all tools succeed. */
     auto success = executor.performInvocations(
         &context,
         &launcher,
         &filesystem,
+        &filesystem,
         executablePaths,
         {
             builtinSuccess,
             externalSuccess,
         },
-        false);
+        false,
+        nullptr,
+        nullptr,
+        nullptr);
     ASSERT_TRUE(success.first);
     EXPECT_EQ(success.second.size(), 0);
 
@@ -116,13 +130,17 @@ TEST(SimpleExecutor, PropagateToolResult)
         &context,
         &launcher,
         &filesystem,
+        &filesystem,
         executablePaths,
         {
             externalFail,
             builtinSuccess,
             externalSuccess,
         },
-        false);
+        false,
+        nullptr,
+        nullptr,
+        nullptr);
     ASSERT_FALSE(fail1.first);
     EXPECT_EQ(fail1.second.size(), 1);
 
@@ -131,6 +149,7 @@ TEST(SimpleExecutor, PropagateToolResult)
         &context,
         &launcher,
         &filesystem,
+        &filesystem,
         executablePaths,
         {
             builtinSuccess,
@@ -138,8 +157,471 @@ TEST(SimpleExecutor, PropagateToolResult)
             externalSuccess,
             externalFail,
         },
-        false);
+        false,
+        nullptr,
+        nullptr,
+        nullptr);
     ASSERT_FALSE(fail2.first);
     EXPECT_EQ(fail2.second.size(), 1);
 }
 
+
+TEST(SimpleExecutor, KeepGoing)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("fail-tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("success-tool", std::vector<uint8_t>()),
+    });
+
+    std::vector<std::string> ran;
+    auto launcher = process::MemoryLauncher({
+        { "/fail-tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            ran.push_back(context->commandLineArguments().front());
+            return 1;
+        } },
+        { "/success-tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            ran.push_back(context->commandLineArguments().front());
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /* Two failing invocations, one depended on, and one independent invocation. */
+    auto invocation = [](std::string const &tool, std::string const &name, std::vector<std::string> const &inputs) {
+        auto invocation = pbxbuild::Tool::Invocation();
+        invocation.executable() = pbxbuild::Tool::Invocation::Executable::External(tool);
+        invocation.arguments() = { name };
+        invocation.inputs() = inputs;
+        invocation.outputs() = { "/out/" + name };
+        return invocation;
+    };
+    std::vector<pbxbuild::Tool::Invocation> invocations = {
+        invocation("fail-tool", "first", { }),
+        invocation("success-tool", "dependent", { "/out/first" }),
+        invocation("success-tool", "independent", { }),
+        invocation("fail-tool", "second", { }),
+    };
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+
+    /* Without keeping going, the first failure stops the rest. */
+    SimpleExecutor stopping = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), SimpleExecutor::Options());
+    auto stopped = stopping.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, invocations, false, nullptr, nullptr, nullptr);
+    EXPECT_FALSE(stopped.first);
+    EXPECT_EQ(1, stopped.second.size());
+    EXPECT_EQ(std::vector<std::string>({ "first" }), ran);
+
+    /* Keeping going runs everything not waiting on a failure, and reports each failure. */
+    ran.clear();
+    SimpleExecutor::Options goingOptions;
+    goingOptions.keepGoing = true;
+    SimpleExecutor going = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), goingOptions);
+    auto kept = going.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, invocations, false, nullptr, nullptr, nullptr);
+    EXPECT_FALSE(kept.first);
+    EXPECT_EQ(2, kept.second.size());
+    EXPECT_EQ(std::vector<std::string>({ "first", "independent", "second" }), ran);
+}
+
+TEST(SimpleExecutor, ParallelJobs)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+    });
+
+    /* Each tool waits until at least two tools are running at once. */
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t running = 0;
+    size_t maximum = 0;
+    std::vector<std::string> order;
+
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            std::unique_lock<std::mutex> lock(mutex);
+            running++;
+            maximum = std::max(maximum, running);
+            condition.notify_all();
+            condition.wait_for(lock, std::chrono::seconds(5), [&]{ return maximum >= 2; });
+            order.push_back(context->commandLineArguments().front());
+            running--;
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /* Two independent invocations, and one depending on both. */
+    auto first = pbxbuild::Tool::Invocation();
+    first.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    first.arguments() = { "first" };
+    first.outputs() = { "/out/first" };
+    auto second = pbxbuild::Tool::Invocation();
+    second.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    second.arguments() = { "second" };
+    second.outputs() = { "/out/second" };
+    auto third = pbxbuild::Tool::Invocation();
+    third.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    third.arguments() = { "third" };
+    third.inputs() = { "/out/first", "/out/second" };
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor::Options options;
+    options.jobs = 4;
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), options);
+
+    auto result = executor.performInvocations(
+        &context,
+        &launcher,
+        &filesystem,
+        &filesystem,
+        executablePaths,
+        { first, second, third },
+        false,
+        nullptr,
+        nullptr,
+        nullptr);
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(2, maximum);
+    ASSERT_EQ(3, order.size());
+    EXPECT_EQ("third", order[2]);
+}
+
+TEST(SimpleExecutor, CriticalPathFirst)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+    });
+
+    /* Each tool waits until two tools are running, so both first starts are recorded. */
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t running = 0;
+    size_t maximum = 0;
+    std::vector<std::string> started;
+
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            std::unique_lock<std::mutex> lock(mutex);
+            started.push_back(context->commandLineArguments().front());
+            running++;
+            maximum = std::max(maximum, running);
+            condition.notify_all();
+            condition.wait_for(lock, std::chrono::seconds(5), [&]{ return maximum >= 2; });
+            running--;
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /* Two independent invocations, then the start of a chain of three. */
+    std::vector<pbxbuild::Tool::Invocation> invocations;
+    for (std::string const &name : { "single1", "single2", "chain1", "chain2", "chain3" }) {
+        auto invocation = pbxbuild::Tool::Invocation();
+        invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+        invocation.arguments() = { name };
+        invocation.outputs() = { "/out/" + name };
+        invocations.push_back(invocation);
+    }
+    invocations[3].inputs() = { "/out/chain1" };
+    invocations[4].inputs() = { "/out/chain2" };
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor::Options options;
+    options.jobs = 2;
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), options);
+
+    auto result = executor.performInvocations(
+        &context,
+        &launcher,
+        &filesystem,
+        &filesystem,
+        executablePaths,
+        invocations,
+        false,
+        nullptr,
+        nullptr,
+        nullptr);
+    ASSERT_TRUE(result.first);
+    ASSERT_EQ(5, started.size());
+
+    /* The chain starts before the second independent invocation. */
+    std::vector<std::string> first = { started[0], started[1] };
+    std::sort(first.begin(), first.end());
+    EXPECT_EQ(std::vector<std::string>({ "chain1", "single1" }), first);
+}
+
+TEST(SimpleExecutor, MemoryLimit)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+    });
+
+    /* Each tool waits a short time for all three to be running at once. */
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t running = 0;
+    size_t maximum = 0;
+
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            std::unique_lock<std::mutex> lock(mutex);
+            running++;
+            maximum = std::max(maximum, running);
+            condition.notify_all();
+            condition.wait_for(lock, std::chrono::milliseconds(200), [&]{ return running >= 3; });
+            running--;
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    xcexecution::BuildLog buildLog;
+    buildLog.recordMemory("large", 600);
+    buildLog.recordMemory("small", 300);
+
+    auto invocations = [](std::string const &tool) {
+        std::vector<pbxbuild::Tool::Invocation> invocations;
+        for (std::string const &name : { "first", "second", "third" }) {
+            auto invocation = pbxbuild::Tool::Invocation();
+            invocation.toolIdentifier() = tool;
+            invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+            invocation.outputs() = { "/" + tool + "/" + name };
+            invocations.push_back(invocation);
+        }
+        return invocations;
+    };
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor::Options options;
+    options.jobs = 4;
+    options.memoryLimit = 1000;
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), options);
+
+    /* Tools that used too much memory to fit together run one at a time. */
+    auto largeResult = executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, invocations("large"), false, &buildLog, nullptr, nullptr);
+    ASSERT_TRUE(largeResult.first);
+    EXPECT_EQ(1, maximum);
+
+    /* Smaller tools run as many at once as fit. */
+    maximum = 0;
+    auto smallResult = executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, invocations("small"), false, &buildLog, nullptr, nullptr);
+    ASSERT_TRUE(smallResult.first);
+    EXPECT_EQ(3, maximum);
+}
+
+TEST(SimpleExecutor, ParallelBuiltins)
+{
+    auto filesystem = MemoryFilesystem({ });
+    auto launcher = process::MemoryLauncher({ });
+
+    /* Each builtin waits a short time for another to be running at once. */
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t running = 0;
+    size_t maximum = 0;
+    auto wait = [&](process::Context const *context, Filesystem *filesystem) -> int {
+        std::unique_lock<std::mutex> lock(mutex);
+        running++;
+        maximum = std::max(maximum, running);
+        condition.notify_all();
+        condition.wait_for(lock, std::chrono::milliseconds(500), [&]{ return running >= 2; });
+        running--;
+        return 0;
+    };
+
+    auto registry = builtin::Registry::Create({
+        std::static_pointer_cast<builtin::Driver>(std::make_shared<Driver>("builtin-reentrant", wait, true)),
+        std::static_pointer_cast<builtin::Driver>(std::make_shared<Driver>("builtin-serial", wait, false)),
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor::Options options;
+    options.jobs = 4;
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, options);
+
+    /* Independent reentrant builtins run at the same time. */
+    std::vector<pbxbuild::Tool::Invocation> reentrant;
+    for (std::string const &name : { "first", "second" }) {
+        auto invocation = pbxbuild::Tool::Invocation();
+        invocation.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("builtin-reentrant");
+        invocation.outputs() = { "/out/" + name };
+        reentrant.push_back(invocation);
+    }
+
+    auto reentrantResult = executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, reentrant, false, nullptr, nullptr, nullptr);
+    ASSERT_TRUE(reentrantResult.first);
+    EXPECT_EQ(2, maximum);
+
+    /* Other builtins still run one at a time. */
+    maximum = 0;
+    std::vector<pbxbuild::Tool::Invocation> serial;
+    for (std::string const &name : { "first", "second" }) {
+        auto invocation = pbxbuild::Tool::Invocation();
+        invocation.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("builtin-serial");
+        invocation.outputs() = { "/serial/" + name };
+        serial.push_back(invocation);
+    }
+
+    auto serialResult = executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, serial, false, nullptr, nullptr, nullptr);
+    ASSERT_TRUE(serialResult.first);
+    EXPECT_EQ(1, maximum);
+}
+
+TEST(SimpleExecutor, SkipUpToDate)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("input", std::vector<uint8_t>()),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    size_t runs = 0;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            runs++;
+            return (filesystem->write(std::vector<uint8_t>(), "/out/output") ? 0 : 1);
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    invocation.inputs() = { "/input" };
+    invocation.outputs() = { "/out/output" };
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), SimpleExecutor::Options());
+    xcexecution::BuildLog buildLog;
+
+    /* Only run again once out of date. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, { invocation }, false, &buildLog, nullptr, nullptr).first);
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, { invocation }, false, &buildLog, nullptr, nullptr).first);
+    EXPECT_EQ(1, runs);
+
+    invocation.arguments() = { "changed" };
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, { invocation }, false, &buildLog, nullptr, nullptr).first);
+    EXPECT_EQ(2, runs);
+
+    /* Without a build log, always run. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, { invocation }, false, nullptr, nullptr, nullptr).first);
+    EXPECT_EQ(3, runs);
+}
+
+static pbxbuild::Tool::Invocation
+EstimateInvocation(std::string const &tool, std::vector<std::string> const &inputs, std::string const &output)
+{
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.toolIdentifier() = tool;
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External(tool);
+    invocation.logMessage() = tool + " " + output;
+    invocation.inputs() = inputs;
+    invocation.outputs() = { output };
+    return invocation;
+}
+
+TEST(SimpleExecutor, Estimate)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("a.c", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("a.o", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("b.c", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("lib.a", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("app", std::vector<uint8_t>()),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 0, 1 }));
+
+    auto compileA = EstimateInvocation("cc", { "/a.c" }, "/a.o");
+    auto compileB = EstimateInvocation("cc", { "/b.c" }, "/b.o");
+    auto link = EstimateInvocation("ld", { "/a.o", "/b.o" }, "/lib.a");
+    auto linkApp = EstimateInvocation("ld", { "/lib.a" }, "/app");
+
+    /* Only the first compile and the library link ran before. */
+    xcexecution::BuildLog buildLog;
+    buildLog.record(&filesystem, compileA, 1000);
+    buildLog.record(&filesystem, link, 500);
+
+    xcexecution::BuildGraph::Target library;
+    library.name = "Library";
+    library.invocations = { compileA, compileB, link };
+    xcexecution::BuildGraph::Target application;
+    application.name = "Application";
+    application.dependencies = { 0 };
+    application.invocations = { linkApp };
+    xcexecution::BuildGraph graph = xcexecution::BuildGraph({ library, application });
+
+    /*
+     * The new compile runs, and the links run after it as their inputs will
+     * change. Unrecorded invocations take as long as the same tool did.
+     */
+    auto formatter = xcformatter::NullFormatter::Create();
+    SimpleExecutor::Options options;
+    options.jobs = 2;
+    options.parallelizeTargets = true;
+    SimpleExecutor executor = SimpleExecutor(formatter, true, builtin::Registry::Create({ }), options);
+    std::string estimate = executor.estimate(&filesystem, graph, buildLog);
+    EXPECT_NE(std::string::npos, estimate.find("Estimate: 3 of 4 invocations would run, 2 without a recorded duration\n"));
+    EXPECT_NE(std::string::npos, estimate.find("0.002s of work with 2 jobs and parallelized targets\n"));
+    EXPECT_NE(std::string::npos, estimate.find("Critical path: 0.002s running of 0.002s\n"));
+    EXPECT_NE(std::string::npos, estimate.find("Application: ld /app\n"));
+    EXPECT_EQ(std::string::npos, estimate.find("cc /a.o"));
+}
@@ -0,0 +1,162 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/WorkspaceCache.h>
+#include <pbxsetting/Environment.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/FileWatcher.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <cstdlib>
+#include <sys/time.h>
+
+using xcexecution::WorkspaceCache;
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::FileWatcher;
+using libutil::MemoryFilesystem;
+
+/*
+ * When loading started, after the stamps of files not changed while loading.
+ */
+static std::chrono::system_clock::time_point const LoadStarted = std::chrono::system_clock::time_point(std::chrono::seconds(10));
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static std::string const ProjectContents =
+    "{\n"
+    "    archiveVersion = 1;\n"
+    "    objectVersion = 46;\n"
+    "    objects = {\n"
+    "        P = { isa = PBXProject; buildConfigurationList = L; mainGroup = G; targets = ( ); };\n"
+    "        L = { isa = XCConfigurationList; buildConfigurations = ( ); };\n"
+    "        G = { isa = PBXGroup; children = ( ); };\n"
+    "    };\n"
+    "    rootObject = P;\n"
+    "}\n";
+
+TEST(WorkspaceCache, Changed)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("P.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", Contents(ProjectContents)),
+        }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/P.xcodeproj");
+    ASSERT_NE(project, nullptr);
+    pbxbuild::WorkspaceContext workspaceContext = pbxbuild::WorkspaceContext::Project(&filesystem, "user", pbxsetting::Environment(), project);
+
+    WorkspaceCache cache;
+    EXPECT_FALSE(cache.find(&filesystem, "P"));
+
+    /* Unchanged workspaces are used again. */
+    cache.insert(&filesystem, "P", workspaceContext, LoadStarted);
+    ext::optional<pbxbuild::WorkspaceContext> found = cache.find(&filesystem, "P");
+    ASSERT_TRUE(found);
+    EXPECT_EQ(found->project(), project);
+    EXPECT_FALSE(cache.find(&filesystem, "other"));
+
+    /* Changed workspaces are not. */
+    filesystem.setStamp(Filesystem::Stamp({ 1, 2 }));
+    EXPECT_FALSE(cache.find(&filesystem, "P"));
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+    EXPECT_FALSE(cache.find(&filesystem, "P"));
+}
+
+TEST(WorkspaceCache, Unstamped)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("P.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", Contents(ProjectContents)),
+        }),
+    });
+
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/P.xcodeproj");
+    ASSERT_NE(project, nullptr);
+    pbxbuild::WorkspaceContext workspaceContext = pbxbuild::WorkspaceContext::Project(&filesystem, "user", pbxsetting::Environment(), project);
+
+    /* Without stamps, changes can't be seen, so workspaces aren't kept. */
+    WorkspaceCache cache;
+    cache.insert(&filesystem, "P", workspaceContext, LoadStarted);
+    EXPECT_FALSE(cache.find(&filesystem, "P"));
+}
+
+TEST(WorkspaceCache, ChangedWhileLoading)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("P.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", Contents(ProjectContents)),
+        }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/P.xcodeproj");
+    ASSERT_NE(project, nullptr);
+    pbxbuild::WorkspaceContext workspaceContext = pbxbuild::WorkspaceContext::Project(&filesystem, "user", pbxsetting::Environment(), project);
+
+    /* Modified after loading started; what was loaded may be older. */
+    WorkspaceCache cache;
+    filesystem.setStamp(Filesystem::Stamp({ 1, 10500000000 }));
+    cache.insert(&filesystem, "P", workspaceContext, LoadStarted);
+    EXPECT_FALSE(cache.find(&filesystem, "P"));
+
+    /* Even in the same second, for filesystems with coarse times. */
+    filesystem.setStamp(Filesystem::Stamp({ 1, 10000000000 }));
+    cache.insert(&filesystem, "P", workspaceContext, LoadStarted + std::chrono::milliseconds(500));
+    EXPECT_FALSE(cache.find(&filesystem, "P"));
+
+    filesystem.setStamp(Filesystem::Stamp({ 1, 9999999999 }));
+    cache.insert(&filesystem, "P", workspaceContext, LoadStarted);
+    EXPECT_TRUE(cache.find(&filesystem, "P"));
+}
+
+TEST(WorkspaceCache, Watched)
+{
+    std::unique_ptr<FileWatcher> watcher = FileWatcher::Create();
+    if (watcher == nullptr) {
+        /* Not supported on this platform. */
+        return;
+    }
+
+    char directoryTemplate[] = "/tmp/xcbuild-test-workspace-cache-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string directory = directoryTemplate;
+
+    DefaultFilesystem filesystem;
+    ASSERT_TRUE(filesystem.createDirectory(directory + "/P.xcodeproj", false));
+    ASSERT_TRUE(filesystem.write(Contents(ProjectContents), directory + "/P.xcodeproj/project.pbxproj"));
+
+    /* Written well before loading, so not mistaken for a change while loading. */
+    struct timeval times[2] = { { 1000000000, 0 }, { 1000000000, 0 } };
+    ASSERT_EQ(0, ::utimes((directory + "/P.xcodeproj/project.pbxproj").c_str(), times));
+
+    std::chrono::system_clock::time_point loadStarted = std::chrono::system_clock::now();
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, directory + "/P.xcodeproj");
+    ASSERT_NE(project, nullptr);
+    pbxbuild::WorkspaceContext workspaceContext = pbxbuild::WorkspaceContext::Project(&filesystem, "user", pbxsetting::Environment(), project);
+
+    WorkspaceCache cache = WorkspaceCache(std::move(watcher));
+    cache.insert(&filesystem, "P", workspaceContext, loadStarted);
+    EXPECT_TRUE(cache.find(&filesystem, "P"));
+
+    /* The change is reported by the watcher. */
+    ASSERT_TRUE(filesystem.write(Contents(ProjectContents + "\n"), directory + "/P.xcodeproj/project.pbxproj"));
+    EXPECT_FALSE(cache.find(&filesystem, "P"));
+
+    EXPECT_TRUE(filesystem.removeFile(directory + "/P.xcodeproj/project.pbxproj"));
+    EXPECT_TRUE(filesystem.removeDirectory(directory + "/P.xcodeproj", false));
+    EXPECT_TRUE(filesystem.removeDirectory(directory, false));
+}
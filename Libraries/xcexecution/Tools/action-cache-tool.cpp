@@ -0,0 +1,288 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/CommandRemoteCache.h>
+#include <dependency/DependencyInfoFormat.h>
+#include <dependency/DependencyInfoMerger.h>
+#include <libutil/Options.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/DefaultContext.h>
+#include <process/DefaultLauncher.h>
+#include <process/MemoryContext.h>
+
+using xcexecution::ActionCache;
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+class Options {
+private:
+    ext::optional<bool>        _help;
+    ext::optional<bool>        _version;
+
+private:
+    ext::optional<std::string> _cache;
+    ext::optional<std::string> _remote;
+    std::vector<std::string>   _inputs;
+    std::vector<std::string>   _outputs;
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> _dependencyInfo;
+    std::vector<std::string>   _command;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool help() const
+    { return _help.value_or(false); }
+    bool version() const
+    { return _version.value_or(false); }
+
+public:
+    ext::optional<std::string> const &cache() const
+    { return _cache; }
+    ext::optional<std::string> const &remote() const
+    { return _remote; }
+    std::vector<std::string> const &inputs() const
+    { return _inputs; }
+    std::vector<std::string> const &outputs() const
+    { return _outputs; }
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> const &dependencyInfo() const
+    { return _dependencyInfo; }
+    std::vector<std::string> const &command() const
+    { return _command; }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+Options::
+Options()
+{
+}
+
+Options::
+~Options()
+{
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (arg == "-h" || arg == "--help") {
+        return libutil::Options::Current<bool>(&_help, arg, it);
+    } else if (arg == "-v" || arg == "--version") {
+        return libutil::Options::Current<bool>(&_version, arg, it);
+    } else if (arg == "-c" || arg == "--cache") {
+        return libutil::Options::Next<std::string>(&_cache, args, it);
+    } else if (arg == "-r" || arg == "--remote") {
+        return libutil::Options::Next<std::string>(&_remote, args, it);
+    } else if (arg == "-i" || arg == "--input") {
+        return libutil::Options::AppendNext<std::string>(&_inputs, args, it);
+    } else if (arg == "-o" || arg == "--output") {
+        return libutil::Options::AppendNext<std::string>(&_outputs, args, it);
+    } else if (arg == "--") {
+        /* Everything after is the command to run. */
+        _command = std::vector<std::string>(*it + 1, args.end());
+        *it = args.end() - 1;
+        return std::make_pair(true, std::string());
+    } else if (!arg.empty() && arg[0] != '-') {
+        std::string::size_type offset = arg.find(':');
+        if (offset != std::string::npos && offset != 0 && offset != arg.size() - 1) {
+            std::string name = arg.substr(0, offset);
+            std::string path = arg.substr(offset + 1);
+
+            dependency::DependencyInfoFormat format;
+            if (!dependency::DependencyInfoFormats::Parse(name, &format) || format == dependency::DependencyInfoFormat::Directory) {
+                return std::make_pair(false, "unsupported format " + name);
+            }
+
+            _dependencyInfo.push_back({ format, path });
+            return std::make_pair(true, std::string());
+        } else {
+            return std::make_pair(false, "unknown dependency info " + arg + " (use format:/path/to/dependency/info)");
+        }
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
+
+static int
+Help(std::string const &error = std::string())
+{
+    if (!error.empty()) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "Usage: action-cache-tool [options] [dependency info] -- command [arguments]\n\n");
+    fprintf(stderr, "Runs a command, or restores its outputs from a cache of earlier runs.\n\n");
+
+#define INDENT "  "
+    fprintf(stderr, "Information:\n");
+    fprintf(stderr, INDENT "-h, --help\n");
+    fprintf(stderr, INDENT "-v, --version\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Cache Options:\n");
+    fprintf(stderr, INDENT "-c, --cache <directory>\n");
+    fprintf(stderr, INDENT "-r, --remote <helper>\n");
+    fprintf(stderr, INDENT "-i, --input <path>\n");
+    fprintf(stderr, INDENT "-o, --output <path>\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Dependency Info:\n");
+    fprintf(stderr, INDENT "<format>:<path>\n");
+    fprintf(stderr, INDENT "format: makefile, binary\n");
+    fprintf(stderr, "\n");
+#undef INDENT
+
+    return (error.empty() ? 0 : -1);
+}
+
+static int
+Version()
+{
+    printf("action-cache-tool version 1\n");
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    process::DefaultContext processContext = process::DefaultContext();
+
+    /*
+     * Parse out the options, or print help & exit.
+     */
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext.commandLineArguments());
+    if (!result.first) {
+        return Help(result.second);
+    }
+
+    /*
+     * Handle the basic options.
+     */
+    if (options.help()) {
+        return Help();
+    } else if (options.version()) {
+        return Version();
+    }
+
+    /*
+     * Diagnose missing options.
+     */
+    if (!options.cache() || options.outputs().empty() || options.command().empty()) {
+        return Help("missing option(s)");
+    }
+
+    std::string const &currentDirectory = processContext.currentDirectory();
+    ext::optional<std::string> executable;
+    if (FSUtil::IsAbsolutePath(options.command().front())) {
+        executable = options.command().front();
+    } else {
+        executable = filesystem.findExecutable(options.command().front(), processContext.executableSearchPaths());
+    }
+    if (!executable) {
+        fprintf(stderr, "error: unable to find executable %s\n", options.command().front().c_str());
+        return -1;
+    }
+
+    std::vector<std::string> arguments = std::vector<std::string>(options.command().begin() + 1, options.command().end());
+
+    std::vector<std::string> inputs;
+    for (std::string const &input : options.inputs()) {
+        inputs.push_back(FSUtil::ResolveRelativePath(input, currentDirectory));
+    }
+
+    /* The dependency info is restored along with the outputs, for the build to read. */
+    std::vector<std::string> outputs;
+    for (std::string const &output : options.outputs()) {
+        outputs.push_back(FSUtil::ResolveRelativePath(output, currentDirectory));
+    }
+    for (std::pair<dependency::DependencyInfoFormat, std::string> const &dependencyInfo : options.dependencyInfo()) {
+        outputs.push_back(FSUtil::ResolveRelativePath(dependencyInfo.second, currentDirectory));
+    }
+
+    /*
+     * Find the outputs in the cache. The environment is exactly the command's,
+     * as this tool is run in its place; the remote helper also runs with it.
+     */
+    process::DefaultLauncher launcher;
+    std::unique_ptr<xcexecution::CommandRemoteCache> remote;
+    if (options.remote()) {
+        remote = std::unique_ptr<xcexecution::CommandRemoteCache>(new xcexecution::CommandRemoteCache(&launcher, &processContext, *options.remote()));
+    }
+
+    ActionCache cache = ActionCache(FSUtil::ResolveRelativePath(*options.cache(), currentDirectory), remote.get());
+    ext::optional<std::string> key;
+    if (ext::optional<std::string> command = cache.command(&filesystem, *executable, arguments, processContext.environmentVariables(), currentDirectory)) {
+        key = ActionCache::Key(&filesystem, *command, inputs, outputs);
+    }
+
+    if (key && cache.restore(&filesystem, *key, outputs)) {
+        return 0;
+    }
+
+    /*
+     * Run the command.
+     */
+    process::MemoryContext context = process::MemoryContext(
+        *executable,
+        currentDirectory,
+        arguments,
+        processContext.environmentVariables(),
+        processContext.userID(),
+        processContext.groupID(),
+        processContext.userName(),
+        processContext.groupName());
+    ext::optional<int> exitCode = launcher.launch(&filesystem, &context);
+    if (!exitCode) {
+        fprintf(stderr, "error: unable to run %s\n", executable->c_str());
+        return -1;
+    } else if (*exitCode != 0 || !key) {
+        return *exitCode;
+    }
+
+    /*
+     * Store the outputs, along with the inputs the command discovered.
+     */
+    dependency::DependencyInfoMerger merger = dependency::DependencyInfoMerger(currentDirectory);
+    for (std::string const &input : inputs) {
+        merger.add(input);
+    }
+
+    bool stored = true;
+    for (std::pair<dependency::DependencyInfoFormat, std::string> const &dependencyInfo : options.dependencyInfo()) {
+        stored = stored && merger.add(&filesystem, dependencyInfo.first, FSUtil::ResolveRelativePath(dependencyInfo.second, currentDirectory));
+    }
+
+    if (stored) {
+        std::vector<std::string> discoveredInputs;
+        for (std::string const *input : merger.inputs()) {
+            discoveredInputs.push_back(*input);
+        }
+        stored = cache.store(&filesystem, *key, discoveredInputs, outputs);
+    }
+
+    if (!stored) {
+        fprintf(stderr, "warning: unable to store outputs in action cache %s\n", cache.path().c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,546 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/SimpleExecutor.h>
+#include <xcexecution/BuildLog.h>
+#include <xcformatter/NullFormatter.h>
+#include <builtin/Registry.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/XML.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+#include <process/SimulatedLauncher.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdio>
+#include <cstdlib>
+
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+using process::SimulatedLauncher;
+
+/*
+ * An invocation to simulate: how long it takes in microseconds, the most
+ * memory it uses in bytes, and the invocations it must wait for.
+ */
+struct SimulatedInvocation {
+    std::string         name;
+    std::string         tool;
+    int64_t             duration;
+    int64_t             memory;
+    std::vector<size_t> dependencies;
+};
+
+/*
+ * A memory filesystem where every file has the same stamp, so the build log
+ * can record the simulated invocations.
+ */
+class SimulatedFilesystem : public MemoryFilesystem {
+public:
+    explicit SimulatedFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
+        MemoryFilesystem(entries)
+    {
+    }
+
+public:
+    virtual ext::optional<Filesystem::Stamp> readFileStamp(std::string const &path) const
+    { return (type(path) == Filesystem::Type::File ? ext::optional<Filesystem::Stamp>(Filesystem::Stamp({ 0, 1 })) : ext::nullopt); }
+};
+
+/*
+ * A build graph shaped like a workspace: targets of compiles followed by a
+ * link, where a target's compiles wait for the links of the targets it
+ * depends on. Only the raw output of the generator is used, as it is the
+ * same everywhere, so a seed always creates the same graph.
+ */
+static std::vector<SimulatedInvocation>
+SyntheticInvocations(size_t count, uint32_t seed)
+{
+    std::mt19937 random = std::mt19937(seed);
+    auto uniform = [&](int64_t low, int64_t high) -> int64_t {
+        return low + static_cast<int64_t>(random() % static_cast<uint64_t>(high - low + 1));
+    };
+
+    std::vector<SimulatedInvocation> invocations;
+    std::vector<size_t> links;
+
+    while (invocations.size() < count) {
+        size_t target = links.size();
+
+        std::vector<size_t> targetDependencies;
+        for (int64_t n = uniform(0, 2); n > 0 && !links.empty(); --n) {
+            size_t link = links[static_cast<size_t>(uniform(0, static_cast<int64_t>(links.size()) - 1))];
+            if (std::find(targetDependencies.begin(), targetDependencies.end(), link) == targetDependencies.end()) {
+                targetDependencies.push_back(link);
+            }
+        }
+
+        /* Leave room for the link. */
+        size_t compiles = std::min(static_cast<size_t>(uniform(5, 40)), count - invocations.size() - 1);
+
+        std::vector<size_t> objects;
+        for (size_t n = 0; n < compiles; ++n) {
+            /* Some sources take much longer to compile than the rest. */
+            bool slow = (uniform(0, 19) == 0);
+
+            SimulatedInvocation compile;
+            compile.name = "target" + std::to_string(target) + "/compile" + std::to_string(n);
+            compile.tool = "compile";
+            compile.duration = (slow ? uniform(5000000, 15000000) : uniform(200000, 3000000));
+            compile.memory = uniform(100, 500) * 1024 * 1024;
+            compile.dependencies = targetDependencies;
+            objects.push_back(invocations.size());
+            invocations.push_back(compile);
+        }
+
+        SimulatedInvocation link;
+        link.name = "target" + std::to_string(target) + "/link";
+        link.tool = "link";
+        link.duration = uniform(500000, 2000000);
+        link.memory = uniform(300, 1500) * 1024 * 1024;
+        link.dependencies = (objects.empty() ? targetDependencies : objects);
+        links.push_back(invocations.size());
+        invocations.push_back(link);
+    }
+
+    return invocations;
+}
+
+/*
+ * Reads a trace: an array of dictionaries with a Name, a Tool, a Duration in
+ * microseconds, a Memory in bytes, and the names of its Dependencies.
+ */
+static ext::optional<std::vector<SimulatedInvocation>>
+ReadTrace(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        fprintf(stderr, "error: unable to read %s\n", path.c_str());
+        return ext::nullopt;
+    }
+
+    auto deserialize = plist::Format::Any::Deserialize(contents);
+    auto array = plist::CastTo<plist::Array>(deserialize.first.get());
+    if (array == nullptr) {
+        fprintf(stderr, "error: %s is not an array of invocations\n", path.c_str());
+        return ext::nullopt;
+    }
+
+    std::vector<SimulatedInvocation> invocations;
+    std::unordered_map<std::string, size_t> indexes;
+    std::vector<std::vector<std::string>> dependencyNames;
+
+    for (size_t n = 0; n < array->count(); ++n) {
+        auto dict = array->value<plist::Dictionary>(n);
+        auto name = (dict != nullptr ? dict->value<plist::String>("Name") : nullptr);
+        if (name == nullptr || !indexes.insert({ name->value(), invocations.size() }).second) {
+            fprintf(stderr, "error: invocation %zu has no name or a duplicate name\n", n);
+            return ext::nullopt;
+        }
+
+        SimulatedInvocation invocation;
+        invocation.name = name->value();
+        if (auto tool = dict->value<plist::String>("Tool")) {
+            invocation.tool = tool->value();
+        }
+        auto duration = dict->value<plist::Integer>("Duration");
+        invocation.duration = (duration != nullptr ? duration->value() : 0);
+        auto memory = dict->value<plist::Integer>("Memory");
+        invocation.memory = (memory != nullptr ? memory->value() : 0);
+
+        std::vector<std::string> names;
+        if (auto dependencies = dict->value<plist::Array>("Dependencies")) {
+            for (size_t i = 0; i < dependencies->count(); ++i) {
+                if (auto dependency = dependencies->value<plist::String>(i)) {
+                    names.push_back(dependency->value());
+                }
+            }
+        }
+
+        invocations.push_back(invocation);
+        dependencyNames.push_back(names);
+    }
+
+    for (size_t n = 0; n < invocations.size(); ++n) {
+        for (std::string const &name : dependencyNames[n]) {
+            auto it = indexes.find(name);
+            if (it == indexes.end()) {
+                fprintf(stderr, "error: %s depends on unknown invocation %s\n", invocations[n].name.c_str(), name.c_str());
+                return ext::nullopt;
+            }
+            invocations[n].dependencies.push_back(it->second);
+        }
+    }
+
+    return invocations;
+}
+
+/*
+ * Reads the invocations recorded in a build log. An invocation depends on
+ * those that produced its inputs. The log keeps the memory used by each
+ * tool, but not which tool each invocation ran, so memory is not simulated.
+ */
+static ext::optional<std::vector<SimulatedInvocation>>
+ReadBuildLog(Filesystem const *filesystem, std::string const &path)
+{
+    xcexecution::BuildLog buildLog;
+    if (!buildLog.load(filesystem, path)) {
+        fprintf(stderr, "error: unable to load build log %s\n", path.c_str());
+        return ext::nullopt;
+    }
+
+    std::vector<std::pair<std::vector<std::string>, std::vector<std::string>>> paths;
+    std::vector<SimulatedInvocation> invocations;
+    buildLog.iterate([&](std::vector<std::string> const &outputs, std::vector<std::string> const &inputs, ext::optional<int64_t> duration) {
+        if (outputs.empty()) {
+            return;
+        }
+
+        SimulatedInvocation invocation;
+        invocation.name = outputs.front();
+        invocation.duration = duration.value_or(0);
+        invocation.memory = 0;
+        invocations.push_back(invocation);
+        paths.push_back({ outputs, inputs });
+    });
+
+    /* The log is unordered; sort so the same log always simulates the same way. */
+    std::vector<size_t> order;
+    for (size_t n = 0; n < invocations.size(); ++n) {
+        order.push_back(n);
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return invocations[a].name < invocations[b].name;
+    });
+
+    std::vector<SimulatedInvocation> sorted;
+    std::unordered_map<std::string, size_t> producers;
+    for (size_t n : order) {
+        for (std::string const &output : paths[n].first) {
+            producers[output] = sorted.size();
+        }
+        sorted.push_back(invocations[n]);
+    }
+
+    for (size_t n = 0; n < order.size(); ++n) {
+        for (std::string const &input : paths[order[n]].second) {
+            auto it = producers.find(input);
+            if (it != producers.end() && it->second != n &&
+                std::find(sorted[n].dependencies.begin(), sorted[n].dependencies.end(), it->second) == sorted[n].dependencies.end()) {
+                sorted[n].dependencies.push_back(it->second);
+            }
+        }
+    }
+
+    return sorted;
+}
+
+static bool
+WriteTrace(Filesystem *filesystem, std::string const &path, std::vector<SimulatedInvocation> const &invocations)
+{
+    auto array = plist::Array::New();
+    for (SimulatedInvocation const &invocation : invocations) {
+        auto dependencies = plist::Array::New();
+        for (size_t dependency : invocation.dependencies) {
+            dependencies->append(plist::String::New(invocations[dependency].name));
+        }
+
+        auto dict = plist::Dictionary::New();
+        dict->set("Name", plist::String::New(invocation.name));
+        dict->set("Tool", plist::String::New(invocation.tool));
+        dict->set("Duration", plist::Integer::New(invocation.duration));
+        dict->set("Memory", plist::Integer::New(invocation.memory));
+        dict->set("Dependencies", std::move(dependencies));
+        array->append(std::move(dict));
+    }
+
+    plist::Format::XML xml = plist::Format::XML::Create(plist::Format::Encoding::UTF8);
+    auto serialize = plist::Format::XML::Serialize(array.get(), xml);
+    if (serialize.first == nullptr) {
+        fprintf(stderr, "error: %s\n", serialize.second.c_str());
+        return false;
+    }
+
+    if (!filesystem->write(*serialize.first, path)) {
+        fprintf(stderr, "error: unable to write %s\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * The longest time through the graph, which no number of jobs can beat.
+ * Fails if the graph has a cycle.
+ */
+static ext::optional<int64_t>
+CriticalPath(std::vector<SimulatedInvocation> const &invocations)
+{
+    enum class State { Unvisited, Visiting, Visited };
+    std::vector<State> states = std::vector<State>(invocations.size(), State::Unvisited);
+    std::vector<int64_t> finishes = std::vector<int64_t>(invocations.size(), 0);
+
+    std::function<bool(size_t)> visit = [&](size_t n) -> bool {
+        if (states[n] == State::Visited) {
+            return true;
+        } else if (states[n] == State::Visiting) {
+            return false;
+        }
+
+        states[n] = State::Visiting;
+        int64_t start = 0;
+        for (size_t dependency : invocations[n].dependencies) {
+            if (!visit(dependency)) {
+                return false;
+            }
+            start = std::max(start, finishes[dependency]);
+        }
+        states[n] = State::Visited;
+
+        finishes[n] = start + invocations[n].duration;
+        return true;
+    };
+
+    int64_t critical = 0;
+    for (size_t n = 0; n < invocations.size(); ++n) {
+        if (!visit(n)) {
+            return ext::nullopt;
+        }
+        critical = std::max(critical, finishes[n]);
+    }
+
+    return critical;
+}
+
+static std::string
+OutputPath(size_t n)
+{
+    return "/out/" + std::to_string(n);
+}
+
+static double
+Seconds(int64_t microseconds)
+{
+    return static_cast<double>(microseconds) / 1000000.0;
+}
+
+static double
+Megabytes(int64_t bytes)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+static void
+Usage()
+{
+    fprintf(stderr, "Usage: benchmark_scheduler [options] (-synthetic count [-seed seed] | -trace trace.plist | -build-log path)\n\n");
+    fprintf(stderr, "Simulates building a graph of invocations with the simple executor, without running anything,\n");
+    fprintf(stderr, "and reports how long the build would take with each number of jobs.\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -jobs N[,N...]        numbers of jobs to simulate (default 1,2,4,8,16)\n");
+    fprintf(stderr, "  -memory-limit MB      memory the running invocations may use at once\n");
+    fprintf(stderr, "  -estimates            simulate with the durations and memory of an earlier build known\n");
+    fprintf(stderr, "  -settle us            wall time to wait for invocations to start (default 2000)\n");
+    fprintf(stderr, "  -write-trace path     write the simulated graph as a trace\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    std::vector<size_t> jobCounts = { 1, 2, 4, 8, 16 };
+    size_t memoryLimit = 0;
+    bool estimates = false;
+    std::chrono::microseconds settle = std::chrono::milliseconds(2);
+    ext::optional<size_t> synthetic;
+    uint32_t seed = 1;
+    ext::optional<std::string> tracePath;
+    ext::optional<std::string> buildLogPath;
+    ext::optional<std::string> writeTracePath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (argument == "-jobs" && hasValue) {
+            jobCounts.clear();
+            std::string value = argv[++i];
+            std::string::size_type start = 0;
+            do {
+                std::string::size_type end = value.find(',', start);
+                size_t count = std::strtoul(value.substr(start, end - start).c_str(), NULL, 10);
+                if (count > 0) {
+                    jobCounts.push_back(count);
+                }
+                start = (end == std::string::npos ? end : end + 1);
+            } while (start != std::string::npos);
+        } else if (argument == "-memory-limit" && hasValue) {
+            memoryLimit = std::strtoul(argv[++i], NULL, 10) * 1024 * 1024;
+        } else if (argument == "-estimates") {
+            estimates = true;
+        } else if (argument == "-settle" && hasValue) {
+            settle = std::chrono::microseconds(std::strtoul(argv[++i], NULL, 10));
+        } else if (argument == "-synthetic" && hasValue) {
+            synthetic = std::strtoul(argv[++i], NULL, 10);
+        } else if (argument == "-seed" && hasValue) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], NULL, 10));
+        } else if (argument == "-trace" && hasValue) {
+            tracePath = std::string(argv[++i]);
+        } else if (argument == "-build-log" && hasValue) {
+            buildLogPath = std::string(argv[++i]);
+        } else if (argument == "-write-trace" && hasValue) {
+            writeTracePath = std::string(argv[++i]);
+        } else {
+            Usage();
+            return -1;
+        }
+    }
+
+    if (static_cast<int>(static_cast<bool>(synthetic)) + static_cast<int>(static_cast<bool>(tracePath)) + static_cast<int>(static_cast<bool>(buildLogPath)) != 1 || jobCounts.empty()) {
+        Usage();
+        return -1;
+    }
+
+    DefaultFilesystem defaultFilesystem = DefaultFilesystem();
+
+    std::vector<SimulatedInvocation> invocations;
+    if (synthetic) {
+        invocations = SyntheticInvocations(*synthetic, seed);
+    } else {
+        auto read = (tracePath ? ReadTrace(&defaultFilesystem, *tracePath) : ReadBuildLog(&defaultFilesystem, *buildLogPath));
+        if (!read) {
+            return 1;
+        }
+        invocations = std::move(*read);
+    }
+
+    if (writeTracePath && !WriteTrace(&defaultFilesystem, *writeTracePath, invocations)) {
+        return 1;
+    }
+
+    ext::optional<int64_t> critical = CriticalPath(invocations);
+    if (!critical) {
+        fprintf(stderr, "error: the invocations depend on each other in a cycle\n");
+        return 1;
+    }
+
+    int64_t work = 0;
+    for (SimulatedInvocation const &invocation : invocations) {
+        work += invocation.duration;
+    }
+
+    printf("Invocations:    %zu\n", invocations.size());
+    printf("Total work:     %.1f s\n", Seconds(work));
+    printf("Critical path:  %.1f s\n\n", Seconds(*critical));
+    printf("%6s %12s %12s %11s %13s %13s %10s\n", "jobs", "simulated", "bound", "efficiency", "peak running", "peak memory", "wall");
+
+    /* Each invocation is an external tool named by its index, producing one output. */
+    std::vector<pbxbuild::Tool::Invocation> toolInvocations;
+    std::vector<MemoryFilesystem::Entry> outputs;
+    for (size_t n = 0; n < invocations.size(); ++n) {
+        auto invocation = pbxbuild::Tool::Invocation();
+        invocation.toolIdentifier() = invocations[n].tool;
+        invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+        invocation.arguments() = { std::to_string(n) };
+        invocation.workingDirectory() = "/";
+        for (size_t dependency : invocations[n].dependencies) {
+            invocation.inputs().push_back(OutputPath(dependency));
+        }
+        invocation.outputs() = { OutputPath(n) };
+        toolInvocations.push_back(invocation);
+
+        outputs.push_back(MemoryFilesystem::Entry::File(std::to_string(n), std::vector<uint8_t>()));
+    }
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto simulate = [&](process::Context const *context) -> ext::optional<SimulatedLauncher::Process> {
+        if (context->commandLineArguments().empty()) {
+            return ext::nullopt;
+        }
+
+        size_t n = std::strtoul(context->commandLineArguments().front().c_str(), NULL, 10);
+        if (n >= invocations.size()) {
+            return ext::nullopt;
+        }
+
+        return SimulatedLauncher::Process { invocations[n].duration, invocations[n].memory, 0 };
+    };
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+
+    for (size_t jobs : jobCounts) {
+        SimulatedFilesystem filesystem = SimulatedFilesystem({
+            MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+            MemoryFilesystem::Entry::Directory("out", outputs),
+        });
+
+        /* Estimates recorded under another command, so nothing is up to date. */
+        xcexecution::BuildLog buildLog;
+        if (estimates) {
+            for (size_t n = 0; n < invocations.size(); ++n) {
+                pbxbuild::Tool::Invocation earlier = toolInvocations[n];
+                earlier.arguments() = { "earlier" };
+                buildLog.record(&filesystem, earlier, invocations[n].duration);
+
+                if (invocations[n].memory > 0) {
+                    buildLog.recordMemory(invocations[n].tool, invocations[n].memory);
+                }
+            }
+        }
+
+        SimulatedLauncher launcher(simulate, jobs, settle);
+        xcexecution::SimpleExecutor::Options options;
+        options.jobs = jobs;
+        options.memoryLimit = memoryLimit;
+        xcexecution::SimpleExecutor executor = xcexecution::SimpleExecutor(formatter, false, builtin::Registry::Create({ }), options);
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = executor.performInvocations(&context, &launcher, &filesystem, &filesystem, executablePaths, toolInvocations, false, &buildLog, nullptr, nullptr);
+        auto end = std::chrono::steady_clock::now();
+        if (!result.first) {
+            fprintf(stderr, "error: simulated build with %zu jobs failed\n", jobs);
+            return 1;
+        }
+
+        int64_t bound = std::max(*critical, work / static_cast<int64_t>(jobs));
+        double efficiency = (launcher.time() > 0 ? 100.0 * static_cast<double>(bound) / static_cast<double>(launcher.time()) : 100.0);
+        double wall = std::chrono::duration<double>(end - start).count();
+        printf("%6zu %10.1f s %10.1f s %10.1f%% %13zu %10.0f MB %8.2f s\n",
+            jobs,
+            Seconds(launcher.time()),
+            Seconds(bound),
+            efficiency,
+            launcher.peakRunning(),
+            Megabytes(launcher.peakMemory()),
+            wall);
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/NinjaExecutor.h>
+#include <xcexecution/Parameters.h>
+#include <xcformatter/NullFormatter.h>
+#include <pbxbuild/Build/Environment.h>
+#include <pbxbuild/WorkspaceContext.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/DefaultContext.h>
+#include <process/DefaultLauncher.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <cstdio>
+#include <cstdlib>
+
+using libutil::DefaultFilesystem;
+using libutil::FSUtil;
+
+/*
+ * Runs a step repeatedly and prints the average time it took. Stops at the
+ * first failure.
+ */
+static bool
+Benchmark(std::string const &name, size_t iterations, std::function<bool()> const &function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        if (!function()) {
+            fprintf(stderr, "error: %s failed\n", name.c_str());
+            return false;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("%-32s %10.1f ms\n", name.c_str(), milliseconds / static_cast<double>(iterations));
+    return true;
+}
+
+int
+main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: benchmark_workspace workspace scheme [iterations]\n\n");
+        fprintf(stderr, "Measures loading a workspace, resolving its dependencies, and generating Ninja files for it.\n");
+        fprintf(stderr, "Workspaces to measure can be created with generate_workspace.\n");
+        return -1;
+    }
+
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    process::DefaultContext processContext = process::DefaultContext();
+    process::DefaultLauncher processLauncher = process::DefaultLauncher();
+
+    std::string workspace = FSUtil::ResolveRelativePath(argv[1], processContext.currentDirectory());
+    std::string scheme = argv[2];
+    size_t iterations = (argc > 3 ? std::strtoul(argv[3], NULL, 10) : 5);
+
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment;
+    if (!Benchmark("Build::Environment::Default", 1, [&] {
+        buildEnvironment = pbxbuild::Build::Environment::Default(&processContext, &filesystem);
+        return static_cast<bool>(buildEnvironment);
+    })) {
+        return 1;
+    }
+
+    /* Without a workspace cache, so each iteration loads from scratch. */
+    xcexecution::Parameters parameters = xcexecution::Parameters(
+        workspace,
+        ext::nullopt,
+        scheme,
+        ext::nullopt,
+        false,
+        { "build" },
+        ext::nullopt,
+        { });
+
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext;
+    if (!Benchmark("Load workspace", iterations, [&] {
+        workspaceContext = parameters.loadWorkspace(&filesystem, processContext.userName(), *buildEnvironment, processContext.currentDirectory());
+        return static_cast<bool>(workspaceContext);
+    })) {
+        return 1;
+    }
+
+    size_t targets = 0;
+    if (!Benchmark("Resolve dependencies", iterations, [&] {
+        ext::optional<pbxbuild::Build::Context> buildContext = parameters.createBuildContext(*workspaceContext);
+        if (!buildContext) {
+            return false;
+        }
+
+        auto graph = parameters.resolveDependencies(*buildEnvironment, *buildContext);
+        if (!graph) {
+            return false;
+        }
+
+        targets = graph->nodes().size();
+        return true;
+    })) {
+        return 1;
+    }
+
+    /* Generating includes loading the workspace and resolving dependencies again. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    auto executor = xcexecution::NinjaExecutor::Create(formatter, false, true, false);
+    if (!Benchmark("Generate Ninja", iterations, [&] {
+        return executor->build(&processContext, &processLauncher, &filesystem, *buildEnvironment, parameters);
+    })) {
+        return 1;
+    }
+
+    printf("\n%zu targets\n", targets);
+    return 0;
+}
@@ -0,0 +1,588 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Options.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/DefaultContext.h>
+
+#include <string>
+#include <vector>
+
+#include <cstdio>
+
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+class Options {
+private:
+    ext::optional<bool>        _help;
+
+private:
+    ext::optional<std::string> _output;
+    ext::optional<int>         _projects;
+    ext::optional<int>         _targets;
+    ext::optional<int>         _sources;
+    ext::optional<int>         _dependencies;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool help() const
+    { return _help.value_or(false); }
+
+public:
+    ext::optional<std::string> const &output() const
+    { return _output; }
+    int projects() const
+    { return _projects.value_or(10); }
+    int targets() const
+    { return _targets.value_or(10); }
+    int sources() const
+    { return _sources.value_or(20); }
+    int dependencies() const
+    { return _dependencies.value_or(2); }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+Options::
+Options()
+{
+}
+
+Options::
+~Options()
+{
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (arg == "-h" || arg == "--help") {
+        return libutil::Options::Current<bool>(&_help, arg, it);
+    } else if (arg == "-o" || arg == "--output") {
+        return libutil::Options::Next<std::string>(&_output, args, it);
+    } else if (arg == "-p" || arg == "--projects") {
+        return libutil::Options::Next<int>(&_projects, args, it);
+    } else if (arg == "-t" || arg == "--targets") {
+        return libutil::Options::Next<int>(&_targets, args, it);
+    } else if (arg == "-s" || arg == "--sources") {
+        return libutil::Options::Next<int>(&_sources, args, it);
+    } else if (arg == "-d" || arg == "--dependencies") {
+        return libutil::Options::Next<int>(&_dependencies, args, it);
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
+
+static int
+Help(std::string const &error = std::string())
+{
+    if (!error.empty()) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "Usage: generate_workspace [options] -o <directory>\n\n");
+    fprintf(stderr, "Generates a synthetic workspace, for measuring how builds scale.\n\n");
+
+#define INDENT "  "
+    fprintf(stderr, "Information:\n");
+    fprintf(stderr, INDENT "-h, --help\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Workspace Options:\n");
+    fprintf(stderr, INDENT "-o, --output <directory>\n");
+    fprintf(stderr, INDENT "-p, --projects <count> (default 10)\n");
+    fprintf(stderr, INDENT "-t, --targets <count> (targets per project, default 10)\n");
+    fprintf(stderr, INDENT "-s, --sources <count> (sources per target, default 20)\n");
+    fprintf(stderr, INDENT "-d, --dependencies <count> (other projects each target depends on, default 2)\n");
+    fprintf(stderr, "\n");
+#undef INDENT
+
+    return (error.empty() ? 0 : -1);
+}
+
+/*
+ * Writes the contents of a file, creating its directory.
+ */
+static bool
+Write(Filesystem *filesystem, std::string const &path, std::string const &contents)
+{
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true)) {
+        return false;
+    }
+
+    return filesystem->write(std::vector<uint8_t>(contents.begin(), contents.end()), path);
+}
+
+static std::string
+ProjectName(int project)
+{
+    return "Project" + std::to_string(project);
+}
+
+static std::string
+TargetName(int project, int target)
+{
+    return ProjectName(project) + "Target" + std::to_string(target);
+}
+
+/*
+ * Identifiers of objects in a project, derived from what they are for, so
+ * other projects can refer to targets without looking them up.
+ */
+static std::string
+Identifier(int kind, int project, int target, int index)
+{
+    char identifier[25];
+    snprintf(identifier, sizeof(identifier), "%04X%04X%08X%08X",
+        static_cast<unsigned int>(kind) & 0xFFFF,
+        static_cast<unsigned int>(project) & 0xFFFF,
+        static_cast<unsigned int>(target),
+        static_cast<unsigned int>(index));
+    return identifier;
+}
+
+enum Kind {
+    KindProject = 1,
+    KindMainGroup,
+    KindProductsGroup,
+    KindTargetGroup,
+    KindConfigurationList,
+    KindConfiguration,
+    KindConfigFile,
+    KindTarget,
+    KindProduct,
+    KindSourcesPhase,
+    KindFrameworksPhase,
+    KindSource,
+    KindSourceBuildFile,
+    KindHeader,
+    KindLibrary,
+    KindLibraryBuildFile,
+    KindDependency,
+    KindProxy,
+    KindProjectFile,
+};
+
+/*
+ * The targets a target depends on: the previous target in its project, and
+ * the same target in each of the previous projects.
+ */
+static std::vector<std::pair<int, int>>
+Dependencies(Options const &options, int project, int target)
+{
+    std::vector<std::pair<int, int>> dependencies;
+    if (target > 0) {
+        dependencies.push_back({ project, target - 1 });
+    }
+    for (int i = 1; i <= options.dependencies() && project - i >= 0; ++i) {
+        dependencies.push_back({ project - i, target });
+    }
+    return dependencies;
+}
+
+static std::string
+ConfigurationList(int project, int target, std::string const &settings)
+{
+    std::string contents;
+    std::vector<std::string> names = { "Debug", "Release" };
+
+    std::string list = Identifier(KindConfigurationList, project, target, 0);
+    contents += "\t\t" + list + " = {\n";
+    contents += "\t\t\tisa = XCConfigurationList;\n";
+    contents += "\t\t\tbuildConfigurations = (\n";
+    for (size_t i = 0; i < names.size(); ++i) {
+        contents += "\t\t\t\t" + Identifier(KindConfiguration, project, target, i) + ",\n";
+    }
+    contents += "\t\t\t);\n";
+    contents += "\t\t\tdefaultConfigurationIsVisible = 0;\n";
+    contents += "\t\t\tdefaultConfigurationName = Release;\n";
+    contents += "\t\t};\n";
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        contents += "\t\t" + Identifier(KindConfiguration, project, target, i) + " = {\n";
+        contents += "\t\t\tisa = XCBuildConfiguration;\n";
+        contents += "\t\t\tbaseConfigurationReference = " + Identifier(KindConfigFile, project, target, (target < 0 ? i : 0)) + ";\n";
+        contents += "\t\t\tbuildSettings = {\n" + settings + "\t\t\t};\n";
+        contents += "\t\t\tname = " + names[i] + ";\n";
+        contents += "\t\t};\n";
+    }
+
+    return contents;
+}
+
+static std::string
+ProjectFile(Options const &options, int project)
+{
+    std::string objects;
+    std::string mainGroupChildren;
+    std::string productsGroupChildren;
+    std::string targets;
+
+    /* The project's configurations are based on the workspace's. */
+    std::vector<std::string> configurations = { "Debug", "Release" };
+    for (size_t i = 0; i < configurations.size(); ++i) {
+        std::string file = Identifier(KindConfigFile, project, -1, i);
+        objects += "\t\t" + file + " = {isa = PBXFileReference; lastKnownFileType = text.xcconfig; path = ../Configurations/" + configurations[i] + ".xcconfig; sourceTree = SOURCE_ROOT; };\n";
+        mainGroupChildren += "\t\t\t\t" + file + ",\n";
+    }
+    objects += ConfigurationList(project, -1, "\t\t\t\tPROJECT_GROUP = " + ProjectName(project) + ";\n");
+
+    /* Other projects this project's targets depend on. */
+    for (int other = 0; other < project; ++other) {
+        std::string file = Identifier(KindProjectFile, project, other, 0);
+        objects += "\t\t" + file + " = {isa = PBXFileReference; lastKnownFileType = \"wrapper.pb-project\"; name = " + ProjectName(other) + ".xcodeproj; path = ../" + ProjectName(other) + "/" + ProjectName(other) + ".xcodeproj; sourceTree = SOURCE_ROOT; };\n";
+    }
+
+    for (int target = 0; target < options.targets(); ++target) {
+        std::string name = TargetName(project, target);
+        std::string targetGroupChildren;
+        std::string sourceFiles;
+        std::string libraryFiles;
+        std::string dependencies;
+
+        std::string config = Identifier(KindConfigFile, project, target, 0);
+        objects += "\t\t" + config + " = {isa = PBXFileReference; lastKnownFileType = text.xcconfig; path = " + name + ".xcconfig; sourceTree = \"<group>\"; };\n";
+        targetGroupChildren += "\t\t\t\t" + config + ",\n";
+
+        std::string header = Identifier(KindHeader, project, target, 0);
+        objects += "\t\t" + header + " = {isa = PBXFileReference; lastKnownFileType = sourcecode.c.h; path = " + name + ".h; sourceTree = \"<group>\"; };\n";
+        targetGroupChildren += "\t\t\t\t" + header + ",\n";
+
+        for (int source = 0; source < options.sources(); ++source) {
+            std::string file = Identifier(KindSource, project, target, source);
+            std::string buildFile = Identifier(KindSourceBuildFile, project, target, source);
+            objects += "\t\t" + file + " = {isa = PBXFileReference; lastKnownFileType = sourcecode.c.c; path = Source" + std::to_string(source) + ".c; sourceTree = \"<group>\"; };\n";
+            objects += "\t\t" + buildFile + " = {isa = PBXBuildFile; fileRef = " + file + "; };\n";
+            targetGroupChildren += "\t\t\t\t" + file + ",\n";
+            sourceFiles += "\t\t\t\t" + buildFile + ",\n";
+        }
+
+        /*
+         * Depend on targets in this project directly, and on targets in other
+         * projects through a proxy. Link with the products of both, which are
+         * found by name in the products directory.
+         */
+        int index = 0;
+        for (std::pair<int, int> const &dependency : Dependencies(options, project, target)) {
+            std::string dependencyName = TargetName(dependency.first, dependency.second);
+            std::string targetDependency = Identifier(KindDependency, project, target, index);
+            objects += "\t\t" + targetDependency + " = {\n";
+            objects += "\t\t\tisa = PBXTargetDependency;\n";
+            if (dependency.first == project) {
+                objects += "\t\t\ttarget = " + Identifier(KindTarget, dependency.first, dependency.second, 0) + ";\n";
+            } else {
+                std::string proxy = Identifier(KindProxy, project, target, index);
+                objects += "\t\t\tname = " + dependencyName + ";\n";
+                objects += "\t\t\ttargetProxy = " + proxy + ";\n";
+                objects += "\t\t};\n";
+                objects += "\t\t" + proxy + " = {\n";
+                objects += "\t\t\tisa = PBXContainerItemProxy;\n";
+                objects += "\t\t\tcontainerPortal = " + Identifier(KindProjectFile, project, dependency.first, 0) + ";\n";
+                objects += "\t\t\tproxyType = 1;\n";
+                objects += "\t\t\tremoteGlobalIDString = " + Identifier(KindTarget, dependency.first, dependency.second, 0) + ";\n";
+                objects += "\t\t\tremoteInfo = " + dependencyName + ";\n";
+            }
+            objects += "\t\t};\n";
+            dependencies += "\t\t\t\t" + targetDependency + ",\n";
+
+            std::string library = Identifier(KindLibrary, project, target, index);
+            std::string libraryBuildFile = Identifier(KindLibraryBuildFile, project, target, index);
+            objects += "\t\t" + library + " = {isa = PBXFileReference; explicitFileType = archive.ar; path = lib" + dependencyName + ".a; sourceTree = BUILT_PRODUCTS_DIR; };\n";
+            objects += "\t\t" + libraryBuildFile + " = {isa = PBXBuildFile; fileRef = " + library + "; };\n";
+            libraryFiles += "\t\t\t\t" + libraryBuildFile + ",\n";
+            index++;
+        }
+
+        std::string group = Identifier(KindTargetGroup, project, target, 0);
+        objects += "\t\t" + group + " = {\n";
+        objects += "\t\t\tisa = PBXGroup;\n";
+        objects += "\t\t\tchildren = (\n" + targetGroupChildren + "\t\t\t);\n";
+        objects += "\t\t\tpath = " + name + ";\n";
+        objects += "\t\t\tsourceTree = \"<group>\";\n";
+        objects += "\t\t};\n";
+        mainGroupChildren += "\t\t\t\t" + group + ",\n";
+
+        std::string product = Identifier(KindProduct, project, target, 0);
+        objects += "\t\t" + product + " = {isa = PBXFileReference; explicitFileType = archive.ar; includeInIndex = 0; path = lib" + name + ".a; sourceTree = BUILT_PRODUCTS_DIR; };\n";
+        productsGroupChildren += "\t\t\t\t" + product + ",\n";
+
+        std::string sourcesPhase = Identifier(KindSourcesPhase, project, target, 0);
+        objects += "\t\t" + sourcesPhase + " = {\n";
+        objects += "\t\t\tisa = PBXSourcesBuildPhase;\n";
+        objects += "\t\t\tbuildActionMask = 2147483647;\n";
+        objects += "\t\t\tfiles = (\n" + sourceFiles + "\t\t\t);\n";
+        objects += "\t\t\trunOnlyForDeploymentPostprocessing = 0;\n";
+        objects += "\t\t};\n";
+
+        std::string frameworksPhase = Identifier(KindFrameworksPhase, project, target, 0);
+        objects += "\t\t" + frameworksPhase + " = {\n";
+        objects += "\t\t\tisa = PBXFrameworksBuildPhase;\n";
+        objects += "\t\t\tbuildActionMask = 2147483647;\n";
+        objects += "\t\t\tfiles = (\n" + libraryFiles + "\t\t\t);\n";
+        objects += "\t\t\trunOnlyForDeploymentPostprocessing = 0;\n";
+        objects += "\t\t};\n";
+
+        objects += ConfigurationList(project, target, "\t\t\t\tPRODUCT_NAME = \"$(TARGET_NAME)\";\n");
+
+        std::string nativeTarget = Identifier(KindTarget, project, target, 0);
+        objects += "\t\t" + nativeTarget + " = {\n";
+        objects += "\t\t\tisa = PBXNativeTarget;\n";
+        objects += "\t\t\tbuildConfigurationList = " + Identifier(KindConfigurationList, project, target, 0) + ";\n";
+        objects += "\t\t\tbuildPhases = (\n\t\t\t\t" + sourcesPhase + ",\n\t\t\t\t" + frameworksPhase + ",\n\t\t\t);\n";
+        objects += "\t\t\tbuildRules = (\n\t\t\t);\n";
+        objects += "\t\t\tdependencies = (\n" + dependencies + "\t\t\t);\n";
+        objects += "\t\t\tname = " + name + ";\n";
+        objects += "\t\t\tproductName = " + name + ";\n";
+        objects += "\t\t\tproductReference = " + product + ";\n";
+        objects += "\t\t\tproductType = \"com.apple.product-type.library.static\";\n";
+        objects += "\t\t};\n";
+        targets += "\t\t\t\t" + nativeTarget + ",\n";
+    }
+
+    std::string productsGroup = Identifier(KindProductsGroup, project, 0, 0);
+    objects += "\t\t" + productsGroup + " = {\n";
+    objects += "\t\t\tisa = PBXGroup;\n";
+    objects += "\t\t\tchildren = (\n" + productsGroupChildren + "\t\t\t);\n";
+    objects += "\t\t\tname = Products;\n";
+    objects += "\t\t\tsourceTree = \"<group>\";\n";
+    objects += "\t\t};\n";
+    mainGroupChildren += "\t\t\t\t" + productsGroup + ",\n";
+
+    std::string mainGroup = Identifier(KindMainGroup, project, 0, 0);
+    objects += "\t\t" + mainGroup + " = {\n";
+    objects += "\t\t\tisa = PBXGroup;\n";
+    objects += "\t\t\tchildren = (\n" + mainGroupChildren + "\t\t\t);\n";
+    objects += "\t\t\tsourceTree = \"<group>\";\n";
+    objects += "\t\t};\n";
+
+    std::string rootObject = Identifier(KindProject, project, 0, 0);
+    objects += "\t\t" + rootObject + " = {\n";
+    objects += "\t\t\tisa = PBXProject;\n";
+    objects += "\t\t\tattributes = {\n\t\t\t\tLastUpgradeCheck = 0800;\n\t\t\t};\n";
+    objects += "\t\t\tbuildConfigurationList = " + Identifier(KindConfigurationList, project, -1, 0) + ";\n";
+    objects += "\t\t\tcompatibilityVersion = \"Xcode 3.2\";\n";
+    objects += "\t\t\tdevelopmentRegion = English;\n";
+    objects += "\t\t\thasScannedForEncodings = 0;\n";
+    objects += "\t\t\tknownRegions = (\n\t\t\t\ten,\n\t\t\t);\n";
+    objects += "\t\t\tmainGroup = " + mainGroup + ";\n";
+    objects += "\t\t\tproductRefGroup = " + productsGroup + ";\n";
+    objects += "\t\t\tprojectDirPath = \"\";\n";
+    objects += "\t\t\tprojectRoot = \"\";\n";
+    objects += "\t\t\ttargets = (\n" + targets + "\t\t\t);\n";
+    objects += "\t\t};\n";
+
+    std::string contents;
+    contents += "// !$*UTF8*$!\n";
+    contents += "{\n";
+    contents += "\tarchiveVersion = 1;\n";
+    contents += "\tclasses = {\n\t};\n";
+    contents += "\tobjectVersion = 46;\n";
+    contents += "\tobjects = {\n" + objects + "\t};\n";
+    contents += "\trootObject = " + rootObject + ";\n";
+    contents += "}\n";
+    return contents;
+}
+
+static std::string
+Scheme(Options const &options)
+{
+    std::string entries;
+    for (int project = 0; project < options.projects(); ++project) {
+        for (int target = 0; target < options.targets(); ++target) {
+            std::string name = TargetName(project, target);
+            entries += "         <BuildActionEntry\n";
+            entries += "            buildForTesting = \"YES\"\n";
+            entries += "            buildForRunning = \"YES\"\n";
+            entries += "            buildForProfiling = \"YES\"\n";
+            entries += "            buildForArchiving = \"YES\"\n";
+            entries += "            buildForAnalyzing = \"YES\">\n";
+            entries += "            <BuildableReference\n";
+            entries += "               BuildableIdentifier = \"primary\"\n";
+            entries += "               BlueprintIdentifier = \"" + Identifier(KindTarget, project, target, 0) + "\"\n";
+            entries += "               BuildableName = \"lib" + name + ".a\"\n";
+            entries += "               BlueprintName = \"" + name + "\"\n";
+            entries += "               ReferencedContainer = \"container:" + ProjectName(project) + "/" + ProjectName(project) + ".xcodeproj\">\n";
+            entries += "            </BuildableReference>\n";
+            entries += "         </BuildActionEntry>\n";
+        }
+    }
+
+    std::string contents;
+    contents += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    contents += "<Scheme\n";
+    contents += "   LastUpgradeVersion = \"0800\"\n";
+    contents += "   version = \"1.3\">\n";
+    contents += "   <BuildAction\n";
+    contents += "      parallelizeBuildables = \"YES\"\n";
+    contents += "      buildImplicitDependencies = \"YES\">\n";
+    contents += "      <BuildActionEntries>\n" + entries + "      </BuildActionEntries>\n";
+    contents += "   </BuildAction>\n";
+    contents += "</Scheme>\n";
+    return contents;
+}
+
+static std::string
+WorkspaceContents(Options const &options)
+{
+    std::string contents;
+    contents += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    contents += "<Workspace\n";
+    contents += "   version = \"1.0\">\n";
+    for (int project = 0; project < options.projects(); ++project) {
+        contents += "   <FileRef\n";
+        contents += "      location = \"group:" + ProjectName(project) + "/" + ProjectName(project) + ".xcodeproj\">\n";
+        contents += "   </FileRef>\n";
+    }
+    contents += "</Workspace>\n";
+    return contents;
+}
+
+/*
+ * Build settings come from a hierarchy of configuration files, like large
+ * workspaces share settings: workspace, then configuration, project and
+ * target, each including the one before.
+ */
+static bool
+WriteConfigurations(Filesystem *filesystem, Options const &options, std::string const &root)
+{
+    bool success = true;
+
+    success &= Write(filesystem, root + "/Configurations/Base.xcconfig",
+        "SDKROOT = macosx\n"
+        "ALWAYS_SEARCH_USER_PATHS = NO\n"
+        "CLANG_ENABLE_MODULES = YES\n"
+        "GCC_C_LANGUAGE_STANDARD = gnu99\n"
+        "GCC_WARN_UNUSED_VARIABLE = YES\n"
+        "GCC_WARN_UNUSED_FUNCTION = YES\n"
+        "GCC_WARN_64_TO_32_BIT_CONVERSION = YES\n"
+        "WARNING_CFLAGS = -Wall -Wextra\n"
+        "HEADER_SEARCH_PATHS = $(inherited) $(SRCROOT)/../Include\n"
+        "OTHER_CFLAGS = $(inherited) -DWORKSPACE=1\n"
+        "OTHER_CFLAGS[arch=x86_64] = $(inherited) -DX86_64=1\n");
+    success &= Write(filesystem, root + "/Configurations/Debug.xcconfig",
+        "#include \"Base.xcconfig\"\n"
+        "GCC_OPTIMIZATION_LEVEL = 0\n"
+        "GCC_PREPROCESSOR_DEFINITIONS = DEBUG=1 $(inherited)\n"
+        "ONLY_ACTIVE_ARCH = YES\n");
+    success &= Write(filesystem, root + "/Configurations/Release.xcconfig",
+        "#include \"Base.xcconfig\"\n"
+        "GCC_OPTIMIZATION_LEVEL = s\n"
+        "GCC_PREPROCESSOR_DEFINITIONS = NDEBUG=1 $(inherited)\n");
+
+    for (int project = 0; project < options.projects(); ++project) {
+        std::string directory = root + "/" + ProjectName(project);
+        success &= Write(filesystem, directory + "/Project.xcconfig",
+            "#include \"../Configurations/Base.xcconfig\"\n"
+            "HEADER_SEARCH_PATHS = $(inherited) $(SRCROOT)\n"
+            "OTHER_CFLAGS = $(inherited) -DPROJECT=$(PROJECT_NAME)\n");
+
+        for (int target = 0; target < options.targets(); ++target) {
+            std::string name = TargetName(project, target);
+            success &= Write(filesystem, directory + "/" + name + "/" + name + ".xcconfig",
+                "#include \"../Project.xcconfig\"\n"
+                "OTHER_CFLAGS = $(inherited) -DTARGET=$(TARGET_NAME:c99extidentifier)\n"
+                "GCC_PREFIX_HEADER = $(SRCROOT)/$(TARGET_NAME)/$(TARGET_NAME).h\n");
+        }
+    }
+
+    return success;
+}
+
+static bool
+WriteSources(Filesystem *filesystem, Options const &options, std::string const &root)
+{
+    bool success = true;
+
+    for (int project = 0; project < options.projects(); ++project) {
+        for (int target = 0; target < options.targets(); ++target) {
+            std::string name = TargetName(project, target);
+            std::string directory = root + "/" + ProjectName(project) + "/" + name;
+
+            std::string header;
+            for (int source = 0; source < options.sources(); ++source) {
+                std::string function = name + "Source" + std::to_string(source);
+                header += "int " + function + "(void);\n";
+                success &= Write(filesystem, directory + "/Source" + std::to_string(source) + ".c",
+                    "#include \"" + name + ".h\"\n"
+                    "\n"
+                    "int " + function + "(void) { return " + std::to_string(source) + "; }\n");
+            }
+            success &= Write(filesystem, directory + "/" + name + ".h", header);
+        }
+    }
+
+    return success;
+}
+
+int
+main(int argc, char **argv)
+{
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    process::DefaultContext processContext = process::DefaultContext();
+
+    /*
+     * Parse out the options, or print help & exit.
+     */
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext.commandLineArguments());
+    if (!result.first) {
+        return Help(result.second);
+    }
+
+    if (options.help()) {
+        return Help();
+    }
+
+    if (!options.output()) {
+        return Help("missing option(s)");
+    }
+
+    if (options.projects() < 1 || options.targets() < 1 || options.sources() < 0 || options.dependencies() < 0) {
+        return Help("invalid count");
+    }
+
+    std::string root = FSUtil::ResolveRelativePath(*options.output(), processContext.currentDirectory());
+
+    bool success = true;
+    success &= WriteConfigurations(&filesystem, options, root);
+    success &= WriteSources(&filesystem, options, root);
+
+    for (int project = 0; project < options.projects(); ++project) {
+        std::string path = root + "/" + ProjectName(project) + "/" + ProjectName(project) + ".xcodeproj/project.pbxproj";
+        success &= Write(&filesystem, path, ProjectFile(options, project));
+    }
+
+    success &= Write(&filesystem, root + "/Workspace.xcworkspace/contents.xcworkspacedata", WorkspaceContents(options));
+    success &= Write(&filesystem, root + "/Workspace.xcworkspace/xcshareddata/xcschemes/All.xcscheme", Scheme(options));
+
+    if (!success) {
+        fprintf(stderr, "error: unable to write workspace to %s\n", root.c_str());
+        return 1;
+    }
+
+    printf("%s/Workspace.xcworkspace: %d projects, %d targets, %d sources\n",
+        root.c_str(),
+        options.projects(),
+        options.projects() * options.targets(),
+        options.projects() * options.targets() * options.sources());
+    return 0;
+}
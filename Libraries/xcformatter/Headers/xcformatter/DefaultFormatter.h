@@ -51,7 +51,7 @@ public:
 
 public:
     virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
-    virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
+    virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple, ext::optional<int> exitCode, ext::optional<process::ResourceUsage> const &usage);
 
 public:
     /*
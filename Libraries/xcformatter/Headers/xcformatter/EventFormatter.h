@@ -0,0 +1,90 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcformatter_EventFormatter_h
+#define __xcformatter_EventFormatter_h
+
+#include <xcformatter/Formatter.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+
+namespace xcformatter {
+
+/*
+ * Formatter that writes a machine-readable stream of build events, one JSON
+ * object per line, while passing output through to another formatter.
+ *
+ * Every event has a "type" and a "time" in microseconds since the build
+ * began, from a monotonic clock, and the "thread" that reported it. Events
+ * come in "begin" and "finish" pairs for the build, targets, checking
+ * dependencies, writing auxiliary files, creating the product structure,
+ * and invocations. Finished invocations include their "exit_code", and the
+ * peak resident set size in kilobytes as "max_rss_kb": of the tool itself,
+ * or of the build process for builtin tools. Tools also report their CPU
+ * time in microseconds as "user_time_us" and "system_time_us", and their
+ * "block_inputs" and "block_outputs".
+ *
+ * Not thread safe; callers serialize formatter calls.
+ */
+class EventFormatter : public Formatter {
+private:
+    std::shared_ptr<Formatter>                   _formatter;
+    std::FILE                                   *_stream;
+    std::chrono::steady_clock::time_point        _start;
+    std::unordered_map<std::thread::id, size_t>  _threads;
+
+public:
+    EventFormatter(std::shared_ptr<Formatter> const &formatter, std::FILE *stream);
+    virtual ~EventFormatter();
+
+public:
+    virtual std::string begin(pbxbuild::Build::Context const &buildContext);
+    virtual std::string success(pbxbuild::Build::Context const &buildContext);
+    virtual std::string failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool::Invocation> const &failingInvocations);
+
+public:
+    virtual std::string beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string finishTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string finishCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string createAuxiliaryDirectory(std::string const &directory);
+    virtual std::string writeAuxiliaryFile(std::string const &file);
+    virtual std::string setAuxiliaryExecutable(std::string const &file);
+    virtual std::string finishWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string finishCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
+    virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple, ext::optional<int> exitCode, ext::optional<process::ResourceUsage> const &usage);
+
+private:
+    void write(std::string const &type, std::string const &fields, bool flush);
+
+public:
+    /*
+     * Create an event formatter writing to a file, closed when the formatter
+     * is destroyed. Nothing if the file can't be opened.
+     */
+    static std::shared_ptr<EventFormatter> Create(std::shared_ptr<Formatter> const &formatter, std::string const &path);
+};
+
+}
+
+#endif // !__xcformatter_EventFormatter_h
@@ -11,6 +11,9 @@
 #define __xcformatter_Formatter_h
 
 #include <pbxproj/PBX/Target.h>
+#include <process/ResourceUsage.h>
+
+#include <ext/optional>
 
 namespace pbxbuild {
 namespace Build { class Context; }
@@ -55,7 +58,11 @@ public:
 
 public:
     virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple) = 0;
-    virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple) = 0;
+    /*
+     * The exit code is nothing if the invocation could not be run. The
+     * usage is nothing if it wasn't measured, such as for builtin tools.
+     */
+    virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple, ext::optional<int> exitCode, ext::optional<process::ResourceUsage> const &usage) = 0;
 
 public:
     /*
@@ -254,7 +254,7 @@ beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const
 }
 
 std::string DefaultFormatter::
-finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple)
+finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple, ext::optional<int> exitCode, ext::optional<process::ResourceUsage> const &usage)
 {
     if (simple) {
         return std::string();
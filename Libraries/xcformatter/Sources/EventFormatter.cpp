@@ -0,0 +1,230 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcformatter/EventFormatter.h>
+#include <pbxbuild/Tool/Invocation.h>
+#include <pbxbuild/Build/Context.h>
+#include <libutil/Escape.h>
+
+#include <cinttypes>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using xcformatter::EventFormatter;
+using xcformatter::Formatter;
+using libutil::Escape;
+
+EventFormatter::
+EventFormatter(std::shared_ptr<Formatter> const &formatter, std::FILE *stream) :
+    Formatter (),
+    _formatter(formatter),
+    _stream   (stream),
+    _start    (std::chrono::steady_clock::now())
+{
+}
+
+EventFormatter::
+~EventFormatter()
+{
+    std::fclose(_stream);
+}
+
+static std::string
+Field(std::string const &name, std::string const &value)
+{
+    return ",\"" + name + "\":" + value;
+}
+
+static std::string
+TargetFields(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return Field("target", Escape::JSON(target->name()));
+}
+
+static std::string
+InvocationFields(pbxbuild::Tool::Invocation const &invocation, std::string const &executable)
+{
+    std::string outputs = "[";
+    for (std::string const &output : invocation.outputs()) {
+        outputs += (outputs.size() > 1 ? "," : "") + Escape::JSON(output);
+    }
+    outputs += "]";
+
+    return Field("executable", Escape::JSON(executable)) + Field("message", Escape::JSON(invocation.logMessage())) + Field("outputs", outputs);
+}
+
+/*
+ * Peak resident set size in kilobytes of this process.
+ */
+static long
+MaximumResidentSetSize()
+{
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+#if defined(__APPLE__)
+    /* Reported in bytes rather than kilobytes. */
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+void EventFormatter::
+write(std::string const &type, std::string const &fields, bool flush)
+{
+    int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
+
+    /* Threads are numbered in the order they first report an event. */
+    auto thread = _threads.insert({ std::this_thread::get_id(), _threads.size() }).first->second;
+
+    std::string line = "{\"type\":" + Escape::JSON(type) + Field("time", std::to_string(time)) + Field("thread", std::to_string(thread)) + fields + "}\n";
+    std::fwrite(line.data(), 1, line.size(), _stream);
+
+    /* Flushing only after larger steps keeps writes cheap but the stream live. */
+    if (flush) {
+        std::fflush(_stream);
+    }
+}
+
+std::string EventFormatter::
+begin(pbxbuild::Build::Context const &buildContext)
+{
+    write("begin", Field("pid", std::to_string(::getpid())) + Field("action", Escape::JSON(buildContext.action())) + Field("configuration", Escape::JSON(buildContext.configuration())), true);
+    return (_formatter != nullptr ? _formatter->begin(buildContext) : std::string());
+}
+
+std::string EventFormatter::
+success(pbxbuild::Build::Context const &buildContext)
+{
+    write("finish", Field("success", "true"), true);
+    return (_formatter != nullptr ? _formatter->success(buildContext) : std::string());
+}
+
+std::string EventFormatter::
+failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool::Invocation> const &failingInvocations)
+{
+    write("finish", Field("success", "false") + Field("failures", std::to_string(failingInvocations.size())), true);
+    return (_formatter != nullptr ? _formatter->failure(buildContext, failingInvocations) : std::string());
+}
+
+std::string EventFormatter::
+beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("begin_target", TargetFields(target), false);
+    return (_formatter != nullptr ? _formatter->beginTarget(buildContext, target) : std::string());
+}
+
+std::string EventFormatter::
+finishTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("finish_target", TargetFields(target), true);
+    return (_formatter != nullptr ? _formatter->finishTarget(buildContext, target) : std::string());
+}
+
+std::string EventFormatter::
+beginCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("begin_check_dependencies", TargetFields(target), false);
+    return (_formatter != nullptr ? _formatter->beginCheckDependencies(target) : std::string());
+}
+
+std::string EventFormatter::
+finishCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("finish_check_dependencies", TargetFields(target), false);
+    return (_formatter != nullptr ? _formatter->finishCheckDependencies(target) : std::string());
+}
+
+std::string EventFormatter::
+beginWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("begin_write_auxiliary_files", TargetFields(target), false);
+    return (_formatter != nullptr ? _formatter->beginWriteAuxiliaryFiles(target) : std::string());
+}
+
+std::string EventFormatter::
+createAuxiliaryDirectory(std::string const &directory)
+{
+    /* Individual files are too fine-grained to be worth an event. */
+    return (_formatter != nullptr ? _formatter->createAuxiliaryDirectory(directory) : std::string());
+}
+
+std::string EventFormatter::
+writeAuxiliaryFile(std::string const &file)
+{
+    return (_formatter != nullptr ? _formatter->writeAuxiliaryFile(file) : std::string());
+}
+
+std::string EventFormatter::
+setAuxiliaryExecutable(std::string const &file)
+{
+    return (_formatter != nullptr ? _formatter->setAuxiliaryExecutable(file) : std::string());
+}
+
+std::string EventFormatter::
+finishWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("finish_write_auxiliary_files", TargetFields(target), false);
+    return (_formatter != nullptr ? _formatter->finishWriteAuxiliaryFiles(target) : std::string());
+}
+
+std::string EventFormatter::
+beginCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("begin_create_product_structure", TargetFields(target), false);
+    return (_formatter != nullptr ? _formatter->beginCreateProductStructure(target) : std::string());
+}
+
+std::string EventFormatter::
+finishCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    write("finish_create_product_structure", TargetFields(target), false);
+    return (_formatter != nullptr ? _formatter->finishCreateProductStructure(target) : std::string());
+}
+
+std::string EventFormatter::
+beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple)
+{
+    write("begin_invocation", InvocationFields(invocation, executable), false);
+    return (_formatter != nullptr ? _formatter->beginInvocation(invocation, executable, simple) : std::string());
+}
+
+std::string EventFormatter::
+finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple, ext::optional<int> exitCode, ext::optional<process::ResourceUsage> const &usage)
+{
+    std::string fields = InvocationFields(invocation, executable);
+    fields += Field("exit_code", exitCode ? std::to_string(*exitCode) : "null");
+    if (usage) {
+        fields += Field("max_rss_kb", std::to_string(usage->maximumResidentSetSize() / 1024));
+        fields += Field("user_time_us", std::to_string(usage->userTime()));
+        fields += Field("system_time_us", std::to_string(usage->systemTime()));
+        fields += Field("block_inputs", std::to_string(usage->blockInputs()));
+        fields += Field("block_outputs", std::to_string(usage->blockOutputs()));
+    } else {
+        fields += Field("max_rss_kb", std::to_string(MaximumResidentSetSize()));
+    }
+
+    write("finish_invocation", fields, false);
+    return (_formatter != nullptr ? _formatter->finishInvocation(invocation, executable, simple, exitCode, usage) : std::string());
+}
+
+std::shared_ptr<EventFormatter> EventFormatter::
+Create(std::shared_ptr<Formatter> const &formatter, std::string const &path)
+{
+    std::FILE *stream = std::fopen(path.c_str(), "w");
+    if (stream == nullptr) {
+        return nullptr;
+    }
+
+    return std::make_shared<EventFormatter>(formatter, stream);
+}
@@ -117,7 +117,7 @@ beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const
 }
 
 std::string NullFormatter::
-finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple)
+finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple, ext::optional<int> exitCode, ext::optional<process::ResourceUsage> const &usage)
 {
     return std::string();
 }
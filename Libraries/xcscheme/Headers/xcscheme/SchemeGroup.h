@@ -13,29 +13,54 @@
 #include <xcscheme/XC/Scheme.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; }
 
 namespace xcscheme {
 
+/*
+ * The shared and user schemes of a project or workspace. Opening a group
+ * only lists the scheme files; each scheme is parsed when it's first used,
+ * so naming one scheme doesn't parse all the others. The filesystem the
+ * group is opened with must outlive it.
+ */
 class SchemeGroup {
 public:
     typedef std::shared_ptr <SchemeGroup> shared_ptr;
 
 private:
-    std::string                      _basePath;
-    std::string                      _path;
-    std::string                      _name;
+    struct SchemeFile {
+        std::string                                     name;
+        std::string                                     owner;
+        std::string                                     path;
+        ext::optional<xcscheme::XC::Scheme::shared_ptr> scheme;
+    };
+
+private:
+    std::string                              _basePath;
+    std::string                              _path;
+    std::string                              _name;
+
+private:
+    libutil::Filesystem const               *_filesystem;
+    std::vector<std::string>                 _schemePaths;
+    mutable std::vector<SchemeFile>          _schemeFiles;
+    mutable std::mutex                       _schemeFilesMutex;
 
 private:
-    xcscheme::XC::Scheme::vector     _schemes;
-    xcscheme::XC::Scheme::shared_ptr _defaultScheme;
+    mutable ext::optional<xcscheme::XC::Scheme::vector>     _schemes;
+    mutable ext::optional<xcscheme::XC::Scheme::shared_ptr> _defaultScheme;
 
 public:
     SchemeGroup();
 
+private:
+    xcscheme::XC::Scheme::shared_ptr load(SchemeFile *schemeFile) const;
+
 public:
     inline std::string const &basePath() const
     { return _basePath; }
@@ -45,10 +70,21 @@ public:
     { return _name; }
 
 public:
-    inline xcscheme::XC::Scheme::vector const &schemes() const
-    { return _schemes; }
-    inline xcscheme::XC::Scheme::shared_ptr const &defaultScheme() const
-    { return _defaultScheme; }
+    /*
+     * All schemes in the group. Parses every scheme not yet parsed.
+     */
+    xcscheme::XC::Scheme::vector const &schemes() const;
+
+    /*
+     * The scheme named after the group, or the first scheme.
+     */
+    xcscheme::XC::Scheme::shared_ptr const &defaultScheme() const;
+
+    /*
+     * The paths of every scheme file in the group, parsed or not.
+     */
+    inline std::vector<std::string> const &schemePaths() const
+    { return _schemePaths; }
 
 public:
     /*
@@ -11,6 +11,10 @@
 #define __xcscheme_XC_Scheme_h
 
 #include <xcscheme/XC/Actions.h>
+#include <plist/Object.h>
+
+#include <memory>
+#include <mutex>
 
 namespace libutil { class Filesystem; }
 
@@ -35,12 +39,26 @@ private:
 private:
     uint32_t                  _lastUpgradeVersion;
     std::string               _version;
-    BuildAction::shared_ptr   _buildAction;
-    TestAction::shared_ptr    _testAction;
-    LaunchAction::shared_ptr  _launchAction;
-    ProfileAction::shared_ptr _profileAction;
-    AnalyzeAction::shared_ptr _analyzeAction;
-    ArchiveAction::shared_ptr _archiveAction;
+
+private:
+    /*
+     * Actions are parsed from the scheme file when first used, as most
+     * uses of a scheme only need some of its actions.
+     */
+    std::unique_ptr<plist::Object>    _contents;
+    plist::Dictionary const          *_dict;
+    mutable BuildAction::shared_ptr   _buildAction;
+    mutable std::once_flag            _buildActionOnce;
+    mutable TestAction::shared_ptr    _testAction;
+    mutable std::once_flag            _testActionOnce;
+    mutable LaunchAction::shared_ptr  _launchAction;
+    mutable std::once_flag            _launchActionOnce;
+    mutable ProfileAction::shared_ptr _profileAction;
+    mutable std::once_flag            _profileActionOnce;
+    mutable AnalyzeAction::shared_ptr _analyzeAction;
+    mutable std::once_flag            _analyzeActionOnce;
+    mutable ArchiveAction::shared_ptr _archiveAction;
+    mutable std::once_flag            _archiveActionOnce;
 
 public:
     Scheme(std::string const &name, std::string const &owner);
@@ -70,43 +88,19 @@ public:
     { return _version; }
 
 public:
-    inline BuildAction::shared_ptr const &buildAction() const
-    { return _buildAction; }
-    inline BuildAction::shared_ptr &buildAction()
-    { return _buildAction; }
-
-public:
-    inline TestAction::shared_ptr const &testAction() const
-    { return _testAction; }
-    inline TestAction::shared_ptr &testAction()
-    { return _testAction; }
-
-public:
-    inline LaunchAction::shared_ptr const &launchAction() const
-    { return _launchAction; }
-    inline LaunchAction::shared_ptr &launchAction()
-    { return _launchAction; }
+    /*
+     * The scheme's actions, if present. An action that fails to parse is
+     * reported and treated as missing.
+     */
+    BuildAction::shared_ptr const &buildAction() const;
+    TestAction::shared_ptr const &testAction() const;
+    LaunchAction::shared_ptr const &launchAction() const;
+    ProfileAction::shared_ptr const &profileAction() const;
+    AnalyzeAction::shared_ptr const &analyzeAction() const;
+    ArchiveAction::shared_ptr const &archiveAction() const;
 
-public:
-    inline ProfileAction::shared_ptr const &profileAction() const
-    { return _profileAction; }
-    inline ProfileAction::shared_ptr &profileAction()
-    { return _profileAction; }
-
-public:
-    inline AnalyzeAction::shared_ptr const &analyzeAction() const
-    { return _analyzeAction; }
-    inline AnalyzeAction::shared_ptr &analyzeAction()
-    { return _analyzeAction; }
-
-public:
-    inline ArchiveAction::shared_ptr const &archiveAction() const
-    { return _archiveAction; }
-    inline ArchiveAction::shared_ptr &archiveAction()
-    { return _archiveAction; }
-
-public:
-    bool parse(plist::Dictionary const *dict);
+private:
+    bool parse(std::unique_ptr<plist::Object> contents);
 
 public:
     static shared_ptr Open(
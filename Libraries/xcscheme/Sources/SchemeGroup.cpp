@@ -18,16 +18,83 @@ using libutil::Filesystem;
 using libutil::FSUtil;
 
 SchemeGroup::
-SchemeGroup()
+SchemeGroup() :
+    _filesystem(nullptr)
 {
 }
 
+Scheme::shared_ptr SchemeGroup::
+load(SchemeFile *schemeFile) const
+{
+    if (!schemeFile->scheme) {
+        Scheme::shared_ptr scheme = Scheme::Open(_filesystem, schemeFile->name, schemeFile->owner, schemeFile->path);
+        if (!scheme) {
+            fprintf(stderr, "warning: failed parsing %s scheme '%s'\n", (schemeFile->owner.empty() ? "shared" : "user"), schemeFile->name.c_str());
+        }
+        schemeFile->scheme = scheme;
+    }
+
+    return *schemeFile->scheme;
+}
+
+Scheme::vector const &SchemeGroup::
+schemes() const
+{
+    std::lock_guard<std::mutex> lock(_schemeFilesMutex);
+
+    if (!_schemes) {
+        Scheme::vector schemes;
+        for (SchemeFile &schemeFile : _schemeFiles) {
+            if (Scheme::shared_ptr scheme = load(&schemeFile)) {
+                schemes.push_back(scheme);
+            }
+        }
+        _schemes = schemes;
+    }
+
+    return *_schemes;
+}
+
+Scheme::shared_ptr const &SchemeGroup::
+defaultScheme() const
+{
+    {
+        std::lock_guard<std::mutex> lock(_schemeFilesMutex);
+
+        if (_defaultScheme) {
+            return *_defaultScheme;
+        }
+
+        /* Prefer a scheme named for the group. */
+        for (SchemeFile &schemeFile : _schemeFiles) {
+            if (schemeFile.name == _name) {
+                if (Scheme::shared_ptr scheme = load(&schemeFile)) {
+                    _defaultScheme = scheme;
+                    return *_defaultScheme;
+                }
+            }
+        }
+    }
+
+    /* Otherwise, the first scheme that parses. */
+    Scheme::vector const &schemes = this->schemes();
+
+    std::lock_guard<std::mutex> lock(_schemeFilesMutex);
+    _defaultScheme = (!schemes.empty() ? schemes.front() : nullptr);
+    return *_defaultScheme;
+}
+
 Scheme::shared_ptr SchemeGroup::
 scheme(std::string const &name) const
 {
-    for (Scheme::shared_ptr const &scheme : _schemes) {
-        if (scheme->name() == name) {
-            return scheme;
+    std::lock_guard<std::mutex> lock(_schemeFilesMutex);
+
+    /* Only parse schemes with the name; earlier schemes take priority. */
+    for (SchemeFile &schemeFile : _schemeFiles) {
+        if (schemeFile.name == name) {
+            if (Scheme::shared_ptr scheme = load(&schemeFile)) {
+                return scheme;
+            }
         }
     }
 
@@ -54,51 +121,30 @@ Open(Filesystem const *filesystem, ext::optional<std::string> const &userName, s
     group->_basePath = basePath;
     group->_path = path;
     group->_name = name;
+    group->_filesystem = filesystem;
 
-    std::string schemePath;
-
-    schemePath = path + "/xcshareddata/xcschemes";
-    filesystem->readDirectory(schemePath, false, [&](std::string const &filename) -> void {
-        if (FSUtil::GetFileExtension(filename) != "xcscheme") {
-            return;
-        }
-
-        std::string name = filename.substr(0, filename.find('.'));
-        auto scheme = Scheme::Open(filesystem, name, std::string(), schemePath + "/" + filename);
-        if (!scheme) {
-            fprintf(stderr, "warning: failed parsing shared scheme '%s'\n", name.c_str());
-        } else {
-            group->_schemes.push_back(scheme);
-        }
-
-        if (!group->_defaultScheme && name == group->name()) {
-            group->_defaultScheme = scheme;
-        }
-    });
-
-    if (userName) {
-        schemePath = path + "/xcuserdata/" + *userName + ".xcuserdatad/xcschemes";
+    /*
+     * List the scheme files; they're parsed when used. Shared schemes come
+     * before user schemes.
+     */
+    auto list = [&](std::string const &schemePath, std::string const &owner) {
         filesystem->readDirectory(schemePath, false, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "xcscheme") {
                 return;
             }
 
-            std::string name = filename.substr(0, filename.find('.'));
-            auto scheme = Scheme::Open(filesystem, name, *userName, schemePath + "/" + filename);
-            if (!scheme) {
-                fprintf(stderr, "warning: failed parsing user scheme '%s'\n", name.c_str());
-            } else {
-                group->_schemes.push_back(scheme);
-            }
-
-            if (!group->_defaultScheme && name == group->name()) {
-                group->_defaultScheme = scheme;
-            }
+            SchemeFile schemeFile;
+            schemeFile.name = filename.substr(0, filename.find('.'));
+            schemeFile.owner = owner;
+            schemeFile.path = schemePath + "/" + filename;
+            group->_schemePaths.push_back(schemeFile.path);
+            group->_schemeFiles.push_back(schemeFile);
         });
-    }
+    };
 
-    if (!group->_schemes.empty() && !group->_defaultScheme) {
-        group->_defaultScheme = group->_schemes[0];
+    list(path + "/xcshareddata/xcschemes", std::string());
+    if (userName) {
+        list(path + "/xcuserdata/" + *userName + ".xcuserdatad/xcschemes", *userName);
     }
 
     return group;
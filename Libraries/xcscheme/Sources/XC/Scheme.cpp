@@ -15,6 +15,8 @@
 #include <plist/Format/SimpleXML.h>
 #include <libutil/Filesystem.h>
 
+#include <cstdio>
+
 using xcscheme::XC::Scheme;
 using libutil::Filesystem;
 
@@ -22,25 +24,24 @@ Scheme::
 Scheme(std::string const &name, std::string const &owner) :
     _name              (name),
     _owner             (owner),
-    _lastUpgradeVersion(0)
+    _lastUpgradeVersion(0),
+    _dict              (nullptr)
 {
 }
 
 bool Scheme::
-parse(plist::Dictionary const *dict)
+parse(std::unique_ptr<plist::Object> contents)
 {
-    auto S = dict->value <plist::Dictionary> ("Scheme");
+    plist::Dictionary const *plist = plist::CastTo<plist::Dictionary>(contents.get());
+    if (plist == nullptr)
+        return false;
+
+    auto S = plist->value <plist::Dictionary> ("Scheme");
     if (S == nullptr)
         return false;
 
     auto LUV = S->value <plist::Integer> ("LastUpgradeVersion");
     auto V   = S->value <plist::String> ("version");
-    auto BA  = S->value <plist::Dictionary> ("BuildAction");
-    auto TA  = S->value <plist::Dictionary> ("TestAction");
-    auto LA  = S->value <plist::Dictionary> ("LaunchAction");
-    auto PA  = S->value <plist::Dictionary> ("ProfileAction");
-    auto AnA = S->value <plist::Dictionary> ("AnalyzeAction");
-    auto ArA = S->value <plist::Dictionary> ("ArchiveAction");
 
     if (LUV != nullptr) {
         _lastUpgradeVersion = LUV->value();
@@ -50,43 +51,74 @@ parse(plist::Dictionary const *dict)
         _version = V->value();
     }
 
-    if (BA != nullptr) {
-        _buildAction = std::make_shared <BuildAction> ();
-        if (!_buildAction->parse(BA))
-            return false;
-    }
+    /*
+     * Keep the contents to parse actions from later.
+     */
+    _contents = std::move(contents);
+    _dict = S;
 
-    if (TA != nullptr) {
-        _testAction = std::make_shared <TestAction> ();
-        if (!_testAction->parse(TA))
-            return false;
-    }
+    return true;
+}
 
-    if (LA != nullptr) {
-        _launchAction = std::make_shared <LaunchAction> ();
-        if (!_launchAction->parse(LA))
-            return false;
-    }
+template<typename T>
+static void
+ParseAction(Scheme const *scheme, plist::Dictionary const *dict, char const *key, std::once_flag *once, std::shared_ptr<T> *action)
+{
+    std::call_once(*once, [&] {
+        auto A = dict->value <plist::Dictionary> (key);
+        if (A == nullptr)
+            return;
+
+        std::shared_ptr<T> result = std::make_shared <T> ();
+        if (!result->parse(A)) {
+            fprintf(stderr, "warning: failed parsing %s in scheme '%s'\n", key, scheme->name().c_str());
+            return;
+        }
+
+        *action = result;
+    });
+}
 
-    if (PA != nullptr) {
-        _profileAction = std::make_shared <ProfileAction> ();
-        if (!_profileAction->parse(PA))
-            return false;
-    }
+xcscheme::XC::BuildAction::shared_ptr const &Scheme::
+buildAction() const
+{
+    ParseAction(this, _dict, "BuildAction", &_buildActionOnce, &_buildAction);
+    return _buildAction;
+}
 
-    if (AnA != nullptr) {
-        _analyzeAction = std::make_shared <AnalyzeAction> ();
-        if (!_analyzeAction->parse(AnA))
-            return false;
-    }
+xcscheme::XC::TestAction::shared_ptr const &Scheme::
+testAction() const
+{
+    ParseAction(this, _dict, "TestAction", &_testActionOnce, &_testAction);
+    return _testAction;
+}
 
-    if (ArA != nullptr) {
-        _archiveAction = std::make_shared <ArchiveAction> ();
-        if (!_archiveAction->parse(ArA))
-            return false;
-    }
+xcscheme::XC::LaunchAction::shared_ptr const &Scheme::
+launchAction() const
+{
+    ParseAction(this, _dict, "LaunchAction", &_launchActionOnce, &_launchAction);
+    return _launchAction;
+}
 
-    return true;
+xcscheme::XC::ProfileAction::shared_ptr const &Scheme::
+profileAction() const
+{
+    ParseAction(this, _dict, "ProfileAction", &_profileActionOnce, &_profileAction);
+    return _profileAction;
+}
+
+xcscheme::XC::AnalyzeAction::shared_ptr const &Scheme::
+analyzeAction() const
+{
+    ParseAction(this, _dict, "AnalyzeAction", &_analyzeActionOnce, &_analyzeAction);
+    return _analyzeAction;
+}
+
+xcscheme::XC::ArchiveAction::shared_ptr const &Scheme::
+archiveAction() const
+{
+    ParseAction(this, _dict, "ArchiveAction", &_archiveActionOnce, &_archiveAction);
+    return _archiveAction;
 }
 
 Scheme::shared_ptr Scheme::
@@ -118,16 +150,11 @@ Open(Filesystem const *filesystem, std::string const &name, std::string const &o
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(root.get());
-    if (plist == nullptr) {
-        return nullptr;
-    }
-
     //
     // Parse the scheme dictionary and create the scheme object.
     //
     auto scheme = std::make_shared <Scheme> (name, owner);
-    if (scheme->parse(plist)) {
+    if (scheme->parse(std::move(root))) {
         scheme->_path = realPath;
     } else {
         scheme = nullptr;
@@ -0,0 +1,99 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcsdk_LookupCache_h
+#define __xcsdk_LookupCache_h
+
+#include <libutil/Filesystem.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace process { class Context; }
+
+namespace xcsdk {
+
+/*
+ * Remembers the results of finding SDKs and tools in a developer root, so
+ * they can be used again without opening the developer root. A result is
+ * used again until any of the files or directories it was found from
+ * changes; paths that did not exist when it was found must still not exist.
+ */
+class LookupCache {
+public:
+    /*
+     * The result of a lookup. Values are missing if the SDK, its product
+     * or platform, or the tool was not found.
+     */
+    struct Result {
+        ext::optional<std::string> SDKPath;
+        ext::optional<std::string> SDKVersion;
+        ext::optional<std::string> SDKBuildVersion;
+        ext::optional<std::string> SDKPlatformPath;
+        ext::optional<std::string> SDKPlatformVersion;
+        ext::optional<std::string> executable;
+    };
+
+private:
+    struct Entry {
+        Result                                                                            result;
+        std::vector<std::pair<std::string, ext::optional<libutil::Filesystem::Stamp>>> stamps;
+    };
+
+private:
+    std::unordered_map<std::string, Entry> _entries;
+    bool                                   _modified;
+
+public:
+    LookupCache();
+
+public:
+    /*
+     * Find the result of a lookup, if none of its files changed.
+     */
+    ext::optional<Result> find(libutil::Filesystem const *filesystem, std::string const &key);
+
+    /*
+     * Keep the result of a lookup, along with the current stamps of the
+     * files it was found from and the directories that were searched for
+     * them. Not kept if a path exists but has no stamp.
+     */
+    void insert(libutil::Filesystem const *filesystem, std::string const &key, Result const &result, std::vector<std::string> const &paths);
+
+public:
+    /*
+     * Load a cache saved to a file. Fails if the file is missing or invalid.
+     */
+    bool load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Save the cache to a file, if it changed since it was loaded.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path);
+
+public:
+    /*
+     * Build a key for a lookup from its inputs.
+     */
+    static std::string Key(std::vector<std::string> const &inputs);
+
+    /*
+     * The path to the cache for the current user, in a directory only the
+     * user can access. The directory is created if needed. Nothing if it
+     * can't be created, or if it is not private.
+     */
+    static ext::optional<std::string> DefaultPath(process::Context const *processContext);
+};
+
+}
+
+#endif // !__xcsdk_LookupCache_h
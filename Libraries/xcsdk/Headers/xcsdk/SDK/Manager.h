@@ -15,7 +15,9 @@
 #include <xcsdk/SDK/Target.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; }
@@ -26,12 +28,29 @@ namespace xcsdk { namespace SDK {
 /*
  * Represents the contents of a developer root, containing toolchains,
  * platforms, and SDKs. There is usually only one developer root.
+ *
+ * Platforms and toolchains are found when the manager is opened, but each
+ * is only loaded when first needed. Safe to use from multiple threads.
  */
-class Manager {
+class Manager : public std::enable_shared_from_this<Manager> {
 private:
-    std::string                        _path;
-    std::vector<Platform::shared_ptr>  _platforms;
-    std::vector<Toolchain::shared_ptr> _toolchains;
+    std::string                                                    _path;
+    libutil::Filesystem const                                     *_filesystem;
+    std::vector<std::string>                                       _platformPaths;
+    std::vector<std::string>                                       _toolchainPaths;
+
+private:
+    mutable std::recursive_mutex                                   _mutex;
+    mutable std::unordered_map<std::string, Platform::shared_ptr>  _openedPlatforms;
+    mutable std::unordered_map<std::string, Toolchain::shared_ptr> _openedToolchains;
+    mutable ext::optional<std::vector<Platform::shared_ptr>>       _platforms;
+    mutable ext::optional<std::vector<Toolchain::shared_ptr>>      _toolchains;
+
+private:
+    struct ExecutablePathsKeyHash {
+        size_t operator()(std::vector<void const *> const &key) const;
+    };
+    mutable std::unordered_map<std::vector<void const *>, std::vector<std::string>, ExecutablePathsKeyHash> _executablePaths;
 
 public:
     Manager();
@@ -39,16 +58,18 @@ public:
 
 public:
     /*
-     * Platforms included in the developer root.
+     * Platforms included in the developer root. Loads every platform.
      */
-    inline std::vector<Platform::shared_ptr> const &platforms() const
-    { return _platforms; }
+    std::vector<Platform::shared_ptr> const &platforms() const;
 
     /*
-     * Toolchains included in the developer root.
+     * Toolchains included in the developer root. Loads every toolchain.
      */
-    inline std::vector<Toolchain::shared_ptr> const &toolchains() const
-    { return _toolchains; }
+    std::vector<Toolchain::shared_ptr> const &toolchains() const;
+
+private:
+    Platform::shared_ptr openPlatform(std::string const &path) const;
+    Toolchain::shared_ptr openToolchain(std::string const &path) const;
 
 public:
     /*
@@ -91,16 +112,17 @@ public:
 
     /*
      * Conglomeration of executable paths that optionally includes extra toolchains
-     * and the paths from an SDK target.
+     * and the paths from an SDK target. Computed once for each combination.
      */
-    std::vector<std::string> executablePaths(
+    std::vector<std::string> const &executablePaths(
         Platform::shared_ptr const &platform,
         Target::shared_ptr const &target,
         std::vector<Toolchain::shared_ptr> const &toolchains) const;
 
 public:
     /*
-     * Load from a developer root. Returns nullptr on error.
+     * Load from a developer root. Returns nullptr on error. The filesystem
+     * must outlive the manager, since platforms are loaded as needed.
      */
     static std::shared_ptr<Manager> Open(libutil::Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration);
 };
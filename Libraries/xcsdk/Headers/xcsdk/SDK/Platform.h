@@ -15,15 +15,16 @@
 #include <pbxsetting/Level.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace libutil { class Filesystem; };
-namespace plist { class Dictionary; }
+namespace plist { class Object; class Dictionary; }
 
 namespace xcsdk { namespace SDK {
 
-class Platform {
+class Platform : public std::enable_shared_from_this<Platform> {
 public:
     typedef std::shared_ptr <Platform> shared_ptr;
     typedef std::vector <shared_ptr> vector;
@@ -31,7 +32,11 @@ public:
 private:
     std::weak_ptr<Manager>           _manager;
     PlatformVersion::shared_ptr      _platformVersion;
-    std::vector<Target::shared_ptr>  _targets;
+    libutil::Filesystem const       *_filesystem;
+
+private:
+    mutable std::mutex                                     _targetsMutex;
+    mutable ext::optional<std::vector<Target::shared_ptr>> _targets;
 
 private:
     std::string                      _path;
@@ -58,7 +63,7 @@ private:
 
 private:
     ext::optional<bool>              _isDeploymentPlatform;
-    plist::Dictionary         const *_defaultDebuggerSettings;
+    std::shared_ptr<plist::Dictionary const> _defaultDebuggerSettings;
     ext::optional<std::string>       _runtimeSystemSpecification;
 
 public:
@@ -72,8 +77,10 @@ public:
 public:
     inline PlatformVersion::shared_ptr const &platformVersion() const
     { return _platformVersion; }
-    inline std::vector<Target::shared_ptr> const &targets() const
-    { return _targets; }
+    /*
+     * The SDKs in the platform. Loaded when first used.
+     */
+    std::vector<Target::shared_ptr> const &targets() const;
 
 public:
     inline std::string const &path() const
@@ -117,7 +124,7 @@ public:
     inline ext::optional<bool> const &isDeploymentPlatformOptional() const
     { return _isDeploymentPlatform; }
     inline plist::Dictionary const *defaultDebuggerSettings() const
-    { return _defaultDebuggerSettings; }
+    { return _defaultDebuggerSettings.get(); }
     inline ext::optional<std::string> const &runtimeSystemSpecification() const
     { return _runtimeSystemSpecification; }
 
@@ -131,7 +138,7 @@ public:
     static Platform::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path);
 
 private:
-    bool parse(plist::Dictionary const *dict);
+    bool parse(std::shared_ptr<plist::Object const> const &contents, plist::Dictionary const *dict);
 };
 
 } }
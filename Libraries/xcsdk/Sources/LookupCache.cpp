@@ -0,0 +1,222 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcsdk/LookupCache.h>
+#include <process/Context.h>
+#include <plist/Array.h>
+#include <plist/CacheFile.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Ownership.h>
+
+#include <unistd.h>
+
+using xcsdk::LookupCache;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Ownership;
+
+static int64_t const CacheVersion = 2;
+
+/*
+ * Directories are stamped too, so new SDKs or toolchains in them are seen.
+ */
+static ext::optional<Filesystem::Stamp>
+ReadStamp(Filesystem const *filesystem, std::string const &path)
+{
+    if (ext::optional<Filesystem::Stamp> stamp = filesystem->readFileStamp(path)) {
+        return stamp;
+    }
+    return filesystem->readDirectoryStamp(path);
+}
+
+LookupCache::
+LookupCache() :
+    _modified(false)
+{
+}
+
+ext::optional<LookupCache::Result> LookupCache::
+find(Filesystem const *filesystem, std::string const &key)
+{
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        return ext::nullopt;
+    }
+
+    for (auto const &stamp : it->second.stamps) {
+        ext::optional<Filesystem::Stamp> current = ReadStamp(filesystem, stamp.first);
+        if (current != stamp.second) {
+            /* Changed since found; it will be found again. */
+            _entries.erase(it);
+            _modified = true;
+            return ext::nullopt;
+        }
+    }
+
+    return it->second.result;
+}
+
+void LookupCache::
+insert(Filesystem const *filesystem, std::string const &key, Result const &result, std::vector<std::string> const &paths)
+{
+    std::vector<std::pair<std::string, ext::optional<Filesystem::Stamp>>> stamps;
+    for (std::string const &path : paths) {
+        ext::optional<Filesystem::Stamp> stamp = ReadStamp(filesystem, path);
+        if (!stamp && filesystem->exists(path)) {
+            /* Without a stamp, changes to the path can't be seen. */
+            return;
+        }
+
+        stamps.push_back({ path, stamp });
+    }
+
+    _entries[key] = Entry { result, stamps };
+    _modified = true;
+}
+
+static void
+LoadValue(plist::Dictionary const *dict, std::string const &key, ext::optional<std::string> *value)
+{
+    if (auto string = dict->value<plist::String>(key)) {
+        *value = string->value();
+    }
+}
+
+bool LookupCache::
+load(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<plist::Dictionary> root = plist::CacheFile::Load(filesystem, path, CacheVersion);
+    auto entries = (root != nullptr ? root->value<plist::Dictionary>("Entries") : nullptr);
+    if (entries == nullptr) {
+        return false;
+    }
+
+    for (size_t n = 0; n < entries->count(); ++n) {
+        auto dict = entries->value<plist::Dictionary>(n);
+        auto stamps = (dict != nullptr ? dict->value<plist::Array>("Stamps") : nullptr);
+        if (stamps == nullptr) {
+            continue;
+        }
+
+        Entry entry;
+        LoadValue(dict, "SDKPath", &entry.result.SDKPath);
+        LoadValue(dict, "SDKVersion", &entry.result.SDKVersion);
+        LoadValue(dict, "SDKBuildVersion", &entry.result.SDKBuildVersion);
+        LoadValue(dict, "SDKPlatformPath", &entry.result.SDKPlatformPath);
+        LoadValue(dict, "SDKPlatformVersion", &entry.result.SDKPlatformVersion);
+        LoadValue(dict, "Executable", &entry.result.executable);
+
+        bool valid = true;
+        for (size_t i = 0; i < stamps->count() && valid; ++i) {
+            auto stamp = stamps->value<plist::Dictionary>(i);
+            auto stampPath = (stamp != nullptr ? stamp->value<plist::String>("Path") : nullptr);
+            if (stampPath == nullptr) {
+                valid = false;
+                continue;
+            }
+
+            auto size = stamp->value<plist::Integer>("Size");
+            auto modificationTime = stamp->value<plist::Integer>("ModificationTime");
+            if (size != nullptr && modificationTime != nullptr) {
+                Filesystem::Stamp value = { static_cast<uint64_t>(size->value()), modificationTime->value() };
+                entry.stamps.push_back({ stampPath->value(), value });
+            } else {
+                /* Missing when found. */
+                entry.stamps.push_back({ stampPath->value(), ext::nullopt });
+            }
+        }
+
+        if (valid) {
+            _entries[entries->key(n)] = std::move(entry);
+        }
+    }
+
+    _modified = false;
+    return true;
+}
+
+static void
+SaveValue(plist::Dictionary *dict, std::string const &key, ext::optional<std::string> const &value)
+{
+    if (value) {
+        dict->set(key, plist::String::New(*value));
+    }
+}
+
+bool LookupCache::
+save(Filesystem *filesystem, std::string const &path)
+{
+    if (!_modified) {
+        return true;
+    }
+
+    auto entries = plist::Dictionary::New();
+    for (auto const &it : _entries) {
+        auto dict = plist::Dictionary::New();
+        SaveValue(dict.get(), "SDKPath", it.second.result.SDKPath);
+        SaveValue(dict.get(), "SDKVersion", it.second.result.SDKVersion);
+        SaveValue(dict.get(), "SDKBuildVersion", it.second.result.SDKBuildVersion);
+        SaveValue(dict.get(), "SDKPlatformPath", it.second.result.SDKPlatformPath);
+        SaveValue(dict.get(), "SDKPlatformVersion", it.second.result.SDKPlatformVersion);
+        SaveValue(dict.get(), "Executable", it.second.result.executable);
+
+        auto stamps = plist::Array::New();
+        for (auto const &stamp : it.second.stamps) {
+            auto value = plist::Dictionary::New();
+            value->set("Path", plist::String::New(stamp.first));
+            if (stamp.second) {
+                value->set("Size", plist::Integer::New(static_cast<int64_t>(stamp.second->size)));
+                value->set("ModificationTime", plist::Integer::New(stamp.second->modificationTime));
+            }
+            stamps->append(std::move(value));
+        }
+        dict->set("Stamps", std::move(stamps));
+
+        entries->set(it.first, std::move(dict));
+    }
+
+    auto root = plist::Dictionary::New();
+    root->set("Entries", std::move(entries));
+    if (!plist::CacheFile::Save(filesystem, path, CacheVersion, std::move(root))) {
+        return false;
+    }
+
+    _modified = false;
+    return true;
+}
+
+std::string LookupCache::
+Key(std::vector<std::string> const &inputs)
+{
+    std::string key;
+    for (std::string const &input : inputs) {
+        key += input;
+        key += '\n';
+    }
+    return key;
+}
+
+ext::optional<std::string> LookupCache::
+DefaultPath(process::Context const *processContext)
+{
+    /*
+     * The cache names tools that are then run, so keep it where only the
+     * user can write. Others could plant a cache in the shared directory.
+     */
+    std::string temporaryDirectory = processContext->environmentVariable("TMPDIR").value_or("/tmp");
+    std::string directory = FSUtil::NormalizePath(temporaryDirectory + "/xcrun-" + std::to_string(::geteuid()));
+    if (!Ownership::CreatePrivateDirectory(directory)) {
+        return ext::nullopt;
+    }
+
+    return directory + "/xcrun_db";
+}
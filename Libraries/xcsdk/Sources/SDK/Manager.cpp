@@ -15,6 +15,7 @@
 #include <pbxsetting/Type.h>
 
 #include <algorithm>
+#include <cctype>
 
 using xcsdk::Configuration;
 using xcsdk::SDK::Manager;
@@ -25,7 +26,8 @@ using libutil::Filesystem;
 using libutil::FSUtil;
 
 Manager::
-Manager()
+Manager() :
+    _filesystem(nullptr)
 {
 }
 
@@ -34,10 +36,89 @@ Manager::
 {
 }
 
-Target::shared_ptr Manager::
-findTarget(std::string const &name) const
+Platform::shared_ptr Manager::
+openPlatform(std::string const &path) const
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+    auto it = _openedPlatforms.find(path);
+    if (it != _openedPlatforms.end()) {
+        return it->second;
+    }
+
+    /* Platforms that fail to load are remembered too, so they aren't loaded again. */
+    auto manager = std::const_pointer_cast<Manager>(shared_from_this());
+    Platform::shared_ptr platform = SDK::Platform::Open(_filesystem, manager, path);
+    _openedPlatforms.insert({ path, platform });
+    return platform;
+}
+
+Toolchain::shared_ptr Manager::
+openToolchain(std::string const &path) const
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+    auto it = _openedToolchains.find(path);
+    if (it != _openedToolchains.end()) {
+        return it->second;
+    }
+
+    Toolchain::shared_ptr toolchain = SDK::Toolchain::Open(_filesystem, path);
+    _openedToolchains.insert({ path, toolchain });
+    return toolchain;
+}
+
+std::vector<Platform::shared_ptr> const &Manager::
+platforms() const
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+    if (!_platforms) {
+        std::vector<Platform::shared_ptr> platforms;
+        for (std::string const &path : _platformPaths) {
+            if (Platform::shared_ptr platform = openPlatform(path)) {
+                platforms.push_back(platform);
+            }
+        }
+
+        std::sort(platforms.begin(), platforms.end(), [](Platform::shared_ptr const &a, Platform::shared_ptr const &b) -> bool {
+            return (a->description() < b->description());
+        });
+        _platforms = platforms;
+    }
+
+    return *_platforms;
+}
+
+std::vector<Toolchain::shared_ptr> const &Manager::
+toolchains() const
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+    if (!_toolchains) {
+        std::vector<Toolchain::shared_ptr> toolchains;
+        for (std::string const &path : _toolchainPaths) {
+            if (Toolchain::shared_ptr toolchain = openToolchain(path)) {
+                toolchains.push_back(toolchain);
+            }
+        }
+        _toolchains = toolchains;
+    }
+
+    return *_toolchains;
+}
+
+static std::string
+Lowercase(std::string string)
 {
-    for (Platform::shared_ptr const &platform : _platforms) {
+    std::transform(string.begin(), string.end(), string.begin(), ::tolower);
+    return string;
+}
+
+static Target::shared_ptr
+FindTarget(std::vector<Platform::shared_ptr> const &platforms, std::string const &name)
+{
+    for (Platform::shared_ptr const &platform : platforms) {
         for (Target::shared_ptr const &target : platform->targets()) {
             /* Try both the name and the path; either are valid. */
             if (target->canonicalName() == name || target->path() == name) {
@@ -54,12 +135,61 @@ findTarget(std::string const &name) const
     return nullptr;
 }
 
+Target::shared_ptr Manager::
+findTarget(std::string const &name) const
+{
+    /*
+     * Platform and SDK names start with the platform's directory name, and
+     * SDK paths are inside it. Try those platforms before loading all.
+     */
+    std::string lowercaseName = Lowercase(name);
+
+    std::vector<Platform::shared_ptr> likely;
+    for (std::string const &path : _platformPaths) {
+        std::string platformName = Lowercase(FSUtil::GetBaseNameWithoutExtension(path));
+        if (lowercaseName.compare(0, platformName.size(), platformName) == 0 || name.compare(0, path.size(), path) == 0) {
+            if (Platform::shared_ptr platform = openPlatform(path)) {
+                likely.push_back(platform);
+            }
+        }
+    }
+
+    if (Target::shared_ptr target = FindTarget(likely, name)) {
+        return target;
+    }
+
+    return FindTarget(platforms(), name);
+}
+
+static bool
+MatchToolchain(Toolchain::shared_ptr const &toolchain, std::string const &name)
+{
+    /* Match liberally: name, identifier, or path; all are valid. */
+    return (toolchain->name() == name || toolchain->identifier() == name || toolchain->path() == name);
+}
+
 Toolchain::shared_ptr Manager::
 findToolchain(std::string const &name) const
 {
-    for (Toolchain::shared_ptr const &toolchain : _toolchains) {
-        /* Match liberally: name, identifier, or path; all are valid. */
-        if (toolchain->name() == name || toolchain->identifier() == name || toolchain->path() == name) {
+    /*
+     * Toolchain names are their directory names, and identifiers usually
+     * end with them. Try those toolchains before loading all.
+     */
+    for (std::string const &path : _toolchainPaths) {
+        std::string toolchainName = FSUtil::GetBaseNameWithoutExtension(path);
+        bool likely = (name == path || name == toolchainName ||
+            (name.size() > toolchainName.size() && name.compare(name.size() - toolchainName.size(), toolchainName.size(), toolchainName) == 0 &&
+             name[name.size() - toolchainName.size() - 1] == '.'));
+        if (likely) {
+            Toolchain::shared_ptr toolchain = openToolchain(path);
+            if (toolchain != nullptr && MatchToolchain(toolchain, name)) {
+                return toolchain;
+            }
+        }
+    }
+
+    for (Toolchain::shared_ptr const &toolchain : toolchains()) {
+        if (MatchToolchain(toolchain, name)) {
             return toolchain;
         }
     }
@@ -72,7 +202,7 @@ findPlatformFamily(std::string const &identifier)
 {
     std::vector<Platform::shared_ptr> platforms;
 
-    for (Platform::shared_ptr const &platform : _platforms) {
+    for (Platform::shared_ptr const &platform : this->platforms()) {
         /* Match by family identifier. */
         if (platform->familyIdentifier() == identifier) {
             platforms.push_back(platform);
@@ -106,7 +236,7 @@ computedSettings(void) const
     }
 
     std::vector<std::string> platformNames;
-    for (Platform::shared_ptr const &platform : _platforms) {
+    for (Platform::shared_ptr const &platform : platforms()) {
         platformNames.push_back(platform->name());
     }
     settings.push_back(pbxsetting::Setting::Create("AVAILABLE_PLATFORMS", pbxsetting::Type::FormatList(platformNames)));
@@ -123,9 +253,32 @@ executablePaths() const
     };
 }
 
-std::vector<std::string> Manager::
+size_t Manager::ExecutablePathsKeyHash::
+operator()(std::vector<void const *> const &key) const
+{
+    size_t hash = 0;
+    for (void const *pointer : key) {
+        hash = hash * 31 + std::hash<void const *>()(pointer);
+    }
+    return hash;
+}
+
+std::vector<std::string> const &Manager::
 executablePaths(Platform::shared_ptr const &platform, Target::shared_ptr const &target, std::vector<Toolchain::shared_ptr> const &toolchains) const
 {
+    /* Platforms, targets, and toolchains are kept by the manager, so they identify themselves. */
+    std::vector<void const *> key = { platform.get(), target.get() };
+    for (Toolchain::shared_ptr const &toolchain : toolchains) {
+        key.push_back(toolchain.get());
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+    auto it = _executablePaths.find(key);
+    if (it != _executablePaths.end()) {
+        return it->second;
+    }
+
     std::vector<std::string> paths;
 
     if (target != nullptr) {
@@ -146,7 +299,8 @@ executablePaths(Platform::shared_ptr const &platform, Target::shared_ptr const &
     std::vector<std::string> managerPaths = this->executablePaths();
     paths.insert(paths.end(), managerPaths.begin(), managerPaths.end());
 
-    return paths;
+    /* Entries are never removed, so references to them stay valid. */
+    return _executablePaths.insert({ key, paths }).first->second;
 }
 
 std::shared_ptr<Manager> Manager::
@@ -159,27 +313,26 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
 
     auto manager = std::make_shared <Manager> ();
     manager->_path = path;
+    manager->_filesystem = filesystem;
 
+    /*
+     * Only find the toolchains and platforms here; they are loaded as needed.
+     */
     std::vector<std::string> toolchainsPaths = { path + "/" + "Toolchains" };
     if (configuration) {
         std::vector<std::string> const &extraToolchainsPaths = configuration->extraToolchainsPaths();
         toolchainsPaths.insert(toolchainsPaths.end(), extraToolchainsPaths.begin(), extraToolchainsPaths.end());
     }
 
-    std::vector<std::shared_ptr<Toolchain>> toolchains;
     for (std::string const &toolchainsPath : toolchainsPaths) {
         filesystem->readDirectory(toolchainsPath, false, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "xctoolchain") {
                 return;
             }
 
-            auto toolchain = SDK::Toolchain::Open(filesystem, toolchainsPath + "/" + filename);
-            if (toolchain != nullptr) {
-                toolchains.push_back(toolchain);
-            }
+            manager->_toolchainPaths.push_back(toolchainsPath + "/" + filename);
         });
     }
-    manager->_toolchains = toolchains;
 
     std::vector<std::string> platformsPaths = { path + "/" + "Platforms" };
     if (configuration) {
@@ -187,23 +340,15 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
         platformsPaths.insert(platformsPaths.end(), extraPlatformsPaths.begin(), extraPlatformsPaths.end());
     }
 
-    std::vector<std::shared_ptr<Platform>> platforms;
     for (std::string const &platformsPath : platformsPaths) {
         filesystem->readDirectory(platformsPath, false, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "platform") {
                 return;
             }
 
-            auto platform = SDK::Platform::Open(filesystem, manager, platformsPath + "/" + filename);
-            if (platform != nullptr) {
-                platforms.push_back(platform);
-            }
+            manager->_platformPaths.push_back(platformsPath + "/" + filename);
         });
     }
-    std::sort(platforms.begin(), platforms.end(), [](Platform::shared_ptr const &a, Platform::shared_ptr const &b) -> bool {
-        return (a->description() < b->description());
-    });
-    manager->_platforms = platforms;
 
     return manager;
 }
@@ -16,27 +16,26 @@
 #include <plist/Boolean.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
+#include <plist/FileCache.h>
 #include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 
 #include <algorithm>
 
 using xcsdk::SDK::Platform;
+using xcsdk::SDK::Target;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
 Platform::
 Platform() :
-    _defaultDebuggerSettings(nullptr)
+    _filesystem             (nullptr)
 {
 }
 
 Platform::
 ~Platform()
 {
-    if (_defaultDebuggerSettings != nullptr) {
-        _defaultDebuggerSettings->release();
-    }
 }
 
 static bool
@@ -154,7 +153,7 @@ executablePaths() const
 }
 
 bool Platform::
-parse(plist::Dictionary const *dict)
+parse(std::shared_ptr<plist::Object const> const &contents, plist::Dictionary const *dict)
 {
     std::unordered_set<std::string> seen;
     auto unpack = plist::Keys::Unpack("Platform", dict, &seen);
@@ -230,7 +229,8 @@ parse(plist::Dictionary const *dict)
     }
 
     if (DDS != nullptr) {
-        _defaultDebuggerSettings = DDS->copy().release();
+        /* Share the settings with the parsed file rather than copying them. */
+        _defaultDebuggerSettings = std::shared_ptr<plist::Dictionary const>(contents, DDS);
     }
 
     if (DP != nullptr) {
@@ -290,6 +290,39 @@ parse(plist::Dictionary const *dict)
     return true;
 }
 
+std::vector<Target::shared_ptr> const &Platform::
+targets() const
+{
+    std::lock_guard<std::mutex> lock(_targetsMutex);
+
+    if (!_targets) {
+        /*
+         * Load all the SDKs inside the platform.
+         */
+        std::shared_ptr<Manager> manager = _manager.lock();
+        auto platform = std::const_pointer_cast<Platform>(shared_from_this());
+
+        std::vector<Target::shared_ptr> targets;
+        std::string sdksPath = _path + "/Developer/SDKs";
+        _filesystem->readDirectory(sdksPath, false, [&](std::string const &filename) -> void {
+            if (FSUtil::GetFileExtension(filename) != "sdk") {
+                return;
+            }
+
+            if (auto target = Target::Open(_filesystem, manager, platform, sdksPath + "/" + filename)) {
+                targets.push_back(target);
+            }
+        });
+
+        std::sort(targets.begin(), targets.end(), [](Target::shared_ptr const &a, Target::shared_ptr const &b) -> bool {
+            return (a->canonicalName() < b->canonicalName());
+        });
+        _targets = targets;
+    }
+
+    return *_targets;
+}
+
 Platform::shared_ptr Platform::
 Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path)
 {
@@ -310,20 +343,15 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
-    }
-
     /*
-     * Parse platform info property list.
+     * Parse platform info property list. The parsed file is shared with other reads of it.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::shared_ptr<plist::Object const> result = plist::FileCache::GetDefault()->read<plist::Format::Any>(filesystem, settingsFileName);
+    if (result == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary const *plist = plist::CastTo<plist::Dictionary>(result.get());
     if (plist == nullptr) {
         return nullptr;
     }
@@ -333,12 +361,13 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
      */
     auto platform = std::make_shared<Platform>();
     platform->_manager = manager;
+    platform->_filesystem = filesystem;
     platform->_path = FSUtil::GetDirectoryName(realPath);
 
     /*
      * Parse platform info dictionary.
      */
-    if (!platform->parse(plist)) {
+    if (!platform->parse(result, plist)) {
         return nullptr;
     }
 
@@ -347,23 +376,5 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
      */
     platform->_platformVersion = PlatformVersion::Open(filesystem, platform->_path);
 
-    /*
-     * Load all the SDKs inside the platform.
-     */
-    std::string sdksPath = platform->_path + "/Developer/SDKs";
-    filesystem->readDirectory(sdksPath, false, [&](std::string const &filename) -> void {
-        if (FSUtil::GetFileExtension(filename) != "sdk") {
-            return;
-        }
-
-        if (auto target = Target::Open(filesystem, manager, platform, sdksPath + "/" + filename)) {
-            platform->_targets.push_back(target);
-        }
-    });
-
-    std::sort(platform->_targets.begin(), platform->_targets.end(), [](Target::shared_ptr const &a, Target::shared_ptr const &b) -> bool {
-        return (a->canonicalName() < b->canonicalName());
-    });
-
     return platform;
 }
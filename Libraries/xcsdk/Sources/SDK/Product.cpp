@@ -11,6 +11,7 @@
 #include <libutil/Filesystem.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
+#include <plist/FileCache.h>
 #include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 
@@ -81,20 +82,15 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
-    }
-
     /*
-     * Parse property list.
+     * Parse property list. The parsed file is shared with other reads of it.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::shared_ptr<plist::Object const> result = plist::FileCache::GetDefault()->read<plist::Format::Any>(filesystem, settingsFileName);
+    if (result == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary const *plist = plist::CastTo<plist::Dictionary>(result.get());
     if (plist == nullptr) {
         return nullptr;
     }
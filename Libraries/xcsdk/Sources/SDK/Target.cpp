@@ -14,6 +14,7 @@
 #include <plist/Boolean.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
+#include <plist/FileCache.h>
 #include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 #include <libutil/Filesystem.h>
@@ -221,20 +222,15 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
-    }
-
     /*
-     * Parse settings property list.
+     * Parse settings property list. The parsed file is shared with other reads of it.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::shared_ptr<plist::Object const> result = plist::FileCache::GetDefault()->read<plist::Format::Any>(filesystem, settingsFileName);
+    if (result == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary const *plist = plist::CastTo<plist::Dictionary>(result.get());
     if (plist == nullptr) {
         return nullptr;
     }
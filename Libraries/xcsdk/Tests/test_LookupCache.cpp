@@ -0,0 +1,191 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcsdk/LookupCache.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+
+#include <cstdlib>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using xcsdk::LookupCache;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static LookupCache::Result
+ToolResult()
+{
+    LookupCache::Result result;
+    result.SDKPath = std::string("/Developer/SDKs/macosx.sdk");
+    result.SDKVersion = std::string("10.12");
+    result.executable = std::string("/Developer/usr/bin/tool");
+    return result;
+}
+
+TEST(LookupCache, FindUnchanged)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Developer", {
+            MemoryFilesystem::Entry::Directory("usr", {
+                MemoryFilesystem::Entry::Directory("bin", {
+                    MemoryFilesystem::Entry::File("tool", { }),
+                }),
+            }),
+        }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    LookupCache cache;
+    std::string key = LookupCache::Key({ "/Developer", "macosx", "tool" });
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, key));
+
+    cache.insert(&filesystem, key, ToolResult(), { "/Developer/usr/bin/tool", "/missing" });
+    auto result = cache.find(&filesystem, key);
+    ASSERT_NE(ext::nullopt, result);
+    EXPECT_EQ("/Developer/usr/bin/tool", *result->executable);
+    EXPECT_EQ("10.12", *result->SDKVersion);
+    EXPECT_EQ(ext::nullopt, result->SDKPlatformPath);
+
+    /* Other inputs are a different lookup. */
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, LookupCache::Key({ "/Developer", "macosx", "other" })));
+}
+
+TEST(LookupCache, ForgetChanged)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    LookupCache cache;
+    cache.insert(&filesystem, "key", ToolResult(), { "/tool" });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 2 }));
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, "key"));
+
+    /* Still forgotten when changed back. */
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, "key"));
+}
+
+TEST(LookupCache, ForgetCreated)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    LookupCache cache;
+    cache.insert(&filesystem, "key", ToolResult(), { "/tool", "/SDKSettings.plist" });
+    ASSERT_NE(ext::nullopt, cache.find(&filesystem, "key"));
+
+    /* A file that was missing could change the result once it exists. */
+    ASSERT_TRUE(filesystem.write({ }, "/SDKSettings.plist"));
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, "key"));
+}
+
+TEST(LookupCache, NotKeptWithoutStamps)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", { }),
+    });
+
+    LookupCache cache;
+    cache.insert(&filesystem, "key", ToolResult(), { "/tool" });
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, "key"));
+}
+
+TEST(LookupCache, SaveLoad)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", { }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    {
+        LookupCache cache;
+        cache.insert(&filesystem, LookupCache::Key({ "/Developer", "" }), ToolResult(), { "/tool", "/missing" });
+        ASSERT_TRUE(cache.save(&filesystem, "/tmp/xcrun_db"));
+    }
+
+    LookupCache cache;
+    ASSERT_TRUE(cache.load(&filesystem, "/tmp/xcrun_db"));
+    auto result = cache.find(&filesystem, LookupCache::Key({ "/Developer", "" }));
+    ASSERT_NE(ext::nullopt, result);
+    EXPECT_EQ("/Developer/SDKs/macosx.sdk", *result->SDKPath);
+    EXPECT_EQ(ext::nullopt, result->SDKBuildVersion);
+
+    filesystem.setStamp(Filesystem::Stamp({ 2, 1 }));
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, LookupCache::Key({ "/Developer", "" })));
+
+    EXPECT_FALSE(cache.load(&filesystem, "/tmp/missing"));
+}
+
+TEST(LookupCache, ForgetChangedDirectory)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Platforms", { }),
+        MemoryFilesystem::Entry::Directory("bin", {
+            MemoryFilesystem::Entry::File("tool", { }),
+        }),
+    });
+    filesystem.setStamp(Filesystem::Stamp({ 1, 1 }));
+
+    LookupCache cache;
+    std::string key = LookupCache::Key({ "/", "tool" });
+
+    /* A platform added to a searched directory changes its stamp. */
+    cache.insert(&filesystem, key, ToolResult(), { "/bin/tool", "/Platforms" });
+    EXPECT_NE(ext::nullopt, cache.find(&filesystem, key));
+    EXPECT_TRUE(filesystem.setStamp("/Platforms", Filesystem::Stamp({ 2, 2 })));
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, key));
+
+    /* A tool added to an earlier search path must still be missing. */
+    cache.insert(&filesystem, key, ToolResult(), { "/bin/tool", "/usr/bin/tool" });
+    EXPECT_NE(ext::nullopt, cache.find(&filesystem, key));
+    ASSERT_TRUE(filesystem.createDirectory("/usr/bin", true));
+    ASSERT_TRUE(filesystem.write({ }, "/usr/bin/tool"));
+    EXPECT_EQ(ext::nullopt, cache.find(&filesystem, key));
+}
+
+TEST(LookupCache, DefaultPathPrivate)
+{
+    char directoryTemplate[] = "/tmp/xcbuild-test-lookup-cache-XXXXXX";
+    ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+    std::string directory = directoryTemplate;
+
+    process::MemoryContext processContext = process::MemoryContext(
+        "/usr/bin/xcrun",
+        "/",
+        { },
+        { { "TMPDIR", directory } },
+        0,
+        0,
+        "root",
+        "wheel");
+
+    /* The cache is kept in a directory only the user can access. */
+    ext::optional<std::string> path = LookupCache::DefaultPath(&processContext);
+    ASSERT_TRUE(path);
+    std::string cacheDirectory = path->substr(0, path->rfind('/'));
+    EXPECT_EQ(0u, cacheDirectory.find(directory + "/"));
+
+    struct stat status;
+    ASSERT_EQ(0, ::lstat(cacheDirectory.c_str(), &status));
+    EXPECT_EQ(static_cast<mode_t>(0700), status.st_mode & 0777);
+
+    /* Not used if others could have planted a cache there. */
+    ASSERT_EQ(0, ::chmod(cacheDirectory.c_str(), 0777));
+    EXPECT_FALSE(LookupCache::DefaultPath(&processContext));
+
+    ::rmdir(cacheDirectory.c_str());
+    ::rmdir(directory.c_str());
+}
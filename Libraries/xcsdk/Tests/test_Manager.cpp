@@ -20,6 +20,27 @@ using xcsdk::SDK::Platform;
 using xcsdk::SDK::Toolchain;
 using libutil::MemoryFilesystem;
 
+/*
+ * A memory filesystem that records the files read from it.
+ */
+class RecordingFilesystem : public MemoryFilesystem {
+public:
+    mutable std::vector<std::string> reads;
+
+public:
+    explicit RecordingFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
+        MemoryFilesystem(entries)
+    {
+    }
+
+public:
+    virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const
+    {
+        reads.push_back(path);
+        return MemoryFilesystem::read(contents, path, offset, length);
+    }
+};
+
 static std::vector<uint8_t>
 Contents(std::string const &string)
 {
@@ -59,3 +80,79 @@ TEST(Manager, ConfigurationExtraPaths)
     Toolchain::shared_ptr const &toolchain = manager->toolchains().front();
     EXPECT_EQ(toolchain->identifier(), std::string("extra"));
 }
+
+static MemoryFilesystem::Entry
+PlatformEntry(std::string const &name, std::string const &sdk)
+{
+    return MemoryFilesystem::Entry::Directory(name + ".platform", {
+        MemoryFilesystem::Entry::File("Info.plist", Contents("{ Identifier = " + name + "; Name = " + sdk + "; Description = " + name + "; }")),
+        MemoryFilesystem::Entry::Directory("Developer", {
+            MemoryFilesystem::Entry::Directory("SDKs", {
+                MemoryFilesystem::Entry::Directory(name + ".sdk", {
+                    MemoryFilesystem::Entry::File("SDKSettings.plist", Contents("{ CanonicalName = " + sdk + "1.0; }")),
+                }),
+            }),
+        }),
+    });
+}
+
+TEST(Manager, LoadOnlyUsedPlatforms)
+{
+    auto filesystem = RecordingFilesystem({
+        MemoryFilesystem::Entry::Directory("Platforms", {
+            PlatformEntry("MacOSX", "macosx"),
+            PlatformEntry("iPhoneOS", "iphoneos"),
+        }),
+        MemoryFilesystem::Entry::Directory("Toolchains", {
+            MemoryFilesystem::Entry::Directory("XcodeDefault.xctoolchain", {
+                MemoryFilesystem::Entry::File("ToolchainInfo.plist", Contents("{ Identifier = com.apple.dt.toolchain.XcodeDefault; }")),
+            }),
+        }),
+    });
+
+    auto manager = Manager::Open(&filesystem, "/", ext::nullopt);
+    ASSERT_NE(manager, nullptr);
+    EXPECT_TRUE(filesystem.reads.empty());
+
+    auto target = manager->findTarget("iphoneos1.0");
+    ASSERT_NE(target, nullptr);
+    EXPECT_EQ(target->path(), "/Platforms/iPhoneOS.platform/Developer/SDKs/iPhoneOS.sdk");
+    ASSERT_EQ(target->toolchains().size(), 1);
+    EXPECT_EQ(target->toolchains().front(), manager->findToolchain("XcodeDefault"));
+    for (std::string const &path : filesystem.reads) {
+        EXPECT_EQ(path.find("MacOSX"), std::string::npos) << path;
+    }
+
+    /* Names that don't look like a platform still find it. */
+    ASSERT_NE(manager->findTarget("/Platforms/MacOSX.platform"), nullptr);
+    ASSERT_EQ(manager->platforms().size(), 2);
+    EXPECT_EQ(manager->platforms().front()->name(), "macosx");
+}
+
+TEST(Manager, ExecutablePathsComputedOnce)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Platforms", {
+            PlatformEntry("MacOSX", "macosx"),
+        }),
+        MemoryFilesystem::Entry::Directory("Toolchains", {
+            MemoryFilesystem::Entry::Directory("XcodeDefault.xctoolchain", {
+                MemoryFilesystem::Entry::File("ToolchainInfo.plist", Contents("{ Identifier = com.apple.dt.toolchain.XcodeDefault; }")),
+            }),
+        }),
+    });
+
+    auto manager = Manager::Open(&filesystem, "/", ext::nullopt);
+    ASSERT_NE(manager, nullptr);
+
+    auto target = manager->findTarget("macosx");
+    ASSERT_NE(target, nullptr);
+
+    std::vector<std::string> const &paths = manager->executablePaths(target->platform(), target, target->toolchains());
+    EXPECT_EQ(&paths, &manager->executablePaths(target->platform(), target, target->toolchains()));
+    EXPECT_EQ(paths.back(), "//Tools");
+
+    std::vector<std::string> const &withoutToolchains = manager->executablePaths(target->platform(), target, { });
+    EXPECT_NE(&paths, &withoutToolchains);
+    EXPECT_LT(withoutToolchains.size(), paths.size());
+}
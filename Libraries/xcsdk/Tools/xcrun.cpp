@@ -9,8 +9,10 @@
 
 #include <xcsdk/Configuration.h>
 #include <xcsdk/Environment.h>
+#include <xcsdk/LookupCache.h>
 #include <xcsdk/SDK/Manager.h>
 #include <xcsdk/SDK/Toolchain.h>
+#include <libutil/CachingFilesystem.h>
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
@@ -22,6 +24,7 @@
 #include <process/DefaultLauncher.h>
 #include <pbxsetting/Type.h>
 
+using libutil::CachingFilesystem;
 using libutil::DefaultFilesystem;
 using libutil::Filesystem;
 using libutil::FSUtil;
@@ -208,8 +211,8 @@ Help(std::string const &error = std::string())
     fprintf(stderr, "Options:\n");
     fprintf(stderr, INDENT "-v, --verbose\n");
     fprintf(stderr, INDENT "-l, --log\n");
-    fprintf(stderr, INDENT "-n, --no-cache (not implemented)\n");
-    fprintf(stderr, INDENT "-k, --kill-cache (not implemented)\n");
+    fprintf(stderr, INDENT "-n, --no-cache\n");
+    fprintf(stderr, INDENT "-k, --kill-cache\n");
 #undef INDENT
 
     return (error.empty() ? 0 : -1);
@@ -222,6 +225,191 @@ Version()
     return 0;
 }
 
+/*
+ * Inputs to finding an SDK or a tool. A lookup with the same inputs has the
+ * same result, as long as none of the files it was found from change.
+ */
+struct LookupInputs {
+    std::string                developerRoot;
+    std::vector<std::string>   configurationPaths;
+    ext::optional<std::string> SDK;
+    ext::optional<std::string> toolchains;
+    ext::optional<std::string> tool;
+    std::vector<std::string>   defaultExecutablePaths;
+};
+
+static std::string
+LookupKey(LookupInputs const &inputs)
+{
+    std::vector<std::string> keyInputs = {
+        inputs.developerRoot,
+        inputs.SDK.value_or(std::string()),
+        inputs.toolchains.value_or(std::string()),
+        (inputs.tool ? "tool:" + *inputs.tool : "sdk"),
+    };
+    keyInputs.insert(keyInputs.end(), inputs.configurationPaths.begin(), inputs.configurationPaths.end());
+    keyInputs.insert(keyInputs.end(), inputs.defaultExecutablePaths.begin(), inputs.defaultExecutablePaths.end());
+    return xcsdk::LookupCache::Key(keyInputs);
+}
+
+/*
+ * Find the SDK and tool by opening the developer root. Also collects the
+ * files the result depends on, so it can be cached. Returns an exit code.
+ */
+static int
+Lookup(Filesystem const *filesystem, LookupInputs const &inputs, bool verbose, xcsdk::LookupCache::Result *result, std::vector<std::string> *paths)
+{
+    /*
+     * Load the SDK manager from the developer root.
+     */
+    auto configuration = xcsdk::Configuration::Load(filesystem, inputs.configurationPaths);
+    auto manager = xcsdk::SDK::Manager::Open(filesystem, inputs.developerRoot, configuration);
+    if (manager == nullptr) {
+        fprintf(stderr, "error: unable to load manager from '%s'\n", inputs.developerRoot.c_str());
+        return -1;
+    }
+    if (verbose) {
+        fprintf(stderr, "verbose: using developer root '%s'\n", manager->path().c_str());
+    }
+    paths->insert(paths->end(), inputs.configurationPaths.begin(), inputs.configurationPaths.end());
+
+    /* Toolchains and platforms installed later appear in these directories. */
+    paths->push_back(manager->path() + "/Toolchains");
+    paths->push_back(manager->path() + "/Platforms");
+    if (configuration) {
+        paths->insert(paths->end(), configuration->extraToolchainsPaths().begin(), configuration->extraToolchainsPaths().end());
+        paths->insert(paths->end(), configuration->extraPlatformsPaths().begin(), configuration->extraPlatformsPaths().end());
+    }
+
+    /*
+     * Determine the SDK to use.
+     */
+    const std::string defaultSDK = "macosx";
+    xcsdk::SDK::Target::shared_ptr target = nullptr;
+    if (inputs.SDK) {
+        target = manager->findTarget(*inputs.SDK);
+        if (target == nullptr) {
+             printf("error: unable to find sdk: '%s'\n", inputs.SDK->c_str());
+             return -1;
+        }
+    } else {
+        target = manager->findTarget(defaultSDK);
+        /* nullptr target is not an error (except later on if SDK information is requested) */
+        if (!inputs.tool && target == nullptr) {
+            printf("error: unable os find default sdk: '%s'\n", defaultSDK.c_str());
+            return -1;
+        }
+    }
+
+    /* And SDKs installed later in these; finding the SDK searched them all. */
+    for (xcsdk::SDK::Platform::shared_ptr const &platform : manager->platforms()) {
+        paths->push_back(platform->path() + "/Developer/SDKs");
+    }
+
+    if (verbose) {
+        if (target == nullptr) {
+            fprintf(stderr, "verbose: not using any SDK\n");
+        } else {
+            fprintf(stderr, "verbose: using sdk '%s': %s\n", target->canonicalName().value_or(target->bundleName()).c_str(), target->path().c_str());
+        }
+    }
+
+    if (target != nullptr) {
+        result->SDKPath = target->path();
+        result->SDKVersion = target->version().value_or("");
+        paths->push_back(target->path() + "/SDKSettings.plist");
+        paths->push_back(target->path() + "/Info.plist");
+
+        if (auto product = target->product()) {
+            result->SDKBuildVersion = product->buildVersion().value_or("");
+        }
+        paths->push_back(target->path() + "/System/Library/CoreServices/SystemVersion.plist");
+
+        if (auto platform = target->platform()) {
+            result->SDKPlatformPath = platform->path();
+            result->SDKPlatformVersion = platform->version().value_or("");
+            paths->push_back(platform->path() + "/Info.plist");
+            paths->push_back(platform->path() + "/version.plist");
+        }
+    }
+
+    if (!inputs.tool) {
+        return 0;
+    }
+
+    /*
+     * Determine the toolchains to use. Default to the SDK's toolchains.
+     */
+    std::vector<xcsdk::SDK::Toolchain::shared_ptr> toolchains;
+    if (inputs.toolchains) {
+        /* If the custom toolchain exists, use it instead. */
+        std::vector<std::string> toolchainTokens = pbxsetting::Type::ParseList(*inputs.toolchains);
+        for (std::string const &toolchainToken : toolchainTokens) {
+            if (auto TC = manager->findToolchain(toolchainToken)) {
+                toolchains.push_back(TC);
+            }
+        }
+
+        if (toolchains.empty()) {
+            fprintf(stderr, "error: unable to find toolchains in '%s'\n", inputs.toolchains->c_str());
+            return -1;
+        }
+    } else if (target != nullptr) {
+        toolchains = target->toolchains();
+    }
+    if (toolchains.empty()) {
+        fprintf(stderr, "error: unable to find any toolchains\n");
+        return -1;
+    }
+    if (verbose) {
+        fprintf(stderr, "verbose: using toolchain(s):");
+        for (xcsdk::SDK::Toolchain::shared_ptr const &toolchain : toolchains) {
+            if (toolchain->identifier()) {
+                fprintf(stderr, " '%s'", toolchain->identifier()->c_str());
+            }
+        }
+        fprintf(stderr, "\n");
+    }
+    for (xcsdk::SDK::Toolchain::shared_ptr const &toolchain : toolchains) {
+        paths->push_back(toolchain->path() + "/ToolchainInfo.plist");
+        paths->push_back(toolchain->path() + "/Info.plist");
+    }
+
+    /*
+     * Collect search paths for the tool.
+     * Can be in toolchains, target (if one is provided), developer root,
+     * or default paths.
+     */
+    std::vector<std::string> executablePaths = manager->executablePaths(target != nullptr ? target->platform() : nullptr, target, toolchains);
+    executablePaths.insert(executablePaths.end(), inputs.defaultExecutablePaths.begin(), inputs.defaultExecutablePaths.end());
+
+    /*
+     * Find the tool to execute.
+     */
+    ext::optional<std::string> executable = filesystem->findExecutable(*inputs.tool, executablePaths);
+    if (!executable) {
+        fprintf(stderr, "error: tool '%s' not found\n", inputs.tool->c_str());
+        return 1;
+    }
+    if (verbose) {
+        fprintf(stderr, "verbose: resolved tool '%s' to: %s\n", inputs.tool->c_str(), executable->c_str());
+    }
+
+    result->executable = *executable;
+    paths->push_back(*executable);
+
+    /* A tool installed later earlier in the search paths would be found instead. */
+    for (std::string const &executablePath : executablePaths) {
+        std::string candidate = FSUtil::NormalizePath(executablePath + "/" + *inputs.tool);
+        if (candidate == *executable) {
+            break;
+        }
+        paths->push_back(candidate);
+    }
+
+    return 0;
+}
+
 static int Run(Filesystem *filesystem, process::Context const *processContext, process::Launcher *processLauncher)
 {
     /*
@@ -259,90 +447,105 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
     bool log = options.log() || (bool)processContext->environmentVariable("xcrun_log");
     bool nocache = options.noCache() || (bool)processContext->environmentVariable("xcrun_nocache");
 
-    /*
-     * Warn about unhandled arguments.
-     */
-    if (nocache || options.killCache()) {
-        fprintf(stderr, "warning: cache options not implemented\n");
+    bool showSDKValue = options.showSDKPath() ||
+        options.showSDKVersion() ||
+        options.showSDKBuildVersion() ||
+        options.showSDKPlatformPath() ||
+        options.showSDKPlatformVersion();
+
+    if (!showSDKValue && !options.tool()) {
+        return Help("no tool provided");
     }
 
     /*
-     * Load the SDK manager from the developer root.
+     * Find the developer root to look in.
      */
     ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(processContext, filesystem);
     if (!developerRoot) {
         fprintf(stderr, "error: unable to find developer root\n");
         return -1;
     }
-    auto configuration = xcsdk::Configuration::Load(filesystem, xcsdk::Configuration::DefaultPaths(processContext));
-    auto manager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration);
-    if (manager == nullptr) {
-        fprintf(stderr, "error: unable to load manager from '%s'\n", developerRoot->c_str());
-        return -1;
-    }
-    if (verbose) {
-        fprintf(stderr, "verbose: using developer root '%s'\n", manager->path().c_str());
-    }
 
-    bool showSDKValue = options.showSDKPath() ||
-        options.showSDKVersion() ||
-        options.showSDKBuildVersion() ||
-        options.showSDKPlatformPath() ||
-        options.showSDKPlatformVersion();
+    LookupInputs inputs;
+    inputs.developerRoot = *developerRoot;
+    inputs.configurationPaths = xcsdk::Configuration::DefaultPaths(processContext);
+    inputs.SDK = SDK;
+    if (!showSDKValue) {
+        inputs.toolchains = toolchainsInput;
+        inputs.tool = options.tool();
+        inputs.defaultExecutablePaths = processContext->executableSearchPaths();
+    }
 
     /*
-     * Determine the SDK to use.
+     * Opening the developer root is slow, so use the result of an earlier
+     * lookup with the same inputs if possible. Killing the cache forgets
+     * earlier lookups; this one is still cached afterwards. Without a
+     * private directory for the cache, lookups aren't cached.
      */
-    const std::string defaultSDK = "macosx";
-    xcsdk::SDK::Target::shared_ptr target = nullptr;
-    if (SDK) {
-        target = manager->findTarget(*SDK);
-        if (target == nullptr) {
-             printf("error: unable to find sdk: '%s'\n", SDK->c_str());
-             return -1;
+    ext::optional<std::string> cachePath = xcsdk::LookupCache::DefaultPath(processContext);
+    if (!cachePath) {
+        if (!nocache && verbose) {
+            fprintf(stderr, "verbose: no private directory for the cache\n");
         }
-    } else {
-        target = manager->findTarget(defaultSDK);
-        /* nullptr target is not an error (except later on if SDK information is requested) */
-        if (showSDKValue && target == nullptr) {
-            printf("error: unable os find default sdk: '%s'\n", defaultSDK.c_str());
-            return -1;
+        nocache = true;
+    } else if (options.killCache() && filesystem->exists(*cachePath)) {
+        if (!filesystem->removeFile(*cachePath)) {
+            fprintf(stderr, "warning: unable to remove cache '%s'\n", cachePath->c_str());
         }
     }
 
-    if (verbose) {
-        if (target == nullptr) {
-            fprintf(stderr, "verbose: not using any SDK\n");
-        } else {
-            fprintf(stderr, "verbose: using sdk '%s': %s\n", target->canonicalName().value_or(target->bundleName()).c_str(), target->path().c_str());
+    std::string cacheKey = LookupKey(inputs);
+    xcsdk::LookupCache cache;
+    ext::optional<xcsdk::LookupCache::Result> lookup;
+    if (!nocache && cache.load(filesystem, *cachePath)) {
+        lookup = cache.find(filesystem, cacheKey);
+        if (lookup && verbose) {
+            fprintf(stderr, "verbose: using cached lookup from '%s'\n", cachePath->c_str());
         }
     }
 
+    if (!lookup) {
+        xcsdk::LookupCache::Result found;
+        std::vector<std::string> paths;
+        int status = Lookup(filesystem, inputs, verbose, &found, &paths);
+        if (status != 0) {
+            return status;
+        }
+
+        if (!nocache) {
+            cache.insert(filesystem, cacheKey, found, paths);
+            if (!cache.save(filesystem, *cachePath) && verbose) {
+                fprintf(stderr, "verbose: unable to save cache '%s'\n", cachePath->c_str());
+            }
+        }
+        lookup = found;
+    }
+
     /*
      * Perform SDK-specific actions.
      */
     if (showSDKValue) {
         if (options.showSDKPath()) {
-            printf("%s\n", target->path().c_str());
+            printf("%s\n", lookup->SDKPath->c_str());
         } else if (options.showSDKVersion()) {
-            printf("%s\n", target->version().value_or("").c_str());
+            printf("%s\n", lookup->SDKVersion->c_str());
         } else if (options.showSDKBuildVersion()) {
-            if (auto product = target->product()) {
-                printf("%s\n", product->buildVersion().value_or("").c_str());
+            if (lookup->SDKBuildVersion) {
+                printf("%s\n", lookup->SDKBuildVersion->c_str());
             } else {
                 fprintf(stderr, "error: sdk has no build version\n");
                 return -1;
             }
         } else if (options.showSDKPlatformPath()) {
-            if (auto platform = target->platform()) {
-                printf("%s\n", platform->path().c_str());
+            if (lookup->SDKPlatformPath) {
+                printf("%s\n", lookup->SDKPlatformPath->c_str());
             } else {
                 fprintf(stderr, "error: sdk has no platform\n");
                 return -1;
             }
         } else if (options.showSDKPlatformVersion()) {
-            if (auto platform = target->platform()) {
-                printf("%s\n", platform->version().value_or("").c_str());
+            if (lookup->SDKPlatformVersion) {
+                printf("%s\n", lookup->SDKPlatformVersion->c_str());
             } else {
                 fprintf(stderr, "error: sdk has no platform\n");
                 return -1;
@@ -351,86 +554,26 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
 
         return 0;
     } else {
-        /*
-         * Perform toolchain-specific actions.
-         */
-        if (!options.tool()) {
-            return Help("no tool provided");
-        }
-
-        /*
-         * Determine the toolchains to use. Default to the SDK's toolchains.
-         */
-        std::vector<xcsdk::SDK::Toolchain::shared_ptr> toolchains;
-        if (toolchainsInput) {
-            /* If the custom toolchain exists, use it instead. */
-            std::vector<std::string> toolchainTokens = pbxsetting::Type::ParseList(*toolchainsInput);
-            for (std::string const &toolchainToken : toolchainTokens) {
-                if (auto TC = manager->findToolchain(toolchainToken)) {
-                    toolchains.push_back(TC);
-                }
-            }
-
-            if (toolchains.empty()) {
-                fprintf(stderr, "error: unable to find toolchains in '%s'\n", toolchainsInput->c_str());
-                return -1;
-            }
-        } else if (target != nullptr) {
-            toolchains = target->toolchains();
-        }
-        if (toolchains.empty()) {
-            fprintf(stderr, "error: unable to find any toolchains\n");
-            return -1;
-        }
-        if (verbose) {
-            fprintf(stderr, "verbose: using toolchain(s):");
-            for (xcsdk::SDK::Toolchain::shared_ptr const &toolchain : toolchains) {
-                if (toolchain->identifier()) {
-                    fprintf(stderr, " '%s'", toolchain->identifier()->c_str());
-                }
-            }
-            fprintf(stderr, "\n");
-        }
-
-        /*
-         * Collect search paths for the tool.
-         * Can be in toolchains, target (if one is provided), developer root,
-         * or default paths.
-         */
-        std::vector<std::string> executablePaths = manager->executablePaths(target != nullptr ? target->platform() : nullptr, target, toolchains);
-        std::vector<std::string> defaultExecutablePaths = processContext->executableSearchPaths();
-        executablePaths.insert(executablePaths.end(), defaultExecutablePaths.begin(), defaultExecutablePaths.end());
-
-        /*
-         * Find the tool to execute.
-         */
-        ext::optional<std::string> executable = filesystem->findExecutable(*options.tool(), executablePaths);
-        if (!executable) {
-            fprintf(stderr, "error: tool '%s' not found\n", options.tool()->c_str());
-            return 1;
-        }
-        if (verbose) {
-            fprintf(stderr, "verbose: resolved tool '%s' to: %s\n", options.tool()->c_str(), executable->c_str());
-        }
+        std::string const &executable = *lookup->executable;
 
         if (options.find()) {
             /*
              * Just find the tool; i.e. print its path.
              */
-            printf("%s\n", executable->c_str());
+            printf("%s\n", executable.c_str());
             return 0;
         } else {
             /* Run is the default. */
 
             std::unordered_map<std::string, std::string> environment = processContext->environmentVariables();
 
-            if (target != nullptr) {
+            if (lookup->SDKPath) {
                 /*
                  * Update effective environment to include the target path.
                  */
-                environment["SDKROOT"] = target->path();
+                environment["SDKROOT"] = *lookup->SDKPath;
                 if (log) {
-                    printf("env SDKROOT=%s %s\n", target->path().c_str(), executable->c_str());
+                    printf("env SDKROOT=%s %s\n", lookup->SDKPath->c_str(), executable.c_str());
                 }
             }
 
@@ -438,11 +581,11 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
              * Execute the process!
              */
             if (verbose) {
-                printf("verbose: executing tool: %s\n", executable->c_str());
+                printf("verbose: executing tool: %s\n", executable.c_str());
             }
 
             process::MemoryContext context = process::MemoryContext(
-                *executable,
+                executable,
                 processContext->currentDirectory(),
                 options.args(),
                 environment,
@@ -465,7 +608,11 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
 int
 main(int argc, char **argv)
 {
-    DefaultFilesystem filesystem = DefaultFilesystem();
+    DefaultFilesystem defaultFilesystem = DefaultFilesystem();
+
+    /* Opening the SDKs and finding the tool check many of the same paths. */
+    CachingFilesystem filesystem(&defaultFilesystem);
+
     process::DefaultContext processContext = process::DefaultContext();
     process::DefaultLauncher processLauncher = process::DefaultLauncher();
     return Run(&filesystem, &processContext, &processLauncher);